@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/AST.hpp"
+#include "../visitor/Visitor.hpp"
+
+namespace zenith {
+	// What the intraprocedural passes (EscapeAnalysis, ShapeInference) share
+	// Finds every function, method and constructor body and every global, and walks the statements that only
+	// nest others while keeping a stack of block scopes. Binding is what a pass keeps per local variable.
+	// Statements and expressions that matter to a pass are left to it; everything else is skipped.
+	template<typename Binding>
+	class BodyPass : public Visitor {
+	protected:
+		enum class BodyKind : uint8_t { FUNCTION, METHOD, CONSTRUCTOR };
+		struct Body {
+			FunctionDeclNode* function;
+			BodyKind kind;
+			std::string object; // Declaring object, empty for top-level functions
+			std::string name;   // "f", "Object.method" or "Object.constructor"
+		};
+
+		std::vector<std::unordered_map<std::string, Binding>> scopes;
+		size_t lambdaScopeFloor = 0; // Bindings in scopes below this belong to the function around the lambda
+
+		// In declaration order, template declarations included
+		static std::vector<Body> bodies(ProgramNode& program) {
+			std::vector<Body> out;
+			for (auto &decl: program.declarations) {
+				polymorphic_ref<ASTNode> target = decl;
+				if (auto templ = target.cast().non_throwing().to<TemplateDeclNode>()) {
+					target = templ->declaration;
+				}
+				if (auto function = target.cast().non_throwing().to<FunctionDeclNode>()) {
+					out.push_back({&*function, BodyKind::FUNCTION, "", function->name});
+				}
+				else if (auto object = target.cast().non_throwing().to<ObjectDeclNode>()) {
+					for (auto &member: object->members) {
+						polymorphic_ref<DeclNode> ref = member;
+						if (auto ctor = ref.cast().non_throwing().to<CtorDeclNode>()) {
+							out.push_back({&*ctor, BodyKind::CONSTRUCTOR, object->name, object->name + ".constructor"});
+						}
+						else if (auto method = ref.cast().non_throwing().to<FunctionDeclNode>()) {
+							out.push_back({&*method, BodyKind::METHOD, object->name, object->name + "." + method->name});
+						}
+					}
+				}
+			}
+			return out;
+		}
+
+		static std::vector<VarDeclNode*> globals(ProgramNode& program) {
+			std::vector<VarDeclNode*> out;
+			for (auto &decl: program.declarations) {
+				if (auto var = polymorphic_ref<ASTNode>(decl).cast().non_throwing().to<VarDeclNode>()) out.push_back(&*var);
+			}
+			return out;
+		}
+
+		void resetScopes() {
+			scopes.clear();
+			scopes.emplace_back();
+			lambdaScopeFloor = 0;
+		}
+
+		// Innermost binding of name, nullptr for globals and functions
+		// captured is set when the binding lives outside the lambda currently being walked.
+		Binding* find(const std::string& name, bool& captured) {
+			for (size_t i = scopes.size(); i-- > 0;) {
+				if (const auto it = scopes[i].find(name); it != scopes[i].end()) {
+					captured = i < lambdaScopeFloor;
+					return &it->second;
+				}
+			}
+			return nullptr;
+		}
+
+		// Walks a lambda's body in place, in a new scope where bind(param) gives each parameter its binding
+		template<typename Bind>
+		void walkLambda(LambdaExprNode& node, Bind&& bind) {
+			const size_t savedFloor = lambdaScopeFloor;
+			lambdaScopeFloor = scopes.size();
+			scopes.emplace_back();
+			for (auto &param: node.lambda->params) scopes.back()[param.name] = bind(param);
+			if (node.lambda->body) node.lambda->body->accept(*this);
+			scopes.pop_back();
+			lambdaScopeFloor = savedFloor;
+		}
+
+	public:
+		void visit(ASTNode&) override {
+			// Nothing a pass looks at
+		}
+
+		void visit(BlockNode& node) override {
+			scopes.emplace_back();
+			for (auto &stmt: node.statements) stmt->accept(*this);
+			scopes.pop_back();
+		}
+
+		void visit(ScopeBlockNode& node) override { visit(static_cast<BlockNode&>(node)); }
+		void visit(UnsafeNode& node) override { visit(static_cast<BlockNode&>(node)); }
+
+		void visit(CompoundStmtNode& node) override {
+			for (auto &stmt: node.stmts) stmt->accept(*this);
+		}
+
+		void visit(MultiVarDeclNode& node) override {
+			for (auto &var: node.vars) var->accept(*this);
+		}
+	};
+}
@@ -0,0 +1,128 @@
+#include "ClassHierarchy.hpp"
+#include <algorithm>
+
+namespace zenith {
+	void ClassHierarchy::add(ObjectDeclNode& decl) {
+		// First declaration wins
+		if (ids.contains(decl.name)) return;
+		ids.emplace(decl.name, static_cast<ClassId>(classes.size()));
+		classes.push_back(ClassInfo{make_polymorphic_ref(decl)});
+		built = false;
+	}
+
+	void ClassHierarchy::clear() {
+		classes.clear();
+		ids.clear();
+		built = false;
+	}
+
+	void ClassHierarchy::build() {
+		resolveBases();
+		breakCycles();
+		number();
+		built = true;
+	}
+
+	void ClassHierarchy::resolveBases() {
+		for (auto& cls : classes) {
+			cls.parent = NO_CLASS;
+			const auto& base = cls.decl->base;
+			if (base.empty()) continue;
+
+			const auto it = ids.find(base);
+			if (it == ids.end()) {
+				errorReporter.error(cls.decl->loc, "Base class '" + base + "' not found");
+				continue;
+			}
+			cls.parent = it->second;
+		}
+	}
+
+	void ClassHierarchy::breakCycles() {
+		// Single inheritance means every class has at most one parent, so a cycle is found by
+		// following the parent chain and hitting a class that is still on the current path
+		enum class State : uint8_t { UNVISITED, ON_PATH, DONE };
+		std::vector<State> state(classes.size(), State::UNVISITED);
+		std::vector<ClassId> path;
+
+		for (ClassId start = 0; start < classes.size(); ++start) {
+			if (state[start] != State::UNVISITED) continue;
+
+			path.clear();
+			ClassId cur = start;
+			while (cur != NO_CLASS && state[cur] == State::UNVISITED) {
+				state[cur] = State::ON_PATH;
+				path.push_back(cur);
+				cur = classes[cur].parent;
+			}
+
+			if (cur != NO_CLASS && state[cur] == State::ON_PATH) {
+				std::string chain = classes[cur].decl->name;
+				for (size_t i = std::ranges::find(path, cur) - path.begin() + 1; i < path.size(); ++i) {
+					chain += " -> " + classes[path[i]].decl->name;
+				}
+				chain += " -> " + classes[cur].decl->name;
+				errorReporter.error(classes[cur].decl->loc, "Inheritance cycle detected: " + chain);
+				// Cut the cycle at the class we re-entered so numbering still sees a forest
+				classes[cur].parent = NO_CLASS;
+			}
+
+			for (const ClassId id : path) state[id] = State::DONE;
+		}
+	}
+
+	void ClassHierarchy::number() {
+		// Children lists in CSR form, then an iterative DFS over every root
+		std::vector<uint32_t> childStart(classes.size() + 1, 0);
+		for (const auto& cls : classes) {
+			if (cls.parent != NO_CLASS) ++childStart[cls.parent + 1];
+		}
+		for (size_t i = 1; i < childStart.size(); ++i) childStart[i] += childStart[i - 1];
+
+		std::vector<ClassId> children(childStart.back());
+		std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+		for (ClassId id = 0; id < classes.size(); ++id) {
+			if (const ClassId parent = classes[id].parent; parent != NO_CLASS) {
+				children[fill[parent]++] = id;
+			}
+		}
+
+		uint32_t counter = 0;
+		std::vector<std::pair<ClassId, uint32_t>> stack; // (class, next child index)
+		for (ClassId root = 0; root < classes.size(); ++root) {
+			if (classes[root].parent != NO_CLASS) continue;
+
+			classes[root].pre = counter++;
+			stack.emplace_back(root, childStart[root]);
+			while (!stack.empty()) {
+				auto& [id, next] = stack.back();
+				if (next < childStart[id + 1]) {
+					const ClassId child = children[next++];
+					classes[child].pre = counter++;
+					stack.emplace_back(child, childStart[child]);
+				}
+				else {
+					classes[id].post = counter++;
+					stack.pop_back();
+				}
+			}
+		}
+	}
+
+	bool ClassHierarchy::contains(const std::string& name) const {
+		return ids.contains(name);
+	}
+
+	ClassHierarchy::ClassId ClassHierarchy::idOf(const std::string& name) const {
+		const auto it = ids.find(name);
+		return it != ids.end() ? it->second : NO_CLASS;
+	}
+
+	bool ClassHierarchy::isSubclassOf(const std::string& derived, const std::string& base) const {
+		if (!built) return false;
+		const ClassId d = idOf(derived);
+		const ClassId b = idOf(base);
+		if (d == NO_CLASS || b == NO_CLASS) return false;
+		return isSubclassOf(d, b);
+	}
+} // namespace zenith
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../exceptions/ErrorReporter.hpp"
+#include "../ast/AST.hpp"
+
+namespace zenith {
+	// Index over every class/struct/actor declaration in a program
+	// Built once after all ObjectDeclNodes are collected, every class gets a DFS pre/post number
+	// so subtype queries are a constant-time interval check instead of a walk up the base chain
+	class ClassHierarchy {
+	public:
+		using ClassId = uint32_t;
+		static constexpr ClassId NO_CLASS = UINT32_MAX;
+
+		struct ClassInfo {
+			polymorphic_ref<ObjectDeclNode> decl;
+			ClassId parent = NO_CLASS;
+			uint32_t pre = 0;
+			uint32_t post = 0;
+		};
+
+	private:
+		ErrorReporter& errorReporter;
+		std::vector<ClassInfo> classes;
+		std::unordered_map<std::string, ClassId> ids;
+		bool built = false;
+
+		void resolveBases();
+		void breakCycles();
+		void number();
+
+	public:
+		explicit ClassHierarchy(ErrorReporter& reporter) : errorReporter(reporter) {}
+
+		void add(ObjectDeclNode& decl);
+		void build();
+		void clear();
+
+		[[nodiscard]] bool isBuilt() const { return built; }
+		[[nodiscard]] bool contains(const std::string& name) const;
+		[[nodiscard]] ClassId idOf(const std::string& name) const;
+		[[nodiscard]] const ClassInfo& info(ClassId id) const { return classes[id]; }
+		[[nodiscard]] size_t size() const { return classes.size(); }
+
+		// True if 'derived' is 'base' or (transitively) inherits from it
+		[[nodiscard]] bool isSubclassOf(ClassId derived, ClassId base) const {
+			const auto& d = classes[derived];
+			const auto& b = classes[base];
+			return b.pre <= d.pre && d.post <= b.post;
+		}
+		[[nodiscard]] bool isSubclassOf(const std::string& derived, const std::string& base) const;
+	};
+} // namespace zenith
@@ -0,0 +1,209 @@
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include "ConstantEvaluator.hpp"
+
+namespace zenith {
+	namespace {
+		using Kind = ConstantValue::Kind;
+
+		int64_t wrapTo(const Kind kind, const int64_t value) {
+			switch (kind) {
+				case Kind::BYTE: return static_cast<int8_t>(value);
+				case Kind::SHORT: return static_cast<int16_t>(value);
+				case Kind::INT: return static_cast<int32_t>(value);
+				default: return value;
+			}
+		}
+
+		ConstantValue makeFloating(const Kind kind, const double value) {
+			return {kind, kind == Kind::FLOAT ? static_cast<double>(static_cast<float>(value)) : value};
+		}
+	}
+
+	std::optional<ConstantValue::Kind> ConstantEvaluator::kindOf(const PrimitiveTypeNode::Type type) {
+		switch (type) {
+			case PrimitiveTypeNode::Type::BYTE: return Kind::BYTE;
+			case PrimitiveTypeNode::Type::SHORT: return Kind::SHORT;
+			case PrimitiveTypeNode::Type::INT: return Kind::INT;
+			case PrimitiveTypeNode::Type::LONG: return Kind::LONG;
+			case PrimitiveTypeNode::Type::FLOAT: return Kind::FLOAT;
+			case PrimitiveTypeNode::Type::DOUBLE: return Kind::DOUBLE;
+			case PrimitiveTypeNode::Type::BOOL: return Kind::BOOL;
+			case PrimitiveTypeNode::Type::STRING: return Kind::STRING;
+			default: return std::nullopt;
+		}
+	}
+
+	std::optional<ConstantValue> ConstantEvaluator::literal(const LiteralNode& node) {
+		switch (node.type) {
+			case LiteralNode::NUMBER: {
+				if (node.value.find_first_of(".eE") != std::string::npos) {
+					return ConstantValue{Kind::DOUBLE, std::strtod(node.value.c_str(), nullptr)};
+				}
+				int64_t value = 0;
+				const auto [end, ec] = std::from_chars(node.value.data(), node.value.data() + node.value.size(), value);
+				if (ec != std::errc()) return std::nullopt; // Only representable as bigint, left to runtime
+				const bool fitsInt = value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+				return ConstantValue{fitsInt ? Kind::INT : Kind::LONG, value};
+			}
+			case LiteralNode::STRING:
+				return ConstantValue{Kind::STRING, node.value};
+			case LiteralNode::BOOL:
+				return ConstantValue{Kind::BOOL, node.value == "true"};
+			case LiteralNode::NIL:
+				return std::nullopt;
+		}
+		return std::nullopt;
+	}
+
+	std::optional<ConstantValue> ConstantEvaluator::unary(const UnaryOpNode& node, const ConstantValue& operand) {
+		switch (node.op) {
+			case UnaryOpNode::Op::NEGATE:
+				if (operand.isInteger()) return integerOp(BinaryOpNode::SUB, operand.kind, 0, operand.asInteger(), node.loc);
+				if (operand.isFloating()) return makeFloating(operand.kind, -operand.asFloating());
+				return std::nullopt;
+			case UnaryOpNode::Op::NOT:
+				if (operand.kind == Kind::BOOL) return ConstantValue{Kind::BOOL, !operand.asBool()};
+				return std::nullopt;
+			default:
+				return std::nullopt; // ++/-- need an lvalue, never constant
+		}
+	}
+
+	std::optional<ConstantValue> ConstantEvaluator::binary(const BinaryOpNode& node, const ConstantValue& left,
+	                                                       const ConstantValue& right) {
+		if (node.op >= BinaryOpNode::EQ && node.op <= BinaryOpNode::GTE) {
+			return compare(node.op, left, right);
+		}
+
+		if (left.isNumeric() && right.isNumeric()) {
+			// No promotion to int: byte op byte stays byte, so narrow types overflow at their own width
+			const Kind kind = std::max(left.kind, right.kind);
+			if (left.isInteger() && right.isInteger()) {
+				return integerOp(node.op, kind, left.asInteger(), right.asInteger(), node.loc);
+			}
+			return floatingOp(node.op, kind, left.asFloating(), right.asFloating());
+		}
+
+		if (node.op == BinaryOpNode::ADD && left.kind == Kind::STRING && right.kind == Kind::STRING) {
+			return ConstantValue{Kind::STRING, left.asString() + right.asString()};
+		}
+		return std::nullopt;
+	}
+
+	std::optional<ConstantValue> ConstantEvaluator::integerOp(const BinaryOpNode::Op op, const Kind kind,
+	                                                          const int64_t a, const int64_t b,
+	                                                          const SourceLocation& loc) {
+		constexpr int64_t MIN = std::numeric_limits<int64_t>::min();
+		constexpr int64_t MAX = std::numeric_limits<int64_t>::max();
+		// Unsigned arithmetic gives the two's complement wrap without signed overflow UB
+		const auto ua = static_cast<uint64_t>(a);
+		const auto ub = static_cast<uint64_t>(b);
+
+		int64_t result;
+		bool overflow = false;
+		switch (op) {
+			case BinaryOpNode::ADD:
+				result = static_cast<int64_t>(ua + ub);
+				overflow = (b > 0 && a > MAX - b) || (b < 0 && a < MIN - b);
+				break;
+			case BinaryOpNode::SUB:
+				result = static_cast<int64_t>(ua - ub);
+				overflow = (b < 0 && a > MAX + b) || (b > 0 && a < MIN + b);
+				break;
+			case BinaryOpNode::MUL:
+				result = static_cast<int64_t>(ua * ub);
+				overflow = (a == -1 && b == MIN) || (b == -1 && a == MIN) || (a != 0 && result / a != b);
+				break;
+			case BinaryOpNode::DIV:
+			case BinaryOpNode::MOD:
+				if (b == 0) {
+					errorReporter.error(loc, "Division by zero in constant expression");
+					return std::nullopt;
+				}
+				if (a == MIN && b == -1) {
+					result = op == BinaryOpNode::DIV ? MIN : 0;
+					overflow = op == BinaryOpNode::DIV;
+				}
+				else result = op == BinaryOpNode::DIV ? a / b : a % b;
+				break;
+			default:
+				return std::nullopt;
+		}
+
+		const int64_t wrapped = wrapTo(kind, result);
+		if (overflow || wrapped != result) {
+			errorReporter.warning(loc, std::string("Constant expression overflows '") + ConstantValue::kindName(kind) +
+			                           "', result wraps to " + std::to_string(wrapped));
+		}
+		return ConstantValue{kind, wrapped};
+	}
+
+	std::optional<ConstantValue> ConstantEvaluator::floatingOp(const BinaryOpNode::Op op, const Kind kind,
+	                                                           const double a, const double b) {
+		switch (op) {
+			case BinaryOpNode::ADD: return makeFloating(kind, a + b);
+			case BinaryOpNode::SUB: return makeFloating(kind, a - b);
+			case BinaryOpNode::MUL: return makeFloating(kind, a * b);
+			case BinaryOpNode::DIV: return makeFloating(kind, a / b);
+			case BinaryOpNode::MOD: return makeFloating(kind, std::fmod(a, b));
+			default: return std::nullopt;
+		}
+	}
+
+	std::optional<ConstantValue> ConstantEvaluator::compare(const BinaryOpNode::Op op, const ConstantValue& left,
+	                                                        const ConstantValue& right) {
+		int order;
+		if (left.isInteger() && right.isInteger()) {
+			order = left.asInteger() < right.asInteger() ? -1 : left.asInteger() > right.asInteger();
+		}
+		else if (left.isNumeric() && right.isNumeric()) {
+			const double a = left.asFloating(), b = right.asFloating();
+			if (std::isnan(a) || std::isnan(b)) return ConstantValue{Kind::BOOL, op == BinaryOpNode::NEQ};
+			order = a < b ? -1 : a > b;
+		}
+		else if (left.kind == Kind::STRING && right.kind == Kind::STRING) {
+			order = left.asString().compare(right.asString());
+		}
+		else if (left.kind == Kind::BOOL && right.kind == Kind::BOOL && (op == BinaryOpNode::EQ || op == BinaryOpNode::NEQ)) {
+			order = left.asBool() != right.asBool();
+		}
+		else return std::nullopt;
+
+		bool result;
+		switch (op) {
+			case BinaryOpNode::EQ: result = order == 0; break;
+			case BinaryOpNode::NEQ: result = order != 0; break;
+			case BinaryOpNode::LT: result = order < 0; break;
+			case BinaryOpNode::GT: result = order > 0; break;
+			case BinaryOpNode::LTE: result = order <= 0; break;
+			case BinaryOpNode::GTE: result = order >= 0; break;
+			default: return std::nullopt;
+		}
+		return ConstantValue{Kind::BOOL, result};
+	}
+
+	std::optional<ConstantValue> ConstantEvaluator::convert(const ConstantValue& value,
+	                                                        const PrimitiveTypeNode::Type target,
+	                                                        const SourceLocation& loc) {
+		const auto kind = kindOf(target);
+		if (!kind) return value; // number/bigint/... keep whatever the expression produced
+		if (*kind == value.kind) return value;
+
+		const bool toInteger = *kind <= Kind::LONG;
+		const bool toFloating = *kind == Kind::FLOAT || *kind == Kind::DOUBLE;
+		if (toInteger && value.isInteger()) {
+			const int64_t wrapped = wrapTo(*kind, value.asInteger());
+			if (wrapped != value.asInteger()) {
+				errorReporter.warning(loc, "Constant value " + value.toString() + " overflows '" +
+				                           ConstantValue::kindName(*kind) + "', wraps to " + std::to_string(wrapped));
+			}
+			return ConstantValue{*kind, wrapped};
+		}
+		if (toFloating && value.isNumeric()) {
+			return makeFloating(*kind, value.asFloating());
+		}
+		return std::nullopt;
+	}
+}
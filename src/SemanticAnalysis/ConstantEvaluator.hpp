@@ -0,0 +1,32 @@
+#pragma once
+#include <optional>
+#include "../exceptions/ErrorReporter.hpp"
+#include "../ast/AST.hpp"
+
+namespace zenith {
+	// Folds operators over already evaluated operands
+	// The SemanticAnalyzer walks expressions bottom-up and calls in here whenever every operand of a node is constant.
+	// Integers wrap to the width of their type (byte/short/int/long) and report a warning when they do,
+	// float results are rounded to single precision after every operation.
+	class ConstantEvaluator {
+		ErrorReporter& errorReporter;
+
+		std::optional<ConstantValue> integerOp(BinaryOpNode::Op op, ConstantValue::Kind kind, int64_t a, int64_t b,
+		                                       const SourceLocation& loc);
+		static std::optional<ConstantValue> floatingOp(BinaryOpNode::Op op, ConstantValue::Kind kind, double a, double b);
+		static std::optional<ConstantValue> compare(BinaryOpNode::Op op, const ConstantValue& left, const ConstantValue& right);
+
+	public:
+		explicit ConstantEvaluator(ErrorReporter& reporter) : errorReporter(reporter) {}
+
+		std::optional<ConstantValue> literal(const LiteralNode& node);
+		std::optional<ConstantValue> unary(const UnaryOpNode& node, const ConstantValue& operand);
+		std::optional<ConstantValue> binary(const BinaryOpNode& node, const ConstantValue& left, const ConstantValue& right);
+
+		// Converts to a declared primitive type the way a store would, nullopt if there is no implicit conversion
+		std::optional<ConstantValue> convert(const ConstantValue& value, PrimitiveTypeNode::Type target,
+		                                     const SourceLocation& loc);
+
+		static std::optional<ConstantValue::Kind> kindOf(PrimitiveTypeNode::Type type);
+	};
+}
@@ -0,0 +1,549 @@
+#include <algorithm>
+#include <tuple>
+#include "EscapeAnalysis.hpp"
+
+namespace zenith {
+	namespace {
+		std::string causesToString(const uint8_t causes) {
+			static const char* names[] = {"return", "store", "capture", "call", "loop"};
+			std::string out;
+			for (int bit = 0; bit < 5; ++bit) {
+				if (!(causes & (1 << bit))) continue;
+				if (!out.empty()) out += ", ";
+				out += names[bit];
+			}
+			return out;
+		}
+
+		const char* verdictName(const EscapeInfo::Verdict verdict) {
+			switch (verdict) {
+				case EscapeInfo::Verdict::HEAP: return "heap";
+				case EscapeInfo::Verdict::STACK: return "stack";
+				case EscapeInfo::Verdict::SCALAR_REPLACED: return "scalar-replaced";
+				default: return "unanalyzed";
+			}
+		}
+	}
+
+	void EscapeAnalysis::analyze(ProgramNode& program) {
+		functions.clear();
+		constructors.clear();
+		summaries.clear();
+		allocations.clear();
+
+		const std::vector<Body> functionBodies = bodies(program);
+		for (const auto &body: functionBodies) {
+			if (body.kind == BodyKind::FUNCTION) functions.try_emplace(body.name, body.function);
+			else if (body.kind == BodyKind::CONSTRUCTOR) constructors[body.object].push_back(body.function);
+		}
+
+		// Summaries only grow, so this terminates; most programs settle in two rounds
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (auto &body: functionBodies) {
+				if (body.kind == BodyKind::METHOD) continue; // Method calls are dynamically dispatched, never summarized
+				Summary summary = analyzeFunction(*body.function, body.kind, body.name);
+				Summary& known = summaries[body.function];
+				if (summary != known) {
+					known = std::move(summary);
+					changed = true;
+				}
+			}
+		}
+
+		annotate = true;
+		for (auto &body: functionBodies) {
+			analyzeFunction(*body.function, body.kind, body.name);
+		}
+		analyzeGlobals(program);
+		annotate = false;
+
+		std::ranges::sort(allocations, [](const Allocation& a, const Allocation& b) {
+			return std::tie(a.loc.file, a.loc.line, a.loc.column) < std::tie(b.loc.file, b.loc.line, b.loc.column);
+		});
+	}
+
+	void EscapeAnalysis::report(std::ostream& out) const {
+		size_t heap = 0;
+		for (const auto &allocation: allocations) {
+			heap += allocation.info->verdict == EscapeInfo::Verdict::HEAP;
+		}
+		out << "Escape analysis: " << allocations.size() << " allocation(s), " << heap << " on the heap\n";
+		for (const auto &allocation: allocations) {
+			out << "  " << allocation.loc.file << ":" << allocation.loc.line << ":" << allocation.loc.column << ": "
+				<< allocation.kind << " in '" << allocation.function << "': " << verdictName(allocation.info->verdict);
+			if (allocation.info->causes) out << " (" << causesToString(allocation.info->causes) << ")";
+			out << "\n";
+		}
+	}
+
+	// --- Per function ---
+
+	void EscapeAnalysis::reset(const BodyKind kind) {
+		nodes.clear();
+		resetScopes();
+		loopDepth = 0;
+
+		externalNode = newNode();
+		nodes[externalNode].external = true;
+		nodes[externalNode].holdsExternal = true;
+		returnNode = newNode();
+		nodes[returnNode].causes = EscapeInfo::RETURN;
+		// Methods run on an arbitrary receiver, a constructor's 'this' is the object being allocated by the caller
+		thisNode = kind == BodyKind::CONSTRUCTOR ? newNode() : externalNode;
+	}
+
+	EscapeAnalysis::Summary EscapeAnalysis::analyzeFunction(FunctionDeclNode& function, const BodyKind kind, std::string name) {
+		reset(kind);
+		functionName = std::move(name);
+
+		std::vector<uint32_t> params;
+		params.reserve(function.params.size());
+		for (auto &param: function.params) {
+			const uint32_t node = newNode(true);
+			nodes[node].external = true;
+			nodes[node].holdsExternal = true;
+			scopes.back()[param.name] = node;
+			params.push_back(node);
+		}
+		if (auto ctor = dynamic_cast<CtorDeclNode*>(&function)) {
+			for (auto &[field, value]: ctor->initializers) {
+				flow(evaluate(*value, Use::VALUE), thisNode, EdgeKind::STORE);
+			}
+		}
+		if (function.body) function.body->accept(*this);
+
+		solve();
+		if (annotate) annotateSites();
+
+		Summary summary;
+		if (kind == BodyKind::METHOD) return summary;
+		summary.paramEscapes.reserve(params.size());
+		for (const uint32_t param: params) {
+			summary.paramEscapes.push_back(nodes[param].causes & ~EscapeInfo::RETURN);
+			summary.paramReturned.push_back(reaches(param, returnNode));
+			if (kind == BodyKind::CONSTRUCTOR) summary.paramStoredInThis.push_back(reaches(param, thisNode));
+		}
+		if (kind == BodyKind::CONSTRUCTOR) summary.thisEscapes = nodes[thisNode].causes != EscapeInfo::NONE;
+		return summary;
+	}
+
+	void EscapeAnalysis::analyzeGlobals(ProgramNode& program) {
+		// Globals live for the whole program, anything stored in one escapes
+		reset(BodyKind::FUNCTION);
+		functionName = "<global>";
+		for (VarDeclNode* var: globals(program)) {
+			if (var->initializer) flow(evaluate(*var->initializer, Use::VALUE), externalNode, EdgeKind::STORE);
+		}
+		solve();
+		annotateSites();
+	}
+
+	uint32_t EscapeAnalysis::newNode(const bool isVariable) {
+		Node node;
+		node.loopDepth = loopDepth;
+		node.isVariable = isVariable;
+		nodes.push_back(std::move(node));
+		return static_cast<uint32_t>(nodes.size() - 1);
+	}
+
+	uint32_t EscapeAnalysis::newSite(EscapeInfo& info, const char* kind, const SourceLocation& loc) {
+		const uint32_t node = newNode();
+		nodes[node].site = &info;
+		nodes[node].siteKind = kind;
+		nodes[node].siteLoc = loc;
+		return node;
+	}
+
+	void EscapeAnalysis::addEdge(const uint32_t from, const uint32_t to, const EdgeKind kind) {
+		nodes[from].out.push_back({to, kind});
+		nodes[to].in.push_back({from, kind});
+	}
+
+	void EscapeAnalysis::flow(const std::vector<uint32_t>& from, const uint32_t to, const EdgeKind kind) {
+		for (const uint32_t node: from) addEdge(node, to, kind);
+	}
+
+	void EscapeAnalysis::escape(const std::vector<uint32_t>& from, const uint8_t cause) {
+		for (const uint32_t node: from) nodes[node].causes |= cause;
+	}
+
+	const uint32_t* EscapeAnalysis::lookup(const std::string& name) {
+		bool captured = false;
+		const uint32_t* node = find(name, captured);
+		// Referenced from inside a lambda body, the closure may run after this frame is gone
+		if (node && captured) nodes[*node].causes |= EscapeInfo::CAPTURE;
+		return node;
+	}
+
+	std::vector<uint32_t> EscapeAnalysis::evaluate(ExprNode& expr, const Use use) {
+		result.clear();
+		expr.accept(*this);
+		auto nodesOf = std::move(result);
+		result.clear();
+		if (use != Use::BASE) {
+			for (const uint32_t node: nodesOf) {
+				if (use == Use::VALUE || nodes[node].isVariable) nodes[node].wholeUse = true;
+			}
+		}
+		return nodesOf;
+	}
+
+	void EscapeAnalysis::assign(ExprNode& target, ExprNode& value) {
+		// Binding a fresh allocation to a variable is not a use of the object itself
+		auto valueNodes = evaluate(value, Use::BIND);
+
+		if (auto var = dynamic_cast<VarNode*>(&target)) {
+			if (const uint32_t* local = lookup(var->name)) flow(valueNodes, *local, EdgeKind::ASSIGN);
+			else flow(valueNodes, externalNode, EdgeKind::STORE);
+		}
+		else if (auto member = dynamic_cast<MemberAccessNode*>(&target)) {
+			for (const uint32_t base: evaluate(*member->object, Use::BASE)) flow(valueNodes, base, EdgeKind::STORE);
+		}
+		else if (auto element = dynamic_cast<ArrayAccessNode*>(&target)) {
+			evaluate(*element->index, Use::VALUE);
+			// A computed key needs the real object, so this counts as a whole use
+			for (const uint32_t base: evaluate(*element->array, Use::VALUE)) flow(valueNodes, base, EdgeKind::STORE);
+		}
+		else {
+			evaluate(target, Use::VALUE);
+			escape(valueNodes, EscapeInfo::STORE);
+		}
+		result = std::move(valueNodes);
+	}
+
+	void EscapeAnalysis::call(const FunctionDeclNode* callee, small_vector<polymorphic<ExprNode>, 4>& args) {
+		const Summary* summary = nullptr;
+		if (callee) {
+			const auto it = summaries.find(callee);
+			summary = it != summaries.end() ? &it->second : nullptr;
+		}
+
+		std::vector<uint32_t> returned{externalNode};
+		for (size_t i = 0; i < args.size(); ++i) {
+			auto argNodes = evaluate(*args[i], Use::VALUE);
+			// Before the first round every summary is empty, i.e. optimistic, the fixpoint fixes that up
+			if (!callee) {
+				escape(argNodes, EscapeInfo::CALL);
+				continue;
+			}
+			if (!summary || i >= summary->paramEscapes.size()) continue;
+			if (summary->paramEscapes[i]) escape(argNodes, EscapeInfo::CALL);
+			if (summary->paramReturned[i]) returned.insert(returned.end(), argNodes.begin(), argNodes.end());
+		}
+		result = std::move(returned);
+	}
+
+	// --- Solving ---
+
+	void EscapeAnalysis::solve() {
+		// Forward: which nodes may refer to memory this function does not own
+		std::vector<uint32_t> work;
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			if (nodes[i].external || nodes[i].holdsExternal) work.push_back(i);
+		}
+		while (!work.empty()) {
+			const uint32_t from = work.back();
+			work.pop_back();
+			const bool external = nodes[from].external;
+			const bool holdsExternal = nodes[from].holdsExternal;
+			for (const auto &[to, kind]: nodes[from].out) {
+				auto& target = nodes[to];
+				const bool before = target.external, beforeHolds = target.holdsExternal;
+				switch (kind) {
+					case EdgeKind::ASSIGN:
+						target.external |= external;
+						target.holdsExternal |= holdsExternal;
+						break;
+					case EdgeKind::STORE:
+						target.holdsExternal |= external || holdsExternal;
+						break;
+					case EdgeKind::LOAD:
+						target.external |= external || holdsExternal;
+						target.holdsExternal |= external || holdsExternal;
+						break;
+				}
+				if (target.external != before || target.holdsExternal != beforeHolds) work.push_back(to);
+			}
+		}
+
+		// Storing into something that may be foreign memory publishes the value
+		for (auto &node: nodes) {
+			for (const auto &[to, kind]: node.out) {
+				if (kind == EdgeKind::STORE && nodes[to].external) node.causes |= EscapeInfo::STORE;
+			}
+		}
+
+		// Backward: whatever flows into an escaping node escapes for the same reasons
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			if (nodes[i].causes) work.push_back(i);
+		}
+		while (!work.empty()) {
+			const uint32_t to = work.back();
+			work.pop_back();
+			const uint8_t causes = nodes[to].causes;
+			for (const auto &[from, kind]: nodes[to].in) {
+				if ((nodes[from].causes | causes) != nodes[from].causes) {
+					nodes[from].causes |= causes;
+					work.push_back(from);
+				}
+			}
+		}
+
+		// A stack slot inside a loop is reused every iteration, so it must not be reachable from outside the loop
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			auto& site = nodes[i];
+			if (!site.site || site.causes || site.loopDepth == 0) continue;
+
+			std::vector<bool> seen(nodes.size());
+			work.assign(1, i);
+			seen[i] = true;
+			while (!work.empty() && !(site.causes & EscapeInfo::LOOP)) {
+				const uint32_t cur = work.back();
+				work.pop_back();
+				for (const auto &edge: nodes[cur].out) {
+					if (seen[edge.node]) continue;
+					seen[edge.node] = true;
+					if (nodes[edge.node].loopDepth < site.loopDepth) {
+						site.causes |= EscapeInfo::LOOP;
+						break;
+					}
+					work.push_back(edge.node);
+				}
+			}
+		}
+	}
+
+	bool EscapeAnalysis::reaches(const uint32_t from, const uint32_t to) const {
+		std::vector<bool> seen(nodes.size());
+		std::vector<uint32_t> work{from};
+		seen[from] = true;
+		while (!work.empty()) {
+			const uint32_t cur = work.back();
+			work.pop_back();
+			if (cur == to) return true;
+			for (const auto &edge: nodes[cur].out) {
+				if (!seen[edge.node]) {
+					seen[edge.node] = true;
+					work.push_back(edge.node);
+				}
+			}
+		}
+		return false;
+	}
+
+	bool EscapeAnalysis::isScalarReplaceable(const uint32_t site) const {
+		// Only ever bound to variables that hold nothing else and are only used through their fields
+		if (nodes[site].wholeUse) return false;
+		for (const auto &[node, kind]: nodes[site].out) {
+			if (kind == EdgeKind::LOAD) continue;
+			const auto& var = nodes[node];
+			if (kind != EdgeKind::ASSIGN || !var.isVariable || var.wholeUse) return false;
+			const auto assignments = std::ranges::count_if(var.in, [](const Edge& e) { return e.kind == EdgeKind::ASSIGN; });
+			if (assignments != 1) return false;
+			if (!std::ranges::all_of(var.out, [](const Edge& e) { return e.kind == EdgeKind::LOAD; })) return false;
+		}
+		return true;
+	}
+
+	void EscapeAnalysis::annotateSites() {
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			const auto& node = nodes[i];
+			if (!node.site) continue;
+			node.site->causes = node.causes;
+			node.site->verdict = node.causes
+				                     ? EscapeInfo::Verdict::HEAP
+				                     : isScalarReplaceable(i)
+				                     ? EscapeInfo::Verdict::SCALAR_REPLACED
+				                     : EscapeInfo::Verdict::STACK;
+			allocations.push_back({node.siteLoc, node.siteKind, functionName, node.site});
+		}
+	}
+
+	// --- Statements ---
+
+	void EscapeAnalysis::visit(VarDeclNode& node) {
+		const uint32_t var = newNode(true);
+		if (node.initializer) flow(evaluate(*node.initializer, Use::BIND), var, EdgeKind::ASSIGN);
+		scopes.back()[node.name] = var;
+	}
+
+	void EscapeAnalysis::visit(ExprStmtNode& node) {
+		evaluate(*node.expr, Use::BASE); // Result is discarded
+	}
+
+	void EscapeAnalysis::visit(ReturnStmtNode& node) {
+		if (node.value) flow(evaluate(*node.value, Use::VALUE), returnNode, EdgeKind::ASSIGN);
+	}
+
+	void EscapeAnalysis::visit(IfNode& node) {
+		evaluate(*node.condition, Use::VALUE);
+		if (node.thenBranch) node.thenBranch->accept(*this);
+		if (node.elseBranch) node.elseBranch->accept(*this);
+	}
+
+	void EscapeAnalysis::visit(WhileNode& node) {
+		++loopDepth;
+		evaluate(*node.condition, Use::VALUE);
+		if (node.body) node.body->accept(*this);
+		--loopDepth;
+	}
+
+	void EscapeAnalysis::visit(DoWhileNode& node) {
+		++loopDepth;
+		if (node.body) node.body->accept(*this);
+		evaluate(*node.condition, Use::VALUE);
+		--loopDepth;
+	}
+
+	void EscapeAnalysis::visit(ForNode& node) {
+		scopes.emplace_back();
+		if (node.initializer) node.initializer->accept(*this);
+		++loopDepth;
+		if (node.condition) evaluate(*node.condition, Use::VALUE);
+		if (node.increment) evaluate(*node.increment, Use::BASE);
+		if (node.body) node.body->accept(*this);
+		--loopDepth;
+		scopes.pop_back();
+	}
+
+	// --- Expressions ---
+
+	void EscapeAnalysis::visit(LiteralNode&) {
+		result.clear();
+	}
+
+	void EscapeAnalysis::visit(VarNode& node) {
+		if (const uint32_t* local = lookup(node.name)) result = {*local};
+		else if (functions.contains(node.name)) result.clear();
+		else result = {externalNode}; // Global
+	}
+
+	void EscapeAnalysis::visit(ThisNode&) {
+		if (lambdaScopeFloor) nodes[thisNode].causes |= EscapeInfo::CAPTURE;
+		result = {thisNode};
+	}
+
+	void EscapeAnalysis::visit(BinaryOpNode& node) {
+		if (node.op == BinaryOpNode::ASN) {
+			assign(*node.left, *node.right);
+			return;
+		}
+		// Compound assignments and every other operator only read their operands
+		evaluate(*node.left, Use::VALUE);
+		evaluate(*node.right, Use::VALUE);
+		result.clear();
+	}
+
+	void EscapeAnalysis::visit(UnaryOpNode& node) {
+		evaluate(*node.right, Use::VALUE);
+		result.clear();
+	}
+
+	void EscapeAnalysis::visit(CallNode& node) {
+		if (auto var = dynamic_cast<VarNode*>(node.callee.get()); var && !lookup(var->name)) {
+			if (const auto it = functions.find(var->name); it != functions.end()) {
+				call(it->second, node.arguments);
+				return;
+			}
+		}
+		// Unknown target: a method (dynamic dispatch), a lambda or an import. The receiver is passed along too.
+		if (auto member = dynamic_cast<MemberAccessNode*>(node.callee.get())) {
+			escape(evaluate(*member->object, Use::VALUE), EscapeInfo::CALL);
+		}
+		else {
+			escape(evaluate(*node.callee, Use::VALUE), EscapeInfo::CALL);
+		}
+		call(nullptr, node.arguments);
+	}
+
+	void EscapeAnalysis::visit(MemberAccessNode& node) {
+		const auto bases = evaluate(*node.object, Use::BASE);
+		const uint32_t loaded = newNode();
+		for (const uint32_t base: bases) addEdge(base, loaded, EdgeKind::LOAD);
+		result = {loaded};
+	}
+
+	void EscapeAnalysis::visit(ArrayAccessNode& node) {
+		const auto bases = evaluate(*node.array, Use::VALUE); // Computed key, cannot be scalar replaced
+		evaluate(*node.index, Use::VALUE);
+		const uint32_t loaded = newNode();
+		for (const uint32_t base: bases) addEdge(base, loaded, EdgeKind::LOAD);
+		result = {loaded};
+	}
+
+	void EscapeAnalysis::visit(FreeObjectNode& node) {
+		const uint32_t site = newSite(node.escape, "free object", node.loc);
+		for (auto &[name, value]: node.properties) {
+			flow(evaluate(*value, Use::VALUE), site, EdgeKind::STORE);
+		}
+		result = {site};
+	}
+
+	void EscapeAnalysis::visit(StructInitializerNode& node) {
+		const uint32_t site = newSite(node.escape, "struct initializer", node.loc);
+		for (auto &field: node.fields) {
+			flow(evaluate(*field.value, Use::VALUE), site, EdgeKind::STORE);
+		}
+		result = {site};
+	}
+
+	void EscapeAnalysis::visit(NewExprNode& node) {
+		const uint32_t site = newSite(node.escape, "new", node.loc);
+
+		std::vector<const Summary*> candidates;
+		bool known = true;
+		if (const auto it = constructors.find(node.className); it != constructors.end()) {
+			for (auto &ctor: it->second) {
+				if (ctor->params.size() != node.args.size()) continue;
+				const auto summary = summaries.find(ctor);
+				if (summary == summaries.end()) known = false;
+				else candidates.push_back(&summary->second);
+			}
+			// No constructor matched by arity (default parameters, a variadic or a bad call), assume the worst
+			if (candidates.empty()) known = false;
+		}
+		else known = node.args.empty(); // Implicit default constructor
+
+		for (size_t i = 0; i < node.args.size(); ++i) {
+			auto argNodes = evaluate(*node.args[i], Use::VALUE);
+			if (!known) escape(argNodes, EscapeInfo::CALL);
+			// Overloads are not resolved here, so every constructor with a matching arity counts
+			for (const Summary* summary: candidates) {
+				if (summary->paramEscapes[i]) escape(argNodes, EscapeInfo::CALL);
+				if (summary->paramStoredInThis[i]) flow(argNodes, site, EdgeKind::STORE);
+			}
+		}
+		for (const Summary* summary: candidates) {
+			if (summary->thisEscapes) nodes[site].causes |= EscapeInfo::CALL;
+		}
+		result = {site};
+	}
+
+	void EscapeAnalysis::visit(TemplateStringNode& node) {
+		// Interpolation calls toString() on each part
+		for (auto &part: node.parts) escape(evaluate(*part, Use::VALUE), EscapeInfo::CALL);
+		result.clear();
+	}
+
+	void EscapeAnalysis::visit(LambdaExprNode& node) {
+		// The body is analyzed in place: outer variables it touches are captured, its own returns leave the closure
+		const uint32_t savedReturn = returnNode;
+		const uint32_t savedDepth = loopDepth;
+		loopDepth = 0;
+		returnNode = newNode();
+		nodes[returnNode].causes = EscapeInfo::RETURN;
+
+		walkLambda(node, [this](const FunctionDeclNode::Param&) {
+			const uint32_t var = newNode(true);
+			nodes[var].external = true;
+			nodes[var].holdsExternal = true;
+			return var;
+		});
+
+		returnNode = savedReturn;
+		loopDepth = savedDepth;
+		result.clear();
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BodyPass.hpp"
+
+namespace zenith {
+	// Decides for every FreeObjectNode, NewExprNode and StructInitializerNode whether the object can outlive
+	// the function that allocates it, and writes the verdict into the node's EscapeInfo.
+	//
+	// Each function body becomes a small flow-insensitive graph: locals, parameters and allocation sites are nodes,
+	// assignments/stores/loads are edges. An object escapes when it can reach a return, a store into memory the
+	// function does not own, a lambda capture or a call we know nothing about. Top-level functions and constructors
+	// get summaries (which parameters escape, are returned or stored into 'this') so calls to them stay precise;
+	// the summaries are iterated to a fixpoint to handle recursion.
+	class EscapeAnalysis : public BodyPass<uint32_t> {
+	public:
+		struct Allocation {
+			SourceLocation loc;
+			const char* kind;
+			std::string function;
+			const EscapeInfo* info;
+		};
+
+	private:
+		struct Summary {
+			std::vector<uint8_t> paramEscapes; // EscapeInfo::Cause bits
+			std::vector<bool> paramReturned;
+			std::vector<bool> paramStoredInThis; // Constructors only
+			bool thisEscapes = false;            // Constructors only
+
+			bool operator==(const Summary&) const = default;
+		};
+
+		enum class EdgeKind : uint8_t { ASSIGN, STORE, LOAD };
+		struct Edge {
+			uint32_t node;
+			EdgeKind kind;
+		};
+		struct Node {
+			std::vector<Edge> out; // Value of this node may end up in / be read from the target
+			std::vector<Edge> in;
+			uint32_t loopDepth = 0;
+			uint8_t causes = EscapeInfo::NONE;
+			bool external = false;      // May point to an object this function did not allocate
+			bool holdsExternal = false; // Its fields may point to such an object
+			bool wholeUse = false;      // Used as a value (compared, passed, copied), not only through its fields
+			bool isVariable = false;
+			EscapeInfo* site = nullptr;
+			const char* siteKind = nullptr;
+			SourceLocation siteLoc;
+		};
+		enum class Use : uint8_t { VALUE, BASE, BIND };
+
+		// Whole program
+		std::unordered_map<std::string, FunctionDeclNode*> functions;
+		std::unordered_map<std::string, std::vector<FunctionDeclNode*>> constructors;
+		std::unordered_map<const FunctionDeclNode*, Summary> summaries;
+		std::vector<Allocation> allocations;
+		bool annotate = false;
+
+		// Current function
+		std::vector<Node> nodes;
+		uint32_t externalNode = 0;
+		uint32_t returnNode = 0;
+		uint32_t thisNode = 0;
+		uint32_t loopDepth = 0;
+		std::string functionName;
+		std::vector<uint32_t> result; // Nodes the last visited expression may evaluate to
+
+		void reset(BodyKind kind);
+		uint32_t newNode(bool isVariable = false);
+		uint32_t newSite(EscapeInfo& info, const char* kind, const SourceLocation& loc);
+		void addEdge(uint32_t from, uint32_t to, EdgeKind kind);
+		void flow(const std::vector<uint32_t>& from, uint32_t to, EdgeKind kind);
+		void escape(const std::vector<uint32_t>& from, uint8_t cause);
+		const uint32_t* lookup(const std::string& name);
+		std::vector<uint32_t> evaluate(ExprNode& expr, Use use);
+		void assign(ExprNode& target, ExprNode& value);
+		void call(const FunctionDeclNode* callee, small_vector<polymorphic<ExprNode>, 4>& args);
+
+		void solve();
+		bool reaches(uint32_t from, uint32_t to) const;
+		bool isScalarReplaceable(uint32_t site) const;
+		void annotateSites();
+		Summary analyzeFunction(FunctionDeclNode& function, BodyKind kind, std::string name);
+		void analyzeGlobals(ProgramNode& program);
+
+	public:
+		void analyze(ProgramNode& program);
+		[[nodiscard]] const std::vector<Allocation>& results() const { return allocations; }
+		void report(std::ostream& out) const;
+
+		using BodyPass::visit;
+
+		// Statements
+		void visit(VarDeclNode& node) override;
+		void visit(ExprStmtNode& node) override;
+		void visit(ReturnStmtNode& node) override;
+		void visit(IfNode& node) override;
+		void visit(WhileNode& node) override;
+		void visit(DoWhileNode& node) override;
+		void visit(ForNode& node) override;
+		// Expressions
+		void visit(LiteralNode& node) override;
+		void visit(VarNode& node) override;
+		void visit(ThisNode& node) override;
+		void visit(BinaryOpNode& node) override;
+		void visit(UnaryOpNode& node) override;
+		void visit(CallNode& node) override;
+		void visit(MemberAccessNode& node) override;
+		void visit(ArrayAccessNode& node) override;
+		void visit(FreeObjectNode& node) override;
+		void visit(NewExprNode& node) override;
+		void visit(StructInitializerNode& node) override;
+		void visit(TemplateStringNode& node) override;
+		void visit(LambdaExprNode& node) override;
+	};
+}
@@ -5,9 +5,10 @@
 #include <unordered_set>
 #include "SemanticAnalyzer.hpp"
 #include "fmt/args.h"
+#include "utils/TimeTrace.hpp"
 
-#define CREATE_ERROR_INFO(loc) ExpressionInfo(make_polymorphic<TypeNode>(loc, TypeNode::Kind::ERROR), false, false)
-#define CREATE_ERROR_TYPE(loc) make_polymorphic<TypeNode>(loc, TypeNode::Kind::ERROR)
+#define CREATE_ERROR_INFO(loc) ExpressionInfo(make_node<TypeNode>(loc, TypeNode::Kind::ERROR), false, false)
+#define CREATE_ERROR_TYPE(loc) make_node<TypeNode>(loc, TypeNode::Kind::ERROR)
 
 namespace zenith {
 	auto isNumeric = [](const polymorphic_ref<TypeNode>& t) -> bool {
@@ -31,19 +32,134 @@ namespace zenith {
 		}
 	};
 	namespace constants {
-		auto BOOL_TYPE = make_polymorphic<PrimitiveTypeNode>(SourceLocation{}, PrimitiveTypeNode::Type::BOOL); //NOLINT
-		auto VOID_TYPE = make_polymorphic<PrimitiveTypeNode>(SourceLocation{}, PrimitiveTypeNode::Type::VOID); //NOLINT
+		auto BOOL_TYPE = make_node<PrimitiveTypeNode>(SourceLocation{}, PrimitiveTypeNode::Type::BOOL); //NOLINT
+		auto VOID_TYPE = make_node<PrimitiveTypeNode>(SourceLocation{}, PrimitiveTypeNode::Type::VOID); //NOLINT
 	}
 
 	SymbolTable &&SemanticAnalyzer::analyze(polymorphic_ref<ProgramNode> program) {
 		program->accept(*this);
+		collecting = false;
 		return std::move(symbolTable);
 	}
 
+	SemanticAnalyzer::SemanticAnalyzer(ErrorReporter& errorReporter, SemanticAnalyzer& global)
+		: errorReporter(errorReporter), symbolTable(errorReporter, global.symbolTable),
+		  ownClassHierarchy(errorReporter), classHierarchy(global.classHierarchy), constantEvaluator(errorReporter) {}
+
+	void SemanticAnalyzer::collectDeclarations(ProgramNode& program) {
+		TimeTrace::Scope trace("Collect declarations", "analyze");
+		classHierarchy.clear();
+		for (auto &decl: program.declarations) {
+			collectDeclaration(decl);
+		}
+		declareCollected();
+	}
+
+	void SemanticAnalyzer::collectDeclaration(polymorphic_ref<ASTNode> decl) {
+		polymorphic_ref<ASTNode> target = std::move(decl);
+		if (auto templ = target.cast().non_throwing().to<TemplateDeclNode>()) {
+			target = templ->declaration;
+		}
+		// Types right away, function signatures wait for every class so they can name any regardless of source order
+		if (auto object = target.cast().non_throwing().to<ObjectDeclNode>()) {
+			declareObject(*object);
+		}
+		else if (auto function = target.cast().non_throwing().to<FunctionDeclNode>()) {
+			collectedFunctions.push_back(std::move(function));
+		}
+	}
+
+	void SemanticAnalyzer::declareCollected() {
+		classHierarchy.build();
+		for (auto &function: collectedFunctions) {
+			declareFunction(*function);
+		}
+		collectedFunctions.clear();
+	}
+
+	void SemanticAnalyzer::collect(polymorphic_ref<ASTNode> declaration) {
+		if (!collecting) classHierarchy.clear();
+		collecting = true;
+		collectDeclaration(std::move(declaration));
+	}
+
+	void SemanticAnalyzer::declareObject(ObjectDeclNode& node) {
+		classHierarchy.add(node);
+		symbolTable.declare(node.name,
+		                    SymbolInfo(node.kind == ObjectDeclNode::Kind::ACTOR ? SymbolInfo::ACTOR : SymbolInfo::OBJECT,
+		                               make_node<NamedTypeNode>(node.loc, node.name), node));
+	}
+
+	void SemanticAnalyzer::declareFunction(FunctionDeclNode& node) {
+		symbolTable.declare(node.name, SymbolInfo(SymbolInfo::FUNCTION, makeFunctionType(node), node));
+	}
+
+	void SemanticAnalyzer::checkBody(const BodyTask& body, ErrorReporter& reporter, std::vector<Reference>* references) {
+		SemanticAnalyzer worker(reporter, *this);
+		auto [function, owner] = body;
+		worker.currentClass = owner;
+		worker.references = references;
+		worker.checkFunctionBody(*function);
+	}
+
+	std::vector<SemanticAnalyzer::BodyTask> SemanticAnalyzer::bodies(polymorphic_ref<ASTNode> declaration) {
+		if (auto templ = declaration.cast().non_throwing().to<TemplateDeclNode>()) declaration = templ->declaration;
+		std::vector<BodyTask> found;
+		if (auto function = declaration.cast().non_throwing().to<FunctionDeclNode>()) {
+			found.push_back({function, nullptr});
+		}
+		else if (auto object = declaration.cast().non_throwing().to<ObjectDeclNode>()) {
+			// Methods, constructors and message handlers, in the order declareGlobals() visits them
+			for (auto& member: object->members) {
+				if (auto method = polymorphic_ref<DeclNode>(member).cast().non_throwing().to<FunctionDeclNode>()) {
+					found.push_back({method, object});
+				}
+			}
+		}
+		return found;
+	}
+
+	void SemanticAnalyzer::checkBodies(const std::vector<BodyTask>& tasks) {
+		// Workers report straight into the shared DiagnosticsEngine, which orders the output itself
+		auto check = [this, &tasks](const size_t i) {
+			checkBody(tasks[i], errorReporter);
+		};
+
+		if (!pool || pool->size() < 2 || tasks.size() < 2) {
+			for (size_t i = 0; i < tasks.size(); ++i) {
+				check(i);
+			}
+			return;
+		}
+		pool->parallelFor(tasks.size(), check);
+	}
+
 	void SemanticAnalyzer::visit(ProgramNode& node) {
-		for (auto &x: node.declarations) {
+		// Phase 1: every top-level type and function signature goes into the global scope
+		if (collecting) {
+			TimeTrace::Scope trace("Collect declarations", "analyze");
+			declareCollected();
+		}
+		else collectDeclarations(node);
+		// Phase 2: the global scope is read-only from here on, so bodies can be checked independently
+		checkBodies(declareGlobals(node));
+	}
+
+	std::vector<SemanticAnalyzer::BodyTask> SemanticAnalyzer::declare(polymorphic_ref<ProgramNode> program) {
+		collectDeclarations(*program);
+		return declareGlobals(*program);
+	}
+
+	std::vector<SemanticAnalyzer::BodyTask> SemanticAnalyzer::declareGlobals(ProgramNode& program) {
+		// Globals, imports and class-level members in source order, bodies are only collected
+		std::vector<BodyTask> bodies;
+		deferredBodies = &bodies;
+		for (auto &x: program.declarations) {
 			x->accept(*this);
 		}
+		deferredBodies = nullptr;
+		symbolTable.freeze();
+		return bodies;
 	}
 	void SemanticAnalyzer::visit(ASTNode& node) {
 		Visitor::visit(node);
@@ -58,6 +174,11 @@ namespace zenith {
 		}
 		symbolTable.exitScope();
 	}
+	void SemanticAnalyzer::visit(LazyBlockNode& node) {
+		// Syntax errors in a lazily parsed body are reported with the rest of this analysis
+		node.materialize(&errorReporter);
+		visit(static_cast<BlockNode&>(node));
+	}
 	void SemanticAnalyzer::visit(VarDeclNode& node) {
 		polymorphic_variant<TypeNode> declaredType = node.type ? resolveType(node.type).copy_or_share() : polymorphic_variant<TypeNode>(nullptr);
 		ExpressionInfo initializerType;
@@ -74,7 +195,7 @@ namespace zenith {
 
 		// Handle dynamic variables
 		if (node.kind == VarDeclNode::DYNAMIC) {
-			finalType = make_polymorphic<TypeNode>(node.loc, TypeNode::Kind::DYNAMIC);
+			finalType = make_node<TypeNode>(node.loc, TypeNode::Kind::DYNAMIC);
 
 			if (declaredType && !declaredType->isDynamic()) {
 				errorReporter.report(node.type->loc,
@@ -105,20 +226,32 @@ namespace zenith {
 				errorReporter.report(node.loc,
 				                     "Variable '" + node.name +
 				                     "' must have a type or an initializer for static declaration");
-				finalType = make_polymorphic<TypeNode>(node.loc, TypeNode::Kind::ERROR);
+				finalType = make_node<TypeNode>(node.loc, TypeNode::Kind::ERROR);
+			}
+		}
+
+		// A store converts to the declared type, so the folded initializer does too
+		if (node.initializer && node.initializer->constantValue && declaredType && node.kind != VarDeclNode::DYNAMIC) {
+			if (auto prim = declaredType.get_ref().cast().non_throwing().to<PrimitiveTypeNode>()) {
+				node.initializer->constantValue = constantEvaluator.convert(*node.initializer->constantValue, prim->type,
+				                                                            node.initializer->loc);
 			}
 		}
 
 		// Declare in symbol table
-		symbolTable.declare(node.name,
-		                    SymbolInfo(SymbolInfo::VARIABLE, std::move(finalType), node, node.isConst));
+		if (references) references->push_back({node, node, SymbolInfo::VARIABLE, typeToString(finalType)});
+		SymbolInfo info(SymbolInfo::VARIABLE, std::move(finalType), node, node.isConst);
+		if (node.isConst && node.initializer) {
+			info.constantValue = node.initializer->constantValue;
+		}
+		symbolTable.declare(node.name, std::move(info));
 	}
 	void SemanticAnalyzer::visit(MultiVarDeclNode& node) {
 		for (auto &x: node.vars) {
 			x->accept(*this);
 		}
 	}
-	void SemanticAnalyzer::visit(FunctionDeclNode& node) {
+	polymorphic_variant<TypeNode> SemanticAnalyzer::makeFunctionType(FunctionDeclNode& node) {
 		polymorphic_variant<TypeNode> returnTypeVariant = nullptr;
     if (node.returnType) {
         returnTypeVariant = resolveType(node.returnType);
@@ -132,26 +265,34 @@ namespace zenith {
         if (!pType) {
             errorReporter.report(param.type ? param.type->loc : node.loc,
                                  "Unresolved type for parameter '" + param.name + "' in function '" + node.name + "'");
-            paramTypes.emplace_back(make_polymorphic<TypeNode>(
+            paramTypes.emplace_back(make_node<TypeNode>(
                 param.type ? param.type->loc : node.loc, TypeNode::Kind::ERROR));
         } else {
             paramTypes.push_back(std::move(pType));
         }
     }
 
-    auto functionType = make_polymorphic<FunctionTypeNode>(
+    return make_node<FunctionTypeNode>(
         node.loc,
         std::move(paramTypes),
         returnTypeVariant ? std::move(returnTypeVariant)
-                          : make_polymorphic<PrimitiveTypeNode>(
+                          : make_node<PrimitiveTypeNode>(
                                 node.loc, PrimitiveTypeNode::Type::VOID)
                                 .cast()
                                 .to<TypeNode>()
     );
-
-    SymbolInfo funcInfo(SymbolInfo::FUNCTION, std::move(functionType), node);
-    symbolTable.declare(node.name, std::move(funcInfo));
-
+	}
+	void SemanticAnalyzer::visit(FunctionDeclNode& node) {
+		// The signature was declared by collectDeclarations, only the body is left
+		if (deferredBodies) {
+			deferredBodies->push_back({node, currentClass});
+			return;
+		}
+		checkFunctionBody(node);
+	}
+	void SemanticAnalyzer::checkFunctionBody(FunctionDeclNode& node) {
+    TimeTrace::Scope trace("Analyze function", "analyze");
+    trace.detail(node.name);
     auto previousFunction = currentFunction;
     currentFunction = node;
 
@@ -160,7 +301,7 @@ namespace zenith {
     for (auto& param : node.params) {
         auto pType = resolveType(param.type);
         if (!pType) {
-            pType = make_polymorphic<TypeNode>(
+            pType = make_node<TypeNode>(
                 param.type ? param.type->loc : node.loc, TypeNode::Kind::DYNAMIC);
         }
 
@@ -200,7 +341,7 @@ namespace zenith {
 				errorReporter.report(param ? param->loc : node.loc,
 				                     "Could not resolve type for lambda parameter '" + name);
 				paramError = true;
-				paramTypes.emplace_back(make_polymorphic<TypeNode>(
+				paramTypes.emplace_back(make_node<TypeNode>(
 					param ? param->loc : node.loc, TypeNode::Kind::ERROR));
 			}
 			else {
@@ -209,7 +350,7 @@ namespace zenith {
 		}
 
 		if (paramError) {
-			exprVR = ExpressionInfo(make_polymorphic<TypeNode>(
+			exprVR = ExpressionInfo(make_node<TypeNode>(
 					node.loc, TypeNode::Kind::ERROR), false, false);
 			return;
 		}
@@ -220,7 +361,7 @@ namespace zenith {
 			if (!returnType) {
 				errorReporter.report(node.lambda->returnType->loc,
 				                     "Could not resolve explicit return type for lambda");
-				exprVR = ExpressionInfo (make_polymorphic<TypeNode>(node.lambda->returnType->loc, TypeNode::Kind::ERROR), false, false);
+				exprVR = ExpressionInfo (make_node<TypeNode>(node.lambda->returnType->loc, TypeNode::Kind::ERROR), false, false);
 				return; // Early exit
 			}
 		}
@@ -278,7 +419,7 @@ namespace zenith {
 			exprVR = CREATE_ERROR_INFO(node.loc);
 		}
 		else {
-			exprVR = ExpressionInfo(make_polymorphic<FunctionTypeNode>(
+			exprVR = ExpressionInfo(make_node<FunctionTypeNode>(
 				node.loc, std::move(paramTypes), std::move(returnType)).cast().to<TypeNode>(), false, false);
 		}
 	}
@@ -294,12 +435,7 @@ namespace zenith {
 
 		symbolTable.enterScope();
 
-		if (!node.base.empty()) {
-			auto baseInfo = symbolTable.lookup(node.base, SymbolInfo::OBJECT);
-			if (!baseInfo) {
-				errorReporter.report(node.loc, "Base class '" + node.base + "' not found");
-			}
-		}
+		// Missing bases and inheritance cycles are reported once by classHierarchy.build()
 
 		// Process all members
 		for (auto &member: node.members) {
@@ -317,6 +453,34 @@ namespace zenith {
 		// Restore previous class context
 		currentClass = previousClass;
 	}
+	void SemanticAnalyzer::visit(ActorDeclNode& node) {
+		visit(static_cast<ObjectDeclNode&>(node));
+	}
+	void SemanticAnalyzer::visit(TemplateDeclNode& node) {
+		node.declaration->accept(*this);
+	}
+	void SemanticAnalyzer::visit(FieldDeclNode& node) {
+		if (!node.initializer) return;
+
+		auto initializerType = visitExpression(node.initializer);
+		if (!node.type || !initializerType.type) return;
+
+		auto declaredType = resolveType(node.type);
+		if (!areTypesCompatible(declaredType, initializerType.type.get_ref())) {
+			errorReporter.report(node.initializer->loc,
+			                     "Initializer type '" + typeToString(initializerType.type.get_ref()) +
+			                     "' is not compatible with field type '" + typeToString(declaredType) + "'");
+		}
+	}
+	void SemanticAnalyzer::visit(MethodDeclNode& node) {
+		visit(static_cast<FunctionDeclNode&>(node));
+	}
+	void SemanticAnalyzer::visit(CtorDeclNode& node) {
+		visit(static_cast<FunctionDeclNode&>(node));
+	}
+	void SemanticAnalyzer::visit(MessageHandlerNode& node) {
+		visit(static_cast<FunctionDeclNode&>(node));
+	}
 	void SemanticAnalyzer::visit(ReturnStmtNode& node) {
 		if (!currentFunction) {
 			errorReporter.report(node.loc, "'return' statement outside of function.");
@@ -413,15 +577,8 @@ namespace zenith {
 					// Exact same name
 					if (targetObj->name == valueObj->name) return true;
 
-					// Check inheritance
-					if (auto valueSymbol = symbolTable.lookup(valueObj->name, SymbolInfo::OBJECT); valueSymbol && valueSymbol->declarationNode) {
-						if (auto valueDecl = valueSymbol->declarationNode.cast().non_throwing().to<ObjectDeclNode>(); valueDecl && !valueDecl->base.empty()) {
-							polymorphic_variant<TypeNode> baseType = make_polymorphic<
-								NamedTypeNode>(valueObj->loc, valueDecl->base);
-							return areTypesCompatible(targetType, baseType.get_ref());
-						}
-					}
-					return false;
+					// Check inheritance (constant-time interval check on the hierarchy numbering)
+					return classHierarchy.isSubclassOf(valueObj->name, targetObj->name);
 				}
 
 				case TypeNode::Kind::ARRAY: {
@@ -514,7 +671,7 @@ namespace zenith {
 			case TypeNode::Kind::ARRAY: {
 				auto arr = type.cast().non_throwing().unchecked().to<ArrayTypeNode>();
 				if (!arr || !arr->elementType) return "<invalid array>";
-				return typeToString(arr->elementType.get_ref()) + "[]";
+				return typeToString(arr->elementType.get_ref()) + "[" + (arr->size ? std::to_string(*arr->size) : "") + "]";
 			}
 
 			case TypeNode::Kind::FUNCTION: {
@@ -557,22 +714,25 @@ namespace zenith {
 	void SemanticAnalyzer::visit(LiteralNode& node) {
 		switch (node.type) {
 			case LiteralNode::NUMBER:
-				exprVR = ExpressionInfo(make_polymorphic<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::NUMBER), false, false);
+				exprVR = ExpressionInfo(make_node<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::NUMBER), false, false);
 				break;
 			case LiteralNode::STRING:
-				exprVR = ExpressionInfo(make_polymorphic<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::STRING), false, false);
+				exprVR = ExpressionInfo(make_node<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::STRING), false, false);
 				break;
 			case LiteralNode::BOOL:
-				exprVR = ExpressionInfo(make_polymorphic<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::BOOL), false, false);
+				exprVR = ExpressionInfo(make_node<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::BOOL), false, false);
 				break;
 			case LiteralNode::NIL:
-				exprVR = ExpressionInfo(make_polymorphic<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::NIL), false, false);
+				exprVR = ExpressionInfo(make_node<PrimitiveTypeNode>(node.loc, PrimitiveTypeNode::Type::NIL), false, false);
 				break;
 		}
+		node.constantValue = constantEvaluator.literal(node);
 	}
 	void SemanticAnalyzer::visit(VarNode& node) {
 		if (const auto symbol = symbolTable.lookup(node.name)) {
 			exprVR = ExpressionInfo(symbol->type.copy_or_share(), true, symbol->isConst);
+			node.constantValue = symbol->constantValue; // const propagation
+			if (references) references->push_back({node, symbol->declarationNode, symbol->kind, typeToString(symbol->type)});
 		}
 		else {
 			errorReporter.error(node.loc, "Undeclared variable '" + node.name + "'");
@@ -583,7 +743,8 @@ namespace zenith {
 		auto leftType = visitExpression(node.left);
 		auto rightType = visitExpression(node.right);
 
-		if (node.op >= BinaryOpNode::ASN && node.op <= BinaryOpNode::MOD_ASN) {
+		// MOD sits between ASN and the compound assignments
+		if (node.op == BinaryOpNode::ASN || (node.op >= BinaryOpNode::ADD_ASN && node.op <= BinaryOpNode::MOD_ASN)) {
 			if (!areTypesCompatible(leftType.type.get_ref(), rightType.type.get_ref())) {
 				errorReporter.report(node.loc,
 				                     "Type mismatch in assignment. Left type: " +
@@ -602,22 +763,39 @@ namespace zenith {
 									 typeToString(leftType.type) + ", right type: " +
 									 typeToString(rightType.type));
 			}
-			exprVR = ExpressionInfo(make_polymorphic<PrimitiveTypeNode>(node.loc,PrimitiveTypeNode::Type::BOOL), false, false);
-			return;
+			exprVR = ExpressionInfo(make_node<PrimitiveTypeNode>(node.loc,PrimitiveTypeNode::Type::BOOL), false, false);
 		}
-		if (!areTypesCompatible(leftType.type, rightType.type)) {
-			errorReporter.report(node.loc,
-			                     "Type mismatch in binary operation. Left type: " +
-			                     typeToString(leftType.type) + ", right type: " +
-			                     typeToString(rightType.type));
+		else {
+			if (!areTypesCompatible(leftType.type, rightType.type)) {
+				errorReporter.report(node.loc,
+				                     "Type mismatch in binary operation. Left type: " +
+				                     typeToString(leftType.type) + ", right type: " +
+				                     typeToString(rightType.type));
+			}
+			exprVR = ExpressionInfo(leftType.type.copy_or_share(), false, false);
 		}
 
-		exprVR = ExpressionInfo(leftType.type.copy_or_share(), false, false);
+		if (node.left->constantValue && node.right->constantValue) {
+			node.constantValue = constantEvaluator.binary(node, *node.left->constantValue, *node.right->constantValue);
+		}
+	}
+	std::optional<uint64_t> SemanticAnalyzer::evaluateArraySize(polymorphic_ref<ExprNode> sizeExpr) {
+		visitExpression(sizeExpr);
+		const auto &value = sizeExpr->constantValue;
+		if (!value || !value->isInteger()) {
+			errorReporter.error(sizeExpr->loc, "Array size must be a constant integer expression");
+			return std::nullopt;
+		}
+		if (value->asInteger() < 0) {
+			errorReporter.error(sizeExpr->loc, "Array size cannot be negative (" + value->toString() + ")");
+			return std::nullopt;
+		}
+		return static_cast<uint64_t>(value->asInteger());
 	}
 	polymorphic_variant<TypeNode> SemanticAnalyzer::resolveType(const polymorphic_ref<TypeNode> typeNode) {
 		if (!typeNode) {
 			errorReporter.error(SourceLocation{}, "Attempting to resolve null type");
-			return make_polymorphic<PrimitiveTypeNode>(
+			return make_node<PrimitiveTypeNode>(
 				SourceLocation{}, PrimitiveTypeNode::Type::NIL);
 		}
 
@@ -635,19 +813,24 @@ namespace zenith {
 				}
 
 				auto sym = symbolTable.lookup(named->name);
-				if (!sym || (sym->kind != SymbolInfo::TYPE_ALIAS && sym->kind != SymbolInfo::OBJECT)) {
-					errorReporter.error(sym->declarationNode->loc,
+				if (!sym || (sym->kind != SymbolInfo::TYPE_ALIAS && sym->kind != SymbolInfo::OBJECT && sym->kind != SymbolInfo::ACTOR)) {
+					errorReporter.error(named->loc,
 					               "Unknown or non-type identifier used as type: '" + named->name + "'");
-					return make_polymorphic<PrimitiveTypeNode>(
+					return make_node<PrimitiveTypeNode>(
 						named->loc, PrimitiveTypeNode::Type::NIL);
 				}
 
 				if (!sym->type) {
 					errorReporter.internalError(named->loc, "Type symbol '" + named->name + "' has no associated type");
-					return make_polymorphic<PrimitiveTypeNode>(
+					return make_node<PrimitiveTypeNode>(
 						named->loc, PrimitiveTypeNode::Type::NIL);
 				}
 
+				// Classes and actors name themselves, only aliases have an underlying type to resolve
+				if (sym->kind != SymbolInfo::TYPE_ALIAS) {
+					return typeNode;
+				}
+
 				// Recursively resolve the underlying type
 				return resolveType(sym->type);
 			}
@@ -658,11 +841,16 @@ namespace zenith {
 
 				auto resolvedElem = resolveType(arr->elementType.get_ref());
 
-				return make_polymorphic<ArrayTypeNode>(
+				auto resolved = make_node<ArrayTypeNode>(
 					arr->loc,
 					std::move(resolvedElem),
 					arr->sizeExpr ? arr->sizeExpr.copy_or_share() : nullptr
 				);
+				// Evaluated again by every analysis, the declared node is reused across edits and the constants in
+				// its size expression may have changed
+				if (arr->sizeExpr) resolved->size = evaluateArraySize(arr->sizeExpr.get_ref());
+				else resolved->size = arr->size;
+				return resolved;
 			}
 
 			case TypeNode::Kind::FUNCTION: {
@@ -680,7 +868,7 @@ namespace zenith {
 					                   ? resolveType(fn->returnType)
 					                   : nullptr;
 
-				return make_polymorphic<FunctionTypeNode>(
+				return make_node<FunctionTypeNode>(
 					fn->loc,
 					std::move(resolvedParams),
 					std::move(resolvedRet)
@@ -698,7 +886,7 @@ namespace zenith {
 					resolvedArgs.push_back(resolveType(arg));
 				}
 
-				return make_polymorphic<TemplateTypeNode>(
+				return make_node<TemplateTypeNode>(
 					tmpl->loc,
 					tmpl->baseName,
 					std::move(resolvedArgs)
@@ -708,7 +896,7 @@ namespace zenith {
 			invalid:
 			default:
 				errorReporter.internalError(typeNode->loc, "Invalid or corrupted TypeNode during resolution");
-				return make_polymorphic<PrimitiveTypeNode>(
+				return make_node<PrimitiveTypeNode>(
 					typeNode->loc, PrimitiveTypeNode::Type::NIL);
 		}
 	}
@@ -773,6 +961,10 @@ namespace zenith {
             errorReporter.internalError(node.loc, "Unhandled unary operator");
             exprVR = { CREATE_ERROR_TYPE(node.loc), false, false };
     }
+
+    if (node.right->constantValue) {
+        node.constantValue = constantEvaluator.unary(node, *node.right->constantValue);
+    }
 }
 	void SemanticAnalyzer::visit(CallNode& node) {
 		auto calleeType = visitExpression(node.callee);
@@ -817,6 +1009,12 @@ namespace zenith {
 	void SemanticAnalyzer::visit(ExprStmtNode& node) {
 		exprVR = visitExpression(node.expr);
 	}
+	void SemanticAnalyzer::visit(FreeObjectNode& node) {
+		for (auto &[name, value]: node.properties) {
+			visitExpression(value);
+		}
+		exprVR = ExpressionInfo(make_node<TypeNode>(node.loc, TypeNode::Kind::DYNAMIC), false, false);
+	}
 	void SemanticAnalyzer::visit(MemberAccessNode& node) {
 		auto object = visitExpression(node.object);
 
@@ -824,6 +1022,11 @@ namespace zenith {
 			exprVR = ExpressionInfo(object.type.copy_or_share(), false, false);
 			return;
 		}
+		if (object.type->isDynamic()) {
+			// Properties of dynamic values are looked up at runtime
+			exprVR = ExpressionInfo(make_node<TypeNode>(node.loc, TypeNode::Kind::DYNAMIC), true, false);
+			return;
+		}
 		if (object.type->kind != TypeNode::Kind::OBJECT) {
 			errorReporter.error(
 				node.loc,
@@ -868,6 +1071,10 @@ namespace zenith {
 			return;
 		}
 		exprVR = ExpressionInfo((*it)->getType());
+		if (references) {
+			const SymbolInfo::Kind kind = dynamic_cast<const FunctionDeclNode*>(it->get()) ? SymbolInfo::FUNCTION : SymbolInfo::VARIABLE;
+			references->push_back({node, *it, kind, typeToString(exprVR.type)});
+		}
 	}
 	void SemanticAnalyzer::visit(WhileNode& node) {
 		const bool areCompatible = areTypesCompatible(visitExpression(node.condition).type, constants::BOOL_TYPE);
@@ -902,6 +1109,11 @@ namespace zenith {
     	    exprVR = { CREATE_ERROR_TYPE(node.loc), false, false };
     	    return;
     	}
+    	if (aType->isDynamic()) {
+    	    // Computed property of a dynamic value
+    	    exprVR = { make_node<TypeNode>(node.loc, TypeNode::Kind::DYNAMIC), true, false };
+    	    return;
+    	}
     	if (aType->kind != TypeNode::Kind::ARRAY) {
     	    errorReporter.error(node.array->loc,
     	        "Cannot index into a non-array type '" + typeToString(aType) + "'");
@@ -2,9 +2,28 @@
 #include "../exceptions/ErrorReporter.hpp"
 #include <string>
 #include "SymbolTable.hpp"
+#include "ClassHierarchy.hpp"
+#include "ConstantEvaluator.hpp"
+#include "../utils/ThreadPool.hpp"
 
 namespace zenith {
 	class SemanticAnalyzer : public Visitor {
+	public:
+		// A function/method body that can be checked independently once the global scope is frozen
+		struct BodyTask {
+			polymorphic_ref<FunctionDeclNode> function;
+			polymorphic_ref<ObjectDeclNode> owner;
+		};
+
+		// A name in a body and the declaration it resolved to, recorded by checkBody()
+		struct Reference {
+			polymorphic_ref<ASTNode> use; // VarNode, MemberAccessNode for its member, or a local VarDeclNode itself
+			polymorphic_ref<ASTNode> declaration;
+			SymbolInfo::Kind kind;
+			std::string type; // As typeToString() spells it
+		};
+
+	private:
 		struct ExpressionInfo {
 			polymorphic_variant<TypeNode> type;
 			bool isLvalue;
@@ -13,21 +32,46 @@ namespace zenith {
 		};
 		ErrorReporter& errorReporter;
 		SymbolTable symbolTable;
+		ClassHierarchy ownClassHierarchy;
+		ClassHierarchy& classHierarchy = ownClassHierarchy; // Shared with the global analyzer in body workers
+		ThreadPool* pool = nullptr;
+		ConstantEvaluator constantEvaluator;
 
 		// Context information
 		polymorphic_ref<FunctionDeclNode> currentFunction;
 		polymorphic_ref<ObjectDeclNode> currentClass;
 		bool inLoop = false;
+		// Functions seen by collectDeclaration(), declared once every class is known
+		std::vector<polymorphic_ref<FunctionDeclNode>> collectedFunctions;
+		bool collecting = false; // The declarations came through collect(), analyze() only finishes phase 1
+		// Set while phase 1 walks the program, function bodies are queued here instead of being checked
+		std::vector<BodyTask>* deferredBodies = nullptr;
+
+		std::vector<Reference>* references = nullptr;
 
 		// Expression result type
 		ExpressionInfo exprVR;
 
+		// Body worker, checks against the frozen global scope of 'global'
+		SemanticAnalyzer(ErrorReporter& errorReporter, SemanticAnalyzer& global);
+
+		// Two-phase analysis
+		void collectDeclarations(ProgramNode& program);
+		void collectDeclaration(polymorphic_ref<ASTNode> decl);
+		void declareCollected();
+		void declareFunction(FunctionDeclNode& node);
+		void declareObject(ObjectDeclNode& node);
+		void checkFunctionBody(FunctionDeclNode& node);
+		void checkBodies(const std::vector<BodyTask>& tasks);
+		std::vector<BodyTask> declareGlobals(ProgramNode& program); // Phase 1 after collection, freezes the scope
+
 		// Type system helpers
+		polymorphic_variant<TypeNode> makeFunctionType(FunctionDeclNode& node);
 		bool areTypesCompatible(polymorphic_ref<TypeNode> targetType, polymorphic_ref<TypeNode> valueType);
 
 		polymorphic_variant<TypeNode> resolveType(polymorphic_ref<TypeNode> typeNode);
+		std::optional<uint64_t> evaluateArraySize(polymorphic_ref<ExprNode> sizeExpr);
 
-		[[nodiscard]] static std::string typeToString(polymorphic_ref<TypeNode> type);
 
 		// Visitor methods
 		void visit(ASTNode& node) override;
@@ -37,14 +81,20 @@ namespace zenith {
 		void visit(ProgramNode& node) override;
 		void visit(ImportNode& node) override;
 		void visit(BlockNode& node) override;
+		void visit(LazyBlockNode& node) override;
 		void visit(VarDeclNode& node) override;
 		void visit(MultiVarDeclNode& node) override;
 		void visit(FunctionDeclNode& node) override;
 		void visit(LambdaExprNode& node) override;
 		void visit(ReturnStmtNode& node) override;
 		void visit(ObjectDeclNode& node) override;
+		void visit(ActorDeclNode& node) override;
+		void visit(TemplateDeclNode& node) override;
+		void visit(FieldDeclNode& node) override;
+		void visit(MethodDeclNode& node) override;
+		void visit(CtorDeclNode& node) override;
+		void visit(MessageHandlerNode& node) override;
 		// void visit(UnionDeclNode& node) override;
-		// void visit(ActorDeclNode& node) override;
 		// Stmt
 		void visit(IfNode& node) override;
 		void visit(WhileNode& node) override;
@@ -52,10 +102,11 @@ namespace zenith {
 		void visit(ForNode& node) override;
 		void visit(ExprStmtNode& node) override;
 		void visit(EmptyStmtNode& node) override {}
+		void visit(ErrorNode&) override {} // The parser already reported it
 		// void visit(AnnotationNode& node) override;
 		// void visit(TemplateDeclNode& node) override;
 		// void visit(OperatorOverloadNode& node) override;
-		// void visit(MemberDeclNode& node) override;
+		// void visit(DeclNode& node) override;
 
 		// Expression visitors
 		void visit(LiteralNode& node) override;               // polymorphic<TypeNode> -> exprVR
@@ -67,15 +118,32 @@ namespace zenith {
 		void visit(ArrayAccessNode& node) override;           // polymorphic<TypeNode> -> exprVR
 		// void visit(NewExprNode& node) override;               // polymorphic<TypeNode> -> exprVR
 		// void visit(ThisNode& node) override;                  // polymorphic<TypeNode> -> exprVR
-		// void visit(FreeObjectNode& node) override;            // polymorphic<TypeNode> -> exprVR
+		void visit(FreeObjectNode& node) override;            // polymorphic<TypeNode> -> exprVR
 		// void visit(TemplateStringNode& node) override;        // polymorphic<TypeNode> -> exprVR
 		// void visit(StructInitializerNode& node) override;     // polymorphic<TypeNode> -> exprVR
 
 	public:
-		explicit SemanticAnalyzer(ErrorReporter& errorReporter)
-				: errorReporter(errorReporter), symbolTable(errorReporter) {}
+		// With a pool, function and method bodies are checked in parallel after declaration collection
+		explicit SemanticAnalyzer(ErrorReporter& errorReporter, ThreadPool* pool = nullptr)
+				: errorReporter(errorReporter), symbolTable(errorReporter), ownClassHierarchy(errorReporter), pool(pool),
+				  constantEvaluator(errorReporter) {}
 
 		SymbolTable&& analyze(polymorphic_ref<ProgramNode> program);
+		// Pipelined phase 1: takes the top-level declarations one at a time while the parser is still going, classes are
+		// declared right away. analyze() then needs a program of exactly these declarations in the same order.
+		void collect(polymorphic_ref<ASTNode> declaration);
+
+		// Phase 1 on its own, for callers that check the bodies themselves, e.g. only the ones an edit changed.
+		// Declares every global and freezes the global scope, the bodies are returned unchecked.
+		std::vector<BodyTask> declare(polymorphic_ref<ProgramNode> program);
+		// Checks a body returned by declare(), safe to call from several threads at once.
+		// With references, every name the body resolves is added to them.
+		void checkBody(const BodyTask& body, ErrorReporter& reporter, std::vector<Reference>* references = nullptr);
+		[[nodiscard]] SymbolTable& globals() { return symbolTable; }
+		// The bodies declare() returns for one top-level declaration, found without declaring anything
+		[[nodiscard]] static std::vector<BodyTask> bodies(polymorphic_ref<ASTNode> declaration);
+
+		[[nodiscard]] static std::string typeToString(polymorphic_ref<TypeNode> type);
 	};
 
 } // namespace zenith
\ No newline at end of file
@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <tuple>
+#include "ShapeInference.hpp"
+#include "SemanticAnalyzer.hpp"
+
+namespace zenith {
+	namespace {
+		std::string changesToString(const uint8_t changes) {
+			static const char* names[] = {"add", "retype", "conditional", "computed key", "aliased"};
+			std::string out;
+			for (int bit = 0; bit < 5; ++bit) {
+				if (!(changes & (1 << bit))) continue;
+				if (!out.empty()) out += ", ";
+				out += names[bit];
+			}
+			return out;
+		}
+
+		std::string declaredType(const polymorphic_ref<TypeNode> type) {
+			return type ? SemanticAnalyzer::typeToString(type) : "dynamic";
+		}
+	}
+
+	// --- ShapeTree ---
+
+	uint32_t ShapeTree::addProperty(const uint32_t shape, const std::string& property, const std::string& type) {
+		std::string key = std::to_string(shape);
+		key += '\0';
+		key += property;
+		key += '\0';
+		key += type;
+		if (const auto it = transitions.find(key); it != transitions.end()) return it->second;
+
+		const uint32_t slot = shape == EMPTY ? 0 : shapes[shape].slot + 1;
+		shapes.push_back({shape, property, type, slot});
+		const auto child = static_cast<uint32_t>(shapes.size() - 1);
+		transitions.emplace(std::move(key), child);
+		return child;
+	}
+
+	uint32_t ShapeTree::retype(const uint32_t shape, const std::string& property, const std::string& type) {
+		uint32_t rebuilt = EMPTY;
+		for (const Shape* entry: properties(shape)) {
+			rebuilt = addProperty(rebuilt, entry->property, entry->property == property ? type : entry->type);
+		}
+		return rebuilt;
+	}
+
+	std::optional<uint32_t> ShapeTree::slotOf(uint32_t shape, const std::string& property) const {
+		for (; shape != EMPTY; shape = shapes[shape].parent) {
+			if (shapes[shape].property == property) return shapes[shape].slot;
+		}
+		return std::nullopt;
+	}
+
+	std::optional<std::string> ShapeTree::typeOf(uint32_t shape, const std::string& property) const {
+		for (; shape != EMPTY; shape = shapes[shape].parent) {
+			if (shapes[shape].property == property) return shapes[shape].type;
+		}
+		return std::nullopt;
+	}
+
+	std::vector<const ShapeTree::Shape*> ShapeTree::properties(uint32_t shape) const {
+		std::vector<const Shape*> out;
+		for (; shape != EMPTY; shape = shapes[shape].parent) out.push_back(&shapes[shape]);
+		std::ranges::reverse(out);
+		return out;
+	}
+
+	std::string ShapeTree::toString(const uint32_t shape) const {
+		std::string out = "{";
+		for (const Shape* entry: properties(shape)) {
+			if (out.size() > 1) out += ", ";
+			out += entry->property + ": " + entry->type;
+		}
+		return out + "}";
+	}
+
+	// --- ShapeInference ---
+
+	void ShapeInference::analyze(ProgramNode& program) {
+		literals.clear();
+
+		for (auto &body: bodies(program)) analyzeFunction(*body.function, std::move(body.name));
+
+		// Globals can be changed by any function, only their initial shape is known
+		reset("<global>");
+		for (VarDeclNode* var: globals(program)) {
+			if (var->initializer) release(evaluate(*var->initializer));
+		}
+		finish();
+
+		std::ranges::sort(literals, [](const Literal& a, const Literal& b) {
+			return std::tie(a.node->loc.file, a.node->loc.line, a.node->loc.column) <
+			       std::tie(b.node->loc.file, b.node->loc.line, b.node->loc.column);
+		});
+	}
+
+	void ShapeInference::report(std::ostream& out) const {
+		const auto fixed = std::ranges::count_if(literals, [](const Literal& l) { return l.node->shape.fixedLayout(); });
+		out << "Shape inference: " << literals.size() << " freeobj literal(s), " << fixed << " with a fixed layout, "
+			<< tree.size() - 1 << " shape(s)\n";
+		for (const auto &[node, function]: literals) {
+			const ShapeInfo& shape = node->shape;
+			out << "  " << node->loc.file << ":" << node->loc.line << ":" << node->loc.column << ": in '" << function
+				<< "': " << tree.toString(shape.initial);
+			if (shape.fixedLayout()) out << " fixed";
+			else {
+				if (shape.final != shape.initial) {
+					out << " -> " << (shape.final == ShapeInfo::UNKNOWN ? "?" : tree.toString(shape.final));
+				}
+				out << " (" << changesToString(shape.changes) << ")";
+			}
+			out << "\n";
+		}
+	}
+
+	void ShapeInference::reset(std::string name) {
+		objects.clear();
+		resetScopes();
+		regions.assign(1, 0);
+		nextRegion = 0;
+		functionName = std::move(name);
+	}
+
+	void ShapeInference::finish() {
+		for (const auto &object: objects) {
+			object.node->shape.final = object.lost ? ShapeInfo::UNKNOWN : object.shape;
+			literals.push_back({object.node, functionName});
+		}
+	}
+
+	void ShapeInference::analyzeFunction(FunctionDeclNode& function, std::string name) {
+		reset(std::move(name));
+		for (auto &param: function.params) {
+			scopes.back()[param.name] = Binding{declaredType(param.type), -1, region()};
+		}
+		if (function.body) function.body->accept(*this);
+		finish();
+	}
+
+	void ShapeInference::change(const int32_t object, const ShapeInfo::Change change) {
+		if (object < 0) return;
+		auto& tracked = objects[object];
+		tracked.node->shape.changes |= change;
+		if (change != ShapeInfo::ADD && change != ShapeInfo::RETYPE) tracked.lost = true;
+	}
+
+	ShapeInference::Binding* ShapeInference::lookup(const std::string& name) {
+		bool captured = false;
+		Binding* binding = find(name, captured);
+		// Captured by a lambda, which may run at any point after this
+		if (binding && captured) {
+			change(binding->object, ShapeInfo::ALIASED);
+			return nullptr;
+		}
+		return binding;
+	}
+
+	ShapeInference::Value ShapeInference::evaluate(ExprNode& expr) {
+		result = Value{};
+		expr.accept(*this);
+		Value value = std::move(result);
+		if (expr.constantValue) value.type = ConstantValue::kindName(expr.constantValue->kind);
+		return value;
+	}
+
+	void ShapeInference::setProperty(const int32_t object, const std::string& property, const std::string& type) {
+		auto& tracked = objects[object];
+		const auto existing = tree.typeOf(tracked.shape, property);
+		if (existing && (*existing == type || *existing == "dynamic")) return; // Not a shape change
+
+		if (tracked.lost) {
+			change(object, existing ? ShapeInfo::RETYPE : ShapeInfo::ADD);
+		}
+		else if (tracked.region != region()) {
+			// May or may not run, the object has one of two shapes afterwards
+			change(object, ShapeInfo::CONDITIONAL);
+		}
+		else if (existing) {
+			tracked.shape = tree.retype(tracked.shape, property, "dynamic");
+			change(object, ShapeInfo::RETYPE);
+		}
+		else {
+			tracked.shape = tree.addProperty(tracked.shape, property, type);
+			change(object, ShapeInfo::ADD);
+		}
+	}
+
+	void ShapeInference::assign(ExprNode& target, ExprNode& value) {
+		Value assigned = evaluate(value);
+
+		if (auto var = dynamic_cast<VarNode*>(&target)) {
+			Binding* binding = lookup(var->name);
+			if (!binding) release(assigned); // Global or captured
+			else if (binding->region != region()) {
+				// After the branch or loop the variable may still hold the old object, follow neither
+				change(binding->object, ShapeInfo::ALIASED);
+				release(assigned);
+				binding->object = -1;
+				binding->type = assigned.type;
+			}
+			else {
+				binding->object = assigned.object;
+				binding->type = assigned.type;
+			}
+		}
+		else if (auto member = dynamic_cast<MemberAccessNode*>(&target)) {
+			const Value base = evaluate(*member->object);
+			release(assigned);
+			if (base.object >= 0) setProperty(base.object, member->member, assigned.type);
+		}
+		else if (auto element = dynamic_cast<ArrayAccessNode*>(&target)) {
+			const Value base = evaluate(*element->array);
+			evaluate(*element->index);
+			release(assigned);
+			change(base.object, ShapeInfo::COMPUTED);
+		}
+		else {
+			evaluate(target);
+			release(assigned);
+		}
+		result = std::move(assigned);
+	}
+
+	// --- Statements ---
+
+	void ShapeInference::visit(VarDeclNode& node) {
+		Value value;
+		if (node.initializer) value = evaluate(*node.initializer);
+		std::string type = declaredType(node.type);
+		if (type == "dynamic") type = std::move(value.type);
+		scopes.back()[node.name] = Binding{std::move(type), value.object, region()};
+	}
+
+	void ShapeInference::visit(ExprStmtNode& node) {
+		evaluate(*node.expr);
+	}
+
+	void ShapeInference::visit(ReturnStmtNode& node) {
+		if (node.value) release(evaluate(*node.value));
+	}
+
+	void ShapeInference::visit(IfNode& node) {
+		evaluate(*node.condition);
+		enterRegion();
+		if (node.thenBranch) node.thenBranch->accept(*this);
+		exitRegion();
+		enterRegion();
+		if (node.elseBranch) node.elseBranch->accept(*this);
+		exitRegion();
+	}
+
+	void ShapeInference::visit(WhileNode& node) {
+		enterRegion();
+		evaluate(*node.condition);
+		if (node.body) node.body->accept(*this);
+		exitRegion();
+	}
+
+	void ShapeInference::visit(DoWhileNode& node) {
+		enterRegion();
+		if (node.body) node.body->accept(*this);
+		evaluate(*node.condition);
+		exitRegion();
+	}
+
+	void ShapeInference::visit(ForNode& node) {
+		scopes.emplace_back();
+		if (node.initializer) node.initializer->accept(*this);
+		enterRegion();
+		if (node.condition) evaluate(*node.condition);
+		if (node.body) node.body->accept(*this);
+		if (node.increment) evaluate(*node.increment);
+		exitRegion();
+		scopes.pop_back();
+	}
+
+	// --- Expressions ---
+
+	void ShapeInference::visit(LiteralNode& node) {
+		switch (node.type) {
+			case LiteralNode::NUMBER: result.type = "number"; break;
+			case LiteralNode::STRING: result.type = "string"; break;
+			case LiteralNode::BOOL: result.type = "bool"; break;
+			case LiteralNode::NIL: result.type = "nil"; break;
+		}
+	}
+
+	void ShapeInference::visit(VarNode& node) {
+		if (const Binding* binding = lookup(node.name)) result = Value{binding->type, binding->object};
+	}
+
+	void ShapeInference::visit(BinaryOpNode& node) {
+		if (node.op == BinaryOpNode::ASN) {
+			assign(*node.left, *node.right);
+			return;
+		}
+		// Reading and comparing an object does not change its shape
+		const Value left = evaluate(*node.left);
+		const Value right = evaluate(*node.right);
+		if (node.op >= BinaryOpNode::EQ && node.op <= BinaryOpNode::GTE) result.type = "bool";
+		else if (left.type == right.type) result.type = left.type;
+		else if (node.op == BinaryOpNode::ADD && (left.type == "string" || right.type == "string")) result.type = "string";
+	}
+
+	void ShapeInference::visit(UnaryOpNode& node) {
+		const Value operand = evaluate(*node.right);
+		result.type = node.op == UnaryOpNode::Op::NOT ? "bool" : operand.type;
+	}
+
+	void ShapeInference::visit(CallNode& node) {
+		// The callee can do anything to its receiver and arguments
+		if (auto member = dynamic_cast<MemberAccessNode*>(node.callee.get())) release(evaluate(*member->object));
+		else release(evaluate(*node.callee));
+		for (auto &arg: node.arguments) release(evaluate(*arg));
+		result = Value{};
+	}
+
+	void ShapeInference::visit(MemberAccessNode& node) {
+		const Value base = evaluate(*node.object);
+		result = Value{};
+		if (base.object >= 0 && !objects[base.object].lost) {
+			if (auto type = tree.typeOf(objects[base.object].shape, node.member)) result.type = std::move(*type);
+		}
+	}
+
+	void ShapeInference::visit(ArrayAccessNode& node) {
+		evaluate(*node.array);
+		evaluate(*node.index);
+		result = Value{};
+	}
+
+	void ShapeInference::visit(FreeObjectNode& node) {
+		uint32_t shape = ShapeTree::EMPTY;
+		for (auto &[name, value]: node.properties) {
+			Value property = evaluate(*value);
+			release(property); // Nested objects are only tracked as long as they stay in a variable
+			if (auto existing = tree.typeOf(shape, name)) {
+				// Repeated key, the last one wins
+				if (*existing != property.type) shape = tree.retype(shape, name, "dynamic");
+			}
+			else shape = tree.addProperty(shape, name, property.type);
+		}
+		node.shape = ShapeInfo{};
+		node.shape.initial = shape;
+		objects.push_back({&node, shape, region()});
+		result = Value{tree.toString(shape), static_cast<int32_t>(objects.size() - 1)};
+	}
+
+	void ShapeInference::visit(NewExprNode& node) {
+		for (auto &arg: node.args) release(evaluate(*arg));
+		result = Value{node.className, -1};
+	}
+
+	void ShapeInference::visit(StructInitializerNode& node) {
+		for (auto &field: node.fields) release(evaluate(*field.value));
+		result = Value{};
+	}
+
+	void ShapeInference::visit(TemplateStringNode& node) {
+		for (auto &part: node.parts) evaluate(*part);
+		result = Value{"string", -1};
+	}
+
+	void ShapeInference::visit(LambdaExprNode& node) {
+		enterRegion();
+		walkLambda(node, [this](const FunctionDeclNode::Param& param) {
+			return Binding{declaredType(param.type), -1, region()};
+		});
+		exitRegion();
+		result = Value{};
+	}
+}
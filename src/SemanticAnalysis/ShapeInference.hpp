@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BodyPass.hpp"
+
+namespace zenith {
+	// Hidden classes for freeobj values
+	// A shape is the ordered list of (property, type) pairs an object has. Shapes form a transition tree rooted
+	// at the empty shape: adding a property to a shape always leads to the same child, so two objects that got
+	// the same properties in the same order share one shape id program-wide. A property's slot is its index in
+	// that order, which is what a backend uses instead of a dictionary lookup.
+	class ShapeTree {
+	public:
+		static constexpr uint32_t EMPTY = 0;
+
+		struct Shape {
+			uint32_t parent;
+			std::string property; // Last property added, empty for the root
+			std::string type;
+			uint32_t slot;        // == number of properties - 1
+		};
+
+	private:
+		std::vector<Shape> shapes{{EMPTY, "", "", UINT32_MAX}};
+		std::unordered_map<std::string, uint32_t> transitions; // "<parent>:<property>:<type>" -> child
+
+	public:
+		uint32_t addProperty(uint32_t shape, const std::string& property, const std::string& type);
+		// Same properties in the same order, with the type of 'property' replaced
+		uint32_t retype(uint32_t shape, const std::string& property, const std::string& type);
+
+		[[nodiscard]] std::optional<uint32_t> slotOf(uint32_t shape, const std::string& property) const;
+		[[nodiscard]] std::optional<std::string> typeOf(uint32_t shape, const std::string& property) const;
+		[[nodiscard]] std::vector<const Shape*> properties(uint32_t shape) const; // In slot order
+		[[nodiscard]] const Shape& operator[](const uint32_t shape) const { return shapes[shape]; }
+		[[nodiscard]] size_t size() const { return shapes.size(); }
+		[[nodiscard]] std::string toString(uint32_t shape) const;
+	};
+
+	// Computes the shape of every freeobj literal and follows property additions through straight-line code
+	// Runs per function body. An object is tracked through local variables that alias it; as soon as it is
+	// changed inside a branch or loop it was not created in, written through a computed key, or handed to code
+	// we do not follow (calls, returns, stores, captures, globals), its final shape is given up on.
+	// Literals that are never changed and never leave our sight get ShapeInfo::fixedLayout().
+	// What ShapeInference knows about a local variable
+	struct ShapeBinding {
+		std::string type;
+		int32_t object = -1; // Index into the function's tracked objects, -1 if not a tracked freeobj
+		uint32_t region;
+	};
+
+	class ShapeInference : public BodyPass<ShapeBinding> {
+	public:
+		struct Literal {
+			FreeObjectNode* node;
+			std::string function;
+		};
+
+	private:
+		struct Object {
+			FreeObjectNode* node;
+			uint32_t shape;
+			uint32_t region;
+			bool lost = false;
+		};
+		using Binding = ShapeBinding;
+		struct Value {
+			std::string type = "dynamic";
+			int32_t object = -1;
+		};
+
+		ShapeTree tree;
+		std::vector<Literal> literals;
+
+		// Current function
+		std::vector<Object> objects;
+		std::vector<uint32_t> regions;     // Stack of control flow regions, each branch and loop body is one
+		uint32_t nextRegion = 0;
+		std::string functionName;
+		Value result;
+
+		void reset(std::string name);
+		void finish();
+		uint32_t region() const { return regions.back(); }
+		void enterRegion() { regions.push_back(++nextRegion); }
+		void exitRegion() { regions.pop_back(); }
+		void change(int32_t object, ShapeInfo::Change change);
+		void release(const Value& value) { change(value.object, ShapeInfo::ALIASED); }
+		Binding* lookup(const std::string& name);
+		Value evaluate(ExprNode& expr);
+		void assign(ExprNode& target, ExprNode& value);
+		void setProperty(int32_t object, const std::string& property, const std::string& type);
+		void analyzeFunction(FunctionDeclNode& function, std::string name);
+
+	public:
+		void analyze(ProgramNode& program);
+		[[nodiscard]] const ShapeTree& shapes() const { return tree; }
+		[[nodiscard]] const std::vector<Literal>& results() const { return literals; }
+		void report(std::ostream& out) const;
+
+		using BodyPass::visit;
+
+		// Statements
+		void visit(VarDeclNode& node) override;
+		void visit(ExprStmtNode& node) override;
+		void visit(ReturnStmtNode& node) override;
+		void visit(IfNode& node) override;
+		void visit(WhileNode& node) override;
+		void visit(DoWhileNode& node) override;
+		void visit(ForNode& node) override;
+		// Expressions
+		void visit(LiteralNode& node) override;
+		void visit(VarNode& node) override;
+		void visit(BinaryOpNode& node) override;
+		void visit(UnaryOpNode& node) override;
+		void visit(CallNode& node) override;
+		void visit(MemberAccessNode& node) override;
+		void visit(ArrayAccessNode& node) override;
+		void visit(FreeObjectNode& node) override;
+		void visit(NewExprNode& node) override;
+		void visit(StructInitializerNode& node) override;
+		void visit(TemplateStringNode& node) override;
+		void visit(LambdaExprNode& node) override;
+	};
+}
@@ -20,11 +20,23 @@ namespace zenith{
 		enterScope();
 	}
 
+	SymbolTable::SymbolTable(ErrorReporter& reporter, SymbolTable& parent) : errorReporter(reporter), parent(&parent) {
+		enterScope();
+	}
+
 	void SymbolTable::enterScope() {
+		if (frozen) {
+			errorReporter.internalError(SourceLocation(), "Entering scope of a frozen symbol table.");
+			return;
+		}
 		scopeStack.emplace_back();
 	}
 
 	void SymbolTable::exitScope() {
+		if (frozen) {
+			errorReporter.internalError(SourceLocation(), "Exiting scope of a frozen symbol table.");
+			return;
+		}
 		if (!scopeStack.empty()) {
 			scopeStack.pop_back();
 		} else {
@@ -33,6 +45,10 @@ namespace zenith{
 	}
 
 	void SymbolTable::declare(const std::string &name, SymbolInfo info) {
+		if (frozen) {
+			errorReporter.internalError(info.declarationNode ? info.declarationNode->loc : SourceLocation(), "Declaration of '" + name + "' in a frozen symbol table");
+			return;
+		}
 		if (scopeStack.empty()) {
 			errorReporter.internalError(info.declarationNode ? info.declarationNode->loc : SourceLocation(), "No current scope for declaration");
 			return;
@@ -57,7 +73,7 @@ namespace zenith{
 				return make_polymorphic_ref(found->second);
 			}
 		}
-		return nullptr;
+		return parent ? parent->lookup(name) : nullptr;
 	}
 
 	const SymbolInfo* SymbolTable::lookupCurrentScope(const std::string& name) {
@@ -78,7 +94,13 @@ namespace zenith{
 					return make_polymorphic_ref(found->second);
 			}
 		}
-		return nullptr;
+		return parent ? parent->lookup(name, kind) : nullptr;
+	}
+
+	size_t SymbolTable::symbolCount() const {
+		size_t count = 0;
+		for (const Scope& scope: scopeStack) count += scope.size();
+		return count;
 	}
 
 	std::string SymbolTable::toString(int indent) const {
@@ -113,6 +135,9 @@ namespace zenith{
 
 				ss << pad << "    Const: "  << (symbolInfo.isConst  ? "true" : "false") << "\n";
 				ss << pad << "    Static: " << (symbolInfo.isStatic ? "true" : "false") << "\n";
+				if (symbolInfo.constantValue) {
+					ss << pad << "    Value: " << symbolInfo.constantValue->toString() << "\n";
+				}
 
 				if (symbolInfo.declarationNode) {
 					ss << pad << "    Declaration: " /*<< symbolInfo.declarationNode->toString(indent + 6)*/ << "\n";
@@ -2,6 +2,7 @@
 #include "../exceptions/ErrorReporter.hpp"
 #include "../ast/AST.hpp"
 #include <core/polymorphic_variant.hpp>
+#include "../utils/MemoryAccounting.hpp"
  namespace zenith{
 	struct SymbolInfo {
 		enum Kind {
@@ -11,6 +12,7 @@
 		polymorphic_ref<ASTNode> declarationNode = nullptr;
 		bool isConst = false;
 		bool isStatic = false;
+		std::optional<ConstantValue> constantValue; // Folded initializer of a const variable
 
 		//SymbolInfo(Kind k, polymorphic_ref<TypeNode> t, polymorphic_ref<ASTNode> node, bool isConst = false, bool isStatic = false);
 		SymbolInfo(Kind k, polymorphic_variant<TypeNode> t, polymorphic_ref<ASTNode> node, bool isConst = false, bool isStatic = false);
@@ -24,7 +26,8 @@
 				  type(std::move(other.type)),
 				  declarationNode(other.declarationNode),
 				  isConst(other.isConst),
-				  isStatic(other.isStatic) {
+				  isStatic(other.isStatic),
+				  constantValue(std::move(other.constantValue)) {
 			other.kind = UNKNOWN;
 			other.declarationNode = nullptr;
 			other.isConst = false;
@@ -37,6 +40,7 @@
 				declarationNode = other.declarationNode;
 				isConst = other.isConst;
 				isStatic = other.isStatic;
+				constantValue = std::move(other.constantValue);
 				other.kind = UNKNOWN;
 				other.declarationNode = nullptr;
 				other.isConst = false;
@@ -48,14 +52,24 @@
 		SymbolInfo& operator=(const SymbolInfo&) = delete;
 	};
 
-	using Scope = std::unordered_map<std::string, SymbolInfo>;
+	using Scope = std::unordered_map<std::string, SymbolInfo, std::hash<std::string>, std::equal_to<std::string>,
+	                                 CountingAllocator<std::pair<const std::string, SymbolInfo>,
+	                                                   MemoryAccounting::Category::SYMBOLS>>;
 
 	class SymbolTable {
 		std::vector<Scope> scopeStack;
 		ErrorReporter& errorReporter;
+		// Read-only enclosing table (the frozen global scope) consulted after all local scopes
+		SymbolTable* parent = nullptr;
+		bool frozen = false;
 
 	public:
 		explicit SymbolTable(ErrorReporter& reporter);
+		SymbolTable(ErrorReporter& reporter, SymbolTable& parent);
+
+		// After freezing, declare/enter/exit are rejected so the table can be shared between threads
+		void freeze() { frozen = true; }
+		[[nodiscard]] bool isFrozen() const { return frozen; }
 
 		void enterScope();
 
@@ -67,6 +81,12 @@
 		polymorphic_ref<SymbolInfo> lookup(const std::string &name, SymbolInfo::Kind kind);
 		const SymbolInfo* lookupCurrentScope(const std::string& name);
 
+		// The outermost scope, the globals once a program was analyzed
+		[[nodiscard]] const Scope& globalScope() const { return scopeStack.front(); }
+
+		// Declared in the open scopes, not counting the parent table
+		[[nodiscard]] size_t symbolCount() const;
+
 		[[nodiscard]] std::string toString(int indent = 0) const;
 	};
 } // namespace zenith
\ No newline at end of file
@@ -10,4 +10,3 @@
 #include "Statements.hpp"
 #include "TypeNodes.hpp"
 #include "../visitor/Visitor.hpp"
-#include "IAnnotatable.hpp"
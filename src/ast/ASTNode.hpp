@@ -1,7 +1,10 @@
 #pragma once
+#include <optional>
 #include <string>
 #include "SourceLocation.hpp"
+#include "ConstantValue.hpp"
 #include "../core/polymorphic.hpp"
+#include "../utils/MemoryAccounting.hpp"
 namespace zenith {
 	class Visitor;
 }
@@ -14,7 +17,17 @@ namespace zenith {
 	};
 
 	struct ExprNode : ASTNode {
+		// Set by semantic analysis when the expression folds to a compile-time constant
+		std::optional<ConstantValue> constantValue;
 		[[nodiscard]] virtual bool isConstructorCall() const { return false; }
 	};
 	struct StmtNode : ASTNode {};
+
+	// Every AST node is allocated here; with --mem-report on it is charged to the AST and to its node kind
+	template<typename Concrete, typename Base = Concrete, typename... Args>
+	polymorphic<Base> make_node(Args&&... args) {
+		if (!MemoryAccounting::enabled()) return make_polymorphic<Concrete, Base>(std::forward<Args>(args)...);
+		return allocate_polymorphic<Concrete, Base>(NodeAllocator<Concrete>(MemoryAccounting::kind<Concrete>()),
+		                                            std::forward<Args>(args)...);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <variant>
+
+namespace zenith {
+	// Result of compile-time evaluation, attached to folded expressions and const symbols
+	struct ConstantValue {
+		enum class Kind : uint8_t { BYTE, SHORT, INT, LONG, FLOAT, DOUBLE, BOOL, STRING } kind;
+		std::variant<int64_t, double, bool, std::string> value;
+
+		[[nodiscard]] bool isInteger() const { return kind <= Kind::LONG; }
+		[[nodiscard]] bool isFloating() const { return kind == Kind::FLOAT || kind == Kind::DOUBLE; }
+		[[nodiscard]] bool isNumeric() const { return kind <= Kind::DOUBLE; }
+
+		[[nodiscard]] int64_t asInteger() const { return std::get<int64_t>(value); }
+		[[nodiscard]] double asFloating() const {
+			return isInteger() ? static_cast<double>(std::get<int64_t>(value)) : std::get<double>(value);
+		}
+		[[nodiscard]] bool asBool() const { return std::get<bool>(value); }
+		[[nodiscard]] const std::string& asString() const { return std::get<std::string>(value); }
+
+		[[nodiscard]] static const char* kindName(const Kind kind) {
+			static const char* kindNames[] = {"byte", "short", "int", "long", "float", "double", "bool", "string"};
+			return kindNames[static_cast<int>(kind)];
+		}
+
+		[[nodiscard]] std::string toString() const {
+			if (isInteger()) return std::to_string(asInteger());
+			if (isFloating()) return std::to_string(asFloating());
+			if (kind == Kind::BOOL) return asBool() ? "true" : "false";
+			return "\"" + asString() + "\"";
+		}
+	};
+}
@@ -9,7 +9,6 @@
 #include "ASTNode.hpp"
 #include "TypeNodes.hpp"
 #include "Statements.hpp"
-#include "IAnnotatable.hpp"
 #include "Other.hpp"
 #include "../core/polymorphic.hpp"
 namespace zenith {
@@ -57,7 +56,70 @@ namespace zenith {
 		ACCEPT_METHODS
 	};
 
-	struct FunctionDeclNode : virtual ASTNode, virtual IAnnotatable {
+	// A named declaration that annotations attach to
+	// Nodes derive from ASTNode along a single chain, so a FunctionDeclNode& to a method is the same address and base
+	// access needs no adjustment. What only some declarations have (member flags) is held, not inherited.
+	struct DeclNode : ASTNode {
+		std::string name;
+		small_vector<polymorphic<AnnotationNode>, 2> annotations;
+
+		void setAnnotations(std::vector<polymorphic<AnnotationNode>> ann) {
+			annotations.clear();
+			annotations.reserve(ann.size());
+			for (auto&& item : ann) {
+				annotations.emplace_back(std::move(item));
+			}
+		}
+		// A field's type, a function's return type
+		[[nodiscard]] virtual polymorphic_ref<TypeNode> getType() const = 0;
+	};
+
+	// Access, kind and modifiers of an object member, held by FieldDeclNode and MethodDeclNode
+	struct Member {
+		enum class Kind : uint8_t { FIELD, METHOD, METHOD_CONSTRUCTOR, MESSAGE_HANDLER };
+		enum class Access : uint8_t { PUBLIC, PROTECTED, PRIVATE, PRIVATEW, PROTECTEDW };
+
+#pragma pack(push, 1)
+		struct Flags {
+			Kind kind: 2;
+			Access access: 3;
+			bool isConst: 1;
+			bool isStatic: 1;
+			uint8_t reserved: 1;
+		};
+#pragma pack(pop)
+
+		[[nodiscard]] static const char* getKindName(Kind kind) {
+			static const char* kindNames[] = {"FIELD", "METHOD", "METHOD_CONSTRUCTOR", "MESSAGE_HANDLER"};
+			return kindNames[static_cast<int>(kind)];
+		}
+
+		[[nodiscard]] static const char* getAccessName(Access access) {
+			static const char* accessNames[] = {"PUBLIC", "PROTECTED", "PRIVATE", "PRIVATEW", "PROTECTEDW"};
+			return accessNames[static_cast<int>(access)];
+		}
+
+		[[nodiscard]] static std::string buildHeader(const DeclNode& node, const Flags flags, int indent) {
+			std::string pad(indent, ' ');
+			std::stringstream ss;
+
+			// Output annotations
+			for (const auto& ann : node.annotations) {
+				ss << pad << ann->toString() << "\n";
+			}
+
+			// Output access, const, static, kind, and name
+			ss << pad << getAccessName(flags.access)
+			   << (flags.isConst ? " CONST" : "")
+			   << (flags.isStatic ? " STATIC " : " ")
+			   << getKindName(flags.kind) << " " << node.name;
+
+			return ss.str();
+		}
+	};
+	static_assert(sizeof(Member::Flags) == 1);
+
+	struct FunctionDeclNode : DeclNode {
 		struct Param {
 			std::string name;
 			polymorphic<TypeNode> type;
@@ -71,7 +133,6 @@ namespace zenith {
 
 		[[nodiscard]] virtual bool isLambda() const { return false; }
 
-		std::string name;
 		std::vector<Param> params;
 		polymorphic<TypeNode> returnType;
 		polymorphic<BlockNode> body;
@@ -87,15 +148,19 @@ namespace zenith {
 			polymorphic<BlockNode> body,
 			bool isAsync = false,
 			bool structSugar = false,
-			std::vector<polymorphic<AnnotationNode> > ann = {}) : ASTNode(),
-			                                                      name(std::move(name)), params(std::move(params)),
+			std::vector<polymorphic<AnnotationNode> > ann = {}) : params(std::move(params)),
 			                                                      returnType(std::move(returnType)),
 			                                                      body(std::move(body)),
 			                                                      isAsync(isAsync), usingStructSugar(structSugar) {
 			this->loc = std::move(loc);
+			this->name = std::move(name);
 			this->annotations = std::move(ann);
 		}
 
+		[[nodiscard]] polymorphic_ref<TypeNode> getType() const override {
+			return returnType;
+		}
+
 		[[nodiscard]] std::string toString(int indent = 0) const override {
 			std::string pad(indent, ' ');
 
@@ -143,102 +208,32 @@ namespace zenith {
 		ACCEPT_METHODS
 	};
 
-	// Base MemberDeclNode
-	struct MemberDeclNode : virtual ASTNode, virtual IAnnotatable {
-		enum class Kind : uint8_t { FIELD, METHOD, METHOD_CONSTRUCTOR, MESSAGE_HANDLER };
-		enum class Access : uint8_t { PUBLIC, PROTECTED, PRIVATE, PRIVATEW, PROTECTEDW };
-
-#pragma pack(push, 1)
-		struct Flags {
-			Kind kind: 2;
-			Access access: 3;
-			bool isConst: 1;
-			bool isStatic: 1;
-			uint8_t reserved: 1;
-		};
-#pragma pack(pop)
-
-		Flags flags;
-		std::string name;
-
-		MemberDeclNode(
-			SourceLocation loc,
-			Kind kind,
-			Access access,
-			bool isConst,
-			std::string &&name,
-			std::vector<polymorphic<AnnotationNode> > ann = {},
-			bool isStatic = false
-		) : ASTNode(),
-		    flags{kind, access, isConst, isStatic, 0},
-		    name(std::move(name)) {
-			this->loc = std::move(loc);
-			this->annotations = std::move(ann);
-		}
-		[[nodiscard]] virtual polymorphic_ref<TypeNode> getType() const = 0;
-		ACCEPT_METHODS
-	protected:
-		[[nodiscard]] static const char* getKindName(Kind kind) {
-			static const char* kindNames[] = {"FIELD", "METHOD", "METHOD_CONSTRUCTOR", "MESSAGE_HANDLER"};
-			return kindNames[static_cast<int>(kind)];
-		}
-
-		[[nodiscard]] static const char* getAccessName(Access access) {
-			static const char* accessNames[] = {"PUBLIC", "PROTECTED", "PRIVATE", "PRIVATEW", "PROTECTEDW"};
-			return accessNames[static_cast<int>(access)];
-		}
-
-		[[nodiscard]] std::string buildMemberHeader(int indent) const {
-			static const char* kindNames[] = {"FIELD", "METHOD", "METHOD_CONSTRUCTOR", "MESSAGE_HANDLER"};
-			static const char* accessNames[] = {"PUBLIC", "PROTECTED", "PRIVATE", "PRIVATEW", "PROTECTEDW"};
-			std::string pad(indent, ' ');
-			std::stringstream ss;
-
-			// Output annotations
-			for (const auto& ann : annotations) {
-				ss << pad << ann->toString() << "\n";
-			}
-
-			// Output access, const, static, kind, and name
-			ss << pad << accessNames[static_cast<int>(flags.access)]
-			   << (flags.isConst ? " CONST" : "")
-			   << (flags.isStatic ? " STATIC " : " ")
-			   << kindNames[static_cast<int>(flags.kind)] << " " << name;
-
-			return ss.str();
-		}
-	};
-
 	// FieldDeclNode
-	struct FieldDeclNode : MemberDeclNode {
+	struct FieldDeclNode : DeclNode {
+		Member::Flags flags;
 		polymorphic<TypeNode> type;
 		polymorphic<ExprNode> initializer;
 
 		FieldDeclNode(
 			SourceLocation loc,
-			Access access,
+			Member::Access access,
 			bool isConst,
 			bool isStatic,
 			std::string &&name,
 			polymorphic<TypeNode> type,
 			polymorphic<ExprNode> initializer = nullptr,
 			std::vector<polymorphic<AnnotationNode> > ann = {}
-		) : MemberDeclNode(
-			    std::move(loc),
-			    Kind::FIELD,
-			    access,
-			    isConst,
-			    std::move(name),
-			    std::move(ann),
-			    isStatic
-		    ),
+		) : flags{Member::Kind::FIELD, access, isConst, isStatic, 0},
 		    type(std::move(type)),
 		    initializer(std::move(initializer)) {
+			this->loc = std::move(loc);
+			this->name = std::move(name);
+			this->annotations = std::move(ann);
 		}
 
 		[[nodiscard]] std::string toString(int indent = 0) const override {
 			std::stringstream ss;
-			ss << buildMemberHeader(indent);
+			ss << Member::buildHeader(*this, flags, indent);
 
 			// Add type
 			if (type) ss << " : " << type->toString();
@@ -256,10 +251,12 @@ namespace zenith {
 	};
 
 	// Base MethodDeclNode
-	struct MethodDeclNode : FunctionDeclNode, MemberDeclNode {
+	struct MethodDeclNode : FunctionDeclNode {
+		Member::Flags flags;
+
 	    MethodDeclNode(
 	        SourceLocation loc,
-	        Access access,
+	        Member::Access access,
 	        bool isConst,
 	        std::string&& name,
 	        std::vector<Param> params,
@@ -269,41 +266,25 @@ namespace zenith {
 	        bool isStatic = false,
 	        bool isAsync = false,
 	        bool structSugar = false
-	    ) : ASTNode(),
-	        IAnnotatable(),
-	        FunctionDeclNode(
-		        loc,
+	    ) : FunctionDeclNode(
+		        std::move(loc),
 		        std::move(name),
 		        std::move(params),
 		        std::move(returnType),
 		        std::move(body),
 		        isAsync,
 		        structSugar,
-		        {}
+		        std::move(ann)
 	        ),
-	        MemberDeclNode(
-		        loc,
-		        Kind::METHOD,
-		        access,
-		        isConst,
-		        std::string(name),
-		        {},
-		        isStatic
-	        )
+	        flags{Member::Kind::METHOD, access, isConst, isStatic, 0}
 	    {
-	        this->loc = std::move(loc);
-	    	this->annotations = std::move(ann);
-	        MemberDeclNode::name = FunctionDeclNode::name;
 	    }
 
 	    [[nodiscard]] std::string toString(int indent = 0) const override {
 	    	std::stringstream ss;
-	    	ss << buildMemberHeader(indent) << FunctionDeclNode::toString(indent);
+	    	ss << Member::buildHeader(*this, flags, indent) << FunctionDeclNode::toString(indent);
 
 	    	return ss.str();
-	    }
-		[[nodiscard]] polymorphic_ref<TypeNode> getType() const override {
-	    	return returnType;
 	    }
 	    ACCEPT_METHODS
 	};
@@ -314,7 +295,7 @@ namespace zenith {
 
 	    CtorDeclNode(
 	        SourceLocation loc,
-	        Access access,
+	        Member::Access access,
 	        bool isConst,
 	        bool isStatic,
 	        std::string&& name,
@@ -336,7 +317,7 @@ namespace zenith {
 				false
 			)
 	    {
-	    	this->flags.kind = Kind::METHOD_CONSTRUCTOR;
+	    	this->flags.kind = Member::Kind::METHOD_CONSTRUCTOR;
 	    	// Add initializers
 	    	for (auto& init : ctor_inits) {
 	    		initializers.emplace_back(init.first, std::move(init.second));
@@ -345,7 +326,7 @@ namespace zenith {
 
 	    [[nodiscard]] std::string toString(int indent = 0) const override {
 	    	std::stringstream ss;
-	    	ss << buildMemberHeader(indent);
+	    	ss << Member::buildHeader(*this, flags, indent);
 
 	    	ss << "(";
 	    	for (size_t i = 0; i < params.size(); ++i) {
@@ -369,9 +350,6 @@ namespace zenith {
 	    		ss << " " << removePadUntilNewLine(body->toString(indent));
 	    	}
 	    	return ss.str();
-	    }
-		[[nodiscard]] polymorphic_ref<TypeNode> getType() const override {
-	    	return returnType;
 	    }
 	    ACCEPT_METHODS
 	};
@@ -381,7 +359,7 @@ namespace zenith {
 		//todo actually add method handlers
 		MessageHandlerNode(
 			SourceLocation loc,
-			Access access,
+			Member::Access access,
 			bool isConst,
 			std::string &&name,
 			std::vector<Param> params,
@@ -404,16 +382,13 @@ namespace zenith {
 			isAsync,
 			structSugar
 		) {
-			this->flags.kind = Kind::MESSAGE_HANDLER;
+			this->flags.kind = Member::Kind::MESSAGE_HANDLER;
 		}
 
 		// Use MethodDeclNode's toString method
 		[[nodiscard]] std::string toString(int indent = 0) const override {
 			return MethodDeclNode::toString(indent);
 		}
-		[[nodiscard]] polymorphic_ref<TypeNode> getType() const override {
-			return returnType;
-		}
 		ACCEPT_METHODS
 	};
 
@@ -426,7 +401,7 @@ namespace zenith {
 			bool usingSS,
 			polymorphic<TypeNode> returnType = nullptr,
 			polymorphic<BlockNode> body = nullptr,
-			bool isAsync = false) : ASTNode(),
+			bool isAsync = false) :
 		FunctionDeclNode(std::move(loc), "", std::move(params), std::move(returnType), std::move(body), isAsync, usingSS, {}) {}
 
 		ACCEPT_METHODS
@@ -478,12 +453,12 @@ namespace zenith {
 
 		std::string name;
 		std::string base;
-		std::vector<polymorphic<MemberDeclNode> > members;
+		std::vector<polymorphic<DeclNode> > members;
 		std::vector<polymorphic<OperatorOverloadNode> > operators;
 		bool autoGettersSetters;
 
 		ObjectDeclNode(SourceLocation loc, Kind kind, std::string name, std::string base,
-		               std::vector<polymorphic<MemberDeclNode> > memb,
+		               std::vector<polymorphic<DeclNode> > memb,
 		               std::vector<polymorphic<OperatorOverloadNode> > ops = {},
 		               bool autoGS = true)
 			: name(std::move(name)), base(std::move(base)),
@@ -548,7 +523,7 @@ namespace zenith {
 		explicit ActorDeclNode(
 			SourceLocation loc,
 			std::string name,
-			std::vector<polymorphic<MemberDeclNode> > members,
+			std::vector<polymorphic<DeclNode> > members,
 			std::string baseActor = ""
 		) : ObjectDeclNode(std::move(loc), ObjectDeclNode::Kind::ACTOR, std::move(name), std::move(baseActor),
 		                   std::move(members)) {
@@ -185,8 +185,28 @@ namespace zenith{
 	};
 
 	// --- Free Objects ---
+	// Filled in by EscapeAnalysis on every allocating expression
+	struct EscapeInfo {
+		enum class Verdict : uint8_t { UNANALYZED, HEAP, STACK, SCALAR_REPLACED } verdict = Verdict::UNANALYZED;
+		enum Cause : uint8_t { NONE = 0, RETURN = 1 << 0, STORE = 1 << 1, CAPTURE = 1 << 2, CALL = 1 << 3, LOOP = 1 << 4 };
+		uint8_t causes = NONE;
+	};
+
+	// Filled in by ShapeInference, shape ids index into its ShapeTree
+	struct ShapeInfo {
+		static constexpr uint32_t UNKNOWN = UINT32_MAX;
+		enum Change : uint8_t { NONE = 0, ADD = 1 << 0, RETYPE = 1 << 1, CONDITIONAL = 1 << 2, COMPUTED = 1 << 3, ALIASED = 1 << 4 };
+		uint32_t initial = UNKNOWN;
+		uint32_t final = UNKNOWN; // UNKNOWN once it was changed somewhere we could not follow
+		uint8_t changes = NONE;
+
+		[[nodiscard]] bool fixedLayout() const { return initial != UNKNOWN && changes == NONE; }
+	};
+
 	struct FreeObjectNode : ExprNode {
 		small_vector<std::pair<std::string, polymorphic<ExprNode>>, 4> properties;
+		EscapeInfo escape;
+		ShapeInfo shape;
 
 		FreeObjectNode(SourceLocation loc,
 		               small_vector<std::pair<std::string, polymorphic<ExprNode>>, 4> props)
@@ -248,6 +268,7 @@ namespace zenith{
 	struct NewExprNode : ExprNode {
 		std::string className;
 		small_vector<polymorphic<ExprNode>, 4> args;
+		EscapeInfo escape;
 
 		NewExprNode(SourceLocation loc, std::string _class,
 		            small_vector<polymorphic<ExprNode>, 4> args)
@@ -361,6 +382,7 @@ namespace zenith{
 
 		std::vector<StructFieldInitializer> fields;
 		bool isPositional; // true if all fields are positional
+		EscapeInfo escape;
 
 		StructInitializerNode(SourceLocation loc, std::vector<StructFieldInitializer> fields)
 				: fields(std::move(fields)) {
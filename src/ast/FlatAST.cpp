@@ -0,0 +1,401 @@
+#include "FlatAST.hpp"
+#include <stdexcept>
+#include "../visitor/Visitor.hpp"
+
+namespace zenith {
+	namespace {
+		uint8_t memberFlags(const Member::Flags flags) {
+			return static_cast<uint8_t>(flags.kind) | static_cast<uint8_t>(flags.access) << 2 |
+			       flags.isConst << 5 | flags.isStatic << 6;
+		}
+	}
+
+	// Appends each node before its children and closes its subtree once they are all in
+	class FlatAST::Freezer : public Visitor {
+		FlatAST& flat;
+		std::unordered_map<std::string, uint32_t> index;
+		Index parent = 0;
+
+		Index open(const ASTNode& node, const Kind kind) {
+			const Index at = flat.size();
+			flat.nodes.push_back({
+				kind, 0, 0, at + 1, at == 0 ? 0 : parent, 0, 0,
+				static_cast<uint32_t>(node.loc.line), static_cast<uint32_t>(node.loc.column),
+				static_cast<uint32_t>(node.loc.length), static_cast<uint32_t>(node.loc.fileOffset)
+			});
+			parent = at;
+			return at;
+		}
+
+		Index open(const ExprNode& node, const Kind kind) {
+			const Index at = open(static_cast<const ASTNode&>(node), kind);
+			if (node.constantValue) flat.constants.emplace(at, *node.constantValue);
+			return at;
+		}
+
+		void close(const Index at) {
+			flat.nodes[at].end = flat.size();
+			parent = flat.nodes[at].parent;
+		}
+
+		Node& at(const Index index) { return flat.nodes[index]; }
+
+		template<typename T>
+		void add(T& child) {
+			if (child) child->accept(*this);
+			else flat.nodes.push_back({Kind::NONE, 0, 0, flat.size() + 1, parent, 0, 0, 0, 0, 0, 0});
+		}
+
+		uint32_t text(const std::string& value) {
+			const auto [it, added] = index.try_emplace(value, static_cast<uint32_t>(flat.strings.size()));
+			if (added) flat.strings.push_back(value);
+			return it->second;
+		}
+
+		// Starts a list in the side table, the caller appends the names
+		uint32_t list(const size_t count) {
+			const auto offset = static_cast<uint32_t>(flat.lists.size());
+			flat.lists.push_back(static_cast<uint32_t>(count));
+			return offset;
+		}
+
+		// A node's lists are written before its children add theirs, so a constructor's two stay next to each other
+		void signature(FunctionDeclNode& node, const Index self) {
+			at(self).name = text(node.name);
+			at(self).flags = node.isAsync | node.usingStructSugar << 1;
+			at(self).data = list(node.params.size());
+			for (const auto& param: node.params) flat.lists.push_back(text(param.name));
+		}
+
+		void function(FunctionDeclNode& node) {
+			for (auto& annotation: node.annotations) add(annotation);
+			for (auto& param: node.params) {
+				add(param.type);
+				add(param.defaultValue);
+			}
+			add(node.returnType);
+			add(node.body);
+		}
+
+		void method(MethodDeclNode& node, const Kind kind) {
+			const Index self = open(node, kind);
+			signature(node, self);
+			at(self).op = memberFlags(node.flags);
+			function(node);
+			close(self);
+		}
+
+		void object(ObjectDeclNode& node, const Kind kind) {
+			const Index self = open(node, kind);
+			at(self).name = text(node.name);
+			at(self).data = text(node.base);
+			at(self).op = static_cast<uint8_t>(node.kind);
+			at(self).flags = node.autoGettersSetters;
+			for (auto& member: node.members) add(member);
+			for (auto& op: node.operators) add(op);
+			close(self);
+		}
+
+		template<typename Statements>
+		void block(ASTNode& node, Statements& statements, const Kind kind) {
+			const Index self = open(node, kind);
+			for (auto& statement: statements) add(statement);
+			close(self);
+		}
+
+		// A node with a fixed list of children and no payload
+		template<typename... Children>
+		void plain(ASTNode& node, const Kind kind, Children&... children) {
+			const Index self = open(node, kind);
+			(add(children), ...);
+			close(self);
+		}
+
+		template<typename... Children>
+		void plain(ExprNode& node, const Kind kind, Children&... children) {
+			const Index self = open(node, kind);
+			(add(children), ...);
+			close(self);
+		}
+
+	public:
+		explicit Freezer(FlatAST& flat) : flat(flat) { text(""); }
+
+		void visit(ProgramNode& node) override { block(node, node.declarations, Kind::PROGRAM); }
+
+		void visit(ImportNode& node) override {
+			const Index self = open(node, Kind::IMPORT);
+			at(self).name = text(node.path);
+			at(self).op = node.isJavaImport;
+			close(self);
+		}
+
+		void visit(VarDeclNode& node) override {
+			const Index self = open(node, Kind::VAR_DECL);
+			at(self).name = text(node.name);
+			at(self).op = node.kind;
+			at(self).flags = node.isHoisted | node.isConst << 1;
+			add(node.type);
+			add(node.initializer);
+			close(self);
+		}
+
+		void visit(MultiVarDeclNode& node) override { block(node, node.vars, Kind::MULTI_VAR_DECL); }
+
+		void visit(FunctionDeclNode& node) override {
+			const Index self = open(node, Kind::FUNCTION);
+			signature(node, self);
+			function(node);
+			close(self);
+		}
+
+		void visit(LambdaNode& node) override {
+			const Index self = open(node, Kind::LAMBDA);
+			signature(node, self);
+			function(node);
+			close(self);
+		}
+
+		void visit(MethodDeclNode& node) override { method(node, Kind::METHOD); }
+		void visit(MessageHandlerNode& node) override { method(node, Kind::MESSAGE_HANDLER); }
+
+		void visit(CtorDeclNode& node) override {
+			const Index self = open(node, Kind::CONSTRUCTOR);
+			signature(node, self);
+			at(self).op = memberFlags(node.flags);
+			list(node.initializers.size());
+			for (const auto& [name, value]: node.initializers) flat.lists.push_back(text(name));
+			function(node);
+			for (auto& [name, value]: node.initializers) add(value);
+			close(self);
+		}
+
+		void visit(FieldDeclNode& node) override {
+			const Index self = open(node, Kind::FIELD);
+			at(self).name = text(node.name);
+			at(self).op = memberFlags(node.flags);
+			for (auto& annotation: node.annotations) add(annotation);
+			add(node.type);
+			add(node.initializer);
+			close(self);
+		}
+
+		void visit(OperatorOverloadNode& node) override {
+			const Index self = open(node, Kind::OPERATOR);
+			at(self).name = text(node.op);
+			at(self).data = list(node.params.size());
+			for (const auto& [name, type]: node.params) flat.lists.push_back(text(name));
+			for (auto& [name, type]: node.params) add(type);
+			add(node.returnType);
+			add(node.body);
+			close(self);
+		}
+
+		void visit(ObjectDeclNode& node) override { object(node, Kind::OBJECT); }
+		void visit(ActorDeclNode& node) override { object(node, Kind::ACTOR); }
+
+		void visit(UnionDeclNode& node) override {
+			const Index self = open(node, Kind::UNION);
+			at(self).name = text(node.name);
+			for (auto& type: node.types) add(type);
+			close(self);
+		}
+
+		void visit(TemplateDeclNode& node) override {
+			const Index self = open(node, Kind::TEMPLATE);
+			for (auto& parameter: node.parameters) parameter.accept(*this);
+			add(node.declaration);
+			close(self);
+		}
+
+		void visit(TemplateParameter& node) override {
+			const Index self = open(node, Kind::TEMPLATE_PARAMETER);
+			at(self).name = text(node.name);
+			at(self).op = static_cast<uint8_t>(node.kind);
+			at(self).flags = node.isVariadic;
+			add(node.defaultType);
+			add(node.type);
+			add(node.defaultValue);
+			for (auto& parameter: node.templateParams) parameter.accept(*this);
+			close(self);
+		}
+
+		void visit(AnnotationNode& node) override {
+			const Index self = open(node, Kind::ANNOTATION);
+			at(self).name = text(node.name);
+			at(self).data = list(node.arguments.size());
+			for (const auto& [name, value]: node.arguments) flat.lists.push_back(text(name));
+			for (auto& [name, value]: node.arguments) add(value);
+			close(self);
+		}
+
+		void visit(ErrorNode& node) override { plain(node, Kind::ERROR); }
+
+		// A LazyBlockNode materializes in accept() and comes here as a plain block
+		void visit(BlockNode& node) override { block(node, node.statements, Kind::BLOCK); }
+		void visit(ScopeBlockNode& node) override { block(node, node.statements, Kind::SCOPE_BLOCK); }
+		void visit(UnsafeNode& node) override { block(node, node.statements, Kind::UNSAFE); }
+		void visit(CompoundStmtNode& node) override { block(node, node.stmts, Kind::COMPOUND); }
+
+		void visit(IfNode& node) override {
+			plain(node, Kind::IF, node.condition, node.thenBranch, node.elseBranch);
+		}
+		void visit(WhileNode& node) override { plain(node, Kind::WHILE, node.condition, node.body); }
+		void visit(DoWhileNode& node) override { plain(node, Kind::DO_WHILE, node.body, node.condition); }
+
+		void visit(ForNode& node) override {
+			plain(node, Kind::FOR, node.initializer, node.condition, node.increment, node.body);
+		}
+
+		void visit(ExprStmtNode& node) override { plain(node, Kind::EXPR_STMT, node.expr); }
+		void visit(EmptyStmtNode& node) override { plain(node, Kind::EMPTY_STMT); }
+		void visit(ReturnStmtNode& node) override { plain(node, Kind::RETURN, node.value); }
+
+		void visit(LiteralNode& node) override {
+			const Index self = open(node, Kind::LITERAL);
+			at(self).name = text(node.value);
+			at(self).op = node.type;
+			close(self);
+		}
+
+		void visit(VarNode& node) override {
+			const Index self = open(node, Kind::VAR);
+			at(self).name = text(node.name);
+			close(self);
+		}
+
+		void visit(BinaryOpNode& node) override {
+			const Index self = open(node, Kind::BINARY);
+			at(self).op = node.op;
+			add(node.left);
+			add(node.right);
+			close(self);
+		}
+
+		void visit(UnaryOpNode& node) override {
+			const Index self = open(node, Kind::UNARY);
+			at(self).op = static_cast<uint8_t>(node.op);
+			at(self).flags = node.prefix;
+			add(node.right);
+			close(self);
+		}
+
+		void visit(CallNode& node) override {
+			const Index self = open(node, Kind::CALL);
+			add(node.callee);
+			for (auto& argument: node.arguments) add(argument);
+			close(self);
+		}
+
+		void visit(MemberAccessNode& node) override {
+			const Index self = open(node, Kind::MEMBER_ACCESS);
+			at(self).name = text(node.member);
+			add(node.object);
+			close(self);
+		}
+
+		void visit(FreeObjectNode& node) override {
+			const Index self = open(node, Kind::FREE_OBJECT);
+			at(self).data = list(node.properties.size());
+			for (const auto& [name, value]: node.properties) flat.lists.push_back(text(name));
+			for (auto& [name, value]: node.properties) add(value);
+			close(self);
+		}
+
+		void visit(ArrayAccessNode& node) override { plain(node, Kind::ARRAY_ACCESS, node.array, node.index); }
+
+		void visit(NewExprNode& node) override {
+			const Index self = open(node, Kind::NEW);
+			at(self).name = text(node.className);
+			for (auto& argument: node.args) add(argument);
+			close(self);
+		}
+
+		void visit(TemplateStringNode& node) override {
+			const Index self = open(node, Kind::TEMPLATE_STRING);
+			for (auto& part: node.parts) add(part);
+			close(self);
+		}
+
+		void visit(ThisNode& node) override { plain(node, Kind::THIS); }
+
+		void visit(StructInitializerNode& node) override {
+			const Index self = open(node, Kind::STRUCT_INIT);
+			at(self).flags = node.isPositional;
+			at(self).data = list(node.fields.size());
+			for (const auto& field: node.fields) flat.lists.push_back(text(field.name));
+			for (auto& field: node.fields) add(field.value);
+			close(self);
+		}
+
+		void visit(LambdaExprNode& node) override { plain(node, Kind::LAMBDA_EXPR, node.lambda); }
+
+		void visit(TypeNode& node) override {
+			const Index self = open(node, Kind::TYPE);
+			at(self).op = static_cast<uint8_t>(node.kind);
+			close(self);
+		}
+
+		void visit(PrimitiveTypeNode& node) override {
+			const Index self = open(node, Kind::PRIMITIVE_TYPE);
+			at(self).op = static_cast<uint8_t>(node.type);
+			close(self);
+		}
+
+		void visit(NamedTypeNode& node) override {
+			const Index self = open(node, Kind::NAMED_TYPE);
+			at(self).name = text(node.name);
+			close(self);
+		}
+
+		void visit(ArrayTypeNode& node) override {
+			plain(node, Kind::ARRAY_TYPE, node.elementType, node.sizeExpr);
+		}
+
+		void visit(TemplateTypeNode& node) override {
+			const Index self = open(node, Kind::TEMPLATE_TYPE);
+			at(self).name = text(node.baseName);
+			for (auto& argument: node.templateArgs) add(argument);
+			close(self);
+		}
+
+		void visit(FunctionTypeNode& node) override {
+			const Index self = open(node, Kind::FUNCTION_TYPE);
+			for (auto& parameter: node.parameterTypes) add(parameter);
+			add(node.returnType);
+			close(self);
+		}
+	};
+
+	FlatAST FlatAST::freeze(ProgramNode& program) {
+		FlatAST flat;
+		flat.file = program.loc.file;
+		Freezer freezer(flat);
+		program.accept(freezer);
+		return flat;
+	}
+
+	FlatAST::Index FlatAST::child(const Index index, const size_t position) const {
+		size_t at = 0;
+		for (const Index child: children(index)) {
+			if (at++ == position) return child;
+		}
+		throw std::out_of_range("Node " + std::to_string(index) + " has no child " + std::to_string(position));
+	}
+
+	std::span<const uint32_t> FlatAST::names(const Index index, int list) const {
+		uint32_t offset = nodes[index].data;
+		for (; list > 0; --list) offset += lists[offset] + 1;
+		return {lists.data() + offset + 1, lists[offset]};
+	}
+
+	const ConstantValue* FlatAST::constant(const Index index) const {
+		const auto it = constants.find(index);
+		return it == constants.end() ? nullptr : &it->second;
+	}
+
+	SourceLocation FlatAST::location(const Index index) const {
+		const Node& node = nodes[index];
+		return {node.line, node.column, node.length, node.offset, file};
+	}
+}
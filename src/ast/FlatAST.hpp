@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "AST.hpp"
+
+namespace zenith {
+	// Read-only copy of a tree in one array, for analyses that only look at it
+	// Built once after parsing by freeze(). Nodes are stored in pre-order, in the order ASTWalker visits them, so a
+	// subtree is the range [index, end) and walking the whole tree is a loop over the array. Children refer to each
+	// other by index; an absent optional child (an if without else, a declaration without a type) is a NONE node so
+	// every kind has its children at fixed positions. Names and literals live in one string table, lists of names in
+	// a side table and folded constants in a map, so a node stays the same small size whatever it stands for.
+	class FlatAST {
+	public:
+		using Index = uint32_t;
+
+		// What a node's children are and what its payload means, in that order
+		enum class Kind : uint8_t {
+			NONE,
+			PROGRAM,          // declarations
+			IMPORT,           // name: path, op: Java import
+			VAR_DECL,         // type, initializer; name, op: VarDeclNode::Kind, flags: hoisted | const << 1
+			MULTI_VAR_DECL,   // variables
+			FUNCTION,         // annotations, (type, default) per parameter, return type, body; name, flags: async |
+			                  // struct sugar << 1, names: parameters
+			LAMBDA,           // like FUNCTION
+			METHOD,           // like FUNCTION; op: member flags
+			MESSAGE_HANDLER,  // like METHOD
+			CONSTRUCTOR,      // like METHOD, then initializer values; names: parameters, then initialized members
+			FIELD,            // annotations, type, initializer; name, op: member flags
+			OPERATOR,         // type per parameter, return type, body; name: operator, names: parameters
+			OBJECT,           // members, operators; name, data: base name, op: ObjectDeclNode::Kind, flags: getters
+			ACTOR,            // like OBJECT
+			UNION,            // types; name
+			TEMPLATE,         // parameters, declaration
+			TEMPLATE_PARAMETER, // default type, type, default value, template parameters; name, op: kind, flags: variadic
+			ANNOTATION,       // argument values; name, names: arguments
+			ERROR,
+			BLOCK,            // statements
+			SCOPE_BLOCK,      // statements
+			UNSAFE,           // statements
+			IF,               // condition, then, else
+			WHILE,            // condition, body
+			DO_WHILE,         // body, condition
+			FOR,              // initializer, condition, increment, body
+			EXPR_STMT,        // expression
+			EMPTY_STMT,
+			RETURN,           // value
+			COMPOUND,         // statements
+			// Expressions, constant() has what semantic analysis folded them to
+			LITERAL,          // name: text, op: LiteralNode::Type
+			VAR,              // name
+			BINARY,           // left, right; op: BinaryOpNode::Op
+			UNARY,            // operand; op: UnaryOpNode::Op, flags: prefix
+			CALL,             // callee, arguments
+			MEMBER_ACCESS,    // object; name: member
+			FREE_OBJECT,      // property values; names: properties
+			ARRAY_ACCESS,     // array, index
+			NEW,              // arguments; name: class
+			TEMPLATE_STRING,  // parts
+			THIS,
+			STRUCT_INIT,      // field values; names: fields, flags: positional
+			LAMBDA_EXPR,      // lambda
+			TYPE,             // op: TypeNode::Kind
+			PRIMITIVE_TYPE,   // op: PrimitiveTypeNode::Type
+			NAMED_TYPE,       // name
+			ARRAY_TYPE,       // element type, size expression
+			TEMPLATE_TYPE,    // arguments; name: base
+			FUNCTION_TYPE     // parameter types, return type
+		};
+
+		struct Node {
+			Kind kind;
+			uint8_t op;
+			uint16_t flags;
+			Index end;    // One past the subtree, the next sibling unless this is the last child
+			Index parent; // The root is its own parent
+			uint32_t name; // String index
+			uint32_t data; // Second string index, or side table offset of the names
+			uint32_t line, column, length, offset;
+		};
+		static_assert(sizeof(Node) == 36, "a node should stay within 36 bytes");
+
+		// Children of one node, in order; a forward range that skips over each child's subtree
+		class Children {
+			const Node* nodes;
+			Index first, last;
+
+		public:
+			class iterator {
+				const Node* nodes;
+				Index at;
+
+			public:
+				using value_type = Index;
+				using difference_type = std::ptrdiff_t;
+				iterator() = default;
+				iterator(const Node* nodes, const Index at) : nodes(nodes), at(at) {}
+				Index operator*() const { return at; }
+				iterator& operator++() { at = nodes[at].end; return *this; }
+				iterator operator++(int) { auto old = *this; ++*this; return old; }
+				bool operator==(const iterator& other) const { return at == other.at; }
+			};
+
+			Children(const Node* nodes, const Index first, const Index last) : nodes(nodes), first(first), last(last) {}
+			[[nodiscard]] iterator begin() const { return {nodes, first}; }
+			[[nodiscard]] iterator end() const { return {nodes, last}; }
+			[[nodiscard]] bool empty() const { return first == last; }
+		};
+
+		// Lazy bodies are materialized on the way, the tree itself is not changed otherwise
+		[[nodiscard]] static FlatAST freeze(ProgramNode& program);
+
+		[[nodiscard]] Index size() const { return static_cast<Index>(nodes.size()); }
+		[[nodiscard]] const Node& operator[](const Index index) const { return nodes[index]; }
+		[[nodiscard]] std::span<const Node> all() const { return nodes; }
+
+		[[nodiscard]] Children children(const Index index) const {
+			return {nodes.data(), index + 1, nodes[index].end};
+		}
+		[[nodiscard]] Index child(Index index, size_t position) const;
+
+		[[nodiscard]] std::string_view name(const Index index) const { return strings[nodes[index].name]; }
+		[[nodiscard]] std::string_view string(const uint32_t id) const { return strings[id]; }
+		// The node's list of names (parameters, properties, ...); list 1 is a constructor's initialized members
+		[[nodiscard]] std::span<const uint32_t> names(Index index, int list = 0) const;
+		[[nodiscard]] const ConstantValue* constant(Index index) const;
+		// Every location carries the program's file
+		[[nodiscard]] SourceLocation location(Index index) const;
+
+	private:
+		class Freezer;
+		std::vector<Node> nodes;
+		std::vector<std::string> strings;
+		std::vector<uint32_t> lists; // Each list is its length, then string indices
+		std::unordered_map<Index, ConstantValue> constants;
+		std::string file;
+	};
+}
@@ -0,0 +1,18 @@
+#include "NodeSizes.hpp"
+#include "fmt/format.h"
+#include "AST.hpp"
+
+namespace zenith {
+#define ZENITH_CHECK_NODE_SIZE(Node, budget) \
+	static_assert(sizeof(void*) != 8 || sizeof(Node) <= (budget), #Node " grew past its size budget");
+	ZENITH_AST_NODE_SIZES(ZENITH_CHECK_NODE_SIZE)
+#undef ZENITH_CHECK_NODE_SIZE
+
+	std::string nodeSizeReport() {
+		std::string report = fmt::format("{:<24}{:>6}{:>8}\n", "node", "size", "budget");
+#define ZENITH_REPORT_NODE_SIZE(Node, budget) report += fmt::format("{:<24}{:>6}{:>8}\n", #Node, sizeof(Node), budget);
+		ZENITH_AST_NODE_SIZES(ZENITH_REPORT_NODE_SIZE)
+#undef ZENITH_REPORT_NODE_SIZE
+		return report;
+	}
+}
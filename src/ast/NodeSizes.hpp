@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+
+// Every node type with the most bytes one may take, on a 64-bit target
+// Nodes are allocated one at a time and make up most of a parse's memory, so a node growing is a decision: raise its
+// budget in the same change. NodeSizes.cpp checks them at compile time, node_sizes prints the table.
+#define ZENITH_AST_NODE_SIZES(X) \
+	X(ProgramNode, 96) \
+	X(ImportNode, 112) \
+	X(VarDeclNode, 152) \
+	X(MultiVarDeclNode, 96) \
+	X(FunctionDeclNode, 208) \
+	X(LambdaNode, 208) \
+	X(FieldDeclNode, 184) \
+	X(MethodDeclNode, 208) \
+	X(CtorDeclNode, 264) \
+	X(MessageHandlerNode, 208) \
+	X(OperatorOverloadNode, 160) \
+	X(ObjectDeclNode, 200) \
+	X(ActorDeclNode, 200) \
+	X(UnionDeclNode, 128) \
+	X(TemplateDeclNode, 112) \
+	X(TemplateParameter, 192) \
+	X(AnnotationNode, 128) \
+	X(ErrorNode, 72) \
+	X(BlockNode, 96) \
+	X(LazyBlockNode, 136) \
+	X(ScopeBlockNode, 96) \
+	X(UnsafeNode, 96) \
+	X(IfNode, 120) \
+	X(WhileNode, 104) \
+	X(DoWhileNode, 104) \
+	X(ForNode, 136) \
+	X(ExprStmtNode, 88) \
+	X(EmptyStmtNode, 72) \
+	X(ReturnStmtNode, 88) \
+	X(CompoundStmtNode, 96) \
+	X(LiteralNode, 168) \
+	X(VarNode, 160) \
+	X(BinaryOpNode, 168) \
+	X(UnaryOpNode, 160) \
+	X(CallNode, 216) \
+	X(MemberAccessNode, 176) \
+	X(FreeObjectNode, 344) \
+	X(ArrayAccessNode, 160) \
+	X(NewExprNode, 240) \
+	X(TemplateStringNode, 200) \
+	X(ThisNode, 128) \
+	X(StructInitializerNode, 160) \
+	X(LambdaExprNode, 144) \
+	X(TypeNode, 80) \
+	X(PrimitiveTypeNode, 80) \
+	X(NamedTypeNode, 112) \
+	X(ArrayTypeNode, 144) \
+	X(TemplateTypeNode, 136) \
+	X(FunctionTypeNode, 128)
+
+namespace zenith {
+	// One line per node type: name, sizeof, budget
+	std::string nodeSizeReport();
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <utility>
 #include <sstream>
 #include <vector>
@@ -8,6 +9,8 @@
 
 
 namespace zenith {
+	class ErrorReporter;
+
 	// Block statements { ... }
 	struct BlockNode : StmtNode {
 		std::vector<polymorphic<ASTNode>> statements;
@@ -31,6 +34,36 @@ namespace zenith {
 		ACCEPT_METHODS
 	};
 
+	// Function body that is only brace-matched by the parser (--lazy-parse), or not yet decoded from a BinaryAST
+	// The statements are parsed the first time a visitor enters the block, visitors then see a plain BlockNode.
+	// The node can outlive the parser and whoever called it, so it owns what parsing needs except the reporter,
+	// which the visitor that materializes it passes in.
+	struct LazyBlockNode : BlockNode {
+		using ParseBody = std::function<std::vector<polymorphic<ASTNode>>(ErrorReporter* reporter)>;
+		ParseBody parseBody;
+		size_t tokenCount; // 0 for decoded bodies
+
+		LazyBlockNode(SourceLocation loc, size_t tokenCount, ParseBody parseBody)
+				: BlockNode(std::move(loc), {}), parseBody(std::move(parseBody)), tokenCount(tokenCount) {}
+
+		[[nodiscard]] bool isParsed() const { return !parseBody; }
+		// Syntax errors in the body go to reporter; without one they are dropped, as for visitors that only walk or
+		// copy the tree. Not synchronized: each body is checked by exactly one analysis task
+		void materialize(ErrorReporter* reporter = nullptr) {
+			if (!parseBody) return;
+			auto parse = std::move(parseBody);
+			parseBody = nullptr;
+			statements = parse(reporter);
+		}
+
+		[[nodiscard]] std::string toString(int indent = 0) const override {
+			if (isParsed()) return BlockNode::toString(indent);
+			if (tokenCount == 0) return std::string(indent, ' ') + "Block { <not decoded yet> }";
+			return std::string(indent, ' ') + "Block { <" + std::to_string(tokenCount) + " tokens, not parsed yet> }";
+		}
+		ACCEPT_METHODS
+	};
+
 	struct ScopeBlockNode : BlockNode {
 
 		explicit ScopeBlockNode(SourceLocation loc,
@@ -71,6 +71,7 @@ namespace zenith {
 	struct ArrayTypeNode : TypeNode {
 		polymorphic_variant<TypeNode> elementType;
 		polymorphic_variant<ExprNode> sizeExpr;
+		std::optional<uint64_t> size; // sizeExpr evaluated, set on the types SemanticAnalyzer::resolveType() returns
 
 		ArrayTypeNode(SourceLocation loc, polymorphic_variant<TypeNode> elemType, polymorphic_variant<ExprNode> sizeExpr = nullptr)
 				: TypeNode(std::move(loc), Kind::ARRAY), elementType(std::move(elemType)), sizeExpr(std::move(sizeExpr)) {}
@@ -3,7 +3,6 @@
 namespace zenith {
 	ACCEPT_METHOD(VarDeclNode)
 	ACCEPT_METHOD(FunctionDeclNode)
-	ACCEPT_METHOD(MemberDeclNode)
 	ACCEPT_METHOD(LambdaNode)
 	ACCEPT_METHOD(OperatorOverloadNode)
 	ACCEPT_METHOD(ObjectDeclNode)
@@ -33,6 +32,7 @@ namespace zenith {
 	ACCEPT_METHOD(TemplateParameter)
 	ACCEPT_METHOD(TemplateDeclNode)
 	ACCEPT_METHOD(BlockNode)
+	ACCEPT_METHOD(LazyBlockNode)
 	ACCEPT_METHOD(ScopeBlockNode)
 	ACCEPT_METHOD(IfNode)
 	ACCEPT_METHOD(WhileNode)
@@ -0,0 +1,151 @@
+// Traversal of the pointer tree against its FlatAST copy
+// The same read-only analysis (variable references, and binary operators on two literals) runs three ways: an
+// ASTWalker over the parsed tree, a loop over the flat array, and a recursive walk of the flat tree through children().
+//
+//   flat_ast_bench [--lines N] [--runs R]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ast/FlatAST.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "visitor/ASTWalker.hpp"
+#include "exceptions/DiagnosticsEngine.hpp"
+using namespace zenith;
+
+static constexpr size_t FUNCTION_LINES = 10;
+
+static std::string generate(const size_t lines) {
+	std::ostringstream out;
+	for (size_t i = 0, line = 0; line < lines; ++i, line += FUNCTION_LINES) {
+		out << "fun int f" << i << "(int a, int b) {\n"
+			<< "    int x = a + b * " << i << "\n"
+			<< "    var y = g(h(x, a), 2 * 3)\n"
+			<< "    if (x > y) {\n"
+			<< "        x = x - 1\n"
+			<< "    }\n"
+			<< "    while (x < 10) {\n"
+			<< "        x = x + h(a, b)\n"
+			<< "    }\n"
+			<< "}\n";
+	}
+	return out.str();
+}
+
+static size_t argument(const int argc, char* argv[], const std::string& name, const size_t fallback) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (argv[i] == name) return std::strtoull(argv[i + 1], nullptr, 10);
+	}
+	return fallback;
+}
+
+template<typename F>
+static double timed(F&& f) {
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double median(std::vector<double> times) {
+	std::ranges::sort(times);
+	return times[times.size() / 2];
+}
+
+struct Counts {
+	size_t variables = 0, foldable = 0;
+	bool operator==(const Counts&) const = default;
+};
+
+class PointerCount : public ASTWalker {
+protected:
+	void enter(ASTNode&) override {}
+
+public:
+	Counts counts;
+
+	void visit(VarNode& node) override {
+		++counts.variables;
+		ASTWalker::visit(node);
+	}
+
+	void visit(BinaryOpNode& node) override {
+		if (dynamic_cast<LiteralNode*>(node.left.get()) && dynamic_cast<LiteralNode*>(node.right.get())) {
+			++counts.foldable;
+		}
+		ASTWalker::visit(node);
+	}
+};
+
+static Counts scan(const FlatAST& flat) {
+	Counts counts;
+	const auto nodes = flat.all();
+	for (FlatAST::Index i = 0; i < nodes.size(); ++i) {
+		if (nodes[i].kind == FlatAST::Kind::VAR) ++counts.variables;
+		else if (nodes[i].kind == FlatAST::Kind::BINARY && nodes[i + 1].kind == FlatAST::Kind::LITERAL &&
+		         nodes[nodes[i + 1].end].kind == FlatAST::Kind::LITERAL) {
+			++counts.foldable;
+		}
+	}
+	return counts;
+}
+
+static void recurse(const FlatAST& flat, const FlatAST::Index index, Counts& counts) {
+	const auto& node = flat[index];
+	if (node.kind == FlatAST::Kind::VAR) ++counts.variables;
+	if (node.kind == FlatAST::Kind::BINARY) {
+		auto children = flat.children(index).begin();
+		const FlatAST::Index left = *children++;
+		if (flat[left].kind == FlatAST::Kind::LITERAL && flat[*children].kind == FlatAST::Kind::LITERAL) {
+			++counts.foldable;
+		}
+	}
+	for (const FlatAST::Index child: flat.children(index)) recurse(flat, child, counts);
+}
+
+int main(int argc, char* argv[]) {
+	const size_t lines = argument(argc, argv, "--lines", 100000);
+	const size_t runs = std::max<size_t>(1, argument(argc, argv, "--runs", 20));
+
+	Flags flags;
+	DiagnosticsEngine diagnostics;
+	ErrorReporter reporter(diagnostics);
+	std::ostream discard(nullptr);
+	Parser parser(Lexer(generate(lines), "<bench>").tokenize(), flags, reporter, discard);
+	auto program = parser.parse();
+
+	FlatAST flat;
+	const double freezeTime = timed([&] { flat = FlatAST::freeze(*program); });
+
+	std::vector<double> pointerTimes, scanTimes, recurseTimes;
+	Counts pointer, linear, recursive;
+	for (size_t i = 0; i < runs; ++i) {
+		pointerTimes.push_back(timed([&] {
+			PointerCount count;
+			program->accept(count);
+			pointer = count.counts;
+		}));
+		scanTimes.push_back(timed([&] { linear = scan(flat); }));
+		recurseTimes.push_back(timed([&] {
+			recursive = {};
+			recurse(flat, 0, recursive);
+		}));
+	}
+	if (!(pointer == linear && linear == recursive)) {
+		std::cerr << "Traversals disagree\n";
+		return 1;
+	}
+
+	const double walk = median(pointerTimes);
+	std::cout << "lines:              " << lines << "\n"
+		<< "nodes:              " << flat.size() << " (" << flat.size() * sizeof(FlatAST::Node) / 1024 << " KiB)\n"
+		<< "variables, foldable: " << pointer.variables << ", " << pointer.foldable << "\n"
+		<< "freeze:             " << freezeTime << " ms\n"
+		<< "pointer walk:       " << walk << " ms\n"
+		<< "flat scan:          " << median(scanTimes) << " ms (" << walk / median(scanTimes) << "x)\n"
+		<< "flat recursion:     " << median(recurseTimes) << " ms (" << walk / median(recurseTimes) << "x)\n";
+	return 0;
+}
@@ -0,0 +1,52 @@
+// Writes a synthetic Zenith program, the same one for the same options
+//
+//   zenith_gen [--lines N] [--seed S] [--errors-per-kloc E] [--depth D] [--statements K] [--analyzable] [--out FILE]
+//
+// --analyzable leaves out what the analyzer cannot check yet. Without --out the program goes to stdout, the line
+// and error counts to stderr.
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "ProgramGenerator.hpp"
+using namespace zenith;
+
+static std::string argument(const int argc, char* argv[], const std::string& name, const std::string& fallback) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (argv[i] == name) return argv[i + 1];
+	}
+	return fallback;
+}
+
+static bool flag(const int argc, char* argv[], const std::string& name) {
+	for (int i = 1; i < argc; ++i) {
+		if (argv[i] == name) return true;
+	}
+	return false;
+}
+
+int main(int argc, char* argv[]) {
+	const size_t lines = std::strtoull(argument(argc, argv, "--lines", "1000").c_str(), nullptr, 10);
+	const uint64_t seed = std::strtoull(argument(argc, argv, "--seed", "1").c_str(), nullptr, 10);
+	auto options = flag(argc, argv, "--analyzable")
+		? ProgramGenerator::Options::analyzable(lines, seed)
+		: ProgramGenerator::Options{.lines = lines, .seed = seed};
+	options.errorsPerKLoc = std::strtod(argument(argc, argv, "--errors-per-kloc", "0").c_str(), nullptr);
+	options.expressionDepth = std::strtoull(argument(argc, argv, "--depth", "4").c_str(), nullptr, 10);
+	options.statements = std::max<size_t>(1, std::strtoull(argument(argc, argv, "--statements", "8").c_str(), nullptr, 10));
+
+	ProgramGenerator generator(options);
+	const std::string file = argument(argc, argv, "--out", "");
+	if (file.empty()) {
+		generator.write(std::cout);
+	} else {
+		std::ofstream out(file, std::ios::binary);
+		if (!out) {
+			std::cerr << "Could not open " << file << "\n";
+			return 1;
+		}
+		generator.write(out);
+	}
+	std::cerr << generator.lines() << " lines, " << generator.injectedErrors() << " syntax errors\n";
+	return 0;
+}
@@ -0,0 +1,116 @@
+// Latency of single-character edits: Parser::reparse against a full parse of the edited file
+// Generates a corpus of small functions, then applies random one-character edits (a digit changed, a space or a
+// newline inserted) one after the other. Lexing is timed on its own, there is no incremental lexer yet.
+//
+//   incremental_parse_bench [--lines N] [--edits E] [--seed S]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "exceptions/DiagnosticsEngine.hpp"
+using namespace zenith;
+
+static constexpr size_t FUNCTION_LINES = 10;
+
+static std::string generate(const size_t lines) {
+	std::ostringstream out;
+	for (size_t i = 0, line = 0; line < lines; ++i, line += FUNCTION_LINES) {
+		out << "fun int f" << i << "(int a, int b) {\n"
+			<< "    int x = a + b * " << i << "\n"
+			<< "    var y = g(h(x, a), b)\n"
+			<< "    if (x > y) {\n"
+			<< "        x = x - 1\n"
+			<< "    }\n"
+			<< "    while (x < 10) {\n"
+			<< "        x = x + h(a, b)\n"
+			<< "    }\n"
+			<< "}\n";
+	}
+	return out.str();
+}
+
+static size_t argument(const int argc, char* argv[], const std::string& name, const size_t fallback) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (argv[i] == name) return std::strtoull(argv[i + 1], nullptr, 10);
+	}
+	return fallback;
+}
+
+template<typename F>
+static double timed(F&& f) {
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double percentile(std::vector<double> times, const double p) {
+	std::ranges::sort(times);
+	return times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))];
+}
+
+int main(int argc, char* argv[]) {
+	const size_t lines = argument(argc, argv, "--lines", 100000);
+	const size_t edits = std::max<size_t>(1, argument(argc, argv, "--edits", 50));
+	std::mt19937 rng(static_cast<unsigned>(argument(argc, argv, "--seed", 1)));
+
+	std::string source = generate(lines);
+	Flags flags;
+	DiagnosticsEngine diagnostics;
+	ErrorReporter reporter(diagnostics);
+	std::ostream discard(nullptr);
+	auto parse = Parser::parseForEditing(Lexer(source, "<bench>").tokenize(), flags, reporter, discard);
+	const size_t tokenCount = parse.tokens.size();
+
+	std::vector<double> lexTimes, reparseTimes, fullTimes;
+	size_t reusedDeclarations = 0, reusedStatements = 0, declarations = 0;
+	for (size_t i = 0; i < edits; ++i) {
+		// Somewhere past a random point: the next digit changes, or a space or newline goes before the next space
+		const size_t from = rng() % source.size();
+		auto next = [&](const char* chars) {
+			const size_t found = source.find_first_of(chars, from);
+			return found == std::string::npos ? source.find_first_of(chars) : found;
+		};
+		TextEdit edit{};
+		if (i % 3 == 0) {
+			const size_t digit = next("0123456789");
+			source[digit] = static_cast<char>('0' + (source[digit] - '0' + 1) % 10);
+			edit = {digit, 1, 1};
+		}
+		else {
+			const size_t space = next(" ");
+			source.insert(space, 1, i % 3 == 1 ? ' ' : '\n');
+			edit = {space, 0, 1};
+		}
+
+		std::vector<Token> tokens;
+		lexTimes.push_back(timed([&] { tokens = Lexer(source, "<bench>").tokenize(); }));
+		std::vector<Token> copy = tokens;
+		reparseTimes.push_back(timed([&] {
+			parse = Parser::reparse(std::move(parse), edit, std::move(tokens), flags, reporter, discard);
+		}));
+		fullTimes.push_back(timed([&] {
+			Parser parser(std::move(copy), flags, reporter, discard);
+			auto program = parser.parse();
+		}));
+		reusedDeclarations += parse.reusedDeclarations;
+		reusedStatements += parse.reusedStatements;
+		declarations += parse.program->declarations.size();
+	}
+
+	std::cout << "lines:              " << lines << "\n"
+		<< "tokens:             " << tokenCount << "\n"
+		<< "edits:              " << edits << "\n"
+		<< "declarations kept:  " << 100.0 * reusedDeclarations / declarations << " %\n"
+		<< "statements reused:  " << static_cast<double>(reusedStatements) / edits << " per edit\n"
+		<< "lex median:         " << percentile(lexTimes, 0.5) << " ms\n"
+		<< "full parse median:  " << percentile(fullTimes, 0.5) << " ms\n"
+		<< "reparse median:     " << percentile(reparseTimes, 0.5) << " ms\n"
+		<< "reparse p90:        " << percentile(reparseTimes, 0.9) << " ms\n";
+	return 0;
+}
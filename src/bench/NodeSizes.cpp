@@ -0,0 +1,10 @@
+// Prints sizeof and the budget of every AST node type, see ast/NodeSizes.hpp
+//
+//   node_sizes
+#include <iostream>
+#include "ast/NodeSizes.hpp"
+
+int main() {
+	std::cout << zenith::nodeSizeReport();
+	return 0;
+}
@@ -0,0 +1,81 @@
+// Parse throughput on code with and without syntax errors
+// Generates a corpus of small functions and breaks one line in every --error-every lines, so error recovery runs
+// as often as it would on a file someone is in the middle of editing. Only Parser::parse is timed.
+//
+//   parser_error_bench [--lines N] [--error-every K] [--runs R]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "exceptions/DiagnosticsEngine.hpp"
+using namespace zenith;
+
+static constexpr size_t FUNCTION_LINES = 10;
+
+static std::string generate(const size_t lines, const size_t errorEvery) {
+	std::ostringstream out;
+	size_t line = 0, nextError = errorEvery;
+	for (size_t i = 0; line < lines; ++i, line += FUNCTION_LINES) {
+		// The error sits inside a nested call, recovery has to get out of several levels of expression parsing
+		const bool broken = errorEvery && line + FUNCTION_LINES > nextError;
+		if (broken) nextError += errorEvery;
+		out << "fun int f" << i << "(int a, int b) {\n"
+			<< "    int x = a + b * " << i << "\n"
+			<< (broken ? "    var y = g(h(x, ), b)\n" : "    var y = g(h(x, a), b)\n")
+			<< "    if (x > y) {\n"
+			<< "        x = x - 1\n"
+			<< "    }\n"
+			<< "    while (x < 10) {\n"
+			<< "        x = x + h(a, b)\n"
+			<< "    }\n"
+			<< "}\n";
+	}
+	return out.str();
+}
+
+static size_t argument(const int argc, char* argv[], const std::string& name, const size_t fallback) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (argv[i] == name) return std::strtoull(argv[i + 1], nullptr, 10);
+	}
+	return fallback;
+}
+
+int main(int argc, char* argv[]) {
+	const size_t lines = argument(argc, argv, "--lines", 100000);
+	const size_t errorEvery = argument(argc, argv, "--error-every", 10);
+	const size_t runs = std::max<size_t>(1, argument(argc, argv, "--runs", 5));
+
+	const std::string source = generate(lines, errorEvery);
+	const std::vector<Token> tokens = Lexer(source, "<bench>").tokenize();
+	Flags flags;
+
+	std::vector<double> times;
+	size_t errors = 0;
+	for (size_t run = 0; run < runs; ++run) {
+		DiagnosticsEngine diagnostics;
+		ErrorReporter reporter(diagnostics);
+		std::ostream discard(nullptr);
+		Parser parser(tokens, flags, reporter, discard);
+
+		const auto start = std::chrono::steady_clock::now();
+		auto program = parser.parse();
+		times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		errors = diagnostics.errorCount();
+	}
+	std::ranges::sort(times);
+
+	const double best = times.front(), median = times[times.size() / 2];
+	std::cout << "lines:        " << lines << "\n"
+		<< "tokens:       " << tokens.size() << "\n"
+		<< "error every:  " << (errorEvery ? std::to_string(errorEvery) + " lines" : "never") << "\n"
+		<< "errors:       " << errors << "\n"
+		<< "parse best:   " << best << " ms\n"
+		<< "parse median: " << median << " ms\n"
+		<< "lines/s:      " << static_cast<size_t>(lines / (best / 1000)) << "\n";
+	return 0;
+}
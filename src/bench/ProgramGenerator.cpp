@@ -0,0 +1,318 @@
+#include "ProgramGenerator.hpp"
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+
+namespace zenith {
+	static constexpr size_t FLUSH_BYTES = 1 << 16;
+	static constexpr size_t MAX_BLOCK_DEPTH = 2;
+
+	ProgramGenerator::Options ProgramGenerator::Options::analyzable(const size_t lines, const uint64_t seed) {
+		Options options;
+		options.lines = lines;
+		options.seed = seed;
+		options.lambdas = false;
+		return options;
+	}
+
+	ProgramGenerator::ProgramGenerator(Options options)
+		: options(options), state(options.seed),
+		  nextError(options.errorsPerKLoc > 0 ? 1000 / options.errorsPerKLoc : 0) {}
+
+	// splitmix64, the standard distributions are not the same in every standard library
+	uint64_t ProgramGenerator::next() {
+		uint64_t z = state += 0x9e3779b97f4a7c15;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		return z ^ (z >> 31);
+	}
+
+	size_t ProgramGenerator::below(const size_t n) {
+		return n ? next() % n : 0;
+	}
+
+	bool ProgramGenerator::chance(const unsigned percent) {
+		return below(100) < percent;
+	}
+
+	void ProgramGenerator::write(std::ostream& out) {
+		this->out = &out;
+		while (lineCount < options.lines) declaration();
+		flush();
+		this->out = nullptr;
+	}
+
+	std::string ProgramGenerator::generate() {
+		std::ostringstream out;
+		write(out);
+		return out.str();
+	}
+
+	void ProgramGenerator::line(const size_t indent, const std::string& text) {
+		buffer.append(indent * 4, ' ');
+		buffer += text;
+		buffer += '\n';
+		++lineCount;
+		if (buffer.size() >= FLUSH_BYTES) flush();
+	}
+
+	void ProgramGenerator::flush() {
+		if (out) out->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		buffer.clear();
+	}
+
+	bool ProgramGenerator::errorDue() const {
+		return options.errorsPerKLoc > 0 && static_cast<double>(lineCount) >= nextError;
+	}
+
+	void ProgramGenerator::declaration() {
+		const unsigned weights[] = {
+			options.functions, options.classes, options.structs, options.templates, options.actors, options.freeObjects
+		};
+		unsigned total = 0;
+		for (const unsigned weight: weights) total += weight;
+		// Something has to be callable before anything else is generated
+		size_t pick = functionCount == 0 || total == 0 ? 0 : below(total);
+		size_t kind = 0;
+		while (kind + 1 < std::size(weights) && pick >= weights[kind]) pick -= weights[kind++];
+		switch (kind) {
+			case 0: function(); break;
+			case 1: classDecl(); break;
+			case 2: structDecl(); break;
+			case 3: templateDecl(); break;
+			case 4: actor(); break;
+			default: freeObject(); break;
+		}
+	}
+
+	static std::vector<std::string> parameters(const size_t count) {
+		std::vector<std::string> names;
+		for (size_t i = 0; i < count; ++i) names.push_back("p" + std::to_string(i));
+		return names;
+	}
+
+	static std::string parameterList(const std::vector<std::string>& names) {
+		std::string list;
+		for (const std::string& name: names) list += (list.empty() ? "int " : ", int ") + name;
+		return list;
+	}
+
+	void ProgramGenerator::function() {
+		const auto params = parameters(1 + below(3));
+		const std::string name = "f" + std::to_string(functionCount);
+		line(0, "fun int " + name + "(" + parameterList(params) + ") {");
+		std::vector<std::string> locals;
+		localCount = 0;
+		statements(1, locals, params, 0);
+		auto names = params;
+		names.insert(names.end(), locals.begin(), locals.end());
+		line(1, "return " + expression(names, options.expressionDepth));
+		line(0, "}");
+		// Only now, a function never calls itself
+		functionArity.push_back(params.size());
+		++functionCount;
+	}
+
+	void ProgramGenerator::classDecl() {
+		const std::string name = "C" + std::to_string(classCount++);
+		line(0, "class " + name + " {");
+		line(1, "privatew int balance = " + std::to_string(below(1000)) + ";");
+		line(1, "protectedw int limit = " + std::to_string(below(1000)) + ";");
+		line(1, "public int id;");
+		if (chance(50)) line(1, "private static int count = 0;");
+		for (size_t method = 0, methods = 1 + below(3); method < methods; ++method) {
+			const auto params = parameters(1 + below(2));
+			line(1, "public fun int m" + std::to_string(method) + "(" + parameterList(params) + ") {");
+			std::vector<std::string> locals;
+			localCount = 0;
+			statements(2, locals, params, 1);
+			auto names = params;
+			names.insert(names.end(), locals.begin(), locals.end());
+			line(2, "return " + expression(names, options.expressionDepth / 2));
+			line(1, "}");
+		}
+		line(0, "}");
+	}
+
+	void ProgramGenerator::structDecl() {
+		line(0, "struct S" + std::to_string(structCount++) + " {");
+		for (size_t field = 0, fields = 2 + below(4); field < fields; ++field) {
+			line(1, "int x" + std::to_string(field) + ";");
+		}
+		line(0, "}");
+	}
+
+	void ProgramGenerator::templateDecl() {
+		const bool sized = chance(50);
+		line(0, std::string(sized ? "template<typename T, int N = 3>" : "template<typename T>") + " class Box" +
+		        std::to_string(templateCount++) + " {");
+		line(1, "public T value;");
+		line(1, "public int size = " + std::to_string(below(100)) + ";");
+		line(0, "}");
+	}
+
+	void ProgramGenerator::actor() {
+		line(0, "actor A" + std::to_string(actorCount++) + " {");
+		for (size_t handler = 0, handlers = 1 + below(3); handler < handlers; ++handler) {
+			const auto params = parameters(1 + below(2));
+			line(1, "on Message" + std::to_string(handler) + "(" + parameterList(params) + ") {");
+			std::vector<std::string> locals;
+			localCount = 0;
+			statements(2, locals, params, 1);
+			line(1, "}");
+		}
+		line(0, "}");
+	}
+
+	void ProgramGenerator::freeObject() {
+		const auto object = [this](const auto& self, const size_t nesting) -> std::string {
+			std::string text = "{";
+			for (size_t field = 0, fields = 1 + below(3); field < fields; ++field) {
+				if (field) text += ", ";
+				text += static_cast<char>('a' + field);
+				text += ": ";
+				if (nesting && chance(30)) text += self(self, nesting - 1);
+				else if (chance(30)) text += "\"s" + std::to_string(below(100)) + "\"";
+				else text += std::to_string(below(1000));
+			}
+			return text + "}";
+		};
+		line(0, "freeobj o" + std::to_string(objectCount++) + " = freeobj " + object(object, 2));
+	}
+
+	void ProgramGenerator::statements(const size_t indent, std::vector<std::string>& locals,
+	                                  const std::vector<std::string>& params, const size_t depth) {
+		for (size_t statement = 0, count = 1 + below(options.statements); statement < count; ++statement) {
+			auto names = params;
+			names.insert(names.end(), locals.begin(), locals.end());
+			if (errorDue()) {
+				brokenStatement(indent, names);
+				continue;
+			}
+			const bool nested = depth < MAX_BLOCK_DEPTH;
+			switch (below(11)) {
+				case 4:
+				case 5:
+					if (!locals.empty()) {
+						line(indent, locals[below(locals.size())] + " = " + expression(names, options.expressionDepth));
+						break;
+					}
+					[[fallthrough]];
+				default: {
+					std::string local = "v" + std::to_string(localCount++);
+					line(indent, "int " + local + " = " + expression(names, options.expressionDepth));
+					locals.push_back(std::move(local));
+					break;
+				}
+				case 6:
+					if (!nested) break;
+					line(indent, "if (" + condition(names) + ") {");
+					{
+						auto inner = locals;
+						statements(indent + 1, inner, params, depth + 1);
+					}
+					if (chance(40)) {
+						line(indent, "} else {");
+						auto inner = locals;
+						statements(indent + 1, inner, params, depth + 1);
+					}
+					line(indent, "}");
+					break;
+				case 7:
+					if (!nested) break;
+					line(indent, "while (" + condition(names) + ") {");
+					{
+						auto inner = locals;
+						statements(indent + 1, inner, params, depth + 1);
+					}
+					line(indent, "}");
+					break;
+				case 8: {
+					if (!nested) break;
+					const std::string i = "i" + std::to_string(localCount++);
+					line(indent, "for (int " + i + " = 0; " + i + " < " + std::to_string(1 + below(100)) + "; " + i +
+					             " = " + i + " + 1) {");
+					auto inner = locals;
+					inner.push_back(i);
+					statements(indent + 1, inner, params, depth + 1);
+					line(indent, "}");
+					break;
+				}
+				case 9:
+					if (!nested) break;
+					line(indent, "do {");
+					{
+						auto inner = locals;
+						statements(indent + 1, inner, params, depth + 1);
+					}
+					line(indent, "} while (" + condition(names) + ")");
+					break;
+				case 10:
+					if (!options.lambdas) break;
+					line(indent, "var l" + std::to_string(localCount++) + " = " + lambda(1 + below(3)));
+					break;
+			}
+		}
+	}
+
+	// One line the parser recovers from at the end of the statement
+	void ProgramGenerator::brokenStatement(const size_t indent, const std::vector<std::string>& names) {
+		const std::string& name = names[below(names.size())];
+		switch (below(3)) {
+			case 0:
+				line(indent, "int e" + std::to_string(localCount++) + " = " +
+				             (functionCount ? "f" + std::to_string(below(functionCount)) : std::string("g")) + "(" +
+				             name + ", )");
+				break;
+			case 1:
+				line(indent, "int e" + std::to_string(localCount++) + " = " + name + " * + 2");
+				break;
+			default:
+				line(indent, "int = " + name);
+				break;
+		}
+		++errorCount;
+		nextError += 1000 / options.errorsPerKLoc;
+	}
+
+	std::string ProgramGenerator::expression(const std::vector<std::string>& names, const size_t depth) {
+		if (depth == 0 || chance(15)) return operand(names, depth);
+		switch (below(6)) {
+			case 0: return expression(names, depth - 1) + " + " + expression(names, depth - 1);
+			case 1: return expression(names, depth - 1) + " - " + expression(names, depth - 1);
+			case 2: return expression(names, depth - 1) + " * " + operand(names, depth - 1);
+			case 3: return "(" + expression(names, depth - 1) + ") / " + std::to_string(1 + below(9));
+			case 4: return "(" + expression(names, depth - 1) + " + " + expression(names, depth - 1) + ")";
+			default: return operand(names, depth);
+		}
+	}
+
+	std::string ProgramGenerator::operand(const std::vector<std::string>& names, const size_t depth) {
+		if (depth > 0 && functionCount && chance(25)) {
+			const size_t callee = below(functionCount);
+			std::string call = "f" + std::to_string(callee) + "(";
+			for (size_t arg = 0; arg < functionArity[callee]; ++arg) {
+				if (arg) call += ", ";
+				call += expression(names, depth - 1);
+			}
+			return call + ")";
+		}
+		if (names.empty() || chance(30)) return std::to_string(below(1000));
+		return names[below(names.size())];
+	}
+
+	std::string ProgramGenerator::condition(const std::vector<std::string>& names) {
+		static const char* const comparisons[] = {" < ", " > ", " <= ", " >= ", " == ", " != "};
+		return expression(names, 1) + comparisons[below(std::size(comparisons))] + expression(names, 1);
+	}
+
+	std::string ProgramGenerator::lambda(const size_t nesting) {
+		std::vector<std::string> params;
+		std::string text;
+		for (size_t level = 0; level < nesting; ++level) {
+			params.push_back("x" + std::to_string(level));
+			text += "(" + params.back() + ") => ";
+		}
+		return text + expression(params, 2);
+	}
+}
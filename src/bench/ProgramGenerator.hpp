@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace zenith {
+	// Deterministic synthetic Zenith programs for scalability testing
+	// Top-level declarations are drawn by weight until the requested line count is reached: functions with loops,
+	// branches and deep expressions, classes with privatew/protectedw fields, structs, class templates, actors with
+	// message handlers and free objects. Functions only call functions declared before them, so a program without
+	// injected errors parses cleanly. The same options give the same program on every platform.
+	class ProgramGenerator {
+	public:
+		struct Options {
+			size_t lines = 1000;
+			uint64_t seed = 1;
+			double errorsPerKLoc = 0; // Statements replaced by a broken one, spaced evenly
+			size_t expressionDepth = 4;
+			size_t statements = 8; // At most, per function
+			bool lambdas = true; // Nested lambdas in function bodies, the analyzer cannot check them yet
+			// Relative weights of the top-level declarations
+			unsigned functions = 8, classes = 2, structs = 1, templates = 1, actors = 1, freeObjects = 1;
+
+			// Only what SemanticAnalyzer handles today, no lambdas
+			static Options analyzable(size_t lines, uint64_t seed = 1);
+		};
+
+		explicit ProgramGenerator(Options options);
+
+		// Writes whole declarations until at least options.lines lines are out, in chunks
+		void write(std::ostream& out);
+		std::string generate();
+
+		[[nodiscard]] size_t lines() const { return lineCount; }
+		[[nodiscard]] size_t injectedErrors() const { return errorCount; }
+
+	private:
+		Options options;
+		uint64_t state;
+		std::string buffer;
+		std::ostream* out = nullptr;
+		size_t lineCount = 0, errorCount = 0;
+		double nextError;
+		size_t functionCount = 0, classCount = 0, structCount = 0, templateCount = 0, actorCount = 0, objectCount = 0;
+		std::vector<size_t> functionArity;
+		size_t localCount = 0; // Locals of the function being generated, names are never reused in one
+
+		uint64_t next();
+		size_t below(size_t n);
+		bool chance(unsigned percent);
+
+		void line(size_t indent, const std::string& text);
+		void flush();
+		bool errorDue() const;
+
+		void declaration();
+		void function();
+		void classDecl();
+		void structDecl();
+		void templateDecl();
+		void actor();
+		void freeObject();
+
+		void statements(size_t indent, std::vector<std::string>& locals, const std::vector<std::string>& params,
+		                size_t depth);
+		void brokenStatement(size_t indent, const std::vector<std::string>& names);
+		std::string expression(const std::vector<std::string>& names, size_t depth);
+		std::string operand(const std::vector<std::string>& names, size_t depth);
+		std::string condition(const std::vector<std::string>& names);
+		std::string lambda(size_t nesting);
+	};
+}
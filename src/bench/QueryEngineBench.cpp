@@ -0,0 +1,95 @@
+// What the query engine recomputes after one edit in a large module
+// Generates an analyzable program, analyzes it once, then makes three edits one after the other and prints for
+// each how every kind of query was brought up to date: reused without running (green), run again with the same
+// result (unchanged), or run with a new one (changed). The edits are a statement added to one function's body,
+// a line added at the top that moves everything, and a parameter type changed in one function's signature.
+// Every result is checked against a fresh engine's.
+//
+//   query_engine_bench [--lines N] [--seed S]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bench/ProgramGenerator.hpp"
+#include "driver/QueryEngine.hpp"
+using namespace zenith;
+
+static size_t argument(const int argc, char* argv[], const std::string& name, const size_t fallback) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (argv[i] == name) return std::strtoull(argv[i + 1], nullptr, 10);
+	}
+	return fallback;
+}
+
+template<typename F>
+static double timed(F&& f) {
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string describe(const std::vector<Diagnostic>& diagnostics) {
+	std::string out;
+	for (const auto& d: diagnostics) {
+		out += std::to_string(d.loc.line) + ":" + std::to_string(d.loc.column) + " " + d.message + "\n";
+	}
+	return out;
+}
+
+static void report(const std::string& title, const QueryEngine& engine, const double ms) {
+	std::cout << title << ", " << std::fixed << std::setprecision(1) << ms << " ms\n"
+		<< "  query            green  unchanged  changed\n";
+	for (size_t i = 1; i < QueryEngine::QUERY_KINDS; ++i) {
+		const auto query = static_cast<QueryEngine::Query>(i);
+		const auto& count = engine.count(query);
+		std::cout << "  " << std::left << std::setw(15) << QueryEngine::queryName(query) << std::right
+			<< std::setw(7) << count.green << std::setw(11) << count.unchanged << std::setw(9) << count.changed << "\n";
+	}
+}
+
+int main(int argc, char* argv[]) {
+	const size_t lines = argument(argc, argv, "--lines", 50000);
+	const uint64_t seed = argument(argc, argv, "--seed", 1);
+	std::string source = ProgramGenerator(ProgramGenerator::Options::analyzable(lines, seed)).generate();
+
+	QueryEngine engine;
+	std::vector<Diagnostic> diagnostics;
+	const double cold = timed([&] {
+		engine.setSource("big.zn", source);
+		diagnostics = engine.diagnostics("big.zn");
+	});
+	report("initial analysis, " + std::to_string(diagnostics.size()) + " diagnostics", engine, cold);
+
+	// The function in the middle of the file
+	const size_t middle = source.find("\nfun int ", source.size() / 2) + 1;
+	const std::string name = source.substr(middle + 8, source.find('(', middle) - middle - 8);
+	auto edit = [&](const std::string& title, const size_t offset, const size_t removed, const std::string& text) {
+		source.replace(offset, removed, text);
+		engine.resetCounts();
+		const double ms = timed([&] {
+			engine.setSource("big.zn", source);
+			diagnostics = engine.diagnostics("big.zn");
+		});
+		std::cout << "\n";
+		report(title, engine, ms);
+		QueryEngine fresh;
+		fresh.setSource("big.zn", source);
+		if (describe(fresh.diagnostics("big.zn")) != describe(diagnostics)) {
+			std::cerr << "The diagnostics after '" << title << "' differ from a fresh engine's" << std::endl;
+			std::exit(1);
+		}
+	};
+
+	edit("statement added to the body of " + name, source.find("\n    return ", middle) + 1, 0,
+	     "    int edited = 0\n");
+	edit("line added at the top", 0, 0, "\n");
+	const size_t parameter = source.find("(int ", source.find("\nfun int " + name + "(")) + 1;
+	edit("parameter type of " + name + " changed", parameter, 3, "long");
+
+	size_t lineCount = 0;
+	for (const char c: source) lineCount += c == '\n';
+	std::cout << "\n" << lineCount << " lines, " << diagnostics.size() << " diagnostics\n";
+	return 0;
+}
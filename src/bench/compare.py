@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compares two zenith_bench JSON results and fails on throughput regressions.
+
+    zenith_bench --benchmark_repetitions=5 --benchmark_out=base.json --benchmark_out_format=json
+    zenith_bench --benchmark_repetitions=5 --benchmark_out=head.json --benchmark_out_format=json
+    src/bench/compare.py base.json head.json [--threshold 5] [--metric cpu_time|real_time]
+
+With repetitions the median of each benchmark is compared, otherwise the mean of its runs. Exits with 1 when a
+benchmark in both files got slower by more than the threshold, in percent.
+"""
+import argparse
+import json
+import statistics
+import sys
+
+
+def load(path, metric):
+    with open(path) as f:
+        benchmarks = json.load(f)["benchmarks"]
+    medians = {b["run_name"]: b[metric] for b in benchmarks
+               if b.get("run_type") == "aggregate" and b.get("aggregate_name") == "median"}
+    if medians:
+        return medians
+    runs = {}
+    for b in benchmarks:
+        if b.get("run_type", "iteration") == "iteration" and "error_occurred" not in b:
+            runs.setdefault(b.get("run_name", b["name"]), []).append(b[metric])
+    return {name: statistics.mean(times) for name, times in runs.items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=5.0, help="allowed slowdown in percent (default 5)")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"), default="cpu_time")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline, args.metric)
+    contender = load(args.contender, args.metric)
+
+    regressions = []
+    width = max((len(name) for name in baseline), default=10)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'contender':>12}  {'change':>8}")
+    for name, before in baseline.items():
+        if name not in contender:
+            print(f"{name:<{width}}  {before:>12.1f}  {'missing':>12}")
+            continue
+        after = contender[name]
+        change = (after - before) / before * 100 if before else 0.0
+        marker = ""
+        if change > args.threshold:
+            regressions.append(name)
+            marker = "  REGRESSION"
+        print(f"{name:<{width}}  {before:>12.1f}  {after:>12.1f}  {change:>+7.1f}%{marker}")
+    for name in contender.keys() - baseline.keys():
+        print(f"{name:<{width}}  {'new':>12}  {contender[name]:>12.1f}")
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) slower by more than {args.threshold}%: {', '.join(regressions)}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Edit-to-diagnostics latency of zenith-lsp on a large file, through a scripted LSP client on stdio.
+
+    src/bench/lsp_latency.py --lsp build/zenith-lsp --gen build/zenith_gen [--lines 50000] [--edits 40] [--budget-ms 50]
+
+Opens one analyzable file of --lines lines, then makes --edits edits one after the other. Each inserts a
+declaration into a random function body, every other one with an undeclared name in it. The latency of an edit is
+the time from sending textDocument/didChange to receiving the textDocument/publishDiagnostics of its version; the
+diagnostics are checked to report exactly the undeclared names inserted so far. Also times hover, go-to-definition
+and document symbols once the edits are in.
+
+Exits with 1 when the 90th percentile of the edit latency is over --budget-ms.
+"""
+import argparse
+import json
+import os
+import queue
+import random
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+
+class Client:
+    def __init__(self, command):
+        self.process = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        self.messages = queue.Queue()
+        self.next_id = 0
+        threading.Thread(target=self._read, daemon=True).start()
+
+    def _read(self):
+        stream = self.process.stdout
+        while True:
+            length = None
+            while True:
+                line = stream.readline()
+                if not line:
+                    self.messages.put(None)
+                    return
+                line = line.strip()
+                if not line:
+                    break
+                name, _, value = line.partition(b":")
+                if name.lower() == b"content-length":
+                    length = int(value)
+            self.messages.put((time.perf_counter(), json.loads(stream.read(length))))
+
+    def send(self, message):
+        body = json.dumps(message).encode()
+        sent = time.perf_counter()
+        self.process.stdin.write(b"Content-Length: %d\r\n\r\n" % len(body) + body)
+        self.process.stdin.flush()
+        return sent
+
+    def notify(self, method, params):
+        return self.send({"jsonrpc": "2.0", "method": method, "params": params})
+
+    def request(self, method, params):
+        self.next_id += 1
+        sent = self.send({"jsonrpc": "2.0", "id": self.next_id, "method": method, "params": params})
+        received, message = self.wait(lambda m: m.get("id") == self.next_id)
+        if "error" in message:
+            sys.exit(f"{method} failed: {message['error']}")
+        return received - sent, message.get("result")
+
+    def wait(self, matches, timeout=60):
+        deadline = time.time() + timeout
+        while True:
+            item = self.messages.get(timeout=max(0.0, deadline - time.time()))
+            if item is None:
+                sys.exit("zenith-lsp exited")
+            if matches(item[1]):
+                return item
+
+
+def published(uri, version):
+    return lambda m: (m.get("method") == "textDocument/publishDiagnostics" and m["params"]["uri"] == uri and
+                      m["params"].get("version") == version)
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * fraction))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--lsp", required=True, help="zenith-lsp")
+    parser.add_argument("--gen", required=True, help="zenith_gen")
+    parser.add_argument("--lines", type=int, default=50000)
+    parser.add_argument("--edits", type=int, default=40)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--budget-ms", type=float, default=50.0)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory(prefix="zenith_lsp_bench") as directory:
+        path = os.path.join(directory, "big.zn")
+        subprocess.run([args.gen, "--lines", str(args.lines), "--seed", str(args.seed), "--analyzable", "--out", path],
+                       check=True, stderr=subprocess.DEVNULL)
+        with open(path) as f:
+            lines = f.read().split("\n")
+
+    uri = "file:///bench/big.zn"
+    client = Client([args.lsp])
+    client.request("initialize", {"processId": None, "rootUri": None, "capabilities": {}})
+    client.notify("initialized", {})
+    sent = client.notify("textDocument/didOpen", {"textDocument": {
+        "uri": uri, "languageId": "zenith", "version": 1, "text": "\n".join(lines)}})
+    received, message = client.wait(published(uri, 1))
+    if message["params"]["diagnostics"]:
+        sys.exit(f"the generated file has diagnostics: {message['params']['diagnostics'][:3]}")
+    open_ms = (received - sent) * 1000
+
+    # Lines a declaration can go in front of: the statements directly in a function body
+    rng = random.Random(args.seed)
+    latencies = []
+    undeclared = set()
+    for edit in range(args.edits):
+        candidates = [i for i, line in enumerate(lines) if line.startswith("    return ")]
+        at = rng.choice(candidates)
+        name = f"missing{edit}" if edit % 2 == 0 else "0"
+        text = f"    int edited{edit} = {name}\n"
+        lines.insert(at, text[:-1])
+        if edit % 2 == 0:
+            undeclared.add(name)
+        version = edit + 2
+        sent = client.notify("textDocument/didChange", {
+            "textDocument": {"uri": uri, "version": version},
+            "contentChanges": [{"range": {"start": {"line": at, "character": 0}, "end": {"line": at, "character": 0}},
+                                "text": text}]})
+        received, message = client.wait(published(uri, version))
+        latencies.append((received - sent) * 1000)
+        reported = {m.group(1) for d in message["params"]["diagnostics"]
+                    for m in [re.search(r"'(missing\d+)'", d["message"])] if m}
+        if reported != undeclared:
+            sys.exit(f"edit {edit}: diagnostics name {sorted(reported)}, expected {sorted(undeclared)}")
+
+    # Queries on the last function the edits went into
+    line = next(i for i, text in enumerate(lines) if text.startswith(f"    int edited{args.edits - 1} "))
+    position = {"line": line, "character": len("    int ")}
+    document = {"uri": uri}
+    hover_s, hover = client.request("textDocument/hover", {"textDocument": document, "position": position})
+    definition_s, definition = client.request("textDocument/definition", {"textDocument": document, "position": position})
+    symbols_s, symbols = client.request("textDocument/documentSymbol", {"textDocument": document})
+    if not hover or not definition or not symbols:
+        sys.exit("a query came back empty")
+    client.request("shutdown", None)
+    client.notify("exit", None)
+    client.process.wait(timeout=30)
+
+    p50, p90 = statistics.median(latencies), percentile(latencies, 0.9)
+    print(f"{len(lines)} lines, {args.edits} edits")
+    print(f"open             {open_ms:8.1f} ms")
+    print(f"edit median      {p50:8.1f} ms")
+    print(f"edit p90         {p90:8.1f} ms  (budget {args.budget_ms:g} ms)")
+    print(f"edit max         {max(latencies):8.1f} ms")
+    print(f"hover            {hover_s * 1000:8.1f} ms")
+    print(f"definition       {definition_s * 1000:8.1f} ms")
+    print(f"document symbols {symbols_s * 1000:8.1f} ms  ({len(symbols)} top-level)")
+    return 0 if p90 <= args.budget_ms else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Per-phase time and memory against input size, from a zenith_bench JSON result.
+
+    zenith_bench --benchmark_filter=Scaling --scale-max 10000000 --benchmark_out=time.json --benchmark_out_format=json
+    zenith_bench --benchmark_filter=Scaling --scale-max 10000000 --memory --benchmark_out=mem.json --benchmark_out_format=json
+    src/bench/plot_scaling.py time.json [mem.json] [--png scaling.png]
+
+Prints one CSV row per phase and size. With --png and matplotlib installed it also draws time and, when a
+--memory result is given, allocated bytes on log-log axes.
+"""
+import argparse
+import csv
+import json
+import re
+import sys
+
+NAME = re.compile(r"^Scaling/(\w+)/lines:(\d+)")
+TO_MS = {"ns": 1e-6, "us": 1e-3, "ms": 1.0, "s": 1e3}
+
+
+def rows(path):
+    with open(path) as f:
+        benchmarks = json.load(f)["benchmarks"]
+    result = {}
+    for b in benchmarks:
+        match = NAME.match(b["name"])
+        if not match or b.get("run_type", "iteration") != "iteration":
+            continue
+        phase, size = match.group(1), int(match.group(2))
+        result[(phase, size)] = {
+            "lines": int(b.get("lines", size)),
+            "ms": b["real_time"] * TO_MS[b.get("time_unit", "ns")],
+            "allocated_bytes": b.get("allocated_bytes"),
+            "live_bytes": b.get("live_bytes"),
+        }
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("time")
+    parser.add_argument("memory", nargs="?", help="a run with --memory, its times are not used")
+    parser.add_argument("--png")
+    args = parser.parse_args()
+
+    times = rows(args.time)
+    memory = rows(args.memory) if args.memory else times
+    writer = csv.writer(sys.stdout)
+    writer.writerow(["phase", "lines", "ms", "allocated_bytes", "live_bytes"])
+    for key in sorted(times):
+        mem = memory.get(key, {})
+        writer.writerow([key[0], times[key]["lines"], f"{times[key]['ms']:.3f}"] +
+                        [int(mem[counter]) if mem.get(counter) is not None else "" for counter in ("allocated_bytes", "live_bytes")])
+
+    if not args.png:
+        return 0
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("matplotlib is not installed, no plot written", file=sys.stderr)
+        return 1
+    phases = sorted({phase for phase, _ in times})
+    has_memory = any(row.get("allocated_bytes") for row in memory.values())
+    figure, axes = plt.subplots(1, 2 if has_memory else 1, figsize=(12 if has_memory else 6, 4.5), squeeze=False)
+    for phase in phases:
+        sizes = sorted(size for p, size in times if p == phase)
+        lines = [times[(phase, size)]["lines"] for size in sizes]
+        axes[0][0].plot(lines, [times[(phase, size)]["ms"] for size in sizes], marker="o", label=phase)
+        if has_memory:
+            axes[0][1].plot(lines, [memory.get((phase, size), {}).get("allocated_bytes") or 0 for size in sizes],
+                            marker="o", label=phase)
+    axes[0][0].set(xscale="log", yscale="log", xlabel="lines", ylabel="ms", title="time")
+    if has_memory:
+        axes[0][1].set(xscale="log", yscale="log", xlabel="lines", ylabel="bytes", title="allocated")
+    for axis in axes[0]:
+        axis.legend()
+        axis.grid(True, which="both", alpha=0.3)
+    figure.tight_layout()
+    figure.savefig(args.png)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
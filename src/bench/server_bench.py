@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Build times with one Zenith process per file against a warm compile server (--server).
+
+    src/bench/server_bench.py --zenith build/Zenith --gen build/zenith_gen [--files 200] [--lines 300] [--changed 5]
+
+Generates a project of analyzable files, then times each build step the way a build system runs it, one
+invocation per file:
+
+    full         every file, the server's cache still empty
+    touched      every file with a new modification time but the same text, e.g. after a checkout
+    incremental  only the changed files, after --changed percent of them were edited
+    rebuild-all  every file after the edit, a build system that does not track dependencies
+
+Each step runs once with cold processes and once through --connect. The table shows wall-clock seconds for both.
+"""
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def build(zenith, files, socket=None):
+    start = time.perf_counter()
+    for path in files:
+        command = [zenith] + ([f"--connect={socket}"] if socket else []) + [path]
+        result = subprocess.run(command, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, stdin=subprocess.DEVNULL)
+        if result.returncode != 0:
+            sys.exit(f"{' '.join(command)} failed:\n{result.stderr.decode()}")
+        if socket and b"compiling in this process" in result.stderr:
+            sys.exit("the compile server is not answering")
+    return time.perf_counter() - start
+
+
+def wait_for(socket, server):
+    for _ in range(200):
+        if os.path.exists(socket):
+            return
+        if server.poll() is not None:
+            sys.exit("the compile server exited")
+        time.sleep(0.05)
+    sys.exit("the compile server did not come up")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--zenith", required=True)
+    parser.add_argument("--gen", required=True, help="zenith_gen")
+    parser.add_argument("--files", type=int, default=200)
+    parser.add_argument("--lines", type=int, default=300)
+    parser.add_argument("--changed", type=float, default=5.0, help="percent of files edited (default 5)")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory(prefix="zenith_server_bench") as directory:
+        files = []
+        for i in range(args.files):
+            path = os.path.join(directory, f"module{i}.zn")
+            subprocess.run([args.gen, "--lines", str(args.lines), "--seed", str(i + 1), "--analyzable", "--out", path],
+                           check=True, stderr=subprocess.DEVNULL)
+            files.append(path)
+        changed = files[:max(1, round(len(files) * args.changed / 100))]
+        socket = os.path.join(directory, "zenith.sock")
+        server = subprocess.Popen([args.zenith, f"--server={socket}"], stderr=subprocess.DEVNULL)
+        try:
+            wait_for(socket, server)
+            rows = [("full", build(args.zenith, files), build(args.zenith, files, socket))]
+            for path in files:
+                os.utime(path)
+            rows.append(("touched", build(args.zenith, files), build(args.zenith, files, socket)))
+            for path in changed:
+                with open(path, "a") as f:
+                    f.write("int editedConstant = 1\n")
+            # The first pass through the server compiles the edits, so the cold build goes second here
+            incremental_server = build(args.zenith, changed, socket)
+            rows.append(("incremental", build(args.zenith, changed), incremental_server))
+            rows.append(("rebuild-all", build(args.zenith, files), build(args.zenith, files, socket)))
+        finally:
+            subprocess.run([args.zenith, f"--stop-server={socket}"], stderr=subprocess.DEVNULL)
+            server.wait(timeout=30)
+
+    print(f"{args.files} files of {args.lines} lines, {len(changed)} edited")
+    print(f"{'step':<12} {'files':>6} {'cold s':>9} {'server s':>9} {'speedup':>8}")
+    for step, cold, warm in rows:
+        count = len(changed) if step == "incremental" else len(files)
+        print(f"{step:<12} {count:>6} {cold:>9.3f} {warm:>9.3f} {cold / warm:>7.1f}x")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,94 @@
+// Symbol table, polymorphic and small_vector operations on their own
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "ast/Expressions.hpp"
+#include "core/polymorphic.hpp"
+#include "SemanticAnalysis/SymbolTable.hpp"
+#include "exceptions/DiagnosticsEngine.hpp"
+#include "utils/small_vector.hpp"
+
+namespace zenith::bench {
+	static std::vector<std::string> names(const size_t count) {
+		std::vector<std::string> result;
+		for (size_t i = 0; i < count; ++i) result.push_back("symbol" + std::to_string(i));
+		return result;
+	}
+
+	// range(0) symbols into one fresh scope
+	static void BM_SymbolTableDeclare(benchmark::State& state) {
+		const auto symbols = names(state.range(0));
+		DiagnosticsEngine diagnostics;
+		ErrorReporter reporter(diagnostics);
+		for (auto _: state) {
+			SymbolTable table(reporter);
+			for (const std::string& name: symbols) table.declare(name, SymbolInfo());
+			benchmark::DoNotOptimize(table.symbolCount());
+		}
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * symbols.size()));
+	}
+	BENCHMARK(BM_SymbolTableDeclare)->Arg(16)->Arg(1024);
+
+	// Every name looked up through range(0) nested scopes, each declaring eight of them
+	static void BM_SymbolTableLookup(benchmark::State& state) {
+		const auto symbols = names(8 * state.range(0));
+		DiagnosticsEngine diagnostics;
+		ErrorReporter reporter(diagnostics);
+		SymbolTable table(reporter);
+		for (size_t i = 0; i < symbols.size(); ++i) {
+			if (i && i % 8 == 0) table.enterScope();
+			table.declare(symbols[i], SymbolInfo());
+		}
+		for (auto _: state) {
+			for (const std::string& name: symbols) benchmark::DoNotOptimize(table.lookup(name));
+		}
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * symbols.size()));
+	}
+	BENCHMARK(BM_SymbolTableLookup)->Arg(1)->Arg(16);
+
+	static void BM_PolymorphicMake(benchmark::State& state) {
+		for (auto _: state) {
+			auto node = make_node<VarNode, ExprNode>(SourceLocation{}, "x");
+			benchmark::DoNotOptimize(node.get());
+		}
+	}
+	BENCHMARK(BM_PolymorphicMake);
+
+	// The checked downcast the analyzer and the passes do, range(0) is whether it succeeds
+	static void BM_PolymorphicCast(benchmark::State& state) {
+		const polymorphic<ExprNode> node = state.range(0)
+			? make_node<VarNode, ExprNode>(SourceLocation{}, "x")
+			: make_node<LiteralNode, ExprNode>(SourceLocation{}, LiteralNode::NUMBER, "1");
+		for (auto _: state) {
+			auto var = node.cast().non_throwing().to<VarNode>();
+			benchmark::DoNotOptimize(var.get());
+		}
+	}
+	BENCHMARK(BM_PolymorphicCast)->ArgName("hit")->Arg(0)->Arg(1);
+
+	// range(0) push_backs into a small_vector with room for four inline
+	static void BM_SmallVectorPushBack(benchmark::State& state) {
+		for (auto _: state) {
+			small_vector<int, 4> v;
+			for (int64_t i = 0; i < state.range(0); ++i) v.push_back(static_cast<int>(i));
+			benchmark::DoNotOptimize(v.data());
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_SmallVectorPushBack)->Arg(4)->Arg(64);
+
+	// Growth past the inline buffer relocates the nodes, with memcpy as polymorphic is trivially relocatable
+	static void BM_SmallVectorRelocate(benchmark::State& state) {
+		std::vector<polymorphic<ExprNode>> nodes;
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			nodes.push_back(make_node<VarNode, ExprNode>(SourceLocation{}, "a" + std::to_string(i)));
+		}
+		for (auto _: state) {
+			small_vector<polymorphic<ExprNode>, 4> arguments;
+			for (auto& node: nodes) arguments.push_back(std::move(node));
+			for (size_t i = 0; i < nodes.size(); ++i) nodes[i] = std::move(arguments[i]);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_SmallVectorRelocate)->Arg(4)->Arg(64);
+}
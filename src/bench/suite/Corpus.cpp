@@ -0,0 +1,33 @@
+#include "Corpus.hpp"
+#include <algorithm>
+#include <filesystem>
+#include "utils/ReadFile.hpp"
+#include "bench/ProgramGenerator.hpp"
+
+namespace zenith::bench {
+	static size_t lineCount(const std::string& source) {
+		return std::ranges::count(source, '\n') + (!source.empty() && source.back() != '\n');
+	}
+
+	std::vector<Corpus> corpora(const std::string& directory, const size_t generatedLines) {
+		std::vector<std::filesystem::path> files;
+		if (std::filesystem::is_directory(directory)) {
+			for (const auto& entry: std::filesystem::directory_iterator(directory)) {
+				if (entry.path().extension() == ".zn") files.push_back(entry.path());
+			}
+		}
+		std::ranges::sort(files);
+
+		std::vector<Corpus> result;
+		for (const auto& file: files) {
+			std::string source = readFile(file.string());
+			const size_t lines = lineCount(source);
+			const std::string name = file.stem().string();
+			result.push_back({name, std::move(source), lines, !name.starts_with("recovery")});
+		}
+		ProgramGenerator generator(ProgramGenerator::Options::analyzable(generatedLines));
+		std::string source = generator.generate();
+		result.push_back({"generated", std::move(source), generator.lines()});
+		return result;
+	}
+}
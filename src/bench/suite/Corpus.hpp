@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace zenith::bench {
+	// Source a benchmark runs over, either read from src/bench/corpus or generated
+	struct Corpus {
+		std::string name;
+		std::string source;
+		size_t lines = 0;
+		bool analyzable = true; // Parses without errors, so the analyzer can run on it
+	};
+
+	// The *.zn files of directory, sorted by name, followed by an analyzable ProgramGenerator program of
+	// generatedLines lines
+	// A checked-in file whose name starts with "recovery" has syntax errors on purpose.
+	std::vector<Corpus> corpora(const std::string& directory, size_t generatedLines);
+
+	// Lexer, parser and analyzer benchmarks for each corpus, in FrontendBench.cpp
+	void registerFrontend(const std::vector<Corpus>& corpora);
+	// Each phase over generated programs of 1000 lines and ten times as many up to maxLines, in ScalingBench.cpp
+	void registerScaling(size_t maxLines);
+}
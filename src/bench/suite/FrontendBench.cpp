@@ -0,0 +1,124 @@
+// Lexer, parser and analyzer throughput over every corpus, and keyword lookup and expression parsing on their own
+#include <benchmark/benchmark.h>
+#include <array>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Corpus.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "SemanticAnalysis/SemanticAnalyzer.hpp"
+#include "exceptions/DiagnosticsEngine.hpp"
+#include "utils/mainargs.hpp"
+
+namespace zenith::bench {
+	static std::vector<Token> lex(const std::string& source) {
+		return Lexer(source, "<bench>").tokenize();
+	}
+
+	// Bytes and lines per second of source, and items per second of tokens
+	static void throughput(benchmark::State& state, const Corpus& corpus, const size_t tokens) {
+		state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * corpus.source.size()));
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tokens));
+		state.counters["lines"] = benchmark::Counter(static_cast<double>(corpus.lines),
+		                                             benchmark::Counter::kIsIterationInvariantRate);
+	}
+
+	static void tokenize(benchmark::State& state, const Corpus& corpus) {
+		size_t tokens = 0;
+		for (auto _: state) {
+			auto result = lex(corpus.source);
+			tokens = result.size();
+			benchmark::DoNotOptimize(result.data());
+		}
+		throughput(state, corpus, tokens);
+	}
+
+	static void parse(benchmark::State& state, const Corpus& corpus) {
+		const std::vector<Token> tokens = lex(corpus.source);
+		const Flags flags;
+		std::ostream discard(nullptr);
+		polymorphic<ProgramNode> program;
+		for (auto _: state) {
+			state.PauseTiming(); // The copy of the tokens and freeing the last tree are not the parser's work
+			std::vector<Token> copy = tokens;
+			program = nullptr;
+			DiagnosticsEngine diagnostics;
+			ErrorReporter reporter(diagnostics);
+			state.ResumeTiming();
+			program = Parser(std::move(copy), flags, reporter, discard).parse();
+			benchmark::DoNotOptimize(program.get());
+		}
+		throughput(state, corpus, tokens.size());
+	}
+
+	static void analyze(benchmark::State& state, const Corpus& corpus) {
+		const std::vector<Token> tokens = lex(corpus.source);
+		const Flags flags;
+		std::ostream discard(nullptr);
+		for (auto _: state) {
+			state.PauseTiming(); // Analysis fills in the tree, every iteration needs a fresh one
+			DiagnosticsEngine diagnostics;
+			ErrorReporter reporter(diagnostics);
+			auto program = Parser(tokens, flags, reporter, discard).parse();
+			state.ResumeTiming();
+			{
+				SemanticAnalyzer analyzer(reporter);
+				SymbolTable&& symbols = analyzer.analyze(program);
+				benchmark::DoNotOptimize(symbols);
+			}
+			state.PauseTiming();
+			program = nullptr;
+			state.ResumeTiming();
+		}
+		throughput(state, corpus, tokens.size());
+	}
+
+	void registerFrontend(const std::vector<Corpus>& corpora) {
+		for (const Corpus& corpus: corpora) {
+			benchmark::RegisterBenchmark(("Lexer/tokenize/" + corpus.name).c_str(), tokenize, corpus);
+			benchmark::RegisterBenchmark(("Parser/parse/" + corpus.name).c_str(), parse, corpus);
+			if (corpus.analyzable) {
+				benchmark::RegisterBenchmark(("SemanticAnalyzer/analyze/" + corpus.name).c_str(), analyze, corpus);
+			}
+		}
+	}
+
+	// Eight keywords and eight identifiers
+	static void BM_KeywordLookup(benchmark::State& state) {
+		static const std::array<std::string, 16> words{
+			"fun", "var", "while", "return", "if", "else", "class", "struct",
+			"x", "total", "clamp", "fibonacci", "i", "value", "counter", "lookupTable"
+		};
+		for (auto _: state) {
+			for (const std::string& word: words) benchmark::DoNotOptimize(Lexer::wordType(word));
+		}
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * words.size()));
+	}
+	BENCHMARK(BM_KeywordLookup);
+
+	// One expression of range(0) binary operators over calls, parenthesised groups and literals
+	static void BM_ParseExpression(benchmark::State& state) {
+		std::ostringstream source;
+		source << "a0";
+		for (int64_t i = 1; i <= state.range(0); ++i) {
+			switch (i % 4) {
+				case 0: source << " + f(a" << i << ", " << i << ")"; break;
+				case 1: source << " * (b" << i << " - 2)"; break;
+				case 2: source << " < " << i; break;
+				default: source << " / c" << i; break;
+			}
+		}
+		const std::vector<Token> tokens = lex(source.str());
+		const Flags flags;
+		std::ostream discard(nullptr);
+		DiagnosticsEngine diagnostics;
+		ErrorReporter reporter(diagnostics);
+		for (auto _: state) {
+			auto expression = Parser(tokens, flags, reporter, discard).parseExpressionOnly();
+			benchmark::DoNotOptimize(expression.get());
+		}
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tokens.size()));
+	}
+	BENCHMARK(BM_ParseExpression)->Arg(8)->Arg(64)->Arg(512);
+}
@@ -0,0 +1,172 @@
+// Time and memory of each phase against input size, on analyzable ProgramGenerator programs
+// With --memory the bytes a phase allocates and keeps are measured by MemoryAccounting in one extra, untimed run.
+// Accounting slows down node allocation a little, time and memory are best taken in separate runs.
+// sequential and pipelined time lexing, parsing and analysis together, wall clock since pipelined runs three threads.
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "Corpus.hpp"
+#include "bench/ProgramGenerator.hpp"
+#include "driver/Pipeline.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "SemanticAnalysis/SemanticAnalyzer.hpp"
+#include "exceptions/DiagnosticsEngine.hpp"
+#include "utils/MemoryAccounting.hpp"
+#include "utils/mainargs.hpp"
+
+namespace zenith::bench {
+	namespace {
+		using Category = MemoryAccounting::Category;
+
+		// Allocated and live bytes over every category, between construction and take()
+		class MemoryDelta {
+			int64_t allocated = 0, live = 0;
+
+			static void sum(int64_t& allocated, int64_t& live) {
+				allocated = live = 0;
+				for (size_t c = 0; c < static_cast<size_t>(Category::COUNT); ++c) {
+					const auto totals = MemoryAccounting::totals(static_cast<Category>(c));
+					allocated += totals.bytes;
+					live += totals.live;
+				}
+			}
+
+		public:
+			MemoryDelta() { sum(allocated, live); }
+
+			void take(benchmark::State& state) const {
+				int64_t allocatedNow, liveNow;
+				sum(allocatedNow, liveNow);
+				state.counters["allocated_bytes"] = static_cast<double>(allocatedNow - allocated);
+				state.counters["live_bytes"] = static_cast<double>(liveNow - live);
+			}
+		};
+
+		struct Input {
+			std::string source;
+			size_t lines;
+		};
+
+		Input input(const size_t lines) {
+			ProgramGenerator generator(ProgramGenerator::Options::analyzable(lines));
+			std::string source = generator.generate();
+			return {std::move(source), generator.lines()};
+		}
+
+		void lines(benchmark::State& state, const Input& in) {
+			state.counters["lines"] = static_cast<double>(in.lines);
+			state.counters["lines_per_second"] = benchmark::Counter(static_cast<double>(in.lines),
+			                                                        benchmark::Counter::kIsIterationInvariantRate);
+		}
+
+		polymorphic<ProgramNode> parse(std::vector<Token> tokens, ErrorReporter& reporter) {
+			static const Flags flags;
+			std::ostream discard(nullptr);
+			return Parser(std::move(tokens), flags, reporter, discard).parse();
+		}
+
+		void lex(benchmark::State& state, const size_t size) {
+			const Input in = input(size);
+			for (auto _: state) {
+				auto tokens = Lexer(in.source, "<bench>").tokenize();
+				benchmark::DoNotOptimize(tokens.data());
+			}
+			lines(state, in);
+			if (MemoryAccounting::enabled()) {
+				const MemoryDelta memory;
+				const auto tokens = Lexer(in.source, "<bench>").tokenize();
+				memory.take(state);
+			}
+		}
+
+		void parsePhase(benchmark::State& state, const size_t size) {
+			const Input in = input(size);
+			const auto tokens = Lexer(in.source, "<bench>").tokenize();
+			polymorphic<ProgramNode> program;
+			for (auto _: state) {
+				state.PauseTiming();
+				std::vector<Token> copy = tokens;
+				program = nullptr;
+				DiagnosticsEngine diagnostics;
+				ErrorReporter reporter(diagnostics);
+				state.ResumeTiming();
+				program = parse(std::move(copy), reporter);
+			}
+			program = nullptr;
+			lines(state, in);
+			if (MemoryAccounting::enabled()) {
+				DiagnosticsEngine diagnostics;
+				ErrorReporter reporter(diagnostics);
+				std::vector<Token> copy = tokens;
+				const MemoryDelta memory;
+				program = parse(std::move(copy), reporter);
+				memory.take(state);
+			}
+		}
+
+		void analyzePhase(benchmark::State& state, const size_t size) {
+			const Input in = input(size);
+			const auto tokens = Lexer(in.source, "<bench>").tokenize();
+			for (auto _: state) {
+				state.PauseTiming();
+				DiagnosticsEngine diagnostics;
+				ErrorReporter reporter(diagnostics);
+				auto program = parse(tokens, reporter);
+				state.ResumeTiming();
+				{
+					SemanticAnalyzer analyzer(reporter);
+					SymbolTable&& symbols = analyzer.analyze(program);
+					benchmark::DoNotOptimize(symbols);
+				}
+				state.PauseTiming();
+				program = nullptr;
+				state.ResumeTiming();
+			}
+			lines(state, in);
+			if (MemoryAccounting::enabled()) {
+				DiagnosticsEngine diagnostics;
+				ErrorReporter reporter(diagnostics);
+				auto program = parse(tokens, reporter);
+				SemanticAnalyzer analyzer(reporter);
+				const MemoryDelta memory;
+				SymbolTable&& symbols = analyzer.analyze(program);
+				memory.take(state);
+				benchmark::DoNotOptimize(symbols);
+			}
+		}
+
+		// Lex, parse and analyze from source, one phase after the other or with the first three overlapping (--pipeline)
+		void frontEnd(benchmark::State& state, const size_t size, const bool pipelined) {
+			const Input in = input(size);
+			static const Flags flags;
+			for (auto _: state) {
+				DiagnosticsEngine diagnostics;
+				ErrorReporter reporter(diagnostics);
+				std::ostream discard(nullptr);
+				SemanticAnalyzer analyzer(reporter);
+				polymorphic<ProgramNode> program;
+				if (pipelined) program = Pipeline(flags, reporter, discard, {}).run(in.source, "<bench>", analyzer);
+				else program = parse(Lexer(in.source, "<bench>").tokenize(), reporter);
+				SymbolTable&& symbols = analyzer.analyze(program);
+				benchmark::DoNotOptimize(symbols);
+			}
+			lines(state, in);
+		}
+	}
+
+	void registerScaling(const size_t maxLines) {
+		for (size_t size = 1000; size <= maxLines; size *= 10) {
+			const std::string suffix = "/lines:" + std::to_string(size);
+			benchmark::RegisterBenchmark(("Scaling/lex" + suffix).c_str(), lex, size)->Unit(benchmark::kMillisecond);
+			benchmark::RegisterBenchmark(("Scaling/parse" + suffix).c_str(), parsePhase, size)
+				->Unit(benchmark::kMillisecond);
+			benchmark::RegisterBenchmark(("Scaling/analyze" + suffix).c_str(), analyzePhase, size)
+				->Unit(benchmark::kMillisecond);
+			benchmark::RegisterBenchmark(("Scaling/sequential" + suffix).c_str(), frontEnd, size, false)
+				->Unit(benchmark::kMillisecond)->UseRealTime();
+			benchmark::RegisterBenchmark(("Scaling/pipelined" + suffix).c_str(), frontEnd, size, true)
+				->Unit(benchmark::kMillisecond)->UseRealTime();
+		}
+	}
+}
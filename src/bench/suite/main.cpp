@@ -0,0 +1,46 @@
+// Microbenchmarks of the compiler front end, built on Google Benchmark
+// Corpus benchmarks run over every *.zn file in src/bench/corpus and one generated corpus of --lines lines, the
+// Scaling benchmarks over generated programs of 1000 lines up to --scale-max. --memory adds the bytes each Scaling
+// phase allocates. Every --benchmark_* flag works as usual; --benchmark_out=<file> --benchmark_out_format=json writes
+// the results for src/bench/compare.py and src/bench/plot_scaling.py.
+//
+//   zenith_bench [--lines N] [--scale-max N] [--memory] [--corpus-dir DIR] [--benchmark_filter=REGEX] ...
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <string>
+#include "Corpus.hpp"
+#include "utils/MemoryAccounting.hpp"
+
+#ifndef ZENITH_BENCH_CORPUS_DIR
+#define ZENITH_BENCH_CORPUS_DIR "src/bench/corpus"
+#endif
+
+static std::string argument(const int argc, char* argv[], const std::string& name, const std::string& fallback) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (argv[i] == name) return argv[i + 1];
+	}
+	return fallback;
+}
+
+static bool flag(const int argc, char* argv[], const std::string& name) {
+	for (int i = 1; i < argc; ++i) {
+		if (argv[i] == name) return true;
+	}
+	return false;
+}
+
+int main(int argc, char* argv[]) {
+	benchmark::Initialize(&argc, argv); // Takes out its own flags
+	const size_t lines = std::strtoull(argument(argc, argv, "--lines", "10000").c_str(), nullptr, 10);
+	const size_t scaleMax = std::strtoull(argument(argc, argv, "--scale-max", "100000").c_str(), nullptr, 10);
+	const std::string directory = argument(argc, argv, "--corpus-dir", ZENITH_BENCH_CORPUS_DIR);
+	if (flag(argc, argv, "--memory")) zenith::MemoryAccounting::start();
+
+	zenith::bench::registerFrontend(zenith::bench::corpora(directory, lines));
+	zenith::bench::registerScaling(scaleMax);
+	benchmark::AddCustomContext("corpus lines", std::to_string(lines));
+	benchmark::AddCustomContext("memory accounting", zenith::MemoryAccounting::enabled() ? "on" : "off");
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
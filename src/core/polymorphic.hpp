@@ -23,6 +23,8 @@ namespace zenith {
 
     public:
         using value_type = T;
+        // Only a shared_ptr, containers may move it with memcpy
+        using trivially_relocatable = std::true_type;
 
         // Default constructor
         polymorphic() = default;
@@ -36,6 +38,12 @@ namespace zenith {
         explicit polymorphic(std::in_place_type_t<U>, Args&&... args)
             : ptr_(std::make_shared<U>(std::forward<Args>(args)...)) {}
 
+        // Construct from derived type, allocated together with the control block through alloc
+        template<typename U, typename Alloc, typename... Args>
+            requires std::derived_from<U, T> && std::constructible_from<U, Args...>
+        polymorphic(std::allocator_arg_t, const Alloc& alloc, std::in_place_type_t<U>, Args&&... args)
+            : ptr_(std::allocate_shared<U>(alloc, std::forward<Args>(args)...)) {}
+
         // Construct from U
         template<typename U>
             requires std::derived_from<U, T> &&
@@ -242,6 +250,11 @@ namespace zenith {
         return polymorphic<Base>(std::in_place_type<Concrete>, std::forward<Args>(args)...);
     }
 
+    template<typename Concrete, typename Base = Concrete, typename Alloc, typename... Args>
+    polymorphic<Base> allocate_polymorphic(const Alloc& alloc, Args&&... args) {
+        return polymorphic<Base>(std::allocator_arg, alloc, std::in_place_type<Concrete>, std::forward<Args>(args)...);
+    }
+
     template<typename To, typename From>
     polymorphic<To> polymorphic_cast(polymorphic<From>&& p) {
         return std::move(p).template cast<To>().template to<To>();
@@ -118,9 +118,9 @@ namespace zenith {
             template<typename To>
             polymorphic_ref<To> to() && {
                 if (is_const_) {
-                    return do_const_cast<To>();
+                    return do_const_cast<To>(throw_on_fail_);
                 }
-                return do_non_const_cast<To>();
+                return do_non_const_cast<To>(throw_on_fail_);
             }
 
             template<typename To>
@@ -168,8 +168,11 @@ namespace zenith {
                         if (throw_on_fail) throw std::bad_cast();
                         return nullptr;
                     }
-                } else {
+                } else if constexpr (requires(T* p) { static_cast<To*>(p); }) {
                     casted = static_cast<To*>(const_cast<T*>(const_self_.ptr_));
+                } else {
+                    // Downcast through a virtual base, only dynamic_cast can do it
+                    casted = dynamic_cast<To*>(const_cast<T*>(const_self_.ptr_));
                 }
                 return polymorphic_ref<To>(casted);
             }
@@ -187,8 +190,11 @@ namespace zenith {
                         if (throw_on_fail) throw std::bad_cast();
                         return nullptr;
                     }
-                } else {
+                } else if constexpr (requires(T* p) { static_cast<To*>(p); }) {
                     casted = static_cast<To*>(self_.ptr_);
+                } else {
+                    // Downcast through a virtual base, only dynamic_cast can do it
+                    casted = dynamic_cast<To*>(self_.ptr_);
                 }
 
                 return polymorphic_ref<To>(casted);
@@ -0,0 +1,84 @@
+#include "CompileCache.hpp"
+#include <chrono>
+#include <system_error>
+#include "../utils/Hash.hpp"
+#include "../utils/ReadFile.hpp"
+
+namespace zenith {
+	namespace {
+		// A file written within this long of its stat may still change without its modification time moving on
+		constexpr auto racyWindow = std::chrono::seconds(2);
+	}
+
+	std::string CompileCache::key(const Flags& flags) {
+		std::string key;
+		for (const bool flag: {flags.bracesRequired, flags.escapeReport, flags.shapeReport, flags.lazyParsing}) {
+			key += flag ? '1' : '0';
+		}
+		key += std::to_string(static_cast<int>(flags.target)) + "," + std::to_string(static_cast<int>(flags.gc)) + "," +
+		       std::to_string(static_cast<int>(flags.diagnosticsFormat)) + "," + std::to_string(flags.maxErrors) + "," +
+		       flags.astCache;
+		return key;
+	}
+
+	bool CompileCache::cacheable(const Flags& flags) {
+		return !flags.dumpLogs && flags.timeTrace.empty() && !flags.memReport;
+	}
+
+	CompileCache::Source CompileCache::read(const std::string& file) {
+		std::error_code error;
+		const auto mtime = std::filesystem::last_write_time(file, error);
+		const uintmax_t size = error ? 0 : std::filesystem::file_size(file, error);
+		if (!error) {
+			std::lock_guard lock(mutex);
+			if (const auto it = files.find(file); it != files.end() && it->second.trusted &&
+			                                      it->second.mtime == mtime && it->second.size == size) {
+				++counts.unchanged;
+				return it->second.source;
+			}
+		}
+
+		auto text = std::make_shared<const std::string>(readFile(file));
+		Source source{text, (Hash() << *text).value};
+		if (error) return source; // Not worth remembering without a stat to check it against
+		const bool trusted = std::filesystem::file_time_type::clock::now() - mtime > racyWindow;
+		std::lock_guard lock(mutex);
+		++counts.reads;
+		Entry& entry = files[file];
+		entry.mtime = mtime;
+		entry.size = size;
+		entry.trusted = trusted;
+		entry.source = source;
+		return source;
+	}
+
+	std::optional<CompileCache::Result> CompileCache::find(const std::string& file, const Source& source,
+	                                                       const Flags& flags) {
+		std::lock_guard lock(mutex);
+		if (const auto it = files.find(file); it != files.end()) {
+			if (const auto result = it->second.results.find(key(flags));
+				result != it->second.results.end() && result->second.first == source.hash) {
+				++counts.hits;
+				return result->second.second;
+			}
+		}
+		++counts.misses;
+		return std::nullopt;
+	}
+
+	void CompileCache::store(const std::string& file, const Source& source, const Flags& flags, Result result) {
+		std::lock_guard lock(mutex);
+		files[file].results.insert_or_assign(key(flags), std::pair{source.hash, std::move(result)});
+	}
+
+	CompileCache::Stats CompileCache::stats() {
+		std::lock_guard lock(mutex);
+		return counts;
+	}
+
+	void CompileCache::clear() {
+		std::lock_guard lock(mutex);
+		files.clear();
+		counts = {};
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace zenith {
+	class CompileCache;
+}
+#include "../utils/mainargs.hpp"
+
+namespace zenith {
+	// What a long-running compiler remembers between requests (--server)
+	// A source is read again only when its modification time or size changed, and a file whose text and
+	// output-relevant flags hash as they did last time gets that compile's output back without being compiled.
+	// Files are independent, so a file's own text and the flags are everything its result depends on.
+	class CompileCache {
+	public:
+		struct Source {
+			std::shared_ptr<const std::string> text;
+			uint64_t hash = 0;
+		};
+
+		struct Result {
+			std::string out, err;
+			bool ok = false;
+		};
+
+		struct Stats {
+			size_t reads = 0;       // Sources read from disk
+			size_t unchanged = 0;   // Sources taken from memory because the file looked the same
+			size_t hits = 0;        // Results handed back without compiling
+			size_t misses = 0;
+		};
+
+	private:
+		struct Entry {
+			std::filesystem::file_time_type mtime;
+			uintmax_t size = 0;
+			bool trusted = false; // The stat is old enough that a later write changes it
+			Source source;
+			std::unordered_map<std::string, std::pair<uint64_t, Result>> results; // Flags key to source hash, result
+		};
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Entry> files;
+		Stats counts;
+
+		static std::string key(const Flags& flags);
+
+	public:
+		// The file's text, from memory while its modification time and size stay the same. Throws when unreadable.
+		Source read(const std::string& file);
+		std::optional<Result> find(const std::string& file, const Source& source, const Flags& flags);
+		void store(const std::string& file, const Source& source, const Flags& flags, Result result);
+		// False when compiling with flags does more than produce the result, e.g. writes log files
+		[[nodiscard]] static bool cacheable(const Flags& flags);
+
+		[[nodiscard]] Stats stats();
+		void clear();
+	};
+}
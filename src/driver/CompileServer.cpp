@@ -0,0 +1,302 @@
+#include "CompileServer.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include "Driver.hpp"
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace zenith {
+#if !defined(_WIN32)
+	namespace {
+		// A message is a count and that many strings, every number a 32-bit little-endian length
+		constexpr uint32_t maxMessage = 1u << 30;
+
+		bool sendAll(const int fd, const char* data, size_t size) {
+			while (size) {
+				const ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL); // A client gone is no reason to die
+				if (sent < 0 && errno == EINTR) continue;
+				if (sent <= 0) return false;
+				data += sent;
+				size -= static_cast<size_t>(sent);
+			}
+			return true;
+		}
+
+		bool receiveAll(const int fd, char* data, size_t size) {
+			while (size) {
+				const ssize_t received = ::recv(fd, data, size, 0);
+				if (received < 0 && errno == EINTR) continue;
+				if (received <= 0) return false;
+				data += received;
+				size -= static_cast<size_t>(received);
+			}
+			return true;
+		}
+
+		void putLength(std::string& out, const size_t length) {
+			for (int shift = 0; shift < 32; shift += 8) out += static_cast<char>(length >> shift & 0xff);
+		}
+
+		std::optional<uint32_t> receiveLength(const int fd) {
+			unsigned char bytes[4];
+			if (!receiveAll(fd, reinterpret_cast<char*>(bytes), sizeof bytes)) return std::nullopt;
+			const uint32_t length = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+			if (length > maxMessage) return std::nullopt;
+			return length;
+		}
+
+		bool sendMessage(const int fd, const std::vector<std::string>& parts) {
+			std::string message;
+			putLength(message, parts.size());
+			for (const std::string& part: parts) {
+				putLength(message, part.size());
+				message += part;
+			}
+			return sendAll(fd, message.data(), message.size());
+		}
+
+		std::optional<std::vector<std::string>> receiveMessage(const int fd) {
+			const auto count = receiveLength(fd);
+			if (!count) return std::nullopt;
+			std::vector<std::string> parts;
+			for (uint32_t i = 0; i < *count; ++i) {
+				const auto length = receiveLength(fd);
+				if (!length) return std::nullopt;
+				std::string& part = parts.emplace_back(*length, '\0');
+				if (!receiveAll(fd, part.data(), part.size())) return std::nullopt;
+			}
+			return parts;
+		}
+
+		sockaddr_un socketAddress(const std::string& path) {
+			sockaddr_un address{};
+			address.sun_family = AF_UNIX;
+			if (path.size() >= sizeof address.sun_path) throw std::runtime_error("Socket path too long: " + path);
+			path.copy(address.sun_path, path.size());
+			return address;
+		}
+
+		// Whether the process at the other end of a connected socket runs as this user
+		bool peerIsThisUser(const int fd) {
+#if defined(__linux__)
+			ucred credentials{};
+			socklen_t length = sizeof credentials;
+			return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 && credentials.uid == ::getuid();
+#else
+			uid_t uid;
+			gid_t gid;
+			return ::getpeereid(fd, &uid, &gid) == 0 && uid == ::getuid();
+#endif
+		}
+
+		// -1 when nothing listens at path, or another user does. A client sends its arguments and trusts the reply.
+		int connectTo(const std::string& path) {
+			const sockaddr_un address = socketAddress(path);
+			const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			if (fd < 0) return -1;
+			if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof address) < 0 || !peerIsThisUser(fd)) {
+				::close(fd);
+				return -1;
+			}
+			return fd;
+		}
+
+		// Holds the default socket when there is no XDG_RUNTIME_DIR, /tmp itself is anyone's to bind in
+		std::string userDirectory() {
+			return "/tmp/zenith-" + std::to_string(::getuid());
+		}
+
+		// Creates the directory for this user only, or checks that the one there is that
+		void makeUserDirectory(const std::string& directory) {
+			if (::mkdir(directory.c_str(), S_IRWXU) < 0 && errno != EEXIST) {
+				throw std::system_error(errno, std::generic_category(), "Cannot create " + directory);
+			}
+			struct stat status{};
+			if (::lstat(directory.c_str(), &status) < 0) {
+				throw std::system_error(errno, std::generic_category(), "Cannot check " + directory);
+			}
+			if (!S_ISDIR(status.st_mode) || status.st_uid != ::getuid() || (status.st_mode & (S_IRWXG | S_IRWXO))) {
+				throw std::runtime_error(directory + " is not a directory only this user can use");
+			}
+		}
+	}
+
+	CompileServer::CompileServer(std::string socketPath, const size_t jobs)
+		: socketPath(std::move(socketPath)), pool(jobs ? jobs : std::thread::hardware_concurrency()) {}
+
+	CompileServer::~CompileServer() {
+		if (listener < 0) return;
+		::close(listener);
+		::unlink(socketPath.c_str());
+	}
+
+	std::string CompileServer::defaultSocket() {
+		if (const char* runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime) {
+			return std::string(runtime) + "/zenith.sock";
+		}
+		return userDirectory() + "/zenith.sock";
+	}
+
+	void CompileServer::listen() {
+		const sockaddr_un address = socketAddress(socketPath);
+		if (const std::string directory = userDirectory(); socketPath.starts_with(directory + "/")) {
+			makeUserDirectory(directory);
+		}
+		if (const int running = connectTo(socketPath); running >= 0) {
+			::close(running);
+			throw std::runtime_error("A compile server is already listening on " + socketPath);
+		}
+		::unlink(socketPath.c_str()); // Left behind by a server that did not exit cleanly
+		const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) throw std::system_error(errno, std::generic_category(), "Cannot create a socket");
+		// Only this user may connect, the server reads any file a client names. Nobody can connect before listen().
+		if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof address) < 0 ||
+		    ::chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+			const int error = errno;
+			::close(fd);
+			throw std::system_error(error, std::generic_category(), "Cannot listen on " + socketPath);
+		}
+		listener = fd;
+	}
+
+	void CompileServer::serve() {
+		if (listener < 0) listen();
+		while (!stopping) {
+			const int connection = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+			if (connection < 0) {
+				if (stopping) break;
+				if (errno == EINTR || errno == ECONNABORTED) continue;
+				throw std::system_error(errno, std::generic_category(), "Cannot accept on " + socketPath);
+			}
+			// The socket's mode keeps others out already, where the file system honours it
+			if (!peerIsThisUser(connection)) {
+				::close(connection);
+				continue;
+			}
+			{
+				std::lock_guard lock(mutex);
+				++active;
+			}
+			std::thread([this, connection] {
+				try {
+					handle(connection);
+				} catch (...) {
+					// The client gets no reply and compiles in its own process
+				}
+				::close(connection);
+				std::lock_guard lock(mutex);
+				if (--active == 0) idle.notify_all();
+			}).detach();
+		}
+		std::unique_lock lock(mutex);
+		idle.wait(lock, [this] { return active == 0; });
+	}
+
+	void CompileServer::handle(const int connection) {
+		const auto request = receiveMessage(connection);
+		if (!request || request->empty()) return;
+		if ((*request)[0] == "stop") {
+			sendMessage(connection, {"0", "", ""});
+			stopping = true;
+			::shutdown(listener, SHUT_RDWR); // Wakes the accept() in serve()
+			return;
+		}
+		if ((*request)[0] != "compile" || request->size() < 2) return;
+		const Reply reply = compile(*request);
+		sendMessage(connection, {std::to_string(reply.status), reply.out, reply.err});
+	}
+
+	std::optional<CompileServer::Reply> CompileServer::request(const std::string& socketPath, const std::string& cwd,
+	                                                           const std::vector<std::string>& args) {
+		const int connection = connectTo(socketPath);
+		if (connection < 0) return std::nullopt;
+		std::vector<std::string> message{"compile", cwd};
+		message.insert(message.end(), args.begin(), args.end());
+		std::optional<std::vector<std::string>> answer;
+		if (sendMessage(connection, message)) answer = receiveMessage(connection);
+		::close(connection);
+		if (!answer || answer->size() != 3) return std::nullopt;
+		return Reply{std::stoi((*answer)[0]), std::move((*answer)[1]), std::move((*answer)[2])};
+	}
+
+	bool CompileServer::stop(const std::string& socketPath) {
+		const int connection = connectTo(socketPath);
+		if (connection < 0) return false;
+		const bool stopped = sendMessage(connection, {"stop"}) && receiveMessage(connection);
+		::close(connection);
+		return stopped;
+	}
+#else
+	CompileServer::CompileServer(std::string socketPath, const size_t jobs)
+		: socketPath(std::move(socketPath)), pool(jobs ? jobs : std::thread::hardware_concurrency()) {}
+
+	CompileServer::~CompileServer() = default;
+
+	std::string CompileServer::defaultSocket() {
+		return "zenith.sock";
+	}
+
+	void CompileServer::listen() {
+		throw std::runtime_error("The compile server needs Unix domain sockets");
+	}
+
+	void CompileServer::serve() {
+		listen();
+	}
+
+	void CompileServer::handle(int) {}
+
+	std::optional<CompileServer::Reply> CompileServer::request(const std::string&, const std::string&,
+	                                                           const std::vector<std::string>&) {
+		return std::nullopt;
+	}
+
+	bool CompileServer::stop(const std::string&) {
+		return false;
+	}
+#endif
+
+	CompileServer::Reply CompileServer::compile(const std::vector<std::string>& request) {
+		Reply reply;
+		std::ostringstream out, err;
+		try {
+			std::vector<std::string> args{"zenith"};
+			args.insert(args.end(), request.begin() + 2, request.end());
+			Flags flags = ArgumentParser::parse(args);
+			if (!CompileCache::cacheable(flags)) {
+				throw std::runtime_error("--dump-logs, --time-trace and --mem-report only work without the compile server");
+			}
+			if (flags.target != Target::native) {
+				err << "Target not set to native" << std::endl << "Not implemented" << std::endl;
+				reply.err = err.str();
+				return reply;
+			}
+			// Relative paths are the client's
+			const std::filesystem::path cwd = request[1];
+			auto resolve = [&](std::string& path) {
+				if (!path.empty() && std::filesystem::path(path).is_relative()) path = (cwd / path).lexically_normal().string();
+			};
+			for (std::string& file: flags.inputFiles) resolve(file);
+			resolve(flags.inputFile);
+			resolve(flags.astCache);
+			reply.status = Driver(flags, &compileCache).run(out, err, &pool);
+		} catch (const std::exception& e) {
+			err << e.what() << std::endl;
+			reply.status = Driver::USAGE;
+		}
+		reply.out = std::move(out).str();
+		reply.err = std::move(err).str();
+		return reply;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "CompileCache.hpp"
+#include "../utils/ThreadPool.hpp"
+
+namespace zenith {
+	// Compiles for clients on a Unix domain socket, with a CompileCache kept warm between requests (--server)
+	// A client connects once per compile and sends its working directory and arguments. The reply is the output,
+	// the diagnostics and the exit status the compile would have had in the client's own process. Connections are
+	// served concurrently and the files of all of them share one thread pool.
+	class CompileServer {
+	public:
+		struct Reply {
+			int status = 0;
+			std::string out, err;
+		};
+
+	private:
+		std::string socketPath;
+		ThreadPool pool;
+		CompileCache compileCache;
+		int listener = -1;
+		std::atomic<bool> stopping = false;
+		std::mutex mutex;
+		std::condition_variable idle;
+		size_t active = 0; // Connections being served
+
+		void handle(int connection);
+		Reply compile(const std::vector<std::string>& request);
+
+	public:
+		CompileServer(std::string socketPath, size_t jobs);
+		~CompileServer();
+
+		CompileServer(const CompileServer&) = delete;
+		CompileServer& operator=(const CompileServer&) = delete;
+
+		// $XDG_RUNTIME_DIR/zenith.sock, or /tmp/zenith-<uid>/zenith.sock in a directory listen() keeps to this user.
+		// Clients only talk to a server of their own user, wherever the socket is.
+		static std::string defaultSocket();
+
+		// Throws when the socket cannot be set up, e.g. because another server is listening on it
+		void listen();
+		// Serves until a client asks the server to stop, then waits for the requests still running
+		void serve();
+
+		// The reply of the server at socketPath to a compile with args, run as if in directory cwd
+		// Nothing when no server answers there.
+		static std::optional<Reply> request(const std::string& socketPath, const std::string& cwd,
+		                                    const std::vector<std::string>& args);
+		// Asks the server to exit once its running requests are done, false when none answers
+		static bool stop(const std::string& socketPath);
+
+		[[nodiscard]] CompileCache& cache() { return compileCache; }
+	};
+}
@@ -0,0 +1,339 @@
+#include "Driver.hpp"
+#include "CompileCache.hpp"
+#include "Pipeline.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include "../exceptions/LexError.hpp"
+#include "../exceptions/ParseError.hpp"
+#include "../serialize/ModuleCache.hpp"
+#include "../SemanticAnalysis/SemanticAnalyzer.hpp"
+#include "../SemanticAnalysis/EscapeAnalysis.hpp"
+#include "../SemanticAnalysis/ShapeInference.hpp"
+#include "../utils/ReadFile.hpp"
+#include "../utils/ThreadPool.hpp"
+#include "../utils/TimeTrace.hpp"
+#include "../utils/MemoryAccounting.hpp"
+#include "../visitor/ASTWalker.hpp"
+
+namespace zenith {
+	namespace {
+		class NodeCounter : public ASTWalker {
+		protected:
+			void enter(ASTNode&) override { ++count; }
+
+		public:
+			int64_t count = 0;
+		};
+
+		// lexerout.log and parserout.log for a single input, <input>.lexerout.log and so on next to each of several
+		std::string logFile(const std::string& input, const bool several, const char* name) {
+			return several ? input + "." + name : name;
+		}
+
+		// Renders the diagnostics of one compilation once, at the latest when the compilation is left
+		// An early return or an exception from a later phase then still shows what was reported before it.
+		class DiagnosticsOutput {
+			DiagnosticsEngine& diagnostics;
+			const DiagnosticsFormat format;
+			std::ostream& err;
+			bool rendered = false;
+
+		public:
+			DiagnosticsOutput(DiagnosticsEngine& diagnostics, const DiagnosticsFormat format, std::ostream& err)
+				: diagnostics(diagnostics), format(format), err(err) {}
+			DiagnosticsOutput(const DiagnosticsOutput&) = delete;
+			DiagnosticsOutput& operator=(const DiagnosticsOutput&) = delete;
+			~DiagnosticsOutput() {
+				try {
+					if (!rendered && !diagnostics.collect().empty()) render();
+				} catch (...) {
+					// Already leaving with a failure, the diagnostics cannot be shown
+				}
+			}
+
+			void render() {
+				if (rendered) return;
+				rendered = true;
+				if (format == DiagnosticsFormat::json) diagnostics.renderJson(err);
+				else diagnostics.renderText(err);
+			}
+		};
+
+		// The lexer knows where in the source an error is, not which file that is
+		SourceLocation inFile(SourceLocation loc, const std::string& file) {
+			loc.file = file;
+			return loc;
+		}
+
+		// An exception that is no syntax error has no place of its own, it is shown at the start of the file
+		SourceLocation fileStart(const std::string& file) {
+			return {1, 1, 0, 0, file};
+		}
+
+		void writeTokens(std::ostream& log, const std::vector<Token>& tokens) {
+			for (const auto &token: tokens) {
+				log << "Line " << token.loc.line
+				<< ":" << token.loc.column
+				<< " - " << Lexer::tokenToString(token.type)
+				<< " (" << token.lexeme << ")\n";
+			}
+		}
+	}
+
+	void OrderedSink::finish(const size_t index, std::string outText, std::string errText) {
+		std::lock_guard lock(mutex);
+		waiting.emplace(index, std::pair{std::move(outText), std::move(errText)});
+		for (auto it = waiting.begin(); it != waiting.end() && it->first == next; it = waiting.erase(it), ++next) {
+			out << it->second.first;
+			err << it->second.second;
+		}
+		out.flush();
+		err.flush();
+	}
+
+	std::vector<std::string> Driver::expandInputs(const std::vector<std::string>& inputs) {
+		std::vector<std::string> files;
+		for (const std::string& input: inputs) {
+			std::error_code error;
+			if (!std::filesystem::is_directory(input, error)) {
+				files.push_back(input);
+				continue;
+			}
+			std::vector<std::string> found;
+			for (const auto& entry: std::filesystem::recursive_directory_iterator(input, error)) {
+				if (entry.is_regular_file() && entry.path().extension() == ".zn") found.push_back(entry.path().string());
+			}
+			std::ranges::sort(found);
+			std::ranges::move(found, std::back_inserter(files));
+		}
+		return files;
+	}
+
+	Driver::Status Driver::run(std::ostream& out, std::ostream& err, ThreadPool* sharedPool) {
+		const std::vector<std::string> files = expandInputs(flags.inputFiles);
+		if (files.empty()) {
+			err << "No input files\n";
+			return USAGE;
+		}
+
+		std::optional<ThreadPool> ownPool;
+		if (!sharedPool) ownPool.emplace(flags.jobs ? flags.jobs : std::thread::hardware_concurrency());
+		ThreadPool& pool = sharedPool ? *sharedPool : *ownPool;
+		OrderedSink sink(out, err);
+		std::atomic<size_t> failed = 0;
+		pool.parallelFor(files.size(), [&](const size_t i) {
+			std::ostringstream fileOut, fileErr;
+			if (files.size() > 1) fileOut << "Compiling " << files[i] << "\n";
+			bool ok = false;
+			try {
+				ok = compileFile(files[i], files.size() > 1, pool, fileOut, fileErr);
+			} catch (const std::exception& e) {
+				fileErr << files[i] << ": internal error: " << e.what() << "\n";
+			} catch (...) {
+				fileErr << files[i] << ": internal error\n";
+			}
+			if (!ok) failed.fetch_add(1, std::memory_order_relaxed);
+			sink.finish(i, std::move(fileOut).str(), std::move(fileErr).str());
+		});
+		if (files.size() > 1 && failed) err << failed << " of " << files.size() << " files failed\n";
+		return failed ? FAILED : SUCCESS;
+	}
+
+	void Driver::enter(const MemoryAccounting::Phase phase, ErrorReporter& reporter) const {
+		MemoryAccounting::enter(phase);
+		if (phaseHook) phaseHook(phase, reporter);
+	}
+
+	bool Driver::compileFile(const std::string& file, const bool several, ThreadPool& pool, std::ostream& out,
+	                         std::ostream& err) const {
+		if (!compileCache) {
+			std::string source;
+			try {
+				source = readFile(file);
+			} catch (const std::exception& e) {
+				err << e.what() << "\n";
+				return false;
+			}
+			return compile(file, source, several, pool, out, err);
+		}
+
+		CompileCache::Source source;
+		try {
+			source = compileCache->read(file);
+		} catch (const std::exception& e) {
+			err << e.what() << "\n";
+			return false;
+		}
+		if (!CompileCache::cacheable(flags)) return compile(file, *source.text, several, pool, out, err);
+		if (const auto hit = compileCache->find(file, source, flags)) {
+			out << hit->out;
+			err << hit->err;
+			return hit->ok;
+		}
+		std::ostringstream fileOut, fileErr;
+		CompileCache::Result result;
+		result.ok = compile(file, *source.text, several, pool, fileOut, fileErr);
+		result.out = std::move(fileOut).str();
+		result.err = std::move(fileErr).str();
+		out << result.out;
+		err << result.err;
+		const bool ok = result.ok;
+		compileCache->store(file, source, flags, std::move(result));
+		return ok;
+	}
+
+	bool Driver::compile(const std::string& file, const std::string& source, const bool several, ThreadPool& pool,
+	                     std::ostream& out, std::ostream& err) const {
+		TimeTrace::Scope fileTrace("Compile file", "compile");
+		fileTrace.detail(file);
+		Flags flags = this->flags;
+		flags.inputFile = file;
+
+		DiagnosticsEngine diagnostics;
+		diagnostics.setErrorLimit(flags.maxErrors);
+		ErrorReporter reporter(diagnostics);
+		DiagnosticsOutput output(diagnostics, flags.diagnosticsFormat, err);
+
+		std::optional<ModuleCache> cache;
+		if (!flags.astCache.empty()) cache.emplace(flags.astCache);
+		// A cached module decodes its bodies on first use anyway, and storing one needs all of it parsed.
+		// Declared out here with the reporter, so both outlive the analysis that parses lazy bodies
+		Flags parseFlags = flags;
+		if (cache) parseFlags.lazyParsing = false;
+		SemanticAnalyzer semanticAnalyzer(reporter, &pool);
+		polymorphic<ProgramNode> programNode;
+		MemoryAccounting::enter(MemoryAccounting::Phase::PARSE); // Decoding a cached module stands in for parsing it
+		if (cache) programNode = cache->load(source, flags.inputFile, flags);
+		if (programNode) {
+			out << "Loaded from the AST cache \n";
+		}
+		else {
+			std::ofstream lexerLog, parserLog;
+			std::ostream discard(nullptr);
+			if (flags.dumpLogs) {
+				lexerLog.open(logFile(file, several, "lexerout.log"));
+				parserLog.open(logFile(file, several, "parserout.log"));
+			}
+			std::ostream& parserOut = flags.dumpLogs ? static_cast<std::ostream&>(parserLog) : discard;
+
+			if (flags.pipeline) {
+				Pipeline::Options options;
+				if (flags.dumpLogs) options.onTokens = [&](const std::vector<Token>& batch) { writeTokens(lexerLog, batch); };
+				Pipeline pipeline(parseFlags, reporter, parserOut, std::move(options));
+				try {
+					TimeTrace::Scope pipelineTrace("Pipeline", "parse");
+					programNode = pipeline.run(source, flags.inputFile, semanticAnalyzer);
+					pipelineTrace.counter("token batches", static_cast<int64_t>(pipeline.stats().tokenBatches));
+					pipelineTrace.counter("lexer waits", static_cast<int64_t>(pipeline.stats().lexerWaits));
+					pipelineTrace.counter("parser waits", static_cast<int64_t>(pipeline.stats().parserWaits));
+				} catch (const LexError &e) {
+					reporter.error(inFile(e.location, flags.inputFile), e.std::runtime_error::what());
+					output.render();
+					return false;
+				} catch (const ParseError &e) {
+					reporter.error(e.location, e.std::runtime_error::what());
+					output.render();
+					return false;
+				} catch (const std::exception &e) {
+					reporter.internalError(fileStart(flags.inputFile), std::string("Parser error: ") + e.what());
+					output.render();
+					return false;
+				}
+				out << "Done Lexing \n";
+			}
+			else {
+				std::vector<Token> tokens;
+				Lexer lexer(source, flags.inputFile);
+				try {
+					enter(MemoryAccounting::Phase::LEX, reporter);
+					TimeTrace::Scope lexTrace("Lex", "lex");
+					tokens = std::move(lexer).tokenize();
+					lexTrace.counter("tokens", static_cast<int64_t>(tokens.size()));
+					lexTrace.stop();
+					if (flags.dumpLogs) {
+						TimeTrace::Scope logTrace("Write lexer log", "io");
+						writeTokens(lexerLog, tokens);
+					}
+				} catch (const LexError &e) {
+					reporter.error(inFile(e.location, flags.inputFile), e.std::runtime_error::what());
+					output.render();
+					return false;
+				} catch (const std::exception &e) {
+					reporter.internalError(fileStart(flags.inputFile), std::string("Lexer error: ") + e.what());
+					output.render();
+					return false;
+				}
+				out << "Done Lexing \n";
+
+				try{
+					enter(MemoryAccounting::Phase::PARSE, reporter);
+					TimeTrace::Scope parseTrace("Parse", "parse");
+					Parser parser(std::move(tokens),parseFlags,reporter,parserOut,&pool);
+					programNode = parser.parse();
+					parseTrace.counter("declarations", static_cast<int64_t>(programNode->declarations.size()));
+				}catch (const ParseError &e) {
+					reporter.error(e.location, e.std::runtime_error::what());
+					output.render();
+					return false;
+				} catch (const std::exception &e) {
+					reporter.internalError(fileStart(flags.inputFile), std::string("Parser error: ") + e.what());
+					output.render();
+					return false;
+				}
+			}
+			if (flags.dumpLogs) {
+				TimeTrace::Scope logTrace("Write parser log", "io");
+				parserOut << programNode->toString() << std::endl;
+			}
+			out << "Done Parsing \n";
+			// Before analysis fills in types and constants; a parse with diagnostics would not report them on a hit
+			if (cache && !diagnostics.hasErrors()) {
+				try {
+					cache->store(source, flags.inputFile, flags, *programNode);
+				} catch (const std::exception &e) {
+					err << "AST cache: " << e.what() << std::endl;
+				}
+			}
+		}
+
+		// Analysis cannot take the error nodes that recovery left in the tree, a file that did not parse ends here
+		if (diagnostics.hasErrors()) {
+			output.render();
+			return false;
+		}
+
+		enter(MemoryAccounting::Phase::ANALYZE, reporter);
+		TimeTrace::Scope analyzeTrace("Analyze", "analyze");
+		SymbolTable&& symbols = semanticAnalyzer.analyze(programNode);
+		analyzeTrace.counter("symbols", static_cast<int64_t>(symbols.symbolCount()));
+		analyzeTrace.stop();
+		if (TimeTrace::enabled()) {
+			// Lazily parsed bodies are in the tree by now
+			NodeCounter nodes;
+			programNode->accept(nodes);
+			TimeTrace::counter("AST", "nodes", nodes.count);
+		}
+		output.render();
+		out << symbols.toString() << "\n";
+		if (diagnostics.hasErrors()) return false;
+
+		enter(MemoryAccounting::Phase::OPTIMIZE, reporter);
+		EscapeAnalysis escapeAnalysis;
+		TimeTrace::Scope escapeTrace("Escape analysis", "analyze");
+		escapeAnalysis.analyze(*programNode);
+		escapeTrace.stop();
+		if (flags.escapeReport) escapeAnalysis.report(out);
+		ShapeInference shapeInference;
+		TimeTrace::Scope shapeTrace("Shape inference", "analyze");
+		shapeInference.analyze(*programNode);
+		shapeTrace.stop();
+		if (flags.shapeReport) shapeInference.report(out);
+		return true;
+	}
+}
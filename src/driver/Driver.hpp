@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace zenith {
+	class CompileCache;
+	class ErrorReporter;
+	class ThreadPool;
+}
+#include "../utils/mainargs.hpp"
+#include "../utils/MemoryAccounting.hpp"
+
+namespace zenith {
+	// Output of parallel tasks, written in task order as soon as every earlier task has finished
+	class OrderedSink {
+		std::ostream& out;
+		std::ostream& err;
+		std::mutex mutex;
+		size_t next = 0;
+		std::map<size_t, std::pair<std::string, std::string>> waiting;
+
+	public:
+		OrderedSink(std::ostream& out, std::ostream& err) : out(out), err(err) {}
+
+		// Every index from 0 up has to finish once, the output of index waits for all before it
+		void finish(size_t index, std::string outText, std::string errText);
+	};
+
+	// Compiles every input as one task on a shared thread pool
+	// Each file is lexed, parsed and analyzed on its own with its own diagnostics, which go to the sink in input
+	// order. The parser and analyzer of a file spread their work over the same pool.
+	class Driver {
+		Flags flags;
+		CompileCache* compileCache = nullptr;
+		std::function<void(MemoryAccounting::Phase, ErrorReporter&)> phaseHook;
+
+		void enter(MemoryAccounting::Phase phase, ErrorReporter& reporter) const;
+
+		// False when the file could not be read or has errors. With several inputs every file gets its own logs.
+		bool compileFile(const std::string& file, bool several, ThreadPool& pool, std::ostream& out,
+		                 std::ostream& err) const;
+		bool compile(const std::string& file, const std::string& source, bool several, ThreadPool& pool,
+		             std::ostream& out, std::ostream& err) const;
+
+	public:
+		enum Status : int {
+			SUCCESS = 0,
+			FAILED = 1, // Some input could not be read or has errors
+			USAGE = 2 // Bad arguments, nothing was compiled
+		};
+
+		// With a cache, sources and results of earlier runs are reused where they still apply
+		explicit Driver(Flags flags, CompileCache* cache = nullptr) : flags(std::move(flags)), compileCache(cache) {}
+
+		// Called on the compiling thread as a file is lexed, parsed, analyzed and optimized, outside --pipeline. Tests
+		// report and throw from it to stand in for a phase that fails.
+		void onPhase(std::function<void(MemoryAccounting::Phase, ErrorReporter&)> hook) { phaseHook = std::move(hook); }
+
+		// The input files with directories replaced by the *.zn files under them, sorted
+		[[nodiscard]] static std::vector<std::string> expandInputs(const std::vector<std::string>& inputs);
+
+		// Without a pool, one with flags.jobs threads is made for the run
+		Status run(std::ostream& out, std::ostream& err, ThreadPool* pool = nullptr);
+	};
+}
@@ -0,0 +1,75 @@
+#include "Pipeline.hpp"
+#include <exception>
+#include <optional>
+#include <thread>
+#include "../parser/parser.hpp"
+#include "../SemanticAnalysis/SemanticAnalyzer.hpp"
+#include "../utils/BoundedQueue.hpp"
+#include "../utils/MemoryAccounting.hpp"
+#include "../utils/TimeTrace.hpp"
+
+namespace zenith {
+	polymorphic<ProgramNode> Pipeline::run(const std::string& source, const std::string& file,
+	                                       SemanticAnalyzer& analyzer) {
+		runStats = {};
+		BoundedQueue<std::vector<Token>> tokens(options.queueDepth);
+		BoundedQueue<std::vector<polymorphic_ref<ASTNode>>> declarations(options.queueDepth);
+		std::exception_ptr lexError, parseError;
+		polymorphic<ProgramNode> program;
+
+		std::jthread lexer([&] {
+			MemoryAccounting::enter(MemoryAccounting::Phase::LEX);
+			TimeTrace::Scope trace("Lex", "lex");
+			try {
+				Lexer(source, file).tokenize(options.tokenBatch, [&](std::vector<Token>&& batch) {
+					if (options.onTokens) options.onTokens(batch);
+					return tokens.push(std::move(batch));
+				});
+			} catch (...) {
+				lexError = std::current_exception();
+			}
+			tokens.close();
+		});
+		std::jthread parser([&] {
+			MemoryAccounting::enter(MemoryAccounting::Phase::PARSE);
+			TimeTrace::Scope trace("Parse", "parse");
+			try {
+				program = Parser::parseStream(
+					[&](std::vector<Token>& batch) {
+						std::optional<std::vector<Token>> next = tokens.pop();
+						if (!next) return false;
+						batch = std::move(*next);
+						++runStats.tokenBatches;
+						return true;
+					},
+					[&](std::vector<polymorphic_ref<ASTNode>> parsed) { declarations.push(std::move(parsed)); },
+					flags, errorReporter, parserLog);
+			} catch (...) {
+				parseError = std::current_exception();
+			}
+			tokens.close(); // Stops the lexer when the parser gave up early
+			declarations.close();
+		});
+
+		try {
+			TimeTrace::Scope trace("Collect declarations", "analyze");
+			while (std::optional<std::vector<polymorphic_ref<ASTNode>>> parsed = declarations.pop()) {
+				++runStats.declarationRuns;
+				for (auto& declaration: *parsed) analyzer.collect(declaration);
+			}
+		} catch (...) {
+			// Neither stage may wait on a queue nobody reads any more
+			declarations.close();
+			tokens.close();
+			throw;
+		}
+		parser.join();
+		lexer.join();
+		runStats.lexerWaits = tokens.fullWaits();
+		runStats.parserWaits = declarations.fullWaits();
+		// A lexer error cut the token stream short, so it is the one to report
+		if (lexError) std::rethrow_exception(lexError);
+		if (parseError) std::rethrow_exception(parseError);
+		return program;
+	}
+}
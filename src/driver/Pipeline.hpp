@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "../ast/AST.hpp"
+#include "../lexer/lexer.hpp"
+#include "../utils/mainargs.hpp"
+
+namespace zenith {
+	class ErrorReporter;
+	class SemanticAnalyzer;
+
+	// Lexes, parses and collects the declarations of one file in three overlapping stages (--pipeline)
+	// The lexer thread hands token batches to the parser thread, which hands every run of parsed top-level
+	// declarations back to the calling thread for SemanticAnalyzer::collect(). Both hand-offs are bounded queues and a
+	// full one stops its producer, so a large file is never buffered whole and the time tends to the slowest stage.
+	class Pipeline {
+	public:
+		struct Options {
+			size_t tokenBatch = 4096; // Tokens per lexer batch
+			size_t queueDepth = 8;    // Batches or declaration runs waiting in each queue at most
+			std::function<void(const std::vector<Token>&)> onTokens; // Sees every batch on the lexer thread
+		};
+
+		struct Stats {
+			size_t tokenBatches = 0;
+			size_t declarationRuns = 0;
+			size_t lexerWaits = 0;  // Batches the lexer had to hold back because the parser was behind
+			size_t parserWaits = 0; // Same for the parser and the analyzer
+		};
+
+	private:
+		const Flags& flags;
+		ErrorReporter& errorReporter;
+		std::ostream& parserLog;
+		Options options;
+		Stats runStats;
+
+	public:
+		Pipeline(const Flags& flags, ErrorReporter& errorReporter, std::ostream& parserLog, Options options)
+			: flags(flags), errorReporter(errorReporter), parserLog(parserLog), options(std::move(options)) {}
+
+		// The parsed program, every declaration of which already went through analyzer.collect()
+		// Throws the lexer's error first, then the parser's, like lexing and parsing one after the other would.
+		polymorphic<ProgramNode> run(const std::string& source, const std::string& file, SemanticAnalyzer& analyzer);
+
+		[[nodiscard]] const Stats& stats() const { return runStats; }
+	};
+}
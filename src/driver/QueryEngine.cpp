@@ -0,0 +1,594 @@
+#include "QueryEngine.hpp"
+#include <algorithm>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_set>
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include "../exceptions/LexError.hpp"
+#include "../exceptions/ParseError.hpp"
+#include "../SemanticAnalysis/SemanticAnalyzer.hpp"
+#include "../utils/Hash.hpp"
+#include "../utils/TimeTrace.hpp"
+
+namespace zenith {
+	namespace {
+		using Query = QueryEngine::Query;
+		constexpr size_t NONE = static_cast<size_t>(-1);
+
+		struct Lexed {
+			std::vector<Token> tokens;
+			std::optional<Diagnostic> error;
+		};
+
+		struct Parsed {
+			std::shared_ptr<const std::string> text;
+			std::optional<IncrementalParse> parse;
+			std::vector<Diagnostic> diagnostics; // Of lexing and parsing
+			std::vector<std::vector<std::string>> names; // Declared by each top-level declaration, none for imports
+			std::vector<std::pair<size_t, size_t>> ranges; // Tokens of each top-level declaration
+			std::unordered_map<std::string, std::vector<size_t>> byName;
+			// The last parse that worked and its text, what the next reparse starts from while the text does not lex
+			std::optional<IncrementalParse> previous;
+			std::shared_ptr<const std::string> previousText;
+		};
+
+		struct Names {
+			std::vector<std::string> distinct; // In order of first declaration, "" stands for the unnamed ones
+		};
+
+		struct Declared {
+			std::vector<polymorphic<ASTNode>> nodes;
+			std::vector<size_t> indices;          // Into the current program's declarations
+			std::vector<std::string> identifiers; // Every name in their tokens, sorted
+			uint64_t fingerprint = 0;
+			bool hasBodies = false;
+		};
+
+		struct Interface {
+			std::vector<std::string> names; // Every name in the tokens that make it up
+		};
+
+		// A diagnostic relative to the declaration, or class member, it was found in
+		struct Anchored {
+			std::string name;
+			size_t node = NONE;   // Which declaration of the name, NONE for a diagnostic outside of any
+			size_t member = NONE; // Member of the class, NONE for the declaration itself
+			Diagnostic diagnostic;
+		};
+
+		struct Global {
+			DiagnosticsEngine diagnostics;
+			ErrorReporter reporter{diagnostics};
+			polymorphic<ProgramNode> program; // Keeps the declarations the scope points into alive
+			std::unique_ptr<SemanticAnalyzer> analyzer;
+			std::vector<Anchored> found;
+		};
+
+		struct Checked {
+			std::vector<std::vector<Diagnostic>> found; // Per declaration of the name, relative to it
+		};
+
+		// Line and offset from the anchor, the column too on the anchor's own line. A declaration that only moved
+		// keeps the same relative positions.
+		Diagnostic relative(Diagnostic d, const SourceLocation& anchor) {
+			if (d.loc.line == anchor.line) d.loc.column -= anchor.column;
+			d.loc.line -= anchor.line;
+			d.loc.fileOffset -= anchor.fileOffset;
+			return d;
+		}
+
+		Diagnostic absolute(Diagnostic d, const SourceLocation& anchor) {
+			if (d.loc.line == 0) d.loc.column += anchor.column;
+			d.loc.line += anchor.line;
+			d.loc.fileOffset += anchor.fileOffset;
+			return d;
+		}
+
+		void hashDiagnostic(Hash& hash, const Diagnostic& d) {
+			hash << static_cast<uint64_t>(d.severity) << static_cast<uint64_t>(d.loc.line)
+				<< static_cast<uint64_t>(d.loc.column) << static_cast<uint64_t>(d.loc.length)
+				<< static_cast<uint64_t>(d.loc.fileOffset) << d.message << uint64_t{0};
+		}
+
+		polymorphic_ref<ASTNode> unwrapped(const polymorphic<ASTNode>& node) {
+			polymorphic_ref<ASTNode> target = node;
+			if (auto templ = target.cast().non_throwing().to<TemplateDeclNode>()) target = templ->declaration;
+			return target;
+		}
+
+		std::vector<std::string> declaredNames(const polymorphic<ASTNode>& node) {
+			const polymorphic_ref<ASTNode> target = unwrapped(node);
+			if (const auto* decl = dynamic_cast<const DeclNode*>(target.get())) return {decl->name};
+			if (const auto* var = dynamic_cast<const VarDeclNode*>(target.get())) return {var->name};
+			if (const auto* object = dynamic_cast<const ObjectDeclNode*>(target.get())) return {object->name};
+			if (const auto* alias = dynamic_cast<const UnionDeclNode*>(target.get())) return {alias->name};
+			if (const auto* vars = dynamic_cast<const MultiVarDeclNode*>(target.get())) {
+				std::vector<std::string> names;
+				for (const auto& var: vars->vars) names.push_back(var->name);
+				return names;
+			}
+			return {""};
+		}
+
+		// First token at or after offset
+		size_t tokenAt(const std::vector<Token>& tokens, const size_t offset) {
+			return std::ranges::partition_point(tokens, [&](const Token& t) { return t.loc.fileOffset < offset; }) -
+			       tokens.begin();
+		}
+
+		// Tokens [begin, end) as they are placed relative to anchor, so moving them all leaves the hash as it was
+		void layout(Hash& hash, std::vector<std::string>& names, const std::vector<Token>& tokens, const size_t begin,
+		            const size_t end, const SourceLocation& anchor) {
+			for (size_t i = begin; i < end && i < tokens.size(); ++i) {
+				const Token& token = tokens[i];
+				if (token.type == TokenType::EOF_TOKEN) break;
+				hash << static_cast<uint64_t>(token.type) << token.lexeme
+					<< static_cast<uint64_t>(token.loc.line - anchor.line)
+					<< static_cast<uint64_t>(token.loc.line == anchor.line ? token.loc.column - anchor.column : token.loc.column)
+					<< static_cast<uint64_t>(token.loc.fileOffset - anchor.fileOffset);
+				if (token.type == TokenType::IDENTIFIER) names.push_back(token.lexeme);
+			}
+			hash << uint64_t{end - begin};
+		}
+
+		void sortUnique(std::vector<std::string>& names) {
+			std::ranges::sort(names);
+			names.erase(std::ranges::unique(names).begin(), names.end());
+		}
+
+		template<typename T>
+		std::shared_ptr<void> boxed(T value) {
+			return std::make_shared<T>(std::move(value));
+		}
+	}
+
+	size_t QueryEngine::KeyHash::operator()(const Key& key) const {
+		Hash hash;
+		hash << static_cast<uint64_t>(key.query) << key.file << uint64_t{0} << key.name;
+		return hash.value;
+	}
+
+	const char* QueryEngine::queryName(const Query query) {
+		static const char* names[] = {
+			"source", "tokens", "program", "names", "declaration", "signature", "type", "members", "global scope",
+			"check body", "diagnostics"
+		};
+		return names[static_cast<size_t>(query)];
+	}
+
+	void QueryEngine::setSource(const std::string& file, std::string text) {
+		Slot& slot = slots[Key{Query::SOURCE, file, {}}];
+		if (slot.value && *static_cast<const std::string*>(slot.value.get()) == text) return;
+		++revision;
+		slot.value = boxed(std::move(text));
+		slot.changedAt = slot.verifiedAt = revision;
+	}
+
+	std::vector<Diagnostic> QueryEngine::diagnostics(const std::string& file) {
+		return read<std::vector<Diagnostic>>(Query::DIAGNOSTICS, file);
+	}
+
+	std::optional<std::vector<Diagnostic>> QueryEngine::diagnostics(const std::string& file, std::stop_token stop) {
+		this->stop = std::move(stop);
+		std::optional<std::vector<Diagnostic>> result;
+		try {
+			result = diagnostics(file);
+		} catch (const Stopped&) {}
+		this->stop = {};
+		return result;
+	}
+
+	const IncrementalParse* QueryEngine::parse(const std::string& file) {
+		const auto& parsed = peek<Parsed>(Query::PROGRAM, file);
+		return parsed.parse ? &*parsed.parse : nullptr;
+	}
+
+	SemanticAnalyzer* QueryEngine::analyzer(const std::string& file) {
+		const IncrementalParse* current = parse(file);
+		if (!current) return nullptr;
+		const Key key{Query::GLOBAL_SCOPE, file, {}};
+		Slot& slot = update(key);
+		// A scope that stayed green may point into declarations the parser has replaced since, at their old places
+		const auto* global = static_cast<const Global*>(slot.value.get());
+		auto same = [](const polymorphic<ASTNode>& a, const polymorphic<ASTNode>& b) { return a.get() == b.get(); };
+		if (!global->program || !std::ranges::equal(global->program->declarations, current->program->declarations, same)) {
+			execute(key, slot);
+		}
+		return static_cast<Global*>(slot.value.get())->analyzer.get();
+	}
+
+	template<typename T>
+	const T& QueryEngine::read(const Query query, const std::string& file, const std::string& name) {
+		Key key{query, file, name};
+		const Slot& slot = update(key);
+		if (!running.empty()) running.back()->push_back(std::move(key));
+		return *static_cast<const T*>(slot.value.get());
+	}
+
+	template<typename T>
+	T& QueryEngine::peek(const Query query, const std::string& file, const std::string& name) {
+		return *static_cast<T*>(update(Key{query, file, name}).value.get());
+	}
+
+	QueryEngine::Slot& QueryEngine::update(const Key& key) {
+		Slot& slot = slots[key];
+		if (slot.verifiedAt == revision) return slot;
+		if (key.query == Query::SOURCE) {
+			// A file nobody set is empty
+			if (!slot.value) {
+				slot.value = boxed(std::string());
+				slot.changedAt = revision;
+			}
+			slot.verifiedAt = revision;
+			return slot;
+		}
+		if (slot.running) throw std::logic_error(std::string("Query '") + queryName(key.query) + "' depends on itself");
+		if (slot.value && !outdated(slot)) {
+			slot.verifiedAt = revision;
+			++counts[static_cast<size_t>(key.query)].green;
+			return slot;
+		}
+		execute(key, slot);
+		return slot;
+	}
+
+	bool QueryEngine::outdated(const Slot& slot) {
+		// In the order they were read, an early one that changed may mean the later ones are not read at all anymore
+		for (const Key& dependency: slot.dependencies) {
+			if (update(dependency).changedAt > slot.verifiedAt) return true;
+		}
+		return false;
+	}
+
+	void QueryEngine::execute(const Key& key, Slot& slot) {
+		// Between queries, a result is either complete or still the previous one
+		if (stop.stop_requested()) throw Stopped{};
+		TimeTrace::Scope trace(queryName(key.query), "query");
+		trace.detail(key.name);
+		std::vector<Key> dependencies;
+		running.push_back(&dependencies);
+		slot.running = true;
+		Result result;
+		try {
+			switch (key.query) {
+				case Query::TOKENS: result = tokens(key); break;
+				case Query::PROGRAM: result = program(key, slot); break;
+				case Query::NAMES: result = names(key); break;
+				case Query::DECLARATION: result = declaration(key, slot); break;
+				case Query::SIGNATURE:
+				case Query::TYPE:
+				case Query::MEMBERS: result = interface(key); break;
+				case Query::GLOBAL_SCOPE: result = globalScope(key); break;
+				case Query::CHECK_BODY: result = checkBody(key); break;
+				default: result = diagnostics(key); break;
+			}
+		} catch (...) {
+			running.pop_back();
+			slot.running = false;
+			throw;
+		}
+		running.pop_back();
+		slot.running = false;
+
+		// The same result as before keeps its revision, the queries that read it need not run again
+		const bool same = slot.value && slot.fingerprint == result.fingerprint;
+		auto& count = counts[static_cast<size_t>(key.query)];
+		if (same) ++count.unchanged;
+		else {
+			++count.changed;
+			slot.changedAt = revision;
+		}
+		slot.value = std::move(result.value);
+		slot.fingerprint = result.fingerprint;
+		slot.dependencies = std::move(dependencies);
+		slot.verifiedAt = revision;
+	}
+
+	QueryEngine::Result QueryEngine::tokens(const Key& key) {
+		const auto& text = read<std::string>(Query::SOURCE, key.file);
+		Lexed lexed;
+		try {
+			lexed.tokens = Lexer(text, key.file).tokenize();
+		} catch (const LexError& e) {
+			lexed.error = Diagnostic{Severity::ERROR, e.location, e.std::runtime_error::what()};
+		}
+		Hash hash;
+		for (const Token& token: lexed.tokens) {
+			hash << static_cast<uint64_t>(token.type) << token.lexeme << static_cast<uint64_t>(token.loc.line)
+				<< static_cast<uint64_t>(token.loc.column) << static_cast<uint64_t>(token.loc.fileOffset);
+		}
+		if (lexed.error) hashDiagnostic(hash, *lexed.error);
+		return {boxed(std::move(lexed)), hash.value};
+	}
+
+	QueryEngine::Result QueryEngine::program(const Key& key, Slot& slot) {
+		const auto& lexed = read<Lexed>(Query::TOKENS, key.file);
+		// Not a dependency: the tokens decide the tree, the text only helps to find what changed since the last one
+		const auto text = std::static_pointer_cast<const std::string>(update(Key{Query::SOURCE, key.file, {}}).value);
+
+		Parsed parsed;
+		parsed.text = text;
+		if (auto* old = static_cast<Parsed*>(slot.value.get())) {
+			if (old->parse) {
+				parsed.previous = std::move(old->parse);
+				parsed.previousText = std::move(old->text);
+			}
+			else {
+				parsed.previous = std::move(old->previous);
+				parsed.previousText = std::move(old->previousText);
+			}
+		}
+		if (lexed.error) {
+			parsed.diagnostics.push_back(*lexed.error);
+			return {boxed(std::move(parsed)), revision};
+		}
+
+		DiagnosticsEngine syntax;
+		ErrorReporter reporter(syntax);
+		std::ostream discard(nullptr);
+		try {
+			if (parsed.previous) {
+				// The edit is what lies between the common prefix and suffix of the two texts
+				const std::string& before = *parsed.previousText;
+				const size_t shorter = std::min(before.size(), text->size());
+				size_t prefix = 0;
+				while (prefix < shorter && before[prefix] == (*text)[prefix]) ++prefix;
+				size_t suffix = 0;
+				while (suffix < shorter - prefix && before[before.size() - 1 - suffix] == (*text)[text->size() - 1 - suffix]) {
+					++suffix;
+				}
+				const TextEdit edit{prefix, before.size() - prefix - suffix, text->size() - prefix - suffix};
+				parsed.parse = Parser::reparse(std::move(*parsed.previous), edit, lexed.tokens, flags, reporter, discard);
+			}
+			else parsed.parse = Parser::parseForEditing(lexed.tokens, flags, reporter, discard);
+		} catch (const ParseError& e) {
+			parsed.parse.reset();
+			reporter.error(e.location, e.std::runtime_error::what());
+		}
+		parsed.previous.reset();
+		parsed.previousText.reset();
+		parsed.diagnostics = syntax.collect();
+		if (!parsed.parse) return {boxed(std::move(parsed)), revision};
+
+		// Where each declaration's tokens start: the span the parser recorded for it, annotations included, or its node
+		const auto& tokens = parsed.parse->tokens;
+		const auto& declarations = parsed.parse->program->declarations;
+		std::unordered_map<const ASTNode*, size_t> spans;
+		for (const ParseSpan& span: parsed.parse->declarations) {
+			if (span.node) spans.emplace(span.node.get(), span.begin);
+		}
+		std::vector<size_t> starts;
+		for (const auto& declaration: declarations) {
+			const auto span = spans.find(declaration.get());
+			starts.push_back(span != spans.end() ? span->second : tokenAt(tokens, declaration->loc.fileOffset));
+		}
+		for (size_t i = 0; i < declarations.size(); ++i) {
+			parsed.ranges.emplace_back(starts[i], i + 1 < starts.size() ? starts[i + 1] : tokens.size());
+			parsed.names.push_back(declaredNames(declarations[i]));
+			for (const auto& name: parsed.names.back()) parsed.byName[name].push_back(i);
+		}
+		return {boxed(std::move(parsed)), revision};
+	}
+
+	QueryEngine::Result QueryEngine::names(const Key& key) {
+		const auto& parsed = read<Parsed>(Query::PROGRAM, key.file);
+		Names names;
+		std::unordered_set<std::string> seen;
+		Hash hash;
+		for (const auto& declared: parsed.names) {
+			for (const auto& name: declared) {
+				hash << name << uint64_t{0};
+				if (seen.insert(name).second) names.distinct.push_back(name);
+			}
+			hash << uint64_t{1};
+		}
+		return {boxed(std::move(names)), hash.value};
+	}
+
+	QueryEngine::Result QueryEngine::declaration(const Key& key, const Slot& slot) {
+		const auto& parsed = read<Parsed>(Query::PROGRAM, key.file);
+		Declared declared;
+		if (parsed.parse) {
+			if (const auto it = parsed.byName.find(key.name); it != parsed.byName.end()) declared.indices = it->second;
+		}
+		for (const size_t i: declared.indices) {
+			declared.nodes.push_back(parsed.parse->program->declarations[i].share());
+			declared.hasBodies |= !SemanticAnalyzer::bodies(declared.nodes.back()).empty();
+		}
+
+		// Nodes the parser reused have the tokens they had, only moved
+		const auto* old = static_cast<const Declared*>(slot.value.get());
+		auto same = [](const polymorphic<ASTNode>& a, const polymorphic<ASTNode>& b) { return a.get() == b.get(); };
+		if (old && std::ranges::equal(old->nodes, declared.nodes, same)) {
+			declared.identifiers = old->identifiers;
+			declared.fingerprint = old->fingerprint;
+			return {boxed(std::move(declared)), old->fingerprint};
+		}
+		Hash hash;
+		for (size_t k = 0; k < declared.indices.size(); ++k) {
+			const auto [begin, end] = parsed.ranges[declared.indices[k]];
+			layout(hash, declared.identifiers, parsed.parse->tokens, begin, end, declared.nodes[k]->loc);
+		}
+		sortUnique(declared.identifiers);
+		declared.fingerprint = hash.value;
+		return {boxed(std::move(declared)), hash.value};
+	}
+
+	QueryEngine::Result QueryEngine::interface(const Key& key) {
+		const auto& declared = read<Declared>(Query::DECLARATION, key.file, key.name);
+		const auto& parsed = peek<Parsed>(Query::PROGRAM, key.file);
+		Interface result;
+		Hash hash;
+		for (size_t k = 0; k < declared.nodes.size(); ++k) {
+			const auto& tokens = parsed.parse->tokens;
+			const auto [begin, end] = parsed.ranges[declared.indices[k]];
+			const auto& node = declared.nodes[k];
+			// A template shows all of itself, like a variable
+			const auto* function = dynamic_cast<const FunctionDeclNode*>(node.get());
+			const auto* object = dynamic_cast<const ObjectDeclNode*>(node.get());
+			const Query kind = function ? Query::SIGNATURE : object ? Query::MEMBERS : Query::TYPE;
+			if (kind != key.query) continue;
+			hash << uint64_t{k};
+
+			if (function) {
+				// Everything up to the body, annotations and parameters included
+				const size_t body = function->body ? tokenAt(tokens, function->body->loc.fileOffset) : end;
+				layout(hash, result.names, tokens, begin, std::min(body, end), node->loc);
+			}
+			else if (object) {
+				// The header, then each member relative to itself, so a method body that grows moves nothing else
+				std::vector<std::pair<size_t, const ASTNode*>> children;
+				for (const auto& member: object->members) children.emplace_back(member->loc.fileOffset, member.get());
+				for (const auto& op: object->operators) children.emplace_back(op->loc.fileOffset, op.get());
+				std::ranges::sort(children, {}, &std::pair<size_t, const ASTNode*>::first);
+				const size_t header = children.empty() ? end : tokenAt(tokens, children.front().first);
+				layout(hash, result.names, tokens, begin, header, node->loc);
+				for (size_t i = 0; i < children.size(); ++i) {
+					const ASTNode& child = *children[i].second;
+					const size_t from = tokenAt(tokens, child.loc.fileOffset);
+					size_t to = i + 1 < children.size() ? tokenAt(tokens, children[i + 1].first) : end;
+					if (const auto* method = dynamic_cast<const MethodDeclNode*>(&child)) {
+						hash << static_cast<uint64_t>(method->flags.access) << uint64_t{method->flags.isConst}
+							<< uint64_t{method->flags.isStatic} << uint64_t{method->isAsync};
+						if (method->body) to = std::min(to, tokenAt(tokens, method->body->loc.fileOffset));
+					}
+					else if (const auto* field = dynamic_cast<const FieldDeclNode*>(&child)) {
+						hash << static_cast<uint64_t>(field->flags.access) << uint64_t{field->flags.isConst}
+							<< uint64_t{field->flags.isStatic};
+					}
+					layout(hash, result.names, tokens, from, to, child.loc);
+				}
+			}
+			else layout(hash, result.names, tokens, begin, end, node->loc);
+		}
+		sortUnique(result.names);
+		return {boxed(std::move(result)), hash.value};
+	}
+
+	void QueryEngine::readVisible(const std::string& file, std::vector<std::string> names) {
+		// What a name shows may name further declarations: the return type of a function, the base of a class
+		std::unordered_set<std::string> seen(names.begin(), names.end());
+		while (!names.empty()) {
+			const std::string name = std::move(names.back());
+			names.pop_back();
+			for (const Query query: {Query::SIGNATURE, Query::TYPE, Query::MEMBERS}) {
+				for (const auto& next: read<Interface>(query, file, name).names) {
+					if (seen.insert(next).second) names.push_back(next);
+				}
+			}
+		}
+	}
+
+	QueryEngine::Result QueryEngine::globalScope(const Key& key) {
+		// Phase 1 sees the declarations in order, and of each only what the interface queries cover
+		const auto& names = read<Names>(Query::NAMES, key.file);
+		for (const auto& name: names.distinct) {
+			for (const Query query: {Query::SIGNATURE, Query::TYPE, Query::MEMBERS}) read<Interface>(query, key.file, name);
+		}
+		auto global = std::make_shared<Global>();
+		const auto& parsed = peek<Parsed>(Query::PROGRAM, key.file);
+		if (!parsed.parse) return {global, revision};
+
+		const auto& declarations = parsed.parse->program->declarations;
+		std::vector<polymorphic<ASTNode>> shared;
+		shared.reserve(declarations.size());
+		for (const auto& declaration: declarations) shared.push_back(declaration.share());
+		global->program = make_node<ProgramNode>(parsed.parse->program->loc, std::move(shared));
+		global->analyzer = std::make_unique<SemanticAnalyzer>(global->reporter);
+		try {
+			global->analyzer->declare(global->program);
+		} catch (const std::exception& e) {
+			global->reporter.internalError(global->program->loc, e.what());
+			global->analyzer.reset();
+		}
+
+		for (Diagnostic& d: global->diagnostics.collect()) {
+			Anchored anchored;
+			const auto after = std::ranges::upper_bound(declarations, d.loc.fileOffset, {},
+			                                            [](const polymorphic<ASTNode>& n) { return n->loc.fileOffset; });
+			if (after == declarations.begin()) {
+				anchored.diagnostic = std::move(d);
+				global->found.push_back(std::move(anchored));
+				continue;
+			}
+			const size_t index = after - declarations.begin() - 1;
+			anchored.name = parsed.names[index].front();
+			const auto& same = parsed.byName.at(anchored.name);
+			anchored.node = std::ranges::find(same, index) - same.begin();
+			SourceLocation anchor = declarations[index]->loc;
+			if (const auto* object = dynamic_cast<const ObjectDeclNode*>(declarations[index].get())) {
+				for (size_t i = 0; i < object->members.size(); ++i) {
+					if (object->members[i]->loc.fileOffset > d.loc.fileOffset) break;
+					anchored.member = i;
+					anchor = object->members[i]->loc;
+				}
+			}
+			anchored.diagnostic = relative(std::move(d), anchor);
+			global->found.push_back(std::move(anchored));
+		}
+		return {global, revision};
+	}
+
+	QueryEngine::Result QueryEngine::checkBody(const Key& key) {
+		const auto& declared = read<Declared>(Query::DECLARATION, key.file, key.name);
+		readVisible(key.file, declared.identifiers);
+		// Not a dependency as a whole: of the global scope, the body only sees what the names it mentions show
+		auto& global = peek<Global>(Query::GLOBAL_SCOPE, key.file);
+
+		Checked checked;
+		Hash hash;
+		for (const auto& node: declared.nodes) {
+			auto& found = checked.found.emplace_back();
+			if (!global.analyzer) continue;
+			for (const auto& body: SemanticAnalyzer::bodies(node)) {
+				DiagnosticsEngine engine;
+				ErrorReporter reporter(engine);
+				try {
+					global.analyzer->checkBody(body, reporter);
+				} catch (const std::exception& e) {
+					reporter.internalError(body.function->loc, e.what());
+				}
+				for (Diagnostic& d: engine.collect()) {
+					found.push_back(relative(std::move(d), node->loc));
+					hashDiagnostic(hash, found.back());
+				}
+			}
+			hash << uint64_t{found.size()};
+		}
+		return {boxed(std::move(checked)), hash.value};
+	}
+
+	QueryEngine::Result QueryEngine::diagnostics(const Key& key) {
+		const auto& parsed = read<Parsed>(Query::PROGRAM, key.file);
+		std::vector<Diagnostic> all = parsed.diagnostics;
+		if (parsed.parse) {
+			const auto& global = read<Global>(Query::GLOBAL_SCOPE, key.file);
+			for (const Anchored& anchored: global.found) {
+				if (anchored.node == NONE) {
+					all.push_back(anchored.diagnostic);
+					continue;
+				}
+				const auto& declared = read<Declared>(Query::DECLARATION, key.file, anchored.name);
+				SourceLocation anchor = declared.nodes[anchored.node]->loc;
+				if (anchored.member != NONE) {
+					anchor = declared.nodes[anchored.node].cast().to<ObjectDeclNode>()->members[anchored.member]->loc;
+				}
+				all.push_back(absolute(anchored.diagnostic, anchor));
+			}
+			for (const auto& name: read<Names>(Query::NAMES, key.file).distinct) {
+				const auto& declared = read<Declared>(Query::DECLARATION, key.file, name);
+				if (!declared.hasBodies) continue;
+				const auto& checked = read<Checked>(Query::CHECK_BODY, key.file, name);
+				for (size_t k = 0; k < declared.nodes.size(); ++k) {
+					for (const Diagnostic& d: checked.found[k]) all.push_back(absolute(d, declared.nodes[k]->loc));
+				}
+			}
+		}
+		auto order = [](const Diagnostic& d) { return std::tie(d.loc.line, d.loc.column, d.message); };
+		std::ranges::sort(all, {}, order);
+		all.erase(std::ranges::unique(all, {}, order).begin(), all.end());
+		return {boxed(std::move(all)), revision};
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../exceptions/DiagnosticsEngine.hpp"
+#include "../utils/mainargs.hpp"
+
+namespace zenith {
+	class SemanticAnalyzer;
+	struct IncrementalParse;
+
+	// Demand-driven, memoized analysis of source files that change between requests
+	// Every intermediate result is a query keyed by file and name, computed when first asked for and kept. A query
+	// records which queries it read while it ran. setSource() starts a new revision; a kept result is then reused
+	// ("green") when nothing it read changed since it was last verified, otherwise it runs again. A rerun that comes
+	// out the same as before keeps its old change revision, so the queries that read it stay green as well.
+	//
+	// The queries cut SemanticAnalyzer's two phases along declarations. The global scope only depends on what the
+	// declarations show each other: function signatures, global variables, class members. A body check depends on its
+	// own declaration and on what it can see of every name it mentions, so an edit inside one function body checks
+	// that body again and nothing else. Not thread-safe, one engine serves one thread.
+	class QueryEngine {
+	public:
+		enum class Query : uint8_t {
+			SOURCE,       // Input: the text of a file
+			TOKENS,       // Tokens of a file
+			PROGRAM,      // Tree of a file, reusing the previous one's unchanged declarations
+			NAMES,        // Names of the top-level declarations in source order
+			DECLARATION,  // Top-level declarations of a name, with a fingerprint of their tokens
+			SIGNATURE,    // What callers see of a function: the tokens before its body
+			TYPE,         // What users see of a global variable, or any other declaration: all of it
+			MEMBERS,      // What users see of a class: its header, fields and method signatures
+			GLOBAL_SCOPE, // Phase 1 of SemanticAnalyzer over every declaration
+			CHECK_BODY,   // Function and method bodies of a name checked against the global scope
+			DIAGNOSTICS,  // Everything reported for a file, in source order
+		};
+		static constexpr size_t QUERY_KINDS = static_cast<size_t>(Query::DIAGNOSTICS) + 1;
+
+		// How queries of one kind were brought up to date since resetCounts()
+		struct Counts {
+			size_t green = 0;     // Reused, nothing they read had changed
+			size_t unchanged = 0; // Ran again and came out the same
+			size_t changed = 0;   // Ran for the first time or with a new result
+		};
+
+	private:
+		struct Key {
+			Query query;
+			std::string file;
+			std::string name; // Empty for queries of a whole file
+			friend bool operator==(const Key&, const Key&) = default;
+		};
+		struct KeyHash {
+			size_t operator()(const Key& key) const;
+		};
+		struct Slot {
+			std::shared_ptr<void> value;
+			uint64_t fingerprint = 0;      // Equal fingerprints are equal results
+			uint64_t changedAt = 0;        // Revision the result last changed in
+			uint64_t verifiedAt = 0;       // Revision it was last known to be current in
+			std::vector<Key> dependencies; // What it read, in order
+			bool running = false;
+		};
+		struct Result {
+			std::shared_ptr<void> value;
+			uint64_t fingerprint;
+		};
+		struct Stopped {}; // Thrown out of every running query once stop is requested
+
+		Flags flags;
+		uint64_t revision = 1;
+		std::unordered_map<Key, Slot, KeyHash> slots; // Node-based, slots stay put while others are added
+		std::vector<std::vector<Key>*> running;        // Dependencies of the queries running, innermost last
+		std::array<Counts, QUERY_KINDS> counts{};
+		std::stop_token stop;
+
+		Slot& update(const Key& key);
+		[[nodiscard]] bool outdated(const Slot& slot);
+		void execute(const Key& key, Slot& slot);
+		// The current result of key, recorded as a dependency of the query running
+		template<typename T> const T& read(Query query, const std::string& file, const std::string& name = {});
+		// The same without recording it, for what a query's dependencies already pin down
+		template<typename T> T& peek(Query query, const std::string& file, const std::string& name = {});
+
+		Result tokens(const Key& key);
+		Result program(const Key& key, Slot& slot);
+		Result names(const Key& key);
+		Result declaration(const Key& key, const Slot& slot);
+		Result interface(const Key& key);
+		Result globalScope(const Key& key);
+		Result checkBody(const Key& key);
+		Result diagnostics(const Key& key);
+		void readVisible(const std::string& file, std::vector<std::string> names);
+
+	public:
+		explicit QueryEngine(Flags flags = {}) : flags(std::move(flags)) {}
+
+		QueryEngine(const QueryEngine&) = delete;
+		QueryEngine& operator=(const QueryEngine&) = delete;
+
+		// Replaces the text of file, or adds the file; a new revision unless the text is the same
+		void setSource(const std::string& file, std::string text);
+		// Lex, syntax and semantic diagnostics of file, in source order
+		[[nodiscard]] std::vector<Diagnostic> diagnostics(const std::string& file);
+		// The same, or nothing when stop was requested first; the queries that finished keep their results for next time
+		[[nodiscard]] std::optional<std::vector<Diagnostic>> diagnostics(const std::string& file, std::stop_token stop);
+		// The tokens and tree of file, nullptr while it does not lex or parse
+		[[nodiscard]] const IncrementalParse* parse(const std::string& file);
+		// What phase 1 made of file's declarations, for looking up globals and checking bodies; nullptr without a tree
+		[[nodiscard]] SemanticAnalyzer* analyzer(const std::string& file);
+
+		[[nodiscard]] uint64_t currentRevision() const { return revision; }
+		[[nodiscard]] const Counts& count(Query query) const { return counts[static_cast<size_t>(query)]; }
+		void resetCounts() { counts = {}; }
+		[[nodiscard]] static const char* queryName(Query query);
+	};
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <tuple>
+#include "DiagnosticsEngine.hpp"
+#include "../utils/Colorize.hpp"
+
+namespace zenith {
+	namespace {
+		std::atomic<uint64_t> nextEngineId = 1;
+
+		// Last engine this thread reported to, repeated reports skip the registry lock
+		thread_local uint64_t cachedEngine = 0;
+		thread_local void* cachedBuffer = nullptr;
+
+		const char* severityName(const Severity severity) {
+			switch (severity) {
+				case Severity::WARNING: return "warning";
+				case Severity::ERROR: return "error";
+				case Severity::INTERNAL_ERROR: return "internal error";
+			}
+			return "error";
+		}
+
+		const char* severityColor(const Severity severity) {
+			return severity == Severity::WARNING ? YELLOW_TEXT : RED_TEXT;
+		}
+
+		bool isError(const Severity severity) {
+			return severity != Severity::WARNING;
+		}
+
+		auto sortKey(const Diagnostic& d) {
+			return std::tie(d.loc.file, d.loc.line, d.loc.column, d.severity, d.message, d.loc.length);
+		}
+
+		void writeJsonString(std::string& out, const std::string& value) {
+			out += '"';
+			for (const char c: value) {
+				switch (c) {
+					case '"': out += "\\\""; break;
+					case '\\': out += "\\\\"; break;
+					case '\n': out += "\\n"; break;
+					case '\r': out += "\\r"; break;
+					case '\t': out += "\\t"; break;
+					default:
+						if (static_cast<unsigned char>(c) < 0x20) {
+							constexpr char hex[] = "0123456789abcdef";
+							out += "\\u00";
+							out += hex[(c >> 4) & 0xF];
+							out += hex[c & 0xF];
+						}
+						else out += c;
+				}
+			}
+			out += '"';
+		}
+	}
+
+	DiagnosticsEngine::DiagnosticsEngine() : id(nextEngineId.fetch_add(1, std::memory_order_relaxed)) {}
+
+	DiagnosticsEngine::Buffer& DiagnosticsEngine::localBuffer() {
+		if (cachedEngine == id) return *static_cast<Buffer*>(cachedBuffer);
+
+		const auto self = std::this_thread::get_id();
+		std::lock_guard lock(registryMutex);
+		auto it = std::ranges::find_if(buffers, [&](const auto& b) { return b->owner == self; });
+		if (it == buffers.end()) {
+			buffers.push_back(std::make_unique<Buffer>(Buffer{self, {}}));
+			it = buffers.end() - 1;
+		}
+		cachedEngine = id;
+		cachedBuffer = it->get();
+		return **it;
+	}
+
+	void DiagnosticsEngine::add(Diagnostic diagnostic) {
+		localBuffer().diagnostics.push_back(std::move(diagnostic));
+	}
+
+	size_t DiagnosticsEngine::errorCount() const {
+		size_t count = 0;
+		for (const auto& buffer: buffers) {
+			count += std::ranges::count_if(buffer->diagnostics, [](const Diagnostic& d) { return isError(d.severity); });
+		}
+		return count;
+	}
+
+	std::vector<Diagnostic> DiagnosticsEngine::collect() const {
+		std::vector<Diagnostic> all;
+		size_t total = 0;
+		for (const auto& buffer: buffers) total += buffer->diagnostics.size();
+		all.reserve(total);
+		for (const auto& buffer: buffers) {
+			all.insert(all.end(), buffer->diagnostics.begin(), buffer->diagnostics.end());
+		}
+
+		std::ranges::sort(all, [](const Diagnostic& a, const Diagnostic& b) { return sortKey(a) < sortKey(b); });
+		const auto dupes = std::ranges::unique(all, [](const Diagnostic& a, const Diagnostic& b) {
+			return sortKey(a) == sortKey(b);
+		});
+		all.erase(dupes.begin(), dupes.end());
+		return all;
+	}
+
+	void DiagnosticsEngine::renderText(std::ostream& out) {
+		std::string text;
+		size_t errors = 0;
+		for (const auto& d: collect()) {
+			if (isError(d.severity) && errorLimit && errors++ == errorLimit) {
+				text += BOLD_TEXT "fatal error: " RESET_COLOR "too many errors emitted, stopping now\n";
+				break;
+			}
+
+			const std::string lineNumber = std::to_string(d.loc.line);
+			text += BOLD_TEXT + d.loc.file + ":" + lineNumber + ":" + std::to_string(d.loc.column) + ": " +
+				severityColor(d.severity) + severityName(d.severity) + ": " RESET_COLOR + d.message + "\n";
+			text += "  " + lineNumber + " | " + getSourceLine(d.loc) + "\n";
+
+			// Columns are 1-based
+			text += "  " + std::string(lineNumber.size(), ' ') + " | ";
+			text.append(d.loc.column ? d.loc.column - 1 : 0, ' ');
+			text += severityColor(d.severity);
+			text += '^';
+			if (d.loc.length > 1) text.append(d.loc.length - 1, '~');
+			text += RESET_COLOR "\n";
+		}
+		out << text;
+	}
+
+	void DiagnosticsEngine::renderJson(std::ostream& out) const {
+		std::string json = "{\"diagnostics\":[";
+		size_t errors = 0, warnings = 0;
+		bool truncated = false, first = true;
+		for (const auto& d: collect()) {
+			if (isError(d.severity) && errorLimit && errors == errorLimit) {
+				truncated = true;
+				break;
+			}
+			(isError(d.severity) ? errors : warnings)++;
+
+			if (!first) json += ',';
+			first = false;
+			json += "{\"severity\":\"";
+			json += severityName(d.severity);
+			json += "\",\"file\":";
+			writeJsonString(json, d.loc.file);
+			json += ",\"line\":" + std::to_string(d.loc.line) +
+				",\"column\":" + std::to_string(d.loc.column) +
+				",\"length\":" + std::to_string(d.loc.length) + ",\"message\":";
+			writeJsonString(json, d.message);
+			json += '}';
+		}
+		json += "],\"errorCount\":" + std::to_string(errors) +
+			",\"warningCount\":" + std::to_string(warnings) +
+			",\"truncated\":" + (truncated ? "true" : "false") + "}\n";
+		out << json;
+	}
+
+	const std::string& DiagnosticsEngine::getSourceLine(const SourceLocation& loc) {
+		static const std::string couldNotOpen = "[could not open file]";
+		static const std::string outOfRange = "[line number out of range]";
+
+		auto it = fileLineCache.find(loc.file);
+		if (it == fileLineCache.end()) {
+			std::ifstream file(loc.file);
+			if (!file) return couldNotOpen;
+			Lines lines;
+			for (std::string line; std::getline(file, line);) lines.push_back(std::move(line));
+			it = fileLineCache.emplace(loc.file, std::move(lines)).first;
+		}
+		// Lines are 1-based
+		if (loc.line == 0 || loc.line > it->second.size()) return outOfRange;
+		return it->second[loc.line - 1];
+	}
+
+	void DiagnosticsEngine::clear() {
+		for (auto& buffer: buffers) buffer->diagnostics.clear();
+		fileLineCache.clear();
+	}
+}
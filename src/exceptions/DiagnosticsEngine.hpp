@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../ast/SourceLocation.hpp"
+#include "../utils/MemoryAccounting.hpp"
+
+namespace zenith {
+	enum class Severity : uint8_t {
+		WARNING,
+		ERROR,
+		INTERNAL_ERROR
+	};
+
+	struct Diagnostic {
+		Severity severity;
+		SourceLocation loc;
+		std::string message;
+	};
+
+	// Collects diagnostics from every stage and thread, renders them once at the end.
+	// add() only touches a buffer owned by the calling thread, so producers never contend.
+	// Everything else (counting, rendering, clear) must run after the producers are done.
+	// Nothing is shown before it is rendered, so its owner renders it on every way out, a later phase throwing
+	// included; Driver::compile does.
+	class DiagnosticsEngine {
+		template<typename T>
+		using Counted = CountingAllocator<T, MemoryAccounting::Category::DIAGNOSTICS>;
+
+		struct Buffer {
+			std::thread::id owner;
+			std::vector<Diagnostic, Counted<Diagnostic>> diagnostics;
+		};
+		using Lines = std::vector<std::string, Counted<std::string>>;
+
+		const uint64_t id; // Keys the thread-local buffer cache, addresses can be reused
+		std::mutex registryMutex;
+		std::vector<std::unique_ptr<Buffer>> buffers;
+		size_t errorLimit = 0;
+		std::unordered_map<std::string, Lines, std::hash<std::string>, std::equal_to<std::string>,
+		                   Counted<std::pair<const std::string, Lines>>> fileLineCache;
+
+		Buffer& localBuffer();
+		const std::string& getSourceLine(const SourceLocation& loc);
+
+	public:
+		DiagnosticsEngine();
+		DiagnosticsEngine(const DiagnosticsEngine&) = delete;
+		DiagnosticsEngine& operator=(const DiagnosticsEngine&) = delete;
+
+		void add(Diagnostic diagnostic);
+
+		// 0 = no limit
+		void setErrorLimit(const size_t limit) { errorLimit = limit; }
+
+		[[nodiscard]] size_t errorCount() const;
+		[[nodiscard]] bool hasErrors() const { return errorCount() != 0; }
+
+		// Deduplicated and ordered by file, line and column, independent of which thread produced what
+		[[nodiscard]] std::vector<Diagnostic> collect() const;
+
+		void renderText(std::ostream& out);
+		void renderJson(std::ostream& out) const;
+		void clear();
+	};
+}
@@ -1,23 +1,19 @@
 #pragma once
 
-#include <unordered_map>
-#include <vector>
-#include "../utils/Colorize.hpp"
+#include <string>
+#include "DiagnosticsEngine.hpp"
 #include "../ast/SourceLocation.hpp"
 
 namespace zenith{
+	// Producer side of the DiagnosticsEngine, cheap to copy and safe to use from any thread
 	class ErrorReporter{
-		using errType = std::pair<std::string, std::string>;
-		std::ostream& errStream;
-		std::unordered_map<std::string, std::string> fileCache;
-		std::unordered_map<std::string, std::vector<std::string>> fileLineCache;
-		std::string getSourceLine(const SourceLocation& loc);
+		DiagnosticsEngine& engine;
 	public:
-		explicit ErrorReporter(std::ostream& errStream) : errStream(errStream) {}
-		void report(const SourceLocation& loc,const std::string& message,const errType& errorType = {"error", RED_TEXT});
-		void error(const SourceLocation& loc,const std::string& message) {report(loc, message, {"error", RED_TEXT});}
-		void internalError(const SourceLocation& loc,const std::string& message) {report(loc, message, {"internal error", RED_TEXT});}
-		void warning(const SourceLocation& loc,const std::string& message) {report(loc, message, {"warning", YELLOW_TEXT});}
-		void clearCache();
+		explicit ErrorReporter(DiagnosticsEngine& engine) : engine(engine) {}
+		void report(const SourceLocation& loc,const std::string& message,Severity severity = Severity::ERROR);
+		void error(const SourceLocation& loc,const std::string& message) {report(loc, message, Severity::ERROR);}
+		void internalError(const SourceLocation& loc,const std::string& message) {report(loc, message, Severity::INTERNAL_ERROR);}
+		void warning(const SourceLocation& loc,const std::string& message) {report(loc, message, Severity::WARNING);}
+		[[nodiscard]] DiagnosticsEngine& diagnostics() const { return engine; }
 	};
-}
\ No newline at end of file
+}
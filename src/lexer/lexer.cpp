@@ -1,10 +1,21 @@
 #include "lexer.hpp"
 #include "../exceptions/LexError.hpp"
+#include "../utils/MemoryAccounting.hpp"
+#include <algorithm>
 #include <cctype>
 #include <stdexcept>
 
 using namespace zenith;
 
+namespace {
+	// Tokens a scan can be restarted at. The template string scanner emits the others, and a string literal carries
+	// the line it ends on.
+	bool scanStart(const TokenType type) {
+		return type != TokenType::STRING_LIT && type != TokenType::TEMPLATE_PART && type != TokenType::BACKTICK &&
+		       type != TokenType::DOLLAR_LBRACE && type != TokenType::EOF_TOKEN;
+	}
+}
+
 // Keyword map initialization
 const std::unordered_map<std::string, TokenType> Lexer::keywords = {
 		// Keywords
@@ -77,10 +88,124 @@ std::vector<Token> Lexer::tokenize() && {
 		scanToken();
 	}
 
-	tokens.emplace_back(TokenType::EOF_TOKEN, "", line, column, 0);
+	tokens.emplace_back(TokenType::EOF_TOKEN, "", SourceLocation{line, column, 0, current, fileName});
+	account(tokens);
 	return std::move(tokens);
 }
 
+void Lexer::tokenize(const size_t batchSize, const std::function<bool(std::vector<Token>&&)>& emit) && {
+	tokens.reserve(batchSize);
+	while (!isAtEnd()) {
+		start = current;
+		scanToken();
+		if (tokens.size() >= batchSize) {
+			account(tokens);
+			if (!emit(std::move(tokens))) return;
+			tokens = {};
+			tokens.reserve(batchSize);
+		}
+	}
+
+	tokens.emplace_back(TokenType::EOF_TOKEN, "", SourceLocation{line, column, 0, current, fileName});
+	account(tokens);
+	emit(std::move(tokens));
+}
+
+TokenEdit Lexer::relex(std::vector<Token>& tokens, const std::string& source, const std::string& name,
+                       const TextEdit& edit) {
+	// Scanning a token looks at most two bytes past its end, so the ones ending earlier than that stay as they are
+	size_t kept = std::ranges::partition_point(tokens, [&](const Token& token) {
+		return token.loc.fileOffset + token.loc.length + 2 <= edit.offset;
+	}) - tokens.begin();
+	while (kept > 0 && !scanStart(tokens[kept - 1].type)) --kept;
+	const size_t restart = kept ? kept - 1 : 0; // Scanned again, the start of the scan is known from it
+
+	Lexer lexer(source, name);
+	if (kept) {
+		lexer.current = tokens[restart].loc.fileOffset;
+		lexer.line = tokens[restart].loc.line;
+		lexer.column = tokens[restart].loc.column;
+	}
+
+	// Past the edit, a token that starts a scan where an equal one started before ends the scan: the text from there on
+	// is the same, so are its tokens
+	const ptrdiff_t bytes = static_cast<ptrdiff_t>(edit.inserted) - static_cast<ptrdiff_t>(edit.removed);
+	ptrdiff_t lines = 0;
+	size_t next = restart;       // First old token not before the scan
+	size_t sync = tokens.size(); // Old token the scan ended on, the rest were scanned again when it ran to the end
+	while (!lexer.isAtEnd()) {
+		const size_t produced = lexer.tokens.size();
+		lexer.start = lexer.current;
+		lexer.scanToken();
+		if (lexer.tokens.size() != produced + 1) continue;
+		const Token& token = lexer.tokens.back();
+		if (token.loc.fileOffset < edit.offset + edit.inserted || !scanStart(token.type)) continue;
+		const size_t oldOffset = token.loc.fileOffset - bytes;
+		while (next < tokens.size() && tokens[next].loc.fileOffset < oldOffset) ++next;
+		if (next == tokens.size()) continue;
+		const Token& same = tokens[next];
+		if (same.loc.fileOffset != oldOffset || same.type != token.type || same.loc.column != token.loc.column ||
+		    same.lexeme != token.lexeme) continue;
+		lines = static_cast<ptrdiff_t>(token.loc.line) - static_cast<ptrdiff_t>(same.loc.line);
+		sync = next;
+		lexer.tokens.pop_back();
+		break;
+	}
+	if (sync == tokens.size()) {
+		lexer.tokens.emplace_back(TokenType::EOF_TOKEN, "", SourceLocation{lexer.line, lexer.column, 0, lexer.current, name});
+	}
+
+	// The first tokens scanned again can be the ones that were there
+	std::vector<Token>& scanned = lexer.tokens;
+	size_t unchanged = 0;
+	while (unchanged < scanned.size() && restart + unchanged < sync) {
+		const Token& now = scanned[unchanged];
+		const Token& was = tokens[restart + unchanged];
+		if (now.type != was.type || now.lexeme != was.lexeme || now.loc.fileOffset != was.loc.fileOffset ||
+		    now.loc.line != was.loc.line || now.loc.column != was.loc.column || now.loc.length != was.loc.length) break;
+		++unchanged;
+	}
+	const TokenEdit result{restart + unchanged, sync - restart - unchanged, scanned.size() - unchanged, lines, bytes};
+
+	// The tokens from sync on go to where the new ones end, moved and shifted in one pass
+	const size_t end = tokens.size(), to = result.begin + result.inserted;
+	auto move = [&](const size_t from, const size_t into) {
+		Token& token = tokens[into];
+		if (from != into) token = std::move(tokens[from]);
+		token.loc.line += lines;
+		token.loc.fileOffset += bytes;
+	};
+	if (to <= sync) {
+		for (size_t i = sync; i < end; ++i) move(i, i - (sync - to));
+	}
+	else {
+		const size_t grow = to - sync;
+		// Room to type into without moving the whole list every time
+		if (end + grow > tokens.capacity()) tokens.reserve(end + grow + end / 16);
+		for (size_t i = 0; i < grow; ++i) tokens.emplace_back(TokenType::EOF_TOKEN, "", SourceLocation{});
+		for (size_t i = end; i-- > sync;) move(i, i + grow);
+	}
+	for (size_t i = 0; i < result.inserted; ++i) tokens[result.begin + i] = std::move(scanned[unchanged + i]);
+	if (to < sync) tokens.erase(tokens.end() - static_cast<ptrdiff_t>(sync - to), tokens.end());
+	return result;
+}
+
+void Lexer::account(const std::vector<Token>& tokens) {
+	if (!MemoryAccounting::enabled()) return;
+	// Charged once as the tokens are handed over, they live about as long as the compile
+	size_t bytes = tokens.capacity() * sizeof(Token), allocations = 1;
+	auto external = [&](const std::string& text) {
+		if (text.capacity() <= std::string().capacity()) return; // Stored inline
+		bytes += text.capacity() + 1;
+		++allocations;
+	};
+	for (const Token& token: tokens) {
+		external(token.lexeme);
+		external(token.loc.file);
+	}
+	MemoryAccounting::allocated(MemoryAccounting::Category::TOKENS, bytes, allocations);
+}
+
 bool Lexer::isAtEnd() const {
 	return current >= source.length();
 }
@@ -266,10 +391,9 @@ void Lexer::string() {
 }
 
 void Lexer::templateString() {
-	// Add opening backtick
+	// Add opening backtick, scanToken() already consumed it
 	tokens.emplace_back(TokenType::BACKTICK, "`",
-	                    SourceLocation{line, column, 1, current, fileName});
-	advance();  // Consume opening backtick
+	                    SourceLocation{line, column - 1, 1, current - 1, fileName});
 	start = current;  // Start of actual template content
 	startColumn = column;  // Track starting column
 
@@ -356,15 +480,12 @@ void Lexer::number() {
 void Lexer::identifier() {
 	while (isalnum(peek()) || peek() == '_') advance();
 
-	std::string text = source.substr(start, current - start);
+	addToken(wordType(source.substr(start, current - start)));
+}
 
-	// Check if it's a keyword
-	auto it = keywords.find(text);
-	if (it != keywords.end()) {
-		addToken(it->second);
-	} else {
-		addToken(TokenType::IDENTIFIER);
-	}
+TokenType Lexer::wordType(const std::string& text) {
+	const auto it = keywords.find(text);
+	return it != keywords.end() ? it->second : TokenType::IDENTIFIER;
 }
 
 char Lexer::peek() const {
@@ -1,6 +1,8 @@
 // src/lexer/lexer.hpp
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -41,6 +43,23 @@ namespace zenith{
 		EOF_TOKEN
 	};
 
+	// A change to the source: bytes [offset, offset + removed) of the old text became `inserted` new bytes
+	struct TextEdit {
+		size_t offset;
+		size_t removed;
+		size_t inserted;
+	};
+
+	// The same change to a token list: tokens [begin, begin + removed) became `inserted` new ones, the tokens after
+	// them are the old ones moved by lines and bytes
+	struct TokenEdit {
+		size_t begin = 0;
+		size_t removed = 0;
+		size_t inserted = 0;
+		ptrdiff_t lines = 0;
+		ptrdiff_t bytes = 0;
+	};
+
 	struct Token {
 		TokenType type;
 		std::string lexeme;
@@ -55,7 +74,17 @@ namespace zenith{
 	public:
 		Lexer(const std::string& source, const std::string& name);
 		std::vector<Token> tokenize() && ;
+		// The same tokens handed to emit in batches of about batchSize as they are scanned, the last one ends with
+		// EOF_TOKEN. Stops early when emit returns false.
+		void tokenize(size_t batchSize, const std::function<bool(std::vector<Token>&&)>& emit) &&;
+		// Turns the tokens of the text before edit into the tokens of source, in place: only the tokens around the
+		// edit are scanned, the ones after it stay with their lines and offsets moved. Throws like tokenize(), and
+		// leaves tokens as they were then.
+		static TokenEdit relex(std::vector<Token>& tokens, const std::string& source, const std::string& name,
+		                       const TextEdit& edit);
 		static std::string tokenToString(TokenType type);
+		// The keyword's token type, IDENTIFIER for any other word
+		static TokenType wordType(const std::string& text);
 		size_t tokenStart = 0;
 		size_t startColumn = 1;
 	private:
@@ -63,6 +92,7 @@ namespace zenith{
 		bool match(char expected);
 		void addToken(TokenType type);
 		void scanToken();
+		static void account(const std::vector<Token>& tokens); // Charges a batch to MemoryAccounting
 		void identifier();
 		void number();
 		void string();
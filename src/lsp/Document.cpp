@@ -0,0 +1,373 @@
+#include "Document.hpp"
+#include <algorithm>
+
+namespace zenith {
+	namespace {
+		// The engine holds this one document, under no name
+		const std::string FILE_NAME;
+
+		size_t sequenceLength(const unsigned char lead) {
+			return lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+		}
+
+		const char* kindName(const SymbolInfo::Kind kind) {
+			switch (kind) {
+				case SymbolInfo::VARIABLE: return "variable";
+				case SymbolInfo::FUNCTION: return "function";
+				case SymbolInfo::OBJECT: return "object";
+				case SymbolInfo::ACTOR: return "actor";
+				case SymbolInfo::TYPE_ALIAS: return "type";
+				case SymbolInfo::TEMPLATE_PARAM: return "template parameter";
+				default: return "symbol";
+			}
+		}
+
+		// LSP SymbolKind
+		enum SymbolKind { CLASS = 5, METHOD = 6, FIELD = 8, CONSTRUCTOR = 9, FUNCTION = 12, VARIABLE = 13, CONSTANT = 14,
+		                  STRUCT = 23 };
+	}
+
+	Document::Document(std::string text, const int64_t version, const bool utf16)
+		: utf16(utf16), text(std::move(text)), textVersion(version) {
+		lineStarts = lines(this->text);
+	}
+
+	std::vector<size_t> Document::lines(const std::string_view text) {
+		std::vector<size_t> starts{0};
+		for (size_t at = text.find('\n'); at != std::string_view::npos; at = text.find('\n', at + 1)) {
+			starts.push_back(at + 1);
+		}
+		return starts;
+	}
+
+	size_t Document::offsetAt(const std::string& in, const std::vector<size_t>& starts, const Position position) const {
+		if (position.line >= starts.size()) return in.size();
+		const size_t begin = starts[position.line];
+		const size_t end = position.line + 1 < starts.size() ? starts[position.line + 1] - 1 : in.size();
+		if (!utf16) return std::min(begin + position.character, end);
+		size_t at = begin;
+		for (size_t units = 0; at < end && units < position.character;) {
+			const size_t bytes = sequenceLength(static_cast<unsigned char>(in[at]));
+			units += bytes == 4 ? 2 : 1; // Outside the basic plane takes a surrogate pair
+			at += bytes;
+		}
+		return std::min(at, end);
+	}
+
+	Document::Position Document::positionAt(const std::string& in, const std::vector<size_t>& starts,
+	                                        size_t offset) const {
+		offset = std::min(offset, in.size());
+		const size_t line = std::ranges::upper_bound(starts, offset) - starts.begin() - 1;
+		if (!utf16) return {line, offset - starts[line]};
+		size_t units = 0;
+		for (size_t at = starts[line]; at < offset;) {
+			const size_t bytes = sequenceLength(static_cast<unsigned char>(in[at]));
+			units += bytes == 4 ? 2 : 1;
+			at += bytes;
+		}
+		return {line, units};
+	}
+
+	Document::Range Document::rangeOf(const size_t begin, const size_t end) const {
+		return {positionAt(parsedText, parsedLines, begin), positionAt(parsedText, parsedLines, std::max(begin, end))};
+	}
+
+	void Document::change(const std::optional<Range>& range, const std::string_view newText, const int64_t version) {
+		std::lock_guard lock(textMutex);
+		size_t begin = 0, end = text.size();
+		if (range) {
+			begin = offsetAt(text, lineStarts, range->start);
+			end = offsetAt(text, lineStarts, range->end);
+			if (end < begin) std::swap(begin, end);
+		}
+		text.replace(begin, end - begin, newText);
+
+		// Lines starting after the replaced text move along, the ones in it are found again
+		const ptrdiff_t bytes = static_cast<ptrdiff_t>(newText.size()) - static_cast<ptrdiff_t>(end - begin);
+		const auto first = std::ranges::upper_bound(lineStarts, begin) - lineStarts.begin();
+		const auto last = std::ranges::upper_bound(lineStarts, end) - lineStarts.begin();
+		for (size_t i = last; i < lineStarts.size(); ++i) lineStarts[i] += bytes;
+		std::vector<size_t> inserted;
+		for (size_t at = newText.find('\n'); at != std::string_view::npos; at = newText.find('\n', at + 1)) {
+			inserted.push_back(begin + at + 1);
+		}
+		lineStarts.erase(lineStarts.begin() + first, lineStarts.begin() + last);
+		lineStarts.insert(lineStarts.begin() + first, inserted.begin(), inserted.end());
+
+		pending = true;
+		textVersion = version;
+	}
+
+	int64_t Document::version() const {
+		std::lock_guard lock(textMutex);
+		return textVersion;
+	}
+
+	std::string Document::content() const {
+		std::lock_guard lock(textMutex);
+		return text;
+	}
+
+	void Document::refresh() {
+		{
+			std::lock_guard lock(textMutex);
+			parsedVersion = textVersion;
+			if (!pending) return;
+			pending = false;
+			parsedText = text;
+			parsedLines = lineStarts;
+		}
+		// The engine finds what changed by comparing the texts, a text that does not lex keeps the last tree for after it
+		engine.setSource(FILE_NAME, parsedText);
+		parse = engine.parse(FILE_NAME);
+		if (parse) {
+			counts.tokens = parse->tokens.size();
+			counts.reusedDeclarations = parse->reusedDeclarations;
+		}
+	}
+
+	std::unique_lock<std::mutex> Document::lockState() {
+		{
+			std::lock_guard lock(pauseMutex);
+			++requested;
+			if (pause) pause->request_stop();
+		}
+		std::unique_lock state(stateMutex);
+		{
+			std::lock_guard lock(pauseMutex);
+			++served;
+		}
+		handedOff.notify_all();
+		return state;
+	}
+
+	std::optional<std::pair<int64_t, std::vector<Document::Problem>>> Document::diagnostics(const std::stop_token stop) {
+		std::unique_lock lock(stateMutex);
+		engine.resetCounts();
+		std::optional<std::vector<Diagnostic>> all;
+		while (!all) {
+			if (stop.stop_requested()) return std::nullopt;
+			refresh();
+			std::stop_source paused;
+			{
+				std::lock_guard guard(pauseMutex);
+				pause = &paused;
+			}
+			{
+				std::stop_callback forward(stop, [&] { paused.request_stop(); });
+				all = engine.diagnostics(FILE_NAME, paused.get_token());
+			}
+			uint64_t ahead; // Requests to let in before going on
+			{
+				std::lock_guard guard(pauseMutex);
+				pause = nullptr;
+				ahead = requested;
+			}
+			if (!all) {
+				// Lets the requests that paused this in, what the engine finished so far is kept
+				lock.unlock();
+				{
+					std::unique_lock guard(pauseMutex);
+					handedOff.wait(guard, [&] { return served >= ahead; });
+				}
+				lock.lock();
+			}
+		}
+		const auto& checked = engine.count(QueryEngine::Query::CHECK_BODY);
+		counts.bodiesChecked = checked.unchanged + checked.changed;
+		counts.bodiesReused = checked.green;
+
+		std::vector<Problem> problems;
+		problems.reserve(all->size());
+		for (Diagnostic& d: *all) {
+			size_t begin = 0;
+			if (d.loc.line > 0 && d.loc.line <= parsedLines.size()) {
+				begin = std::min(parsedLines[d.loc.line - 1] + (d.loc.column ? d.loc.column - 1 : 0), parsedText.size());
+			}
+			problems.push_back({rangeOf(begin, begin + std::max<size_t>(d.loc.length, 1)), d.severity, std::move(d.message)});
+		}
+		return std::pair{parsedVersion, std::move(problems)};
+	}
+
+	const Token* Document::tokenAt(const size_t offset) const {
+		if (!parse) return nullptr;
+		const auto& tokens = parse->tokens;
+		auto it = std::ranges::partition_point(tokens, [&](const Token& t) { return t.loc.fileOffset <= offset; });
+		if (it == tokens.begin()) return nullptr;
+		const Token* token = &*--it;
+		// Just past a name counts as on it, the way a cursor sits after what was typed
+		if (token->type != TokenType::IDENTIFIER && it != tokens.begin()) {
+			const Token& before = *(it - 1);
+			if (before.type == TokenType::IDENTIFIER && before.loc.fileOffset + before.loc.length == offset) return &before;
+		}
+		if (offset > token->loc.fileOffset + token->loc.length || token->type == TokenType::EOF_TOKEN) return nullptr;
+		return token;
+	}
+
+	const Token* Document::nameToken(const ASTNode& declaration, const std::string& name) const {
+		const auto& tokens = parse->tokens;
+		auto it = std::ranges::partition_point(tokens, [&](const Token& t) {
+			return t.loc.fileOffset < declaration.loc.fileOffset;
+		});
+		// The name follows within a few tokens: keyword, modifiers, type
+		for (size_t i = 0; i < 16 && it != tokens.end(); ++i, ++it) {
+			if (it->type == TokenType::IDENTIFIER && it->lexeme == name) return &*it;
+		}
+		return nullptr;
+	}
+
+	Document::Range Document::tokenRange(const Token& token) const {
+		return rangeOf(token.loc.fileOffset, token.loc.fileOffset + token.loc.length);
+	}
+
+	Document::Range Document::spanRange(const size_t begin, const size_t next) const {
+		const auto& tokens = parse->tokens;
+		auto first = std::ranges::partition_point(tokens, [&](const Token& t) { return t.loc.fileOffset < begin; });
+		auto end = std::ranges::partition_point(tokens, [&](const Token& t) { return t.loc.fileOffset < next; });
+		if (end != tokens.begin() && (end - 1)->type == TokenType::EOF_TOKEN) --end;
+		if (first == tokens.end() || end <= first) return rangeOf(begin, begin);
+		const Token& last = *(end - 1);
+		return rangeOf(first->loc.fileOffset, last.loc.fileOffset + last.loc.length);
+	}
+
+	size_t Document::declarationAt(const size_t offset) const {
+		const auto& declarations = parse->program->declarations;
+		const auto it = std::ranges::partition_point(declarations, [&](const polymorphic<ASTNode>& d) {
+			return d->loc.fileOffset <= offset;
+		});
+		return it == declarations.begin() ? SIZE_MAX : it - declarations.begin() - 1;
+	}
+
+	std::vector<SemanticAnalyzer::Reference> Document::referencesIn(SemanticAnalyzer& analyzer, const size_t declaration) {
+		std::vector<SemanticAnalyzer::Reference> references;
+		DiagnosticsEngine discarded;
+		ErrorReporter reporter(discarded);
+		for (const auto& body: SemanticAnalyzer::bodies(parse->program->declarations[declaration])) {
+			analyzer.checkBody(body, reporter, &references);
+		}
+		return references;
+	}
+
+	std::optional<SemanticAnalyzer::Reference> Document::referenceAt(SemanticAnalyzer& analyzer, const Token& token) {
+		const size_t declaration = declarationAt(token.loc.fileOffset);
+		if (declaration != SIZE_MAX) {
+			const auto references = referencesIn(analyzer, declaration);
+			const Token* before = &token == parse->tokens.data() ? nullptr : &token - 1;
+			const bool member = before && before->type == TokenType::DOT;
+			const SemanticAnalyzer::Reference* closest = nullptr;
+			for (const auto& reference: references) {
+				if (auto var = reference.use.cast().non_throwing().to<VarNode>()) {
+					if (!member && var->loc.fileOffset == token.loc.fileOffset) return reference;
+				}
+				else if (auto access = reference.use.cast().non_throwing().to<MemberAccessNode>()) {
+					// Every access of a chain starts where the chain does, the nearest chain start wins
+					if (member && access->member == token.lexeme && access->loc.fileOffset < token.loc.fileOffset &&
+					    (!closest || closest->use->loc.fileOffset < access->loc.fileOffset)) closest = &reference;
+				}
+			}
+			if (closest) return *closest;
+			// The name of a declaration the body uses somewhere
+			for (const auto& reference: references) {
+				if (reference.declaration && nameToken(*reference.declaration, token.lexeme) == &token) return reference;
+			}
+		}
+
+		// A global, by its own name or from a global initializer
+		const auto symbol = analyzer.globals().lookup(token.lexeme);
+		if (!symbol || !symbol->declarationNode) return std::nullopt;
+		const bool ownName = nameToken(*symbol->declarationNode, token.lexeme) == &token;
+		const bool inInitializer = declaration != SIZE_MAX &&
+		                           (parse->program->declarations[declaration].is_type<VarDeclNode>() ||
+		                            parse->program->declarations[declaration].is_type<MultiVarDeclNode>());
+		if (!ownName && !inInitializer) return std::nullopt;
+		return SemanticAnalyzer::Reference{nullptr, symbol->declarationNode, symbol->kind,
+		                                   SemanticAnalyzer::typeToString(symbol->type)};
+	}
+
+	std::optional<Document::Hover> Document::hover(const Position position) {
+		const auto lock = lockState();
+		refresh();
+		SemanticAnalyzer* analyzer = engine.analyzer(FILE_NAME);
+		if (!parse || !analyzer) return std::nullopt;
+		const Token* token = tokenAt(offsetAt(parsedText, parsedLines, position));
+		if (!token || token->type != TokenType::IDENTIFIER) return std::nullopt;
+		const auto reference = referenceAt(*analyzer, *token);
+		if (!reference) return std::nullopt;
+
+		std::string label = std::string(kindName(reference->kind)) + " " + token->lexeme;
+		if (reference->kind != SymbolInfo::OBJECT && reference->kind != SymbolInfo::ACTOR) label += ": " + reference->type;
+		return Hover{"```zenith\n" + label + "\n```", tokenRange(*token)};
+	}
+
+	std::optional<Document::Range> Document::definition(const Position position) {
+		const auto lock = lockState();
+		refresh();
+		SemanticAnalyzer* analyzer = engine.analyzer(FILE_NAME);
+		if (!parse || !analyzer) return std::nullopt;
+		const Token* token = tokenAt(offsetAt(parsedText, parsedLines, position));
+		if (!token || token->type != TokenType::IDENTIFIER) return std::nullopt;
+		const auto reference = referenceAt(*analyzer, *token);
+		if (!reference || !reference->declaration) return std::nullopt;
+		if (const Token* name = nameToken(*reference->declaration, token->lexeme)) return tokenRange(*name);
+		const SourceLocation& loc = reference->declaration->loc;
+		return rangeOf(loc.fileOffset, loc.fileOffset + loc.length);
+	}
+
+	void Document::addSymbol(std::vector<Symbol>& symbols, polymorphic_ref<ASTNode> node, const size_t next) {
+		if (auto templ = node.cast().non_throwing().to<TemplateDeclNode>()) node = templ->declaration;
+		auto add = [&](const std::string& name, const int kind, const ASTNode& declaration) -> Symbol& {
+			const Token* nameAt = nameToken(declaration, name);
+			const Range selection = nameAt ? tokenRange(*nameAt) : rangeOf(declaration.loc.fileOffset, declaration.loc.fileOffset);
+			Range range = spanRange(declaration.loc.fileOffset, next);
+			if (range.end.line < selection.end.line ||
+			    (range.end.line == selection.end.line && range.end.character < selection.end.character)) range.end = selection.end;
+			return symbols.emplace_back(Symbol{name, kind, range, selection, {}});
+		};
+
+		if (auto object = node.cast().non_throwing().to<ObjectDeclNode>()) {
+			Symbol& symbol = add(object->name, object->kind == ObjectDeclNode::Kind::STRUCT ? STRUCT : CLASS, *object);
+			// The last member ends before the object's closing brace
+			const auto& tokens = parse->tokens;
+			auto end = std::ranges::partition_point(tokens, [&](const Token& t) { return t.loc.fileOffset < next; });
+			while (end != tokens.begin() && (end - 1)->type == TokenType::EOF_TOKEN) --end;
+			const size_t close = end == tokens.begin() ? next : (end - 1)->loc.fileOffset;
+			for (size_t i = 0; i < object->members.size(); ++i) {
+				const size_t after = i + 1 < object->members.size() ? object->members[i + 1]->loc.fileOffset : close;
+				addSymbol(symbol.children, object->members[i], after);
+			}
+		}
+		else if (auto function = node.cast().non_throwing().to<FunctionDeclNode>()) {
+			const int kind = dynamic_cast<const CtorDeclNode*>(function.get()) ? CONSTRUCTOR
+			                 : dynamic_cast<const MethodDeclNode*>(function.get()) ? METHOD : FUNCTION;
+			add(function->name, kind, *function);
+		}
+		else if (auto fieldDecl = node.cast().non_throwing().to<FieldDeclNode>()) {
+			add(fieldDecl->name, FIELD, *fieldDecl);
+		}
+		else if (auto var = node.cast().non_throwing().to<VarDeclNode>()) {
+			add(var->name, var->isConst ? CONSTANT : VARIABLE, *var);
+		}
+		else if (auto vars = node.cast().non_throwing().to<MultiVarDeclNode>()) {
+			for (size_t i = 0; i < vars->vars.size(); ++i) {
+				addSymbol(symbols, vars->vars[i], i + 1 < vars->vars.size() ? vars->vars[i + 1]->loc.fileOffset : next);
+			}
+		}
+	}
+
+	std::vector<Document::Symbol> Document::symbols() {
+		const auto lock = lockState();
+		refresh();
+		std::vector<Symbol> symbols;
+		if (!parse) return symbols;
+		const auto& declarations = parse->program->declarations;
+		for (size_t i = 0; i < declarations.size(); ++i) {
+			addSymbol(symbols, declarations[i], i + 1 < declarations.size() ? declarations[i + 1]->loc.fileOffset : SIZE_MAX);
+		}
+		return symbols;
+	}
+
+	Document::Stats Document::stats() {
+		std::lock_guard lock(stateMutex);
+		return counts;
+	}
+}
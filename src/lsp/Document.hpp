@@ -0,0 +1,119 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../driver/QueryEngine.hpp"
+#include "../parser/parser.hpp"
+#include "../SemanticAnalysis/SemanticAnalyzer.hpp"
+
+namespace zenith {
+	// One document open in the language server, with what is known about it
+	// The text follows the client's edits as they arrive. Everything worked out from it comes from a QueryEngine that
+	// is given the latest text on the next request, so an edit inside one body checks that body again and nothing
+	// else. Every method may be called from any thread.
+	class Document {
+	public:
+		// Lines from 0, characters in UTF-16 code units or in bytes, whichever the client and server agreed on
+		struct Position {
+			size_t line = 0, character = 0;
+			friend bool operator==(const Position&, const Position&) = default;
+		};
+
+		struct Range {
+			Position start, end;
+			friend bool operator==(const Range&, const Range&) = default;
+		};
+
+		struct Problem {
+			Range range;
+			Severity severity;
+			std::string message;
+		};
+
+		struct Symbol {
+			std::string name;
+			int kind; // LSP SymbolKind
+			Range range, selection;
+			std::vector<Symbol> children;
+		};
+
+		struct Hover {
+			std::string markdown;
+			Range range;
+		};
+
+		struct Stats {
+			size_t tokens = 0;
+			size_t reusedDeclarations = 0; // Of the last parse
+			size_t bodiesChecked = 0;      // By the last diagnostics(), counted per name: a class's methods are one
+			size_t bodiesReused = 0;
+		};
+
+	private:
+		const bool utf16;
+
+		// What the client sent, guarded by textMutex
+		mutable std::mutex textMutex;
+		std::string text;
+		int64_t textVersion;
+		std::vector<size_t> lineStarts;
+		bool pending = true; // Changed since the last refresh
+
+		// What was worked out from it, guarded by stateMutex
+		std::mutex stateMutex;
+		std::string parsedText;
+		std::vector<size_t> parsedLines;
+		int64_t parsedVersion = -1;
+		QueryEngine engine;
+		const IncrementalParse* parse = nullptr; // The engine's, until the next refresh
+		Stats counts;
+
+		// Lets another request in between two queries of a running diagnostics(), guarded by pauseMutex
+		std::mutex pauseMutex;
+		std::stop_source* pause = nullptr;
+		// Requests that asked for stateMutex through lockState() and that got it, a paused diagnostics() waits on
+		// handedOff until every request that asked before it paused has had its turn
+		uint64_t requested = 0, served = 0;
+		std::condition_variable handedOff;
+
+		static std::vector<size_t> lines(std::string_view text);
+		[[nodiscard]] size_t offsetAt(const std::string& in, const std::vector<size_t>& starts, Position position) const;
+		[[nodiscard]] Position positionAt(const std::string& in, const std::vector<size_t>& starts, size_t offset) const;
+		[[nodiscard]] Range rangeOf(size_t begin, size_t end) const; // In parsedText
+
+		void refresh(); // Brings the state up to the latest text, needs stateMutex
+		std::unique_lock<std::mutex> lockState(); // Pauses a running diagnostics() to get stateMutex sooner
+		[[nodiscard]] const Token* tokenAt(size_t offset) const;
+		[[nodiscard]] const Token* nameToken(const ASTNode& declaration, const std::string& name) const;
+		[[nodiscard]] Range tokenRange(const Token& token) const;
+		[[nodiscard]] Range spanRange(size_t begin, size_t next) const; // Tokens from offset begin to before next
+		[[nodiscard]] size_t declarationAt(size_t offset) const;         // Index of the top-level declaration
+		std::vector<SemanticAnalyzer::Reference> referencesIn(SemanticAnalyzer& analyzer, size_t declaration);
+		std::optional<SemanticAnalyzer::Reference> referenceAt(SemanticAnalyzer& analyzer, const Token& token);
+		void addSymbol(std::vector<Symbol>& symbols, polymorphic_ref<ASTNode> node, size_t next);
+
+	public:
+		Document(std::string text, int64_t version, bool utf16 = true);
+
+		// Replaces range of the text, or all of it when there is no range
+		void change(const std::optional<Range>& range, std::string_view newText, int64_t version);
+		[[nodiscard]] int64_t version() const;
+		[[nodiscard]] std::string content() const;
+
+		// The diagnostics of the latest text and its version. Nothing when stop was requested before they were complete.
+		// Other requests may come in between two queries, the analysis then goes on with the text they saw.
+		std::optional<std::pair<int64_t, std::vector<Problem>>> diagnostics(std::stop_token stop = {});
+		std::optional<Hover> hover(Position position);
+		// Where the name at position was declared
+		std::optional<Range> definition(Position position);
+		std::vector<Symbol> symbols();
+
+		[[nodiscard]] Stats stats();
+	};
+}
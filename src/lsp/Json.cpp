@@ -0,0 +1,314 @@
+#include "Json.hpp"
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace zenith {
+	namespace {
+		class Reader {
+			std::string_view text;
+			size_t at = 0;
+			size_t depth = 0;
+
+			[[noreturn]] void fail(const std::string& what) const {
+				throw std::runtime_error("Malformed JSON at byte " + std::to_string(at) + ": " + what);
+			}
+
+			void skipSpace() {
+				while (at < text.size() && (text[at] == ' ' || text[at] == '\t' || text[at] == '\n' || text[at] == '\r')) ++at;
+			}
+
+			void expect(const std::string_view word) {
+				if (text.substr(at, word.size()) != word) fail("expected " + std::string(word));
+				at += word.size();
+			}
+
+			uint32_t hex4() {
+				if (at + 4 > text.size()) fail("short \\u escape");
+				uint32_t code = 0;
+				for (size_t i = 0; i < 4; ++i) {
+					const char c = text[at++];
+					code <<= 4;
+					if (c >= '0' && c <= '9') code |= c - '0';
+					else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+					else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+					else fail("bad \\u escape");
+				}
+				return code;
+			}
+
+			static void appendUtf8(std::string& out, const uint32_t code) {
+				if (code < 0x80) out += static_cast<char>(code);
+				else if (code < 0x800) {
+					out += static_cast<char>(0xC0 | code >> 6);
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else if (code < 0x10000) {
+					out += static_cast<char>(0xE0 | code >> 12);
+					out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else {
+					out += static_cast<char>(0xF0 | code >> 18);
+					out += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+					out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+			}
+
+			std::string string() {
+				++at; // '"'
+				std::string out;
+				while (true) {
+					// Copy the run up to the next quote or escape at once, document texts are megabytes long
+					const size_t end = text.find_first_of("\"\\", at);
+					if (end == std::string_view::npos) fail("unterminated string");
+					out.append(text.data() + at, end - at);
+					at = end + 1;
+					if (text[end] == '"') return out;
+					if (at >= text.size()) fail("unterminated string");
+					switch (const char c = text[at++]) {
+						case '"': out += '"'; break;
+						case '\\': out += '\\'; break;
+						case '/': out += '/'; break;
+						case 'b': out += '\b'; break;
+						case 'f': out += '\f'; break;
+						case 'n': out += '\n'; break;
+						case 'r': out += '\r'; break;
+						case 't': out += '\t'; break;
+						case 'u': {
+							uint32_t code = hex4();
+							if (code >= 0xD800 && code < 0xDC00 && text.substr(at, 2) == "\\u") {
+								at += 2;
+								const uint32_t low = hex4();
+								if (low < 0xDC00 || low >= 0xE000) fail("unpaired surrogate");
+								code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+							}
+							appendUtf8(out, code);
+							break;
+						}
+						default: fail(std::string("bad escape \\") + c);
+					}
+				}
+			}
+
+			Json number() {
+				const size_t begin = at;
+				if (at < text.size() && text[at] == '-') ++at;
+				while (at < text.size() && (std::isdigit(static_cast<unsigned char>(text[at])) || text[at] == '.' ||
+				                            text[at] == 'e' || text[at] == 'E' || text[at] == '+' || text[at] == '-')) ++at;
+				double n = 0;
+				const auto [end, error] = std::from_chars(text.data() + begin, text.data() + at, n);
+				if (error != std::errc() || end != text.data() + at) fail("bad number");
+				return n;
+			}
+
+		public:
+			explicit Reader(const std::string_view text) : text(text) {}
+
+			Json value() {
+				skipSpace();
+				if (at >= text.size()) fail("unexpected end");
+				if (++depth > 512) fail("nested too deeply");
+				Json result;
+				switch (text[at]) {
+					case '{': {
+						++at;
+						Json::Object members;
+						skipSpace();
+						if (at < text.size() && text[at] == '}') ++at;
+						else {
+							while (true) {
+								skipSpace();
+								if (at >= text.size() || text[at] != '"') fail("expected a member name");
+								std::string key = string();
+								skipSpace();
+								expect(":");
+								members.emplace_back(std::move(key), value());
+								skipSpace();
+								if (at < text.size() && text[at] == ',') ++at;
+								else {
+									expect("}");
+									break;
+								}
+							}
+						}
+						result = std::move(members);
+						break;
+					}
+					case '[': {
+						++at;
+						Json::Array elements;
+						skipSpace();
+						if (at < text.size() && text[at] == ']') ++at;
+						else {
+							while (true) {
+								elements.push_back(value());
+								skipSpace();
+								if (at < text.size() && text[at] == ',') ++at;
+								else {
+									expect("]");
+									break;
+								}
+							}
+						}
+						result = std::move(elements);
+						break;
+					}
+					case '"': result = string(); break;
+					case 't': expect("true"); result = true; break;
+					case 'f': expect("false"); result = false; break;
+					case 'n': expect("null"); break;
+					default: result = number();
+				}
+				--depth;
+				return result;
+			}
+
+			void finish() {
+				skipSpace();
+				if (at != text.size()) fail("trailing characters");
+			}
+		};
+
+		void writeString(std::string& out, const std::string& value) {
+			out += '"';
+			for (const char c: value) {
+				switch (c) {
+					case '"': out += "\\\""; break;
+					case '\\': out += "\\\\"; break;
+					case '\n': out += "\\n"; break;
+					case '\r': out += "\\r"; break;
+					case '\t': out += "\\t"; break;
+					default:
+						if (static_cast<unsigned char>(c) < 0x20) {
+							constexpr char hex[] = "0123456789abcdef";
+							out += "\\u00";
+							out += hex[(c >> 4) & 0xF];
+							out += hex[c & 0xF];
+						}
+						else out += c;
+				}
+			}
+			out += '"';
+		}
+
+		const Json null;
+		const std::string emptyString;
+		const Json::Array emptyArray;
+	}
+
+	Json Json::parse(const std::string_view text) {
+		Reader reader(text);
+		Json result = reader.value();
+		reader.finish();
+		return result;
+	}
+
+	std::string Json::dump() const {
+		std::string out;
+		dump(out);
+		return out;
+	}
+
+	void Json::dump(std::string& out) const {
+		if (isNull()) out += "null";
+		else if (const bool* b = std::get_if<bool>(&value)) out += *b ? "true" : "false";
+		else if (const double* n = std::get_if<double>(&value)) {
+			if (!std::isfinite(*n)) out += "null";
+			else if (std::trunc(*n) == *n && std::fabs(*n) < 9007199254740992.0) out += std::to_string(static_cast<int64_t>(*n));
+			else {
+				char buffer[32];
+				std::snprintf(buffer, sizeof buffer, "%.17g", *n);
+				out += buffer;
+			}
+		}
+		else if (const std::string* s = std::get_if<std::string>(&value)) writeString(out, *s);
+		else if (const Array* a = std::get_if<Array>(&value)) {
+			out += '[';
+			for (size_t i = 0; i < a->size(); ++i) {
+				if (i) out += ',';
+				(*a)[i].dump(out);
+			}
+			out += ']';
+		}
+		else {
+			const Object& o = std::get<Object>(value);
+			out += '{';
+			for (size_t i = 0; i < o.size(); ++i) {
+				if (i) out += ',';
+				writeString(out, o[i].first);
+				out += ':';
+				o[i].second.dump(out);
+			}
+			out += '}';
+		}
+	}
+
+	bool Json::asBool(const bool fallback) const {
+		const bool* b = std::get_if<bool>(&value);
+		return b ? *b : fallback;
+	}
+
+	double Json::asNumber(const double fallback) const {
+		const double* n = std::get_if<double>(&value);
+		return n ? *n : fallback;
+	}
+
+	int64_t Json::asInt(const int64_t fallback) const {
+		const double* n = std::get_if<double>(&value);
+		return n ? static_cast<int64_t>(*n) : fallback;
+	}
+
+	const std::string& Json::asString() const {
+		const std::string* s = std::get_if<std::string>(&value);
+		return s ? *s : emptyString;
+	}
+
+	const Json::Array& Json::asArray() const {
+		const Array* a = std::get_if<Array>(&value);
+		return a ? *a : emptyArray;
+	}
+
+	std::string Json::takeString() {
+		std::string* s = std::get_if<std::string>(&value);
+		return s ? std::move(*s) : std::string();
+	}
+
+	const Json& Json::operator[](const std::string_view key) const {
+		if (const Object* o = std::get_if<Object>(&value)) {
+			for (const auto& [name, member]: *o) {
+				if (name == key) return member;
+			}
+		}
+		return null;
+	}
+
+	Json* Json::find(const std::string_view key) {
+		if (Object* o = std::get_if<Object>(&value)) {
+			for (auto& [name, member]: *o) {
+				if (name == key) return &member;
+			}
+		}
+		return nullptr;
+	}
+
+	bool Json::contains(const std::string_view key) const {
+		return const_cast<Json*>(this)->find(key) != nullptr;
+	}
+
+	Json& Json::set(std::string key, Json member) {
+		if (!isObject()) value = Object();
+		if (Json* existing = find(key)) *existing = std::move(member);
+		else std::get<Object>(value).emplace_back(std::move(key), std::move(member));
+		return *this;
+	}
+
+	Json& Json::push(Json element) {
+		if (!isArray()) value = Array();
+		std::get<Array>(value).push_back(std::move(element));
+		return *this;
+	}
+}
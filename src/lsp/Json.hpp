@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace zenith {
+	// A JSON value, what the language server reads and writes
+	// Objects keep their members in insertion order; LSP messages have a handful each, so lookup is a linear scan.
+	class Json {
+	public:
+		using Array = std::vector<Json>;
+		using Object = std::vector<std::pair<std::string, Json>>;
+
+	private:
+		std::variant<std::nullptr_t, bool, double, std::string, Array, Object> value;
+
+	public:
+		Json() : value(nullptr) {}
+		Json(std::nullptr_t) : value(nullptr) {}
+		Json(const bool b) : value(b) {}
+		Json(const int n) : value(static_cast<double>(n)) {}
+		Json(const int64_t n) : value(static_cast<double>(n)) {}
+		Json(const size_t n) : value(static_cast<double>(n)) {}
+		Json(const double n) : value(n) {}
+		Json(const char* s) : value(std::string(s)) {}
+		Json(std::string s) : value(std::move(s)) {}
+		Json(std::string_view s) : value(std::string(s)) {}
+		Json(Array a) : value(std::move(a)) {}
+		Json(Object o) : value(std::move(o)) {}
+		Json(std::initializer_list<std::pair<std::string, Json>> members) : value(Object(members)) {}
+
+		// Throws std::runtime_error on malformed text
+		static Json parse(std::string_view text);
+		[[nodiscard]] std::string dump() const;
+		void dump(std::string& out) const;
+
+		[[nodiscard]] bool isNull() const { return std::holds_alternative<std::nullptr_t>(value); }
+		[[nodiscard]] bool isBool() const { return std::holds_alternative<bool>(value); }
+		[[nodiscard]] bool isNumber() const { return std::holds_alternative<double>(value); }
+		[[nodiscard]] bool isString() const { return std::holds_alternative<std::string>(value); }
+		[[nodiscard]] bool isArray() const { return std::holds_alternative<Array>(value); }
+		[[nodiscard]] bool isObject() const { return std::holds_alternative<Object>(value); }
+
+		// The value, or fallback when it has another type
+		[[nodiscard]] bool asBool(bool fallback = false) const;
+		[[nodiscard]] double asNumber(double fallback = 0) const;
+		[[nodiscard]] int64_t asInt(int64_t fallback = 0) const;
+		[[nodiscard]] const std::string& asString() const; // Empty for anything but a string
+		[[nodiscard]] const Array& asArray() const;        // Empty for anything but an array
+		[[nodiscard]] std::string takeString();             // Moves a string out, large document texts are not copied
+
+		// A member of an object, null when missing or not an object
+		[[nodiscard]] const Json& operator[](std::string_view key) const;
+		[[nodiscard]] Json* find(std::string_view key);
+		[[nodiscard]] bool contains(std::string_view key) const;
+		// Replaces the member, or adds it; this becomes an object if it was not one
+		Json& set(std::string key, Json member);
+		// Appends to an array; this becomes an array if it was not one
+		Json& push(Json element);
+
+		friend bool operator==(const Json&, const Json&) = default;
+	};
+}
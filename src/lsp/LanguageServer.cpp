@@ -0,0 +1,337 @@
+#include "LanguageServer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+namespace zenith {
+	namespace {
+		Json toJson(const Document::Position& position) {
+			return Json{{"line", position.line}, {"character", position.character}};
+		}
+
+		Json toJson(const Document::Range& range) {
+			return Json{{"start", toJson(range.start)}, {"end", toJson(range.end)}};
+		}
+
+		Json toJson(const Document::Symbol& symbol) {
+			Json children = Json::Array();
+			for (const auto& child: symbol.children) children.push(toJson(child));
+			return Json{{"name", symbol.name}, {"kind", symbol.kind}, {"range", toJson(symbol.range)},
+			            {"selectionRange", toJson(symbol.selection)}, {"children", std::move(children)}};
+		}
+
+		Document::Position positionOf(const Json& position) {
+			return {static_cast<size_t>(std::max<int64_t>(position["line"].asInt(), 0)),
+			        static_cast<size_t>(std::max<int64_t>(position["character"].asInt(), 0))};
+		}
+
+		Document::Range rangeOf(const Json& range) {
+			return {positionOf(range["start"]), positionOf(range["end"])};
+		}
+
+		bool equalsIgnoringCase(const std::string_view a, const std::string_view b) {
+			return std::ranges::equal(a, b, [](const char x, const char y) {
+				return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+			});
+		}
+	}
+
+	LanguageServer::LanguageServer(std::istream& in, std::ostream& out, const size_t jobs)
+		: in(in), out(out), pool(std::max<size_t>(jobs, 2)) {}
+
+	LanguageServer::~LanguageServer() {
+		waitIdle();
+	}
+
+	std::optional<std::string> LanguageServer::read(std::istream& in) {
+		std::optional<size_t> length;
+		std::string line;
+		bool any = false;
+		while (true) {
+			if (!std::getline(in, line)) return std::nullopt;
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.empty()) {
+				if (any) break;
+				continue;
+			}
+			any = true;
+			const size_t colon = line.find(':');
+			if (colon == std::string::npos) throw std::runtime_error("Malformed header '" + line + "'");
+			if (!equalsIgnoringCase(line.substr(0, colon), "Content-Length")) continue; // Content-Type is optional
+			size_t start = colon + 1;
+			while (start < line.size() && line[start] == ' ') ++start;
+			size_t value = 0;
+			const auto [end, error] = std::from_chars(line.data() + start, line.data() + line.size(), value);
+			if (error != std::errc() || end != line.data() + line.size()) throw std::runtime_error("Malformed header '" + line + "'");
+			length = value;
+		}
+		if (!length) throw std::runtime_error("Message without Content-Length");
+		std::string body(*length, '\0');
+		if (!in.read(body.data(), static_cast<std::streamsize>(body.size()))) return std::nullopt;
+		return body;
+	}
+
+	void LanguageServer::write(std::ostream& out, const std::string& body) {
+		out << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+		out.flush();
+	}
+
+	void LanguageServer::send(const Json& message) {
+		const std::string body = message.dump();
+		std::lock_guard lock(writeMutex);
+		write(out, body);
+	}
+
+	void LanguageServer::reply(const Json& id, Json result) {
+		send(Json{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+	}
+
+	void LanguageServer::fail(const Json& id, const int code, const std::string& message) {
+		send(Json{{"jsonrpc", "2.0"}, {"id", id}, {"error", Json{{"code", code}, {"message", message}}}});
+	}
+
+	void LanguageServer::notify(const std::string& method, Json params) {
+		send(Json{{"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}});
+	}
+
+	void LanguageServer::spawn(std::function<void()> task) {
+		{
+			std::lock_guard lock(mutex);
+			++running;
+		}
+		pool.submit([this, task = std::move(task)] {
+			try {
+				task();
+			} catch (const std::exception& e) {
+				std::cerr << "zenith-lsp: " << e.what() << std::endl;
+			}
+			std::lock_guard lock(mutex);
+			--running;
+			idle.notify_all(); // Under the lock, a waiter may destroy the server as soon as it returns
+		});
+	}
+
+	void LanguageServer::spawnRequest(const Json& id, std::function<Json(std::stop_token)> answer) {
+		const std::string key = id.dump();
+		std::stop_source stop;
+		{
+			std::lock_guard lock(mutex);
+			requests[key] = stop;
+		}
+		spawn([this, id, key, stop, answer = std::move(answer)] {
+			Json result;
+			std::string error;
+			if (!stop.stop_requested()) {
+				try {
+					result = answer(stop.get_token());
+				} catch (const std::exception& e) {
+					error = e.what();
+				}
+			}
+			{
+				std::lock_guard lock(mutex);
+				requests.erase(key);
+			}
+			if (stop.stop_requested()) fail(id, REQUEST_CANCELLED, "Request cancelled");
+			else if (!error.empty()) fail(id, INTERNAL_ERROR, error);
+			else reply(id, std::move(result));
+		});
+	}
+
+	void LanguageServer::waitIdle() {
+		std::unique_lock lock(mutex);
+		idle.wait(lock, [this] { return running == 0; });
+	}
+
+	std::shared_ptr<LanguageServer::OpenDocument> LanguageServer::find(const Json& params) {
+		std::lock_guard lock(mutex);
+		const auto it = documents.find(params["textDocument"]["uri"].asString());
+		return it == documents.end() ? nullptr : it->second;
+	}
+
+	void LanguageServer::analyze(const std::string& uri, const std::shared_ptr<OpenDocument>& open) {
+		std::stop_token stop;
+		{
+			// Diagnostics of the text before this edit are not worth finishing
+			std::lock_guard lock(mutex);
+			open->analysis.request_stop();
+			open->analysis = std::stop_source();
+			stop = open->analysis.get_token();
+		}
+		spawn([this, uri, open, stop] {
+			auto result = open->document->diagnostics(stop);
+			if (!result) return;
+			std::lock_guard lock(open->publishMutex);
+			if (stop.stop_requested() || result->first < open->published) return;
+			open->published = result->first;
+
+			Json diagnostics = Json::Array();
+			for (const auto& problem: result->second) {
+				diagnostics.push(Json{{"range", toJson(problem.range)}, {"severity", problem.severity == Severity::WARNING ? 2 : 1},
+				                      {"source", "zenith"}, {"message", problem.message}});
+			}
+			notify("textDocument/publishDiagnostics",
+			       Json{{"uri", uri}, {"version", result->first}, {"diagnostics", std::move(diagnostics)}});
+		});
+	}
+
+	void LanguageServer::initialize(const Json& id, const Json& params) {
+		if (initialized) {
+			fail(id, INVALID_REQUEST, "Already initialized");
+			return;
+		}
+		// UTF-8 when the client can do it, the positions are byte offsets then
+		for (const Json& encoding: params["capabilities"]["general"]["positionEncodings"].asArray()) {
+			if (encoding.asString() == "utf-8") utf16 = false;
+		}
+		initialized = true;
+		reply(id, Json{
+			      {"capabilities", Json{
+				       {"positionEncoding", utf16 ? "utf-16" : "utf-8"},
+				       {"textDocumentSync", Json{{"openClose", true}, {"change", 2}}}, // Incremental
+				       {"hoverProvider", true},
+				       {"definitionProvider", true},
+				       {"documentSymbolProvider", true},
+			       }},
+			      {"serverInfo", Json{{"name", "zenith-lsp"}}},
+		      });
+	}
+
+	void LanguageServer::didOpen(Json& params) {
+		Json* item = params.find("textDocument");
+		if (!item) return;
+		const std::string uri = (*item)["uri"].asString();
+		Json* text = item->find("text");
+		auto open = std::make_shared<OpenDocument>();
+		open->document = std::make_shared<Document>(text ? text->takeString() : std::string(), (*item)["version"].asInt(), utf16);
+		{
+			std::lock_guard lock(mutex);
+			documents[uri] = open;
+		}
+		analyze(uri, open);
+	}
+
+	void LanguageServer::didChange(Json& params) {
+		const auto open = find(params);
+		if (!open) return;
+		const int64_t version = params["textDocument"]["version"].asInt();
+		Json* changes = params.find("contentChanges");
+		if (!changes) return;
+		for (const Json& change: changes->asArray()) {
+			std::optional<Document::Range> range;
+			if (change.contains("range")) range = rangeOf(change["range"]);
+			open->document->change(range, change["text"].asString(), version);
+		}
+		analyze(params["textDocument"]["uri"].asString(), open);
+	}
+
+	void LanguageServer::didClose(const Json& params) {
+		const std::string& uri = params["textDocument"]["uri"].asString();
+		std::shared_ptr<OpenDocument> open;
+		{
+			std::lock_guard lock(mutex);
+			const auto it = documents.find(uri);
+			if (it == documents.end()) return;
+			open = it->second;
+			open->analysis.request_stop();
+			documents.erase(it);
+		}
+		// A closed document has no problems the client should show, and gets no more
+		std::lock_guard lock(open->publishMutex);
+		open->published = INT64_MAX;
+		notify("textDocument/publishDiagnostics", Json{{"uri", uri}, {"diagnostics", Json::Array()}});
+	}
+
+	int LanguageServer::run() {
+		while (true) {
+			std::optional<std::string> body;
+			Json message;
+			try {
+				body = read(in);
+				if (!body) break;
+				message = Json::parse(*body);
+			} catch (const std::runtime_error& e) {
+				fail(nullptr, PARSE_ERROR, e.what());
+				continue;
+			}
+
+			const std::string method = message["method"].asString();
+			const bool request = message.contains("id");
+			const Json id = message["id"];
+			if (method.empty()) continue; // A response, the server sends no requests
+			Json params;
+			if (Json* p = message.find("params")) params = std::move(*p);
+
+			if (method == "exit") {
+				waitIdle();
+				return shuttingDown ? 0 : 1;
+			}
+			if (method == "initialize") {
+				if (request) initialize(id, params);
+				continue;
+			}
+			if (!initialized || shuttingDown) {
+				if (request) fail(id, initialized ? INVALID_REQUEST : SERVER_NOT_INITIALIZED,
+				                  initialized ? "Shutting down" : "Not initialized");
+				continue;
+			}
+
+			if (method == "textDocument/didOpen") didOpen(params);
+			else if (method == "textDocument/didChange") didChange(params);
+			else if (method == "textDocument/didClose") didClose(params);
+			else if (method == "$/cancelRequest") {
+				std::lock_guard lock(mutex);
+				const auto it = requests.find(params["id"].dump());
+				if (it != requests.end()) it->second.request_stop();
+			}
+			else if (method == "shutdown") {
+				shuttingDown = true;
+				waitIdle();
+				reply(id, nullptr);
+			}
+			else if (method == "textDocument/hover" || method == "textDocument/definition" ||
+			         method == "textDocument/documentSymbol") {
+				const auto open = find(params);
+				if (!open) {
+					reply(id, nullptr);
+					continue;
+				}
+				const std::string uri = params["textDocument"]["uri"].asString();
+				const Document::Position position = positionOf(params["position"]);
+				std::shared_ptr<Document> document = open->document;
+				if (method == "textDocument/hover") {
+					spawnRequest(id, [document, position](std::stop_token) -> Json {
+						const auto hover = document->hover(position);
+						if (!hover) return nullptr;
+						return Json{{"contents", Json{{"kind", "markdown"}, {"value", hover->markdown}}},
+						            {"range", toJson(hover->range)}};
+					});
+				}
+				else if (method == "textDocument/definition") {
+					spawnRequest(id, [document, position, uri](std::stop_token) -> Json {
+						const auto range = document->definition(position);
+						if (!range) return nullptr;
+						return Json{{"uri", uri}, {"range", toJson(*range)}};
+					});
+				}
+				else {
+					spawnRequest(id, [document](const std::stop_token& stop) -> Json {
+						Json symbols = Json::Array();
+						for (const auto& symbol: document->symbols()) {
+							if (stop.stop_requested()) break;
+							symbols.push(toJson(symbol));
+						}
+						return symbols;
+					});
+				}
+			}
+			else if (request) fail(id, METHOD_NOT_FOUND, "Unknown method '" + method + "'");
+			// Other notifications, e.g. initialized, need nothing
+		}
+		waitIdle();
+		return 1;
+	}
+}
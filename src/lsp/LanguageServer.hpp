@@ -0,0 +1,92 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "Document.hpp"
+#include "Json.hpp"
+#include "../utils/ThreadPool.hpp"
+
+namespace zenith {
+	// The Language Server Protocol over a pair of streams, stdin and stdout for zenith-lsp
+	// Messages are read on the calling thread, in order, so document edits apply in the order the client sent them.
+	// Diagnostics, hover, go-to-definition and document symbols run as tasks on a thread pool. A task can be cancelled:
+	// requests by $/cancelRequest, the diagnostics of a document by its next edit.
+	class LanguageServer {
+		struct OpenDocument {
+			std::shared_ptr<Document> document;
+			std::stop_source analysis;   // Of the latest diagnostics task
+			std::mutex publishMutex;
+			int64_t published = INT64_MIN; // Version of the diagnostics the client has, older ones are not sent
+		};
+
+		std::istream& in;
+		std::ostream& out;
+		std::mutex writeMutex;
+		// Only touched by the thread reading the messages
+		bool initialized = false;
+		bool shuttingDown = false;
+		bool utf16 = true;
+
+		std::mutex mutex; // Guards what follows, and the stop sources of the documents
+		std::condition_variable idle;
+		size_t running = 0;
+		std::unordered_map<std::string, std::shared_ptr<OpenDocument>> documents; // By URI
+		std::unordered_map<std::string, std::stop_source> requests;               // Running ones, by dumped id
+
+		ThreadPool pool; // Last, so tasks are done before the members they use go away
+
+		void send(const Json& message);
+		void reply(const Json& id, Json result);
+		void fail(const Json& id, int code, const std::string& message);
+		void notify(const std::string& method, Json params);
+
+		// Runs task on the pool, counted until it finished
+		void spawn(std::function<void()> task);
+		// A request answered on the pool, with a stop token $/cancelRequest can trigger
+		void spawnRequest(const Json& id, std::function<Json(std::stop_token)> answer);
+		void waitIdle();
+
+		std::shared_ptr<OpenDocument> find(const Json& params);
+		void analyze(const std::string& uri, const std::shared_ptr<OpenDocument>& open);
+
+		void initialize(const Json& id, const Json& params);
+		void didOpen(Json& params);
+		void didChange(Json& params);
+		void didClose(const Json& params);
+
+	public:
+		// Error codes of the protocol
+		enum ErrorCode : int {
+			PARSE_ERROR = -32700,
+			INVALID_REQUEST = -32600,
+			METHOD_NOT_FOUND = -32601,
+			SERVER_NOT_INITIALIZED = -32002,
+			INTERNAL_ERROR = -32603,
+			REQUEST_CANCELLED = -32800,
+		};
+
+		LanguageServer(std::istream& in, std::ostream& out, size_t jobs = std::thread::hardware_concurrency());
+		~LanguageServer();
+
+		LanguageServer(const LanguageServer&) = delete;
+		LanguageServer& operator=(const LanguageServer&) = delete;
+
+		// Serves until exit or the end of the input; the exit code, 0 only when the client asked to shut down first
+		int run();
+
+		// One message in Content-Length framing, nothing at the end of the input
+		// Throws std::runtime_error on a malformed header.
+		static std::optional<std::string> read(std::istream& in);
+		static void write(std::ostream& out, const std::string& body);
+	};
+}
@@ -0,0 +1,27 @@
+// The Zenith language server, speaks LSP on stdin and stdout
+//
+//   zenith-lsp [--stdio] [--jobs N]
+//
+// --stdio is what editors pass, stdio is the only transport. Logs go to stderr.
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "LanguageServer.hpp"
+using namespace zenith;
+
+int main(int argc, char* argv[]) {
+	size_t jobs = std::thread::hardware_concurrency();
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--jobs" && i + 1 < argc) jobs = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg != "--stdio") {
+			std::cerr << "Usage: zenith-lsp [--stdio] [--jobs N]" << std::endl;
+			return 2;
+		}
+	}
+	// Messages are binary-safe byte counts, and the output is flushed per message
+	std::ios::sync_with_stdio(false);
+	std::cin.tie(nullptr);
+	return LanguageServer(std::cin, std::cout, jobs).run();
+}
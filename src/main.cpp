@@ -1,63 +1,76 @@
+#include <filesystem>
+#include <fstream>
 #include <iostream>
-#include "lexer/lexer.hpp"
-#include "parser/parser.hpp"
+#include "driver/CompileServer.hpp"
+#include "driver/Driver.hpp"
 #include "utils/mainargs.hpp"
-#include "utils/ReadFile.hpp"
-#include "exceptions/ParseError.hpp"
-#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+#include "utils/TimeTrace.hpp"
+#include "utils/MemoryAccounting.hpp"
+#ifdef ZENITH_SMALL_VECTOR_STATS
+#include "utils/small_vector.hpp"
+#endif
 using namespace zenith;
 
 int main(int argc, char *argv[]) {
-	auto flags = ArgumentParser::parse(argc, argv);
+	Flags flags;
+	try {
+		flags = ArgumentParser::parse(argc, argv);
+	} catch (const std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return Driver::USAGE;
+	}
 	if(flags.target != Target::native){
 		std::cerr << "Target not set to native" << std::endl << "Not implemented" << std::endl;
 		return 0;
 	}
-
-
-	std::string source = readFile(flags.inputFile);
-	std::vector<Token> tokens;
-	Lexer lexer(source, flags.inputFile);
-	std::ofstream lexerOut("lexerout.log");
-	try {
-		tokens = std::move(lexer).tokenize();
-		for (const auto &token: tokens) {
-			lexerOut << "Line " << token.loc.line
-			<< ":" << token.loc.column
-			<< " - " << Lexer::tokenToString(token.type)
-			<< " (" << token.lexeme << ")\n";
+	const std::string socket = flags.socket.empty() ? CompileServer::defaultSocket() : flags.socket;
+	if (flags.serve) {
+		try {
+			CompileServer server(socket, flags.jobs);
+			server.listen();
+			std::cerr << "Serving compiles on " << socket << std::endl;
+			server.serve();
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return Driver::FAILED;
 		}
-	} catch (const std::exception &e) {
-		std::cerr << "Lexer error: " << e.what() << std::endl;
-		return 1;
+		return Driver::SUCCESS;
 	}
-	std::cout << "Done Lexing \n";
-	lexerOut.close();
-
-
-
-	std::ofstream parserOut("parserout.log");
-	polymorphic<ProgramNode> programNode;
-	try{
-		Parser parser(tokens,flags,parserOut);
-		programNode = parser.parse();
-		parserOut << programNode->toString() << std::endl;
-	}catch (const ParseError &e) {
-		std::cout << "Parser error (ParseError): " << e.format() << std::endl;
-		return 1;
-	} catch (const std::exception &e) {
-		std::cout << "Parser error (std::exception): " << e.what() << std::endl;
-		return 1;
-	} catch (...) {
-		std::cout << "Parser error (unknown type)" << std::endl;
-		return 1;
+	if (flags.stopServer) {
+		if (CompileServer::stop(socket)) return Driver::SUCCESS;
+		std::cerr << "No compile server on " << socket << std::endl;
+		return Driver::FAILED;
 	}
-	std::cout << "Done Parsing \n";
+	// Logs, traces and memory reports are about this process, those compiles stay in it
+	if (flags.connect && CompileCache::cacheable(flags)) {
+		const auto args = ArgumentParser::expandResponseFiles(std::vector<std::string>(argv + 1, argv + argc));
+		if (auto reply = CompileServer::request(socket, std::filesystem::current_path().string(), args)) {
+			std::cout << reply->out;
+			std::cerr << reply->err;
+			return reply->status;
+		}
+		std::cerr << "No compile server on " << socket << ", compiling in this process" << std::endl;
+	}
+	// Written on every way out of main, a compile that failed is worth a trace too
+	struct TraceWriter {
+		const std::string& file;
+		~TraceWriter() {
+			if (file.empty()) return;
+			std::ofstream out(file);
+			TimeTrace::write(out);
+			if (!out) std::cerr << "Failed to write the time trace to " << file << std::endl;
+		}
+	} traceWriter{flags.timeTrace};
+	if (!flags.timeTrace.empty()) TimeTrace::start();
+	if (flags.memReport) MemoryAccounting::start();
 
-	ErrorReporter reporter(std::cout);
-	SemanticAnalyzer semanticAnalyzer(reporter);
-	std::cout << semanticAnalyzer.analyze(programNode).toString();
-	std::cin.get();
+	const Driver::Status status = Driver(flags).run(std::cout, std::cerr);
+	if (flags.memReport) MemoryAccounting::report(std::cout);
+#ifdef ZENITH_SMALL_VECTOR_STATS
+	// Vectors are recorded as they are destroyed, every tree is gone by now
+	small_vector_stats::report(std::cerr);
+#endif
+	return status;
 }
 //	std::string source = R"(
 //		class Example {
@@ -0,0 +1,142 @@
+#include "parser.hpp"
+#include <utility>
+#include "../visitor/ASTWalker.hpp"
+
+namespace zenith {
+	namespace {
+		// Moves every location in a subtree by the same number of lines and bytes
+		class LocationShift : public ASTWalker {
+			ptrdiff_t lines, bytes;
+
+		protected:
+			void enter(ASTNode& node) override {
+				node.loc.line += lines;
+				node.loc.fileOffset += bytes;
+			}
+
+		public:
+			LocationShift(const ptrdiff_t lines, const ptrdiff_t bytes) : lines(lines), bytes(bytes) {}
+			void shift(polymorphic<ASTNode>& node) { walk(node); }
+		};
+
+		bool sameToken(const Token& old, const Token& now, const ptrdiff_t lines, const ptrdiff_t bytes) {
+			return old.type == now.type && old.loc.column == now.loc.column &&
+			       old.loc.line + lines == now.loc.line && old.loc.fileOffset + bytes == now.loc.fileOffset &&
+			       old.lexeme == now.lexeme;
+		}
+
+		// Which tokens an edit changed, from the tokens before and after it: the ones both start and end with stay
+		TokenEdit difference(const std::vector<Token>& old, const std::vector<Token>& now, const TextEdit& edit) {
+			size_t begin = 0;
+			while (begin < old.size() && begin < now.size() && sameToken(old[begin], now[begin], 0, 0)) ++begin;
+			const ptrdiff_t lines = static_cast<ptrdiff_t>(now.back().loc.line) - static_cast<ptrdiff_t>(old.back().loc.line);
+			const ptrdiff_t bytes = static_cast<ptrdiff_t>(edit.inserted) - static_cast<ptrdiff_t>(edit.removed);
+			size_t same = 0;
+			while (same < old.size() - begin && same < now.size() - begin &&
+			       sameToken(old[old.size() - 1 - same], now[now.size() - 1 - same], lines, bytes)) ++same;
+			return {begin, old.size() - begin - same, now.size() - begin - same, lines, bytes};
+		}
+	}
+
+	Parser::Inspected Parser::startSpan() {
+		return std::exchange(inspected, Inspected{current, current});
+	}
+
+	void Parser::finishSpan(std::vector<ParseSpan>* spans, const size_t begin, const Inspected outer,
+	                        polymorphic<ASTNode> node) {
+		if (spans) spans->push_back({begin, current, inspected.first, inspected.last, std::move(node)});
+		look(outer.first);
+		look(outer.last);
+	}
+
+	ParseSpan* Parser::findReusable(std::vector<ParseSpan>& spans) const {
+		if (tokens[current].type == TokenType::EOF_TOKEN) return nullptr;
+
+		// Where the token at current was before the edit, nothing was there if the edit made it
+		size_t oldIndex;
+		if (current < edit.begin) oldIndex = current;
+		else if (current >= edit.begin + edit.inserted) oldIndex = current - edit.inserted + edit.removed;
+		else return nullptr;
+		const auto it = std::ranges::lower_bound(spans, oldIndex, {}, &ParseSpan::begin);
+		if (it == spans.end() || it->begin != oldIndex || !it->node) return nullptr;
+
+		// It parses the same if every token it read is still there, all before the edit or all after it. The first
+		// token of the input is special, there is nothing before it to look back at.
+		ParseSpan& span = *it;
+		if (span.last >= edit.begin && span.first < edit.begin + edit.removed) return nullptr;
+		const size_t oldCount = tokens.size() - edit.inserted + edit.removed;
+		if ((span.begin == 0) != (current == 0) || span.last + 1 >= oldCount) return nullptr;
+		const ptrdiff_t shift = static_cast<ptrdiff_t>(current) - static_cast<ptrdiff_t>(span.begin);
+		if (span.last + shift >= tokenEnd) return nullptr;
+		return &span;
+	}
+
+	polymorphic<ASTNode> Parser::reuseSpan(ParseSpan& span, const bool declaration) {
+		const ptrdiff_t shift = static_cast<ptrdiff_t>(current) - static_cast<ptrdiff_t>(span.begin);
+		const bool moved = span.begin >= edit.begin + edit.removed;
+		polymorphic<ASTNode> node = std::move(span.node);
+		if (moved && (edit.lines || edit.bytes)) LocationShift(edit.lines, edit.bytes).shift(node);
+
+		auto movedSpan = [shift](const ParseSpan& old, polymorphic<ASTNode> node) {
+			return ParseSpan{old.begin + shift, old.end + shift, old.first + shift, old.last + shift, std::move(node)};
+		};
+		if (declaration) {
+			// The statements inside come along, already shifted with the declaration
+			auto& statements = previousParse->statements;
+			auto inside = std::ranges::lower_bound(statements, span.begin, {}, &ParseSpan::begin);
+			for (; inside != statements.end() && inside->end <= span.end; ++inside) {
+				if (inside->node) recording->statements.push_back(movedSpan(*inside, inside->node.share()));
+			}
+			recording->declarations.push_back(movedSpan(span, node.share()));
+			++recording->reusedDeclarations;
+		}
+		else {
+			recording->statements.push_back(movedSpan(span, node.share()));
+			++recording->reusedStatements;
+		}
+
+		// The enclosing span depends on everything this one read
+		look(span.first + shift);
+		look(span.last + shift);
+		current = span.end + shift;
+		previous = current - 1;
+		currentToken = tokens[current];
+		return node;
+	}
+
+	IncrementalParse Parser::parseRecorded(IncrementalParse* old, const TokenEdit& edit) {
+		IncrementalParse result;
+		recording = &result;
+		previousParse = old;
+		this->edit = edit;
+		result.program = parse();
+		recording = nullptr;
+		previousParse = nullptr;
+		result.tokens = std::move(tokens);
+		return result;
+	}
+
+	IncrementalParse Parser::parseForEditing(std::vector<Token> tokens, const Flags& flags, ErrorReporter& errorReporter,
+	                                         std::ostream& errStream) {
+		Flags eager = flags;
+		eager.lazyParsing = false;
+		Parser parser(std::move(tokens), eager, errorReporter, errStream);
+		return parser.parseRecorded(nullptr, {});
+	}
+
+	IncrementalParse Parser::reparse(IncrementalParse&& previous, const TextEdit& edit, std::vector<Token> tokens,
+	                                 const Flags& flags, ErrorReporter& errorReporter, std::ostream& errStream) {
+		const TokenEdit changed = difference(previous.tokens, tokens, edit);
+		previous.tokens = std::move(tokens);
+		return reparse(std::move(previous), changed, flags, errorReporter, errStream);
+	}
+
+	IncrementalParse Parser::reparse(IncrementalParse&& previous, const TokenEdit& edit, const Flags& flags,
+	                                 ErrorReporter& errorReporter, std::ostream& errStream) {
+		Flags eager = flags;
+		eager.lazyParsing = false;
+		IncrementalParse old = std::move(previous);
+		Parser parser(std::move(old.tokens), eager, errorReporter, errStream);
+		return parser.parseRecorded(&old, edit);
+	}
+}
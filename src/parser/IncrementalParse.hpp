@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "../lexer/lexer.hpp"
+#include "../ast/AST.hpp"
+
+namespace zenith {
+	// A run of tokens the parser turned into one node, with everything it looked at to decide how
+	struct ParseSpan {
+		size_t begin, end;         // Consumed tokens [begin, end)
+		size_t first, last;        // Tokens read, lookahead and lookbehind included
+		polymorphic<ASTNode> node; // Shared with the tree, null when the tokens were skipped
+	};
+
+	// A parse that can be updated after an edit, see Parser::parseForEditing and Parser::reparse
+	// Only spans without syntax errors or diagnostics are recorded, they are the ones that may be reused.
+	struct IncrementalParse {
+		std::vector<Token> tokens;
+		polymorphic<ProgramNode> program;
+		std::vector<ParseSpan> declarations; // One per iteration of the top-level loop, in source order
+		std::vector<ParseSpan> statements;   // Statements of outermost blocks (function and method bodies)
+		size_t reusedDeclarations = 0;       // How much of the previous parse the last update kept
+		size_t reusedStatements = 0;
+	};
+}
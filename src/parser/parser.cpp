@@ -3,8 +3,13 @@
 #include "parser.hpp"
 #include <iostream>
 #include <algorithm>
+#include <iterator>
+#include <optional>
+#include <sstream>
 #include <unordered_set>
+#include <utility>
 #include "../exceptions/ParseError.hpp"
+#include "../utils/TimeTrace.hpp"
 #include <SemanticAnalysis/SemanticAnalyzer.hpp>
 
 
@@ -18,7 +23,10 @@ namespace zenith {
 	// Fixed parseVarDecl to return the node
 	polymorphic<VarDeclNode> Parser::parseVarDecl() {
 		SourceLocation loc = currentToken.loc;
+		auto syntaxScope = syntaxNode(SyntaxKind::VAR_DECL);
 		bool isHoisted = match(TokenType::HOIST);
+		bool isConst = match(TokenType::CONST);
+		if (isConst) advance();
 		VarDeclNode::Kind kind = VarDeclNode::DYNAMIC; // Default to dynamic
 		polymorphic<TypeNode> typeNode;
 
@@ -43,7 +51,7 @@ namespace zenith {
 			auto sizeExpr = parseExpression();
 
 			// Create a new ArrayTypeNode with the size expression
-			auto arrayType = make_polymorphic<ArrayTypeNode>(
+			auto arrayType = make_node<ArrayTypeNode>(
 				loc,
 				std::move(typeNode),
 				std::move(sizeExpr)
@@ -63,6 +71,7 @@ namespace zenith {
 		if (match(TokenType::EQUAL)) {
 			consume(TokenType::EQUAL);
 			initializer = parseExpression();
+			if (failed()) return nullptr;
 
 			// Special case: Class initialization (SomeClassName a = new SomeClassName())
 			if (kind == VarDeclNode::STATIC && initializer->isConstructorCall()) {
@@ -70,10 +79,10 @@ namespace zenith {
 			}
 		}
 
-		return make_polymorphic<VarDeclNode>(
+		return make_node<VarDeclNode>(
 			loc, kind, std::move(name),
 			std::move(typeNode), std::move(initializer),
-			isHoisted
+			isHoisted, isConst
 		);
 	}
 
@@ -91,7 +100,23 @@ namespace zenith {
 		if (match(type)) {
 			return advance();
 		}
-		throw ParseError(currentToken.loc, errorMessage);
+		fail(currentToken.loc, errorMessage);
+		return currentToken;
+	}
+
+	std::nullptr_t Parser::fail(SourceLocation loc, std::string message) {
+		if (failed()) return nullptr; // Only the first error counts, like the throw it replaces
+		error.emplace(std::move(loc), message);
+		errorToken = std::exchange(currentToken, Token{TokenType::EOF_TOKEN, "", currentToken.loc});
+		return nullptr;
+	}
+
+	ParseError Parser::recover() {
+		++problems;
+		ParseError result = std::move(*error);
+		error.reset();
+		currentToken = std::move(errorToken);
+		return result;
 	}
 
 	Token Parser::consume(TokenType type) {
@@ -99,10 +124,12 @@ namespace zenith {
 	}
 
 	polymorphic<ExprNode> Parser::parseExpression(int precedence) {
+		const auto start = syntaxCheckpoint();
 		if (match({TokenType::PLUS_PLUS, TokenType::MINUS_MINUS})) {
+			auto syntaxScope = syntaxNode(SyntaxKind::UNARY);
 			Token op = advance();
 			auto right = parseExpression(getPrecedence(op.type));
-			return make_polymorphic<UnaryOpNode>(
+			return make_node<UnaryOpNode>(
 				op.loc,
 				op.type,
 				std::move(right),
@@ -114,8 +141,9 @@ namespace zenith {
 
 		while (true) {
 			if (match({TokenType::PLUS_PLUS, TokenType::MINUS_MINUS})) {
+				auto syntaxScope = syntaxNodeAt(start, SyntaxKind::UNARY);
 				Token op = advance();
-				return make_polymorphic<UnaryOpNode>(
+				return make_node<UnaryOpNode>(
 					op.loc,
 					op.type,
 					std::move(expr),
@@ -128,9 +156,10 @@ namespace zenith {
 
 			if (opPrecedence <= precedence) break;
 
+			auto syntaxScope = syntaxNodeAt(start, SyntaxKind::BINARY);
 			advance();
 			auto right = parseExpression(opPrecedence);
-			expr = make_polymorphic<BinaryOpNode>(
+			expr = make_node<BinaryOpNode>(
 				op.loc, // Pass operator location
 				op.type,
 				std::move(expr),
@@ -143,72 +172,85 @@ namespace zenith {
 
 	polymorphic<ExprNode> Parser::parsePrimary() {
 		SourceLocation startLoc = currentToken.loc;
+		const auto start = syntaxCheckpoint();
 
 		if (match(TokenType::NEW)) {
 			return parseNewExpression();
 		}
 		if (match({TokenType::NUMBER, TokenType::INTEGER_LIT, TokenType::FLOAT_LIT})) {
+			auto syntaxScope = syntaxNode(SyntaxKind::LITERAL);
 			Token numToken = advance();
-			return make_polymorphic<LiteralNode>(startLoc, LiteralNode::NUMBER, numToken.lexeme);
+			return make_node<LiteralNode>(startLoc, LiteralNode::NUMBER, numToken.lexeme);
 		}
 		if (match(TokenType::STRING_LIT)) {
+			auto syntaxScope = syntaxNode(SyntaxKind::LITERAL);
 			Token strToken = advance();
-			return make_polymorphic<LiteralNode>(startLoc, LiteralNode::STRING, strToken.lexeme);
+			return make_node<LiteralNode>(startLoc, LiteralNode::STRING, strToken.lexeme);
 		}
 		if (match(TokenType::TRUE) || match(TokenType::FALSE)) {
+			auto syntaxScope = syntaxNode(SyntaxKind::LITERAL);
 			Token boolToken = advance();
-			return make_polymorphic<LiteralNode>(startLoc, LiteralNode::BOOL, boolToken.lexeme);
+			return make_node<LiteralNode>(startLoc, LiteralNode::BOOL, boolToken.lexeme);
 		}
 		if (match(TokenType::NULL_LIT)) {
+			auto syntaxScope = syntaxNode(SyntaxKind::LITERAL);
 			advance();
-			return make_polymorphic<LiteralNode>(startLoc, LiteralNode::NIL, "nil");
+			return make_node<LiteralNode>(startLoc, LiteralNode::NIL, "nil");
 		}
 		if (match(TokenType::LBRACE)) {
 			if (isInStructInitializerContext()) {
 				return parseStructInitializer();
 			}
+			auto syntaxScope = syntaxNode(SyntaxKind::FREE_OBJECT);
 			return parseFreeObject();
 		}
 		if (match(TokenType::FREEOBJ)) {
+			auto syntaxScope = syntaxNode(SyntaxKind::FREE_OBJECT);
 			advance();
 			if (match(TokenType::LBRACE)) {
 				return parseFreeObject();
 			}
-			throw ParseError(startLoc, "Expected '{' after free obj, Achievement unlocked: How did we get here?");
+			return fail(startLoc, "Expected '{' after free obj, Achievement unlocked: How did we get here?");
 		}
 		if (match(TokenType::LPAREN)) {
 			if (isArrowFunctionStart()) {
+				auto syntaxScope = syntaxNode(SyntaxKind::LAMBDA);
 				auto params = parseArrowFunctionParams();
 				if (match(TokenType::LAMBARROW)) {
 					return parseArrowFunction(std::move(params));
 				}
 			}
+			auto syntaxScope = syntaxNode(SyntaxKind::PAREN);
 			advance();
 			auto expr = parseExpression();
 			consume(TokenType::RPAREN, "Expected a ')'");
 			return expr;
 		}
 		else if (match({TokenType::IDENTIFIER, TokenType::THIS})) {
-			Token identToken = advance();
+			Token identToken = currentToken;
+			{
+				auto syntaxScope = syntaxNode(SyntaxKind::NAME);
+				advance();
+			}
 			polymorphic<ExprNode> expr;
 
 			if (identToken.type == TokenType::THIS) {
-				expr = make_polymorphic<ThisNode>(startLoc);
+				expr = make_node<ThisNode>(startLoc);
 			}
 			else {
-				expr = make_polymorphic<VarNode>(startLoc, identToken.lexeme);
+				expr = make_node<VarNode>(startLoc, identToken.lexeme);
 			}
 
 			// Handle chained operations
 			while (true) {
 				if (match(TokenType::LPAREN)) {
-					expr = parseFunctionCall(std::move(expr));
+					expr = parseFunctionCall(std::move(expr), start);
 				}
 				else if (match(TokenType::DOT)) {
-					expr = parseMemberAccess(std::move(expr));
+					expr = parseMemberAccess(std::move(expr), start);
 				}
 				else if (match(TokenType::LBRACKET)) {
-					expr = parseArrayAccess(std::move(expr));
+					expr = parseArrayAccess(std::move(expr), start);
 				}
 				else {
 					break;
@@ -218,48 +260,76 @@ namespace zenith {
 			return expr;
 		}
 
-		throw ParseError(currentToken.loc,
-		                 "Expected primary expression, got " +
-		                 Lexer::tokenToString(currentToken.type));
+		return fail(currentToken.loc,
+		            "Expected primary expression, got " +
+		            Lexer::tokenToString(currentToken.type));
 	}
 
 	Token Parser::advance() {
 		if (isAtEnd()) {
+			if (tokenEnd) look(tokenEnd - 1);
 			return Token{
 				TokenType::EOF_TOKEN, "",
-				tokens.empty() ? SourceLocation{1, 1, 0, 0} : tokens.back().loc
+				tokenEnd == 0 ? SourceLocation{1, 1, 0, 0, ""} : tokens[tokenEnd - 1].loc
 			};
 		}
 
 		Token result = tokens[current]; // 1. Get current token first
 		previous = current;
+		if (syntax) syntax->token(result);
 
 		// 2. Only advance if not already at end
-		if (current + 1 < tokens.size()) {
+		if (current + 1 < tokenEnd) {
 			current++;
+			look(current);
 			currentToken = tokens[current];
 		}
 		else {
-			current = tokens.size(); // Mark as ended
+			current = tokenEnd; // Mark as ended
 			currentToken = Token{TokenType::EOF_TOKEN, "", result.loc};
 		}
 
 		return result; // Return what was current when we entered
 	}
 
-	Parser::Parser(std::vector<Token> tokens, const Flags &flags, std::ostream &errStream)
-		: tokens(std::move(tokens)),
+	Parser::Parser(std::vector<Token> tokens, const Flags &flags, ErrorReporter &errorReporter, std::ostream &errStream,
+	               ThreadPool *pool)
+		: tokenStore(std::make_shared<std::vector<Token>>(std::move(tokens))), tokens(*tokenStore),
+		  tokenEnd(this->tokens.size()),
 		  currentToken(this->tokens.empty() ? Token{TokenType::EOF_TOKEN, "", {1, 1, 0}} : this->tokens[0]),
-		  flags(flags), errStream(errStream), errorReporter(std::cout) {
+		  flags(flags), errStream(errStream), errorReporter(errorReporter), pool(pool) {
 		current = 0;
 	}
 
+	Parser::Parser(std::shared_ptr<std::vector<Token>> tokens, const size_t start, const size_t end, const Flags &flags,
+	               ErrorReporter &errorReporter, std::ostream &errStream)
+		: tokenStore(std::move(tokens)), tokens(*tokenStore), tokenEnd(end), current(start),
+		  previous(start ? start - 1 : 0), currentToken((*tokenStore)[start]), flags(flags), errStream(errStream),
+		  errorReporter(errorReporter) {}
+
 	bool Parser::isAtEnd() const {
-		return current >= tokens.size();
+		return current >= tokenEnd || failed();
+	}
+
+	Parser::SyntaxScope Parser::syntaxNode(const SyntaxKind kind) {
+		if (!syntax) return SyntaxScope(nullptr);
+		syntax->startNode(kind, currentToken.loc.fileOffset);
+		return SyntaxScope(syntax);
+	}
+
+	Parser::SyntaxScope Parser::syntaxNodeAt(const SyntaxBuilder::Checkpoint at, const SyntaxKind kind) {
+		if (!syntax) return SyntaxScope(nullptr);
+		syntax->startNodeAt(at, kind);
+		return SyntaxScope(syntax);
+	}
+
+	SyntaxBuilder::Checkpoint Parser::syntaxCheckpoint() {
+		return syntax ? syntax->checkpoint(currentToken.loc.fileOffset) : 0;
 	}
 
 	polymorphic<TypeNode> Parser::parseType() {
 		SourceLocation startLoc = currentToken.loc;
+		auto syntaxScope = syntaxNode(SyntaxKind::TYPE);
 
 		// Handle built-in types (from TokenType)
 		if (match({
@@ -284,18 +354,18 @@ namespace zenith {
 			else if (typeToken.type == TokenType::VOID) kind = PrimitiveTypeNode::Type::VOID;
 			else if (typeToken.type == TokenType::FREEOBJ) {
 				// For freeobj, we'll return a TypeNode with DYNAMIC kind since it's a special case
-				return make_polymorphic<TypeNode>(startLoc, TypeNode::Kind::DYNAMIC);
+				return make_node<TypeNode>(startLoc, TypeNode::Kind::DYNAMIC);
 			}
 			else kind = PrimitiveTypeNode::Type::BIGNUMBER;
 
-			return make_polymorphic<PrimitiveTypeNode>(startLoc, kind);
+			return make_node<PrimitiveTypeNode>(startLoc, kind);
 		}
 		else if (match(TokenType::LBRACKET)) {
 			// Array type (e.g., [int] or [MyClass])
 			advance(); // Consume '['
 			auto elementType = parseType();
 			consume(TokenType::RBRACKET, "Expected ']' after array type");
-			return make_polymorphic<ArrayTypeNode>(startLoc, std::move(elementType));
+			return make_node<ArrayTypeNode>(startLoc, std::move(elementType));
 		}
 		else if (match(TokenType::IDENTIFIER)) {
 			// User-defined type (class/struct/type alias) - now with template support
@@ -304,7 +374,7 @@ namespace zenith {
 
 			//Todo change this
 			if (baseName == "Function")
-				return make_polymorphic<TypeNode>(
+				return make_node<TypeNode>(
 					startLoc,
 					TypeNode::Kind::FUNCTION
 				);
@@ -323,7 +393,7 @@ namespace zenith {
 
 				consume(TokenType::GREATER, "Expected '>' to close template arguments");
 
-				return make_polymorphic<TemplateTypeNode>(
+				return make_node<TemplateTypeNode>(
 					startLoc,
 					baseName,
 					std::move(templateArgs)
@@ -331,16 +401,17 @@ namespace zenith {
 			}
 
 			// Non-templated case
-			return make_polymorphic<NamedTypeNode>(startLoc, baseName);
+			return make_node<NamedTypeNode>(startLoc, baseName);
 		}
 
-		throw ParseError(
+		return fail(
 			currentToken.loc,
 			"Expected type name, got " + Lexer::tokenToString(currentToken.type)
 		);
 	}
 
 	void Parser::synchronize() {
+		auto syntaxScope = syntaxNode(SyntaxKind::ERROR);
 		// 1. Always consume the current problematic token first
 		advance();
 
@@ -422,6 +493,7 @@ namespace zenith {
 			static Token eof{TokenType::EOF_TOKEN, "", {0, 0, 0}};
 			return eof;
 		}
+		look(previous);
 		return tokens[previous];
 	}
 
@@ -466,71 +538,297 @@ namespace zenith {
 		return it != precedences.end() ? it->second : 0;
 	}
 
+	polymorphic<ExprNode> Parser::parseExpressionOnly() {
+		auto expression = parseExpression();
+		consume(TokenType::EOF_TOKEN, "Expected end of input after expression");
+		if (error) throw *error;
+		return expression;
+	}
+
 	polymorphic<ProgramNode> Parser::parse() {
 		SourceLocation startLoc = currentToken.loc;
 		std::vector<polymorphic<ASTNode> > declarations;
-		while (!isAtEnd()) {
-			pendingAnnotations.clear();
-			pendingAnnotations = parseAnnotations();
-			try {
-				auto annotations = parseAnnotations();
-				if (match(TokenType::IMPORT)) {
-					declarations.emplace_back(parseImport());
-				}
-				if (match(TokenType::TEMPLATE)) {
-					declarations.emplace_back(parseTemplate());
-				}
-				else if (match({TokenType::CLASS, TokenType::STRUCT})) {
-					declarations.emplace_back(parseObject());
-				}
-				else if (match(TokenType::UNION)) {
-					declarations.emplace_back(parseUnion());
-				}
-				else if (match(TokenType::FUN)) {
-					declarations.emplace_back(parseFunction());
-				}
-				else if (isBuiltInType(currentToken.type) || currentToken.type == TokenType::IDENTIFIER) {
-					// Handle both built-in types and user-defined types
-					if (isPotentialMethod()) {
-						declarations.emplace_back(parseFunction());
-					}
-					else {
-						// It's a variable declaration
-						declarations.emplace_back(parseVarDecl());
-					}
-				}
-				else if (match({TokenType::LET, TokenType::VAR, TokenType::DYNAMIC})) {
-					declarations.emplace_back(parseVarDecl());
-				}
-				else if (match(TokenType::ACTOR)) {
-					declarations.emplace_back(parseActorDecl());
-				}
-				else if (!annotations.empty()) {
-					throw ParseError(currentToken.loc,
-					                 "Annotations must precede a declaration");
+
+		// Group neighbouring declarations so each task has enough work to pay for itself
+		const auto slices = pool && pool->size() > 1
+			                    ? splitDeclarations(std::max<size_t>(512, (tokenEnd - current) / (pool->size() * 4)))
+			                    : std::vector<std::pair<size_t, size_t> >{};
+		if (slices.size() < 2) {
+			parseDeclarations(declarations);
+			if (error) throw *error; // Outside every recovery point, fatal for the caller
+		}
+		else {
+			// Every slice gets its own parser, results, diagnostics and log output are stitched back together in source
+			// order. A slice's last declaration may run on into the next slice, as it would in a sequential parse; then
+			// the next one does not start where that parse would, and everything is parsed again in one go.
+			const size_t count = slices.size();
+			std::vector<std::vector<polymorphic<ASTNode> > > parts(count);
+			std::vector<std::ostringstream> logs(count);
+			std::vector<std::optional<ParseError> > errors(count);
+			std::vector<DiagnosticsEngine> reported(count);
+			std::vector<size_t> ends(count);
+			pool->parallelFor(count, [&](const size_t i) {
+				ErrorReporter reporter(reported[i]);
+				Parser parser(tokenStore, slices[i].first, tokenEnd, flags, reporter, logs[i]);
+				parser.declarationsEnd = slices[i].second;
+				parser.parseDeclarations(parts[i]);
+				errors[i] = std::move(parser.error);
+				ends[i] = parser.current;
+			});
+			size_t agreed = 0; // Slices that stopped right where the next one starts
+			while (agreed < count && !errors[agreed] && ends[agreed] == slices[agreed].second) ++agreed;
+			if (agreed < count && !errors[agreed]) {
+				parseDeclarations(declarations);
+				if (error) throw *error;
+			}
+			else {
+				for (size_t i = 0; i < std::min(agreed + 1, count); ++i) {
+					for (const auto &d: reported[i].collect()) errorReporter.report(d.loc, d.message, d.severity);
 				}
-				else {
-					// Handle other top-level constructs
-					advance();
+				if (agreed < count) throw *errors[agreed]; // The earliest one in source order, as a sequential parse would
+				for (size_t i = 0; i < count; ++i) {
+					std::ranges::move(parts[i], std::back_inserter(declarations));
+					errStream << logs[i].str();
 				}
-				if (!declarations.empty()) {
-					if (auto annotatable_opt = declarations.back().cast().non_throwing().to<IAnnotatable>()) {
-						annotatable_opt->setAnnotations(std::move(pendingAnnotations));
-					}
-					else if (!pendingAnnotations.empty()) {
-						throw ParseError(currentToken.loc,
-						                 "Annotations cannot be applied to this declaration type");
+				current = tokenEnd;
+			}
+		}
+
+		return make_node<ProgramNode>(startLoc, std::move(declarations));
+	}
+
+	void Parser::parseDeclarations(std::vector<polymorphic<ASTNode> >& declarations) {
+		while (!isAtEnd() && current < declarationsEnd) {
+			if (!recording) {
+				if (!parseDeclaration(declarations)) return;
+				continue;
+			}
+			if (ParseSpan* reusable = previousParse ? findReusable(previousParse->declarations) : nullptr) {
+				declarations.push_back(reuseSpan(*reusable, true));
+				continue;
+			}
+
+			auto lastAnnotations = [&] {
+				if (declarations.empty()) return size_t{0};
+				const auto annotatable = declarations.back().cast().non_throwing().to<DeclNode>();
+				return annotatable ? annotatable->annotations.size() : 0;
+			};
+			const size_t begin = current, added = declarations.size(), problemsBefore = problems;
+			const size_t annotationsBefore = lastAnnotations();
+			const Inspected outer = startSpan();
+			if (!parseDeclaration(declarations)) return;
+			// Skipped tokens still hand their annotations to the declaration before them, which is then not reusable
+			if (declarations.size() == added && (annotationsBefore || lastAnnotations()) &&
+			    !recording->declarations.empty() && recording->declarations.back().node.get() == declarations.back().get()) {
+				recording->declarations.pop_back();
+			}
+			const bool clean = problems == problemsBefore && declarations.size() == added + 1;
+			finishSpan(clean ? &recording->declarations : nullptr, begin, outer,
+			           clean ? declarations.back().share() : nullptr);
+		}
+	}
+
+	bool Parser::parseDeclaration(std::vector<polymorphic<ASTNode> >& declarations) {
+		TimeTrace::Scope trace("Parse declaration", "parse");
+		const size_t firstToken = current, added = declarations.size();
+		// A declaration that failed half way is dropped, the ones before it stay
+		auto add = [&](auto declaration) {
+			if (!failed()) declarations.emplace_back(std::move(declaration));
+		};
+		pendingAnnotations.clear();
+		pendingAnnotations = parseAnnotations();
+		if (failed()) return false;
+
+		auto annotations = parseAnnotations();
+		if (match(TokenType::IMPORT)) {
+			add(parseImport());
+		}
+		if (match(TokenType::TEMPLATE)) {
+			add(parseTemplate());
+		}
+		else if (match({TokenType::CLASS, TokenType::STRUCT})) {
+			add(parseObject());
+		}
+		else if (match(TokenType::UNION)) {
+			add(parseUnion());
+		}
+		else if (match(TokenType::FUN)) {
+			add(parseFunction());
+		}
+		else if (isBuiltInType(currentToken.type) || currentToken.type == TokenType::IDENTIFIER) {
+			// Handle both built-in types and user-defined types
+			if (isPotentialMethod()) {
+				add(parseFunction());
+			}
+			else {
+				// It's a variable declaration
+				add(parseVarDecl());
+			}
+		}
+		else if (match({TokenType::LET, TokenType::VAR, TokenType::DYNAMIC, TokenType::CONST})) {
+			add(parseVarDecl());
+		}
+		else if (match(TokenType::ACTOR)) {
+			add(parseActorDecl());
+		}
+		else if (!annotations.empty()) {
+			fail(currentToken.loc, "Annotations must precede a declaration");
+		}
+		else {
+			// Handle other top-level constructs
+			auto syntaxScope = syntaxNode(SyntaxKind::ERROR);
+			advance();
+		}
+		if (!failed() && !declarations.empty()) {
+			if (auto annotatable_opt = declarations.back().cast().non_throwing().to<DeclNode>()) {
+				annotatable_opt->setAnnotations(std::move(pendingAnnotations));
+			}
+			else if (!pendingAnnotations.empty()) {
+				fail(currentToken.loc, "Annotations cannot be applied to this declaration type");
+			}
+		}
+		if (failed()) {
+			const ParseError e = recover();
+			errorReporter.report(e.location, e.format());
+			errStream << e.what() << std::endl;
+			synchronize();
+		}
+		if (trace) {
+			trace.counter("tokens", static_cast<int64_t>(current - firstToken));
+			if (declarations.size() > added) {
+				if (const auto decl = declarations.back().cast().non_throwing().to<DeclNode>()) trace.detail(decl->name);
+				else if (const auto var = declarations.back().cast().non_throwing().to<VarDeclNode>()) trace.detail(var->name);
+			}
+		}
+		return true;
+	}
+
+	namespace {
+		// Declaration keywords outside every bracket start a new top-level declaration, annotations stay with theirs
+		// Fed one token at a time, so a token stream can be split as it arrives. Once a bracket is closed by another
+		// kind or was never opened, nothing says where the parser will be, and no declaration starts after it.
+		class DeclarationSplitter {
+			size_t index;
+			std::vector<TokenType> closers; // Of the brackets open, innermost last
+			bool mismatched = false;
+			size_t annotationStart = SIZE_MAX;
+			bool templateHeader = false; // The declaration after 'template<...>' belongs to the template
+
+		public:
+			explicit DeclarationSplitter(const size_t first) : index(first) {}
+
+			// Every bracket so far closed by its own kind, and none left open
+			[[nodiscard]] bool balanced() const { return !mismatched && closers.empty(); }
+
+			// Where the declaration starting at this token begins, its annotations included, SIZE_MAX if none does
+			size_t next(const TokenType type) {
+				const size_t i = index++;
+				if (mismatched) return SIZE_MAX;
+				switch (type) {
+					case TokenType::LBRACE:
+					case TokenType::DOLLAR_LBRACE:
+						closers.push_back(TokenType::RBRACE);
+						break;
+					case TokenType::LPAREN:
+						closers.push_back(TokenType::RPAREN);
+						break;
+					case TokenType::LBRACKET:
+						closers.push_back(TokenType::RBRACKET);
+						break;
+					case TokenType::RBRACE:
+					case TokenType::RPAREN:
+					case TokenType::RBRACKET:
+						if (closers.empty() || closers.back() != type) mismatched = true;
+						else closers.pop_back();
+						break;
+					case TokenType::AT:
+						if (closers.empty() && annotationStart == SIZE_MAX) annotationStart = i;
+						break;
+					case TokenType::CLASS:
+					case TokenType::STRUCT:
+					case TokenType::UNION:
+					case TokenType::FUN:
+					case TokenType::ACTOR:
+					case TokenType::TEMPLATE:
+					case TokenType::IMPORT: {
+						if (!closers.empty()) break;
+						const size_t start = annotationStart == SIZE_MAX ? i : annotationStart;
+						annotationStart = SIZE_MAX;
+						if (templateHeader) {
+							templateHeader = false;
+							break;
+						}
+						templateHeader = type == TokenType::TEMPLATE;
+						return start;
 					}
+					default:
+						break;
 				}
-			} catch (const ParseError &e) {
-				errorReporter.report(e.location, e.format());
-				errStream << e.what() << std::endl;
-				synchronize();
+				return SIZE_MAX;
+			}
+		};
+	}
+
+	std::vector<std::pair<size_t, size_t> > Parser::splitDeclarations(const size_t target) const {
+		std::vector<size_t> starts{current};
+		DeclarationSplitter splitter(current);
+		for (size_t i = current; i < tokenEnd; ++i) {
+			const size_t start = splitter.next(tokens[i].type);
+			if (start != SIZE_MAX && start > starts.back()) starts.push_back(start);
+		}
+		if (!splitter.balanced()) return {{current, tokenEnd}};
+
+		std::vector<std::pair<size_t, size_t> > slices;
+		size_t sliceStart = starts.front();
+		for (size_t i = 1; i < starts.size(); ++i) {
+			if (starts[i] - sliceStart >= target) {
+				slices.emplace_back(sliceStart, starts[i]);
+				sliceStart = starts[i];
 			}
 		}
-		auto program = make_polymorphic<ProgramNode>(startLoc, std::move(declarations));
+		slices.emplace_back(sliceStart, tokenEnd);
+		return slices;
+	}
 
-		return program;
+	polymorphic<ProgramNode> Parser::parseStream(const std::function<bool(std::vector<Token>&)>& next,
+	                                             const std::function<void(std::vector<polymorphic_ref<ASTNode> >)>& emit,
+	                                             const Flags& flags, ErrorReporter& errorReporter,
+	                                             std::ostream& errStream) {
+		constexpr size_t minimumRun = 1024; // Tokens of complete declarations worth starting a parser for
+		std::vector<polymorphic<ASTNode> > declarations;
+		SourceLocation startLoc{1, 1, 0, 0, ""};
+		// Tokens not parsed yet, every parsed run keeps its own buffer for the lazy bodies in it
+		auto pending = std::make_shared<std::vector<Token> >();
+		size_t parsed = 0, complete = 0; // Tokens before pending, tokens of whole declarations at its front
+		DeclarationSplitter splitter(0);
+		std::vector<Token> batch;
+		for (bool more = true, ended = false; more && !ended;) {
+			batch.clear();
+			more = next(batch);
+			if (parsed == 0 && pending->empty() && !batch.empty()) startLoc = batch.front().loc;
+			for (Token& token: batch) {
+				if (const size_t start = splitter.next(token.type); start != SIZE_MAX) complete = start - parsed;
+				pending->push_back(std::move(token));
+			}
+			ended = !pending->empty() && pending->back().type == TokenType::EOF_TOKEN;
+			if (ended) complete = pending->size();
+			if (complete == 0 || (complete < minimumRun && !ended)) continue;
+
+			auto rest = std::make_shared<std::vector<Token> >(std::make_move_iterator(pending->begin() + complete),
+			                                                  std::make_move_iterator(pending->end()));
+			pending->erase(pending->begin() + complete, pending->end());
+			Parser parser(pending, 0, complete, flags, errorReporter, errStream);
+			std::vector<polymorphic<ASTNode> > run;
+			parser.parseDeclarations(run);
+			if (parser.error) throw *parser.error; // Fatal, as in parse()
+			std::vector<polymorphic_ref<ASTNode> > refs(run.begin(), run.end());
+			std::ranges::move(run, std::back_inserter(declarations));
+			emit(std::move(refs));
+			parsed += complete;
+			complete = 0;
+			pending = std::move(rest);
+		}
+		return make_node<ProgramNode>(startLoc, std::move(declarations));
 	}
 
 	bool Parser::isBuiltInType(TokenType type) {
@@ -542,23 +840,26 @@ namespace zenith {
 	}
 
 	polymorphic<NewExprNode> Parser::parseNewExpression() {
+		auto syntaxScope = syntaxNode(SyntaxKind::NEW);
 		SourceLocation location = consume(TokenType::NEW).loc; // Eat 'new' keyword, nom nom nom
 		std::string className = consume(TokenType::IDENTIFIER).lexeme;
 
+		auto argsScope = syntaxNode(SyntaxKind::ARG_LIST);
 		consume(TokenType::LPAREN);
 		std::vector<polymorphic<ExprNode> > args;
 		if (!match(TokenType::RPAREN)) {
 			do {
 				args.push_back(parseExpression());
-			} while (match(TokenType::COMMA));
+			} while (match(TokenType::COMMA) && (advance(), true));
 			consume(TokenType::RPAREN);
 		}
 
-		return make_polymorphic<NewExprNode>(location, className, std::move(args));
+		return make_node<NewExprNode>(location, className, std::move(args));
 	}
 
 	polymorphic<FunctionDeclNode> Parser::parseFunction() {
 		SourceLocation loc = currentToken.loc;
+		auto syntaxScope = syntaxNode(SyntaxKind::FUNCTION);
 		// Handle annotations
 		bool isAsync = std::ranges::find_if(pendingAnnotations,
 		                                    [](const polymorphic<AnnotationNode> &ann) {
@@ -594,9 +895,10 @@ namespace zenith {
 			advance();
 			returnType = parseType();
 		}
-		auto body = parseBlock();
+		auto body = parseFunctionBody();
+		if (failed()) return nullptr; // Leave pendingAnnotations to the declaration after the recovery point
 
-		return make_polymorphic<FunctionDeclNode>(
+		return make_node<FunctionDeclNode>(
 			loc,
 			std::move(name),
 			std::move(params),
@@ -610,15 +912,31 @@ namespace zenith {
 
 	polymorphic<BlockNode> Parser::parseBlock() {
 		SourceLocation startLoc = currentToken.loc;
+		auto syntaxScope = syntaxNode(SyntaxKind::BLOCK);
 		consume(TokenType::LBRACE);
+		if (failed()) return nullptr;
 
 		std::vector<polymorphic<ASTNode> > statements;
-		try {
-			while (!match(TokenType::RBRACE) && !isAtEnd()) {
-				statements.emplace_back(parseStatement());
+		// Statements of function bodies are the unit of reuse below declarations, nested blocks go with theirs
+		const bool outermost = recording && blockDepth == 0;
+		++blockDepth;
+		while (!match(TokenType::RBRACE) && !isAtEnd()) {
+			if (ParseSpan* reusable = outermost && previousParse ? findReusable(previousParse->statements) : nullptr) {
+				statements.push_back(reuseSpan(*reusable, false));
+				continue;
 			}
-			consume(TokenType::RBRACE, "Expected '}' after block");
-		} catch (const ParseError &) {
+			const size_t begin = current, problemsBefore = problems;
+			const Inspected outer = startSpan();
+			auto statement = parseStatement();
+			const bool clean = outermost && !failed() && problems == problemsBefore;
+			finishSpan(clean ? &recording->statements : nullptr, begin, outer, clean ? statement.share() : nullptr);
+			if (failed()) break;
+			statements.emplace_back(std::move(statement));
+		}
+		--blockDepth;
+		consume(TokenType::RBRACE, "Expected '}' after block");
+		if (failed()) {
+			recover();
 			synchronize(); // Your error recovery method
 			if (!match(TokenType::RBRACE)) {
 				// Insert synthetic '}' if missing
@@ -626,7 +944,47 @@ namespace zenith {
 			}
 		}
 
-		return make_polymorphic<BlockNode>(startLoc, std::move(statements));
+		return make_node<BlockNode>(startLoc, std::move(statements));
+	}
+
+	polymorphic<BlockNode> Parser::parseFunctionBody() {
+		if (!flags.lazyParsing || !match(TokenType::LBRACE)) return parseBlock();
+
+		// Only match braces over token types here, the statements are parsed once semantic analysis enters the body
+		const size_t begin = current;
+		size_t depth = 0, end = begin;
+		for (; end < tokenEnd; ++end) {
+			const TokenType type = tokens[end].type;
+			if (type == TokenType::LBRACE || type == TokenType::DOLLAR_LBRACE) ++depth;
+			else if (type == TokenType::RBRACE && --depth == 0) break;
+		}
+		if (end == tokenEnd) return parseBlock(); // Unbalanced, the eager path reports it
+
+		SourceLocation loc = currentToken.loc;
+		current = end;
+		currentToken = tokens[end];
+		advance(); // '}'
+
+		// The body is parsed after this parser and its caller's flags are gone, it keeps a copy shared with its siblings
+		if (!lazyFlags) lazyFlags = std::make_shared<const Flags>(flags);
+		auto parseBody = [store = tokenStore, begin, flags = lazyFlags](ErrorReporter* reporter) {
+			// Bodies are parsed on analysis worker threads, keep them away from the shared debug stream
+			thread_local std::ostream discard(nullptr);
+			std::optional<DiagnosticsEngine> dropped;
+			std::optional<ErrorReporter> droppedReporter;
+			if (!reporter) reporter = &droppedReporter.emplace(dropped.emplace());
+			TimeTrace::Scope trace("Parse body", "parse");
+			Parser parser(store, begin, store->size(), *flags, *reporter, discard);
+			auto block = parser.parseBlock();
+			trace.counter("tokens", static_cast<int64_t>(parser.current - begin));
+			if (parser.failed()) {
+				const ParseError e = parser.recover();
+				reporter->report(e.location, e.format());
+				return std::vector<polymorphic<ASTNode> >{};
+			}
+			return std::move(block->statements);
+		};
+		return make_node<LazyBlockNode>(loc, end - begin + 1, std::move(parseBody));
 	}
 
 	polymorphic<StmtNode> Parser::parseStatement() {
@@ -634,7 +992,7 @@ namespace zenith {
 
 		//Maybe ex
 		// Declaration statements
-		if (match({TokenType::LET, TokenType::VAR, TokenType::DYNAMIC})) {
+		if (match({TokenType::LET, TokenType::VAR, TokenType::DYNAMIC, TokenType::CONST})) {
 			return parseVarDecl();
 		}
 
@@ -647,9 +1005,10 @@ namespace zenith {
 		}
 
 		if (match(TokenType::THIS)) {
+			auto syntaxScope = syntaxNode(SyntaxKind::EXPR_STMT);
 			auto expr = parseExpression();
 			if (match(TokenType::SEMICOLON)) advance();
-			return make_polymorphic<ExprStmtNode>(loc, std::move(expr));
+			return make_node<ExprStmtNode>(loc, std::move(expr));
 		}
 
 		// Control flow statements
@@ -661,6 +1020,7 @@ namespace zenith {
 
 		// Unsafe blocks
 		if (match(TokenType::UNSAFE)) {
+			auto syntaxScope = syntaxNode(SyntaxKind::UNSAFE_BLOCK);
 			advance(); // Consume 'unsafe'
 			return parseUnsafeBlock();
 		}
@@ -674,22 +1034,23 @@ namespace zenith {
 
 		// Expression statements
 		if (peekIsExpressionStart()) {
+			auto syntaxScope = syntaxNode(SyntaxKind::EXPR_STMT);
 			auto expr = parseExpression();
 			// Optional semicolon (Zenith allows brace-optional syntax)
 			if (match(TokenType::SEMICOLON)) {
 				advance();
 			}
-			return make_polymorphic<ExprStmtNode>(loc, std::move(expr));
+			return make_node<ExprStmtNode>(loc, std::move(expr));
 		}
 
 		// Empty statement (just a semicolon)
 		if (match(TokenType::SEMICOLON)) {
 			advance();
-			return make_polymorphic<EmptyStmtNode>(loc);
+			return make_node<EmptyStmtNode>(loc);
 		}
 
 		// Error recovery
-		throw ParseError(currentToken.loc, "Unexpected token in statement: " + currentToken.lexeme);
+		return fail(currentToken.loc, "Unexpected token in statement: " + currentToken.lexeme);
 	}
 
 	bool Parser::peekIsExpressionStart() const {
@@ -715,61 +1076,67 @@ namespace zenith {
 
 	Token Parser::peek(size_t offset) const {
 		size_t idx = current + offset;
-		if (idx >= tokens.size()) {
+		if (tokenEnd) look(std::min(idx, tokenEnd - 1));
+		if (idx >= tokenEnd || failed()) {
 			return Token{
 				TokenType::EOF_TOKEN, "",
-				tokens.empty() ? SourceLocation{1, 1, 0} : tokens.back().loc
+				tokenEnd == 0 ? SourceLocation{1, 1, 0, 0, ""} : tokens[tokenEnd - 1].loc
 			};
 		}
 		return tokens[idx];
 	}
 
 	polymorphic<IfNode> Parser::parseIfStmt() {
+		auto syntaxScope = syntaxNode(SyntaxKind::IF);
 		SourceLocation loc = consume(TokenType::IF).loc;
 		consume(TokenType::LPAREN, "Expected '(' after 'if'");
 		auto condition = parseExpression();
 		consume(TokenType::RPAREN, "Expected ')' after if condition");
+		if (failed()) return nullptr; // Recovered by the enclosing block, not by the branches below
 
 		// Parse 'then' branch (enforce braces if required)
 		polymorphic<StmtNode> thenBranch;
-		try {
-			if (flags.bracesRequired && !match(TokenType::LBRACE)) {
-				throw ParseError(currentToken.loc, "Expected '{' after 'if'");
-			}
+		if (flags.bracesRequired && !match(TokenType::LBRACE)) {
+			fail(currentToken.loc, "Expected '{' after 'if'");
+		}
+		else {
 			thenBranch = parseStatement();
-		} catch (const ParseError &e) {
+		}
+		if (failed()) {
+			const ParseError e = recover();
 			errorReporter.report(e.location, "Error in if body " + e.format());
 			errStream << "Error in if body: " << e.what() << std::endl;
 			synchronize(); // Skip to next statement
 			auto errorNode = createErrorNode();
-			thenBranch = make_polymorphic<EmptyStmtNode>(errorNode->loc);
+			thenBranch = make_node<EmptyStmtNode>(errorNode->loc);
 		}
 
 		// Parse 'else' branch (also enforce braces if required)
 		polymorphic<ASTNode> elseBranch;
 		if (match(TokenType::ELSE)) {
 			advance();
-			try {
-				if (flags.bracesRequired) {
-					if (!match(TokenType::LBRACE)) {
-						throw ParseError(currentToken.loc,
-						                 "Expected '{' after 'else' (braces are required)");
-					}
-					elseBranch = parseBlock();
+			if (flags.bracesRequired) {
+				if (!match(TokenType::LBRACE)) {
+					fail(currentToken.loc, "Expected '{' after 'else' (braces are required)");
 				}
 				else {
-					elseBranch = parseStatement();
+					elseBranch = parseBlock();
 				}
-			} catch (const ParseError &e) {
+			}
+			else {
+				elseBranch = parseStatement();
+			}
+			if (failed()) {
+				const ParseError e = recover();
 				errorReporter.report(e.location, "Error in else body " + e.format());
 				errStream << "Error in else body: " << e.what() << std::endl;
 				synchronize();
 				// Create error node or empty node as fallback
-				elseBranch = make_polymorphic<EmptyStmtNode>(currentToken.loc); // Simplified
+				elseBranch = make_node<EmptyStmtNode>(currentToken.loc); // Simplified
 			}
 		}
 
-		return make_polymorphic<IfNode>(
+		return make_node<IfNode>(
 			loc,
 			std::move(condition),
 			std::move(thenBranch),
@@ -778,6 +1145,7 @@ namespace zenith {
 	}
 
 	polymorphic<ForNode> Parser::parseForStmt() {
+		auto syntaxScope = syntaxNode(SyntaxKind::FOR);
 		SourceLocation loc = consume(TokenType::FOR).loc;
 		consume(TokenType::LPAREN);
 
@@ -791,7 +1159,7 @@ namespace zenith {
 			init = parseVarDecl();
 		}
 		else {
-			init = make_polymorphic<ExprStmtNode>(currentToken.loc, parseExpression());
+			init = make_node<ExprStmtNode>(currentToken.loc, parseExpression());
 		}
 		consume(TokenType::SEMICOLON);
 
@@ -809,16 +1177,16 @@ namespace zenith {
 
 		// Enforce braces if required
 		if (flags.bracesRequired && !match(TokenType::LBRACE)) {
-			throw ParseError(currentToken.loc,
-			                 "Expected '{' after 'for' (braces are required)");
+			return fail(currentToken.loc, "Expected '{' after 'for' (braces are required)");
 		}
 
 		auto body = parseStatement(); // parseBlock() if braces are required
-		return make_polymorphic<ForNode>(loc, std::move(init), std::move(condition),
+		return make_node<ForNode>(loc, std::move(init), std::move(condition),
 		                                 std::move(increment), std::move(body));
 	}
 
 	polymorphic<WhileNode> Parser::parseWhileStmt() {
+		auto syntaxScope = syntaxNode(SyntaxKind::WHILE);
 		SourceLocation loc = consume(TokenType::WHILE).loc;
 		consume(TokenType::LPAREN, "Expected '(' after 'while'");
 		auto condition = parseExpression();
@@ -826,21 +1194,20 @@ namespace zenith {
 
 		// Enforce braces if required
 		if (flags.bracesRequired && !match(TokenType::LBRACE)) {
-			throw ParseError(currentToken.loc,
-			                 "Expected '{' after 'while' (braces are required)");
+			return fail(currentToken.loc, "Expected '{' after 'while' (braces are required)");
 		}
 
 		auto body = parseStatement(); // parseBlock() if braces are required
-		return make_polymorphic<WhileNode>(loc, std::move(condition), std::move(body));
+		return make_node<WhileNode>(loc, std::move(condition), std::move(body));
 	}
 
 	polymorphic<DoWhileNode> Parser::parseDoWhileStmt() {
+		auto syntaxScope = syntaxNode(SyntaxKind::DO_WHILE);
 		SourceLocation loc = consume(TokenType::DO).loc;
 
 		// Enforce braces if required
 		if (flags.bracesRequired && !match(TokenType::LBRACE)) {
-			throw ParseError(currentToken.loc,
-			                 "Expected '{' after 'do' (braces are required)");
+			return fail(currentToken.loc, "Expected '{' after 'do' (braces are required)");
 		}
 
 		auto body = parseStatement(); // parseBlock() if braces are required
@@ -855,16 +1222,17 @@ namespace zenith {
 			advance();
 		}
 
-		return make_polymorphic<DoWhileNode>(loc, std::move(condition), std::move(body));
+		return make_node<DoWhileNode>(loc, std::move(condition), std::move(body));
 	}
 
 	polymorphic<ReturnStmtNode> Parser::parseReturnStmt() {
+		auto syntaxScope = syntaxNode(SyntaxKind::RETURN);
 		SourceLocation loc = consume(TokenType::RETURN).loc;
 
 		// Handle empty return (no expression)
 		if (match(TokenType::SEMICOLON)) {
 			advance(); // Consume the semicolon
-			return make_polymorphic<ReturnStmtNode>(loc, nullptr);
+			return make_node<ReturnStmtNode>(loc, nullptr);
 		}
 
 		// Parse return value (optional in Zenith)
@@ -883,7 +1251,7 @@ namespace zenith {
 			parseAnnotation();
 		}
 
-		return make_polymorphic<ReturnStmtNode>(loc, std::move(value));
+		return make_node<ReturnStmtNode>(loc, std::move(value));
 	}
 
 	bool Parser::peekIsStatementTerminator() const {
@@ -910,61 +1278,71 @@ namespace zenith {
 		}
 
 		consume(TokenType::RBRACE);
-		return make_polymorphic<FreeObjectNode>(loc, std::move(properties));
+		return make_node<FreeObjectNode>(loc, std::move(properties));
 	}
 
-	polymorphic<CallNode> Parser::parseFunctionCall(polymorphic<ExprNode> callee) {
+	polymorphic<CallNode> Parser::parseFunctionCall(polymorphic<ExprNode> callee, const SyntaxBuilder::Checkpoint start) {
 		SourceLocation loc = callee->loc;
+		auto syntaxScope = syntaxNodeAt(start, SyntaxKind::CALL);
+		auto argsScope = syntaxNode(SyntaxKind::ARG_LIST);
 		consume(TokenType::LPAREN);
 
 		std::vector<polymorphic<ExprNode> > args;
 		if (!match(TokenType::RPAREN)) {
 			do {
 				args.push_back(parseExpression());
-			} while (match(TokenType::COMMA));
+			} while (match(TokenType::COMMA) && (advance(), true));
 		}
 
 		consume(TokenType::RPAREN);
-		return make_polymorphic<CallNode>(loc, std::move(callee), std::move(args));
+		return make_node<CallNode>(loc, std::move(callee), std::move(args));
 	}
 
-	polymorphic<ExprNode> Parser::parseMemberAccess(polymorphic<ExprNode> object) {
+	polymorphic<ExprNode> Parser::parseMemberAccess(polymorphic<ExprNode> object, const SyntaxBuilder::Checkpoint start) {
 		SourceLocation loc = object->loc;
 
 		// First access (guaranteed to exist)
-		advance(); // Consume '.'
-		std::string member = consume(TokenType::IDENTIFIER).lexeme;
-		polymorphic<ExprNode> result = make_polymorphic<MemberAccessNode>(loc, std::move(object), member);
+		std::string member;
+		{
+			auto syntaxScope = syntaxNodeAt(start, SyntaxKind::MEMBER_ACCESS);
+			advance(); // Consume '.'
+			member = consume(TokenType::IDENTIFIER).lexeme;
+		}
+		polymorphic<ExprNode> result = make_node<MemberAccessNode>(loc, std::move(object), member);
 
 		// Handle additional accesses or calls
 		while (match(TokenType::DOT)) {
-			advance();
-			member = consume(TokenType::IDENTIFIER).lexeme;
-			result = make_polymorphic<MemberAccessNode>(loc, std::move(result), member);
+			{
+				auto syntaxScope = syntaxNodeAt(start, SyntaxKind::MEMBER_ACCESS);
+				advance();
+				member = consume(TokenType::IDENTIFIER).lexeme;
+			}
+			result = make_node<MemberAccessNode>(loc, std::move(result), member);
 
 			if (match(TokenType::LPAREN)) {
-				if (!result.is_type<MemberDeclNode>()) {
-					throw ParseError(loc, "Only member accesses can be called");
+				if (!result.is_type<DeclNode>()) {
+					return fail(loc, "Only member accesses can be called");
 				}
-				result = parseFunctionCall(std::move(result));
+				result = parseFunctionCall(std::move(result), start);
 			}
 		}
 
 		return result;
 	}
 
-	polymorphic<ExprNode> Parser::parseArrayAccess(polymorphic<ExprNode> arrayExpr) {
+	polymorphic<ExprNode> Parser::parseArrayAccess(polymorphic<ExprNode> arrayExpr, const SyntaxBuilder::Checkpoint start) {
 		SourceLocation loc = currentToken.loc;
 
 		// Keep processing chained array accesses (e.g., arr[1][2][3])
 		while (match(TokenType::LBRACKET)) {
+			auto syntaxScope = syntaxNodeAt(start, SyntaxKind::INDEX);
 			advance(); // Consume '['
 
 			auto indexExpr = parseExpression();
 			consume(TokenType::RBRACKET, "Expected ']' after array index");
 
 			// Create new array access node
-			arrayExpr = make_polymorphic<ArrayAccessNode>(
+			arrayExpr = make_node<ArrayAccessNode>(
 				loc,
 				std::move(arrayExpr), // The array being accessed
 				std::move(indexExpr) // The index expression
@@ -975,6 +1353,7 @@ namespace zenith {
 	}
 
 	polymorphic<AnnotationNode> Parser::parseAnnotation() {
+		auto syntaxScope = syntaxNode(SyntaxKind::ANNOTATION);
 		SourceLocation loc = consume(TokenType::AT).loc; // Eat '@' symbol
 
 		// Parse annotation name
@@ -999,20 +1378,21 @@ namespace zenith {
 					auto value = parseExpression();
 
 					arguments.emplace_back(argName, std::move(value));
-				} while (match(TokenType::COMMA));
+				} while (match(TokenType::COMMA) && (advance(), true));
 			}
 
 			consume(TokenType::RPAREN); // Consume ')'
 		}
 
-		return make_polymorphic<AnnotationNode>(loc, name, std::move(arguments));
+		return make_node<AnnotationNode>(loc, name, std::move(arguments));
 	}
 
 	polymorphic<ErrorNode> Parser::createErrorNode() {
-		return make_polymorphic<ErrorNode>(currentToken.loc);
+		return make_node<ErrorNode>(currentToken.loc);
 	}
 
 	polymorphic<ImportNode> Parser::parseImport() {
+		auto syntaxScope = syntaxNode(SyntaxKind::IMPORT);
 		SourceLocation loc = consume(TokenType::IMPORT).loc;
 		std::string importPath;
 		bool isJavaImport = false;
@@ -1055,13 +1435,13 @@ namespace zenith {
 			advance();
 		}
 
-		return make_polymorphic<ImportNode>(loc, importPath, isJavaImport);
+		return make_node<ImportNode>(loc, importPath, isJavaImport);
 	}
 
 	polymorphic<ObjectDeclNode> Parser::parseObject() {
+		auto syntaxScope = syntaxNode(SyntaxKind::OBJECT);
 		if (!match({TokenType::STRUCT, TokenType::CLASS})) {
-			errorReporter.report(currentToken.loc, "Yeah no",
-			                     {"Internal Error", RED_TEXT});
+			errorReporter.internalError(currentToken.loc, "Yeah no");
 		}
 		bool isClass = match(TokenType::CLASS);
 		ObjectDeclNode::Kind kind = isClass ? ObjectDeclNode::Kind::CLASS : ObjectDeclNode::Kind::STRUCT;
@@ -1082,28 +1462,30 @@ namespace zenith {
 
 		// Parse class body
 		consume(TokenType::LBRACE, "Expected '{' after object declaration");
-		std::vector<polymorphic<MemberDeclNode> > members;
+		std::vector<polymorphic<DeclNode> > members;
 
 		while (!match(TokenType::RBRACE) && !isAtEnd()) {
-			try {
-				// Parse annotations
-				std::vector<polymorphic<AnnotationNode> > annotations;
-				while (match(TokenType::AT)) {
-					annotations.push_back(parseAnnotation());
-				}
-				// Parse access modifier
-				members.push_back(parseObjectPrimary(className, annotations,
-				                                     isClass ? MemberDeclNode::Access::PRIVATE : MemberDeclNode::Access::PUBLIC));
-			} catch (const ParseError &e) {
+			// Parse annotations
+			std::vector<polymorphic<AnnotationNode> > annotations;
+			while (match(TokenType::AT)) {
+				annotations.push_back(parseAnnotation());
+			}
+			// Parse access modifier
+			auto member = parseObjectPrimary(className, annotations,
+			                                 isClass ? Member::Access::PRIVATE : Member::Access::PUBLIC);
+			if (failed()) {
+				const ParseError e = recover();
 				errorReporter.report(e.location, e.format());
 				errStream << e.what() << std::endl;
 				synchronize();
+				continue;
 			}
+			members.push_back(std::move(member));
 		}
 
 		consume(TokenType::RBRACE, "Expected '}' after object body");
 
-		return make_polymorphic<ObjectDeclNode>(
+		return make_node<ObjectDeclNode>(
 			classLoc,
 			kind,
 			std::move(className),
@@ -1112,29 +1494,30 @@ namespace zenith {
 		);
 	}
 
-	polymorphic<MemberDeclNode> Parser::parseObjectPrimary(std::string &name,
+	polymorphic<DeclNode> Parser::parseObjectPrimary(std::string &name,
 	                                                       std::vector<polymorphic<AnnotationNode> > &annotations,
-	                                                       MemberDeclNode::Access defaultLevel) {
-		MemberDeclNode::Access access = defaultLevel;
+	                                                       Member::Access defaultLevel) {
+		auto syntaxScope = syntaxNode(SyntaxKind::MEMBER);
+		Member::Access access = defaultLevel;
 		if (match(TokenType::PUBLIC)) {
 			advance();
-			access = MemberDeclNode::Access::PUBLIC;
+			access = Member::Access::PUBLIC;
 		}
 		else if (match(TokenType::PROTECTED)) {
 			advance();
-			access = MemberDeclNode::Access::PROTECTED;
+			access = Member::Access::PROTECTED;
 		}
 		else if (match(TokenType::PRIVATE)) {
 			advance();
-			access = MemberDeclNode::Access::PRIVATE;
+			access = Member::Access::PRIVATE;
 		}
 		else if (match(TokenType::PRIVATEW)) {
 			advance();
-			access = MemberDeclNode::Access::PRIVATEW;
+			access = Member::Access::PRIVATEW;
 		}
 		else if (match(TokenType::PROTECTEDW)) {
 			advance();
-			access = MemberDeclNode::Access::PROTECTEDW;
+			access = Member::Access::PROTECTEDW;
 		}
 
 		// Parse const modifier
@@ -1152,8 +1535,9 @@ namespace zenith {
 		// Check if it's a method (reuse parseFunctionDecl)
 		if (isPotentialMethod()) {
 			auto funcDecl = parseFunction();
-			// Convert FunctionDeclNode to MemberDeclNode
-			return make_polymorphic<MethodDeclNode>(
+			if (failed()) return nullptr;
+			// Convert FunctionDeclNode to MethodDeclNode
+			return make_node<MethodDeclNode>(
 				funcDecl->loc,
 				access,
 				isConst,
@@ -1172,14 +1556,16 @@ namespace zenith {
 		}
 	}
 
-	polymorphic<MemberDeclNode> Parser::parseField(std::vector<polymorphic<AnnotationNode> > &annotations,
-	                                               const MemberDeclNode::Access &access, bool isConst, bool isStatic) {
+	polymorphic<DeclNode> Parser::parseField(std::vector<polymorphic<AnnotationNode> > &annotations,
+	                                               const Member::Access &access, bool isConst, bool isStatic) {
+		auto syntaxScope = syntaxNode(SyntaxKind::FIELD);
 		auto varDecl = parseVarDecl();
 
 		consume(TokenType::SEMICOLON, "Expected ';' after field declaration");
+		if (failed()) return nullptr;
 
-		return make_polymorphic<FieldDeclNode>(
-			currentToken.loc,
+		return make_node<FieldDeclNode>(
+			varDecl->loc,
 			access,
 			isConst,
 			isStatic,
@@ -1190,9 +1576,10 @@ namespace zenith {
 		);
 	}
 
-	polymorphic<MemberDeclNode> Parser::parseConstructor(const MemberDeclNode::Access &access, bool isConst, bool isStatic,
+	polymorphic<DeclNode> Parser::parseConstructor(const Member::Access &access, bool isConst, bool isStatic,
 	                                                     std::string &className,
 	                                                     std::vector<polymorphic<AnnotationNode> > &annotations) {
+		auto syntaxScope = syntaxNode(SyntaxKind::CONSTRUCTOR);
 		SourceLocation loc = advance().loc;
 		std::vector<std::pair<std::string, polymorphic<ExprNode> > > initializers;
 		auto [params, usingSS] = parseParameters();
@@ -1209,14 +1596,15 @@ namespace zenith {
 				initializers.emplace_back(memberName, std::move(expr));
 			} while (match(TokenType::COMMA) && (advance(), true));
 		}
-		auto body = parseBlock();
+		auto body = parseFunctionBody();
+		if (failed()) return nullptr; // className and annotations belong to the caller until this succeeds
 
-		return make_polymorphic<CtorDeclNode>(
+		return make_node<CtorDeclNode>(
 			loc,
 			access,
 			isConst,
 			isStatic,
-			std::move(className),
+			std::string(className), // The object keeps its own name, a class may declare several constructors
 			std::move(params),
 			std::move(body),
 			std::move(initializers), // Ctor inits
@@ -1230,6 +1618,7 @@ namespace zenith {
 
 	std::pair<std::vector<FunctionDeclNode::Param>, bool> Parser::parseParameters() {
 		std::vector<FunctionDeclNode::Param> params;
+		auto syntaxScope = syntaxNode(SyntaxKind::PARAM_LIST);
 
 		consume(TokenType::LPAREN, "Expected '(' after function declaration");
 
@@ -1240,7 +1629,7 @@ namespace zenith {
 		}
 		polymorphic<TypeNode> currentType = nullptr;
 		bool firstParam = true;
-		while (!(inStructSyntax ? match(TokenType::RBRACE) : match(TokenType::RPAREN))) {
+		while (!failed() && !(inStructSyntax ? match(TokenType::RBRACE) : match(TokenType::RPAREN))) {
 			if (!firstParam) consume(TokenType::COMMA);
 			firstParam = false;
 
@@ -1250,9 +1639,9 @@ namespace zenith {
 			}
 			else if (match({TokenType::DYNAMIC})) {
 				advance();
-				paramType = make_polymorphic<TypeNode>(currentToken.loc, TypeNode::Kind::DYNAMIC);
+				paramType = make_node<TypeNode>(currentToken.loc, TypeNode::Kind::DYNAMIC);
 			} else {
-				paramType = make_polymorphic<TypeNode>(currentToken.loc, TypeNode::Kind::DYNAMIC);
+				paramType = make_node<TypeNode>(currentToken.loc, TypeNode::Kind::DYNAMIC);
 			}
 			std::string name = consume(TokenType::IDENTIFIER, "Expected parameter name").lexeme;
 			params.emplace_back(name, std::move(paramType));
@@ -1270,37 +1659,43 @@ namespace zenith {
 	}
 
 	bool Parser::isPotentialMethod() const {
-		// Look ahead to see if this is a method declaration
-		size_t lookahead = current;
-		while (lookahead < tokens.size()) {
-			const Token &tok = tokens[lookahead];
+		if (isAtEnd()) return false;
+		const uint64_t key = lookaheadKey(current, Lookahead::METHOD);
+		if (const auto it = lookaheadMemo.find(key); it != lookaheadMemo.end()) {
+			++lookaheadStats.memoHits;
+			look(std::min(it->second.end, tokenEnd - 1));
+			return it->second.matched;
+		}
+		++lookaheadStats.scans;
 
-			// Skip over type parameters or array dimensions
-			if (tok.type == TokenType::LBRACKET) {
-				lookahead++;
-				continue;
-			}
+		// Look ahead to see if this is a method declaration
+		LookaheadResult result{false, tokenEnd};
+		for (size_t lookahead = current; lookahead < tokenEnd; ++lookahead) {
+			++lookaheadStats.tokensScanned;
+			const TokenType type = tokens[lookahead].type;
 
 			// If we find '(' before ';' or '=', it's a method
-			if (tok.type == TokenType::LPAREN) {
-				return true;
+			if (type == TokenType::LPAREN) {
+				result = {true, lookahead};
+				break;
 			}
 
 			// If we find these tokens before '(', it's not a method
-			if (tok.type == TokenType::SEMICOLON ||
-			    tok.type == TokenType::EQUAL ||
-			    tok.type == TokenType::LBRACE) {
-				return false;
+			if (type == TokenType::SEMICOLON || type == TokenType::EQUAL || type == TokenType::LBRACE) {
+				result = {false, lookahead};
+				break;
 			}
-
-			lookahead++;
 		}
-		return false;
+		lookaheadMemo.emplace(key, result);
+		look(std::min(result.end, tokenEnd - 1));
+		return result.matched;
 	}
 
 	bool Parser::isInStructInitializerContext() const {
 		// Look back to see if we're after an equals sign following a type name
+		look(previous);
 		if (previous > 0 && tokens[previous].type == TokenType::EQUAL) {
+			if (previous > 1) look(previous - 2);
 			// Check if before the equals sign we have a type name
 			if (previous > 1 &&
 			    (isBuiltInType(tokens[previous - 2].type) || tokens[previous - 2].type == TokenType::IDENTIFIER) &&
@@ -1312,6 +1707,7 @@ namespace zenith {
 	}
 
 	polymorphic<StructInitializerNode> Parser::parseStructInitializer() {
+		auto syntaxScope = syntaxNode(SyntaxKind::STRUCT_INIT);
 		SourceLocation loc = consume(TokenType::LBRACE).loc;
 		std::vector<StructInitializerNode::StructFieldInitializer> fields;
 
@@ -1341,11 +1737,12 @@ namespace zenith {
 		}
 
 		consume(TokenType::RBRACE);
-		return make_polymorphic<StructInitializerNode>(loc, std::move(fields));
+		return make_node<StructInitializerNode>(loc, std::move(fields));
 	}
 
 	std::vector<FunctionDeclNode::Param> Parser::parseArrowFunctionParams() {
 		std::vector<FunctionDeclNode::Param> params;
+		auto syntaxScope = syntaxNode(SyntaxKind::ARROW_PARAMS);
 		consume(TokenType::LPAREN, "Expected '(' before arrow function parameters");
 
 		if (!match(TokenType::RPAREN)) {
@@ -1367,21 +1764,22 @@ namespace zenith {
 		if (!match(TokenType::LBRACE)) {
 			auto expr = parseExpression();
 			auto stmts = std::vector<polymorphic<ASTNode> >();
-			stmts.emplace_back(make_polymorphic<ReturnStmtNode>(loc, std::move(expr)));
-			auto body = make_polymorphic<BlockNode>(loc, std::move(stmts));
+			stmts.emplace_back(make_node<ReturnStmtNode>(loc, std::move(expr)));
+			auto body = make_node<BlockNode>(loc, std::move(stmts));
 
-			lambda = make_polymorphic<LambdaNode>(loc, std::move(params), false,  nullptr, std::move(body), false);
-			return make_polymorphic<LambdaExprNode>(loc, std::move(lambda));
+			lambda = make_node<LambdaNode>(loc, std::move(params), false,  nullptr, std::move(body), false);
+			return make_node<LambdaExprNode>(loc, std::move(lambda));
 		}
 
 		// Handle block body
 		auto body = parseBlock();
-		lambda = make_polymorphic<LambdaNode>(loc, std::move(params), false,  nullptr, std::move(body), false);
+		lambda = make_node<LambdaNode>(loc, std::move(params), false,  nullptr, std::move(body), false);
 
-		return make_polymorphic<LambdaExprNode>(loc, std::move(lambda));
+		return make_node<LambdaExprNode>(loc, std::move(lambda));
 	}
 
 	polymorphic<UnionDeclNode> Parser::parseUnion() {
+		auto syntaxScope = syntaxNode(SyntaxKind::UNION);
 		SourceLocation loc = consume(TokenType::UNION).loc;
 		std::string name = consume(TokenType::IDENTIFIER, "Expected union name").lexeme;
 		consume(TokenType::LBRACE, "Expected '{' after union declaration");
@@ -1391,9 +1789,11 @@ namespace zenith {
 		// Parse at least one type
 		do {
 			auto type = parseType();
+			if (failed()) return nullptr;
 
 			// Check for dynamic types (unions shouldn't allow them)
 			if (type->isDynamic()) {
+				++problems;
 				errorReporter.report(type->loc,
 				                     "Unions cannot contain dynamic types");
 			}
@@ -1406,10 +1806,11 @@ namespace zenith {
 		} while (!match(TokenType::RBRACE) && !isAtEnd());
 
 		consume(TokenType::RBRACE, "Expected '}' after union body");
-		return make_polymorphic<UnionDeclNode>(loc, std::move(name), std::move(types));
+		return make_node<UnionDeclNode>(loc, std::move(name), std::move(types));
 	}
 
 	polymorphic<ActorDeclNode> Parser::parseActorDecl() {
+		auto syntaxScope = syntaxNode(SyntaxKind::ACTOR);
 		SourceLocation loc = consume(TokenType::ACTOR).loc;
 		std::string name = consume(TokenType::IDENTIFIER, "Expected actor name").lexeme;
 
@@ -1422,26 +1823,25 @@ namespace zenith {
 
 		consume(TokenType::LBRACE, "Expected '{' after actor declaration");
 
-		std::vector<polymorphic<MemberDeclNode> > members;
+		std::vector<polymorphic<DeclNode> > members;
 		while (!match(TokenType::RBRACE) && !isAtEnd()) {
-			try {
-				// Parse message handlers (start with "on") or regular members
-				if (match(TokenType::ON)) {
-					members.push_back(parseMessageHandler(std::move(pendingAnnotations)));
-				}
-				else {
-					members.push_back(parseObjectPrimary(name, pendingAnnotations));
-				}
-			} catch (const ParseError &e) {
+			// Parse message handlers (start with "on") or regular members
+			auto member = match(TokenType::ON)
+				              ? parseMessageHandler(std::move(pendingAnnotations))
+				              : parseObjectPrimary(name, pendingAnnotations);
+			if (failed()) {
+				const ParseError e = recover();
 				errorReporter.report(e.location, e.format());
 				errStream << e.what() << std::endl;
 				synchronize();
+				continue;
 			}
+			members.push_back(std::move(member));
 		}
 
 		consume(TokenType::RBRACE, "Expected '}' after actor body");
 
-		return make_polymorphic<ActorDeclNode>(
+		return make_node<ActorDeclNode>(
 			loc,
 			std::move(name),
 			std::move(members),
@@ -1449,7 +1849,8 @@ namespace zenith {
 		);
 	}
 
-	polymorphic<MemberDeclNode> Parser::parseMessageHandler(std::vector<polymorphic<AnnotationNode> > annotations) {
+	polymorphic<DeclNode> Parser::parseMessageHandler(std::vector<polymorphic<AnnotationNode> > annotations) {
+		auto syntaxScope = syntaxNode(SyntaxKind::MESSAGE_HANDLER);
 		SourceLocation loc = consume(TokenType::ON).loc;
 		std::string messageType = consume(TokenType::IDENTIFIER, "Expected message type").lexeme;
 
@@ -1463,11 +1864,11 @@ namespace zenith {
 			returnType = parseType();
 		}
 
-		auto body = parseBlock();
+		auto body = parseFunctionBody();
 
-		return make_polymorphic<MessageHandlerNode>(
+		return make_node<MessageHandlerNode>(
 			loc,
-			MemberDeclNode::Access::PUBLIC,
+			Member::Access::PUBLIC,
 			false,
 			std::move(messageType),
 			std::move(params),
@@ -1478,10 +1879,10 @@ namespace zenith {
 	}
 
 	// Helper function to create error nodes that can be used as members
-	[[maybe_unused]] polymorphic<MemberDeclNode> Parser::createErrorNodeAsMember() {
-		return make_polymorphic<FieldDeclNode>(
+	[[maybe_unused]] polymorphic<DeclNode> Parser::createErrorNodeAsMember() {
+		return make_node<FieldDeclNode>(
 			currentToken.loc,
-			MemberDeclNode::Access::PRIVATE,
+			Member::Access::PRIVATE,
 			false,
 			false,
 			"",
@@ -1494,12 +1895,14 @@ namespace zenith {
 		if (currentToken.type == TokenType::LESS) {
 			// Make sure it's not part of a comparison operator
 			size_t next = current + 1;
-			return next < tokens.size() && tokens[next].type != TokenType::LESS;
+			look(std::min(next, tokenEnd - 1));
+			return next < tokenEnd && tokens[next].type != TokenType::LESS;
 		}
 		return false;
 	}
 
 	polymorphic<ScopeBlockNode> Parser::parseScopeBlock() {
+		auto syntaxScope = syntaxNode(SyntaxKind::SCOPE_BLOCK);
 		SourceLocation loc = consume(TokenType::SCOPE).loc;
 		consume(TokenType::LBRACE, "Expected '{' after 'scope'");
 
@@ -1511,7 +1914,7 @@ namespace zenith {
 
 		consume(TokenType::RBRACE, "Expected '}' after scope block");
 
-		return make_polymorphic<ScopeBlockNode>(loc, std::move(statements));
+		return make_node<ScopeBlockNode>(loc, std::move(statements));
 	}
 
 	std::vector<polymorphic<AnnotationNode> > Parser::parseAnnotations() {
@@ -1523,6 +1926,7 @@ namespace zenith {
 	}
 
 	polymorphic<TemplateDeclNode> Parser::parseTemplate() {
+		auto syntaxScope = syntaxNode(SyntaxKind::TEMPLATE);
 		SourceLocation loc = consume(TokenType::TEMPLATE).loc;
 		consume(TokenType::LESS, "Expected '<' after 'template'");
 
@@ -1545,11 +1949,11 @@ namespace zenith {
 			declaration = parseActorDecl();
 		}
 		else {
-			throw ParseError(currentToken.loc,
-			                 "Expected class, struct, function, union or actor after template declaration");
+			return fail(currentToken.loc,
+			            "Expected class, struct, function, union or actor after template declaration");
 		}
 
-		return make_polymorphic<TemplateDeclNode>(
+		return make_node<TemplateDeclNode>(
 			loc,
 			std::move(params),
 			declaration
@@ -1559,9 +1963,11 @@ namespace zenith {
 	// Helper function to parse template parameters (used for template template parameters)
 	std::vector<TemplateParameter> Parser::parseTemplateParameters() {
 		std::vector<TemplateParameter> params;
+		auto syntaxScope = syntaxNode(SyntaxKind::TEMPLATE_PARAMS);
 		bool hasVariadic = false;
 
 		do {
+			const SourceLocation paramLoc = currentToken.loc;
 			// Handle variadic parameter
 			if (match(TokenType::ELLIPSIS)) {
 				advance();
@@ -1631,9 +2037,10 @@ namespace zenith {
 				);
 			}*/
 			else {
-				throw ParseError(currentToken.loc,
-				                 "Expected 'typename', type, or 'template' in template parameter");
+				fail(currentToken.loc, "Expected 'typename', type, or 'template' in template parameter");
+				break;
 			}
+			params.back().loc = paramLoc;
 
 			hasVariadic = false;
 		} while (match(TokenType::COMMA) && (advance(), true));
@@ -1644,42 +2051,73 @@ namespace zenith {
 	polymorphic<UnsafeNode> Parser::parseUnsafeBlock() {
 		SourceLocation startLoc = currentToken.loc;
 		consume(TokenType::LBRACE);
+		if (failed()) return nullptr;
 
 		std::vector<polymorphic<ASTNode> > statements;
-		try {
-			while (!match(TokenType::RBRACE) && !isAtEnd()) {
-				statements.emplace_back(parseStatement());
-			}
-			consume(TokenType::RBRACE, "Expected '}' after block");
-		} catch (const ParseError &) {
+		while (!match(TokenType::RBRACE) && !isAtEnd()) {
+			auto statement = parseStatement();
+			if (failed()) break;
+			statements.emplace_back(std::move(statement));
+		}
+		consume(TokenType::RBRACE, "Expected '}' after block");
+		if (failed()) {
+			recover();
 			synchronize(); // Your error recovery method
 			if (!match(TokenType::RBRACE)) {
 				// Insert synthetic '}' if missing
 				statements.emplace_back(createErrorNode());
 			}
 		}
-		return make_polymorphic<UnsafeNode>(startLoc, std::move(statements));
+		return make_node<UnsafeNode>(startLoc, std::move(statements));
 	}
 
 	bool Parser::isArrowFunctionStart() const {
 		if (!match(TokenType::LPAREN)) return false;
+		return scanParenthesized(current).matched;
+	}
 
-		size_t i = current;
-		int depth = 0;
-
-		while (i < tokens.size()) {
-			if (tokens[i].type == TokenType::LPAREN) depth++;
-			else if (tokens[i].type == TokenType::RPAREN) {
-				depth--;
-				if (depth == 0) {
-					// Check token AFTER the closing ')'
-					return (i + 1 < tokens.size() &&
-					        tokens[i + 1].type == TokenType::LAMBARROW);
+	Parser::LookaheadResult Parser::scanParenthesized(const size_t open) const {
+		// Decided by the tokens from open to the token after the matching ')'
+		auto decidedBy = [&](const LookaheadResult& result) {
+			look(open);
+			look(std::min(result.end + 1, tokenEnd - 1));
+			return result;
+		};
+		if (const auto it = lookaheadMemo.find(lookaheadKey(open, Lookahead::ARROW_FUNCTION)); it != lookaheadMemo.end()) {
+			++lookaheadStats.memoHits;
+			return decidedBy(it->second);
+		}
+		++lookaheadStats.scans;
+
+		// Every '(' closed on the way gets its answer too, so nested parens cost one scan in total instead of one each
+		std::vector<size_t> openParens;
+		for (size_t i = open; i < tokenEnd; ++i) {
+			++lookaheadStats.tokensScanned;
+			if (tokens[i].type == TokenType::LPAREN) {
+				const auto known = i == open ? lookaheadMemo.end()
+				                             : lookaheadMemo.find(lookaheadKey(i, Lookahead::ARROW_FUNCTION));
+				if (known != lookaheadMemo.end()) {
+					i = known->second.end; // Already matched, jump past it
+					continue;
 				}
+				openParens.push_back(i);
+			}
+			else if (tokens[i].type == TokenType::RPAREN) {
+				const size_t matchedOpen = openParens.back();
+				openParens.pop_back();
+				// It's a lambda if the token after the closing ')' is '=>'
+				const LookaheadResult result{i + 1 < tokenEnd && tokens[i + 1].type == TokenType::LAMBARROW, i};
+				lookaheadMemo.emplace(lookaheadKey(matchedOpen, Lookahead::ARROW_FUNCTION), result);
+				if (openParens.empty()) return decidedBy(result);
 			}
-			i++;
 		}
-		return false;
+
+		// Unbalanced, none of the parens still open has a match
+		const LookaheadResult unmatched{false, tokenEnd};
+		for (const size_t paren: openParens) {
+			lookaheadMemo.emplace(lookaheadKey(paren, Lookahead::ARROW_FUNCTION), unmatched);
+		}
+		return decidedBy(unmatched);
 	}
 }
 #pragma clang diagnostic pop
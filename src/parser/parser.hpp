@@ -1,25 +1,101 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <iostream>
 #include "../lexer/lexer.hpp"
 #include "../utils/mainargs.hpp"
 #include "../exceptions/ErrorReporter.hpp"
+#include "../exceptions/ParseError.hpp"
+#include "../utils/ThreadPool.hpp"
 #include "../ast/AST.hpp"
+#include "../syntax/GreenTree.hpp"
+#include "IncrementalParse.hpp"
 
 namespace zenith {
+	struct LookaheadStats {
+		size_t scans = 0;        // Speculative scans that had to look at tokens
+		size_t tokensScanned = 0;
+		size_t memoHits = 0;
+	};
+
 	class Parser {
-		std::vector<Token> tokens;
+		std::shared_ptr<std::vector<Token>> tokenStore; // Shared with the lazy bodies created by this parser
+		std::vector<Token>& tokens;
+		size_t tokenEnd; // This parser stops here
+		size_t declarationsEnd = SIZE_MAX; // A slice of a parallel parse starts no top-level declaration from here on
 		size_t current = 0;
 		size_t previous = 0;
 		Token currentToken;
 		const Flags& flags;
+		std::shared_ptr<const Flags> lazyFlags; // Copy of flags for the lazy bodies, made for the first one
 		std::ostream& errStream;
-		ErrorReporter errorReporter;
+		ErrorReporter& errorReporter;
+		ThreadPool* pool = nullptr;
 		std::vector<polymorphic<AnnotationNode>> pendingAnnotations;
 
+		// Syntax errors are not thrown. fail() records the first one and makes the parser look like it hit the end of
+		// input, so every parse method falls through to its caller without consuming anything. The nearest recovery
+		// point (block, member list, top-level loop) drops what was built since, takes the error and synchronizes.
+		std::optional<ParseError> error;
+		Token errorToken{TokenType::EOF_TOKEN, "", SourceLocation{}}; // The real currentToken while failed()
+
+		// Speculative scans, memoized per (token index, predicate) so no region is scanned twice
+		enum class Lookahead : uint8_t { ARROW_FUNCTION, METHOD };
+		struct LookaheadResult {
+			bool matched;
+			size_t end; // Token the scan decided on, the matching ')' for ARROW_FUNCTION
+		};
+		mutable std::unordered_map<uint64_t, LookaheadResult> lookaheadMemo;
+		mutable LookaheadStats lookaheadStats;
+
+		// Lossless tree recording, off unless recordSyntax() was called
+		// Every consumed token goes to the builder from advance(), parse methods open a node for what they consume.
+		SyntaxBuilder* syntax = nullptr;
+		class SyntaxScope { // Closes the node on every way out of the parse method
+			SyntaxBuilder* builder;
+		public:
+			explicit SyntaxScope(SyntaxBuilder* builder) : builder(builder) {}
+			SyntaxScope(const SyntaxScope&) = delete;
+			SyntaxScope& operator=(const SyntaxScope&) = delete;
+			~SyntaxScope() { if (builder) builder->finishNode(); }
+		};
+		SyntaxScope syntaxNode(SyntaxKind kind);
+		SyntaxScope syntaxNodeAt(SyntaxBuilder::Checkpoint at, SyntaxKind kind);
+		SyntaxBuilder::Checkpoint syntaxCheckpoint();
+
+		// Incremental parsing: spans are recorded while parsing for editing, and taken over from the previous parse
+		// instead of being parsed again when the edit cannot have changed them
+		struct Inspected {
+			size_t first, last;
+		};
+		mutable Inspected inspected{}; // Tokens read since the innermost span being recorded started
+		size_t problems = 0;           // Recoveries and diagnostics so far, a span that adds any is not recorded
+		IncrementalParse* recording = nullptr;
+		IncrementalParse* previousParse = nullptr;
+		TokenEdit edit{};
+		size_t blockDepth = 0;
+
+		void look(size_t index) const {
+			inspected.first = std::min(inspected.first, index);
+			inspected.last = std::max(inspected.last, index);
+		}
+		Inspected startSpan();
+		void finishSpan(std::vector<ParseSpan>* spans, size_t begin, Inspected outer, polymorphic<ASTNode> node);
+		ParseSpan* findReusable(std::vector<ParseSpan>& spans) const; // Old span that parses the same at current
+		polymorphic<ASTNode> reuseSpan(ParseSpan& span, bool declaration); // Moves past it, returns its node
+		IncrementalParse parseRecorded(IncrementalParse* old, const TokenEdit& edit);
+
+		static uint64_t lookaheadKey(const size_t index, const Lookahead predicate) {
+			return static_cast<uint64_t>(index) << 1 | static_cast<uint64_t>(predicate);
+		}
+		LookaheadResult scanParenthesized(size_t open) const;
+
 		// Helper methods
 		bool isAtEnd() const;
 		bool match(TokenType type) const;
@@ -30,6 +106,9 @@ namespace zenith {
 		Token peek(size_t offset = 1) const;
 		const Token& previousToken() const;
 		void synchronize();
+		bool failed() const { return error.has_value(); }
+		std::nullptr_t fail(SourceLocation loc, std::string message);
+		ParseError recover();
 		bool isPotentialMethod() const;
 
 		// Type checking
@@ -42,7 +121,7 @@ namespace zenith {
 		bool peekIsTemplateStart() const;
 		bool isInStructInitializerContext() const;
 
-		//std::vector<polymorphic<MemberDeclNode>> parseActorMembers(std::string& actorName);
+		//std::vector<polymorphic<DeclNode>> parseActorMembers(std::string& actorName);
 		//polymorphic<MultiVarDeclNode> parseVarDecls();
 		// Parsing methods
 		polymorphic<TypeNode> parseType();
@@ -54,10 +133,10 @@ namespace zenith {
 		polymorphic<StructInitializerNode> parseStructInitializer();
 
 		std::pair<std::vector<FunctionDeclNode::Param>, bool> parseParameters();
-		polymorphic<MemberDeclNode> parseMessageHandler(std::vector<polymorphic<AnnotationNode>> annotations);
-		polymorphic<MemberDeclNode> parseField(std::vector<polymorphic<AnnotationNode>> &annotations, const MemberDeclNode::Access &access, bool isConst, bool isStatic);
-		polymorphic<MemberDeclNode> parseConstructor(const MemberDeclNode::Access &access, bool isConst, bool isStatic,  std::string &className, std::vector<polymorphic<AnnotationNode>> &annotations);
-		polymorphic<MemberDeclNode> parseObjectPrimary(std::string &name, std::vector<polymorphic<AnnotationNode>> &annotations, MemberDeclNode::Access defaultLevel = MemberDeclNode::Access::PUBLIC);
+		polymorphic<DeclNode> parseMessageHandler(std::vector<polymorphic<AnnotationNode>> annotations);
+		polymorphic<DeclNode> parseField(std::vector<polymorphic<AnnotationNode>> &annotations, const Member::Access &access, bool isConst, bool isStatic);
+		polymorphic<DeclNode> parseConstructor(const Member::Access &access, bool isConst, bool isStatic,  std::string &className, std::vector<polymorphic<AnnotationNode>> &annotations);
+		polymorphic<DeclNode> parseObjectPrimary(std::string &name, std::vector<polymorphic<AnnotationNode>> &annotations, Member::Access defaultLevel = Member::Access::PUBLIC);
 
 		// Declaration parsers
 		polymorphic<ImportNode> parseImport();
@@ -78,6 +157,7 @@ namespace zenith {
 		polymorphic<ScopeBlockNode> parseScopeBlock();
 		polymorphic<TemplateDeclNode> parseTemplate();
 		polymorphic<BlockNode> parseBlock();
+		polymorphic<BlockNode> parseFunctionBody();
 		polymorphic<UnsafeNode> parseUnsafeBlock();
 
 		bool isArrowFunctionStart() const;
@@ -85,18 +165,58 @@ namespace zenith {
 		// Expression parsers
 		polymorphic<NewExprNode> parseNewExpression();
 		polymorphic<FreeObjectNode> parseFreeObject();
-		polymorphic<CallNode> parseFunctionCall(polymorphic<ExprNode> callee);
-		polymorphic<ExprNode> parseArrayAccess(polymorphic<ExprNode> arrayExpr);
+		// start is the checkpoint taken before the callee, the node wraps it
+		polymorphic<CallNode> parseFunctionCall(polymorphic<ExprNode> callee, SyntaxBuilder::Checkpoint start);
+		polymorphic<ExprNode> parseArrayAccess(polymorphic<ExprNode> arrayExpr, SyntaxBuilder::Checkpoint start);
 		polymorphic<LambdaExprNode> parseArrowFunction(std::vector<FunctionDeclNode::Param> &&params);
-		polymorphic<ExprNode> parseMemberAccess(polymorphic<ExprNode> object);
+		polymorphic<ExprNode> parseMemberAccess(polymorphic<ExprNode> object, SyntaxBuilder::Checkpoint start);
 		// Error handling
 		polymorphic<ErrorNode> createErrorNode();
 
-		[[maybe_unused]] polymorphic<MemberDeclNode> createErrorNodeAsMember();
+		[[maybe_unused]] polymorphic<DeclNode> createErrorNodeAsMember();
+
+		// Parses tokens[start, end) of a shared token buffer: a lazy body or a slice of top-level declarations
+		Parser(std::shared_ptr<std::vector<Token>> tokens, size_t start, size_t end, const Flags& flags,
+		       ErrorReporter& errorReporter, std::ostream& errStream);
+
+		// Top level
+		void parseDeclarations(std::vector<polymorphic<ASTNode>>& declarations);
+		bool parseDeclaration(std::vector<polymorphic<ASTNode>>& declarations); // One loop iteration, false if fatal
 
 	public:
-		explicit Parser(std::vector<Token> tokens, const Flags& flags, std::ostream& errStream = std::cerr);
+		// With a pool, runs of top-level declarations are parsed in parallel
+		Parser(std::vector<Token> tokens, const Flags& flags, ErrorReporter& errorReporter, std::ostream& errStream = std::cerr,
+		       ThreadPool* pool = nullptr);
 		polymorphic<ProgramNode> parse();
+		// The token ranges parse() hands to the pool: runs of whole top-level declarations of at least target tokens
+		// each, the last one taking the rest. One slice if the brackets do not match up.
+		[[nodiscard]] std::vector<std::pair<size_t, size_t>> splitDeclarations(size_t target) const;
+		// Parses a file whose tokens arrive in batches: next() appends the following one and returns false after the last.
+		// Every run of complete top-level declarations goes to emit as soon as it is parsed, in source order, and stays
+		// owned by the returned program. A stream that stops before EOF_TOKEN was cut short, its unfinished tail is
+		// dropped. Throws like parse().
+		static polymorphic<ProgramNode> parseStream(const std::function<bool(std::vector<Token>&)>& next,
+		                                            const std::function<void(std::vector<polymorphic_ref<ASTNode>>)>& emit,
+		                                            const Flags& flags, ErrorReporter& errorReporter,
+		                                            std::ostream& errStream = std::cerr);
+		// The tokens as one expression and nothing else, throws like parse()
+		polymorphic<ExprNode> parseExpressionOnly();
+		[[nodiscard]] const LookaheadStats& lookahead() const { return lookaheadStats; }
+		// Feeds builder with every token and node while parsing. Needs an eager, single-threaded parse.
+		void recordSyntax(SyntaxBuilder* builder) { syntax = builder; }
+
+		// Parses tokens like parse() does, keeping what reparse() needs to update the result after an edit
+		// Function bodies are always parsed eagerly. Throws like parse().
+		static IncrementalParse parseForEditing(std::vector<Token> tokens, const Flags& flags,
+		                                        ErrorReporter& errorReporter, std::ostream& errStream = std::cerr);
+		// Same result as parseForEditing(tokens) for the edited source, reparsing only the declarations and
+		// statements the edit touches or could have changed. Nodes of previous are moved into the result.
+		static IncrementalParse reparse(IncrementalParse&& previous, const TextEdit& edit, std::vector<Token> tokens,
+		                                const Flags& flags, ErrorReporter& errorReporter,
+		                                std::ostream& errStream = std::cerr);
+		// The same when Lexer::relex() already turned previous.tokens into the tokens of the edited source
+		static IncrementalParse reparse(IncrementalParse&& previous, const TokenEdit& edit, const Flags& flags,
+		                                ErrorReporter& errorReporter, std::ostream& errStream = std::cerr);
 
 	};
 }
\ No newline at end of file
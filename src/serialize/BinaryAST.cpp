@@ -0,0 +1,1224 @@
+#include "BinaryAST.hpp"
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zenith {
+	namespace {
+		enum class Kind : uint8_t {
+			PROGRAM, IMPORT, VAR_DECL, MULTI_VAR_DECL, FUNCTION, LAMBDA, FIELD, METHOD, CONSTRUCTOR, MESSAGE_HANDLER,
+			OPERATOR, OBJECT, ACTOR, UNION, TEMPLATE, TEMPLATE_PARAMETER, ANNOTATION, ERROR,
+			BLOCK, SCOPE_BLOCK, UNSAFE, IF, WHILE, DO_WHILE, FOR, EXPR_STMT, EMPTY_STMT, RETURN, COMPOUND,
+			// Expressions, their records carry the constant value semantic analysis folded them to
+			LITERAL, VAR, BINARY, UNARY, CALL, MEMBER_ACCESS, FREE_OBJECT, ARRAY_ACCESS, NEW, TEMPLATE_STRING, THIS,
+			STRUCT_INIT, LAMBDA_EXPR,
+			TYPE, PRIMITIVE_TYPE, NAMED_TYPE, ARRAY_TYPE, TEMPLATE_TYPE, FUNCTION_TYPE
+		};
+
+		bool isExpression(const Kind kind) { return kind >= Kind::LITERAL && kind <= Kind::LAMBDA_EXPR; }
+
+		constexpr char MAGIC[4] = {'Z', 'A', 'S', 'T'};
+		constexpr size_t HEADER_SIZE = 32;
+		const SourceLocation ROOT{0, 0, 0, 0, {}}; // What the program's location is relative to
+
+		uint64_t zigzag(const int64_t value) {
+			return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+		}
+
+		int64_t unzigzag(const uint64_t value) {
+			return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+		}
+
+		uint8_t memberFlags(const Member::Flags flags) {
+			return static_cast<uint8_t>(flags.kind) | static_cast<uint8_t>(flags.access) << 2 |
+			       flags.isConst << 5 | flags.isStatic << 6;
+		}
+
+		// --- Writing ---
+
+		class Writer : public Visitor {
+			std::string out = std::string(HEADER_SIZE, '\0');
+			std::unordered_map<std::string, uint64_t> index;
+			std::vector<const std::string*> strings;
+			const SourceLocation* parent = &ROOT;
+			size_t written = 0; // Offset of the record written last
+
+			// Children are written before the record that refers to them, relative to its location
+			struct Children {
+				const SourceLocation* outer;
+				std::vector<size_t> offsets;
+				size_t record = 0;
+			};
+
+			Children enter(ASTNode& node) { return {std::exchange(parent, &node.loc), {}}; }
+
+			template<typename T>
+			void add(Children& children, T& node) {
+				if (node) node->accept(*this);
+				children.offsets.push_back(node ? written : 0);
+			}
+
+			void addValue(Children& children, ASTNode& node) {
+				node.accept(*this);
+				children.offsets.push_back(written);
+			}
+
+			void begin(Children& children, ASTNode& node, const Kind kind) {
+				parent = children.outer;
+				children.record = out.size();
+				byte(static_cast<uint8_t>(kind));
+				varint(zigzag(static_cast<int64_t>(node.loc.line - parent->line)));
+				varint(node.loc.column);
+				varint(node.loc.length);
+				varint(zigzag(static_cast<int64_t>(node.loc.fileOffset - parent->fileOffset)));
+				text(node.loc.file);
+			}
+
+			void begin(Children& children, ExprNode& node, const Kind kind) {
+				begin(children, static_cast<ASTNode&>(node), kind);
+				const auto& constant = node.constantValue;
+				if (!constant) {
+					byte(0);
+					return;
+				}
+				byte(static_cast<uint8_t>(constant->kind) + 1);
+				byte(static_cast<uint8_t>(constant->value.index()));
+				switch (constant->value.index()) {
+					case 0: varint(zigzag(std::get<int64_t>(constant->value))); break;
+					case 1: fixed(std::bit_cast<uint64_t>(std::get<double>(constant->value))); break;
+					case 2: byte(std::get<bool>(constant->value)); break;
+					default: text(std::get<std::string>(constant->value)); break;
+				}
+			}
+
+			void end(const Children& children) {
+				for (const size_t offset: children.offsets) varint(offset ? children.record - offset : 0);
+				written = children.record;
+			}
+
+			void byte(const uint8_t value) { out.push_back(static_cast<char>(value)); }
+
+			void varint(uint64_t value) {
+				while (value >= 0x80) {
+					byte(static_cast<uint8_t>(value | 0x80));
+					value >>= 7;
+				}
+				byte(static_cast<uint8_t>(value));
+			}
+
+			void fixed(uint64_t value) {
+				for (int i = 0; i < 8; ++i, value >>= 8) byte(static_cast<uint8_t>(value));
+			}
+
+			void text(const std::string& value) {
+				const auto [it, added] = index.try_emplace(value, strings.size());
+				if (added) strings.push_back(&it->first);
+				varint(it->second);
+			}
+
+			void escape(const EscapeInfo& info) {
+				byte(static_cast<uint8_t>(info.verdict));
+				byte(info.causes);
+			}
+
+			// Function-like nodes: children first, then the fields
+			void addFunction(Children& children, FunctionDeclNode& node) {
+				for (auto& annotation: node.annotations) add(children, annotation);
+				for (auto& param: node.params) {
+					add(children, param.type);
+					add(children, param.defaultValue);
+				}
+				add(children, node.returnType);
+				add(children, node.body);
+			}
+
+			void function(const FunctionDeclNode& node) {
+				text(node.name);
+				byte(node.isAsync | node.usingStructSugar << 1);
+				varint(node.annotations.size());
+				varint(node.params.size());
+				for (const auto& param: node.params) text(param.name);
+			}
+
+			// Fields and methods, which both hold member flags
+			template<typename Node>
+			void member(const Node& node) {
+				byte(memberFlags(node.flags));
+				text(node.name);
+			}
+
+			void object(ObjectDeclNode& node, const Kind kind) {
+				auto children = enter(node);
+				for (auto& member: node.members) add(children, member);
+				for (auto& op: node.operators) add(children, op);
+				begin(children, node, kind);
+				byte(static_cast<uint8_t>(node.kind));
+				text(node.name);
+				text(node.base);
+				byte(node.autoGettersSetters);
+				varint(node.members.size());
+				varint(node.operators.size());
+				end(children);
+			}
+
+			void block(BlockNode& node, const Kind kind) {
+				auto children = enter(node);
+				for (auto& statement: node.statements) add(children, statement);
+				begin(children, node, kind);
+				varint(node.statements.size());
+				end(children);
+			}
+
+			void method(MethodDeclNode& node, const Kind kind) {
+				auto children = enter(node);
+				addFunction(children, node);
+				begin(children, node, kind);
+				member(node);
+				function(node);
+				end(children);
+			}
+
+		public:
+			std::string finish(ProgramNode& program) {
+				program.accept(*this);
+				const size_t root = written, table = out.size();
+				varint(strings.size());
+				for (const std::string* value: strings) {
+					varint(value->size());
+					out += *value;
+				}
+
+				auto put = [this](size_t at, uint64_t value, const int bytes) {
+					for (int i = 0; i < bytes; ++i, value >>= 8) out[at + i] = static_cast<char>(value & 0xff);
+				};
+				out.replace(0, 4, MAGIC, 4);
+				put(4, BinaryAST::VERSION, 4);
+				put(8, root, 8);
+				put(16, table, 8);
+				put(24, out.size(), 8);
+				return std::move(out);
+			}
+
+			void visit(ProgramNode& node) override {
+				auto children = enter(node);
+				for (auto& declaration: node.declarations) add(children, declaration);
+				begin(children, node, Kind::PROGRAM);
+				varint(node.declarations.size());
+				end(children);
+			}
+
+			void visit(ImportNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::IMPORT);
+				text(node.path);
+				byte(node.isJavaImport);
+				end(children);
+			}
+
+			void visit(VarDeclNode& node) override {
+				auto children = enter(node);
+				add(children, node.type);
+				add(children, node.initializer);
+				begin(children, node, Kind::VAR_DECL);
+				byte(node.kind);
+				text(node.name);
+				byte(node.isHoisted | node.isConst << 1);
+				end(children);
+			}
+
+			void visit(MultiVarDeclNode& node) override {
+				auto children = enter(node);
+				for (auto& var: node.vars) add(children, var);
+				begin(children, node, Kind::MULTI_VAR_DECL);
+				varint(node.vars.size());
+				end(children);
+			}
+
+			void visit(FunctionDeclNode& node) override {
+				auto children = enter(node);
+				addFunction(children, node);
+				begin(children, node, Kind::FUNCTION);
+				function(node);
+				end(children);
+			}
+
+			void visit(LambdaNode& node) override {
+				auto children = enter(node);
+				addFunction(children, node);
+				begin(children, node, Kind::LAMBDA);
+				function(node);
+				end(children);
+			}
+
+			void visit(FieldDeclNode& node) override {
+				auto children = enter(node);
+				for (auto& annotation: node.annotations) add(children, annotation);
+				add(children, node.type);
+				add(children, node.initializer);
+				begin(children, node, Kind::FIELD);
+				member(node);
+				varint(node.annotations.size());
+				end(children);
+			}
+
+			void visit(MethodDeclNode& node) override { method(node, Kind::METHOD); }
+			void visit(MessageHandlerNode& node) override { method(node, Kind::MESSAGE_HANDLER); }
+
+			void visit(CtorDeclNode& node) override {
+				auto children = enter(node);
+				addFunction(children, node);
+				for (auto& [name, value]: node.initializers) add(children, value);
+				begin(children, node, Kind::CONSTRUCTOR);
+				member(node);
+				varint(node.initializers.size());
+				for (const auto& [name, value]: node.initializers) text(name);
+				function(node);
+				end(children);
+			}
+
+			void visit(OperatorOverloadNode& node) override {
+				auto children = enter(node);
+				for (auto& [name, type]: node.params) add(children, type);
+				add(children, node.returnType);
+				add(children, node.body);
+				begin(children, node, Kind::OPERATOR);
+				text(node.op);
+				varint(node.params.size());
+				for (const auto& [name, type]: node.params) text(name);
+				end(children);
+			}
+
+			void visit(ObjectDeclNode& node) override { object(node, Kind::OBJECT); }
+			void visit(ActorDeclNode& node) override { object(node, Kind::ACTOR); }
+
+			void visit(UnionDeclNode& node) override {
+				auto children = enter(node);
+				for (auto& type: node.types) add(children, type);
+				begin(children, node, Kind::UNION);
+				text(node.name);
+				varint(node.types.size());
+				end(children);
+			}
+
+			void visit(TemplateDeclNode& node) override {
+				auto children = enter(node);
+				for (auto& parameter: node.parameters) addValue(children, parameter);
+				add(children, node.declaration);
+				begin(children, node, Kind::TEMPLATE);
+				varint(node.parameters.size());
+				end(children);
+			}
+
+			void visit(TemplateParameter& node) override {
+				auto children = enter(node);
+				add(children, node.defaultType);
+				add(children, node.type);
+				add(children, node.defaultValue);
+				for (auto& parameter: node.templateParams) addValue(children, parameter);
+				begin(children, node, Kind::TEMPLATE_PARAMETER);
+				byte(static_cast<uint8_t>(node.kind));
+				text(node.name);
+				byte(node.isVariadic);
+				varint(node.templateParams.size());
+				end(children);
+			}
+
+			void visit(AnnotationNode& node) override {
+				auto children = enter(node);
+				for (auto& [name, value]: node.arguments) add(children, value);
+				begin(children, node, Kind::ANNOTATION);
+				text(node.name);
+				varint(node.arguments.size());
+				for (const auto& [name, value]: node.arguments) text(name);
+				end(children);
+			}
+
+			void visit(ErrorNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::ERROR);
+				end(children);
+			}
+
+			// A LazyBlockNode materializes in accept() and comes here as a plain block
+			void visit(BlockNode& node) override { block(node, Kind::BLOCK); }
+			void visit(ScopeBlockNode& node) override { block(node, Kind::SCOPE_BLOCK); }
+			void visit(UnsafeNode& node) override { block(node, Kind::UNSAFE); }
+
+			void visit(IfNode& node) override {
+				auto children = enter(node);
+				add(children, node.condition);
+				add(children, node.thenBranch);
+				add(children, node.elseBranch);
+				begin(children, node, Kind::IF);
+				end(children);
+			}
+
+			void visit(WhileNode& node) override {
+				auto children = enter(node);
+				add(children, node.condition);
+				add(children, node.body);
+				begin(children, node, Kind::WHILE);
+				end(children);
+			}
+
+			void visit(DoWhileNode& node) override {
+				auto children = enter(node);
+				add(children, node.condition);
+				add(children, node.body);
+				begin(children, node, Kind::DO_WHILE);
+				end(children);
+			}
+
+			void visit(ForNode& node) override {
+				auto children = enter(node);
+				add(children, node.initializer);
+				add(children, node.condition);
+				add(children, node.increment);
+				add(children, node.body);
+				begin(children, node, Kind::FOR);
+				end(children);
+			}
+
+			void visit(ExprStmtNode& node) override {
+				auto children = enter(node);
+				add(children, node.expr);
+				begin(children, node, Kind::EXPR_STMT);
+				end(children);
+			}
+
+			void visit(EmptyStmtNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::EMPTY_STMT);
+				end(children);
+			}
+
+			void visit(ReturnStmtNode& node) override {
+				auto children = enter(node);
+				add(children, node.value);
+				begin(children, node, Kind::RETURN);
+				end(children);
+			}
+
+			void visit(CompoundStmtNode& node) override {
+				auto children = enter(node);
+				for (auto& statement: node.stmts) add(children, statement);
+				begin(children, node, Kind::COMPOUND);
+				varint(node.stmts.size());
+				end(children);
+			}
+
+			void visit(LiteralNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::LITERAL);
+				byte(node.type);
+				text(node.value);
+				end(children);
+			}
+
+			void visit(VarNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::VAR);
+				text(node.name);
+				end(children);
+			}
+
+			void visit(BinaryOpNode& node) override {
+				auto children = enter(node);
+				add(children, node.left);
+				add(children, node.right);
+				begin(children, node, Kind::BINARY);
+				byte(node.op);
+				end(children);
+			}
+
+			void visit(UnaryOpNode& node) override {
+				auto children = enter(node);
+				add(children, node.right);
+				begin(children, node, Kind::UNARY);
+				byte(static_cast<uint8_t>(node.op));
+				byte(node.prefix);
+				end(children);
+			}
+
+			void visit(CallNode& node) override {
+				auto children = enter(node);
+				add(children, node.callee);
+				for (auto& argument: node.arguments) add(children, argument);
+				begin(children, node, Kind::CALL);
+				varint(node.arguments.size());
+				end(children);
+			}
+
+			void visit(MemberAccessNode& node) override {
+				auto children = enter(node);
+				add(children, node.object);
+				begin(children, node, Kind::MEMBER_ACCESS);
+				text(node.member);
+				end(children);
+			}
+
+			void visit(FreeObjectNode& node) override {
+				auto children = enter(node);
+				for (auto& [name, value]: node.properties) add(children, value);
+				begin(children, node, Kind::FREE_OBJECT);
+				varint(node.properties.size());
+				for (const auto& [name, value]: node.properties) text(name);
+				escape(node.escape);
+				varint(static_cast<uint32_t>(node.shape.initial + 1)); // ShapeInfo::UNKNOWN becomes 0
+				varint(static_cast<uint32_t>(node.shape.final + 1));
+				byte(node.shape.changes);
+				end(children);
+			}
+
+			void visit(ArrayAccessNode& node) override {
+				auto children = enter(node);
+				add(children, node.array);
+				add(children, node.index);
+				begin(children, node, Kind::ARRAY_ACCESS);
+				end(children);
+			}
+
+			void visit(NewExprNode& node) override {
+				auto children = enter(node);
+				for (auto& argument: node.args) add(children, argument);
+				begin(children, node, Kind::NEW);
+				text(node.className);
+				varint(node.args.size());
+				escape(node.escape);
+				end(children);
+			}
+
+			void visit(TemplateStringNode& node) override {
+				auto children = enter(node);
+				for (auto& part: node.parts) add(children, part);
+				begin(children, node, Kind::TEMPLATE_STRING);
+				varint(node.parts.size());
+				end(children);
+			}
+
+			void visit(ThisNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::THIS);
+				end(children);
+			}
+
+			void visit(StructInitializerNode& node) override {
+				auto children = enter(node);
+				for (auto& field: node.fields) add(children, field.value);
+				begin(children, node, Kind::STRUCT_INIT);
+				varint(node.fields.size());
+				for (const auto& field: node.fields) text(field.name);
+				byte(node.isPositional);
+				escape(node.escape);
+				end(children);
+			}
+
+			void visit(LambdaExprNode& node) override {
+				auto children = enter(node);
+				add(children, node.lambda);
+				begin(children, node, Kind::LAMBDA_EXPR);
+				end(children);
+			}
+
+			void visit(TypeNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::TYPE);
+				byte(static_cast<uint8_t>(node.kind));
+				end(children);
+			}
+
+			void visit(PrimitiveTypeNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::PRIMITIVE_TYPE);
+				byte(static_cast<uint8_t>(node.type));
+				end(children);
+			}
+
+			void visit(NamedTypeNode& node) override {
+				auto children = enter(node);
+				begin(children, node, Kind::NAMED_TYPE);
+				text(node.name);
+				end(children);
+			}
+
+			void visit(ArrayTypeNode& node) override {
+				auto children = enter(node);
+				add(children, node.elementType);
+				add(children, node.sizeExpr);
+				begin(children, node, Kind::ARRAY_TYPE);
+				byte(node.size.has_value());
+				if (node.size) varint(*node.size);
+				end(children);
+			}
+
+			void visit(TemplateTypeNode& node) override {
+				auto children = enter(node);
+				for (auto& argument: node.templateArgs) add(children, argument);
+				begin(children, node, Kind::TEMPLATE_TYPE);
+				text(node.baseName);
+				varint(node.templateArgs.size());
+				end(children);
+			}
+
+			void visit(FunctionTypeNode& node) override {
+				auto children = enter(node);
+				for (auto& parameter: node.parameterTypes) add(children, parameter);
+				add(children, node.returnType);
+				begin(children, node, Kind::FUNCTION_TYPE);
+				varint(node.parameterTypes.size());
+				end(children);
+			}
+		};
+
+		// --- Reading ---
+
+		[[noreturn]] void corrupt(const std::string& why) {
+			throw std::runtime_error("Invalid binary AST: " + why);
+		}
+
+		// The bytes of one file, read or mapped, with its string table indexed
+		// Lazy bodies hold on to it, so it lives as long as any node that may still decode from it.
+		class Image {
+			std::string owned;
+			void* mapped = nullptr;
+
+		public:
+			const uint8_t* bytes;
+			size_t size;
+			size_t root = 0, table = 0; // The program's record and where the records end
+			std::vector<std::string_view> strings;
+
+			explicit Image(std::string contents)
+				: owned(std::move(contents)), bytes(reinterpret_cast<const uint8_t*>(owned.data())),
+				  size(owned.size()) {
+				indexStrings();
+			}
+
+			Image(void* mapped, const size_t size)
+				: mapped(mapped), bytes(static_cast<const uint8_t*>(mapped)), size(size) {
+				try {
+					indexStrings();
+				}
+				catch (...) {
+					unmap();
+					throw;
+				}
+			}
+
+			Image(const Image&) = delete;
+			Image& operator=(const Image&) = delete;
+			~Image() { unmap(); }
+
+		private:
+			void unmap() {
+#if !defined(_WIN32)
+				if (mapped) ::munmap(mapped, size);
+#endif
+				mapped = nullptr;
+			}
+
+			[[nodiscard]] uint64_t fixed(const size_t at, const int width) const {
+				uint64_t value = 0;
+				for (int i = width - 1; i >= 0; --i) value = value << 8 | bytes[at + i];
+				return value;
+			}
+
+			void indexStrings();
+		};
+
+		// Reads values from one record, never past the end of the records
+		struct Cursor {
+			const uint8_t* at;
+			const uint8_t* end;
+
+			uint8_t byte() {
+				if (at == end) corrupt("truncated record");
+				return *at++;
+			}
+
+			uint64_t varint() {
+				uint64_t value = 0;
+				for (int shift = 0; shift < 64; shift += 7) {
+					const uint8_t next = byte();
+					value |= static_cast<uint64_t>(next & 0x7f) << shift;
+					if (!(next & 0x80)) return value;
+				}
+				corrupt("varint too long");
+			}
+
+			uint64_t fixed() {
+				uint64_t value = 0;
+				for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(byte()) << 8 * i;
+				return value;
+			}
+		};
+
+		void Image::indexStrings() {
+			if (size < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 4, bytes)) corrupt("not a Zenith AST file");
+			if (const uint64_t version = fixed(4, 4); version != BinaryAST::VERSION) {
+				corrupt("format version " + std::to_string(version) + ", expected " +
+				        std::to_string(BinaryAST::VERSION));
+			}
+			root = fixed(8, 8);
+			table = fixed(16, 8);
+			if (fixed(24, 8) != size) corrupt("truncated file");
+			if (table > size || root < HEADER_SIZE || root >= table) corrupt("bad header");
+
+			Cursor in{bytes + table, bytes + size};
+			const uint64_t count = in.varint();
+			if (count > size) corrupt("bad string table");
+			strings.reserve(count);
+			for (uint64_t i = 0; i < count; ++i) {
+				const uint64_t length = in.varint();
+				if (length > static_cast<uint64_t>(in.end - in.at)) corrupt("bad string table");
+				strings.emplace_back(reinterpret_cast<const char*>(in.at), length);
+				in.at += length;
+			}
+		}
+
+		class Reader {
+			std::shared_ptr<const Image> image;
+
+			struct Record {
+				Kind kind;
+				size_t at;
+				SourceLocation loc;
+				std::optional<ConstantValue> constant;
+				Cursor in;
+			};
+
+			[[nodiscard]] Record record(const size_t at, const SourceLocation& parent) const {
+				if (at < HEADER_SIZE || at >= image->table) corrupt("bad child reference");
+				Record record{Kind::PROGRAM, at, {}, std::nullopt, {image->bytes + at, image->bytes + image->table}};
+				const uint8_t kind = record.in.byte();
+				if (kind > static_cast<uint8_t>(Kind::FUNCTION_TYPE)) corrupt("unknown node kind");
+				record.kind = static_cast<Kind>(kind);
+				record.loc.line = parent.line + static_cast<uint64_t>(unzigzag(record.in.varint()));
+				record.loc.column = record.in.varint();
+				record.loc.length = record.in.varint();
+				record.loc.fileOffset = parent.fileOffset + static_cast<uint64_t>(unzigzag(record.in.varint()));
+				record.loc.file = text(record);
+				if (isExpression(record.kind)) record.constant = constant(record);
+				return record;
+			}
+
+			[[nodiscard]] std::optional<ConstantValue> constant(Record& record) const {
+				const uint8_t kind = record.in.byte();
+				if (kind == 0) return std::nullopt;
+				if (kind > static_cast<uint8_t>(ConstantValue::Kind::STRING) + 1) corrupt("bad constant");
+				ConstantValue value{static_cast<ConstantValue::Kind>(kind - 1), {}};
+				// The alternative follows from the kind, ConstantValue's accessors rely on it
+				const uint8_t alternative = value.isInteger() ? 0 : value.isFloating() ? 1 : value.kind == ConstantValue::Kind::BOOL ? 2 : 3;
+				if (record.in.byte() != alternative) corrupt("bad constant");
+				switch (alternative) {
+					case 0: value.value = unzigzag(record.in.varint()); break;
+					case 1: value.value = std::bit_cast<double>(record.in.fixed()); break;
+					case 2: value.value = record.in.byte() != 0; break;
+					default: value.value = text(record); break;
+				}
+				return value;
+			}
+
+			[[nodiscard]] std::string text(Record& record) const {
+				const uint64_t index = record.in.varint();
+				if (index >= image->strings.size()) corrupt("bad string index");
+				return std::string(image->strings[index]);
+			}
+
+			// A count of things that take at least a byte each
+			[[nodiscard]] size_t count(Record& record) const {
+				const uint64_t count = record.in.varint();
+				if (count > image->size) corrupt("bad count");
+				return count;
+			}
+
+			[[nodiscard]] bool flag(Record& record) const { return record.in.byte() != 0; }
+
+			[[nodiscard]] size_t reference(Record& record) const {
+				const uint64_t distance = record.in.varint();
+				if (distance == 0) return 0;
+				if (distance > record.at - HEADER_SIZE) corrupt("bad child reference");
+				return record.at - distance;
+			}
+
+			template<typename T>
+			[[nodiscard]] polymorphic<T> child(Record& record) const {
+				const size_t at = reference(record);
+				return at ? node<T>(at, record.loc) : nullptr;
+			}
+
+			template<typename T>
+			[[nodiscard]] std::vector<polymorphic<T>> children(Record& record, const size_t count) const {
+				std::vector<polymorphic<T>> children;
+				children.reserve(count);
+				for (size_t i = 0; i < count; ++i) children.push_back(child<T>(record));
+				return children;
+			}
+
+			[[nodiscard]] std::vector<polymorphic<ASTNode>> statements(Record& block) const {
+				return children<ASTNode>(block, count(block));
+			}
+
+			// Function bodies are decoded when something first visits them
+			[[nodiscard]] polymorphic<BlockNode> body(Record& record) const {
+				const size_t at = reference(record);
+				if (!at) return nullptr;
+				Record block = this->record(at, record.loc);
+				if (block.kind != Kind::BLOCK) return node<BlockNode>(at, record.loc);
+				SourceLocation loc = block.loc;
+				return make_node<LazyBlockNode, BlockNode>(std::move(loc), 0,
+					[reader = *this, block = std::move(block)](ErrorReporter*) mutable { return reader.statements(block); });
+			}
+
+			[[nodiscard]] static EscapeInfo escape(Record& record) {
+				EscapeInfo info;
+				const uint8_t verdict = record.in.byte();
+				if (verdict > static_cast<uint8_t>(EscapeInfo::Verdict::SCALAR_REPLACED)) corrupt("bad escape verdict");
+				info.verdict = static_cast<EscapeInfo::Verdict>(verdict);
+				info.causes = record.in.byte();
+				return info;
+			}
+
+			[[nodiscard]] static Member::Flags memberFlags(Record& record) {
+				const uint8_t bits = record.in.byte();
+				if ((bits >> 2 & 7) > static_cast<uint8_t>(Member::Access::PROTECTEDW)) corrupt("bad member access");
+				Member::Flags flags{};
+				flags.kind = static_cast<Member::Kind>(bits & 3);
+				flags.access = static_cast<Member::Access>(bits >> 2 & 7);
+				flags.isConst = bits >> 5 & 1;
+				flags.isStatic = bits >> 6 & 1;
+				return flags;
+			}
+
+			// The fields and children Writer::function and Writer::addFunction wrote
+			void function(Record& record, FunctionDeclNode& node) const {
+				node.name = text(record);
+				const uint8_t flags = record.in.byte();
+				node.isAsync = flags & 1;
+				node.usingStructSugar = flags & 2;
+				const size_t annotations = count(record);
+				const size_t params = count(record);
+				node.params.clear();
+				node.params.reserve(params);
+				for (size_t i = 0; i < params; ++i) node.params.emplace_back(text(record));
+
+				node.annotations.clear();
+				for (size_t i = 0; i < annotations; ++i) node.annotations.emplace_back(child<AnnotationNode>(record));
+				for (auto& param: node.params) {
+					param.type = child<TypeNode>(record);
+					param.defaultValue = child<ExprNode>(record);
+				}
+				node.returnType = child<TypeNode>(record);
+				node.body = body(record);
+			}
+
+			void object(Record& record, ObjectDeclNode& node) const {
+				const uint8_t kind = record.in.byte();
+				if (kind > static_cast<uint8_t>(ObjectDeclNode::Kind::ACTOR)) corrupt("bad object kind");
+				node.kind = static_cast<ObjectDeclNode::Kind>(kind);
+				node.name = text(record);
+				node.base = text(record);
+				node.autoGettersSetters = flag(record);
+				const size_t members = count(record);
+				const size_t operators = count(record);
+				node.members = children<DeclNode>(record, members);
+				node.operators = children<OperatorOverloadNode>(record, operators);
+			}
+
+			[[nodiscard]] TemplateParameter parameter(const size_t at, const SourceLocation& parent) const {
+				Record record = this->record(at, parent);
+				if (record.kind != Kind::TEMPLATE_PARAMETER) corrupt("expected a template parameter");
+				const uint8_t kind = record.in.byte();
+				if (kind > static_cast<uint8_t>(TemplateParameter::Kind::TEMPLATE)) corrupt("bad template parameter");
+				TemplateParameter parameter(text(record));
+				parameter.kind = static_cast<TemplateParameter::Kind>(kind);
+				parameter.loc = record.loc;
+				parameter.isVariadic = flag(record);
+				const size_t nested = count(record);
+				parameter.defaultType = child<TypeNode>(record);
+				parameter.type = child<TypeNode>(record);
+				parameter.defaultValue = child<ExprNode>(record);
+				parameter.templateParams = parameters(record, nested);
+				return parameter;
+			}
+
+			[[nodiscard]] std::vector<TemplateParameter> parameters(Record& record, const size_t count) const {
+				std::vector<TemplateParameter> parameters;
+				parameters.reserve(count);
+				for (size_t i = 0; i < count; ++i) {
+					const size_t at = reference(record);
+					if (!at) corrupt("missing template parameter");
+					parameters.push_back(parameter(at, record.loc));
+				}
+				return parameters;
+			}
+
+			template<typename T>
+			[[nodiscard]] static polymorphic<ASTNode> expression(Record& record, polymorphic<T> node) {
+				node->constantValue = std::move(record.constant);
+				return node;
+			}
+
+			[[nodiscard]] polymorphic<ASTNode> decode(Record& r) const {
+				SourceLocation& loc = r.loc;
+				switch (r.kind) {
+					case Kind::PROGRAM: {
+						auto declarations = children<ASTNode>(r, count(r));
+						return make_node<ProgramNode>(loc, std::move(declarations));
+					}
+					case Kind::IMPORT: {
+						std::string path = text(r);
+						return make_node<ImportNode>(loc, std::move(path), flag(r));
+					}
+					case Kind::VAR_DECL: {
+						const uint8_t kind = r.in.byte();
+						if (kind > VarDeclNode::CLASS_INIT) corrupt("bad variable kind");
+						std::string name = text(r);
+						const uint8_t flags = r.in.byte();
+						auto type = child<TypeNode>(r);
+						auto initializer = child<ExprNode>(r);
+						return make_node<VarDeclNode>(loc, static_cast<VarDeclNode::Kind>(kind), std::move(name),
+						                                     std::move(type), std::move(initializer), (flags & 1) != 0,
+						                                     (flags & 2) != 0);
+					}
+					case Kind::MULTI_VAR_DECL: {
+						auto vars = children<VarDeclNode>(r, count(r));
+						return make_node<MultiVarDeclNode>(loc, std::move(vars));
+					}
+					case Kind::FUNCTION: {
+						auto node = make_node<FunctionDeclNode>(loc, std::string(), std::vector<FunctionDeclNode::Param>(),
+						                                               nullptr, nullptr);
+						function(r, *node);
+						return node;
+					}
+					case Kind::LAMBDA: {
+						auto node = make_node<LambdaNode>(loc, std::vector<FunctionDeclNode::Param>(), false);
+						function(r, *node);
+						return node;
+					}
+					case Kind::FIELD: {
+						const auto flags = memberFlags(r);
+						std::string name = text(r);
+						auto annotations = children<AnnotationNode>(r, count(r));
+						auto type = child<TypeNode>(r);
+						auto initializer = child<ExprNode>(r);
+						auto node = make_node<FieldDeclNode>(loc, flags.access, flags.isConst, flags.isStatic,
+						                                            std::move(name), std::move(type),
+						                                            std::move(initializer), std::move(annotations));
+						node->flags = flags;
+						return node;
+					}
+					case Kind::METHOD:
+					case Kind::MESSAGE_HANDLER: {
+						const auto flags = memberFlags(r);
+						std::string name = text(r);
+						polymorphic<MethodDeclNode> node;
+						if (r.kind == Kind::METHOD) {
+							node = make_node<MethodDeclNode>(loc, flags.access, flags.isConst, std::move(name),
+							                                        std::vector<FunctionDeclNode::Param>(), nullptr,
+							                                        nullptr);
+						}
+						else {
+							node = make_node<MessageHandlerNode>(loc, flags.access, flags.isConst, std::move(name),
+							                                            std::vector<FunctionDeclNode::Param>(), nullptr,
+							                                            nullptr);
+						}
+						node->flags = flags;
+						function(r, *node);
+						return node;
+					}
+					case Kind::CONSTRUCTOR: {
+						const auto flags = memberFlags(r);
+						std::string name = text(r);
+						std::vector<std::string> initialized(count(r));
+						for (auto& member: initialized) member = text(r);
+						auto node = make_node<CtorDeclNode>(loc, flags.access, flags.isConst, flags.isStatic,
+						                                           std::move(name), std::vector<FunctionDeclNode::Param>(),
+						                                           nullptr);
+						node->flags = flags;
+						function(r, *node);
+						for (auto& member: initialized) node->initializers.emplace_back(std::move(member), child<ExprNode>(r));
+						return node;
+					}
+					case Kind::OPERATOR: {
+						std::string op = text(r);
+						std::vector<std::pair<std::string, polymorphic<TypeNode>>> params(count(r));
+						for (auto& [name, type]: params) name = text(r);
+						for (auto& [name, type]: params) type = child<TypeNode>(r);
+						auto returnType = child<TypeNode>(r);
+						auto body = this->body(r);
+						return make_node<OperatorOverloadNode>(loc, std::move(op), std::move(params),
+						                                              std::move(returnType), std::move(body));
+					}
+					case Kind::OBJECT:
+					case Kind::ACTOR: {
+						polymorphic<ObjectDeclNode> node;
+						if (r.kind == Kind::OBJECT) {
+							node = make_node<ObjectDeclNode>(loc, ObjectDeclNode::Kind::CLASS, std::string(),
+							                                        std::string(),
+							                                        std::vector<polymorphic<DeclNode>>());
+						}
+						else {
+							node = make_node<ActorDeclNode>(loc, std::string(),
+							                                       std::vector<polymorphic<DeclNode>>());
+						}
+						object(r, *node);
+						return node;
+					}
+					case Kind::UNION: {
+						std::string name = text(r);
+						auto types = children<TypeNode>(r, count(r));
+						return make_node<UnionDeclNode>(loc, std::move(name), std::move(types));
+					}
+					case Kind::TEMPLATE: {
+						auto parameters = this->parameters(r, count(r));
+						auto declaration = child<ASTNode>(r);
+						return make_node<TemplateDeclNode>(loc, std::move(parameters), declaration);
+					}
+					case Kind::ANNOTATION: {
+						std::string name = text(r);
+						std::vector<std::pair<std::string, polymorphic<ExprNode>>> arguments(count(r));
+						for (auto& [argument, value]: arguments) argument = text(r);
+						for (auto& [argument, value]: arguments) value = child<ExprNode>(r);
+						return make_node<AnnotationNode>(loc, std::move(name), std::move(arguments));
+					}
+					case Kind::ERROR:
+						return make_node<ErrorNode>(loc);
+					case Kind::BLOCK:
+						return make_node<BlockNode>(loc, statements(r));
+					case Kind::SCOPE_BLOCK:
+						return make_node<ScopeBlockNode>(loc, statements(r));
+					case Kind::UNSAFE:
+						return make_node<UnsafeNode>(loc, statements(r));
+					case Kind::IF: {
+						auto condition = child<ExprNode>(r);
+						auto thenBranch = child<ASTNode>(r);
+						auto elseBranch = child<ASTNode>(r);
+						return make_node<IfNode>(loc, std::move(condition), std::move(thenBranch),
+						                                std::move(elseBranch));
+					}
+					case Kind::WHILE:
+					case Kind::DO_WHILE: {
+						auto condition = child<ExprNode>(r);
+						auto body = child<ASTNode>(r);
+						if (r.kind == Kind::WHILE) return make_node<WhileNode>(loc, std::move(condition), std::move(body));
+						return make_node<DoWhileNode>(loc, std::move(condition), std::move(body));
+					}
+					case Kind::FOR: {
+						auto initializer = child<StmtNode>(r);
+						auto condition = child<ExprNode>(r);
+						auto increment = child<ExprNode>(r);
+						auto body = child<ASTNode>(r);
+						return make_node<ForNode>(loc, std::move(initializer), std::move(condition),
+						                                 std::move(increment), std::move(body));
+					}
+					case Kind::EXPR_STMT:
+						return make_node<ExprStmtNode>(loc, child<ExprNode>(r));
+					case Kind::EMPTY_STMT:
+						return make_node<EmptyStmtNode>(loc);
+					case Kind::RETURN:
+						return make_node<ReturnStmtNode>(loc, child<ExprNode>(r));
+					case Kind::COMPOUND: {
+						auto statements = children<StmtNode>(r, count(r));
+						return make_node<CompoundStmtNode>(loc, std::move(statements));
+					}
+					case Kind::LITERAL: {
+						const uint8_t type = r.in.byte();
+						if (type > LiteralNode::NIL) corrupt("bad literal type");
+						return expression(r, make_node<LiteralNode>(loc, static_cast<LiteralNode::Type>(type), text(r)));
+					}
+					case Kind::VAR:
+						return expression(r, make_node<VarNode>(loc, text(r)));
+					case Kind::BINARY: {
+						const uint8_t op = r.in.byte();
+						if (op > BinaryOpNode::MOD_ASN) corrupt("bad binary operator");
+						auto left = child<ExprNode>(r);
+						auto right = child<ExprNode>(r);
+						return expression(r, make_node<BinaryOpNode>(loc, static_cast<BinaryOpNode::Op>(op),
+						                                                    std::move(left), std::move(right)));
+					}
+					case Kind::UNARY: {
+						const uint8_t op = r.in.byte();
+						if (op > static_cast<uint8_t>(UnaryOpNode::Op::NOT)) corrupt("bad unary operator");
+						const bool prefix = flag(r);
+						auto right = child<ExprNode>(r);
+						return expression(r, make_node<UnaryOpNode>(loc, static_cast<UnaryOpNode::Op>(op),
+						                                                   std::move(right), prefix));
+					}
+					case Kind::CALL: {
+						const size_t arguments = count(r);
+						auto callee = child<ExprNode>(r);
+						small_vector<polymorphic<ExprNode>, 4> args;
+						args.reserve(arguments);
+						for (size_t i = 0; i < arguments; ++i) args.push_back(child<ExprNode>(r));
+						return expression(r, make_node<CallNode>(loc, std::move(callee), std::move(args)));
+					}
+					case Kind::MEMBER_ACCESS: {
+						std::string member = text(r);
+						auto object = child<ExprNode>(r);
+						return expression(r, make_node<MemberAccessNode>(loc, std::move(object), std::move(member)));
+					}
+					case Kind::FREE_OBJECT: {
+						const size_t count = this->count(r);
+						small_vector<std::pair<std::string, polymorphic<ExprNode>>, 4> properties;
+						properties.reserve(count);
+						for (size_t i = 0; i < count; ++i) properties.emplace_back(text(r), nullptr);
+						const EscapeInfo escapeInfo = escape(r);
+						ShapeInfo shape;
+						shape.initial = static_cast<uint32_t>(r.in.varint() - 1);
+						shape.final = static_cast<uint32_t>(r.in.varint() - 1);
+						shape.changes = r.in.byte();
+						for (auto& [name, value]: properties) value = child<ExprNode>(r);
+						auto node = make_node<FreeObjectNode>(loc, std::move(properties));
+						node->escape = escapeInfo;
+						node->shape = shape;
+						return expression(r, std::move(node));
+					}
+					case Kind::ARRAY_ACCESS: {
+						auto array = child<ExprNode>(r);
+						auto index = child<ExprNode>(r);
+						return expression(r, make_node<ArrayAccessNode>(loc, std::move(array), std::move(index)));
+					}
+					case Kind::NEW: {
+						std::string className = text(r);
+						const size_t count = this->count(r);
+						const EscapeInfo escapeInfo = escape(r);
+						small_vector<polymorphic<ExprNode>, 4> args;
+						args.reserve(count);
+						for (size_t i = 0; i < count; ++i) args.push_back(child<ExprNode>(r));
+						auto node = make_node<NewExprNode>(loc, std::move(className), std::move(args));
+						node->escape = escapeInfo;
+						return expression(r, std::move(node));
+					}
+					case Kind::TEMPLATE_STRING: {
+						const size_t count = this->count(r);
+						small_vector<polymorphic<ExprNode>, 4> parts;
+						parts.reserve(count);
+						for (size_t i = 0; i < count; ++i) parts.push_back(child<ExprNode>(r));
+						return expression(r, make_node<TemplateStringNode>(loc, std::move(parts)));
+					}
+					case Kind::THIS:
+						return expression(r, make_node<ThisNode>(loc));
+					case Kind::STRUCT_INIT: {
+						std::vector<StructInitializerNode::StructFieldInitializer> fields(count(r));
+						for (auto& field: fields) field.name = text(r);
+						const bool positional = flag(r);
+						const EscapeInfo escapeInfo = escape(r);
+						for (auto& field: fields) field.value = child<ExprNode>(r);
+						auto node = make_node<StructInitializerNode>(loc, std::move(fields));
+						node->isPositional = positional;
+						node->escape = escapeInfo;
+						return expression(r, std::move(node));
+					}
+					case Kind::LAMBDA_EXPR:
+						return expression(r, make_node<LambdaExprNode>(loc, child<LambdaNode>(r)));
+					case Kind::TYPE: {
+						const uint8_t kind = r.in.byte();
+						if (kind > static_cast<uint8_t>(TypeNode::Kind::ERROR)) corrupt("bad type kind");
+						return make_node<TypeNode>(loc, static_cast<TypeNode::Kind>(kind));
+					}
+					case Kind::PRIMITIVE_TYPE: {
+						const uint8_t type = r.in.byte();
+						if (type > static_cast<uint8_t>(PrimitiveTypeNode::Type::NIL)) corrupt("bad primitive type");
+						return make_node<PrimitiveTypeNode>(loc, static_cast<PrimitiveTypeNode::Type>(type));
+					}
+					case Kind::NAMED_TYPE:
+						return make_node<NamedTypeNode>(loc, text(r));
+					case Kind::ARRAY_TYPE: {
+						std::optional<uint64_t> size;
+						if (flag(r)) size = r.in.varint();
+						auto elementType = child<TypeNode>(r);
+						auto sizeExpr = child<ExprNode>(r);
+						auto node = make_node<ArrayTypeNode>(loc, std::move(elementType), std::move(sizeExpr));
+						node->size = size;
+						return node;
+					}
+					case Kind::TEMPLATE_TYPE: {
+						std::string baseName = text(r);
+						const size_t count = this->count(r);
+						std::vector<polymorphic_variant<TypeNode>> args;
+						args.reserve(count);
+						for (size_t i = 0; i < count; ++i) args.emplace_back(child<TypeNode>(r));
+						return make_node<TemplateTypeNode>(loc, std::move(baseName), std::move(args));
+					}
+					case Kind::FUNCTION_TYPE: {
+						const size_t count = this->count(r);
+						std::vector<polymorphic_variant<TypeNode>> params;
+						params.reserve(count);
+						for (size_t i = 0; i < count; ++i) params.emplace_back(child<TypeNode>(r));
+						auto returnType = child<TypeNode>(r);
+						return make_node<FunctionTypeNode>(loc, std::move(params), std::move(returnType));
+					}
+					case Kind::TEMPLATE_PARAMETER:
+						break;
+				}
+				corrupt("unexpected template parameter");
+			}
+
+		public:
+			explicit Reader(std::shared_ptr<const Image> image) : image(std::move(image)) {}
+
+			template<typename T>
+			[[nodiscard]] polymorphic<T> node(const size_t at, const SourceLocation& parent) const {
+				Record record = this->record(at, parent);
+				polymorphic<ASTNode> node = decode(record);
+				auto typed = node.cast().non_throwing().template to<T>();
+				if (!typed) corrupt("unexpected node kind");
+				return typed;
+			}
+
+			[[nodiscard]] polymorphic<ProgramNode> program() const { return node<ProgramNode>(image->root, ROOT); }
+		};
+	}
+
+	std::string BinaryAST::write(ProgramNode& program) {
+		return Writer().finish(program);
+	}
+
+	void BinaryAST::write(ProgramNode& program, const std::string& path) {
+		const std::string bytes = write(program);
+		std::ofstream file(path, std::ios::binary);
+		if (!file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+			throw std::runtime_error("Failed to write file: " + path);
+		}
+	}
+
+	polymorphic<ProgramNode> BinaryAST::read(std::string bytes) {
+		return Reader(std::make_shared<const Image>(std::move(bytes))).program();
+	}
+
+	polymorphic<ProgramNode> BinaryAST::load(const std::string& path) {
+#if defined(_WIN32)
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) throw std::runtime_error("Failed to open file: " + path);
+		return read(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+#else
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::runtime_error("Failed to open file: " + path);
+		struct stat info{};
+		const bool sized = ::fstat(fd, &info) == 0;
+		const auto size = static_cast<size_t>(info.st_size);
+		if (!sized || size < HEADER_SIZE) {
+			::close(fd);
+			corrupt("not a Zenith AST file");
+		}
+		void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapped == MAP_FAILED) throw std::runtime_error("Failed to map file: " + path);
+		return Reader(std::make_shared<const Image>(mapped, size)).program();
+#endif
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "../ast/AST.hpp"
+
+namespace zenith {
+	// Versioned binary form of an AST, so a parsed module can be kept on disk and loaded instead of parsed again
+	//
+	//   header   "ZAST", u32 version, u64 root record, u64 string table, u64 file size (little endian)
+	//   records  one per node, children before their parent:
+	//              u8 kind, location, [constant value for expressions], fields, child references
+	//   strings  varint count, then varint length + bytes for each; every name, literal and file name is stored once
+	//
+	// Numbers are LEB128 varints. A location is stored relative to the parent's (line and offset as zigzag deltas,
+	// column, length and a string index for the file). A child reference is the distance back from the parent's
+	// record to the child's, 0 for none, so any record can be decoded on its own.
+	class BinaryAST {
+	public:
+		static constexpr uint32_t VERSION = 1;
+
+		// Function bodies are written materialized, lazily parsed ones included
+		[[nodiscard]] static std::string write(ProgramNode& program);
+		static void write(ProgramNode& program, const std::string& path);
+
+		// Top-level declarations are decoded right away, function bodies are LazyBlockNodes that decode their
+		// statements when first visited. Throws std::runtime_error for anything that is not a complete file of this
+		// version.
+		[[nodiscard]] static polymorphic<ProgramNode> read(std::string bytes);
+		// Maps the file instead of reading it, bodies that are never visited are never paged in
+		[[nodiscard]] static polymorphic<ProgramNode> load(const std::string& path);
+	};
+}
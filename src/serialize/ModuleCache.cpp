@@ -0,0 +1,53 @@
+#include "ModuleCache.hpp"
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include "utils/Hash.hpp"
+#include "utils/TimeTrace.hpp"
+
+namespace zenith {
+	ModuleCache::ModuleCache(std::filesystem::path directory) : directory(std::move(directory)) {}
+
+	std::filesystem::path ModuleCache::entry(const std::string_view source, const std::string& file,
+	                                         const Flags& flags) const {
+		Hash hash;
+		hash << BinaryAST::VERSION << file.size() << file << static_cast<uint64_t>(flags.bracesRequired) << source;
+		char name[48];
+		std::snprintf(name, sizeof name, "%016llx-%zx.zast", static_cast<unsigned long long>(hash.value),
+		              source.size());
+		return directory / name;
+	}
+
+	polymorphic<ProgramNode> ModuleCache::load(const std::string_view source, const std::string& file,
+	                                           const Flags& flags) const {
+		TimeTrace::Scope trace("Load AST cache", "io");
+		const auto path = entry(source, file, flags);
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(path, error)) return nullptr;
+		if (trace) trace.counter("bytes", static_cast<int64_t>(std::filesystem::file_size(path, error)));
+		try {
+			return BinaryAST::load(path.string());
+		}
+		catch (const std::runtime_error&) {
+			return nullptr;
+		}
+	}
+
+	void ModuleCache::store(const std::string_view source, const std::string& file, const Flags& flags,
+	                        ProgramNode& program) const {
+		TimeTrace::Scope trace("Store AST cache", "io");
+		const auto path = entry(source, file, flags);
+		std::filesystem::create_directories(directory);
+		// Written next to the entry and renamed into place, so a concurrent load never sees half a file
+		auto temporary = path;
+		temporary += ".tmp" + std::to_string(std::random_device()());
+		BinaryAST::write(program, temporary.string());
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		if (error) {
+			std::filesystem::remove(temporary, error);
+			throw std::runtime_error("Failed to store " + path.string());
+		}
+	}
+}
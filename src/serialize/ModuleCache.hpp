@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "BinaryAST.hpp"
+#include "../utils/mainargs.hpp"
+
+namespace zenith {
+	// Parsed modules kept across compiler invocations (--ast-cache=<dir>)
+	// Entries are BinaryAST files named after a hash of everything the parse depends on: the source text, the file
+	// name the locations carry, the flags the parser reads and the format version. An entry is never updated, a
+	// changed source is a different entry.
+	class ModuleCache {
+		std::filesystem::path directory;
+
+	public:
+		explicit ModuleCache(std::filesystem::path directory);
+
+		[[nodiscard]] std::filesystem::path entry(std::string_view source, const std::string& file,
+		                                          const Flags& flags) const;
+		// Null when there is no usable entry, a damaged or outdated one counts as missing
+		[[nodiscard]] polymorphic<ProgramNode> load(std::string_view source, const std::string& file,
+		                                            const Flags& flags) const;
+		// Only store programs that parsed without diagnostics, a hit does not report them again
+		void store(std::string_view source, const std::string& file, const Flags& flags, ProgramNode& program) const;
+	};
+}
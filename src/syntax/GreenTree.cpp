@@ -0,0 +1,160 @@
+#include "GreenTree.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace zenith {
+	const char* toString(const SyntaxKind kind) {
+		switch (kind) {
+			case SyntaxKind::TOKEN: return "TOKEN";
+			case SyntaxKind::WHITESPACE: return "WHITESPACE";
+			case SyntaxKind::COMMENT: return "COMMENT";
+			case SyntaxKind::SOURCE_FILE: return "SOURCE_FILE";
+			case SyntaxKind::IMPORT: return "IMPORT";
+			case SyntaxKind::TEMPLATE: return "TEMPLATE";
+			case SyntaxKind::TEMPLATE_PARAMS: return "TEMPLATE_PARAMS";
+			case SyntaxKind::OBJECT: return "OBJECT";
+			case SyntaxKind::UNION: return "UNION";
+			case SyntaxKind::ACTOR: return "ACTOR";
+			case SyntaxKind::FUNCTION: return "FUNCTION";
+			case SyntaxKind::PARAM_LIST: return "PARAM_LIST";
+			case SyntaxKind::MEMBER: return "MEMBER";
+			case SyntaxKind::FIELD: return "FIELD";
+			case SyntaxKind::CONSTRUCTOR: return "CONSTRUCTOR";
+			case SyntaxKind::MESSAGE_HANDLER: return "MESSAGE_HANDLER";
+			case SyntaxKind::ANNOTATION: return "ANNOTATION";
+			case SyntaxKind::VAR_DECL: return "VAR_DECL";
+			case SyntaxKind::TYPE: return "TYPE";
+			case SyntaxKind::BLOCK: return "BLOCK";
+			case SyntaxKind::UNSAFE_BLOCK: return "UNSAFE_BLOCK";
+			case SyntaxKind::SCOPE_BLOCK: return "SCOPE_BLOCK";
+			case SyntaxKind::IF: return "IF";
+			case SyntaxKind::FOR: return "FOR";
+			case SyntaxKind::WHILE: return "WHILE";
+			case SyntaxKind::DO_WHILE: return "DO_WHILE";
+			case SyntaxKind::RETURN: return "RETURN";
+			case SyntaxKind::EXPR_STMT: return "EXPR_STMT";
+			case SyntaxKind::LITERAL: return "LITERAL";
+			case SyntaxKind::NAME: return "NAME";
+			case SyntaxKind::PAREN: return "PAREN";
+			case SyntaxKind::BINARY: return "BINARY";
+			case SyntaxKind::UNARY: return "UNARY";
+			case SyntaxKind::CALL: return "CALL";
+			case SyntaxKind::ARG_LIST: return "ARG_LIST";
+			case SyntaxKind::MEMBER_ACCESS: return "MEMBER_ACCESS";
+			case SyntaxKind::INDEX: return "INDEX";
+			case SyntaxKind::NEW: return "NEW";
+			case SyntaxKind::LAMBDA: return "LAMBDA";
+			case SyntaxKind::ARROW_PARAMS: return "ARROW_PARAMS";
+			case SyntaxKind::FREE_OBJECT: return "FREE_OBJECT";
+			case SyntaxKind::STRUCT_INIT: return "STRUCT_INIT";
+			case SyntaxKind::ERROR: return "ERROR";
+		}
+		return "UNKNOWN";
+	}
+
+	void GreenNode::write(std::string& out) const {
+		for (const GreenElement child: children()) {
+			if (const GreenToken* token = child.token()) out += token->text();
+			else child.node()->write(out);
+		}
+	}
+
+	const GreenToken* GreenArena::token(const SyntaxKind kind, const TokenType type, const std::string_view text) {
+		const size_t hash = std::hash<std::string_view>{}(text) ^ (static_cast<size_t>(kind) << 48 | static_cast<size_t>(type) << 32);
+		for (auto [it, end] = tokenTable.equal_range(hash); it != end; ++it) {
+			const GreenToken* existing = it->second;
+			if (existing->kind == kind && existing->type == type && existing->text() == text) return existing;
+		}
+
+		auto* token = new(memory.allocate(sizeof(GreenToken) + text.size())) GreenToken{
+			kind, type, static_cast<uint32_t>(text.size())
+		};
+		std::memcpy(token + 1, text.data(), text.size());
+		tokenTable.emplace(hash, token);
+		return token;
+	}
+
+	const GreenNode* GreenArena::node(const SyntaxKind kind, const std::span<const GreenElement> children) {
+		size_t hash = static_cast<size_t>(kind);
+		for (const GreenElement child: children) hash = hash * 31 + std::hash<uintptr_t>{}(child.raw());
+		for (auto [it, end] = nodeTable.equal_range(hash); it != end; ++it) {
+			const GreenNode* existing = it->second;
+			if (existing->kind == kind && std::ranges::equal(existing->children(), children)) return existing;
+		}
+
+		uint32_t length = 0;
+		for (const GreenElement child: children) length += child.length();
+		auto* node = new(memory.allocate(sizeof(GreenNode) + children.size() * sizeof(GreenElement))) GreenNode{
+			kind, static_cast<uint32_t>(children.size()), length
+		};
+		std::uninitialized_copy(children.begin(), children.end(), const_cast<GreenElement*>(node->children().data()));
+		nodeTable.emplace(hash, node);
+		return node;
+	}
+
+	const GreenNode* GreenArena::replaceChild(const GreenNode* node, const size_t index, const GreenElement child) {
+		std::vector<GreenElement> children(node->children().begin(), node->children().end());
+		children[index] = child;
+		return this->node(node->kind, children);
+	}
+
+	void SyntaxBuilder::trivia(const size_t until) {
+		while (cursor < until) {
+			const size_t begin = cursor;
+			SyntaxKind kind = SyntaxKind::WHITESPACE;
+			if (source.substr(cursor, 2) == "//") {
+				kind = SyntaxKind::COMMENT;
+				cursor = std::min(source.find('\n', cursor), until);
+			}
+			else if (source.substr(cursor, 2) == "/*") {
+				kind = SyntaxKind::COMMENT;
+				const size_t close = source.find("*/", cursor + 2);
+				cursor = close == std::string_view::npos ? until : std::min(close + 2, until);
+			}
+			else {
+				// Anything up to the next comment, the lexer only skips whitespace in between
+				while (cursor < until && source.substr(cursor, 2) != "//" && source.substr(cursor, 2) != "/*") ++cursor;
+			}
+			children.emplace_back(arena.token(kind, TokenType::EOF_TOKEN, source.substr(begin, cursor - begin)));
+		}
+	}
+
+	SyntaxBuilder::Checkpoint SyntaxBuilder::checkpoint(const size_t nextToken) {
+		trivia(std::min(nextToken, source.size()));
+		return children.size();
+	}
+
+	void SyntaxBuilder::startNode(const SyntaxKind kind, const size_t nextToken) {
+		open.push_back({kind, checkpoint(nextToken)});
+	}
+
+	void SyntaxBuilder::startNodeAt(const Checkpoint at, const SyntaxKind kind) {
+		open.push_back({kind, at});
+	}
+
+	void SyntaxBuilder::finishNode() {
+		const OpenNode node = open.back();
+		open.pop_back();
+		if (node.firstChild == children.size()) return; // Consumed nothing, only happens around syntax errors
+		const GreenNode* green = arena.node(node.kind, std::span(children).subspan(node.firstChild));
+		children.erase(children.begin() + static_cast<ptrdiff_t>(node.firstChild), children.end());
+		children.emplace_back(green);
+	}
+
+	void SyntaxBuilder::token(const Token& token) {
+		if (token.type == TokenType::EOF_TOKEN) return;
+		trivia(token.loc.fileOffset);
+		children.emplace_back(arena.token(SyntaxKind::TOKEN, token.type, token.lexeme));
+		cursor = token.loc.fileOffset + token.lexeme.size();
+	}
+
+	const GreenNode* SyntaxBuilder::finish(const SyntaxKind rootKind) {
+		trivia(source.size());
+		while (!open.empty()) finishNode();
+		const GreenNode* root = arena.node(rootKind, children);
+		children.clear();
+		return root;
+	}
+}
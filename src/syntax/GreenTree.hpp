@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../lexer/lexer.hpp"
+#include "../utils/Arena.hpp"
+
+namespace zenith {
+	enum class SyntaxKind : uint16_t {
+		// Tokens
+		TOKEN,      // A lexer token, GreenToken::type says which
+		WHITESPACE, // Trivia: everything the lexer skips
+		COMMENT,
+
+		// Declarations
+		SOURCE_FILE, IMPORT, TEMPLATE, TEMPLATE_PARAMS, OBJECT, UNION, ACTOR, FUNCTION, PARAM_LIST, MEMBER, FIELD,
+		CONSTRUCTOR, MESSAGE_HANDLER, ANNOTATION, VAR_DECL, TYPE,
+
+		// Statements
+		BLOCK, UNSAFE_BLOCK, SCOPE_BLOCK, IF, FOR, WHILE, DO_WHILE, RETURN, EXPR_STMT,
+
+		// Expressions
+		LITERAL, NAME, PAREN, BINARY, UNARY, CALL, ARG_LIST, MEMBER_ACCESS, INDEX, NEW, LAMBDA, ARROW_PARAMS,
+		FREE_OBJECT, STRUCT_INIT,
+
+		ERROR // Tokens skipped by error recovery
+	};
+
+	const char* toString(SyntaxKind kind);
+
+	// Green tree: the immutable, position-independent half of the lossless syntax tree
+	// Nodes and tokens only know their kind, their children and their text length, never where they are. That makes
+	// them shareable: the arena hands out one instance per distinct subtree, so every '(' token and every 'return x'
+	// node exists once, and an edit allocates only the spine from the changed element up to a new root.
+	struct GreenToken {
+		SyntaxKind kind;
+		TokenType type; // Meaningful for SyntaxKind::TOKEN only
+		uint32_t length;
+
+		// The text is stored right behind the header
+		[[nodiscard]] std::string_view text() const { return {reinterpret_cast<const char*>(this + 1), length}; }
+		[[nodiscard]] bool isTrivia() const { return kind != SyntaxKind::TOKEN; }
+	};
+
+	struct GreenNode;
+
+	// A child of a green node, either a node or a token, in one tagged pointer
+	class GreenElement {
+		uintptr_t bits;
+
+	public:
+		GreenElement(const GreenNode* node) : bits(reinterpret_cast<uintptr_t>(node)) {}
+		GreenElement(const GreenToken* token) : bits(reinterpret_cast<uintptr_t>(token) | 1) {}
+
+		[[nodiscard]] bool isToken() const { return bits & 1; }
+		[[nodiscard]] const GreenNode* node() const { return isToken() ? nullptr : reinterpret_cast<const GreenNode*>(bits); }
+		[[nodiscard]] const GreenToken* token() const {
+			return isToken() ? reinterpret_cast<const GreenToken*>(bits & ~uintptr_t{1}) : nullptr;
+		}
+		[[nodiscard]] uint32_t length() const;
+		[[nodiscard]] uintptr_t raw() const { return bits; }
+		bool operator==(const GreenElement&) const = default;
+	};
+
+	struct alignas(uintptr_t) GreenNode { // Keeps the trailing children aligned
+		SyntaxKind kind;
+		uint32_t childCount;
+		uint32_t length; // Text length of the whole subtree, trivia included
+
+		// The children are stored right behind the header
+		[[nodiscard]] std::span<const GreenElement> children() const {
+			return {reinterpret_cast<const GreenElement*>(this + 1), childCount};
+		}
+		void write(std::string& out) const;
+	};
+
+	inline uint32_t GreenElement::length() const { return isToken() ? token()->length : node()->length; }
+
+	// Owns and deduplicates green nodes and tokens
+	// Everything lives until the arena does, trees and their edited versions share one arena. Not thread-safe.
+	class GreenArena {
+		Arena memory;
+
+		// Keyed by content hash, collisions are resolved by comparing contents
+		std::unordered_multimap<size_t, const GreenToken*> tokenTable;
+		std::unordered_multimap<size_t, const GreenNode*> nodeTable;
+
+
+	public:
+		const GreenToken* token(SyntaxKind kind, TokenType type, std::string_view text);
+		const GreenNode* node(SyntaxKind kind, std::span<const GreenElement> children);
+		// Same node with children[index] replaced
+		const GreenNode* replaceChild(const GreenNode* node, size_t index, GreenElement child);
+
+		[[nodiscard]] size_t bytes() const { return memory.bytes(); }
+		[[nodiscard]] size_t tokenCount() const { return tokenTable.size(); }
+		[[nodiscard]] size_t nodeCount() const { return nodeTable.size(); }
+	};
+
+	// Builds a green tree from a stream of tokens and node boundaries, fed by the parser as it goes
+	// Trivia is not in the token stream, it is recovered from the gaps between token offsets in the source.
+	// Left-recursive constructs (binary operators, calls, member accesses) are opened late with startNodeAt(),
+	// wrapping the children emitted since a checkpoint taken before their first operand.
+	class SyntaxBuilder {
+		struct OpenNode {
+			SyntaxKind kind;
+			size_t firstChild;
+		};
+
+		GreenArena& arena;
+		std::string_view source;
+		size_t cursor = 0; // Source offset up to which everything has been emitted
+		std::vector<GreenElement> children;
+		std::vector<OpenNode> open;
+
+		void trivia(size_t until);
+
+	public:
+		using Checkpoint = size_t;
+
+		SyntaxBuilder(GreenArena& arena, std::string_view source) : arena(arena), source(source) {}
+
+		// nextToken is where the first token of what follows starts, trivia before it stays outside the node
+		Checkpoint checkpoint(size_t nextToken);
+		void startNode(SyntaxKind kind, size_t nextToken);
+		void startNodeAt(Checkpoint at, SyntaxKind kind);
+		void finishNode();
+		void token(const Token& token);
+		// Closes every open node after emitting trailing trivia, returns the root
+		const GreenNode* finish(SyntaxKind rootKind);
+	};
+}
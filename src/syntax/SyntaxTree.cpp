@@ -0,0 +1,192 @@
+#include "SyntaxTree.hpp"
+#include "../parser/parser.hpp"
+
+namespace zenith {
+	std::optional<SyntaxNode> SyntaxNode::parent() const {
+		if (!data->parent) return std::nullopt;
+		return SyntaxNode(data->parent);
+	}
+
+	std::vector<SyntaxNode::Element> SyntaxNode::children() const {
+		std::vector<Element> result;
+		result.reserve(data->green->childCount);
+		uint32_t offset = data->offset;
+		uint32_t index = 0;
+		for (const GreenElement child: data->green->children()) {
+			if (const GreenToken* token = child.token()) result.emplace_back(SyntaxToken(data, token, offset, index));
+			else result.emplace_back(SyntaxNode(std::make_shared<const Data>(Data{child.node(), data, offset, index})));
+			offset += child.length();
+			++index;
+		}
+		return result;
+	}
+
+	std::vector<SyntaxNode> SyntaxNode::childNodes() const {
+		std::vector<SyntaxNode> result;
+		uint32_t offset = data->offset;
+		uint32_t index = 0;
+		for (const GreenElement child: data->green->children()) {
+			if (const GreenNode* node = child.node()) {
+				result.push_back(SyntaxNode(std::make_shared<const Data>(Data{node, data, offset, index})));
+			}
+			offset += child.length();
+			++index;
+		}
+		return result;
+	}
+
+	SyntaxNode SyntaxNode::coveringNode(const uint32_t begin, const uint32_t end) const {
+		SyntaxNode node = *this;
+		for (bool descended = true; descended;) {
+			descended = false;
+			for (SyntaxNode& child: node.childNodes()) {
+				if (child.offset() <= begin && end <= child.end() && child.green()->length > 0) {
+					node = std::move(child);
+					descended = true;
+					break;
+				}
+			}
+		}
+		return node;
+	}
+
+	std::optional<SyntaxToken> SyntaxNode::tokenAt(const uint32_t offset) const {
+		if (offset < this->offset() || offset > end()) return std::nullopt;
+		std::shared_ptr<const Data> node = data;
+		while (true) {
+			const auto children = node->green->children();
+			uint32_t start = node->offset;
+			size_t index = 0;
+			// First child ending after offset, or the last one when offset is the end of the node
+			while (index + 1 < children.size() && start + children[index].length() <= offset) {
+				start += children[index].length();
+				++index;
+			}
+			if (children.empty()) return std::nullopt;
+			const GreenElement child = children[index];
+			if (const GreenToken* token = child.token()) {
+				return SyntaxToken(node, token, start, static_cast<uint32_t>(index));
+			}
+			node = std::make_shared<const Data>(Data{child.node(), node, start, static_cast<uint32_t>(index)});
+		}
+	}
+
+	std::string SyntaxNode::text() const {
+		std::string out;
+		out.reserve(data->green->length);
+		data->green->write(out);
+		return out;
+	}
+
+	SyntaxTree SyntaxTree::parse(const std::string& source, const std::string& fileName, const Flags& flags,
+	                             ErrorReporter& errorReporter, std::shared_ptr<GreenArena> arena) {
+		if (!arena) arena = std::make_shared<GreenArena>();
+		// Every token has to go through the parser in order: no lazy bodies, no parallel slices
+		Flags eager = flags;
+		eager.lazyParsing = false;
+
+		SyntaxBuilder builder(*arena, source);
+		std::ostream discard(nullptr);
+		Parser parser(Lexer(source, fileName).tokenize(), eager, errorReporter, discard);
+		parser.recordSyntax(&builder);
+		parser.parse();
+		const GreenNode* root = builder.finish(SyntaxKind::SOURCE_FILE);
+		return {std::move(arena), root, fileName};
+	}
+
+	SyntaxNode SyntaxTree::root() const {
+		return SyntaxNode(std::make_shared<const SyntaxNode::Data>(SyntaxNode::Data{green, nullptr, 0, 0}));
+	}
+
+	std::string SyntaxTree::text() const {
+		return root().text();
+	}
+
+	SyntaxTree SyntaxTree::replace(const SyntaxNode& target, const GreenElement replacement) const {
+		GreenElement current = replacement;
+		for (const SyntaxNode::Data* at = target.data.get(); at->parent; at = at->parent.get()) {
+			current = arena->replaceChild(at->parent->green, at->index, current);
+		}
+		return {arena, current.node(), fileName};
+	}
+
+	SyntaxTree SyntaxTree::replace(const SyntaxToken& target, const GreenElement replacement) const {
+		const SyntaxNode parent = target.parent();
+		return replace(parent, arena->replaceChild(parent.green(), target.indexInParent(), replacement));
+	}
+
+	namespace {
+		struct TokenCollector {
+			const std::string& fileName;
+			std::vector<Token> tokens;
+			uint32_t offset = 0;
+			size_t line = 1, column = 1;
+
+			void walk(const GreenNode* node) {
+				for (const GreenElement child: node->children()) {
+					if (const GreenToken* token = child.token()) add(token);
+					else walk(child.node());
+				}
+			}
+
+			void add(const GreenToken* token) {
+				const size_t startColumn = column;
+				for (const char c: token->text()) {
+					if (c == '\n') {
+						++line;
+						column = 1;
+					}
+					else ++column;
+				}
+				// Same convention as the lexer: the line a token ends on, the column it starts at
+				if (!token->isTrivia()) {
+					tokens.emplace_back(token->type, std::string(token->text()),
+					                    SourceLocation{line, startColumn, token->length, offset, fileName});
+				}
+				offset += token->length;
+			}
+		};
+
+		std::string escaped(const std::string_view text) {
+			std::string result;
+			for (const char c: text) {
+				if (c == '\n') result += "\\n";
+				else if (c == '\t') result += "\\t";
+				else if (c == '"' || c == '\\') result += {'\\', c};
+				else result += c;
+			}
+			return result;
+		}
+
+		void dumpNode(std::ostream& out, const SyntaxNode& node, const size_t depth) {
+			out << std::string(depth * 2, ' ') << toString(node.kind()) << '@' << node.offset() << ".." << node.end() << '\n';
+			for (const auto& child: node.children()) {
+				if (const auto* inner = std::get_if<SyntaxNode>(&child)) {
+					dumpNode(out, *inner, depth + 1);
+					continue;
+				}
+				const auto& token = std::get<SyntaxToken>(child);
+				out << std::string(depth * 2 + 2, ' ')
+					<< (token.kind() == SyntaxKind::TOKEN ? Lexer::tokenToString(token.type()) : toString(token.kind()))
+					<< '@' << token.offset() << ".." << token.end() << " \"" << escaped(token.text()) << "\"\n";
+			}
+		}
+	}
+
+	std::vector<Token> SyntaxTree::tokens() const {
+		TokenCollector collector{fileName, {}};
+		collector.walk(green);
+		collector.tokens.emplace_back(TokenType::EOF_TOKEN, "", collector.line, collector.column, 0);
+		return std::move(collector.tokens);
+	}
+
+	polymorphic<ProgramNode> SyntaxTree::lower(const Flags& flags, ErrorReporter& errorReporter,
+	                                           std::ostream& errStream) const {
+		Parser parser(tokens(), flags, errorReporter, errStream);
+		return parser.parse();
+	}
+
+	void SyntaxTree::dump(std::ostream& out) const {
+		dumpNode(out, root(), 0);
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <variant>
+#include <vector>
+#include "GreenTree.hpp"
+#include "../ast/AST.hpp"
+#include "../exceptions/ErrorReporter.hpp"
+#include "../utils/mainargs.hpp"
+
+namespace zenith {
+	class SyntaxToken;
+
+	// Red tree: a view of a green node at a position
+	// Red nodes are made on demand while walking down and hold on to their parent, so they know their absolute offset
+	// and can go back up. They are cheap handles, nothing is cached: asking for the same child twice makes two.
+	class SyntaxNode {
+		struct Data {
+			const GreenNode* green;
+			std::shared_ptr<const Data> parent;
+			uint32_t offset;
+			uint32_t index; // In the parent's children
+		};
+		std::shared_ptr<const Data> data;
+
+		explicit SyntaxNode(std::shared_ptr<const Data> data) : data(std::move(data)) {}
+		friend class SyntaxToken;
+		friend class SyntaxTree;
+
+	public:
+		using Element = std::variant<SyntaxNode, SyntaxToken>;
+
+		[[nodiscard]] SyntaxKind kind() const { return data->green->kind; }
+		[[nodiscard]] const GreenNode* green() const { return data->green; }
+		[[nodiscard]] uint32_t offset() const { return data->offset; }
+		[[nodiscard]] uint32_t end() const { return data->offset + data->green->length; }
+		[[nodiscard]] uint32_t indexInParent() const { return data->index; }
+		[[nodiscard]] std::optional<SyntaxNode> parent() const;
+		[[nodiscard]] std::vector<Element> children() const;
+		[[nodiscard]] std::vector<SyntaxNode> childNodes() const;
+		// Innermost node whose range contains [begin, end)
+		[[nodiscard]] SyntaxNode coveringNode(uint32_t begin, uint32_t end) const;
+		// The token containing offset, the one to the left when offset sits between two
+		[[nodiscard]] std::optional<SyntaxToken> tokenAt(uint32_t offset) const;
+		[[nodiscard]] std::string text() const;
+		bool operator==(const SyntaxNode& other) const {
+			return data->green == other.data->green && data->offset == other.data->offset;
+		}
+	};
+
+	class SyntaxToken {
+		std::shared_ptr<const SyntaxNode::Data> parentData;
+		const GreenToken* token;
+		uint32_t start;
+		uint32_t index;
+
+		SyntaxToken(std::shared_ptr<const SyntaxNode::Data> parent, const GreenToken* token, uint32_t offset, uint32_t index)
+			: parentData(std::move(parent)), token(token), start(offset), index(index) {}
+		friend class SyntaxNode;
+
+	public:
+		[[nodiscard]] SyntaxKind kind() const { return token->kind; }
+		[[nodiscard]] TokenType type() const { return token->type; }
+		[[nodiscard]] const GreenToken* green() const { return token; }
+		[[nodiscard]] uint32_t offset() const { return start; }
+		[[nodiscard]] uint32_t end() const { return start + token->length; }
+		[[nodiscard]] uint32_t indexInParent() const { return index; }
+		[[nodiscard]] SyntaxNode parent() const { return SyntaxNode(parentData); }
+		[[nodiscard]] std::string_view text() const { return token->text(); }
+	};
+
+	// A lossless syntax tree: the green root plus the arena that owns it
+	// tree.root().text() reproduces the source byte for byte, comments and whitespace included. Edits return a new
+	// tree that shares every untouched subtree with the old one.
+	class SyntaxTree {
+		std::shared_ptr<GreenArena> arena;
+		const GreenNode* green;
+		std::string fileName;
+
+	public:
+		SyntaxTree(std::shared_ptr<GreenArena> arena, const GreenNode* root, std::string fileName)
+			: arena(std::move(arena)), green(root), fileName(std::move(fileName)) {}
+
+		// Lexes and parses source with the regular parser, recording the tree as it goes. Throws like they do.
+		static SyntaxTree parse(const std::string& source, const std::string& fileName, const Flags& flags,
+		                        ErrorReporter& errorReporter, std::shared_ptr<GreenArena> arena = nullptr);
+
+		[[nodiscard]] SyntaxNode root() const;
+		[[nodiscard]] const std::string& file() const { return fileName; }
+		[[nodiscard]] const std::shared_ptr<GreenArena>& greenArena() const { return arena; }
+		[[nodiscard]] std::string text() const;
+
+		// Rebuilds the path from target up to the root around the replacement, everything else is shared
+		[[nodiscard]] SyntaxTree replace(const SyntaxNode& target, GreenElement replacement) const;
+		[[nodiscard]] SyntaxTree replace(const SyntaxToken& target, GreenElement replacement) const;
+
+		// The AST for this tree, built by running the parser over the tokens the tree holds
+		// Locations are recomputed from the tree, so this works for edited trees too.
+		[[nodiscard]] std::vector<Token> tokens() const;
+		[[nodiscard]] polymorphic<ProgramNode> lower(const Flags& flags, ErrorReporter& errorReporter,
+		                                             std::ostream& errStream) const;
+
+		// One line per node and token with its range, tokens with their text
+		void dump(std::ostream& out) const;
+	};
+}
@@ -0,0 +1,291 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <serialize/BinaryAST.hpp>
+#include <serialize/ModuleCache.hpp>
+#include <visitor/ASTWalker.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <exceptions/LexError.hpp>
+
+using namespace zenith;
+
+// Streams every node in source order with everything that is not visible in toString()
+class NodeDump : public ASTWalker {
+protected:
+    void enter(ASTNode& node) override {
+        // Whether a body was decoded lazily is not part of the tree
+        const auto& type = typeid(node) == typeid(LazyBlockNode) ? typeid(BlockNode) : typeid(node);
+        out << type.name() << ' ' << node.loc.line << ':' << node.loc.column << '+' << node.loc.length
+            << '@' << node.loc.fileOffset << ' ' << node.loc.file;
+        if (const auto* expr = dynamic_cast<ExprNode*>(&node); expr && expr->constantValue) {
+            out << " = " << ConstantValue::kindName(expr->constantValue->kind) << ' '
+                << expr->constantValue->toString();
+        }
+        if (const auto* object = dynamic_cast<FreeObjectNode*>(&node)) {
+            out << " escape " << static_cast<int>(object->escape.verdict) << '/' << +object->escape.causes
+                << " shape " << object->shape.initial << "->" << object->shape.final << '/' << +object->shape.changes;
+        }
+        out << '\n';
+    }
+
+public:
+    std::ostringstream out;
+};
+
+// Walking first decodes every lazy body, so toString() sees the whole tree
+static std::string dump(polymorphic<ProgramNode>& program) {
+    NodeDump nodes;
+    program->accept(nodes);
+    try {
+        return nodes.out.str() + program->toString();
+    }
+    catch (const std::exception& e) {
+        return nodes.out.str() + e.what(); // e.g. a for loop without a condition, see IncrementalParseTest
+    }
+}
+
+static polymorphic<ProgramNode> parse(const std::string& src, Flags flags = {}, size_t* errors = nullptr) {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    Parser parser(Lexer(src, "<test>").tokenize(), flags, reporter, discard);
+    auto program = parser.parse();
+    if (errors) *errors = diagnostics.errorCount();
+    return program;
+}
+
+static std::filesystem::path temporaryDirectory() {
+    return std::filesystem::temp_directory_path() / ("zenith-binary-ast-" + std::to_string(std::random_device()()));
+}
+
+static const std::string SAMPLE =
+    "@Async fun int add(int a, int b) {\n"
+    "    int q = a + b * 2\n"
+    "    if (q > 10) {\n"
+    "        q = q - 1\n"
+    "    } else {\n"
+    "        q = g(h(q, a), b)\n"
+    "    }\n"
+    "    do {\n"
+    "        q = q - 1\n"
+    "    } while (q > 0)\n"
+    "    unsafe {\n"
+    "        q = 3\n"
+    "    }\n"
+    "    return q\n"
+    "}\n"
+    "class Point {\n"
+    "    public int x;\n"
+    "    private static int count = 0;\n"
+    "    Point(int x) : x(x) {\n"
+    "        this.x = x\n"
+    "    }\n"
+    "    public fun int sum() {\n"
+    "        return this.x + 1\n"
+    "    }\n"
+    "}\n"
+    "template<typename T, int N = 3> class Box {\n"
+    "    public T value;\n"
+    "}\n"
+    "union Num { int, float }\n"
+    "var f = (a, b) => a * b\n"
+    "Point p = {x: 1, y: 2}\n"
+    "freeobj o = freeobj {a: 1, b: \"s\"}\n"
+    "var n = new Point(1)\n"
+    "actor Counter {\n"
+    "    on Increment(int by) {\n"
+    "        count = count + by\n"
+    "    }\n"
+    "}\n"
+    "fun main() {\n"
+    "    var x = add(1, 2)\n"
+    "    for (int i = 0; i < 3; i = i + 1) {\n"
+    "        x = x.y[i]\n"
+    "    }\n"
+    "    while (!done) {\n"
+    "        x = -x\n"
+    "    }\n"
+    "}\n"
+    "import \"lib/math\"\n";
+
+// ===========================================================================
+// 1. Round trip
+// ===========================================================================
+
+TEST(BinaryAST, RoundTripsEveryNode) {
+    size_t errors = 0;
+    auto program = parse(SAMPLE, {}, &errors);
+    ASSERT_EQ(errors, 0u);
+
+    const std::string bytes = BinaryAST::write(*program);
+    auto loaded = BinaryAST::read(bytes);
+    EXPECT_EQ(dump(loaded), dump(program));
+    EXPECT_EQ(BinaryAST::write(*loaded), bytes); // Nothing was lost that writing looks at
+}
+
+TEST(BinaryAST, BodiesAreDecodedOnFirstVisit) {
+    auto program = parse(SAMPLE);
+    auto loaded = BinaryAST::read(BinaryAST::write(*program));
+
+    auto function = loaded->declarations.front().cast().non_throwing().to<FunctionDeclNode>();
+    ASSERT_TRUE(function);
+    auto body = function->body.cast().non_throwing().to<LazyBlockNode>();
+    ASSERT_TRUE(body);
+    EXPECT_FALSE(body->isParsed());
+    EXPECT_TRUE(body->statements.empty());
+
+    NodeDump nodes;
+    loaded->accept(nodes);
+    EXPECT_TRUE(body->isParsed());
+    EXPECT_EQ(body->statements.size(), 5u);
+}
+
+TEST(BinaryAST, WritesLazilyParsedBodies) {
+    Flags lazy;
+    lazy.lazyParsing = true;
+    auto program = parse(SAMPLE, lazy);
+    auto loaded = BinaryAST::read(BinaryAST::write(*program));
+    auto eager = parse(SAMPLE);
+    EXPECT_EQ(dump(loaded), dump(eager));
+}
+
+TEST(BinaryAST, KeepsAnalysisResults) {
+    auto program = parse("var a = 1 + 2\nvar b = 1.5\nvar c = \"s\"\nfreeobj o = freeobj {a: true}\n");
+
+    // What semantic analysis, escape analysis and shape inference would have filled in
+    class Annotate : public ASTWalker {
+        int next = 0;
+
+    protected:
+        void enter(ASTNode& node) override {
+            auto* expr = dynamic_cast<ExprNode*>(&node);
+            if (!expr) return;
+            switch (next++ % 4) {
+                case 0: expr->constantValue = ConstantValue{ConstantValue::Kind::LONG, int64_t{-40000000000}}; break;
+                case 1: expr->constantValue = ConstantValue{ConstantValue::Kind::DOUBLE, 1.5}; break;
+                case 2: expr->constantValue = ConstantValue{ConstantValue::Kind::STRING, std::string("s")}; break;
+                default: expr->constantValue = ConstantValue{ConstantValue::Kind::BOOL, true}; break;
+            }
+            if (auto* object = dynamic_cast<FreeObjectNode*>(&node)) {
+                object->escape = {EscapeInfo::Verdict::STACK, EscapeInfo::CAPTURE | EscapeInfo::LOOP};
+                object->shape.initial = 3;
+                object->shape.changes = ShapeInfo::ADD;
+            }
+        }
+    } annotate;
+    program->accept(annotate);
+
+    auto loaded = BinaryAST::read(BinaryAST::write(*program));
+    EXPECT_EQ(dump(loaded), dump(program));
+    EXPECT_NE(dump(program).find("shape 3->4294967295/1"), std::string::npos);
+}
+
+TEST(BinaryAST, RoundTripsUnderRandomEdits) {
+    static const std::string alphabet = "{}()[];,=+<>@.\n x1\"";
+    size_t checked = 0;
+    for (unsigned seed = 0; seed < 40; ++seed) {
+        std::mt19937 rng(seed);
+        std::string src = SAMPLE;
+        for (int step = 0; step < 10; ++step) {
+            const size_t offset = rng() % (src.size() + 1);
+            const char c = alphabet[rng() % alphabet.size()];
+            if (offset == src.size() || rng() % 2) src.insert(offset, 1, c);
+            else src.erase(offset, 1);
+        }
+
+        Flags flags;
+        flags.lazyParsing = seed % 2;
+        polymorphic<ProgramNode> program;
+        try {
+            program = parse(src, flags);
+        }
+        catch (const std::exception&) {
+            continue; // Lex errors and errors that escape the top level leave no tree
+        }
+        auto loaded = BinaryAST::read(BinaryAST::write(*program));
+        ASSERT_EQ(dump(loaded), dump(program)) << "seed " << seed << "\n" << src;
+        ++checked;
+    }
+    EXPECT_GT(checked, 20u);
+}
+
+// ===========================================================================
+// 2. Files
+// ===========================================================================
+
+TEST(BinaryAST, LoadsMappedFile) {
+    auto program = parse(SAMPLE);
+    const auto directory = temporaryDirectory();
+    std::filesystem::create_directories(directory);
+    const auto path = (directory / "sample.zast").string();
+    BinaryAST::write(*program, path);
+
+    auto loaded = BinaryAST::load(path);
+    EXPECT_EQ(dump(loaded), dump(program));
+    std::filesystem::remove_all(directory);
+}
+
+TEST(BinaryAST, RejectsForeignAndDamagedInput) {
+    auto program = parse(SAMPLE);
+    const std::string bytes = BinaryAST::write(*program);
+
+    EXPECT_THROW((void) BinaryAST::read("not an AST at all, but long enough for a header"), std::runtime_error);
+    std::string otherVersion = bytes;
+    ++otherVersion[4];
+    EXPECT_THROW((void) BinaryAST::read(otherVersion), std::runtime_error);
+    EXPECT_THROW((void) BinaryAST::read(bytes.substr(0, bytes.size() - 1)), std::runtime_error);
+
+    // Damage anywhere is either caught or decodes to some tree, it never reads out of bounds
+    std::mt19937 rng(7);
+    for (int i = 0; i < 500; ++i) {
+        std::string damaged = bytes;
+        damaged[32 + rng() % (damaged.size() - 32)] ^= static_cast<char>(1 << rng() % 8);
+        try {
+            auto loaded = BinaryAST::read(damaged);
+            NodeDump nodes;
+            loaded->accept(nodes);
+        }
+        catch (const std::runtime_error&) {}
+    }
+}
+
+// ===========================================================================
+// 3. Module cache
+// ===========================================================================
+
+TEST(ModuleCache, ReusesModulesWithTheSameSource) {
+    const auto directory = temporaryDirectory();
+    const ModuleCache cache(directory);
+    Flags flags;
+    EXPECT_FALSE(cache.load(SAMPLE, "a.zn", flags));
+
+    auto program = parse(SAMPLE);
+    cache.store(SAMPLE, "a.zn", flags, *program);
+    auto loaded = cache.load(SAMPLE, "a.zn", flags);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(dump(loaded), dump(program));
+
+    // Anything the parse depends on is part of the key
+    EXPECT_FALSE(cache.load(SAMPLE + "\n", "a.zn", flags));
+    EXPECT_FALSE(cache.load(SAMPLE, "b.zn", flags));
+    Flags optionalBraces = flags;
+    optionalBraces.bracesRequired = false;
+    EXPECT_FALSE(cache.load(SAMPLE, "a.zn", optionalBraces));
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ModuleCache, DamagedEntryIsAMiss) {
+    const auto directory = temporaryDirectory();
+    const ModuleCache cache(directory);
+    Flags flags;
+    auto program = parse(SAMPLE);
+    cache.store(SAMPLE, "a.zn", flags, *program);
+
+    std::ofstream(cache.entry(SAMPLE, "a.zn", flags), std::ios::binary | std::ios::trunc) << "ZAST";
+    EXPECT_FALSE(cache.load(SAMPLE, "a.zn", flags));
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <SemanticAnalysis/ClassHierarchy.hpp>
+#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+#include <test/ParsedProgram.hpp>
+
+using namespace zenith;
+
+// The hierarchy points into the declarations, so they live as long as it does
+struct Hierarchy {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter{diagnostics};
+    std::deque<ObjectDeclNode> declarations;
+    ClassHierarchy classes{reporter};
+
+    // 'name' or 'name : base'
+    Hierarchy(std::initializer_list<std::pair<std::string, std::string>> list) {
+        for (const auto& [name, base]: list) add(name, base);
+        classes.build();
+    }
+
+    void add(const std::string& name, const std::string& base) {
+        classes.add(declarations.emplace_back(SourceLocation{declarations.size() + 1, 1, 5, 0, "<test>"},
+                                              ObjectDeclNode::Kind::CLASS, name, base,
+                                              std::vector<polymorphic<DeclNode>>{}));
+    }
+
+    std::vector<std::string> messages() const {
+        std::vector<std::string> out;
+        for (const auto& d: diagnostics.collect()) out.push_back(d.message);
+        return out;
+    }
+};
+
+// ===========================================================================
+// 1. Subclass queries
+// ===========================================================================
+
+TEST(ClassHierarchy, ClassIsASubclassOfItself) {
+    const Hierarchy h{{"Animal", ""}, {"Dog", "Animal"}};
+    EXPECT_TRUE(h.classes.isSubclassOf("Animal", "Animal"));
+    EXPECT_TRUE(h.classes.isSubclassOf("Dog", "Dog"));
+}
+
+TEST(ClassHierarchy, DirectAndIndirectBases) {
+    // Declared out of order, bases are resolved after every class is known
+    const Hierarchy h{{"Puppy", "Dog"}, {"Dog", "Animal"}, {"Animal", ""}};
+    EXPECT_TRUE(h.messages().empty());
+    EXPECT_TRUE(h.classes.isSubclassOf("Dog", "Animal"));
+    EXPECT_TRUE(h.classes.isSubclassOf("Puppy", "Dog"));
+    EXPECT_TRUE(h.classes.isSubclassOf("Puppy", "Animal"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Animal", "Dog"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Animal", "Puppy"));
+}
+
+TEST(ClassHierarchy, SiblingsAreNotSubclassesOfEachOther) {
+    const Hierarchy h{{"Animal", ""}, {"Dog", "Animal"}, {"Cat", "Animal"}, {"Kitten", "Cat"}, {"Rock", ""}};
+    EXPECT_FALSE(h.classes.isSubclassOf("Dog", "Cat"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Cat", "Dog"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Kitten", "Dog"));
+    EXPECT_TRUE(h.classes.isSubclassOf("Kitten", "Animal"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Rock", "Animal"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Animal", "Rock"));
+}
+
+TEST(ClassHierarchy, UnknownBaseIsReportedAndTheClassBecomesARoot) {
+    const Hierarchy h{{"Dog", "Missing"}, {"Puppy", "Dog"}};
+    ASSERT_EQ(h.messages(), std::vector<std::string>{"Base class 'Missing' not found"});
+    EXPECT_EQ(h.classes.info(h.classes.idOf("Dog")).parent, ClassHierarchy::NO_CLASS);
+    EXPECT_TRUE(h.classes.isSubclassOf("Puppy", "Dog"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Dog", "Missing"));
+}
+
+TEST(ClassHierarchy, UnknownNamesAreNotSubclasses) {
+    const Hierarchy h{{"Animal", ""}};
+    EXPECT_FALSE(h.classes.isSubclassOf("Missing", "Animal"));
+    EXPECT_FALSE(h.classes.isSubclassOf("Animal", "Missing"));
+}
+
+// ===========================================================================
+// 2. Cycles
+// ===========================================================================
+
+TEST(ClassHierarchy, SelfInheritanceIsACycle) {
+    const Hierarchy h{{"Loop", "Loop"}};
+    EXPECT_EQ(h.messages(), std::vector<std::string>{"Inheritance cycle detected: Loop -> Loop"});
+    EXPECT_TRUE(h.classes.isSubclassOf("Loop", "Loop"));
+}
+
+TEST(ClassHierarchy, DirectCycleIsReportedOnceAndCut) {
+    const Hierarchy h{{"A", "B"}, {"B", "A"}};
+    EXPECT_EQ(h.messages(), std::vector<std::string>{"Inheritance cycle detected: A -> B -> A"});
+    // Cut at A, the class the walk came back to, so B still inherits from it
+    EXPECT_TRUE(h.classes.isSubclassOf("B", "A"));
+    EXPECT_FALSE(h.classes.isSubclassOf("A", "B"));
+}
+
+TEST(ClassHierarchy, IndirectCycleIsReportedOnceAndCut) {
+    const Hierarchy h{{"Root", ""}, {"A", "C"}, {"B", "A"}, {"C", "B"}, {"Leaf", "B"}};
+    EXPECT_EQ(h.messages(), std::vector<std::string>{"Inheritance cycle detected: A -> C -> B -> A"});
+    EXPECT_TRUE(h.classes.isSubclassOf("C", "A"));
+    EXPECT_TRUE(h.classes.isSubclassOf("Leaf", "A"));
+    EXPECT_FALSE(h.classes.isSubclassOf("A", "C"));
+    EXPECT_FALSE(h.classes.isSubclassOf("A", "Root"));
+}
+
+// ===========================================================================
+// 3. Numbering
+// ===========================================================================
+
+TEST(ClassHierarchy, DeepChainIsNumberedWithoutRecursion) {
+    // Far deeper than the call stack would allow a recursive DFS to go
+    constexpr size_t DEPTH = 200000;
+    Hierarchy h{};
+    h.add("C0", "");
+    for (size_t i = 1; i < DEPTH; ++i) h.add("C" + std::to_string(i), "C" + std::to_string(i - 1));
+    h.classes.build();
+    ASSERT_TRUE(h.messages().empty());
+
+    const auto last = "C" + std::to_string(DEPTH - 1);
+    EXPECT_TRUE(h.classes.isSubclassOf(last, "C0"));
+    EXPECT_TRUE(h.classes.isSubclassOf(last, "C" + std::to_string(DEPTH / 2)));
+    EXPECT_FALSE(h.classes.isSubclassOf("C0", last));
+    const auto& root = h.classes.info(h.classes.idOf("C0"));
+    EXPECT_EQ(root.pre, 0u);
+    EXPECT_EQ(root.post, 2 * DEPTH - 1);
+}
+
+TEST(ClassHierarchy, IntervalsNestExactlyForDescendants) {
+    const Hierarchy h{{"A", ""}, {"B", "A"}, {"C", "A"}, {"D", "B"}, {"E", "B"}, {"F", "C"}, {"G", ""}};
+    const std::vector<std::string> names{"A", "B", "C", "D", "E", "F", "G"};
+    // Brute force over the parent chain as the reference
+    auto walks = [&](ClassHierarchy::ClassId derived, const ClassHierarchy::ClassId base) {
+        for (; derived != ClassHierarchy::NO_CLASS; derived = h.classes.info(derived).parent) {
+            if (derived == base) return true;
+        }
+        return false;
+    };
+    for (const auto& d: names) {
+        for (const auto& b: names) {
+            EXPECT_EQ(h.classes.isSubclassOf(d, b), walks(h.classes.idOf(d), h.classes.idOf(b))) << d << " : " << b;
+        }
+    }
+}
+
+// ===========================================================================
+// 4. Type compatibility in the analyzer
+// ===========================================================================
+
+static size_t analysisErrors(const std::string& src) {
+    ParsedProgram parsed(src);
+    SemanticAnalyzer(parsed.reporter).analyze(parsed.program);
+    return parsed.diagnostics.errorCount();
+}
+
+static const std::string ANIMALS =
+    "class Animal {\n"
+    "    public int legs;\n"
+    "}\n"
+    "class Dog : Animal {\n"
+    "    public int tricks;\n"
+    "}\n"
+    "class Puppy : Dog {\n"
+    "    public int age;\n"
+    "}\n"
+    "class Cat : Animal {\n"
+    "    public int lives;\n"
+    "}\n";
+
+TEST(ClassHierarchy, SubclassIsAssignableToItsBases) {
+    EXPECT_EQ(analysisErrors(ANIMALS +
+        "fun Animal widen(Puppy p) {\n"
+        "    return p\n"
+        "}\n"
+        "fun int feed(Dog d) {\n"
+        "    return 1\n"
+        "}\n"
+        "fun int play(Puppy p) {\n"
+        "    return feed(p)\n"
+        "}\n"), 0u);
+}
+
+TEST(ClassHierarchy, BaseAndSiblingAreNotAssignable) {
+    EXPECT_EQ(analysisErrors(ANIMALS +
+        "fun Dog narrow(Animal a) {\n"
+        "    return a\n"
+        "}\n"), 1u);
+    EXPECT_EQ(analysisErrors(ANIMALS +
+        "fun Cat swap(Dog d) {\n"
+        "    return d\n"
+        "}\n"), 1u);
+}
@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <driver/CompileServer.hpp>
+#include <driver/Driver.hpp>
+#include <test/TempDir.hpp>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace zenith;
+namespace fs = std::filesystem;
+
+// Dated back so the cache trusts the stat, the way files look that were not written just now
+static void age(const std::string& file, const int minutes) {
+    fs::last_write_time(file, fs::file_time_type::clock::now() - std::chrono::minutes(minutes));
+}
+
+static std::string program(const int value) {
+    return "fun int main() {\n    return " + std::to_string(value) + "\n}\n";
+}
+
+static CompileServer::Reply compileDirectly(const std::vector<std::string>& files) {
+    std::vector<std::string> args{"zenith"};
+    args.insert(args.end(), files.begin(), files.end());
+    std::ostringstream out, err;
+    const int status = Driver(ArgumentParser::parse(args)).run(out, err);
+    return {status, out.str(), err.str()};
+}
+
+// ===========================================================================
+// 1. CompileCache
+// ===========================================================================
+
+TEST(CompileServer, CacheReadsAFileAgainOnlyWhenItsStatChanged) {
+    TempDir dir("read");
+    const std::string file = dir.write("a.zn", program(1));
+    age(file, 10);
+    CompileCache cache;
+    EXPECT_EQ(*cache.read(file).text, program(1));
+    EXPECT_EQ(*cache.read(file).text, program(1));
+    EXPECT_EQ(cache.stats().reads, 1u);
+    EXPECT_EQ(cache.stats().unchanged, 1u);
+
+    dir.write("a.zn", program(2)); // Same size, a later modification time
+    age(file, 5);
+    EXPECT_EQ(*cache.read(file).text, program(2));
+    EXPECT_EQ(cache.stats().reads, 2u);
+}
+
+TEST(CompileServer, CacheDoesNotTrustAStatTakenRightAfterAWrite) {
+    TempDir dir("racy");
+    const std::string file = dir.write("a.zn", program(1));
+    CompileCache cache;
+    EXPECT_EQ(cache.read(file).hash, cache.read(file).hash);
+    EXPECT_EQ(cache.stats().reads, 2u) << "a write in the same clock tick would not change the stat";
+}
+
+TEST(CompileServer, CacheKeysResultsByContentAndFlags) {
+    TempDir dir("results");
+    const std::string file = dir.write("a.zn", program(1));
+    CompileCache cache;
+    Flags flags;
+    const CompileCache::Source source = cache.read(file);
+    EXPECT_FALSE(cache.find(file, source, flags));
+    cache.store(file, source, flags, {"out", "err", true});
+    const auto hit = cache.find(file, source, flags);
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit->out, "out");
+    EXPECT_TRUE(hit->ok);
+
+    Flags otherFlags;
+    otherFlags.maxErrors = 3;
+    EXPECT_FALSE(cache.find(file, source, otherFlags));
+    otherFlags = flags;
+    otherFlags.pipeline = true; // Same output either way
+    EXPECT_TRUE(cache.find(file, source, otherFlags));
+
+    dir.write("a.zn", program(2));
+    EXPECT_FALSE(cache.find(file, cache.read(file), flags));
+    dir.write("a.zn", program(1)); // Back to the text the result was made from
+    EXPECT_TRUE(cache.find(file, cache.read(file), flags));
+
+    Flags logs;
+    logs.dumpLogs = true;
+    EXPECT_FALSE(CompileCache::cacheable(logs));
+    EXPECT_TRUE(CompileCache::cacheable(flags));
+}
+
+// ===========================================================================
+// 2. Server
+// ===========================================================================
+
+struct RunningServer {
+    std::string socket;
+    CompileServer server;
+    std::thread thread;
+
+    explicit RunningServer(const TempDir& dir) : socket((dir.path / "zenith.sock").string()), server(socket, 2) {
+        server.listen();
+        thread = std::thread([this] { server.serve(); });
+    }
+    ~RunningServer() {
+        CompileServer::stop(socket);
+        thread.join();
+    }
+};
+
+TEST(CompileServer, RepliesLikeACompileInTheClientsProcess) {
+    TempDir dir("reply");
+    const std::string good = dir.write("good.zn", program(1));
+    const std::string bad = dir.write("bad.zn", "fun int f( {\n");
+    RunningServer running(dir);
+
+    for (const auto& files: std::vector<std::vector<std::string>>{{good}, {bad}, {good, bad}}) {
+        const auto reply = CompileServer::request(running.socket, dir.path.string(), files);
+        ASSERT_TRUE(reply);
+        const CompileServer::Reply expected = compileDirectly(files);
+        EXPECT_EQ(reply->status, expected.status);
+        EXPECT_EQ(reply->out, expected.out);
+        EXPECT_EQ(reply->err, expected.err);
+    }
+    EXPECT_EQ(running.server.cache().stats().hits, 2u) << "good and bad again in the last request";
+}
+
+TEST(CompileServer, ResolvesRelativePathsAgainstTheClientsDirectory) {
+    TempDir dir("relative");
+    dir.write("a.zn", program(1));
+    RunningServer running(dir);
+    const auto reply = CompileServer::request(running.socket, dir.path.string(), {"a.zn"});
+    ASSERT_TRUE(reply);
+    EXPECT_EQ(reply->status, Driver::SUCCESS) << reply->err;
+
+    const auto usage = CompileServer::request(running.socket, dir.path.string(), {"--bogus", "a.zn"});
+    ASSERT_TRUE(usage);
+    EXPECT_EQ(usage->status, Driver::USAGE);
+    EXPECT_NE(usage->err.find("Unknown option"), std::string::npos);
+}
+
+TEST(CompileServer, RecompilesAnEditedFile) {
+    TempDir dir("edit");
+    const std::string file = dir.write("a.zn", program(1));
+    RunningServer running(dir);
+    ASSERT_EQ(CompileServer::request(running.socket, "/", {file})->status, Driver::SUCCESS);
+    dir.write("a.zn", "fun int main() {\n    return undefinedName\n}\n");
+    const auto reply = CompileServer::request(running.socket, "/", {file});
+    ASSERT_TRUE(reply);
+    EXPECT_EQ(reply->status, Driver::FAILED);
+    EXPECT_EQ(running.server.cache().stats().hits, 0u);
+}
+
+TEST(CompileServer, ServesConcurrentClients) {
+    TempDir dir("concurrent");
+    std::vector<std::string> files;
+    for (int i = 0; i < 8; ++i) files.push_back(dir.write("m" + std::to_string(i) + ".zn", program(i)));
+    RunningServer running(dir);
+    std::vector<CompileServer::Reply> replies(32);
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < replies.size(); ++i) {
+        clients.emplace_back([&, i] {
+            if (auto reply = CompileServer::request(running.socket, "/", {files[i % files.size()]})) replies[i] = *reply;
+            else replies[i].status = -1;
+        });
+    }
+    for (auto& client: clients) client.join();
+    for (size_t i = 0; i < replies.size(); ++i) {
+        EXPECT_EQ(replies[i].status, Driver::SUCCESS) << i;
+        EXPECT_EQ(replies[i].out, compileDirectly({files[i % files.size()]}).out) << i;
+    }
+}
+
+TEST(CompileServer, StopsAndRemovesItsSocket) {
+    TempDir dir("stop");
+    const std::string socket = (dir.path / "zenith.sock").string();
+    EXPECT_FALSE(CompileServer::request(socket, "/", {"a.zn"}));
+    EXPECT_FALSE(CompileServer::stop(socket));
+    {
+        RunningServer running(dir);
+        CompileServer second(socket, 1);
+        EXPECT_THROW(second.listen(), std::runtime_error) << "one server per socket";
+    }
+    EXPECT_FALSE(fs::exists(socket));
+    EXPECT_FALSE(CompileServer::stop(socket));
+}
+
+// ===========================================================================
+// 3. Only this user
+// ===========================================================================
+
+TEST(CompileServer, DefaultSocketIsInADirectoryOfTheUser) {
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    const std::optional<std::string> saved = runtime ? std::optional<std::string>(runtime) : std::nullopt;
+    ::setenv("XDG_RUNTIME_DIR", "/run/user/test", 1);
+    EXPECT_EQ(CompileServer::defaultSocket(), "/run/user/test/zenith.sock");
+    ::unsetenv("XDG_RUNTIME_DIR");
+    const std::string socket = CompileServer::defaultSocket();
+    if (saved) ::setenv("XDG_RUNTIME_DIR", saved->c_str(), 1);
+
+    const fs::path directory = "/tmp/zenith-" + std::to_string(::getuid());
+    EXPECT_EQ(fs::path(socket).parent_path(), directory);
+    if (fs::exists(socket)) GTEST_SKIP() << "a compile server of this user is running";
+    {
+        CompileServer server(socket, 1);
+        server.listen();
+        struct stat status{};
+        ASSERT_EQ(::lstat(directory.c_str(), &status), 0);
+        EXPECT_EQ(status.st_uid, ::getuid());
+        EXPECT_EQ(status.st_mode & 0777, 0700u);
+    }
+    // Others could bind in it, or take the socket away
+    fs::permissions(directory, fs::perms::group_all | fs::perms::others_all, fs::perm_options::add);
+    CompileServer open(socket, 1);
+    EXPECT_THROW(open.listen(), std::runtime_error);
+    fs::permissions(directory, fs::perms::owner_all, fs::perm_options::replace);
+}
+
+TEST(CompileServer, ClientsDoNotTrustAServerOfAnotherUser) {
+    if (::geteuid() != 0) GTEST_SKIP() << "listening as another user needs root";
+    TempDir dir("impostor");
+    const std::string socket = (dir.path / "zenith.sock").string();
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    socket.copy(address.sun_path, sizeof address.sun_path - 1);
+    // Every request gets a successful compile with "fake" as its output
+    static const char reply[] = {3, 0, 0, 0, 1, 0, 0, 0, '0', 4, 0, 0, 0, 'f', 'a', 'k', 'e', 0, 0, 0, 0};
+    int ready[2];
+    ASSERT_EQ(::pipe(ready), 0);
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // Credentials of a listening socket are the ones at listen()
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof address) < 0 ||
+            ::setuid(65534) < 0 || ::listen(fd, 4) < 0 || ::write(ready[1], "x", 1) != 1) {
+            ::_exit(1);
+        }
+        for (;;) {
+            const int connection = ::accept(fd, nullptr, nullptr);
+            if (connection < 0) continue;
+            char request[4096];
+            (void)::recv(connection, request, sizeof request, 0);
+            (void)::send(connection, reply, sizeof reply, MSG_NOSIGNAL);
+            ::close(connection);
+        }
+    }
+    char byte;
+    const bool listening = ::read(ready[0], &byte, 1) == 1;
+    if (listening) {
+        EXPECT_FALSE(CompileServer::request(socket, "/", {"a.zn"}));
+        EXPECT_FALSE(CompileServer::stop(socket));
+    }
+    ::kill(child, SIGKILL);
+    ::waitpid(child, nullptr, 0);
+    ::close(ready[0]);
+    ::close(ready[1]);
+    ASSERT_TRUE(listening);
+}
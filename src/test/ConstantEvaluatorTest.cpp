@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <SemanticAnalysis/ConstantEvaluator.hpp>
+#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+#include <test/ParsedProgram.hpp>
+
+using namespace zenith;
+
+using Kind = ConstantValue::Kind;
+
+static size_t countOf(const DiagnosticsEngine& diagnostics, const Severity severity) {
+    size_t count = 0;
+    for (const auto& diagnostic: diagnostics.collect()) count += diagnostic.severity == severity;
+    return count;
+}
+
+// Folds 'left op right' the way the analyzer does once both operands are constant
+struct Folder {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter{diagnostics};
+    ConstantEvaluator evaluator{reporter};
+
+    std::optional<ConstantValue> fold(const BinaryOpNode::Op op, const ConstantValue& left, const ConstantValue& right) {
+        const BinaryOpNode node(SourceLocation{1, 1, 1, 0, "<test>"}, op, nullptr, nullptr);
+        return evaluator.binary(node, left, right);
+    }
+
+    size_t warnings() const { return countOf(diagnostics, Severity::WARNING); }
+    size_t errors() const { return diagnostics.errorCount(); }
+};
+
+// The program stays alive so the folded values on its nodes can be inspected
+struct Analyzed {
+    polymorphic<ProgramNode> program;
+    size_t errors;
+    size_t warnings;
+};
+
+static Analyzed analyze(const std::string& src) {
+    ParsedProgram parsed(src);
+    SemanticAnalyzer(parsed.reporter).analyze(parsed.program);
+    return {std::move(parsed.program), parsed.diagnostics.errorCount(), countOf(parsed.diagnostics, Severity::WARNING)};
+}
+
+// Folded initializer of the top-level variable declared by declaration 'index'
+static const std::optional<ConstantValue>& initializerOf(const Analyzed& result, const size_t index) {
+    const auto& decl = dynamic_cast<const VarDeclNode&>(*result.program->declarations.at(index));
+    return decl.initializer->constantValue;
+}
+
+// ===========================================================================
+// 1. Integer arithmetic wraps at the width of its type
+// ===========================================================================
+
+TEST(ConstantEvaluator, FoldsWithoutWarningInRange) {
+    Folder folder;
+    const auto sum = folder.fold(BinaryOpNode::ADD, {Kind::INT, int64_t{40}}, {Kind::INT, int64_t{2}});
+    ASSERT_TRUE(sum);
+    EXPECT_EQ(sum->kind, Kind::INT);
+    EXPECT_EQ(sum->asInteger(), 42);
+    EXPECT_EQ(folder.warnings(), 0u);
+}
+
+struct WrapCase {
+    Kind kind;
+    int64_t max;
+    int64_t min;
+};
+
+class ConstantEvaluatorWrap : public ::testing::TestWithParam<WrapCase> {};
+
+TEST_P(ConstantEvaluatorWrap, OverflowWrapsAndWarns) {
+    const auto [kind, max, min] = GetParam();
+    Folder folder;
+    const auto sum = folder.fold(BinaryOpNode::ADD, {kind, max}, {kind, int64_t{1}});
+    ASSERT_TRUE(sum);
+    EXPECT_EQ(sum->kind, kind);
+    EXPECT_EQ(sum->asInteger(), min);
+    EXPECT_EQ(folder.warnings(), 1u);
+
+    const auto difference = folder.fold(BinaryOpNode::SUB, {kind, min}, {kind, int64_t{1}});
+    ASSERT_TRUE(difference);
+    EXPECT_EQ(difference->asInteger(), max);
+    EXPECT_EQ(folder.warnings(), 2u);
+
+    const auto product = folder.fold(BinaryOpNode::MUL, {kind, max}, {kind, int64_t{2}});
+    ASSERT_TRUE(product);
+    EXPECT_EQ(product->asInteger(), -2); // 0b0111..1 * 2 = 0b1111..10
+    EXPECT_EQ(folder.warnings(), 3u);
+    EXPECT_EQ(folder.errors(), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Widths, ConstantEvaluatorWrap, ::testing::Values(
+    WrapCase{Kind::BYTE, std::numeric_limits<int8_t>::max(), std::numeric_limits<int8_t>::min()},
+    WrapCase{Kind::SHORT, std::numeric_limits<int16_t>::max(), std::numeric_limits<int16_t>::min()},
+    WrapCase{Kind::INT, std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()},
+    WrapCase{Kind::LONG, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min()}
+), [](const auto& info) { return std::string(ConstantValue::kindName(info.param.kind)); });
+
+TEST(ConstantEvaluator, NarrowOperandsStayNarrow) {
+    Folder folder;
+    // byte op byte is not promoted to int, the wider operand decides
+    const auto bytes = folder.fold(BinaryOpNode::ADD, {Kind::BYTE, int64_t{100}}, {Kind::BYTE, int64_t{100}});
+    ASSERT_TRUE(bytes);
+    EXPECT_EQ(bytes->kind, Kind::BYTE);
+    EXPECT_EQ(bytes->asInteger(), -56);
+
+    const auto mixed = folder.fold(BinaryOpNode::ADD, {Kind::BYTE, int64_t{100}}, {Kind::INT, int64_t{100}});
+    ASSERT_TRUE(mixed);
+    EXPECT_EQ(mixed->kind, Kind::INT);
+    EXPECT_EQ(mixed->asInteger(), 200);
+    EXPECT_EQ(folder.warnings(), 1u);
+}
+
+TEST(ConstantEvaluator, ConvertingToANarrowerTypeWraps) {
+    Folder folder;
+    const auto stored = folder.evaluator.convert({Kind::INT, int64_t{300}}, PrimitiveTypeNode::Type::BYTE, {});
+    ASSERT_TRUE(stored);
+    EXPECT_EQ(stored->kind, Kind::BYTE);
+    EXPECT_EQ(stored->asInteger(), 44);
+    EXPECT_EQ(folder.warnings(), 1u);
+}
+
+// ===========================================================================
+// 2. Floating point
+// ===========================================================================
+
+TEST(ConstantEvaluator, FloatRoundsToSinglePrecisionAfterEveryOperation) {
+    Folder folder;
+    // 2^24 + 1 is the first integer a float cannot hold
+    const auto single = folder.fold(BinaryOpNode::ADD, {Kind::FLOAT, 16777216.0}, {Kind::FLOAT, 1.0});
+    ASSERT_TRUE(single);
+    EXPECT_EQ(single->kind, Kind::FLOAT);
+    EXPECT_EQ(single->asFloating(), 16777216.0);
+
+    const auto tenth = folder.fold(BinaryOpNode::DIV, {Kind::FLOAT, 1.0}, {Kind::FLOAT, 10.0});
+    ASSERT_TRUE(tenth);
+    EXPECT_EQ(tenth->asFloating(), static_cast<double>(0.1f));
+    EXPECT_NE(tenth->asFloating(), 0.1);
+}
+
+TEST(ConstantEvaluator, DoubleKeepsFullPrecision) {
+    Folder folder;
+    const auto sum = folder.fold(BinaryOpNode::ADD, {Kind::DOUBLE, 16777216.0}, {Kind::FLOAT, 1.0});
+    ASSERT_TRUE(sum);
+    EXPECT_EQ(sum->kind, Kind::DOUBLE);
+    EXPECT_EQ(sum->asFloating(), 16777217.0);
+}
+
+TEST(ConstantEvaluator, FloatingModuloAndDivisionByZero) {
+    Folder folder;
+    const auto remainder = folder.fold(BinaryOpNode::MOD, {Kind::DOUBLE, 7.5}, {Kind::DOUBLE, 2.0});
+    ASSERT_TRUE(remainder);
+    EXPECT_EQ(remainder->asFloating(), 1.5);
+
+    // IEEE semantics, not an error
+    const auto infinite = folder.fold(BinaryOpNode::DIV, {Kind::DOUBLE, 1.0}, {Kind::DOUBLE, 0.0});
+    ASSERT_TRUE(infinite);
+    EXPECT_TRUE(std::isinf(infinite->asFloating()));
+    EXPECT_EQ(folder.errors(), 0u);
+}
+
+// ===========================================================================
+// 3. Division and modulo
+// ===========================================================================
+
+TEST(ConstantEvaluator, IntegerDivisionAndModuloByZeroAreErrors) {
+    Folder folder;
+    EXPECT_FALSE(folder.fold(BinaryOpNode::DIV, {Kind::INT, int64_t{1}}, {Kind::INT, int64_t{0}}));
+    EXPECT_FALSE(folder.fold(BinaryOpNode::MOD, {Kind::INT, int64_t{1}}, {Kind::INT, int64_t{0}}));
+    EXPECT_EQ(folder.errors(), 2u);
+}
+
+TEST(ConstantEvaluator, ModuloTruncatesTowardZero) {
+    Folder folder;
+    const auto remainder = folder.fold(BinaryOpNode::MOD, {Kind::INT, int64_t{-7}}, {Kind::INT, int64_t{3}});
+    ASSERT_TRUE(remainder);
+    EXPECT_EQ(remainder->asInteger(), -1);
+}
+
+TEST(ConstantEvaluator, MinimumDividedByMinusOneOverflows) {
+    Folder folder;
+    constexpr int64_t MIN = std::numeric_limits<int64_t>::min();
+    const auto quotient = folder.fold(BinaryOpNode::DIV, {Kind::LONG, MIN}, {Kind::LONG, int64_t{-1}});
+    ASSERT_TRUE(quotient);
+    EXPECT_EQ(quotient->asInteger(), MIN);
+    EXPECT_EQ(folder.warnings(), 1u);
+
+    const auto remainder = folder.fold(BinaryOpNode::MOD, {Kind::LONG, MIN}, {Kind::LONG, int64_t{-1}});
+    ASSERT_TRUE(remainder);
+    EXPECT_EQ(remainder->asInteger(), 0);
+    EXPECT_EQ(folder.warnings(), 1u);
+}
+
+// ===========================================================================
+// 4. Through the analyzer
+// ===========================================================================
+
+TEST(ConstantEvaluator, AnalyzerFoldsModulo) {
+    const auto result = analyze("int r = 17 % 5\n");
+    EXPECT_EQ(result.errors, 0u);
+    const auto& value = initializerOf(result, 0);
+    ASSERT_TRUE(value);
+    EXPECT_EQ(value->asInteger(), 2);
+}
+
+TEST(ConstantEvaluator, AnalyzerReportsDivisionByZero) {
+    const auto result = analyze("int r = 1 / (2 - 2)\n");
+    EXPECT_EQ(result.errors, 1u);
+    EXPECT_FALSE(initializerOf(result, 0));
+}
+
+TEST(ConstantEvaluator, ConstantsPropagateThroughTheSymbolTable) {
+    const auto result = analyze(
+        "const int width = 6\n"
+        "const int area = width * 7\n"
+        "int cells = area % 5\n");
+    EXPECT_EQ(result.errors, 0u);
+    const auto& area = initializerOf(result, 1);
+    ASSERT_TRUE(area);
+    EXPECT_EQ(area->asInteger(), 42);
+    const auto& cells = initializerOf(result, 2);
+    ASSERT_TRUE(cells);
+    EXPECT_EQ(cells->asInteger(), 2);
+}
+
+TEST(ConstantEvaluator, MutableVariablesAreNotPropagated) {
+    const auto result = analyze(
+        "int width = 6\n"
+        "int area = width * 7\n");
+    EXPECT_EQ(result.errors, 0u);
+    EXPECT_TRUE(initializerOf(result, 0));
+    EXPECT_FALSE(initializerOf(result, 1));
+}
+
+TEST(ConstantEvaluator, AnalyzerWarnsWhenAStoreWraps) {
+    const auto result = analyze("byte b = 100 + 100\n");
+    EXPECT_EQ(result.errors, 0u);
+    EXPECT_EQ(result.warnings, 1u);
+    const auto& value = initializerOf(result, 0);
+    ASSERT_TRUE(value);
+    EXPECT_EQ(value->kind, Kind::BYTE);
+    EXPECT_EQ(value->asInteger(), -56);
+}
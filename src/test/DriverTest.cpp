@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <driver/Driver.hpp>
+#include <exceptions/ErrorReporter.hpp>
+#include <test/TempDir.hpp>
+#include <utils/ThreadPool.hpp>
+
+using namespace zenith;
+namespace fs = std::filesystem;
+
+static Flags parseArgs(const std::vector<std::string>& args) {
+    std::vector<std::string> commandLine{"zenith"};
+    commandLine.insert(commandLine.end(), args.begin(), args.end());
+    return ArgumentParser::parse(commandLine);
+}
+
+// ===========================================================================
+// 1. Arguments
+// ===========================================================================
+
+TEST(Driver, AcceptsSeveralInputFiles) {
+    const Flags flags = parseArgs({"a.zn", "--jobs=2", "b.zn"});
+    EXPECT_EQ(flags.inputFiles, (std::vector<std::string>{"a.zn", "b.zn"}));
+    EXPECT_EQ(flags.inputFile, "a.zn");
+    EXPECT_EQ(flags.jobs, 2u);
+    EXPECT_FALSE(flags.dumpLogs);
+    EXPECT_THROW(parseArgs({"--jobs=2"}), std::runtime_error);
+}
+
+TEST(Driver, ExpandsResponseFiles) {
+    TempDir dir("response");
+    const std::string inner = dir.write("inner.rsp", "c.zn\n");
+    const std::string outer = dir.write("outer.rsp", "a.zn \"dir with space/b.zn\"\n  --dump-logs @" + inner + "\n");
+    const Flags flags = parseArgs({"@" + outer, "d.zn"});
+    EXPECT_EQ(flags.inputFiles, (std::vector<std::string>{"a.zn", "dir with space/b.zn", "c.zn", "d.zn"}));
+    EXPECT_TRUE(flags.dumpLogs);
+
+    const std::string loop = dir.write("loop.rsp", "@" + (dir.path / "loop.rsp").string());
+    EXPECT_THROW(parseArgs({"@" + loop}), std::runtime_error);
+    EXPECT_THROW(parseArgs({"@" + (dir.path / "missing.rsp").string()}), std::runtime_error);
+}
+
+TEST(Driver, ExpandsDirectoriesToSortedSources) {
+    TempDir dir("expand");
+    const std::string b = dir.write("src/b.zn", "");
+    const std::string a = dir.write("src/nested/a.zn", "");
+    dir.write("src/notes.txt", "");
+    const auto files = Driver::expandInputs({"first.zn", (dir.path / "src").string()});
+    EXPECT_EQ(files, (std::vector<std::string>{"first.zn", b, a}));
+}
+
+// ===========================================================================
+// 2. Ordered output
+// ===========================================================================
+
+TEST(Driver, SinkWritesInTaskOrder) {
+    std::ostringstream out, err;
+    OrderedSink sink(out, err);
+    sink.finish(2, "c", "");
+    sink.finish(1, "b", "1");
+    EXPECT_EQ(out.str(), "");
+    sink.finish(0, "a", "0");
+    EXPECT_EQ(out.str(), "abc");
+    EXPECT_EQ(err.str(), "01");
+
+    std::ostringstream manyOut, manyErr;
+    OrderedSink many(manyOut, manyErr);
+    ThreadPool pool(4);
+    std::string expected;
+    for (size_t i = 0; i < 500; ++i) expected += std::to_string(i) + ",";
+    pool.parallelFor(500, [&](const size_t i) { many.finish(i, std::to_string(i) + ",", ""); });
+    EXPECT_EQ(manyOut.str(), expected);
+}
+
+// ===========================================================================
+// 3. Compiling
+// ===========================================================================
+
+TEST(Driver, ReportsEveryFileInInputOrder) {
+    TempDir dir("compile");
+    const std::string good = dir.write("good.zn", "fun int main() {\n    return 0\n}\n");
+    const std::string bad = dir.write("bad.zn", "fun int f( {\n");
+    Flags flags = parseArgs({good, bad, (dir.path / "missing.zn").string(), good, "--jobs=3"});
+    std::ostringstream out, err;
+    EXPECT_EQ(Driver(flags).run(out, err), Driver::FAILED);
+    const std::string text = out.str();
+    EXPECT_LT(text.find("Compiling " + good), text.find("Compiling " + bad));
+    EXPECT_NE(err.str().find(bad + ":"), std::string::npos) << "the end of input error names its file";
+    EXPECT_NE(err.str().find("2 of 4 files failed"), std::string::npos);
+    EXPECT_FALSE(fs::exists(dir.path / "good.zn.lexerout.log"));
+
+    flags.inputFiles = {good};
+    std::ostringstream goodOut, goodErr;
+    EXPECT_EQ(Driver(flags).run(goodOut, goodErr), Driver::SUCCESS);
+    EXPECT_EQ(goodOut.str().find("Compiling"), std::string::npos);
+}
+
+TEST(Driver, LazyBodiesReportLikeEagerOnes) {
+    TempDir dir("lazy");
+    const std::string file = dir.write("a.zn",
+        "fun int twice(int x) {\n    return x * 2\n}\n"
+        "fun int main() {\n    int y = twice(2)\n    return y * nope\n}\n");
+    auto diagnostics = [&](const std::vector<std::string>& extra) {
+        std::vector<std::string> args{file};
+        args.insert(args.end(), extra.begin(), extra.end());
+        std::ostringstream out, err;
+        EXPECT_EQ(Driver(parseArgs(args)).run(out, err), Driver::FAILED);
+        return err.str();
+    };
+    const std::string eager = diagnostics({});
+    EXPECT_NE(eager.find("nope"), std::string::npos);
+    EXPECT_EQ(diagnostics({"--lazy-parse"}), eager);
+    EXPECT_EQ(diagnostics({"--lazy-parse", "--pipeline"}), eager);
+}
+
+TEST(Driver, SyntaxErrorIsReportedWithoutAnalysis) {
+    TempDir dir("syntax");
+    const std::string file = dir.write("a.zn",
+        "fun int twice(int x) {\n    int y = )\n    return x * 2\n}\n"
+        "fun int main() {\n    return twice(2)\n}\n");
+    for (const std::vector<std::string>& extra: {std::vector<std::string>{}, {"--pipeline"}}) {
+        std::vector<std::string> args{file};
+        args.insert(args.end(), extra.begin(), extra.end());
+        std::ostringstream out, err;
+        EXPECT_EQ(Driver(parseArgs(args)).run(out, err), Driver::FAILED);
+        EXPECT_NE(err.str().find("Error at 3:14 - Expected"), std::string::npos) << err.str();
+        EXPECT_EQ(err.str().find("internal error"), std::string::npos) << err.str();
+    }
+}
+
+TEST(Driver, DiagnosticsAreShownWhenALaterPhaseThrows) {
+    TempDir dir("throws");
+    const std::string file = dir.write("a.zn", "fun int first() {\n    return 1\n}\n");
+    Driver driver(parseArgs({file, "--jobs=1"}));
+    // Analysis reports a problem and then fails, the way a bug in it would
+    driver.onPhase([&](const MemoryAccounting::Phase phase, ErrorReporter& reporter) {
+        if (phase != MemoryAccounting::Phase::ANALYZE) return;
+        reporter.error(SourceLocation{2, 5, 6, 0, file}, "reported before failing");
+        throw std::runtime_error("analysis failed");
+    });
+    std::ostringstream out, err;
+    EXPECT_EQ(driver.run(out, err), Driver::FAILED);
+    const size_t reported = err.str().find("reported before failing");
+    const size_t internal = err.str().find("internal error: analysis failed");
+    ASSERT_NE(reported, std::string::npos) << err.str();
+    ASSERT_NE(internal, std::string::npos) << err.str();
+    EXPECT_LT(reported, internal) << err.str();
+}
+
+// The whole of stderr, one JSON report and nothing else
+static void expectJsonReport(const std::string& err) {
+    ASSERT_TRUE(err.starts_with("{\"diagnostics\":[")) << err;
+    EXPECT_TRUE(err.ends_with("}\n")) << err;
+    EXPECT_EQ(std::ranges::count(err, '\n'), 1) << err;
+}
+
+TEST(Driver, LexerErrorsGoThroughTheDiagnostics) {
+    TempDir dir("lexer");
+    const std::string file = dir.write("a.zn", "fun int f() {\n    return \"open\n}\n");
+    for (const std::vector<std::string>& extra: {std::vector<std::string>{}, {"--pipeline"}}) {
+        std::vector<std::string> args{file, "--diagnostics-format=json"};
+        args.insert(args.end(), extra.begin(), extra.end());
+        std::ostringstream out, err;
+        EXPECT_EQ(Driver(parseArgs(args)).run(out, err), Driver::FAILED);
+        expectJsonReport(err.str());
+        EXPECT_NE(err.str().find("\"severity\":\"error\",\"file\":\"" + file + "\""), std::string::npos) << err.str();
+        EXPECT_NE(err.str().find("\"message\":\"Unterminated string literal\""), std::string::npos) << err.str();
+        EXPECT_EQ(out.str().find("error"), std::string::npos) << out.str();
+    }
+}
+
+TEST(Driver, ExceptionsWhileLexingOrParsingGoThroughTheDiagnostics) {
+    TempDir dir("parser");
+    const std::string file = dir.write("a.zn", "fun int f() {\n    return 1\n}\n");
+    for (const auto [phase, prefix]: {std::pair{MemoryAccounting::Phase::LEX, "Lexer error: "},
+                                      std::pair{MemoryAccounting::Phase::PARSE, "Parser error: "}}) {
+        Driver driver(parseArgs({file, "--diagnostics-format=json"}));
+        driver.onPhase([phase](const MemoryAccounting::Phase entered, ErrorReporter&) {
+            if (entered == phase) throw std::runtime_error("out of tokens");
+        });
+        std::ostringstream out, err;
+        EXPECT_EQ(driver.run(out, err), Driver::FAILED);
+        expectJsonReport(err.str());
+        EXPECT_NE(err.str().find("\"severity\":\"internal error\",\"file\":\"" + file + "\",\"line\":1"),
+                  std::string::npos) << err.str();
+        EXPECT_NE(err.str().find(std::string("\"message\":\"") + prefix + "out of tokens\""), std::string::npos)
+            << err.str();
+        EXPECT_EQ(out.str().find("error"), std::string::npos) << out.str();
+    }
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <functional>
+#include <string>
+#include <SemanticAnalysis/EscapeAnalysis.hpp>
+#include <test/ParsedProgram.hpp>
+
+using namespace zenith;
+
+// The allocations stay valid as long as the program they point into
+struct Analyzed {
+    ParsedProgram parsed;
+    EscapeAnalysis analysis;
+
+    // 'edit' changes the program before the analysis sees it
+    explicit Analyzed(const std::string& src, const std::function<void(ProgramNode&)>& edit = nullptr) : parsed(src) {
+        if (edit) edit(*parsed.program);
+        analysis.analyze(*parsed.program);
+    }
+};
+
+// The single allocation on 'line'
+static const EscapeInfo& at(const Analyzed& result, const size_t line) {
+    const EscapeInfo* found = nullptr;
+    for (const auto& allocation: result.analysis.results()) {
+        if (allocation.loc.line != line) continue;
+        EXPECT_EQ(found, nullptr) << "more than one allocation on line " << line;
+        found = allocation.info;
+    }
+    if (!found) ADD_FAILURE() << "no allocation on line " << line;
+    static const EscapeInfo missing;
+    return found ? *found : missing;
+}
+
+static bool escapes(const EscapeInfo& info, const EscapeInfo::Cause cause) {
+    return info.verdict == EscapeInfo::Verdict::HEAP && (info.causes & cause);
+}
+
+// ===========================================================================
+// 1. Escaping
+// ===========================================================================
+
+TEST(EscapeAnalysis, ReturnedObjectEscapes) {
+    const Analyzed result(
+        "fun make() {\n"
+        "    var o = { x: 1 }\n"
+        "    return o\n"
+        "}\n");
+    EXPECT_TRUE(escapes(at(result, 2), EscapeInfo::RETURN));
+}
+
+TEST(EscapeAnalysis, ObjectStoredIntoAParameterFieldEscapes) {
+    const Analyzed result(
+        "fun attach(freeobj node) {\n"
+        "    node.next = { x: 1 }\n"
+        "    return 0\n"
+        "}\n");
+    EXPECT_TRUE(escapes(at(result, 2), EscapeInfo::STORE));
+}
+
+TEST(EscapeAnalysis, ObjectStoredIntoAGlobalEscapes) {
+    const Analyzed result(
+        "var last = { x: 0 }\n"
+        "fun remember() {\n"
+        "    last = { x: 1 }\n"
+        "    return 0\n"
+        "}\n");
+    EXPECT_TRUE(escapes(at(result, 1), EscapeInfo::STORE));
+    EXPECT_TRUE(escapes(at(result, 3), EscapeInfo::STORE));
+}
+
+TEST(EscapeAnalysis, ObjectCapturedByALambdaEscapes) {
+    const Analyzed result(
+        "fun counter() {\n"
+        "    var state = { count: 0 }\n"
+        "    var next = () => state.count\n"
+        "    return 0\n"
+        "}\n");
+    EXPECT_TRUE(escapes(at(result, 2), EscapeInfo::CAPTURE));
+}
+
+TEST(EscapeAnalysis, ObjectPassedToAnUnknownCallEscapes) {
+    const Analyzed result(
+        "fun show() {\n"
+        "    var o = { x: 1 }\n"
+        "    print(o)\n"
+        "    return 0\n"
+        "}\n");
+    EXPECT_TRUE(escapes(at(result, 2), EscapeInfo::CALL));
+}
+
+TEST(EscapeAnalysis, ObjectReturnedThroughACalleeEscapes) {
+    const Analyzed result(
+        "fun same(freeobj p) {\n"
+        "    return p\n"
+        "}\n"
+        "fun make() {\n"
+        "    return same({ x: 1 })\n"
+        "}\n");
+    EXPECT_TRUE(escapes(at(result, 5), EscapeInfo::RETURN));
+}
+
+TEST(EscapeAnalysis, ObjectKeptAcrossLoopIterationsEscapes) {
+    const Analyzed result(
+        "fun last() {\n"
+        "    var kept = { x: 0 }\n"
+        "    while (true) {\n"
+        "        kept = { x: 1 }\n"
+        "    }\n"
+        "    return kept.x + 0\n"
+        "}\n");
+    EXPECT_TRUE(escapes(at(result, 4), EscapeInfo::LOOP));
+}
+
+TEST(EscapeAnalysis, ObjectPassedToAConstructorWithADefaultParameterEscapes) {
+    // The parser does not read default values yet, give 'n' one so the call's arity differs from the constructor's
+    const Analyzed result(
+        "var last = { x: 0 }\n"
+        "class Keeper {\n"
+        "    Keeper(freeobj o, int n) {\n"
+        "        last = o\n"
+        "    }\n"
+        "}\n"
+        "fun keep() {\n"
+        "    var o = { x: 1 }\n"
+        "    var k = new Keeper(o)\n"
+        "    return 0\n"
+        "}\n", [](ProgramNode& program) {
+        polymorphic_ref<ASTNode> decl = program.declarations[1];
+        auto object = decl.cast().non_throwing().to<ObjectDeclNode>();
+        ASSERT_TRUE(object);
+        polymorphic_ref<DeclNode> member = object->members[0];
+        auto ctor = member.cast().non_throwing().to<CtorDeclNode>();
+        ASSERT_TRUE(ctor);
+        ASSERT_EQ(ctor->params.size(), 2u);
+        ctor->params[1].defaultValue = make_node<LiteralNode>(SourceLocation{}, LiteralNode::NUMBER, "0");
+    });
+    EXPECT_TRUE(escapes(at(result, 8), EscapeInfo::CALL));
+}
+
+// ===========================================================================
+// 2. Not escaping
+// ===========================================================================
+
+TEST(EscapeAnalysis, ObjectOnlyReadThroughItsFieldsIsScalarReplaced) {
+    const Analyzed result(
+        "fun sum() {\n"
+        "    var p = { x: 1, y: 2 }\n"
+        "    return p.x + p.y\n"
+        "}\n");
+    const EscapeInfo& info = at(result, 2);
+    EXPECT_EQ(info.verdict, EscapeInfo::Verdict::SCALAR_REPLACED);
+    EXPECT_EQ(info.causes, EscapeInfo::NONE);
+}
+
+TEST(EscapeAnalysis, ObjectUsedWholeButKeptLocalGoesOnTheStack) {
+    const Analyzed result(
+        "fun same() {\n"
+        "    var a = { x: 1 }\n"
+        "    var b = a\n"
+        "    return a == b\n"
+        "}\n");
+    const EscapeInfo& info = at(result, 2);
+    EXPECT_EQ(info.verdict, EscapeInfo::Verdict::STACK);
+    EXPECT_EQ(info.causes, EscapeInfo::NONE);
+}
+
+TEST(EscapeAnalysis, ObjectPassedToACalleeThatKeepsItLocalDoesNotEscape) {
+    const Analyzed result(
+        "fun length(freeobj p) {\n"
+        "    return p.x * p.x + p.y * p.y\n"
+        "}\n"
+        "fun measure() {\n"
+        "    var p = { x: 3, y: 4 }\n"
+        "    return length(p)\n"
+        "}\n");
+    const EscapeInfo& info = at(result, 5);
+    EXPECT_EQ(info.verdict, EscapeInfo::Verdict::STACK);
+    EXPECT_EQ(info.causes, EscapeInfo::NONE);
+}
+
+TEST(EscapeAnalysis, ObjectStoredIntoALocalObjectStaysWithIt) {
+    const Analyzed result(
+        "fun nested() {\n"
+        "    var outer = { inner: nil }\n"
+        "    outer.inner = { x: 1 }\n"
+        "    return outer.inner.x + 0\n"
+        "}\n");
+    EXPECT_EQ(at(result, 2).verdict, EscapeInfo::Verdict::SCALAR_REPLACED);
+    EXPECT_EQ(at(result, 3).causes, EscapeInfo::NONE);
+}
+
+TEST(EscapeAnalysis, ReportCountsHeapAllocations) {
+    const Analyzed result(
+        "fun make() {\n"
+        "    var kept = { x: 1 }\n"
+        "    var local = { x: 2 }\n"
+        "    return kept\n"
+        "}\n");
+    std::ostringstream out;
+    result.analysis.report(out);
+    EXPECT_NE(out.str().find("2 allocation(s), 1 on the heap"), std::string::npos) << out.str();
+    EXPECT_NE(out.str().find("free object in 'make': heap (return)"), std::string::npos) << out.str();
+}
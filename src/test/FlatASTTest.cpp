@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <ranges>
+#include <vector>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <ast/FlatAST.hpp>
+#include <visitor/ASTWalker.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+
+using namespace zenith;
+using Kind = FlatAST::Kind;
+
+static polymorphic<ProgramNode> parse(const std::string& src, Flags flags = {}) {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    Parser parser(Lexer(src, "<test>").tokenize(), flags, reporter, discard);
+    auto program = parser.parse();
+    EXPECT_EQ(diagnostics.errorCount(), 0u) << src;
+    return program;
+}
+
+// Locations of every node, in the order the walker enters them
+class Locations : public ASTWalker {
+protected:
+    void enter(ASTNode& node) override { offsets.push_back(node.loc.fileOffset); }
+
+public:
+    std::vector<size_t> offsets;
+};
+
+static std::vector<size_t> walkOrder(polymorphic<ProgramNode>& program) {
+    Locations locations;
+    program->accept(locations);
+    return locations.offsets;
+}
+
+static std::vector<size_t> flatOrder(const FlatAST& flat) {
+    std::vector<size_t> offsets;
+    for (const auto& node: flat.all()) {
+        if (node.kind != Kind::NONE) offsets.push_back(node.offset);
+    }
+    return offsets;
+}
+
+static FlatAST::Index find(const FlatAST& flat, const Kind kind, const std::string_view name = {}) {
+    for (FlatAST::Index i = 0; i < flat.size(); ++i) {
+        if (flat[i].kind == kind && (name.empty() || flat.name(i) == name)) return i;
+    }
+    ADD_FAILURE() << "no node of kind " << static_cast<int>(kind) << " named " << name;
+    return 0;
+}
+
+static std::vector<std::string_view> names(const FlatAST& flat, const FlatAST::Index index, const int list = 0) {
+    std::vector<std::string_view> result;
+    for (const uint32_t id: flat.names(index, list)) result.push_back(flat.string(id));
+    return result;
+}
+
+static std::vector<Kind> childKinds(const FlatAST& flat, const FlatAST::Index index) {
+    std::vector<Kind> kinds;
+    for (const FlatAST::Index child: flat.children(index)) kinds.push_back(flat[child].kind);
+    return kinds;
+}
+
+static const std::string SAMPLE =
+    "fun int add(int a, int b) {\n"
+    "    int q = a + b * 2\n"
+    "    if (q > 10) {\n"
+    "        q = q - 1\n"
+    "    } else {\n"
+    "        q = g(h(q, a), b)\n"
+    "    }\n"
+    "    do {\n"
+    "        q = q - 1\n"
+    "    } while (q > 0)\n"
+    "    return q\n"
+    "}\n"
+    "class Point {\n"
+    "    public int x;\n"
+    "    Point(int x) : x(x) {\n"
+    "        this.x = x\n"
+    "    }\n"
+    "}\n"
+    "template<typename T, int N = 3> class Box {\n"
+    "    public T value;\n"
+    "}\n"
+    "var f = (a, b) => a * b\n"
+    "freeobj o = freeobj {a: 1, b: \"s\"}\n"
+    "fun main() {\n"
+    "    for (int i = 0; i < 3; i = i + 1) {\n"
+    "        x = x.y[i]\n"
+    "    }\n"
+    "}\n";
+
+// ===========================================================================
+// 1. Layout
+// ===========================================================================
+
+TEST(FlatAST, NodesAreInWalkOrder) {
+    auto program = parse(SAMPLE);
+    const FlatAST flat = FlatAST::freeze(*program);
+    EXPECT_EQ(flatOrder(flat), walkOrder(program));
+    EXPECT_EQ(flat[0].kind, Kind::PROGRAM);
+}
+
+TEST(FlatAST, SubtreesNestInsideTheirParents) {
+    auto program = parse(SAMPLE);
+    const FlatAST flat = FlatAST::freeze(*program);
+    EXPECT_EQ(flat[0].end, flat.size());
+    EXPECT_EQ(flat[0].parent, 0u);
+    for (FlatAST::Index i = 1; i < flat.size(); ++i) {
+        const auto& node = flat[i];
+        ASSERT_LT(node.parent, i);
+        EXPECT_GT(node.end, i);
+        EXPECT_LE(node.end, flat[node.parent].end);
+        for (const FlatAST::Index child: flat.children(i)) EXPECT_EQ(flat[child].parent, i);
+    }
+}
+
+TEST(FlatAST, AbsentChildrenKeepTheirPlace) {
+    auto program = parse(SAMPLE);
+    const FlatAST flat = FlatAST::freeze(*program);
+
+    // Two parameters without defaults, no return type in main, the body
+    const auto add = find(flat, Kind::FUNCTION, "add");
+    EXPECT_EQ(childKinds(flat, add), (std::vector{
+        Kind::PRIMITIVE_TYPE, Kind::NONE, Kind::PRIMITIVE_TYPE, Kind::NONE, Kind::PRIMITIVE_TYPE, Kind::BLOCK
+    }));
+    EXPECT_EQ(childKinds(flat, find(flat, Kind::FUNCTION, "main")), (std::vector{Kind::NONE, Kind::BLOCK}));
+    EXPECT_EQ(childKinds(flat, find(flat, Kind::IF)), (std::vector{Kind::BINARY, Kind::BLOCK, Kind::BLOCK}));
+    EXPECT_EQ(childKinds(flat, find(flat, Kind::DO_WHILE)), (std::vector{Kind::BLOCK, Kind::BINARY}));
+    EXPECT_EQ(flat[flat.child(find(flat, Kind::VAR_DECL, "f"), 0)].kind, Kind::NONE);
+    EXPECT_THROW((void) flat.child(add, 6), std::out_of_range);
+}
+
+// ===========================================================================
+// 2. Payloads
+// ===========================================================================
+
+TEST(FlatAST, NamesAndListsByKind) {
+    auto program = parse(SAMPLE);
+    const FlatAST flat = FlatAST::freeze(*program);
+
+    EXPECT_EQ(names(flat, find(flat, Kind::FUNCTION, "add")), (std::vector<std::string_view>{"a", "b"}));
+    EXPECT_EQ(names(flat, find(flat, Kind::LAMBDA)), (std::vector<std::string_view>{"a", "b"}));
+    EXPECT_EQ(names(flat, find(flat, Kind::FREE_OBJECT)), (std::vector<std::string_view>{"a", "b"}));
+
+    const auto constructor = find(flat, Kind::CONSTRUCTOR);
+    EXPECT_EQ(names(flat, constructor), (std::vector<std::string_view>{"x"}));
+    EXPECT_EQ(names(flat, constructor, 1), (std::vector<std::string_view>{"x"}));
+    EXPECT_EQ(flat[flat.child(constructor, 4)].kind, Kind::VAR); // After the parameter, return type and body
+
+    const auto parameter = find(flat, Kind::TEMPLATE_PARAMETER, "N");
+    EXPECT_EQ(flat[parameter].op, static_cast<uint8_t>(TemplateParameter::Kind::NON_TYPE));
+    EXPECT_EQ(flat.name(flat.child(parameter, 2)), "3");
+
+    const auto product = flat.child(find(flat, Kind::BINARY), 1);
+    EXPECT_EQ(flat[product].op, BinaryOpNode::MUL);
+    EXPECT_EQ(flat[flat.child(find(flat, Kind::MEMBER_ACCESS, "y"), 0)].kind, Kind::VAR);
+    const auto text = flat.child(find(flat, Kind::FREE_OBJECT), 1);
+    EXPECT_EQ(flat[text].op, LiteralNode::STRING);
+    EXPECT_NE(flat.name(text).find('s'), std::string_view::npos);
+}
+
+TEST(FlatAST, LocationsAndConstants) {
+    auto program = parse("var a = 1 + 2\n");
+    auto declaration = program->declarations.front().cast().non_throwing().to<VarDeclNode>();
+    ASSERT_TRUE(declaration);
+    declaration->initializer->constantValue = ConstantValue{ConstantValue::Kind::INT, int64_t{3}};
+
+    const FlatAST flat = FlatAST::freeze(*program);
+    const auto sum = find(flat, Kind::BINARY);
+    ASSERT_TRUE(flat.constant(sum));
+    EXPECT_EQ(std::get<int64_t>(flat.constant(sum)->value), 3);
+    EXPECT_EQ(flat.constant(flat.child(sum, 0)), nullptr);
+
+    const SourceLocation loc = flat.location(sum);
+    EXPECT_EQ(loc.line, declaration->initializer->loc.line);
+    EXPECT_EQ(loc.column, declaration->initializer->loc.column);
+    EXPECT_EQ(loc.fileOffset, declaration->initializer->loc.fileOffset);
+    EXPECT_EQ(loc.file, "<test>");
+}
+
+TEST(FlatAST, FreezesLazyBodies) {
+    Flags lazy;
+    lazy.lazyParsing = true;
+    auto lazyProgram = parse(SAMPLE, lazy);
+    auto eager = parse(SAMPLE);
+    EXPECT_EQ(flatOrder(FlatAST::freeze(*lazyProgram)), flatOrder(FlatAST::freeze(*eager)));
+}
@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <visitor/ASTWalker.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <exceptions/LexError.hpp>
+
+using namespace zenith;
+
+// Every node's location in source order, what a reused subtree gets wrong first
+class LocationCollector : public ASTWalker {
+protected:
+    void enter(ASTNode& node) override {
+        std::ostringstream out;
+        out << typeid(node).name() << ' ' << node.loc.line << ':' << node.loc.column << '@' << node.loc.fileOffset;
+        locations.push_back(out.str());
+    }
+
+public:
+    std::vector<std::string> locations;
+    void collect(polymorphic<ProgramNode>& program) { walk(program); }
+};
+
+struct Snapshot {
+    bool fatal = false;
+    std::string ast;
+    std::vector<std::string> locations;
+    size_t errors = 0;
+};
+
+static Snapshot snapshot(polymorphic<ProgramNode>& program, const DiagnosticsEngine& diagnostics) {
+    LocationCollector collector;
+    collector.collect(program);
+    std::string ast;
+    try {
+        ast = program->toString();
+    }
+    catch (const std::exception& e) {
+        ast = e.what(); // Some nodes can't print what recovery left of them, e.g. a for loop without a condition
+    }
+    return {false, std::move(ast), std::move(collector.locations), diagnostics.errorCount()};
+}
+
+static Snapshot fullParse(const std::string& src) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    Parser parser(Lexer(src, "<test>").tokenize(), flags, reporter, discard);
+    try {
+        auto program = parser.parse();
+        return snapshot(program, diagnostics);
+    }
+    catch (const ParseError&) {
+        return {true, "", {}};
+    }
+}
+
+static const std::string SAMPLE =
+    "@Async fun int add(int a, int b) {\n"
+    "    int q = a + b * 2\n"
+    "    if (q > 10) {\n"
+    "        q = q - 1\n"
+    "    } else {\n"
+    "        q = g(h(q, a), b)\n"
+    "    }\n"
+    "    return q\n"
+    "}\n"
+    "class Point {\n"
+    "    public int x;\n"
+    "    public int y = 3;\n"
+    "    public fun int sum() {\n"
+    "        return this.x + this.y\n"
+    "    }\n"
+    "}\n"
+    "var f = (a, b) => a * b\n"
+    "Point p = {x: 1, y: 2}\n"
+    "freeobj o = freeobj {a: 1, b: \"s\"}\n"
+    "actor Counter {\n"
+    "    on Increment(int by) {\n"
+    "        count = count + by\n"
+    "    }\n"
+    "}\n"
+    "fun main() {\n"
+    "    var x = add(1, 2)\n"
+    "    while (x < 10) {\n"
+    "        x = x + 1\n"
+    "    }\n"
+    "    for (int i = 0; i < 3; i = i + 1) {\n"
+    "        x = x.y[i]\n"
+    "    }\n"
+    "    var l = (x) => x\n"
+    "}\n"
+    "int done = 1\n";
+
+// ===========================================================================
+// 1. What gets reused
+// ===========================================================================
+
+TEST(IncrementalParse, EditInsideOneFunctionReusesTheRest) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    auto parse = Parser::parseForEditing(Lexer(SAMPLE, "<test>").tokenize(), flags, reporter, discard);
+    ASSERT_EQ(diagnostics.errorCount(), 0u);
+    const size_t declarations = parse.program->declarations.size();
+
+    // "x = x + 1" becomes "x = x + 12" in main
+    std::string edited = SAMPLE;
+    const size_t offset = SAMPLE.find("x + 1\n") + 5;
+    edited.insert(offset, "2");
+    auto updated = Parser::reparse(std::move(parse), {offset, 0, 1}, Lexer(edited, "<test>").tokenize(), flags,
+                                   reporter, discard);
+
+    EXPECT_EQ(updated.reusedDeclarations, declarations - 2); // Not main, nor the last one that saw the end
+    EXPECT_EQ(updated.reusedStatements, 3u); // The statements of main around the while loop
+    auto expected = fullParse(edited);
+    auto actual = snapshot(updated.program, diagnostics);
+    EXPECT_EQ(actual.ast, expected.ast);
+    EXPECT_EQ(actual.locations, expected.locations);
+}
+
+TEST(IncrementalParse, DeclarationsAfterANewLineMoveDown) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    auto parse = Parser::parseForEditing(Lexer(SAMPLE, "<test>").tokenize(), flags, reporter, discard);
+
+    std::string edited = "\n" + SAMPLE;
+    auto updated = Parser::reparse(std::move(parse), {0, 0, 1}, Lexer(edited, "<test>").tokenize(), flags,
+                                   reporter, discard);
+    // All but the last one, which saw the end of the input
+    EXPECT_EQ(updated.reusedDeclarations, updated.program->declarations.size() - 1);
+    EXPECT_EQ(snapshot(updated.program, diagnostics).locations, fullParse(edited).locations);
+}
+
+TEST(IncrementalParse, SyntaxErrorsAreReportedAgain) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    const std::string src = "class A {\n    public int x = )\n}\nfun f() {\n    return 1\n}\n";
+    auto parse = Parser::parseForEditing(Lexer(src, "<test>").tokenize(), flags, reporter, discard);
+    const size_t errors = diagnostics.errorCount();
+    ASSERT_GT(errors, 0u);
+
+    std::string edited = src;
+    const size_t offset = src.find('1');
+    edited[offset] = '2';
+    auto updated = Parser::reparse(std::move(parse), {offset, 1, 1}, Lexer(edited, "<test>").tokenize(), flags,
+                                   reporter, discard);
+    EXPECT_EQ(diagnostics.errorCount(), 2 * errors); // The broken class is parsed, and reported, again
+    EXPECT_EQ(updated.program->toString(), fullParse(edited).ast);
+}
+
+// ===========================================================================
+// 2. Differential: random single-character edits against a full reparse
+// ===========================================================================
+
+TEST(IncrementalParse, MatchesFullParseUnderRandomEdits) {
+    static const std::string alphabet = "{}()[];,=+<>@.\n x1\"";
+    Flags flags;
+    std::ostream discard(nullptr);
+    size_t reused = 0, checked = 0;
+
+    for (unsigned seed = 0; seed < 60; ++seed) {
+        std::mt19937 rng(seed);
+        std::string src = SAMPLE;
+        std::optional<IncrementalParse> parse;
+
+        for (int step = 0; step < 30; ++step) {
+            // Insert, delete or replace one character
+            std::string edited = src;
+            const size_t offset = rng() % (src.size() + 1);
+            const char c = alphabet[rng() % alphabet.size()];
+            TextEdit edit{offset, 0, 0};
+            switch (offset == src.size() ? 0 : rng() % 3) {
+                case 0: edited.insert(offset, 1, c); edit.inserted = 1; break;
+                case 1: edited.erase(offset, 1); edit.removed = 1; break;
+                default: edited[offset] = c; edit.removed = edit.inserted = 1; break;
+            }
+
+            std::vector<Token> tokens;
+            try {
+                tokens = Lexer(edited, "<test>").tokenize();
+            }
+            catch (const LexError&) {
+                continue; // Not something the parser gets to see
+            }
+            src = std::move(edited);
+
+            const Snapshot expected = fullParse(src);
+            DiagnosticsEngine diagnostics;
+            ErrorReporter reporter(diagnostics);
+            Snapshot actual{true, "", {}};
+            try {
+                // Odd seeds relex the previous tokens in place, the way an editor session would
+                if (parse && seed % 2) {
+                    const TokenEdit changed = Lexer::relex(parse->tokens, src, "<test>", edit);
+                    parse = Parser::reparse(std::move(*parse), changed, flags, reporter, discard);
+                }
+                else parse = parse ? Parser::reparse(std::move(*parse), edit, std::move(tokens), flags, reporter, discard)
+                                   : Parser::parseForEditing(std::move(tokens), flags, reporter, discard);
+                actual = snapshot(parse->program, diagnostics);
+                reused += parse->reusedDeclarations + parse->reusedStatements;
+            }
+            catch (const ParseError&) {
+                parse.reset();
+            }
+
+            ASSERT_EQ(actual.fatal, expected.fatal) << "seed " << seed << " step " << step << "\n" << src;
+            ASSERT_EQ(actual.ast, expected.ast) << "seed " << seed << " step " << step << "\n" << src;
+            ASSERT_EQ(actual.locations, expected.locations) << "seed " << seed << " step " << step << "\n" << src;
+            ASSERT_EQ(actual.errors, expected.errors) << "seed " << seed << " step " << step << "\n" << src;
+            ++checked;
+        }
+    }
+    EXPECT_GT(checked, 1000u);
+    EXPECT_GT(reused, checked); // Most edits keep most of the tree
+}
+
+// ===========================================================================
+// 3. Relexing: random edits against a full lex
+// ===========================================================================
+
+static std::string describe(const std::vector<Token>& tokens) {
+    std::ostringstream out;
+    for (const Token& token: tokens) {
+        out << Lexer::tokenToString(token.type) << " '" << token.lexeme << "' " << token.loc.line << ':'
+            << token.loc.column << '+' << token.loc.length << '@' << token.loc.fileOffset << '\n';
+    }
+    return out.str();
+}
+
+TEST(IncrementalParse, RelexMatchesFullLexUnderRandomEdits) {
+    static const std::string alphabet = "/*\"`${}\n .1ex";
+    const std::string start = SAMPLE + "// a comment\nvar s = `a b` + x\n/* block\n comment */ var t = \"q\\\"\"\n";
+    size_t checked = 0;
+
+    for (unsigned seed = 0; seed < 60; ++seed) {
+        std::mt19937 rng(seed);
+        std::string src = start;
+        std::vector<Token> tokens = Lexer(src, "<test>").tokenize();
+
+        for (int step = 0; step < 40; ++step) {
+            std::string edited = src;
+            const size_t offset = rng() % (src.size() + 1);
+            const size_t removed = offset == src.size() ? 0 : std::min<size_t>(rng() % 3, src.size() - offset);
+            const std::string inserted(rng() % 3, alphabet[rng() % alphabet.size()]);
+            edited.replace(offset, removed, inserted);
+
+            std::optional<std::vector<Token>> expected;
+            try {
+                expected = Lexer(edited, "<test>").tokenize();
+            }
+            catch (const LexError&) {}
+            std::vector<Token> actual = tokens;
+            std::optional<TokenEdit> changed;
+            try {
+                changed = Lexer::relex(actual, edited, "<test>", {offset, removed, inserted.size()});
+            }
+            catch (const LexError&) {
+                EXPECT_EQ(describe(actual), describe(tokens)) << "a failed relex leaves the tokens alone";
+            }
+
+            ASSERT_EQ(changed.has_value(), expected.has_value()) << "seed " << seed << " step " << step << "\n" << edited;
+            if (!expected) continue;
+            ASSERT_EQ(describe(actual), describe(*expected)) << "seed " << seed << " step " << step << "\n" << edited;
+
+            // Outside the tokens reported as changed, the old ones are still there
+            ASSERT_EQ(actual.size(), tokens.size() - changed->removed + changed->inserted);
+            for (size_t i = 0; i < changed->begin; ++i) {
+                ASSERT_EQ(describe({actual[i]}), describe({tokens[i]}));
+            }
+            for (size_t i = changed->begin + changed->removed; i < tokens.size(); ++i) {
+                Token old = tokens[i];
+                old.loc.line += changed->lines;
+                old.loc.fileOffset += changed->bytes;
+                ASSERT_EQ(describe({actual[i - changed->removed + changed->inserted]}), describe({old}));
+            }
+            src = std::move(edited);
+            tokens = std::move(actual);
+            ++checked;
+        }
+    }
+    EXPECT_GT(checked, 1000u);
+}
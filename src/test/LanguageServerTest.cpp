@@ -0,0 +1,410 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <lsp/Document.hpp>
+#include <lsp/Json.hpp>
+#include <lsp/LanguageServer.hpp>
+
+using namespace zenith;
+
+static const std::string PROGRAM =
+    "int limit = 10\n"
+    "fun int twice(int x) {\n"
+    "    return x * 2\n"
+    "}\n"
+    "class Point {\n"
+    "    public int x;\n"
+    "    public fun int scaled(int by) {\n"
+    "        return twice(by) + limit\n"
+    "    }\n"
+    "}\n"
+    "fun int main(Point p) {\n"
+    "    int total = twice(limit)\n"
+    "    total = total + p.x\n"
+    "    return total\n"
+    "}\n";
+
+static std::string describe(const std::vector<Document::Problem>& problems) {
+    std::ostringstream out;
+    for (const auto& p: problems) {
+        out << p.range.start.line << ':' << p.range.start.character << '-' << p.range.end.line << ':'
+            << p.range.end.character << ' ' << p.message << '\n';
+    }
+    return out.str();
+}
+
+static std::vector<Document::Problem> problems(Document& document) {
+    auto result = document.diagnostics();
+    EXPECT_TRUE(result);
+    return result ? result->second : std::vector<Document::Problem>{};
+}
+
+// Where text first occurs in PROGRAM-like source, plus characters
+static Document::Position at(const std::string& source, const std::string& text, const size_t plus = 0) {
+    const size_t offset = source.find(text) + plus;
+    const size_t lineStart = source.rfind('\n', offset - 1);
+    const size_t line = std::count(source.begin(), source.begin() + offset, '\n');
+    return {line, offset - (lineStart == std::string::npos || offset == 0 ? 0 : lineStart + 1)};
+}
+
+// ===========================================================================
+// 1. Json
+// ===========================================================================
+
+TEST(LanguageServer, JsonRoundTrips) {
+    const std::string text = R"({"a":[1,-2.5,true,null,"x\n\"y\""],"b":{"c":"é \ud83d\ude00"},"n":1e3})";
+    const Json json = Json::parse(text);
+    EXPECT_EQ(json["a"].asArray().size(), 5u);
+    EXPECT_EQ(json["a"].asArray()[1].asNumber(), -2.5);
+    EXPECT_EQ(json["a"].asArray()[4].asString(), "x\n\"y\"");
+    EXPECT_EQ(json["b"]["c"].asString(), "é \xF0\x9F\x98\x80");
+    EXPECT_EQ(json["n"].asInt(), 1000);
+    EXPECT_TRUE(json["missing"]["deeper"].isNull());
+    EXPECT_EQ(Json::parse(json.dump()), json);
+    EXPECT_EQ((Json{{"id", 3}}.dump()), R"({"id":3})");
+}
+
+TEST(LanguageServer, JsonRejectsMalformedText) {
+    for (const std::string& text: std::vector<std::string>{"", "{", "[1,]", "{\"a\" 1}", "tru", "\"\\x\"", "1 2", "[" + std::string(600, '[')}) {
+        EXPECT_THROW(Json::parse(text), std::runtime_error) << text;
+    }
+}
+
+// ===========================================================================
+// 2. Document
+// ===========================================================================
+
+TEST(LanguageServer, EditsGiveTheDiagnosticsOfAFreshDocument) {
+    Document document(PROGRAM, 1);
+    EXPECT_EQ(describe(problems(document)), "");
+
+    std::string text = PROGRAM;
+    const std::vector<std::pair<std::string, std::string>> edits{
+        {"return x * 2", "return x * missing"}, // An error in one body
+        {"int total = twice(limit)", "int total = twice(limit, 1)"},
+        {"return x * missing", "return x * 2"},  // Fixed again
+        {"int limit = 10", "string limit = \"10\""}, // A global every body sees
+        {"fun int main(", "fun int main("},
+    };
+    int64_t version = 1;
+    for (const auto& [from, to]: edits) {
+        const Document::Position start = at(text, from), end = at(text, from, from.size());
+        text.replace(text.find(from), from.size(), to);
+        document.change(Document::Range{start, end}, to, ++version);
+        Document fresh(text, version);
+        const auto actual = document.diagnostics();
+        ASSERT_TRUE(actual);
+        EXPECT_EQ(actual->first, version);
+        EXPECT_EQ(describe(actual->second), describe(problems(fresh))) << text;
+    }
+    EXPECT_EQ(document.content(), text);
+}
+
+TEST(LanguageServer, OnlyChangedBodiesAreCheckedAgain) {
+    Document document(PROGRAM, 1);
+    problems(document);
+    EXPECT_EQ(document.stats().bodiesChecked, 3u);
+
+    const std::string from = "return x * 2";
+    document.change(Document::Range{at(PROGRAM, from), at(PROGRAM, from, from.size())}, "return x * 3", 2);
+    EXPECT_EQ(describe(problems(document)), "");
+    EXPECT_EQ(document.stats().bodiesChecked, 1u); // twice alone
+    EXPECT_EQ(document.stats().bodiesReused, 2u);
+    EXPECT_GT(document.stats().reusedDeclarations, 0u);
+
+    // A new line above moves every body, their diagnostics come along
+    document.change(Document::Range{{0, 0}, {0, 0}}, "\n", 3);
+    problems(document);
+    EXPECT_EQ(document.stats().bodiesChecked, 0u);
+
+    // Changing what a global is checks the bodies that use it again, Point and main but not twice
+    document.change(Document::Range{{1, 0}, {1, 3}}, "long", 4);
+    problems(document);
+    EXPECT_EQ(document.stats().bodiesChecked, 2u);
+    EXPECT_EQ(document.stats().bodiesReused, 1u);
+}
+
+TEST(LanguageServer, ReusedBodiesEvaluateArraySizesAgain) {
+    const std::string text = "const int N = 3\nfun int f() {\n    int values[N]\n    return 0\n}\nfun int g() {\n    return 1\n}\n";
+    Document document(text, 1);
+    EXPECT_EQ(describe(problems(document)), "");
+    document.change(Document::Range{at(text, "3"), at(text, "3", 1)}, "0 - 1", 2);
+    const std::string after = describe(problems(document));
+    EXPECT_NE(after.find("Array size cannot be negative"), std::string::npos) << after;
+    EXPECT_GT(document.stats().reusedDeclarations, 0u);
+}
+
+TEST(LanguageServer, CachedDiagnosticsMoveWithTheirFunction) {
+    std::string text = PROGRAM;
+    text.replace(text.find("x * 2"), 5, "x * nope");
+    Document document(text, 1);
+    const auto before = problems(document);
+    ASSERT_EQ(before.size(), 2u) << describe(before); // The undeclared name, and the product it is in
+
+    document.change(Document::Range{{0, 0}, {0, 0}}, "// Notes\n\n", 2);
+    const auto after = problems(document);
+    EXPECT_EQ(document.stats().bodiesReused, 3u);
+    ASSERT_EQ(after.size(), 2u);
+    EXPECT_EQ(after[1].range.start.line, before[1].range.start.line + 2);
+    EXPECT_EQ(after[1].range.start.character, before[1].range.start.character);
+}
+
+TEST(LanguageServer, AnUnterminatedStringKeepsThePreviousParse) {
+    Document document(PROGRAM, 1);
+    problems(document);
+    const Document::Position end = at(PROGRAM, "return total", 12);
+    document.change(Document::Range{end, end}, " + \"", 2);
+    const auto open = problems(document);
+    ASSERT_EQ(open.size(), 1u);
+    EXPECT_NE(open[0].message.find("Unterminated"), std::string::npos) << open[0].message;
+
+    const Document::Position after = {end.line, end.character + 4};
+    document.change(Document::Range{after, after}, "\"", 3);
+    problems(document);
+    EXPECT_GT(document.stats().reusedDeclarations, 0u);
+    EXPECT_EQ(document.stats().bodiesReused, 2u);
+}
+
+TEST(LanguageServer, PositionsCountUtf16CodeUnits) {
+    const std::string text = "string s = \"\xF0\x9F\x98\x80\xC3\xA9\" + missing\n";
+    Document utf16(text, 1);
+    const auto problems16 = problems(utf16);
+    ASSERT_EQ(problems16.size(), 2u) << describe(problems16);
+    // The emoji is two code units, é one
+    EXPECT_EQ(problems16[1].range.start.character, text.find("missing") - 6 + 3);
+    Document utf8(text, 1, false);
+    EXPECT_EQ(problems(utf8)[1].range.start.character, text.find("missing"));
+
+    // An edit after the emoji lands where the client meant it
+    const Document::Position position = problems16[1].range.start;
+    utf16.change(Document::Range{position, {position.line, position.character + 7}}, "s", 2);
+    EXPECT_EQ(utf16.content(), "string s = \"\xF0\x9F\x98\x80\xC3\xA9\" + s\n");
+}
+
+TEST(LanguageServer, HoverAndDefinitionFollowTheAnalyzer) {
+    Document document(PROGRAM, 1);
+    problems(document);
+
+    const auto call = document.hover(at(PROGRAM, "twice(limit)", 2));
+    ASSERT_TRUE(call);
+    EXPECT_NE(call->markdown.find("function twice: "), std::string::npos) << call->markdown;
+    EXPECT_EQ(document.definition(at(PROGRAM, "twice(limit)")), (Document::Range{{1, 8}, {1, 13}}));
+
+    const auto local = document.hover(at(PROGRAM, "total + p.x"));
+    ASSERT_TRUE(local);
+    EXPECT_NE(local->markdown.find("variable total: int"), std::string::npos) << local->markdown;
+    EXPECT_EQ(document.definition(at(PROGRAM, "total + p.x")), (Document::Range{{11, 8}, {11, 13}}));
+
+    const auto field = document.hover(at(PROGRAM, "p.x", 2));
+    ASSERT_TRUE(field);
+    EXPECT_NE(field->markdown.find("variable x: int"), std::string::npos) << field->markdown;
+    EXPECT_EQ(document.definition(at(PROGRAM, "p.x", 2)), (Document::Range{{5, 15}, {5, 16}}));
+
+    // The global used from a method, and its own name
+    EXPECT_EQ(document.definition(at(PROGRAM, "+ limit", 2)), (Document::Range{{0, 4}, {0, 9}}));
+    EXPECT_TRUE(document.hover(at(PROGRAM, "limit = 10")));
+    EXPECT_FALSE(document.hover(at(PROGRAM, "return x")));
+}
+
+TEST(LanguageServer, DefinitionFollowsADeclarationThatWasParsedAgain) {
+    const std::string notes = "// Notes that are long enough to move twice past its uses\n// once they are gone\n";
+    const std::string text = notes + PROGRAM;
+    Document document(text, 1);
+    problems(document);
+    const std::string from = "return x * 2";
+    document.change(Document::Range{at(text, from), at(text, from, from.size())}, "return x * 3", 2);
+    problems(document);
+    document.change(Document::Range{{0, 0}, {2, 0}}, "", 3);
+    problems(document);
+    // twice is a new node since the first edit, the global scope kept from before it has the old one
+    EXPECT_EQ(document.definition(at(PROGRAM, "twice(limit)")), (Document::Range{{1, 8}, {1, 13}}));
+}
+
+TEST(LanguageServer, SymbolsNestMembersInTheirClass) {
+    Document document(PROGRAM, 1);
+    const auto symbols = document.symbols();
+    ASSERT_EQ(symbols.size(), 4u);
+    EXPECT_EQ(symbols[0].name, "limit");
+    EXPECT_EQ(symbols[1].name, "twice");
+    EXPECT_EQ(symbols[1].kind, 12);
+    EXPECT_EQ(symbols[1].range, (Document::Range{{1, 0}, {3, 1}}));
+    EXPECT_EQ(symbols[1].selection, (Document::Range{{1, 8}, {1, 13}}));
+    ASSERT_EQ(symbols[2].children.size(), 2u);
+    EXPECT_EQ(symbols[2].kind, 5);
+    EXPECT_EQ(symbols[2].children[0].name, "x");
+    EXPECT_EQ(symbols[2].children[0].kind, 8);
+    EXPECT_EQ(symbols[2].children[1].name, "scaled");
+    EXPECT_EQ(symbols[2].children[1].kind, 6);
+    EXPECT_EQ(symbols[2].children[1].range.end, (Document::Position{8, 5}));
+    EXPECT_EQ(symbols[3].name, "main");
+}
+
+TEST(LanguageServer, DiagnosticsStopWhenAsked) {
+    Document document(PROGRAM, 1);
+    std::stop_source stop;
+    stop.request_stop();
+    EXPECT_FALSE(document.diagnostics(stop.get_token()));
+    EXPECT_TRUE(document.diagnostics()) << "a stopped run leaves nothing half done";
+}
+
+TEST(LanguageServer, RequestsGetInWhileDiagnosticsRun) {
+    std::string text = PROGRAM;
+    for (size_t i = 0; i < 2000; ++i) {
+        text += "fun int f" + std::to_string(i) + "(int a) {\n    int b = twice(a) + limit\n    return b * 2\n}\n";
+    }
+    Document document(text, 1);
+    EXPECT_TRUE(document.hover(at(text, "twice(limit)", 2)));
+
+    std::atomic<bool> done = false;
+    std::optional<std::pair<int64_t, std::vector<Document::Problem>>> result;
+    std::thread running([&] {
+        result = document.diagnostics();
+        done = true;
+    });
+    // Every request waits for one query of the analysis at most, not for all of it
+    size_t answered = 0;
+    while (!done && answered < 100) {
+        EXPECT_TRUE(document.hover(at(text, "twice(limit)", 2)));
+        if (!done) ++answered;
+    }
+    running.join();
+    ASSERT_TRUE(result);
+    Document fresh(text, 1);
+    EXPECT_EQ(describe(result->second), describe(problems(fresh)));
+    EXPECT_GE(answered, 10u);
+}
+
+// ===========================================================================
+// 3. Server
+// ===========================================================================
+
+static std::string frame(const Json& message) {
+    std::ostringstream out;
+    LanguageServer::write(out, message.dump());
+    return out.str();
+}
+
+static Json request(const int id, const std::string& method, Json params) {
+    return Json{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", std::move(params)}};
+}
+
+static Json notification(const std::string& method, Json params) {
+    return Json{{"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}};
+}
+
+// Everything the server wrote for a session of messages, and its exit code
+static std::pair<std::vector<Json>, int> session(const std::string& input) {
+    std::istringstream in(input);
+    std::ostringstream out;
+    int status;
+    {
+        LanguageServer server(in, out, 2);
+        status = server.run();
+    }
+    std::istringstream written(out.str());
+    std::vector<Json> messages;
+    while (auto body = LanguageServer::read(written)) messages.push_back(Json::parse(*body));
+    return {messages, status};
+}
+
+static const Json* reply(const std::vector<Json>& messages, const int id) {
+    for (const Json& message: messages) {
+        if (message["id"] == Json(id)) return &message;
+    }
+    return nullptr;
+}
+
+static Json position(const Document::Position p) {
+    return Json{{"line", p.line}, {"character", p.character}};
+}
+
+TEST(LanguageServer, AnswersASession) {
+    const std::string uri = "file:///a.zn";
+    const Json document{{"uri", uri}};
+    const std::string from = "return x * 2";
+    const Json range{{"start", position(at(PROGRAM, from))}, {"end", position(at(PROGRAM, from, from.size()))}};
+    std::string input;
+    input += frame(request(1, "textDocument/hover", Json::Object()));
+    input += frame(request(2, "initialize", Json{{"capabilities", Json::Object()}}));
+    input += frame(notification("initialized", Json::Object()));
+    input += frame(notification("textDocument/didOpen", Json{{"textDocument", Json{
+        {"uri", uri}, {"languageId", "zenith"}, {"version", 1}, {"text", PROGRAM}}}}));
+    input += frame(request(3, "textDocument/hover", Json{{"textDocument", document},
+                                                         {"position", position(at(PROGRAM, "twice(limit)"))}}));
+    input += frame(notification("textDocument/didChange", Json{
+        {"textDocument", Json{{"uri", uri}, {"version", 2}}},
+        {"contentChanges", Json::Array{Json{{"range", range}, {"text", "return x * nope"}}}}}));
+    input += frame(request(4, "textDocument/definition", Json{{"textDocument", document},
+                                                              {"position", position(at(PROGRAM, "total + p.x"))}}));
+    input += frame(request(5, "textDocument/documentSymbol", Json{{"textDocument", document}}));
+    input += frame(request(6, "textDocument/formatting", Json{{"textDocument", document}}));
+    input += "Content-Length: 5\r\n\r\n{oops";
+    input += frame(request(7, "shutdown", nullptr));
+    input += frame(request(8, "textDocument/hover", Json::Object()));
+    input += frame(notification("exit", nullptr));
+    const auto [messages, status] = session(input);
+    EXPECT_EQ(status, 0);
+
+    ASSERT_TRUE(reply(messages, 1));
+    EXPECT_EQ((*reply(messages, 1))["error"]["code"].asInt(), LanguageServer::SERVER_NOT_INITIALIZED);
+    ASSERT_TRUE(reply(messages, 2));
+    const Json& capabilities = (*reply(messages, 2))["result"]["capabilities"];
+    EXPECT_EQ(capabilities["positionEncoding"].asString(), "utf-16");
+    EXPECT_EQ(capabilities["textDocumentSync"]["change"].asInt(), 2);
+    ASSERT_TRUE(reply(messages, 3));
+    EXPECT_NE((*reply(messages, 3))["result"]["contents"]["value"].asString().find("function twice"), std::string::npos);
+    ASSERT_TRUE(reply(messages, 4));
+    EXPECT_EQ((*reply(messages, 4))["result"]["range"]["start"]["line"].asInt(), 11);
+    ASSERT_TRUE(reply(messages, 5));
+    EXPECT_EQ((*reply(messages, 5))["result"].asArray().size(), 4u);
+    ASSERT_TRUE(reply(messages, 6));
+    EXPECT_EQ((*reply(messages, 6))["error"]["code"].asInt(), LanguageServer::METHOD_NOT_FOUND);
+    ASSERT_TRUE(reply(messages, 7));
+    EXPECT_TRUE((*reply(messages, 7))["result"].isNull());
+    ASSERT_TRUE(reply(messages, 8));
+    EXPECT_EQ((*reply(messages, 8))["error"]["code"].asInt(), LanguageServer::INVALID_REQUEST);
+
+    // The last diagnostics published are those of the last version, in order of versions
+    int64_t lastVersion = 0;
+    size_t parseErrors = 0;
+    Json last;
+    for (const Json& message: messages) {
+        if (message["error"]["code"].asInt() == LanguageServer::PARSE_ERROR) ++parseErrors;
+        if (message["method"].asString() != "textDocument/publishDiagnostics") continue;
+        EXPECT_GE(message["params"]["version"].asInt(), lastVersion);
+        lastVersion = message["params"]["version"].asInt();
+        last = message["params"];
+    }
+    EXPECT_EQ(parseErrors, 1u);
+    EXPECT_EQ(lastVersion, 2);
+    ASSERT_EQ(last["diagnostics"].asArray().size(), 2u) << last.dump();
+    EXPECT_NE(last["diagnostics"].asArray()[1]["message"].asString().find("nope"), std::string::npos);
+}
+
+TEST(LanguageServer, CancelledRequestsGetOneAnswer) {
+    std::string input = frame(request(1, "initialize", Json{{"capabilities", Json{
+        {"general", Json{{"positionEncodings", Json::Array{"utf-8", "utf-16"}}}}}}}));
+    input += frame(notification("textDocument/didOpen", Json{{"textDocument", Json{
+        {"uri", "file:///a.zn"}, {"version", 1}, {"text", PROGRAM}}}}));
+    for (int id = 2; id < 40; ++id) {
+        input += frame(request(id, "textDocument/documentSymbol", Json{{"textDocument", Json{{"uri", "file:///a.zn"}}}}));
+        input += frame(notification("$/cancelRequest", Json{{"id", id}}));
+    }
+    const auto [messages, status] = session(input);
+    EXPECT_EQ(status, 1) << "no shutdown before the input ended";
+    EXPECT_EQ((*reply(messages, 1))["result"]["capabilities"]["positionEncoding"].asString(), "utf-8");
+    for (int id = 2; id < 40; ++id) {
+        size_t answers = 0;
+        for (const Json& message: messages) {
+            if (message["id"] != Json(id)) continue;
+            ++answers;
+            if (message.contains("error")) EXPECT_EQ(message["error"]["code"].asInt(), LanguageServer::REQUEST_CANCELLED);
+            else EXPECT_EQ(message["result"].asArray().size(), 4u);
+        }
+        EXPECT_EQ(answers, 1u) << id;
+    }
+}
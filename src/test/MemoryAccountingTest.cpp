@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <utils/MemoryAccounting.hpp>
+#include <utils/ThreadPool.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+
+using namespace zenith;
+using Category = MemoryAccounting::Category;
+
+// Accounting cannot be switched off again, every test only looks at what changed while it ran
+static polymorphic<ProgramNode> parse(const std::string& src) {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    Flags flags;
+    Parser parser(Lexer(src, "<test>").tokenize(), flags, reporter, discard);
+    return parser.parse();
+}
+
+// ===========================================================================
+// 1. Categories
+// ===========================================================================
+
+TEST(MemoryAccounting, CountingAllocatorsChargeTheirCategory) {
+    MemoryAccounting::start();
+    const auto before = MemoryAccounting::totals(Category::SYMBOLS);
+    {
+        std::vector<int, CountingAllocator<int, Category::SYMBOLS>> v;
+        v.reserve(100);
+        EXPECT_EQ(MemoryAccounting::totals(Category::SYMBOLS).live, before.live + 400);
+    }
+    const auto after = MemoryAccounting::totals(Category::SYMBOLS);
+    EXPECT_EQ(after.live, before.live);
+    EXPECT_EQ(after.bytes, before.bytes + 400);
+    EXPECT_EQ(after.count, before.count + 1);
+    EXPECT_GE(after.peak, before.live + 400);
+}
+
+TEST(MemoryAccounting, TokensAreChargedWhenHandedOver) {
+    MemoryAccounting::start();
+    const auto before = MemoryAccounting::totals(Category::TOKENS);
+    const auto tokens = Lexer("var a = 1", "<test>").tokenize();
+    EXPECT_GE(MemoryAccounting::totals(Category::TOKENS).bytes, before.bytes + tokens.size() * sizeof(Token));
+}
+
+// ===========================================================================
+// 2. AST
+// ===========================================================================
+
+TEST(MemoryAccounting, NodesAreCountedByKind) {
+    MemoryAccounting::start();
+    auto& binary = MemoryAccounting::kind<BinaryOpNode>();
+    const int64_t count = binary.count, bytes = binary.bytes;
+    const auto before = MemoryAccounting::totals(Category::AST);
+    {
+        auto program = parse("var a = 1 + 2 * 3\n");
+        EXPECT_EQ(binary.count - count, 2);
+        EXPECT_GE(binary.bytes - bytes, 2 * static_cast<int64_t>(sizeof(BinaryOpNode)));
+        EXPECT_GT(MemoryAccounting::totals(Category::AST).live, before.live);
+    }
+    EXPECT_EQ(MemoryAccounting::totals(Category::AST).live, before.live);
+}
+
+TEST(MemoryAccounting, PhasesArePerThreadAndFollowPoolTasks) {
+    MemoryAccounting::start();
+    MemoryAccounting::enter(MemoryAccounting::Phase::ANALYZE);
+    ThreadPool pool(2);
+    std::vector<MemoryAccounting::Phase> seen(4);
+    pool.parallelFor(seen.size(), [&](const size_t i) { seen[i] = MemoryAccounting::phase(); });
+    for (const auto phase: seen) EXPECT_EQ(phase, MemoryAccounting::Phase::ANALYZE);
+
+    // A file compiled on another thread enters its own phases without changing this thread's
+    std::thread([] { MemoryAccounting::enter(MemoryAccounting::Phase::LEX); }).join();
+    EXPECT_EQ(MemoryAccounting::phase(), MemoryAccounting::Phase::ANALYZE);
+    std::thread([] { EXPECT_EQ(MemoryAccounting::phase(), MemoryAccounting::Phase::SETUP); }).join();
+    MemoryAccounting::enter(MemoryAccounting::Phase::SETUP);
+}
+
+TEST(MemoryAccounting, ReportListsCategoriesAndKinds) {
+    MemoryAccounting::start();
+    auto program = parse("fun f() { return 1 }\n");
+    std::ostringstream out;
+    MemoryAccounting::report(out);
+    const std::string report = out.str();
+    for (const char* expected: {"tokens", "ast", "symbols", "diagnostics", "analyze", "FunctionDeclNode"}) {
+        EXPECT_NE(report.find(expected), std::string::npos) << expected << "\n" << report;
+    }
+}
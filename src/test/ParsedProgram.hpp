@@ -0,0 +1,25 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+
+// Test source parsed into a program, expected to have no errors. The passes under test report to the same engine.
+struct ParsedProgram {
+    zenith::DiagnosticsEngine diagnostics;
+    zenith::ErrorReporter reporter{diagnostics};
+    zenith::polymorphic<zenith::ProgramNode> program;
+
+    explicit ParsedProgram(const std::string& src) {
+        Flags flags;
+        std::ostringstream log;
+        zenith::Parser parser(zenith::Lexer(src, "<test>").tokenize(), flags, reporter, log);
+        program = parser.parse();
+        EXPECT_EQ(diagnostics.errorCount(), 0u) << "does not parse";
+    }
+
+    ParsedProgram(const ParsedProgram&) = delete;
+    ParsedProgram& operator=(const ParsedProgram&) = delete;
+};
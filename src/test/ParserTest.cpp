@@ -0,0 +1,575 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <bench/ProgramGenerator.hpp>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <exceptions/ParseError.hpp>
+#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+#include <utils/Hash.hpp>
+#include <utils/ThreadPool.hpp>
+#include <visitor/ASTWalker.hpp>
+
+using namespace zenith;
+
+struct ParseResult {
+    polymorphic<ProgramNode> program;
+    LookaheadStats lookahead;
+    size_t tokenCount;
+    size_t errorCount;
+};
+
+static ParseResult parse(const std::string& src) {
+    auto tokens = Lexer(src, "<test>").tokenize();
+    const size_t tokenCount = tokens.size();
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostringstream log;
+    Parser parser(std::move(tokens), flags, reporter, log);
+    auto program = parser.parse();
+    return {std::move(program), parser.lookahead(), tokenCount, diagnostics.errorCount()};
+}
+
+// 'var f = <expr>' inside main, returns <expr>
+static ExprNode& initializerOf(ParseResult& result) {
+    auto& main = dynamic_cast<FunctionDeclNode&>(*result.program->declarations.at(0));
+    auto& decl = dynamic_cast<VarDeclNode&>(*main.body->statements.at(0));
+    return *decl.initializer;
+}
+
+static std::string inMain(const std::string& expr) {
+    return "fun main() {\n    var f = " + expr + "\n}\n";
+}
+
+static std::string nestedParens(size_t depth, const std::string& inner) {
+    return std::string(depth, '(') + inner + std::string(depth, ')');
+}
+
+static std::string curriedLambda(size_t params) {
+    std::string src;
+    for (size_t i = 0; i < params; ++i) src += "(p" + std::to_string(i) + ") => ";
+    return src + "p0";
+}
+
+// Number of lambdas directly nested in each other's single-expression bodies
+static size_t lambdaChainLength(ExprNode* expr) {
+    size_t length = 0;
+    while (auto lambda = dynamic_cast<LambdaExprNode*>(expr)) {
+        ++length;
+        auto& ret = dynamic_cast<ReturnStmtNode&>(*lambda->lambda->body->statements.at(0));
+        expr = ret.value.get();
+    }
+    return length;
+}
+
+// ===========================================================================
+// 1. Results are unchanged by memoization
+// ===========================================================================
+
+TEST(ParserLookahead, ParenthesizedExpressionIsNotALambda) {
+    auto result = parse(inMain("((a + b) * c)"));
+    ASSERT_EQ(result.errorCount, 0u);
+    auto* op = dynamic_cast<BinaryOpNode*>(&initializerOf(result));
+    ASSERT_NE(op, nullptr);
+    EXPECT_EQ(op->op, BinaryOpNode::MUL);
+}
+
+TEST(ParserLookahead, LambdaInsideParens) {
+    auto result = parse(inMain(nestedParens(5, "(a) => a")));
+    ASSERT_EQ(result.errorCount, 0u);
+    EXPECT_EQ(lambdaChainLength(&initializerOf(result)), 1u);
+    // The outermost scan validates every inner group, the later checks are answered from the memo
+    EXPECT_EQ(result.lookahead.scans, 1u);
+    EXPECT_GE(result.lookahead.memoHits, 5u);
+}
+
+TEST(ParserLookahead, CurriedLambdas) {
+    auto result = parse(inMain(curriedLambda(6)));
+    ASSERT_EQ(result.errorCount, 0u);
+    EXPECT_EQ(lambdaChainLength(&initializerOf(result)), 6u);
+}
+
+TEST(ParserLookahead, LambdaAsCallArgument) {
+    auto result = parse(inMain("apply(((x) => (x)), (1 + 2))"));
+    ASSERT_EQ(result.errorCount, 0u);
+    auto* call = dynamic_cast<CallNode*>(&initializerOf(result));
+    ASSERT_NE(call, nullptr);
+    ASSERT_EQ(call->arguments.size(), 2u);
+    EXPECT_NE(dynamic_cast<LambdaExprNode*>(call->arguments[0].get()), nullptr);
+    EXPECT_NE(dynamic_cast<BinaryOpNode*>(call->arguments[1].get()), nullptr);
+}
+
+TEST(ParserLookahead, MethodOrVariable) {
+    auto result = parse("int f() {\n    return 1\n}\nint g = 2\n");
+    ASSERT_EQ(result.errorCount, 0u);
+    ASSERT_EQ(result.program->declarations.size(), 2u);
+    EXPECT_NE(dynamic_cast<FunctionDeclNode*>(result.program->declarations[0].get()), nullptr);
+    EXPECT_NE(dynamic_cast<VarDeclNode*>(result.program->declarations[1].get()), nullptr);
+}
+
+// ===========================================================================
+// 2. Stress: speculative scanning stays linear in the input
+// ===========================================================================
+
+struct StressCase { const char* name; std::string (*make)(size_t); };
+
+class ParserLookaheadStress : public ::testing::TestWithParam<StressCase> {};
+
+TEST_P(ParserLookaheadStress, ScalesLinearly) {
+    const auto make = GetParam().make;
+    size_t previousScanned = 0;
+    for (const size_t size: {250u, 500u, 1000u, 2000u}) {
+        auto result = parse(inMain(make(size)));
+        ASSERT_EQ(result.errorCount, 0u) << "size " << size;
+
+        // Every token is looked at a bounded number of times, no matter how deep the nesting
+        EXPECT_LE(result.lookahead.tokensScanned, 2 * result.tokenCount) << "size " << size;
+        if (previousScanned) {
+            // Doubling the input at most doubles the work (plus slack for the fixed prefix)
+            EXPECT_LE(result.lookahead.tokensScanned, 2 * previousScanned + 16) << "size " << size;
+        }
+        previousScanned = result.lookahead.tokensScanned;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Shapes, ParserLookaheadStress, ::testing::Values(
+    StressCase{"NestedParens", [](size_t n) { return nestedParens(n, "a"); }},
+    StressCase{"NestedParensAroundLambda", [](size_t n) { return nestedParens(n, "(a) => a"); }},
+    StressCase{"CurriedLambdas", [](size_t n) { return curriedLambda(n / 4); }},
+    StressCase{"LambdasInParens", [](size_t n) {
+        std::string src;
+        for (size_t i = 0; i < n / 4; ++i) src += "((p" + std::to_string(i) + ") => ";
+        return src + "p0" + std::string(n / 4, ')');
+    }}
+), [](const auto& info) { return std::string(info.param.name); });
+
+// ===========================================================================
+// 3. Lazily parsed bodies
+// ===========================================================================
+
+TEST(ParserLazyBodies, OutliveTheParserAndReportToTheAnalysis) {
+    const std::string src = "fun int f() {\n    if (true) return (1 +\n    return 1\n}\n";
+    polymorphic<ProgramNode> program;
+    {
+        Flags flags;
+        flags.lazyParsing = true;
+        DiagnosticsEngine diagnostics;
+        ErrorReporter reporter(diagnostics);
+        std::ostringstream log;
+        Parser parser(Lexer(src, "<test>").tokenize(), flags, reporter, log);
+        program = parser.parse();
+        ASSERT_EQ(diagnostics.errorCount(), 0u);
+    }
+    auto& f = dynamic_cast<FunctionDeclNode&>(*program->declarations.at(0));
+    ASSERT_FALSE(f.body.cast().non_throwing().to<LazyBlockNode>()->isParsed());
+
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    EXPECT_NO_THROW(SemanticAnalyzer(reporter).analyze(program));
+    const auto reported = diagnostics.collect();
+    ASSERT_FALSE(reported.empty());
+    EXPECT_EQ(reported.front().loc.line, 2u);
+}
+
+// ===========================================================================
+// 4. Error recovery
+// ===========================================================================
+
+static uint64_t splitmix(uint64_t& state) {
+    uint64_t z = state += 0x9e3779b97f4a7c15;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// A generated program with broken statements, then one to three stray tokens inserted or characters deleted
+static std::string brokenProgram(const uint64_t seed) {
+    ProgramGenerator::Options options;
+    options.lines = 60;
+    options.seed = seed;
+    options.errorsPerKLoc = 30;
+    std::string src = ProgramGenerator(options).generate();
+    static const char* stray[] = {"}", "{", ")", "(", "=", ",", ".", "@", "fun", "if", "class", "return", ":", "<", "=>", "else"};
+    uint64_t state = seed * 31 + 7;
+    const size_t edits = 1 + splitmix(state) % 3;
+    for (size_t i = 0; i < edits; ++i) {
+        size_t at = splitmix(state) % src.size();
+        while (at < src.size() && src[at] != ' ' && src[at] != '\n') ++at;
+        if (splitmix(state) % 2) src.insert(at, std::string(" ") + stray[splitmix(state) % std::size(stray)]);
+        else src.erase(at, std::min<size_t>(1 + splitmix(state) % 6, src.size() - at));
+    }
+    return src;
+}
+
+// What the driver writes to parserout.log, the recovery log then the tree, with every lazy body parsed
+static std::string parserOut(std::vector<Token> tokens, const Flags& flags, size_t& errors, ThreadPool* pool = nullptr) {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostringstream log;
+    try {
+        Parser parser(std::move(tokens), flags, reporter, log, pool);
+        auto program = parser.parse();
+        for (auto& decl: program->declarations) {
+            std::vector<FunctionDeclNode*> functions;
+            if (auto function = dynamic_cast<FunctionDeclNode*>(decl.get())) functions.push_back(function);
+            else if (auto object = dynamic_cast<ObjectDeclNode*>(decl.get())) {
+                for (auto& member: object->members) {
+                    if (auto method = dynamic_cast<FunctionDeclNode*>(member.get())) functions.push_back(method);
+                }
+            }
+            for (auto function: functions) {
+                if (auto lazy = dynamic_cast<LazyBlockNode*>(function->body.get())) lazy->materialize(&reporter);
+            }
+        }
+        log << program->toString() << std::endl;
+    } catch (const ParseError& e) {
+        // Outside every recovery point, main reports it and stops
+        reporter.error(e.location, e.std::runtime_error::what());
+        log << "threw: " << e.std::runtime_error::what() << std::endl;
+    }
+    errors = diagnostics.errorCount();
+    return log.str();
+}
+
+static std::string parserOut(const std::string& src, const Flags& flags, size_t& errors, ThreadPool* pool = nullptr) {
+    return parserOut(Lexer(src, "<fuzz>").tokenize(), flags, errors, pool);
+}
+
+static uint64_t hashOf(const std::string& text) {
+    Hash hash;
+    hash << text;
+    return hash.value;
+}
+
+struct RecordedRecovery {
+    uint64_t seed;
+    size_t errors[3];
+    uint64_t parserOut[3];
+};
+
+// Recorded from the parser that still threw ParseError to its catch sites, the parent of "Signal parse errors
+// without exceptions", with the default flags, --braces=optional and --lazy-parse. Record again only for an intended
+// change to recovery, the tree's toString() or ProgramGenerator.
+static const RecordedRecovery THROWING_PARSER[] = {
+    { 1, {2, 2, 0}, {0x3d24ece6ba92744a, 0x3d24ece6ba92744a, 0x488560669b1d173b}},
+    { 2, {7, 7, 0}, {0x8127fb790ccfe425, 0x8127fb790ccfe425, 0xb5d42b885d7f5c15}},
+    { 3, {6, 6, 5}, {0x550fb4104b6f4e21, 0x550fb4104b6f4e21, 0x78b2cd9da2371223}},
+    { 4, {3, 3, 0}, {0xdf56791a4a168a88, 0xdf56791a4a168a88, 0xe87f54b93c0246c7}},
+    { 5, {4, 4, 0}, {0xeb2e17ee90fe9922, 0xeb2e17ee90fe9922, 0x9ed4b76f5bf31eed}},
+    { 6, {1, 1, 0}, {0x75c360cc2efb50ec, 0x75c360cc2efb50ec, 0x3a8494526315f54d}},
+    { 7, {1, 1, 0}, {0xdd2031fa0bd46bd7, 0xdd2031fa0bd46bd7, 0x6ba95f90658e587e}},
+    { 8, {9, 9, 0}, {0xd7734aad18aee631, 0xd7734aad18aee631, 0xe56e551eb60b9c24}},
+    { 9, {16, 16, 0}, {0x6f255462a8b02c66, 0x6f255462a8b02c66, 0x7356668c4b92ad00}},
+    {10, {8, 8, 0}, {0x66e2c1889bde9656, 0x66e2c1889bde9656, 0x060ed6fcaffd35f0}},
+    {11, {3, 3, 0}, {0x9da0eb3706f0fb72, 0x9da0eb3706f0fb72, 0x3cc428fe40f7f708}},
+    {12, {9, 9, 9}, {0x2919912878744eb0, 0x2919912878744eb0, 0x2919912878744eb0}},
+    {13, {1, 1, 0}, {0xe3fd565de277e956, 0xe3fd565de277e956, 0xd83e0f89126c20b8}},
+    {14, {32, 32, 0}, {0x04a5a470ddd5d3e1, 0x04a5a470ddd5d3e1, 0x7109b6fc219665c8}},
+    {15, {0, 0, 0}, {0x18bf93d19e86f967, 0x18bf93d19e86f967, 0x18bf93d19e86f967}},
+    {16, {3, 3, 0}, {0x5578e96b596dbb01, 0x5578e96b596dbb01, 0xb23bbe2411123285}},
+    {17, {12, 12, 0}, {0x550794b269b7f298, 0x550794b269b7f298, 0xfa0c9d7080dcad27}},
+    {18, {3, 3, 0}, {0xdfc55029b21b4511, 0xdfc55029b21b4511, 0xe55e852af3251ce6}},
+    {19, {8, 8, 0}, {0x9f7b52bb92913647, 0x9f7b52bb92913647, 0x6ce39774e9a26524}},
+    {20, {0, 0, 0}, {0x9e7945cd78f343f4, 0x9e7945cd78f343f4, 0x9e7945cd78f343f4}},
+    {21, {10, 10, 0}, {0x3e187a173dd72083, 0x8daeaad4e6cad2d8, 0xb559ac27ef381d9b}},
+    {22, {5, 5, 0}, {0x7e4931518c102851, 0x7e4931518c102851, 0x8825594aa8e9f078}},
+    {23, {0, 0, 0}, {0xc6d7f73e55c76aa5, 0xc6d7f73e55c76aa5, 0xc6d7f73e55c76aa5}},
+    {24, {5, 5, 0}, {0xb13d199009f8baa0, 0xb13d199009f8baa0, 0xba82e28066526284}},
+    {25, {10, 10, 0}, {0xf6915e869c48a9dc, 0xf6915e869c48a9dc, 0xfc1325321233bf15}},
+    {26, {0, 0, 0}, {0x8c668ee0484f2fa9, 0x8c668ee0484f2fa9, 0x8c668ee0484f2fa9}},
+    {27, {5, 5, 0}, {0xa00a32b35a9dafc6, 0xa00a32b35a9dafc6, 0xa1116c66d493d0ad}},
+    {28, {13, 13, 0}, {0x4debfb1dcb4b5769, 0x4debfb1dcb4b5769, 0x0e01411ee9275715}},
+    {29, {5, 5, 0}, {0x506bdd3109ae45d9, 0x506bdd3109ae45d9, 0xccd9805a3e27e0f3}},
+    {30, {4, 4, 0}, {0xd3dce1523c84ce20, 0xd3dce1523c84ce20, 0xf995865d54197a09}},
+    {31, {10, 10, 0}, {0x613f97eee8d31786, 0x613f97eee8d31786, 0x1058a7ff8b23aa68}},
+    {32, {10, 10, 0}, {0x9a5178afc14a5db1, 0x9a5178afc14a5db1, 0x62004d8d60334889}},
+    {33, {11, 11, 0}, {0x1d195c4ba3fab5ef, 0x1d195c4ba3fab5ef, 0xb19ef00f8f3c48f8}},
+    {34, {0, 0, 0}, {0x526c6ceb0fda0747, 0x526c6ceb0fda0747, 0x526c6ceb0fda0747}},
+    {35, {17, 17, 17}, {0xfe9f3859bfb0ada3, 0xfe9f3859bfb0ada3, 0xfe9f3859bfb0ada3}},
+    {36, {7, 7, 0}, {0x8dcd416c974e4e9e, 0x8dcd416c974e4e9e, 0x32b72ef6eeb1e730}},
+    {37, {1, 1, 0}, {0x851c11368299edae, 0x851c11368299edae, 0x6177f4d7b6654392}},
+    {38, {2, 2, 0}, {0xb346490876a31614, 0xb346490876a31614, 0x9faf77c4bf71b963}},
+    {39, {1, 1, 0}, {0xfe95fe11b691aa4b, 0xfe95fe11b691aa4b, 0x447658bc0b0b622e}},
+    {40, {1, 1, 0}, {0xb2639a56b57b0b6f, 0xb2639a56b57b0b6f, 0x50cd3d33dd91bfc5}},
+};
+
+TEST(ParserRecovery, MatchesTheThrowingParser) {
+    for (const auto& recorded: THROWING_PARSER) {
+        const std::string src = brokenProgram(recorded.seed);
+        for (size_t variant = 0; variant < 3; ++variant) {
+            Flags flags;
+            flags.bracesRequired = variant != 1;
+            flags.lazyParsing = variant == 2;
+            size_t errors = 0;
+            const std::string out = parserOut(src, flags, errors);
+            EXPECT_EQ(errors, recorded.errors[variant]) << "seed " << recorded.seed << ", variant " << variant;
+            EXPECT_EQ(hashOf(out), recorded.parserOut[variant]) << "seed " << recorded.seed << ", variant " << variant
+                << "\n" << src << "\n----\n" << out;
+        }
+    }
+}
+
+// The throwing parser's pooled parse did not match its own sequential one on unbalanced input, so this compares the two
+TEST(ParserRecovery, PooledParseMatchesSequential) {
+    ThreadPool pool(4);
+    for (const auto& recorded: THROWING_PARSER) {
+        const std::string src = brokenProgram(recorded.seed);
+        size_t sequentialErrors = 0, pooledErrors = 0;
+        const std::string sequential = parserOut(src, {}, sequentialErrors);
+        const std::string pooled = parserOut(src, {}, pooledErrors, &pool);
+        EXPECT_EQ(pooledErrors, sequentialErrors) << "seed " << recorded.seed;
+        EXPECT_EQ(pooled, sequential) << "seed " << recorded.seed;
+    }
+}
+
+// Touches every node, parsing lazy bodies on the way
+class TouchEveryNode : public ASTWalker {
+protected:
+    void enter(ASTNode&) override { ++count; }
+
+public:
+    size_t count = 0;
+};
+
+// After fail() every parse method returns nullptr or a partial node up to its caller. Failing at each token of a
+// program that uses every construct walks those paths; a result used before it is checked crashes here.
+TEST(ParserRecovery, SurvivesFailingAtEveryToken) {
+    const std::string src =
+        "@Async fun int add(int a, int b) {\n"
+        "    int q = a + b * 2\n"
+        "    if (q > 10) {\n"
+        "        q = q - 1\n"
+        "    } else {\n"
+        "        q = g(h(q, a), b)\n"
+        "    }\n"
+        "    do {\n"
+        "        q = q - 1\n"
+        "    } while (q > 0)\n"
+        "    unsafe {\n"
+        "        q = 3\n"
+        "    }\n"
+        "    return q\n"
+        "}\n"
+        "class Point {\n"
+        "    public int x;\n"
+        "    private static int count = 0;\n"
+        "    Point(int x) : x(x) {\n"
+        "        this.x = x\n"
+        "    }\n"
+        "    public fun int sum() {\n"
+        "        return this.x + 1\n"
+        "    }\n"
+        "}\n"
+        "template<typename T, int N = 3> class Box {\n"
+        "    public T value;\n"
+        "}\n"
+        "struct Pair {\n"
+        "    int a;\n"
+        "    int b;\n"
+        "}\n"
+        "union Num { int, float }\n"
+        "var f = (a, b) => a * b\n"
+        "Point p = {x: 1, y: 2}\n"
+        "freeobj o = freeobj {a: 1, b: \"s\"}\n"
+        "var n = new Point(1)\n"
+        "actor Counter {\n"
+        "    on Increment(int by) {\n"
+        "        count = count + by\n"
+        "    }\n"
+        "}\n"
+        "fun main() {\n"
+        "    var x = add(1, 2)\n"
+        "    for (int i = 0; i < 3; i = i + 1) {\n"
+        "        x = x.y[i]\n"
+        "    }\n"
+        "    while (!done) {\n"
+        "        x = -x\n"
+        "    }\n"
+        "}\n"
+        "import \"lib/math\"\n";
+    const std::vector<Token> tokens = Lexer(src, "<fuzz>").tokenize();
+    size_t errors = 0;
+    const std::string clean = parserOut(tokens, {}, errors);
+    ASSERT_EQ(errors, 0u) << clean;
+
+    for (size_t variant = 0; variant < 3; ++variant) {
+        Flags flags;
+        flags.bracesRequired = variant != 1;
+        flags.lazyParsing = variant == 2;
+        // Every token but the final EOF, dropped and then doubled
+        for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+            for (const bool duplicate: {false, true}) {
+                std::vector<Token> broken = tokens;
+                if (duplicate) broken.insert(broken.begin() + static_cast<ptrdiff_t>(i), tokens[i]);
+                else broken.erase(broken.begin() + static_cast<ptrdiff_t>(i));
+                SCOPED_TRACE((duplicate ? "doubled token " : "dropped token ") + std::to_string(i) + " '" +
+                             tokens[i].lexeme + "', variant " + std::to_string(variant));
+
+                DiagnosticsEngine diagnostics;
+                ErrorReporter reporter(diagnostics);
+                std::ostream discard(nullptr);
+                try {
+                    Parser parser(std::move(broken), flags, reporter, discard);
+                    auto program = parser.parse();
+                    ASSERT_TRUE(program);
+                    TouchEveryNode walker;
+                    program->accept(walker);
+                    EXPECT_GT(walker.count, 0u);
+                    (void)program->toString();
+                } catch (const ParseError&) {
+                    // Outside every recovery point, parse() throws it once
+                }
+            }
+        }
+    }
+}
+
+// ===========================================================================
+// 5. Argument lists
+// ===========================================================================
+
+TEST(ParserArguments, CallTakesEveryArgument) {
+    auto result = parse(inMain("f(1, a, (b + 2))"));
+    ASSERT_EQ(result.errorCount, 0u);
+    auto* call = dynamic_cast<CallNode*>(&initializerOf(result));
+    ASSERT_NE(call, nullptr);
+    ASSERT_EQ(call->arguments.size(), 3u);
+    EXPECT_NE(dynamic_cast<BinaryOpNode*>(call->arguments[2].get()), nullptr);
+}
+
+TEST(ParserArguments, NewTakesEveryArgument) {
+    auto result = parse(inMain("new Pair(1, 2)"));
+    ASSERT_EQ(result.errorCount, 0u);
+    auto* expr = dynamic_cast<NewExprNode*>(&initializerOf(result));
+    ASSERT_NE(expr, nullptr);
+    EXPECT_EQ(expr->className, "Pair");
+    EXPECT_EQ(expr->args.size(), 2u);
+}
+
+TEST(ParserArguments, AnnotationTakesEveryArgument) {
+    auto result = parse("class A {\n    @Bind(name = \"x\", 2)\n    int x;\n}\n");
+    ASSERT_EQ(result.errorCount, 0u);
+    auto& object = dynamic_cast<ObjectDeclNode&>(*result.program->declarations.at(0));
+    auto& field = *object.members.at(0);
+    ASSERT_EQ(field.annotations.size(), 1u);
+    const auto& arguments = field.annotations[0]->arguments;
+    ASSERT_EQ(arguments.size(), 2u);
+    EXPECT_EQ(arguments[0].first, "name");
+    EXPECT_EQ(arguments[1].first, "");
+}
+
+// ===========================================================================
+// 6. Parallel parsing
+// ===========================================================================
+
+// The first token of every slice, as "lexeme:line", when each declaration may get a slice of its own
+static std::vector<std::string> sliceStarts(const std::string& src) {
+    const auto tokens = Lexer(src, "<test>").tokenize();
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostringstream log;
+    const Parser parser(tokens, flags, reporter, log);
+    std::vector<std::string> starts;
+    size_t expected = 0;
+    for (const auto& [begin, end]: parser.splitDeclarations(1)) {
+        EXPECT_EQ(begin, expected) << "slices must cover the tokens without gaps";
+        expected = end;
+        starts.push_back(tokens[begin].lexeme + ":" + std::to_string(tokens[begin].loc.line));
+    }
+    return starts;
+}
+
+// The first line where two outputs differ, empty if they do not; a whole tree is too long for a readable diff
+static std::string firstDifference(const std::string& a, const std::string& b) {
+    std::istringstream left(a), right(b);
+    std::string l, r;
+    for (size_t line = 1;; ++line) {
+        const bool moreLeft = static_cast<bool>(std::getline(left, l));
+        const bool moreRight = static_cast<bool>(std::getline(right, r));
+        if (!moreLeft && !moreRight) return "";
+        if (moreLeft != moreRight || l != r) return "line " + std::to_string(line) + ": '" + l + "' vs '" + r + "'";
+    }
+}
+
+static std::string generated(const size_t lines, const uint64_t seed, const size_t errorsPerKLoc = 0) {
+    ProgramGenerator::Options options;
+    options.lines = lines;
+    options.seed = seed;
+    options.errorsPerKLoc = errorsPerKLoc;
+    return ProgramGenerator(options).generate();
+}
+
+TEST(ParserSplit, EveryTopLevelDeclarationStartsASlice) {
+    EXPECT_EQ(sliceStarts("import \"lib/math\"\n"
+                          "fun int f() {\n    return 1\n}\n"
+                          "class A {\n    int x;\n}\n"
+                          "@Pure\n@Inline(2)\nfun int g() {\n    return 2\n}\n"
+                          "template<T> class Box {\n}\n"),
+              (std::vector<std::string>{"import:1", "fun:2", "class:5", "@:8", "template:13"}));
+}
+
+TEST(ParserSplit, NestedDeclarationsStayWithTheirParent) {
+    EXPECT_EQ(sliceStarts("class A {\n    fun int m() {\n        return (fun)[class]\n    }\n}\n"
+                          "fun int f(int a = (class), int b = [fun]) {\n    { { fun } }\n}\n"
+                          "fun int g() {\n    @Inner\n    return 2\n}\n"),
+              (std::vector<std::string>{"class:1", "fun:6", "fun:9"}));
+}
+
+TEST(ParserSplit, UnbalancedBracketsGiveOneSlice) {
+    for (const std::string body: {")", "]", "}", "(", "[", "{", "( ]", "[ }", "{ )"}) {
+        const std::string src = "fun int f() {\n    " + body + "\n}\nfun int g() {\n    return 1\n}\n";
+        EXPECT_EQ(sliceStarts(src), (std::vector<std::string>{"fun:1"})) << body;
+    }
+    // A declaration after the mismatch would not start where the parser resumes either
+    EXPECT_EQ(sliceStarts("fun int f() {\n}\n}\nfun int g() {\n}\n"), (std::vector<std::string>{"fun:1"}));
+}
+
+TEST(ParserSplit, LargeProgramMatchesSequential) {
+    const std::string src = generated(50000, 11);
+    Flags flags;
+    flags.maxErrors = 0;
+    ThreadPool pool(4);
+    size_t sequentialErrors = 0, pooledErrors = 0;
+    const std::string sequential = parserOut(src, flags, sequentialErrors);
+    const std::string pooled = parserOut(src, flags, pooledErrors, &pool);
+    EXPECT_EQ(sequentialErrors, 0u);
+    EXPECT_EQ(pooledErrors, 0u);
+    EXPECT_EQ(firstDifference(pooled, sequential), "");
+}
+
+TEST(ParserSplit, UnbalancedBracketsMatchSequential) {
+    const std::string src = generated(5000, 11);
+    Flags flags;
+    flags.maxErrors = 0;
+    ThreadPool pool(4);
+    // A stray or mismatched bracket in the first method of every class, the methods after it must not start a slice
+    for (const std::string stray: {")", "]", "}", "{", "( ]", "[ }"}) {
+        std::string broken = src;
+        size_t classes = 0;
+        for (size_t at = broken.find("    public fun int m0("); at != std::string::npos;
+             at = broken.find("    public fun int m0(", at + 1)) {
+            broken.insert(broken.find('\n', at) + 1, "        " + stray + "\n");
+            ++classes;
+        }
+        ASSERT_GT(classes, 10u);
+        size_t sequentialErrors = 0, pooledErrors = 0;
+        const std::string sequential = parserOut(broken, flags, sequentialErrors);
+        EXPECT_EQ(firstDifference(parserOut(broken, flags, pooledErrors, &pool), sequential), "") << stray;
+        EXPECT_EQ(pooledErrors, sequentialErrors) << stray;
+    }
+}
+
+TEST(ParserSplit, InjectedErrorsMatchSequential) {
+    const std::string src = generated(5000, 5, 10);
+    Flags flags;
+    flags.maxErrors = 0;
+    ThreadPool pool(4);
+    size_t sequentialErrors = 0, pooledErrors = 0;
+    const std::string sequential = parserOut(src, flags, sequentialErrors);
+    EXPECT_EQ(firstDifference(parserOut(src, flags, pooledErrors, &pool), sequential), "");
+    EXPECT_EQ(pooledErrors, sequentialErrors);
+}
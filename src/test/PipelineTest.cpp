@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <bench/ProgramGenerator.hpp>
+#include <driver/Pipeline.hpp>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <exceptions/LexError.hpp>
+#include <utils/BoundedQueue.hpp>
+
+using namespace zenith;
+
+static std::vector<Token> lex(const std::string& src) {
+    return Lexer(src, "<test>").tokenize();
+}
+
+static std::string parseSequential(const std::string& src, const Flags& flags = {}) {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    return Parser(lex(src), flags, reporter, discard).parse()->toString();
+}
+
+// Parses src from batches of batchSize tokens, counting the runs handed out
+static std::string parseStreamed(const std::string& src, const size_t batchSize, size_t* runs = nullptr,
+                                 size_t* declarations = nullptr) {
+    const std::vector<Token> tokens = lex(src);
+    size_t next = 0;
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    auto program = Parser::parseStream(
+        [&](std::vector<Token>& batch) {
+            if (next == tokens.size()) return false;
+            const size_t end = std::min(tokens.size(), next + batchSize);
+            batch.assign(tokens.begin() + static_cast<std::ptrdiff_t>(next), tokens.begin() + static_cast<std::ptrdiff_t>(end));
+            next = end;
+            return true;
+        },
+        [&](const std::vector<polymorphic_ref<ASTNode>>& parsed) {
+            if (runs) ++*runs;
+            if (declarations) *declarations += parsed.size();
+        },
+        flags, reporter, discard);
+    return program->toString();
+}
+
+struct Analyzed {
+    std::string program;
+    std::string symbols;
+    size_t errors;
+};
+
+static Analyzed analyze(const std::string& src, const bool pipelined, Pipeline::Options options = {}) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    SemanticAnalyzer analyzer(reporter);
+    polymorphic<ProgramNode> program;
+    if (pipelined) program = Pipeline(flags, reporter, discard, std::move(options)).run(src, "<test>", analyzer);
+    else program = Parser(lex(src), flags, reporter, discard).parse();
+    SymbolTable&& symbols = analyzer.analyze(program);
+    return {program->toString(), symbols.toString(), diagnostics.errorCount()};
+}
+
+// ===========================================================================
+// 1. BoundedQueue
+// ===========================================================================
+
+TEST(Pipeline, QueueHoldsTheProducerBackWhenFull) {
+    BoundedQueue<int> queue(2);
+    std::atomic<int> pushed = 0;
+    std::thread producer([&] {
+        for (int i = 0; i < 5; ++i) {
+            queue.push(i);
+            ++pushed;
+        }
+        queue.close();
+    });
+    while (queue.fullWaits() == 0) std::this_thread::yield();
+    EXPECT_EQ(pushed.load(), 2);
+    for (int i = 0; i < 5; ++i) EXPECT_EQ(queue.pop(), i);
+    EXPECT_EQ(queue.pop(), std::nullopt);
+    producer.join();
+}
+
+TEST(Pipeline, ClosingTheQueueReleasesABlockedProducer) {
+    BoundedQueue<int> queue(1);
+    bool accepted = true;
+    std::thread producer([&] {
+        queue.push(0);
+        accepted = queue.push(1);
+    });
+    while (queue.fullWaits() == 0) std::this_thread::yield();
+    queue.close();
+    producer.join();
+    EXPECT_FALSE(accepted);
+    EXPECT_EQ(queue.pop(), 0);
+    EXPECT_EQ(queue.pop(), std::nullopt);
+}
+
+// ===========================================================================
+// 2. Streams
+// ===========================================================================
+
+TEST(Pipeline, BatchedLexingMatchesTokenize) {
+    const std::string src = ProgramGenerator(ProgramGenerator::Options::analyzable(500, 3)).generate();
+    const std::vector<Token> whole = lex(src);
+    std::vector<Token> joined;
+    size_t batches = 0;
+    Lexer(src, "<test>").tokenize(100, [&](std::vector<Token>&& batch) {
+        EXPECT_GE(batch.size(), 1u);
+        ++batches;
+        std::ranges::move(batch, std::back_inserter(joined));
+        return true;
+    });
+    ASSERT_EQ(joined.size(), whole.size());
+    EXPECT_GE(batches, whole.size() / 100);
+    EXPECT_EQ(joined.back().type, TokenType::EOF_TOKEN);
+    for (size_t i = 0; i < whole.size(); ++i) {
+        EXPECT_EQ(joined[i].lexeme, whole[i].lexeme);
+        EXPECT_EQ(joined[i].loc.fileOffset, whole[i].loc.fileOffset);
+    }
+
+    size_t stoppedAfter = 0;
+    Lexer(src, "<test>").tokenize(100, [&](std::vector<Token>&&) { return ++stoppedAfter < 3; });
+    EXPECT_EQ(stoppedAfter, 3u);
+}
+
+TEST(Pipeline, StreamedParseMatchesParse) {
+    ProgramGenerator::Options options;
+    options.lines = 3000;
+    options.seed = 5;
+    const std::string src = ProgramGenerator(options).generate();
+    const std::string expected = parseSequential(src);
+    for (const size_t batchSize: {1u, 7u, 300u, 100000u}) {
+        size_t runs = 0, declarations = 0;
+        EXPECT_EQ(parseStreamed(src, batchSize, &runs, &declarations), expected) << "batches of " << batchSize;
+        EXPECT_GT(runs, batchSize < 100000 ? 1u : 0u);
+        EXPECT_GT(declarations, 0u);
+    }
+}
+
+TEST(Pipeline, StreamedParseKeepsAnnotationsAndTemplatesWithTheirDeclaration) {
+    std::string src;
+    for (int i = 0; i < 200; ++i) {
+        src += "@Deprecated\ntemplate<typename T> class Box" + std::to_string(i) + " {\n    public T value;\n}\n";
+        src += "fun int f" + std::to_string(i) + "(int p) {\n    return p + " + std::to_string(i) + "\n}\n";
+    }
+    EXPECT_EQ(parseStreamed(src, 5), parseSequential(src));
+}
+
+TEST(Pipeline, CutShortStreamDropsTheUnfinishedTail) {
+    std::string src;
+    for (int i = 0; i < 300; ++i) src += "fun int f" + std::to_string(i) + "() {\n    return 1\n}\n";
+    std::vector<Token> tokens = lex(src);
+    tokens.erase(tokens.end() - 3, tokens.end()); // Inside the last function, no EOF_TOKEN
+    bool given = false;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    auto program = Parser::parseStream(
+        [&](std::vector<Token>& batch) {
+            if (given) return false;
+            batch = tokens;
+            return given = true;
+        },
+        [](const std::vector<polymorphic_ref<ASTNode>>&) {}, Flags{}, reporter, discard);
+    EXPECT_GT(program->declarations.size(), 0u);
+    EXPECT_LT(program->declarations.size(), 300u);
+    EXPECT_EQ(diagnostics.errorCount(), 0u) << "the unfinished function is not parsed";
+}
+
+// ===========================================================================
+// 3. Pipeline
+// ===========================================================================
+
+TEST(Pipeline, AnalysisMatchesSequential) {
+    const std::string src = ProgramGenerator(ProgramGenerator::Options::analyzable(5000, 9)).generate();
+    const Analyzed sequential = analyze(src, false);
+    Pipeline::Options small;
+    small.tokenBatch = 64;
+    small.queueDepth = 1;
+    for (Pipeline::Options& options: std::vector<Pipeline::Options>{{}, small}) {
+        const Analyzed pipelined = analyze(src, true, options);
+        EXPECT_EQ(pipelined.errors, sequential.errors);
+        EXPECT_EQ(pipelined.program, sequential.program);
+        EXPECT_EQ(pipelined.symbols, sequential.symbols);
+    }
+}
+
+TEST(Pipeline, FunctionsCanNameClassesDeclaredAfterThem) {
+    std::string src = "fun Later make(Later x) {\n    return x\n}\n";
+    for (int i = 0; i < 300; ++i) src += "fun int pad" + std::to_string(i) + "() {\n    return 0\n}\n";
+    src += "class Later {\n    public int value = 1;\n}\n";
+    Pipeline::Options options;
+    options.tokenBatch = 16;
+    const Analyzed pipelined = analyze(src, true, options);
+    EXPECT_EQ(pipelined.errors, analyze(src, false).errors);
+    EXPECT_EQ(pipelined.symbols, analyze(src, false).symbols);
+}
+
+TEST(Pipeline, ReportsTheLexerErrorAndStops) {
+    std::string src;
+    for (int i = 0; i < 2000; ++i) src += "fun int f" + std::to_string(i) + "() {\n    return 0\n}\n";
+    src += "int broken = 1 & 2\n";
+    for (int i = 0; i < 2000; ++i) src += "fun int g" + std::to_string(i) + "() {\n    return 0\n}\n";
+    Pipeline::Options options;
+    options.tokenBatch = 32;
+    options.queueDepth = 1;
+    EXPECT_THROW(analyze(src, true, options), LexError);
+}
+
+TEST(Pipeline, StatsCountBatchesAndRuns) {
+    const std::string src = ProgramGenerator(ProgramGenerator::Options::analyzable(3000, 2)).generate();
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    SemanticAnalyzer analyzer(reporter);
+    Pipeline::Options options;
+    options.tokenBatch = 256;
+    size_t seen = 0;
+    options.onTokens = [&](const std::vector<Token>& batch) { seen += batch.size(); };
+    Pipeline pipeline(flags, reporter, discard, std::move(options));
+    auto program = pipeline.run(src, "<test>", analyzer);
+    EXPECT_EQ(seen, lex(src).size());
+    EXPECT_EQ(pipeline.stats().tokenBatches, (seen + 255) / 256);
+    EXPECT_GT(pipeline.stats().declarationRuns, 1u);
+    EXPECT_LT(pipeline.stats().declarationRuns, program->declarations.size());
+}
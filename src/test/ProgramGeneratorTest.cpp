@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <bench/ProgramGenerator.hpp>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+
+using namespace zenith;
+
+static std::string generate(ProgramGenerator::Options options) {
+    return ProgramGenerator(options).generate();
+}
+
+static ProgramGenerator::Options sized(const size_t lines, const uint64_t seed) {
+    ProgramGenerator::Options options;
+    options.lines = lines;
+    options.seed = seed;
+    return options;
+}
+
+struct Parsed {
+    polymorphic<ProgramNode> program;
+    size_t errors;
+};
+
+static Parsed parse(const std::string& src) {
+    Flags flags;
+    flags.maxErrors = 0;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    Parser parser(Lexer(src, "<test>").tokenize(), flags, reporter, discard);
+    auto program = parser.parse();
+    return {std::move(program), diagnostics.errorCount()};
+}
+
+// ===========================================================================
+// 1. Determinism and size
+// ===========================================================================
+
+TEST(ProgramGenerator, SameSeedSameProgram) {
+    EXPECT_EQ(generate(sized(2000, 7)), generate(sized(2000, 7)));
+    EXPECT_NE(generate(sized(2000, 7)), generate(sized(2000, 8)));
+}
+
+TEST(ProgramGenerator, StopsAfterTheDeclarationReachingTheLineCount) {
+    for (const size_t lines: {1u, 100u, 5000u}) {
+        ProgramGenerator generator(sized(lines, 3));
+        const std::string src = generator.generate();
+        EXPECT_EQ(static_cast<size_t>(std::ranges::count(src, '\n')), generator.lines());
+        EXPECT_GE(generator.lines(), lines);
+        EXPECT_LT(generator.lines(), lines + 200);
+        EXPECT_TRUE(src.ends_with("}\n")) << "cut inside a declaration";
+    }
+}
+
+TEST(ProgramGenerator, EmitsEveryDeclarationKind) {
+    const std::string src = generate(sized(3000, 1));
+    for (const char* expected: {"fun int ", "class ", "privatew ", "protectedw ", "struct ", "template<typename T",
+                                "actor ", "    on ", "freeobj ", "=> ", "while (", "for (int ", "do {"}) {
+        EXPECT_NE(src.find(expected), std::string::npos) << expected;
+    }
+}
+
+// ===========================================================================
+// 2. Validity
+// ===========================================================================
+
+TEST(ProgramGenerator, ProgramsParseWithoutErrors) {
+    for (uint64_t seed = 1; seed <= 5; ++seed) {
+        const auto [program, errors] = parse(generate(sized(2000, seed)));
+        EXPECT_EQ(errors, 0u) << "seed " << seed;
+        EXPECT_EQ(program->toString().find("PARSE ERROR"), std::string::npos) << "seed " << seed;
+    }
+}
+
+TEST(ProgramGenerator, AnalyzableProgramsAnalyzeWithoutErrors) {
+    const std::string src = generate(ProgramGenerator::Options::analyzable(2000, 4));
+    EXPECT_EQ(src.find("=> "), std::string::npos);
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostream discard(nullptr);
+    auto program = Parser(Lexer(src, "<test>").tokenize(), flags, reporter, discard).parse();
+    SemanticAnalyzer analyzer(reporter);
+    analyzer.analyze(program);
+    EXPECT_EQ(diagnostics.errorCount(), 0u);
+}
+
+TEST(ProgramGenerator, InjectsErrorsAtTheRequestedRate) {
+    auto options = sized(10000, 2);
+    options.errorsPerKLoc = 2;
+    ProgramGenerator generator(options);
+    const std::string src = generator.generate();
+    const size_t expected = generator.lines() * 2 / 1000;
+    EXPECT_GE(generator.injectedErrors() + 1, expected);
+    EXPECT_LE(generator.injectedErrors(), expected);
+    EXPECT_GT(parse(src).errors, 0u);
+}
@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <vector>
+#include <bench/ProgramGenerator.hpp>
+#include <driver/QueryEngine.hpp>
+#include <exceptions/ErrorReporter.hpp>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+
+using namespace zenith;
+using Query = QueryEngine::Query;
+
+static const std::string PROGRAM =
+    "int limit = 10\n"
+    "fun int twice(int x) {\n"
+    "    return x * 2\n"
+    "}\n"
+    "fun int thrice(int x) {\n"
+    "    return x * 3\n"
+    "}\n"
+    "class Point {\n"
+    "    public int x;\n"
+    "    public fun int scaled(int by) {\n"
+    "        return twice(by) + limit\n"
+    "    }\n"
+    "}\n"
+    "fun int main(Point p) {\n"
+    "    int total = twice(limit)\n"
+    "    total = total + p.x\n"
+    "    return total\n"
+    "}\n";
+
+static std::string describe(const std::vector<Diagnostic>& diagnostics) {
+    std::ostringstream out;
+    for (const auto& d: diagnostics) out << d.loc.line << ':' << d.loc.column << ' ' << d.message << '\n';
+    return out.str();
+}
+
+static std::string replaced(std::string source, const std::string& from, const std::string& to) {
+    const size_t at = source.find(from);
+    EXPECT_NE(at, std::string::npos) << from;
+    return source.replace(at, from.size(), to);
+}
+
+static std::string fresh(const std::string& source) {
+    QueryEngine engine;
+    engine.setSource("a.zn", source);
+    return describe(engine.diagnostics("a.zn"));
+}
+
+// The Driver's way: lex, parse and analyze the whole file at once
+static std::string direct(const std::string& source) {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    const Flags flags;
+    std::ostream discard(nullptr);
+    Parser parser(Lexer(source, "a.zn").tokenize(), flags, reporter, discard);
+    auto program = parser.parse();
+    SemanticAnalyzer(reporter).analyze(program);
+    return describe(diagnostics.collect());
+}
+
+// Diagnostics after moving engine to source, with the counts of that update alone
+static std::string edit(QueryEngine& engine, const std::string& source) {
+    engine.resetCounts();
+    engine.setSource("a.zn", source);
+    return describe(engine.diagnostics("a.zn"));
+}
+
+static size_t executed(const QueryEngine& engine, const Query query) {
+    return engine.count(query).unchanged + engine.count(query).changed;
+}
+
+// ===========================================================================
+// 1. Results
+// ===========================================================================
+
+TEST(QueryEngine, FreshEngineAgreesWithTheAnalyzer) {
+    const std::string broken = replaced(replaced(PROGRAM, "x * 3", "x * nope"), "p.x", "p.y");
+    EXPECT_EQ(fresh(PROGRAM), direct(PROGRAM));
+    EXPECT_EQ(fresh(broken), direct(broken));
+    EXPECT_NE(fresh(broken), "");
+}
+
+TEST(QueryEngine, FreshEngineAgreesWithTheAnalyzerOnGeneratedPrograms) {
+    for (const uint64_t seed: {1u, 2u, 3u}) {
+        const std::string source = ProgramGenerator(ProgramGenerator::Options::analyzable(400, seed)).generate();
+        EXPECT_EQ(fresh(source), direct(source)) << "seed " << seed;
+    }
+}
+
+TEST(QueryEngine, IncrementalResultsMatchAFreshEngine) {
+    QueryEngine engine;
+    std::string source = PROGRAM;
+    engine.setSource("a.zn", source);
+    (void)engine.diagnostics("a.zn");
+    const std::vector<std::pair<std::string, std::string>> edits{
+        {"x * 2", "x * missing"},
+        {"int limit = 10", "int limit = 10\nint extra = 1"},
+        {"x * missing", "x * extra"},
+        {"fun int thrice(int x)", "fun int thrice(int x, int y)"},
+        {"public int x;", "public int x;\n    public int y;"},
+        {"return total", "return total +"},
+        {"return total +", "return total"},
+        {"int extra = 1\n", ""},
+    };
+    for (const auto& [from, to]: edits) {
+        source = replaced(source, from, to);
+        EXPECT_EQ(edit(engine, source), fresh(source)) << "after " << from << " -> " << to;
+    }
+}
+
+TEST(QueryEngine, SameTextKeepsTheRevision) {
+    QueryEngine engine;
+    engine.setSource("a.zn", PROGRAM);
+    const uint64_t revision = engine.currentRevision();
+    (void)engine.diagnostics("a.zn");
+    engine.setSource("a.zn", PROGRAM);
+    EXPECT_EQ(engine.currentRevision(), revision);
+    engine.resetCounts();
+    (void)engine.diagnostics("a.zn");
+    EXPECT_EQ(executed(engine, Query::DIAGNOSTICS), 0u);
+}
+
+// ===========================================================================
+// 2. What an edit recomputes
+// ===========================================================================
+
+TEST(QueryEngine, BodyEditChecksOnlyThatBody) {
+    QueryEngine engine;
+    engine.setSource("a.zn", PROGRAM);
+    (void)engine.diagnostics("a.zn");
+    const std::string source = replaced(PROGRAM, "x * 3", "x * 4");
+    EXPECT_EQ(edit(engine, source), fresh(source));
+    EXPECT_EQ(executed(engine, Query::CHECK_BODY), 1u);
+    EXPECT_EQ(executed(engine, Query::GLOBAL_SCOPE), 0u);
+    EXPECT_EQ(engine.count(Query::SIGNATURE).changed, 0u);
+    EXPECT_GE(engine.count(Query::CHECK_BODY).green, 2u);
+}
+
+TEST(QueryEngine, SignatureChangeRechecksItsCallersOnly) {
+    QueryEngine engine;
+    engine.setSource("a.zn", PROGRAM);
+    (void)engine.diagnostics("a.zn");
+    const std::string source = replaced(PROGRAM, "fun int twice(int x)", "fun int twice(long x)");
+    EXPECT_EQ(edit(engine, source), fresh(source));
+    EXPECT_EQ(engine.count(Query::SIGNATURE).changed, 1u);
+    EXPECT_EQ(executed(engine, Query::GLOBAL_SCOPE), 1u);
+    // twice itself, Point.scaled and main call it; thrice does not
+    EXPECT_EQ(executed(engine, Query::CHECK_BODY), 3u);
+}
+
+TEST(QueryEngine, NewGlobalRechecksTheBodyThatMissedIt) {
+    QueryEngine engine;
+    std::string source = replaced(PROGRAM, "x * 3", "x * later");
+    engine.setSource("a.zn", source);
+    EXPECT_NE(describe(engine.diagnostics("a.zn")).find("later"), std::string::npos);
+    source = replaced(source, "int limit = 10", "int limit = 10\nint later = 2");
+    const std::string after = edit(engine, source);
+    EXPECT_EQ(after, fresh(source));
+    EXPECT_EQ(after.find("later"), std::string::npos);
+    EXPECT_GE(executed(engine, Query::CHECK_BODY), 1u);
+}
+
+TEST(QueryEngine, LineAtTheTopMovesDiagnosticsWithoutCheckingBodies) {
+    QueryEngine engine;
+    const std::string broken = replaced(PROGRAM, "p.x", "p.y");
+    engine.setSource("a.zn", broken);
+    const auto before = engine.diagnostics("a.zn");
+    ASSERT_FALSE(before.empty());
+    const std::string source = "\n" + broken;
+    engine.resetCounts();
+    engine.setSource("a.zn", source);
+    const auto after = engine.diagnostics("a.zn");
+    EXPECT_EQ(describe(after), fresh(source));
+    ASSERT_EQ(after.size(), before.size());
+    for (size_t i = 0; i < after.size(); ++i) EXPECT_EQ(after[i].loc.line, before[i].loc.line + 1);
+    EXPECT_EQ(executed(engine, Query::CHECK_BODY), 0u);
+    EXPECT_EQ(engine.count(Query::DECLARATION).changed, 0u);
+}
+
+TEST(QueryEngine, BodiesStayGreenAcrossALexError) {
+    QueryEngine engine;
+    engine.setSource("a.zn", PROGRAM);
+    (void)engine.diagnostics("a.zn");
+    const std::string broken = replaced(PROGRAM, "x * 3", "x * \"3");
+    EXPECT_NE(edit(engine, broken), "");
+    EXPECT_EQ(edit(engine, PROGRAM), fresh(PROGRAM));
+    EXPECT_EQ(executed(engine, Query::CHECK_BODY), 0u);
+    EXPECT_EQ(executed(engine, Query::GLOBAL_SCOPE), 0u);
+}
+
+TEST(QueryEngine, BodyEditInAGeneratedModuleChecksAFewBodies) {
+    std::string source = ProgramGenerator(ProgramGenerator::Options::analyzable(3000, 7)).generate();
+    QueryEngine engine;
+    engine.setSource("a.zn", source);
+    (void)engine.diagnostics("a.zn");
+    const size_t middle = source.find("\n    return ", source.size() / 2) + 1;
+    source.insert(middle, "    int edited = 0\n");
+    EXPECT_EQ(edit(engine, source), fresh(source));
+    EXPECT_LE(executed(engine, Query::CHECK_BODY), 2u);
+    EXPECT_EQ(executed(engine, Query::GLOBAL_SCOPE), 0u);
+    EXPECT_GT(engine.count(Query::CHECK_BODY).green, 50u);
+}
+
+TEST(QueryEngine, StoppedRunResumesWhereItStopped) {
+    QueryEngine engine;
+    engine.setSource("a.zn", PROGRAM);
+    std::stop_source stop;
+    stop.request_stop();
+    EXPECT_FALSE(engine.diagnostics("a.zn", stop.get_token()));
+    EXPECT_EQ(executed(engine, Query::DIAGNOSTICS), 0u);
+
+    (void)engine.parse("a.zn");
+    engine.resetCounts();
+    const auto all = engine.diagnostics("a.zn", std::stop_token{});
+    ASSERT_TRUE(all);
+    EXPECT_EQ(describe(*all), direct(PROGRAM));
+    EXPECT_EQ(executed(engine, Query::PROGRAM), 0u);
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <exceptions/DiagnosticsEngine.hpp>
+#include <SemanticAnalysis/SemanticAnalyzer.hpp>
+#include <utils/ThreadPool.hpp>
+#include <test/ParsedProgram.hpp>
+
+using namespace zenith;
+
+struct Analysis {
+    std::vector<std::string> diagnostics; // "line:column severity message", in reporting order
+    size_t errors;
+    bool globalsFrozen;
+};
+
+static Analysis analyze(const std::string& src, ThreadPool* pool = nullptr) {
+    ParsedProgram parsed(src);
+    SemanticAnalyzer analyzer(parsed.reporter, pool);
+    const SymbolTable symbols = analyzer.analyze(parsed.program);
+
+    Analysis result{{}, parsed.diagnostics.errorCount(), symbols.isFrozen()};
+    for (const auto& d: parsed.diagnostics.collect()) {
+        result.diagnostics.push_back(std::to_string(d.loc.line) + ":" + std::to_string(d.loc.column) + " " +
+                                     (d.severity == Severity::WARNING ? "warning " : "error ") + d.message);
+    }
+    return result;
+}
+
+static std::string join(const std::vector<std::string>& lines) {
+    std::string text;
+    for (const auto& line: lines) text += line + "\n";
+    return text;
+}
+
+// Functions that each break in their body, so every body task reports
+static std::string brokenBodies(const size_t count) {
+    std::string src;
+    for (size_t i = 0; i < count; ++i) {
+        const std::string n = std::to_string(i);
+        src += "fun int f" + n + "(int a) {\n"
+               "    int local" + n + " = a + " + n + "\n"
+               "    string s = local" + n + "\n"
+               "    return missing" + n + "\n"
+               "}\n";
+    }
+    return src;
+}
+
+// ===========================================================================
+// 1. Phase 1 declares every global before any body is checked
+// ===========================================================================
+
+TEST(SemanticAnalyzer, BodiesSeeFunctionsDeclaredAfterThem) {
+    const auto result = analyze(
+        "fun int first() {\n"
+        "    return second(1) + 1\n"
+        "}\n"
+        "fun int second(int x) {\n"
+        "    return x\n"
+        "}\n");
+    EXPECT_EQ(result.errors, 0u) << join(result.diagnostics);
+}
+
+TEST(SemanticAnalyzer, SignaturesSeeClassesDeclaredAfterThem) {
+    const auto result = analyze(
+        "fun Shape make(Shape s) {\n"
+        "    return s\n"
+        "}\n"
+        "class Shape {\n"
+        "    public int sides;\n"
+        "}\n");
+    EXPECT_EQ(result.errors, 0u) << join(result.diagnostics);
+}
+
+TEST(SemanticAnalyzer, GlobalsAreSeenFromEveryBody) {
+    const auto result = analyze(
+        "fun int read() {\n"
+        "    return limit\n"
+        "}\n"
+        "int limit = 3\n");
+    EXPECT_EQ(result.errors, 0u) << join(result.diagnostics);
+}
+
+// ===========================================================================
+// 2. Phase 2 checks bodies against a frozen global scope
+// ===========================================================================
+
+TEST(SemanticAnalyzer, GlobalScopeIsFrozenAfterAnalysis) {
+    const auto result = analyze("int limit = 3\n");
+    EXPECT_EQ(result.errors, 0u);
+    EXPECT_TRUE(result.globalsFrozen);
+}
+
+TEST(SemanticAnalyzer, LocalsDoNotLeakIntoOtherBodies) {
+    ThreadPool pool(4);
+    for (ThreadPool* p: {static_cast<ThreadPool*>(nullptr), &pool}) {
+        const auto result = analyze(
+            "fun int declares() {\n"
+            "    int hidden = 1\n"
+            "    return hidden\n"
+            "}\n"
+            "fun int uses() {\n"
+            "    return hidden\n"
+            "}\n", p);
+        EXPECT_NE(std::ranges::find(result.diagnostics, "6:12 error Undeclared variable 'hidden'"),
+                  result.diagnostics.end()) << join(result.diagnostics);
+    }
+}
+
+TEST(SemanticAnalyzer, FrozenSymbolTableRejectsDeclarations) {
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    SymbolTable symbols(reporter);
+    symbols.freeze();
+    symbols.declare("late", SymbolInfo(SymbolInfo::VARIABLE, nullptr, nullptr));
+    EXPECT_EQ(diagnostics.errorCount(), 1u);
+    EXPECT_FALSE(symbols.lookup("late"));
+}
+
+// ===========================================================================
+// 3. Diagnostics do not depend on the number of threads
+// ===========================================================================
+
+TEST(SemanticAnalyzer, ParallelBodiesReportLikeSequentialOnes) {
+    const std::string src = brokenBodies(200);
+    const auto sequential = analyze(src);
+    ASSERT_EQ(sequential.errors, 400u);
+
+    for (const size_t threads: {2u, 4u, 8u}) {
+        ThreadPool pool(threads);
+        for (int run = 0; run < 3; ++run) {
+            const auto parallel = analyze(src, &pool);
+            EXPECT_EQ(join(parallel.diagnostics), join(sequential.diagnostics)) << threads << " threads, run " << run;
+        }
+    }
+}
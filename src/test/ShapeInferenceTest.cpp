@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <SemanticAnalysis/ShapeInference.hpp>
+#include <test/ParsedProgram.hpp>
+
+using namespace zenith;
+
+// The literals stay valid as long as the program they point into
+struct Inferred {
+    ParsedProgram parsed;
+    ShapeInference inference;
+
+    explicit Inferred(const std::string& src) : parsed(src) { inference.analyze(*parsed.program); }
+};
+
+// The single freeobj literal on 'line'
+static const ShapeInfo& at(const Inferred& result, const size_t line) {
+    const ShapeInfo* found = nullptr;
+    for (const auto& literal: result.inference.results()) {
+        if (literal.node->loc.line != line) continue;
+        EXPECT_EQ(found, nullptr) << "more than one literal on line " << line;
+        found = &literal.node->shape;
+    }
+    if (!found) ADD_FAILURE() << "no literal on line " << line;
+    static const ShapeInfo missing;
+    return found ? *found : missing;
+}
+
+static std::string shapeOf(const Inferred& result, const uint32_t shape) {
+    return shape == ShapeInfo::UNKNOWN ? "?" : result.inference.shapes().toString(shape);
+}
+
+// ===========================================================================
+// 1. Shape tree
+// ===========================================================================
+
+TEST(ShapeTree, SamePropertiesInTheSameOrderShareAShape) {
+    ShapeTree tree;
+    const uint32_t xy = tree.addProperty(tree.addProperty(ShapeTree::EMPTY, "x", "number"), "y", "number");
+    EXPECT_EQ(tree.addProperty(tree.addProperty(ShapeTree::EMPTY, "x", "number"), "y", "number"), xy);
+    EXPECT_NE(tree.addProperty(tree.addProperty(ShapeTree::EMPTY, "y", "number"), "x", "number"), xy);
+    EXPECT_NE(tree.addProperty(tree.addProperty(ShapeTree::EMPTY, "x", "string"), "y", "number"), xy);
+    EXPECT_EQ(tree.size(), 7u); // The root and two properties for each distinct order or type
+}
+
+TEST(ShapeTree, SlotsFollowInsertionOrder) {
+    ShapeTree tree;
+    const uint32_t shape = tree.addProperty(tree.addProperty(ShapeTree::EMPTY, "b", "string"), "a", "number");
+    EXPECT_EQ(tree.slotOf(shape, "b"), 0u);
+    EXPECT_EQ(tree.slotOf(shape, "a"), 1u);
+    EXPECT_EQ(tree.slotOf(shape, "c"), std::nullopt);
+    EXPECT_EQ(tree.typeOf(shape, "a"), "number");
+    EXPECT_EQ(tree.toString(shape), "{b: string, a: number}");
+}
+
+TEST(ShapeTree, RetypeKeepsTheOrder) {
+    ShapeTree tree;
+    const uint32_t shape = tree.addProperty(tree.addProperty(ShapeTree::EMPTY, "x", "number"), "y", "number");
+    const uint32_t retyped = tree.retype(shape, "x", "dynamic");
+    EXPECT_EQ(tree.toString(retyped), "{x: dynamic, y: number}");
+    EXPECT_EQ(tree.slotOf(retyped, "y"), 1u);
+}
+
+// ===========================================================================
+// 2. Fixed layouts
+// ===========================================================================
+
+TEST(ShapeInference, UnchangedLiteralHasAFixedLayout) {
+    const Inferred result(
+        "fun point() {\n"
+        "    var p = { x: 1, name: \"origin\" }\n"
+        "    p.x = 2\n"
+        "    return p.x + 0\n"
+        "}\n");
+    const ShapeInfo& shape = at(result, 2);
+    EXPECT_TRUE(shape.fixedLayout());
+    EXPECT_EQ(shapeOf(result, shape.initial), "{x: number, name: string}");
+    EXPECT_EQ(shape.final, shape.initial);
+}
+
+TEST(ShapeInference, LiteralsWithTheSamePropertiesShareAShapeAcrossFunctions) {
+    const Inferred result(
+        "fun a() {\n"
+        "    var p = { x: 1, y: 2 }\n"
+        "    return p.x + 0\n"
+        "}\n"
+        "fun b() {\n"
+        "    var q = { x: 3, y: 4 }\n"
+        "    var r = { y: 4, x: 3 }\n"
+        "    return q.x + r.x\n"
+        "}\n");
+    EXPECT_EQ(at(result, 2).initial, at(result, 6).initial);
+    EXPECT_NE(at(result, 2).initial, at(result, 7).initial);
+}
+
+TEST(ShapeInference, RepeatedKeyOfAnotherTypeBecomesDynamic) {
+    const Inferred result(
+        "fun twice() {\n"
+        "    var p = { x: 1, x: \"one\" }\n"
+        "    return p.x + 0\n"
+        "}\n");
+    EXPECT_EQ(shapeOf(result, at(result, 2).initial), "{x: dynamic}");
+}
+
+// ===========================================================================
+// 3. Shape changes
+// ===========================================================================
+
+TEST(ShapeInference, AddedPropertiesAreFollowedInStraightLineCode) {
+    const Inferred result(
+        "fun grow() {\n"
+        "    var p = { x: 1 }\n"
+        "    var alias = p\n"
+        "    alias.y = 2\n"
+        "    p.label = \"p\"\n"
+        "    return p.x + 0\n"
+        "}\n");
+    const ShapeInfo& shape = at(result, 2);
+    EXPECT_FALSE(shape.fixedLayout());
+    EXPECT_EQ(shape.changes, ShapeInfo::ADD);
+    EXPECT_EQ(shapeOf(result, shape.initial), "{x: number}");
+    EXPECT_EQ(shapeOf(result, shape.final), "{x: number, y: number, label: string}");
+    EXPECT_EQ(result.inference.shapes().slotOf(shape.final, "label"), 2u);
+}
+
+TEST(ShapeInference, PropertyGivenAnotherTypeBecomesDynamic) {
+    const Inferred result(
+        "fun retype() {\n"
+        "    var p = { x: 1, y: 2 }\n"
+        "    p.x = \"one\"\n"
+        "    return p.y + 0\n"
+        "}\n");
+    const ShapeInfo& shape = at(result, 2);
+    EXPECT_EQ(shape.changes, ShapeInfo::RETYPE);
+    EXPECT_EQ(shapeOf(result, shape.final), "{x: dynamic, y: number}");
+}
+
+TEST(ShapeInference, PropertyAddedInABranchLosesTheFinalShape) {
+    const Inferred result(
+        "fun maybe(bool flag) {\n"
+        "    var p = { x: 1 }\n"
+        "    if (flag) {\n"
+        "        p.y = 2\n"
+        "    }\n"
+        "    return p.x + 0\n"
+        "}\n");
+    const ShapeInfo& shape = at(result, 2);
+    EXPECT_EQ(shape.changes, ShapeInfo::CONDITIONAL);
+    EXPECT_EQ(shape.final, ShapeInfo::UNKNOWN);
+    EXPECT_EQ(shapeOf(result, shape.initial), "{x: number}");
+}
+
+TEST(ShapeInference, LiteralCreatedInsideALoopIsFollowedThere) {
+    const Inferred result(
+        "fun loop() {\n"
+        "    while (true) {\n"
+        "        var p = { x: 1 }\n"
+        "        p.y = 2\n"
+        "    }\n"
+        "    return 0\n"
+        "}\n");
+    EXPECT_EQ(shapeOf(result, at(result, 3).final), "{x: number, y: number}");
+}
+
+TEST(ShapeInference, ComputedKeyLosesTheFinalShape) {
+    const Inferred result(
+        "fun computed() {\n"
+        "    var p = { x: 1 }\n"
+        "    p[\"y\"] = 2\n"
+        "    return p.x + 0\n"
+        "}\n");
+    const ShapeInfo& shape = at(result, 2);
+    EXPECT_EQ(shape.changes, ShapeInfo::COMPUTED);
+    EXPECT_EQ(shape.final, ShapeInfo::UNKNOWN);
+}
+
+TEST(ShapeInference, ObjectsThatLeaveTheFunctionAreAliased) {
+    const Inferred result(
+        "var global = { g: 0 }\n"
+        "fun leave() {\n"
+        "    var passed = { a: 1 }\n"
+        "    print(passed)\n"
+        "    var captured = { b: 1 }\n"
+        "    var read = () => captured.b\n"
+        "    var returned = { c: 1 }\n"
+        "    return returned\n"
+        "}\n");
+    for (const size_t line: {1u, 3u, 5u, 7u}) {
+        EXPECT_EQ(at(result, line).changes, ShapeInfo::ALIASED) << "line " << line;
+        EXPECT_EQ(at(result, line).final, ShapeInfo::UNKNOWN) << "line " << line;
+    }
+}
+
+TEST(ShapeInference, ReportListsEveryLiteral) {
+    const Inferred result(
+        "fun grow() {\n"
+        "    var fixed = { x: 1 }\n"
+        "    var grown = { x: 1 }\n"
+        "    grown.y = 2\n"
+        "    return fixed.x + grown.x\n"
+        "}\n");
+    std::ostringstream out;
+    result.inference.report(out);
+    EXPECT_NE(out.str().find("2 freeobj literal(s), 1 with a fixed layout"), std::string::npos) << out.str();
+    EXPECT_NE(out.str().find("<test>:2:17: in 'grow': {x: number} fixed"), std::string::npos) << out.str();
+    EXPECT_NE(out.str().find("{x: number} -> {x: number, y: number} (add)"), std::string::npos) << out.str();
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utils/small_vector.hpp>
+#include <utils/Arena.hpp>
+#include <core/polymorphic.hpp>
+
+using namespace zenith;
+
+// Counts live instances, so leaks and double destruction show up as a nonzero balance
+struct Tracked {
+    static inline int live = 0;
+    int value;
+
+    Tracked(const int value) : value(value) { ++live; }
+    Tracked(const Tracked& other) : value(other.value) { ++live; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) noexcept = default;
+    ~Tracked() { --live; }
+};
+
+static_assert(!is_trivially_relocatable_v<Tracked>);
+static_assert(!is_trivially_relocatable_v<std::string>);
+static_assert(is_trivially_relocatable_v<int>);
+static_assert(is_trivially_relocatable_v<std::shared_ptr<int>>);
+static_assert(is_trivially_relocatable_v<polymorphic<std::string>>);
+static_assert(!is_trivially_relocatable_v<std::pair<std::string, polymorphic<std::string>>>);
+
+template<typename Vector>
+static std::vector<int> values(const Vector& v) {
+    std::vector<int> result;
+    for (const auto& item: v) result.push_back(item.value);
+    return result;
+}
+
+template<typename Vector>
+static std::vector<int> pointees(const Vector& v) {
+    std::vector<int> result;
+    for (const auto& item: v) result.push_back(*item);
+    return result;
+}
+
+// ===========================================================================
+// 1. Layout
+// ===========================================================================
+
+TEST(SmallVector, OneWordOfBookkeeping) {
+#ifdef ZENITH_SMALL_VECTOR_STATS
+    GTEST_SKIP() << "every vector also holds its construction site";
+#endif
+    // The inline buffer holds the heap pointer once spilled; length and capacity share a word
+    EXPECT_EQ(sizeof(small_vector<std::shared_ptr<int>, 4>), 4 * sizeof(std::shared_ptr<int>) + 8);
+    EXPECT_EQ(sizeof(small_vector<int, 1>), sizeof(void*) + 8);
+}
+
+TEST(SmallVector, SpillsPastTheInlineCapacity) {
+    small_vector<int, 2> v;
+    v.push_back(1);
+    v.push_back(2);
+    EXPECT_FALSE(v.spilled());
+    EXPECT_EQ(v.capacity(), 2u);
+    v.push_back(3);
+    EXPECT_TRUE(v.spilled());
+    EXPECT_EQ(v.capacity(), 4u);
+    EXPECT_EQ(std::vector(v.begin(), v.end()), (std::vector{1, 2, 3}));
+
+    v.pop_back();
+    v.shrink_to_fit();
+    EXPECT_FALSE(v.spilled());
+    EXPECT_EQ(std::vector(v.begin(), v.end()), (std::vector{1, 2}));
+}
+
+// ===========================================================================
+// 2. Element lifetimes
+// ===========================================================================
+
+TEST(SmallVector, MovesAndSwapsKeepEveryElementOnce) {
+    {
+        small_vector<Tracked, 2> small, large;
+        small.emplace_back(1);
+        for (int i = 0; i < 5; ++i) large.emplace_back(10 + i);
+
+        small.swap(large);
+        EXPECT_EQ(values(small), (std::vector{10, 11, 12, 13, 14}));
+        EXPECT_EQ(values(large), (std::vector{1}));
+
+        small_vector<Tracked, 2> moved(std::move(large));
+        EXPECT_TRUE(large.empty());
+        EXPECT_EQ(values(moved), (std::vector{1}));
+
+        moved = std::move(small);
+        EXPECT_EQ(values(moved), (std::vector{10, 11, 12, 13, 14}));
+        EXPECT_EQ(Tracked::live, 5);
+
+        moved.erase_range(moved.begin() + 1, moved.begin() + 3);
+        EXPECT_EQ(values(moved), (std::vector{10, 13, 14}));
+        EXPECT_EQ(Tracked::live, 3);
+    }
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(SmallVector, RelocatesSharedPointersByBytes) {
+    auto first = std::make_shared<int>(1);
+    {
+        small_vector<std::shared_ptr<int>, 2> v;
+        v.push_back(first);
+        for (int i = 2; i <= 6; ++i) v.push_back(std::make_shared<int>(i));
+        EXPECT_EQ(first.use_count(), 2); // Growing copied bytes, it took no extra reference
+
+        small_vector<std::shared_ptr<int>, 2> w;
+        w.push_back(std::make_shared<int>(0));
+        v.swap(w);
+        EXPECT_EQ(pointees(w), (std::vector{1, 2, 3, 4, 5, 6}));
+
+        w.erase_range(w.begin(), w.begin() + 2);
+        EXPECT_EQ(pointees(w), (std::vector{3, 4, 5, 6}));
+        EXPECT_EQ(first.use_count(), 1);
+    }
+    EXPECT_EQ(first.use_count(), 1);
+}
+
+TEST(SmallVector, PushingAnOwnElementWhileFull) {
+    small_vector<std::string, 2> v;
+    v.push_back(std::string(40, 'a'));
+    v.push_back("b");
+    v.push_back(v.front()); // Refers into the buffer being replaced
+    EXPECT_EQ(v.back(), std::string(40, 'a'));
+}
+
+TEST(SmallVector, TakesElementsFromStdVector) {
+    std::vector<std::string> source{"a", "b", "c"};
+    small_vector<std::string, 2> v(std::move(source));
+    EXPECT_TRUE(source.empty());
+    EXPECT_EQ(std::vector<std::string>(v.begin(), v.end()), (std::vector<std::string>{"a", "b", "c"}));
+}
+
+// ===========================================================================
+// 3. Allocators
+// ===========================================================================
+
+TEST(SmallVector, SpillsIntoAnArena) {
+    Arena arena;
+    {
+        small_vector<std::shared_ptr<int>, 2, ArenaAllocator<std::shared_ptr<int>>> v{ArenaAllocator<std::shared_ptr<int>>(arena)};
+        v.push_back(std::make_shared<int>(1));
+        v.push_back(std::make_shared<int>(2));
+        EXPECT_EQ(arena.bytes(), 0u);
+        v.push_back(std::make_shared<int>(3));
+        EXPECT_EQ(arena.bytes(), 4 * sizeof(std::shared_ptr<int>));
+
+        auto moved = std::move(v);
+        EXPECT_EQ(moved.get_allocator().arena, &arena);
+        EXPECT_EQ(pointees(moved), (std::vector{1, 2, 3}));
+    }
+    EXPECT_EQ(arena.blockCount(), 1u);
+}
+
+TEST(SmallVector, ArenaAlignsEachAllocation) {
+    Arena arena;
+    (void) arena.allocate(1, 1);
+    const void* aligned = arena.allocate(8, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0u);
+    (void) arena.allocate(100 * 1024); // Larger than a block gets its own
+    EXPECT_EQ(arena.blockCount(), 2u);
+}
+
+// ===========================================================================
+// 4. Statistics
+// ===========================================================================
+
+TEST(SmallVector, RecordsLengthsPerSite) {
+#ifndef ZENITH_SMALL_VECTOR_STATS
+    GTEST_SKIP() << "built without ZENITH_SMALL_VECTOR_STATS";
+#else
+    small_vector_stats::reset();
+    for (int length = 0; length < 4; ++length) {
+        small_vector<int, 2> v;
+        for (int i = 0; i < length; ++i) v.push_back(i);
+        auto moved = std::move(v); // Counted here, not where it was emptied
+    }
+    const auto sites = small_vector_stats::collect();
+    ASSERT_EQ(sites.size(), 1u);
+    EXPECT_NE(sites[0].site.find("SmallVectorTest.cpp"), std::string::npos);
+    EXPECT_EQ(sites[0].inlineCapacity, 2u);
+    EXPECT_EQ(sites[0].counts, (std::map<size_t, size_t>{{0, 1}, {1, 1}, {2, 1}, {3, 1}}));
+#endif
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <lexer/lexer.hpp>
+#include <parser/parser.hpp>
+#include <syntax/SyntaxTree.hpp>
+#include <exceptions/DiagnosticsEngine.hpp>
+
+using namespace zenith;
+
+static SyntaxTree syntaxTree(const std::string& src) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    return SyntaxTree::parse(src, "<test>", flags, reporter);
+}
+
+static std::string directAst(const std::string& src) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostringstream log;
+    Parser parser(Lexer(src, "<test>").tokenize(), flags, reporter, log);
+    return parser.parse()->toString();
+}
+
+static std::string loweredAst(const SyntaxTree& tree) {
+    Flags flags;
+    DiagnosticsEngine diagnostics;
+    ErrorReporter reporter(diagnostics);
+    std::ostringstream log;
+    return tree.lower(flags, reporter, log)->toString();
+}
+
+// First node of the given kind in a depth-first walk
+static std::optional<SyntaxNode> findNode(const SyntaxNode& node, SyntaxKind kind) {
+    if (node.kind() == kind) return node;
+    for (const auto& child: node.childNodes()) {
+        if (auto found = findNode(child, kind)) return found;
+    }
+    return std::nullopt;
+}
+
+static const std::string SAMPLE =
+    "// Animals\n"
+    "class Animal {\n"
+    "    public int age; /* years */\n"
+    "}\n"
+    "\n"
+    "fun int add(int a, int b) {\n"
+    "    return a + b * 2   // trailing\n"
+    "}\n"
+    "fun main() {\n"
+    "\tvar x = add(1, 2)\n"
+    "\tx.y[3] = (x) => x\n"
+    "}\n";
+
+// ===========================================================================
+// 1. Lossless: the tree reproduces the source and the parser's view of it
+// ===========================================================================
+
+TEST(SyntaxTree, RoundTripsSourceWithTrivia) {
+    const auto tree = syntaxTree(SAMPLE);
+    EXPECT_EQ(tree.text(), SAMPLE);
+    EXPECT_EQ(tree.root().kind(), SyntaxKind::SOURCE_FILE);
+    EXPECT_EQ(tree.root().end(), SAMPLE.size());
+}
+
+TEST(SyntaxTree, RoundTripsSourceWithSyntaxErrors) {
+    const std::string src = "fun f() {\n    g(h(x, ), b)\n}\nfun g() { return 1 }\n";
+    const auto tree = syntaxTree(src);
+    EXPECT_EQ(tree.text(), src);
+    // The tokens recovery skipped are kept, under an ERROR node
+    const auto skipped = findNode(tree.root(), SyntaxKind::ERROR);
+    ASSERT_TRUE(skipped.has_value());
+    EXPECT_EQ(skipped->offset(), src.find(", )") + 2);
+}
+
+TEST(SyntaxTree, RoundTripsTemplateStrings) {
+    const std::string src = "var s = `hello`\n";
+    const auto tree = syntaxTree(src);
+    EXPECT_EQ(tree.text(), src);
+    const auto tokens = Lexer(src, "<test>").tokenize();
+    ASSERT_GE(tokens.size(), 7u);
+    EXPECT_EQ(tokens[3].type, TokenType::BACKTICK);
+    EXPECT_EQ(tokens[3].loc.fileOffset, 8u);
+    EXPECT_EQ(tokens[4].lexeme, "hello");
+}
+
+// Every token of a template string sits on its own text, the opening backtick included
+TEST(SyntaxTree, TemplateStringTokensSitOnTheirText) {
+    for (const std::string src: {"var s = `hello`\n", "var s = `a b` + x\n", "f(1)\nvar t = `x`\nvar u = `second line`\n"}) {
+        const auto tokens = Lexer(src, "<test>").tokenize();
+        size_t backticks = 0;
+        for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+            const auto& loc = tokens[i].loc;
+            const size_t lineStart = src.rfind('\n', loc.fileOffset == 0 ? 0 : loc.fileOffset - 1);
+            EXPECT_EQ(src.substr(loc.fileOffset, tokens[i].lexeme.size()), tokens[i].lexeme) << src << "token " << i;
+            EXPECT_EQ(loc.column, loc.fileOffset - (lineStart == std::string::npos ? 0 : lineStart + 1) + 1)
+                << src << "token " << i;
+            if (tokens[i].type == TokenType::BACKTICK) ++backticks;
+        }
+        EXPECT_EQ(backticks % 2, 0u) << src;
+        EXPECT_GT(backticks, 0u) << src;
+    }
+}
+
+TEST(SyntaxTree, TokensMatchTheLexer) {
+    const auto lexed = Lexer(SAMPLE, "<test>").tokenize();
+    const auto rebuilt = syntaxTree(SAMPLE).tokens();
+    ASSERT_EQ(rebuilt.size(), lexed.size());
+    for (size_t i = 0; i + 1 < lexed.size(); ++i) {
+        EXPECT_EQ(rebuilt[i].type, lexed[i].type) << "token " << i;
+        EXPECT_EQ(rebuilt[i].lexeme, lexed[i].lexeme) << "token " << i;
+        EXPECT_EQ(rebuilt[i].loc.line, lexed[i].loc.line) << "token " << i;
+        EXPECT_EQ(rebuilt[i].loc.column, lexed[i].loc.column) << "token " << i;
+        EXPECT_EQ(rebuilt[i].loc.fileOffset, lexed[i].loc.fileOffset) << "token " << i;
+    }
+}
+
+TEST(SyntaxTree, LowersToTheSameAst) {
+    EXPECT_EQ(loweredAst(syntaxTree(SAMPLE)), directAst(SAMPLE));
+}
+
+TEST(SyntaxTree, LeftRecursiveNodesWrapTheirOperands) {
+    const auto tree = syntaxTree("fun f() {\n    a.b(c)[d] + e\n}\n");
+    const auto binary = findNode(tree.root(), SyntaxKind::BINARY);
+    ASSERT_TRUE(binary.has_value());
+    EXPECT_EQ(binary->text(), "a.b(c)[d] + e");
+    const auto index = findNode(tree.root(), SyntaxKind::INDEX);
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->text(), "a.b(c)[d]");
+    const auto call = findNode(tree.root(), SyntaxKind::CALL);
+    ASSERT_TRUE(call.has_value());
+    EXPECT_EQ(call->text(), "a.b(c)");
+}
+
+// ===========================================================================
+// 2. Red layer: absolute positions and parent links
+// ===========================================================================
+
+TEST(SyntaxTree, TokenAtOffset) {
+    const auto tree = syntaxTree(SAMPLE);
+    const size_t offset = SAMPLE.find("add(1");
+    const auto token = tree.root().tokenAt(static_cast<uint32_t>(offset + 1));
+    ASSERT_TRUE(token.has_value());
+    EXPECT_EQ(token->text(), "add");
+    EXPECT_EQ(token->offset(), offset);
+
+    // Up through NAME, CALL, VAR_DECL, BLOCK, FUNCTION to the root
+    std::vector<SyntaxKind> kinds;
+    for (std::optional<SyntaxNode> node = token->parent(); node; node = node->parent()) kinds.push_back(node->kind());
+    EXPECT_EQ(kinds, (std::vector{
+        SyntaxKind::NAME, SyntaxKind::CALL, SyntaxKind::VAR_DECL, SyntaxKind::BLOCK, SyntaxKind::FUNCTION,
+        SyntaxKind::SOURCE_FILE
+    }));
+}
+
+TEST(SyntaxTree, CoveringNode) {
+    const auto tree = syntaxTree(SAMPLE);
+    const auto begin = static_cast<uint32_t>(SAMPLE.find("b * 2"));
+    EXPECT_EQ(tree.root().coveringNode(begin, begin + 5).text(), "b * 2");
+    EXPECT_EQ(tree.root().coveringNode(begin, begin + 5).kind(), SyntaxKind::BINARY);
+}
+
+// ===========================================================================
+// 3. Structural sharing
+// ===========================================================================
+
+TEST(SyntaxTree, IdenticalSubtreesAreShared) {
+    const auto tree = syntaxTree("fun f() {\n    return x + 1\n}\nfun g() {\n    return x + 1\n}\n");
+    const auto functions = tree.root().childNodes();
+    ASSERT_EQ(functions.size(), 2u);
+    const auto first = findNode(functions[0], SyntaxKind::BLOCK);
+    const auto second = findNode(functions[1], SyntaxKind::BLOCK);
+    ASSERT_TRUE(first && second);
+    EXPECT_EQ(first->green(), second->green());
+    EXPECT_NE(first->offset(), second->offset());
+}
+
+TEST(SyntaxTree, EditRebuildsOnlyThePath) {
+    const std::string src = "fun f() {\n    return 1\n}\nfun g() {\n    return 2\n}\n";
+    const auto tree = syntaxTree(src);
+    const auto literal = tree.root().tokenAt(static_cast<uint32_t>(src.find('1')));
+    ASSERT_TRUE(literal.has_value());
+
+    size_t depth = 0;
+    for (std::optional<SyntaxNode> node = literal->parent(); node; node = node->parent()) ++depth;
+
+    auto& arena = *tree.greenArena();
+    const size_t nodesBefore = arena.nodeCount();
+    const auto edited = tree.replace(*literal, arena.token(SyntaxKind::TOKEN, TokenType::INTEGER_LIT, "42"));
+
+    EXPECT_EQ(edited.text(), "fun f() {\n    return 42\n}\nfun g() {\n    return 2\n}\n");
+    EXPECT_EQ(arena.nodeCount() - nodesBefore, depth); // One new node per ancestor, nothing else
+    EXPECT_EQ(edited.root().childNodes()[1].green(), tree.root().childNodes()[1].green());
+    EXPECT_EQ(tree.text(), src); // The old tree is untouched
+    EXPECT_EQ(loweredAst(edited), directAst(edited.text()));
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// A fresh directory under the system temp directory, removed again at the end of the test
+struct TempDir {
+    std::filesystem::path path;
+
+    explicit TempDir(const std::string& name) : path(std::filesystem::temp_directory_path() / ("zenith_" + name)) {
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    // Creates the directories on the way, returns the file's path
+    std::string write(const std::string& relative, const std::string& text) const {
+        const std::filesystem::path file = path / relative;
+        std::filesystem::create_directories(file.parent_path());
+        std::ofstream(file) << text;
+        return file.string();
+    }
+};
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <utils/ThreadPool.hpp>
+
+using namespace zenith;
+
+using Clock = std::chrono::steady_clock;
+
+// Spins until 'done' holds or five seconds pass, a broken pool fails the test instead of hanging it
+template<typename Done>
+static bool waitFor(Done done) {
+    const auto deadline = Clock::now() + std::chrono::seconds(5);
+    while (!done()) {
+        if (Clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// ===========================================================================
+// 1. parallelFor
+// ===========================================================================
+
+TEST(ThreadPool, ParallelForRunsEveryIndexOnce) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> runs(1000);
+    pool.parallelFor(runs.size(), [&](const size_t i) { runs[i].fetch_add(1); });
+    for (size_t i = 0; i < runs.size(); ++i) EXPECT_EQ(runs[i].load(), 1) << "index " << i;
+}
+
+TEST(ThreadPool, ParallelForRethrowsTheFirstException) {
+    ThreadPool pool(4);
+    std::atomic<size_t> finished = 0;
+    EXPECT_THROW(pool.parallelFor(100, [&](const size_t i) {
+        if (i == 42) throw std::runtime_error("body failed");
+        finished.fetch_add(1);
+    }), std::runtime_error);
+    // Every other body still ran before parallelFor returned
+    EXPECT_EQ(finished.load(), 99u);
+}
+
+TEST(ThreadPool, NestedParallelForHelpsWhileWaiting) {
+    // The only worker runs the outer bodies, so the inner ones only make progress if the waiting threads run them
+    ThreadPool pool(1);
+    std::atomic<size_t> inner = 0;
+    pool.parallelFor(4, [&](size_t) {
+        pool.parallelFor(8, [&](size_t) { inner.fetch_add(1); });
+    });
+    EXPECT_EQ(inner.load(), 32u);
+}
+
+// ===========================================================================
+// 2. Work stealing
+// ===========================================================================
+
+TEST(ThreadPool, IdleWorkersStealFromABusyOne) {
+    ThreadPool pool(4);
+    constexpr size_t STOLEN = 3;
+    std::atomic<size_t> arrived = 0;
+    std::atomic<size_t> metUp = 0;
+    std::mutex idsMutex;
+    std::set<std::thread::id> ids;
+    std::latch outerDone(1);
+
+    pool.submit([&] {
+        // Submitted from a worker, these go to its own deque. It then blocks without helping, so the tasks can only
+        // run if the other workers take them from its queue, and only meet if all three run at the same time.
+        for (size_t i = 0; i < STOLEN; ++i) {
+            pool.submit([&] {
+                {
+                    std::lock_guard lock(idsMutex);
+                    ids.insert(std::this_thread::get_id());
+                }
+                arrived.fetch_add(1);
+                if (waitFor([&] { return arrived.load() == STOLEN; })) metUp.fetch_add(1);
+            });
+        }
+        waitFor([&] { return metUp.load() == STOLEN; });
+        outerDone.count_down();
+    });
+    outerDone.wait();
+
+    EXPECT_EQ(metUp.load(), STOLEN);
+    std::lock_guard lock(idsMutex);
+    EXPECT_EQ(ids.size(), STOLEN);
+}
+
+TEST(ThreadPool, DestructorFinishesQueuedTasks) {
+    std::atomic<size_t> ran = 0;
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 100; ++i) pool.submit([&] { ran.fetch_add(1); });
+    }
+    EXPECT_EQ(ran.load(), 100u);
+}
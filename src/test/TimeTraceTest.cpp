@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utils/TimeTrace.hpp>
+#include <utils/ThreadPool.hpp>
+
+using namespace zenith;
+
+struct TracedEvent {
+    std::string phase, name;
+    int tid;
+    long ts, dur;
+};
+
+static std::string finish() {
+    std::ostringstream out;
+    TimeTrace::write(out);
+    return out.str();
+}
+
+// The X and C events of a trace, in the order they were written
+static std::vector<TracedEvent> events(const std::string& json) {
+    static const std::regex event(R"re(\{"ph":"([XC])","pid":1,"tid":(\d+),"ts":(\d+),(?:"dur":(\d+),)?"cat":"[^"]*","name":"([^"]*)")re");
+    std::vector<TracedEvent> result;
+    for (std::sregex_iterator it(json.begin(), json.end(), event), end; it != end; ++it) {
+        const auto& m = *it;
+        result.push_back({m[1], m[5], std::stoi(m[2]), std::stol(m[3]), m[4].matched ? std::stol(m[4]) : 0});
+    }
+    return result;
+}
+
+static const TracedEvent& named(const std::vector<TracedEvent>& all, const std::string& name) {
+    for (const auto& e: all) {
+        if (e.name == name) return e;
+    }
+    throw std::runtime_error("no event " + name);
+}
+
+// ===========================================================================
+// 1. Recording
+// ===========================================================================
+
+TEST(TimeTrace, NothingIsRecordedBeforeStart) {
+    TimeTrace::start();
+    (void) finish();
+    {
+        TimeTrace::Scope scope("Ignored");
+        EXPECT_FALSE(scope);
+        scope.counter("n", 1);
+    }
+    TimeTrace::counter("Ignored", "n", 1);
+    EXPECT_TRUE(events(finish()).empty());
+}
+
+TEST(TimeTrace, ScopesNestWithTheirCounters) {
+    TimeTrace::start();
+    {
+        TimeTrace::Scope outer("Outer");
+        TimeTrace::Scope inner("Inner", "parse");
+        EXPECT_TRUE(inner);
+        inner.counter("tokens", 42);
+        inner.detail("say \"hi\"\n");
+        inner.stop();
+        TimeTrace::counter("AST", "nodes", 7);
+    }
+    const std::string json = finish();
+    const auto all = events(json);
+    ASSERT_EQ(all.size(), 3u);
+    const auto& outer = named(all, "Outer");
+    const auto& inner = named(all, "Inner");
+    EXPECT_LE(outer.ts, inner.ts);
+    EXPECT_GE(outer.ts + outer.dur, inner.ts + inner.dur);
+    EXPECT_EQ(named(all, "AST").phase, "C");
+    EXPECT_NE(json.find(R"("args":{"detail":"say \"hi\"\u000a","tokens":42})"), std::string::npos) << json;
+    EXPECT_NE(json.find(R"("args":{"nodes":7})"), std::string::npos) << json;
+}
+
+TEST(TimeTrace, WorkersGetTheirOwnThreads) {
+    ThreadPool pool(4);
+    TimeTrace::start();
+    pool.parallelFor(64, [](size_t) {
+        TimeTrace::Scope scope("Task");
+    });
+    const std::string json = finish();
+    std::set<int> threads;
+    size_t tasks = 0;
+    for (const auto& e: events(json)) {
+        tasks += e.name == "Task";
+        threads.insert(e.tid);
+    }
+    EXPECT_EQ(tasks, 64u);
+    for (const int tid: threads) {
+        EXPECT_NE(json.find(R"("ph":"M","pid":1,"tid":)" + std::to_string(tid)), std::string::npos);
+    }
+}
@@ -0,0 +1,22 @@
+#include "Arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace zenith {
+	void* Arena::allocate(const size_t size, const size_t alignment) {
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+		size_t padding = -reinterpret_cast<uintptr_t>(cursor) & (alignment - 1);
+		if (size + padding > remaining) {
+			const size_t blockSize = std::max(size + alignment, BLOCK_SIZE);
+			blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(blockSize));
+			cursor = blocks.back().get();
+			remaining = blockSize;
+			padding = -reinterpret_cast<uintptr_t>(cursor) & (alignment - 1);
+		}
+		void* result = cursor + padding;
+		cursor += padding + size;
+		remaining -= padding + size;
+		allocated += size;
+		return result;
+	}
+}
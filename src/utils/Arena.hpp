@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace zenith {
+	// Bump allocator: memory comes out of 64 KiB blocks and is all freed when the arena goes. Not thread-safe.
+	class Arena {
+		std::vector<std::unique_ptr<std::byte[]>> blocks;
+		std::byte* cursor = nullptr;
+		size_t remaining = 0;
+		size_t allocated = 0;
+
+	public:
+		Arena() = default;
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+		Arena(Arena&&) = default;
+		Arena& operator=(Arena&&) = default;
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		// Bytes handed out, not counting alignment padding or the unused end of blocks
+		[[nodiscard]] size_t bytes() const { return allocated; }
+		[[nodiscard]] size_t blockCount() const { return blocks.size(); }
+	};
+
+	// Allocator over an Arena, for containers that die with it; deallocation does nothing
+	template<typename T>
+	struct ArenaAllocator {
+		using value_type = T;
+		Arena* arena;
+
+		explicit ArenaAllocator(Arena& arena) : arena(&arena) {}
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+		T* allocate(const size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+		void deallocate(T*, size_t) noexcept {}
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace zenith {
+	// Blocking queue of at most capacity items from one producer thread to one consumer thread
+	// push() waits while the queue is full, so a fast producer is held to the pace of its consumer. close() ends the
+	// stream from either side: pop() still drains what was pushed before, push() refuses everything after.
+	template<typename T>
+	class BoundedQueue {
+		std::deque<T> items;
+		const size_t capacity;
+		std::mutex mutex;
+		std::condition_variable notFull, notEmpty;
+		bool closed = false;
+		size_t producerWaits = 0; // Pushes that found the queue full
+
+	public:
+		explicit BoundedQueue(const size_t capacity) : capacity(capacity ? capacity : 1) {}
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+		// False when the queue was closed, item is then dropped
+		bool push(T item) {
+			std::unique_lock lock(mutex);
+			if (items.size() >= capacity && !closed) ++producerWaits;
+			notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+			if (closed) return false;
+			items.push_back(std::move(item));
+			notEmpty.notify_one();
+			return true;
+		}
+
+		// Nothing once the queue is closed and empty
+		std::optional<T> pop() {
+			std::unique_lock lock(mutex);
+			notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+			if (items.empty()) return std::nullopt;
+			std::optional<T> item(std::move(items.front()));
+			items.pop_front();
+			notFull.notify_one();
+			return item;
+		}
+
+		void close() {
+			std::lock_guard lock(mutex);
+			closed = true;
+			notFull.notify_all();
+			notEmpty.notify_all();
+		}
+
+		[[nodiscard]] size_t fullWaits() {
+			std::lock_guard lock(mutex);
+			return producerWaits;
+		}
+	};
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace zenith {
+	// 64-bit FNV-1a, for cache keys: fast and stable across runs and platforms, not collision resistant
+	struct Hash {
+		uint64_t value = 0xcbf29ce484222325;
+
+		Hash& operator<<(const std::string_view bytes) {
+			for (const char c: bytes) {
+				value ^= static_cast<uint8_t>(c);
+				value *= 0x100000001b3;
+			}
+			return *this;
+		}
+
+		Hash& operator<<(const uint64_t number) {
+			const char bytes[8] = {
+				static_cast<char>(number), static_cast<char>(number >> 8), static_cast<char>(number >> 16),
+				static_cast<char>(number >> 24), static_cast<char>(number >> 32), static_cast<char>(number >> 40),
+				static_cast<char>(number >> 48), static_cast<char>(number >> 56)
+			};
+			return *this << std::string_view(bytes, 8);
+		}
+	};
+}
@@ -0,0 +1,155 @@
+#include "MemoryAccounting.hpp"
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "fmt/format.h"
+#if defined(__clang__) || defined(__GNUC__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace zenith {
+	namespace {
+		constexpr size_t CATEGORIES = static_cast<size_t>(MemoryAccounting::Category::COUNT);
+		constexpr size_t PHASES = static_cast<size_t>(MemoryAccounting::Phase::COUNT);
+		constexpr std::array<const char*, CATEGORIES> CATEGORY_NAMES{"tokens", "ast", "symbols", "diagnostics"};
+		constexpr std::array<const char*, PHASES> PHASE_NAMES{"setup", "lex", "parse", "analyze", "optimize"};
+
+		struct Counter {
+			std::atomic<int64_t> bytes = 0, count = 0;
+		};
+
+		thread_local MemoryAccounting::Phase currentPhase = MemoryAccounting::Phase::SETUP;
+		std::array<std::array<Counter, PHASES>, CATEGORIES> allocatedIn; // Cumulative, by the phase they were made in
+		std::array<std::atomic<int64_t>, CATEGORIES> live{}, peak{};
+		std::atomic<int64_t> liveTotal = 0, peakTotal = 0;
+
+		std::mutex kindsMutex;
+		std::deque<MemoryAccounting::Kind> kinds; // A deque, callers keep references
+
+		void raise(std::atomic<int64_t>& peakValue, const int64_t value) {
+			int64_t seen = peakValue.load(std::memory_order_relaxed);
+			while (value > seen && !peakValue.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+		}
+
+		std::string kindName(const std::type_info& type) {
+#if (defined(__clang__) || defined(__GNUC__)) && !defined(_MSC_VER)
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+			std::string name = status == 0 && demangled ? demangled : type.name();
+			std::free(demangled);
+#else
+			std::string name = type.name();
+#endif
+			if (name.starts_with("zenith::")) name.erase(0, 8);
+			return name;
+		}
+
+		int64_t peakRssKiB() {
+#if defined(__unix__) || defined(__APPLE__)
+			rusage usage{};
+			if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+			return usage.ru_maxrss / 1024; // Bytes there
+#else
+			return usage.ru_maxrss;
+#endif
+#else
+			return -1;
+#endif
+		}
+	}
+
+	void MemoryAccounting::start() {
+		active.store(true, std::memory_order_relaxed);
+	}
+
+	void MemoryAccounting::enter(const Phase phase) {
+		currentPhase = phase;
+	}
+
+	MemoryAccounting::Phase MemoryAccounting::phase() {
+		return currentPhase;
+	}
+
+	void MemoryAccounting::allocated(const Category category, const size_t bytes, const size_t count) {
+		const auto c = static_cast<size_t>(category);
+		const auto amount = static_cast<int64_t>(bytes);
+		Counter& counter = allocatedIn[c][static_cast<size_t>(currentPhase)];
+		counter.bytes.fetch_add(amount, std::memory_order_relaxed);
+		counter.count.fetch_add(static_cast<int64_t>(count), std::memory_order_relaxed);
+		raise(peak[c], live[c].fetch_add(amount, std::memory_order_relaxed) + amount);
+		raise(peakTotal, liveTotal.fetch_add(amount, std::memory_order_relaxed) + amount);
+	}
+
+	void MemoryAccounting::freed(const Category category, const size_t bytes, size_t) {
+		live[static_cast<size_t>(category)].fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+		liveTotal.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+	}
+
+	MemoryAccounting::Totals MemoryAccounting::totals(const Category category) {
+		const auto c = static_cast<size_t>(category);
+		Totals totals{live[c].load(), peak[c].load()};
+		for (const Counter& counter: allocatedIn[c]) {
+			totals.bytes += counter.bytes.load();
+			totals.count += counter.count.load();
+		}
+		return totals;
+	}
+
+	MemoryAccounting::Kind& MemoryAccounting::registerKind(const std::type_info& type) {
+		std::lock_guard lock(kindsMutex);
+		return kinds.emplace_back(type);
+	}
+
+	void MemoryAccounting::report(std::ostream& out) {
+		std::string text = fmt::format("{:<16}{:>14}{:>14}{:>16}{:>14}\n", "category", "live", "peak", "allocated",
+		                               "allocations");
+		int64_t allocatedTotal = 0, countTotal = 0;
+		for (size_t c = 0; c < CATEGORIES; ++c) {
+			const Totals category = totals(static_cast<Category>(c));
+			allocatedTotal += category.bytes;
+			countTotal += category.count;
+			text += fmt::format("{:<16}{:>14}{:>14}{:>16}{:>14}\n", CATEGORY_NAMES[c], category.live, category.peak,
+			                    category.bytes, category.count);
+		}
+		text += fmt::format("{:<16}{:>14}{:>14}{:>16}{:>14}\n", "tracked", liveTotal.load(), peakTotal.load(),
+		                    allocatedTotal, countTotal);
+		if (const int64_t rss = peakRssKiB(); rss >= 0) text += fmt::format("peak RSS        {:>14} KiB\n", rss);
+
+		text += fmt::format("\n{:<16}", "allocated in");
+		for (const char* category: CATEGORY_NAMES) text += fmt::format("{:>24}", category);
+		text += '\n';
+		for (size_t p = 0; p < PHASES; ++p) {
+			text += fmt::format("{:<16}", PHASE_NAMES[p]);
+			for (size_t c = 0; c < CATEGORIES; ++c) {
+				const Counter& counter = allocatedIn[c][p];
+				text += fmt::format("{:>24}", fmt::format("{} / {}", counter.bytes.load(), counter.count.load()));
+			}
+			text += '\n';
+		}
+
+		std::vector<const Kind*> byBytes;
+		{
+			std::lock_guard lock(kindsMutex);
+			for (const Kind& kind: kinds) byBytes.push_back(&kind);
+		}
+		std::ranges::sort(byBytes, [](const Kind* a, const Kind* b) { return a->bytes.load() > b->bytes.load(); });
+		// Bytes include the shared_ptr control block allocated with each node
+		text += fmt::format("\n{:<28}{:>12}{:>14}{:>10}\n", "ast node", "created", "bytes", "each");
+		for (const Kind* kind: byBytes) {
+			const int64_t count = kind->count.load();
+			if (count == 0) continue;
+			text += fmt::format("{:<28}{:>12}{:>14}{:>10}\n", kindName(kind->type), count, kind->bytes.load(),
+			                    kind->bytes.load() / count);
+		}
+		out << text;
+	}
+}
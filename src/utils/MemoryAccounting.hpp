@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <typeinfo>
+
+namespace zenith {
+	// Where the compiler's memory goes, for --mem-report
+	// Containers opt in with CountingAllocator, AST nodes are counted by make_node and tokens when the lexer hands
+	// them over. Nothing is counted before start(); after it a counted allocation is a few relaxed atomic adds.
+	class MemoryAccounting {
+	public:
+		enum class Category : uint8_t { TOKENS, AST, SYMBOLS, DIAGNOSTICS, COUNT };
+		enum class Phase : uint8_t { SETUP, LEX, PARSE, ANALYZE, OPTIMIZE, COUNT };
+
+		struct Totals {
+			int64_t live = 0, peak = 0, bytes = 0, count = 0; // Bytes and allocation count summed over every phase
+		};
+
+		// Nodes of one concrete type
+		struct Kind {
+			const std::type_info& type;
+			std::atomic<int64_t> count = 0, bytes = 0;
+		};
+
+		static bool enabled() { return active.load(std::memory_order_relaxed); }
+		static void start();
+		// Allocations this thread makes from now on are charged to phase, and those of the ThreadPool tasks it submits.
+		// Per thread, so files compiled in parallel each charge their own phases
+		static void enter(Phase phase);
+		[[nodiscard]] static Phase phase();
+
+		static void allocated(Category category, size_t bytes, size_t count = 1);
+		static void freed(Category category, size_t bytes, size_t count = 1);
+		static Totals totals(Category category);
+
+		template<typename T>
+		static Kind& kind() {
+			static Kind& kind = registerKind(typeid(T));
+			return kind;
+		}
+
+		// Live, peak and total bytes and allocation counts per category, the same per phase, peak RSS and the
+		// AST by node kind
+		static void report(std::ostream& out);
+
+	private:
+		static inline std::atomic<bool> active = false;
+
+		static Kind& registerKind(const std::type_info& type);
+	};
+
+	// std::allocator that charges what it hands out to a category while accounting is on
+	template<typename T, MemoryAccounting::Category category>
+	struct CountingAllocator {
+		using value_type = T;
+		template<typename U>
+		struct rebind { using other = CountingAllocator<U, category>; };
+
+		CountingAllocator() = default;
+		template<typename U>
+		CountingAllocator(const CountingAllocator<U, category>&) {}
+
+		T* allocate(const size_t n) {
+			if (MemoryAccounting::enabled()) MemoryAccounting::allocated(category, n * sizeof(T));
+			return std::allocator<T>().allocate(n);
+		}
+		void deallocate(T* p, const size_t n) noexcept {
+			if (MemoryAccounting::enabled()) MemoryAccounting::freed(category, n * sizeof(T));
+			std::allocator<T>().deallocate(p, n);
+		}
+
+		template<typename U>
+		bool operator==(const CountingAllocator<U, category>&) const { return true; }
+	};
+
+	// Allocates a node with its shared_ptr control block and charges both to the node's kind
+	template<typename T>
+	struct NodeAllocator {
+		using value_type = T;
+		MemoryAccounting::Kind* kind;
+
+		explicit NodeAllocator(MemoryAccounting::Kind& kind) : kind(&kind) {}
+		template<typename U>
+		NodeAllocator(const NodeAllocator<U>& other) : kind(other.kind) {}
+
+		T* allocate(const size_t n) {
+			MemoryAccounting::allocated(MemoryAccounting::Category::AST, n * sizeof(T));
+			kind->count.fetch_add(1, std::memory_order_relaxed);
+			kind->bytes.fetch_add(static_cast<int64_t>(n * sizeof(T)), std::memory_order_relaxed);
+			return std::allocator<T>().allocate(n);
+		}
+		void deallocate(T* p, const size_t n) noexcept {
+			MemoryAccounting::freed(MemoryAccounting::Category::AST, n * sizeof(T));
+			std::allocator<T>().deallocate(p, n);
+		}
+
+		template<typename U>
+		bool operator==(const NodeAllocator<U>& other) const { return kind == other.kind; }
+	};
+}
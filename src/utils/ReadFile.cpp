@@ -3,9 +3,12 @@
 //
 
 #include "ReadFile.hpp"
+#include "TimeTrace.hpp"
 
 namespace zenith{
 	std::string readFile(const std::string& filePath){
+		TimeTrace::Scope trace("Read source", "io");
+		trace.detail(filePath);
 		std::ifstream file(filePath);
 		if (!file.is_open()) {
 			throw std::runtime_error("Failed to open file: " + filePath);
@@ -16,6 +19,7 @@ namespace zenith{
 				(std::istreambuf_iterator<char>(file)),
 				(std::istreambuf_iterator<char>())
 		);
+		trace.counter("bytes", static_cast<int64_t>(content.size()));
 
 		return content;
 	}
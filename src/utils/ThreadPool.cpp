@@ -0,0 +1,125 @@
+#include "ThreadPool.hpp"
+#include "MemoryAccounting.hpp"
+#include <exception>
+#include <latch>
+
+namespace zenith {
+	namespace {
+		thread_local const ThreadPool* currentPool = nullptr;
+		thread_local size_t currentWorker = 0;
+	}
+
+	ThreadPool::ThreadPool(size_t threadCount) {
+		if (threadCount == 0) threadCount = 1;
+		queues.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i) {
+			queues.push_back(std::make_unique<WorkQueue>());
+		}
+		threads.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i) {
+			threads.emplace_back([this, i] { workerLoop(i); });
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		threads.clear(); // joins
+	}
+
+	void ThreadPool::submit(std::function<void()> task) {
+		if (MemoryAccounting::enabled()) {
+			// What the task allocates belongs to the phase of the thread that submitted it
+			task = [task = std::move(task), phase = MemoryAccounting::phase()] {
+				const MemoryAccounting::Phase outer = MemoryAccounting::phase();
+				MemoryAccounting::enter(phase);
+				task();
+				MemoryAccounting::enter(outer);
+			};
+		}
+		const size_t target = currentPool == this
+			                      ? currentWorker
+			                      : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+		{
+			std::lock_guard lock(queues[target]->mutex);
+			queues[target]->tasks.push_back(std::move(task));
+		}
+		pending.fetch_add(1, std::memory_order_release);
+		{
+			// Taking the lock orders this notify after a worker's predicate check, no lost wakeups
+			std::lock_guard lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+
+	bool ThreadPool::tryRunOne(const size_t self) {
+		std::function<void()> task;
+
+		// Own queue first, newest task (LIFO keeps nested work hot in cache)
+		{
+			auto& own = *queues[self];
+			std::lock_guard lock(own.mutex);
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+			}
+		}
+		// Otherwise steal the oldest task of another worker
+		for (size_t i = 1; !task && i < queues.size(); ++i) {
+			auto& victim = *queues[(self + i) % queues.size()];
+			std::lock_guard lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+			}
+		}
+		if (!task) return false;
+
+		pending.fetch_sub(1, std::memory_order_acq_rel);
+		task();
+		return true;
+	}
+
+	void ThreadPool::workerLoop(const size_t index) {
+		currentPool = this;
+		currentWorker = index;
+		while (true) {
+			if (tryRunOne(index)) continue;
+
+			std::unique_lock lock(sleepMutex);
+			wake.wait(lock, [this] { return stopping || pending.load(std::memory_order_acquire) > 0; });
+			if (stopping && pending.load(std::memory_order_acquire) == 0) return;
+		}
+	}
+
+	void ThreadPool::parallelFor(const size_t count, const std::function<void(size_t)>& body) {
+		if (count == 0) return;
+
+		std::latch done(static_cast<std::ptrdiff_t>(count));
+		std::exception_ptr firstError;
+		std::mutex errorMutex;
+
+		for (size_t i = 0; i < count; ++i) {
+			submit([&, i] {
+				try {
+					body(i);
+				} catch (...) {
+					std::lock_guard lock(errorMutex);
+					if (!firstError) firstError = std::current_exception();
+				}
+				done.count_down();
+			});
+		}
+
+		// Help instead of blocking, a waiting worker must not starve its own queue
+		const size_t helper = currentPool == this ? currentWorker : 0;
+		while (!done.try_wait()) {
+			if (!tryRunOne(helper)) std::this_thread::yield();
+		}
+
+		if (firstError) std::rethrow_exception(firstError);
+	}
+}
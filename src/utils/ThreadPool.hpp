@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zenith {
+	// Work-stealing thread pool
+	// Every worker owns a deque, it pops its own newest task and steals the oldest task of the others when empty.
+	// Tasks submitted from inside a worker go to that worker's deque so nested parallelism stays local.
+	class ThreadPool {
+		struct WorkQueue {
+			std::deque<std::function<void()>> tasks;
+			std::mutex mutex;
+		};
+
+		std::vector<std::unique_ptr<WorkQueue>> queues;
+		std::vector<std::jthread> threads;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		std::atomic<size_t> pending = 0;
+		std::atomic<size_t> nextQueue = 0;
+		bool stopping = false;
+
+		bool tryRunOne(size_t self);
+		void workerLoop(size_t index);
+
+	public:
+		explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		[[nodiscard]] size_t size() const { return threads.size(); }
+
+		void submit(std::function<void()> task);
+
+		// Runs body(0..count-1) on the pool and blocks until all of them finished.
+		// The calling thread helps with queued work while it waits, so this is safe to call from a task.
+		// The first exception thrown by a body is rethrown here.
+		void parallelFor(size_t count, const std::function<void(size_t)>& body);
+	};
+}
@@ -0,0 +1,115 @@
+#include "TimeTrace.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include "fmt/format.h"
+
+namespace zenith {
+	namespace {
+		using Clock = std::chrono::steady_clock;
+
+		struct ThreadBuffer {
+			uint32_t thread;
+			std::deque<TimeTrace::Event> events; // A deque, open scopes point into it while others are added
+		};
+
+		std::mutex buffersMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		Clock::time_point origin;
+
+		ThreadBuffer& threadBuffer() {
+			thread_local ThreadBuffer* buffer = nullptr;
+			if (!buffer) {
+				std::lock_guard lock(buffersMutex);
+				buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(buffers.size())));
+				buffer = buffers.back().get();
+			}
+			return *buffer;
+		}
+
+		int64_t now() {
+			return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin).count();
+		}
+
+		void writeJsonString(std::string& out, const std::string_view value) {
+			out += '"';
+			for (const char c: value) {
+				if (c == '"' || c == '\\') {
+					out += '\\';
+					out += c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20) out += fmt::format("\\u{:04x}", c);
+				else out += c;
+			}
+			out += '"';
+		}
+	}
+
+	void TimeTrace::start() {
+		{
+			std::lock_guard lock(buffersMutex);
+			for (const auto& buffer: buffers) buffer->events.clear();
+		}
+		origin = Clock::now();
+		threadBuffer(); // The calling thread is the first one in the trace
+		active.store(true, std::memory_order_relaxed);
+	}
+
+	void TimeTrace::counter(const std::string_view name, const std::string_view key, const int64_t value) {
+		if (!enabled()) return;
+		Event& event = begin(name, "compile");
+		event.phase = 'C';
+		event.counters.emplace_back(key, value);
+	}
+
+	TimeTrace::Event& TimeTrace::begin(const std::string_view name, const std::string_view category) {
+		Event& event = threadBuffer().events.emplace_back();
+		event.name = name;
+		event.category = category;
+		event.start = now();
+		return event;
+	}
+
+	void TimeTrace::end(Event& event) {
+		event.duration = now() - event.start;
+	}
+
+	void TimeTrace::write(std::ostream& out) {
+		active.store(false, std::memory_order_relaxed);
+		std::lock_guard lock(buffersMutex);
+		std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		for (const auto& buffer: buffers) {
+			if (!first) json += ',';
+			first = false;
+			// Thread 0 called start(), the others are pool workers
+			json += fmt::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+			                    buffer->thread, buffer->thread == 0 ? "main" : fmt::format("worker {}", buffer->thread));
+			for (const Event& event: buffer->events) {
+				json += fmt::format(R"(,{{"ph":"{}","pid":1,"tid":{},"ts":{},)", event.phase, buffer->thread, event.start);
+				if (event.phase == 'X') json += fmt::format(R"("dur":{},)", event.duration);
+				json += "\"cat\":";
+				writeJsonString(json, event.category);
+				json += ",\"name\":";
+				writeJsonString(json, event.name);
+				json += ",\"args\":{";
+				bool firstArg = true;
+				if (!event.detail.empty()) {
+					json += "\"detail\":";
+					writeJsonString(json, event.detail);
+					firstArg = false;
+				}
+				for (const auto& [name, value]: event.counters) {
+					if (!firstArg) json += ',';
+					firstArg = false;
+					writeJsonString(json, name);
+					json += fmt::format(":{}", value);
+				}
+				json += "}}";
+			}
+		}
+		json += "]}\n";
+		out << json;
+	}
+}
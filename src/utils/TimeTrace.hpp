@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace zenith {
+	// Timed, nested scopes written as Chrome trace-event JSON, which chrome://tracing and Perfetto open (--time-trace)
+	// Nothing is recorded before start(); until then a Scope costs the one branch on enabled(). Every thread appends to
+	// its own buffer, nesting comes from the scopes' times on that thread.
+	class TimeTrace {
+	public:
+		struct Event {
+			std::string_view name; // Scope names are literals
+			std::string_view category;
+			char phase = 'X'; // X spans start to start + duration, C is a counter sample at start
+			std::string detail;
+			int64_t start = 0, duration = 0; // Microseconds since start()
+			std::vector<std::pair<std::string_view, int64_t>> counters;
+		};
+
+		class Scope {
+			Event* event = nullptr;
+
+		public:
+			explicit Scope(const std::string_view name, const std::string_view category = "compile") {
+				if (enabled()) event = &begin(name, category);
+			}
+			~Scope() {
+				if (event) end(*event);
+			}
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			// Ends the scope before its destructor would
+			void stop() {
+				if (event) end(*event);
+				event = nullptr;
+			}
+
+			// Whether this scope is recorded; callers check it before computing an expensive detail or counter
+			explicit operator bool() const { return event != nullptr; }
+
+			// Shown with the name, e.g. the function a scope analyzes
+			void detail(const std::string_view text) {
+				if (event) event->detail = text;
+			}
+			void counter(const std::string_view name, const int64_t value) {
+				if (event) event->counters.emplace_back(name, value);
+			}
+		};
+
+		static bool enabled() { return active.load(std::memory_order_relaxed); }
+		static void start();
+		// A sample on the counter track called name, for totals that belong to no single scope
+		static void counter(std::string_view name, std::string_view key, int64_t value);
+		// Stops recording and writes every thread's events; only call once the workers are idle
+		static void write(std::ostream& out);
+
+	private:
+		static inline std::atomic<bool> active = false;
+
+		static Event& begin(std::string_view name, std::string_view category);
+		static void end(Event& event);
+	};
+}
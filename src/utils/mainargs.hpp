@@ -1,4 +1,9 @@
 #pragma once
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
@@ -15,11 +20,32 @@ enum class GC {
 	none
 };
 
+enum class DiagnosticsFormat {
+	text,
+	json
+};
+
 struct Flags {
 	bool bracesRequired = true;
 	Target target = Target::native;
 	GC gc = GC::generational;
-	std::string inputFile;
+	std::vector<std::string> inputFiles; // Files and directories, in command line order
+	std::string inputFile; // The one being compiled
+	bool dumpLogs = false; // lexerout.log and parserout.log
+	size_t jobs = 0; // 0 = one per hardware thread
+	DiagnosticsFormat diagnosticsFormat = DiagnosticsFormat::text;
+	size_t maxErrors = 20; // 0 = no limit
+	bool escapeReport = false;
+	bool shapeReport = false;
+	bool memReport = false; // Memory by category, phase and AST node kind
+	bool lazyParsing = false; // Function bodies are parsed on first use
+	bool pipeline = false; // Lexing, parsing and declaration collection overlap on threads of their own
+	std::string astCache; // Directory of parsed modules to reuse, empty = none
+	std::string timeTrace; // Chrome trace-event JSON of where compile time goes, empty = none
+	bool serve = false; // Compile for clients on a socket until stopped
+	bool connect = false; // Have the compile server do this compile
+	bool stopServer = false;
+	std::string socket; // Of the compile server, empty = CompileServer::defaultSocket()
 };
 
 class ArgumentParser {
@@ -28,9 +54,50 @@ public:
 		return parse(std::vector<std::string>(argv, argv + argc));
 	}
 
-	static Flags parse(const std::vector<std::string> &args) {
+	// @file arguments replaced by the whitespace separated arguments in the file, which may quote and nest
+	static std::vector<std::string> expandResponseFiles(const std::vector<std::string> &args, size_t depth = 0) {
+		std::vector<std::string> expanded;
+		for (const std::string &arg: args) {
+			if (!arg.starts_with("@") || arg.size() == 1) {
+				expanded.push_back(arg);
+				continue;
+			}
+			if (depth == 16) throw std::runtime_error("Response files nested too deeply at " + arg);
+			std::ifstream file(arg.substr(1));
+			if (!file) throw std::runtime_error("Cannot read response file " + arg.substr(1));
+			std::vector<std::string> inner;
+			std::string word;
+			bool inWord = false;
+			char quote = 0;
+			for (char c; file.get(c);) {
+				if (quote) {
+					if (c == quote) quote = 0;
+					else word += c;
+				}
+				else if (c == '"' || c == '\'') {
+					quote = c;
+					inWord = true;
+				}
+				else if (std::isspace(static_cast<unsigned char>(c))) {
+					if (inWord) inner.push_back(std::move(word));
+					word.clear();
+					inWord = false;
+				}
+				else {
+					word += c;
+					inWord = true;
+				}
+			}
+			if (quote) throw std::runtime_error("Unterminated quote in response file " + arg.substr(1));
+			if (inWord) inner.push_back(std::move(word));
+			std::ranges::move(expandResponseFiles(inner, depth + 1), std::back_inserter(expanded));
+		}
+		return expanded;
+	}
+
+	static Flags parse(const std::vector<std::string> &commandLine) {
 		Flags flags;
-		bool foundInputFile = false;
+		const std::vector<std::string> args = expandResponseFiles(commandLine);
 
 		for (size_t i = 1; i < args.size(); ++i) {
 			const std::string &arg = args[i];
@@ -55,14 +122,58 @@ public:
 					else if (value == "none") flags.gc = GC::none;
 					else throw std::runtime_error("Invalid GC strategy");
 				}
+				else if (arg.starts_with("--diagnostics-format=")) {
+					std::string value = arg.substr(21);
+					if (value == "text") flags.diagnosticsFormat = DiagnosticsFormat::text;
+					else if (value == "json") flags.diagnosticsFormat = DiagnosticsFormat::json;
+					else throw std::runtime_error("Invalid diagnostics format");
+				}
+				else if (arg.starts_with("--max-errors=")) {
+					flags.maxErrors = std::stoul(arg.substr(13));
+				}
+				else if (arg == "--escape-report") {
+					flags.escapeReport = true;
+				}
+				else if (arg == "--shape-report") {
+					flags.shapeReport = true;
+				}
+				else if (arg == "--mem-report") {
+					flags.memReport = true;
+				}
+				else if (arg == "--lazy-parse") {
+					flags.lazyParsing = true;
+				}
+				else if (arg.starts_with("--ast-cache=")) {
+					flags.astCache = arg.substr(12);
+					if (flags.astCache.empty()) throw std::runtime_error("Missing cache directory");
+				}
+				else if (arg.starts_with("--time-trace=")) {
+					flags.timeTrace = arg.substr(13);
+					if (flags.timeTrace.empty()) throw std::runtime_error("Missing trace file");
+				}
+				else if (arg.starts_with("--jobs=")) {
+					flags.jobs = std::stoul(arg.substr(7));
+				}
+				else if (arg == "--pipeline") {
+					flags.pipeline = true;
+				}
+				else if (arg == "--dump-logs") {
+					flags.dumpLogs = true;
+				}
+				else if (arg == "--server" || arg.starts_with("--server=")) {
+					flags.serve = true;
+					if (arg.size() > 8) flags.socket = arg.substr(9);
+				}
+				else if (arg == "--connect" || arg.starts_with("--connect=")) {
+					flags.connect = true;
+					if (arg.size() > 9) flags.socket = arg.substr(10);
+				}
+				else if (arg == "--stop-server" || arg.starts_with("--stop-server=")) {
+					flags.stopServer = true;
+					if (arg.size() > 13) flags.socket = arg.substr(14);
+				}
 				else if (!arg.starts_with("-")) {
-					if (!foundInputFile) {
-						flags.inputFile = arg;
-						foundInputFile = true;
-					}
-					else {
-						throw std::runtime_error("Multiple input files specified");
-					}
+					flags.inputFiles.push_back(arg);
 				}
 				else {
 					throw std::runtime_error("Unknown option: " + arg);
@@ -72,9 +183,11 @@ public:
 			}
 		}
 
-		if (!foundInputFile) {
+		if (flags.serve || flags.stopServer) return flags;
+		if (flags.inputFiles.empty()) {
 			throw std::runtime_error("No input file specified");
 		};
+		flags.inputFile = flags.inputFiles.front();
 		return flags;
 	}
 };
@@ -1,2 +1,67 @@
-//see small_vector.hpp
-//stupid templates
\ No newline at end of file
+#include "small_vector.hpp"
+#include <algorithm>
+#include <mutex>
+#include <ostream>
+#include <ranges>
+#include "fmt/format.h"
+
+// Templates are in small_vector.hpp, this is the statistics registry
+namespace small_vector_stats {
+	static std::mutex mutex;
+	// Never destroyed, vectors in other statics may record after it would be
+	static std::map<std::string, Lengths>& sites = *new std::map<std::string, Lengths>;
+
+	void record(const std::source_location& site, const size_t inlineCapacity, const size_t elementSize,
+	            const size_t length) {
+		std::string key = fmt::format("{}:{}", site.file_name(), site.line());
+		std::lock_guard lock(mutex);
+		auto [it, inserted] = sites.try_emplace(key);
+		if (inserted) it->second = Lengths{std::move(key), inlineCapacity, elementSize, {}};
+		++it->second.counts[length];
+	}
+
+	std::vector<Lengths> collect() {
+		std::vector<Lengths> result;
+		{
+			std::lock_guard lock(mutex);
+			for (const auto& lengths: sites | std::views::values) result.push_back(lengths);
+		}
+		auto total = [](const Lengths& lengths) {
+			size_t count = 0;
+			for (const size_t n: lengths.counts | std::views::values) count += n;
+			return count;
+		};
+		std::ranges::stable_sort(result, [&](const Lengths& a, const Lengths& b) { return total(a) > total(b); });
+		return result;
+	}
+
+	void report(std::ostream& out) {
+		out << fmt::format("{:<48}{:>4}{:>10}{:>9}{:>5}{:>5}{:>5}{:>5}\n",
+		                   "site", "N", "vectors", "spilled", "p50", "p90", "p99", "max");
+		for (const Lengths& lengths: collect()) {
+			size_t vectors = 0, spilled = 0;
+			for (const auto& [length, count]: lengths.counts) {
+				vectors += count;
+				if (length > lengths.inlineCapacity) spilled += count;
+			}
+			auto percentile = [&](const double p) {
+				size_t seen = 0;
+				for (const auto& [length, count]: lengths.counts) {
+					seen += count;
+					if (seen >= p * vectors) return length;
+				}
+				return lengths.counts.rbegin()->first;
+			};
+			// Sites in headers are long paths, the file name and line say enough
+			std::string_view site = lengths.site;
+			if (const size_t slash = site.find_last_of("/\\"); slash != std::string_view::npos) site.remove_prefix(slash + 1);
+			out << fmt::format("{:<48}{:>4}{:>10}{:>9}{:>5}{:>5}{:>5}{:>5}\n", site, lengths.inlineCapacity, vectors,
+			                   spilled, percentile(0.5), percentile(0.9), percentile(0.99), lengths.counts.rbegin()->first);
+		}
+	}
+
+	void reset() {
+		std::lock_guard lock(mutex);
+		sites.clear();
+	}
+}
@@ -6,39 +6,131 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <limits>
+#include <map>
 #include <memory>
+#include <source_location>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
-template <typename T, size_t N>
+// Whether a T can be moved to another address by copying its bytes, leaving nothing to destroy at the old one
+// True for trivially copyable types and smart pointers; other types opt in with
+// `using trivially_relocatable = std::true_type;`. Not std::string, libstdc++'s short strings point into themselves.
+template <typename T>
+struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <typename T>
+	requires requires { typename T::trivially_relocatable; }
+struct is_trivially_relocatable<T> : T::trivially_relocatable {};
+
+template <typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T, typename Deleter>
+struct is_trivially_relocatable<std::unique_ptr<T, Deleter>> : is_trivially_relocatable<Deleter> {};
+
+template <typename A, typename B>
+struct is_trivially_relocatable<std::pair<A, B>>
+	: std::bool_constant<is_trivially_relocatable<A>::value && is_trivially_relocatable<B>::value> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+// Length statistics, compiled in with ZENITH_SMALL_VECTOR_STATS
+// Every small_vector remembers where it was constructed (for a node's field, the line of the node's constructor that
+// initializes it) and records its length when destroyed, so inline capacities can be picked from real programs.
+// Moved-from vectors are not recorded, their elements are counted where they went.
+namespace small_vector_stats {
+	struct Lengths {
+		std::string site; // file:line
+		size_t inlineCapacity;
+		size_t elementSize;
+		std::map<size_t, size_t> counts; // length -> vectors destroyed with it
+	};
+
+	void record(const std::source_location& site, size_t inlineCapacity, size_t elementSize, size_t length);
+	// Every site recorded so far, most vectors first
+	std::vector<Lengths> collect();
+	// One line per site: vectors, how many spilled, length percentiles
+	void report(std::ostream& out);
+	void reset();
+
+	class Site {
+#ifdef ZENITH_SMALL_VECTOR_STATS
+		std::source_location location;
+
+	public:
+		explicit Site(const std::source_location& location) : location(location) {}
+		void record(const size_t inlineCapacity, const size_t elementSize, const size_t length) const {
+			if (location.line() != 0) small_vector_stats::record(location, inlineCapacity, elementSize, length);
+		}
+		void forget() { location = {}; }
+#else
+	public:
+		explicit Site(const std::source_location&) {}
+		void record(size_t, size_t, size_t) const {}
+		void forget() {}
+#endif
+	};
+}
+
+// Vector holding its first N elements inline, spilling to Allocator beyond them
+// The inline buffer doubles as the heap pointer once spilled, which capacity > N tells apart, and the length and
+// capacity are 32-bit: a small_vector<polymorphic<ExprNode>, 4> is 72 bytes. Trivially relocatable elements are moved
+// with memcpy when the buffer grows, the vector moves, or elements are erased.
+template <typename T, size_t N, typename Allocator = std::allocator<T>>
 class small_vector {
 	static_assert(N > 0, "small_vector requires a positive inline capacity");
-
-	// Buffer for small-size optimization
-	alignas(T) char inline_buffer_[N * sizeof(T)];
-	T* data_ = reinterpret_cast<T*>(inline_buffer_);
-	size_t size_ = 0;
-	size_t capacity_ = N;
-
+	static_assert(N <= std::numeric_limits<uint32_t>::max(), "small_vector capacity is 32-bit");
+
+	using traits = std::allocator_traits<Allocator>;
+	static constexpr bool relocatable = is_trivially_relocatable_v<T>;
+
+	union {
+		T* heap_;
+		alignas(T) char inline_buffer_[N * sizeof(T)];
+	};
+	uint32_t size_ = 0;
+	uint32_t capacity_ = N;
+	[[no_unique_address]] Allocator alloc_;
+	[[no_unique_address]] small_vector_stats::Site site_;
+
+	bool is_inline() const noexcept { return capacity_ == N; }
+	T* inline_data() noexcept { return reinterpret_cast<T*>(inline_buffer_); }
+
+	static uint32_t checked_capacity(size_t capacity);
+	// Moves count elements from src to uninitialized dst, the source is left uninitialized
+	static void relocate(T* src, size_t count, T* dst);
 	// Switch to heap allocation when needed
 	void grow(size_t new_capacity);
+	// Takes other's elements and allocator, this must be empty and inline; other is left empty and inline
+	void steal(small_vector& other) noexcept;
+	void release() noexcept;
 
 public:
 	using value_type = T;
+	using allocator_type = Allocator;
 	using size_type = size_t;
 	using reference = T&;
 	using const_reference = const T&;
 	using iterator = T*;
 	using const_iterator = const T*;
 
-	small_vector() = default;
+	small_vector(std::source_location site = std::source_location::current());
+	explicit small_vector(const Allocator& alloc, std::source_location site = std::source_location::current());
 	~small_vector();
 
 	// Copy constructor
-	small_vector(const small_vector& other);
+	small_vector(const small_vector& other, std::source_location site = std::source_location::current());
 
 	// Move constructor
-	small_vector(small_vector&& other) noexcept;
+	small_vector(small_vector&& other, std::source_location site = std::source_location::current()) noexcept;
 
 	// Copy assignment
 	small_vector& operator=(const small_vector& other);
@@ -61,6 +153,8 @@ public:
 	T* data() noexcept;
 	const T* data() const noexcept;
 
+	allocator_type get_allocator() const noexcept;
+
 	// Iterators
 	iterator begin() noexcept;
 	const_iterator begin() const noexcept;
@@ -74,6 +168,8 @@ public:
 	bool empty() const noexcept;
 	size_t size() const noexcept;
 	size_t capacity() const noexcept;
+	// Whether the elements live in the allocator's memory rather than inline
+	bool spilled() const noexcept;
 
 	void reserve(size_t new_capacity);
 	void shrink_to_fit();
@@ -90,11 +186,11 @@ public:
 	void resize(size_t new_size);
 	void resize(size_t new_size, const T& value);
 
-	template <typename Allocator>
-	small_vector(std::vector<T, Allocator>&& other);
+	template <typename VectorAllocator>
+	small_vector(std::vector<T, VectorAllocator>&& other, std::source_location site = std::source_location::current());
 
-	template <typename Allocator>
-	small_vector& operator=(std::vector<T, Allocator>&& other);
+	template <typename VectorAllocator>
+	small_vector& operator=(std::vector<T, VectorAllocator>&& other);
 
 	template <typename InputIt>
 	void append(InputIt first, InputIt last);
@@ -103,7 +199,7 @@ public:
 	void emplace_back_bulk(Args&&... args);
 
 	template <typename InputIt>
-	small_vector(InputIt first, InputIt last);
+	small_vector(InputIt first, InputIt last, std::source_location site = std::source_location::current());
 
 	void swap_range(size_t pos, small_vector& other, size_t other_pos, size_t count);
 
@@ -114,87 +210,112 @@ public:
 
 //C++ templates...
 
-template <typename T, size_t N>
-void small_vector<T, N>::grow(size_t new_capacity) {
-	assert(new_capacity > capacity_);
-
-	T* new_data = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
-	size_t i = 0;
+template <typename T, size_t N, typename A>
+uint32_t small_vector<T, N, A>::checked_capacity(const size_t capacity) {
+	if (capacity > std::numeric_limits<uint32_t>::max()) throw std::length_error("small_vector capacity is 32-bit");
+	return static_cast<uint32_t>(capacity);
+}
 
-	try {
-		for (; i < size_; ++i) {
-			new (new_data + i) T(std::move(data_[i]));
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::relocate(T* src, const size_t count, T* dst) {
+	if constexpr (relocatable) {
+		if (count) std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+	} else {
+		size_t i = 0;
+		try {
+			for (; i < count; ++i) {
+				new (dst + i) T(std::move_if_noexcept(src[i]));
+			}
+		} catch (...) {
+			for (size_t j = 0; j < i; ++j) {
+				dst[j].~T();
+			}
+			throw;
 		}
-	} catch (...) {
-		for (size_t j = 0; j < i; ++j) {
-			new_data[j].~T();
+		for (size_t j = 0; j < count; ++j) {
+			src[j].~T();
 		}
-		::operator delete(new_data);
-		throw;
 	}
+}
 
-	// Destroy old elements
-	for (size_t j = 0; j < size_; ++j) {
-		data_[j].~T();
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::grow(const size_t new_capacity) {
+	assert(new_capacity > capacity_);
+	const uint32_t capacity = checked_capacity(new_capacity);
+
+	T* new_data = traits::allocate(alloc_, capacity);
+	try {
+		relocate(data(), size_, new_data);
+	} catch (...) {
+		traits::deallocate(alloc_, new_data, capacity);
+		throw;
 	}
 
 	// If we were using heap memory before, free it
-	if (data_ != reinterpret_cast<T*>(inline_buffer_)) {
-		::operator delete(data_);
+	if (!is_inline()) {
+		traits::deallocate(alloc_, heap_, capacity_);
 	}
-
-	data_ = new_data;
-	capacity_ = new_capacity;
+	heap_ = new_data;
+	capacity_ = capacity;
 }
 
-template <typename T, size_t N>
-small_vector<T, N>::~small_vector() {
-	for (size_t i = 0; i < size_; ++i) {
-		data_[i].~T();
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::steal(small_vector& other) noexcept {
+	assert(size_ == 0 && is_inline());
+	alloc_ = other.alloc_;
+	if (other.is_inline()) {
+		// Elements can't leave the inline buffer by pointer, move them over
+		relocate(other.inline_data(), other.size_, inline_data());
+	} else {
+		// Take ownership of heap memory
+		heap_ = other.heap_;
+		capacity_ = other.capacity_;
+		other.capacity_ = N;
 	}
-	if (data_ != reinterpret_cast<T*>(inline_buffer_)) {
-		::operator delete(data_);
+	size_ = other.size_;
+	other.size_ = 0;
+}
+
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::release() noexcept {
+	clear();
+	if (!is_inline()) {
+		traits::deallocate(alloc_, heap_, capacity_);
+		capacity_ = N;
 	}
 }
 
-template <typename T, size_t N>
-small_vector<T, N>::small_vector(const small_vector& other) {
+template <typename T, size_t N, typename A>
+small_vector<T, N, A>::small_vector(const std::source_location site) : site_(site) {}
+
+template <typename T, size_t N, typename A>
+small_vector<T, N, A>::small_vector(const A& alloc, const std::source_location site) : alloc_(alloc), site_(site) {}
+
+template <typename T, size_t N, typename A>
+small_vector<T, N, A>::~small_vector() {
+	site_.record(N, sizeof(T), size_);
+	release();
+}
+
+template <typename T, size_t N, typename A>
+small_vector<T, N, A>::small_vector(const small_vector& other, const std::source_location site)
+	: alloc_(traits::select_on_container_copy_construction(other.alloc_)), site_(site) {
 	reserve(other.size_);
+	std::uninitialized_copy(other.begin(), other.end(), data());
 	size_ = other.size_;
-	for (size_t i = 0; i < size_; ++i) {
-		new (data_ + i) T(other.data_[i]);
-	}
 }
 
-template <typename T, size_t N>
-small_vector<T, N>::small_vector(small_vector&& other) noexcept {
-	if (other.data_ == reinterpret_cast<T*>(other.inline_buffer_)) {
-		// Move elements one by one
-		data_ = reinterpret_cast<T*>(inline_buffer_);
-		capacity_ = N;
-		size_ = 0;
-		for (size_t i = 0; i < other.size_; ++i) {
-			new (data_ + size_) T(std::move(other.data_[i]));
-			++size_;
-		}
-		other.clear();  // Properly clear the source
-	} else {
-		// Take ownership of heap memory
-		data_ = other.data_;
-		size_ = other.size_;
-		capacity_ = other.capacity_;
-
-		// Reset source to empty inline state
-		other.data_ = reinterpret_cast<T*>(other.inline_buffer_);
-		other.size_ = 0;
-		other.capacity_ = N;
-	}
+template <typename T, size_t N, typename A>
+small_vector<T, N, A>::small_vector(small_vector&& other, const std::source_location site) noexcept
+	: alloc_(other.alloc_), site_(site) {
+	steal(other);
+	other.site_.forget();
 	assert(invariant());
 	assert(other.invariant());
 }
 
-template <typename T, size_t N>
-small_vector<T, N>& small_vector<T, N>::operator=(const small_vector& other) {
+template <typename T, size_t N, typename A>
+small_vector<T, N, A>& small_vector<T, N, A>::operator=(const small_vector& other) {
 	if (this != &other) {
 		small_vector tmp(other);
 		swap(tmp);
@@ -202,363 +323,360 @@ small_vector<T, N>& small_vector<T, N>::operator=(const small_vector& other) {
 	return *this;
 }
 
-template <typename T, size_t N>
-small_vector<T, N>& small_vector<T, N>::operator=(small_vector&& other) noexcept {
+template <typename T, size_t N, typename A>
+small_vector<T, N, A>& small_vector<T, N, A>::operator=(small_vector&& other) noexcept {
 	if (this != &other) {
-		small_vector tmp(std::move(other));
-		swap(tmp);
+		release();
+		steal(other);
+		other.site_.forget();
 	}
 	return *this;
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::swap(small_vector& other) noexcept {
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::swap(small_vector& other) noexcept {
 	if (this == &other) return;
 
-	//std::cout << "this: " << this << " other: " << &other << "\n";
-	//std::cout << "this data: " << data_ << " inline: " << reinterpret_cast<void*>(inline_buffer_) << "\n";
-	//std::cout << "other data: " << other.data_ << " inline: " << reinterpret_cast<void*>(other.inline_buffer_) << "\n";
 	// First handle the simple case where both are using heap
-	if (data_ != reinterpret_cast<T*>(inline_buffer_) &&
-	    other.data_ != reinterpret_cast<T*>(other.inline_buffer_)) {
-		std::swap(data_, other.data_);
+	if (!is_inline() && !other.is_inline()) {
+		std::swap(heap_, other.heap_);
 		std::swap(size_, other.size_);
 		std::swap(capacity_, other.capacity_);
+		std::swap(alloc_, other.alloc_);
 		return;
 	}
 
-	// Otherwise, create a temporary and move elements
-	small_vector tmp;
-
-	// Move elements from this to tmp
-	tmp.reserve(other.size_);
-	for (size_t i = 0; i < other.size_; ++i) {
-		tmp.emplace_back(std::move(other.data_[i]));
-	}
-	tmp.size_ = other.size_;
-
-	// Move elements from other to this
-	other.clear();
-	other.reserve(size_);
-	for (size_t i = 0; i < size_; ++i) {
-		other.emplace_back(std::move(data_[i]));
-	}
-	other.size_ = size_;
-
-	// Move elements from tmp to this
-	clear();
-	reserve(tmp.size_);
-	for (size_t i = 0; i < tmp.size_; ++i) {
-		emplace_back(std::move(tmp.data_[i]));
-	}
-	size_ = tmp.size_;
+	// Otherwise, go through a temporary
+	small_vector tmp(other.alloc_);
+	tmp.steal(other);
+	other.steal(*this);
+	steal(tmp);
+	tmp.site_.forget();
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::reference small_vector<T, N>::operator[](size_t pos) {
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::reference small_vector<T, N, A>::operator[](size_t pos) {
 	assert(pos < size_);
-	return data_[pos];
+	return data()[pos];
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::const_reference small_vector<T, N>::operator[](size_t pos) const {
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::const_reference small_vector<T, N, A>::operator[](size_t pos) const {
 	assert(pos < size_);
-	return data_[pos];
+	return data()[pos];
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::reference small_vector<T, N>::front() {
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::reference small_vector<T, N, A>::front() {
 	assert(size_ > 0);
-	return data_[0];
+	return data()[0];
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::const_reference small_vector<T, N>::front() const {
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::const_reference small_vector<T, N, A>::front() const {
 	assert(size_ > 0);
-	return data_[0];
+	return data()[0];
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::reference small_vector<T, N>::back() {
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::reference small_vector<T, N, A>::back() {
 	assert(size_ > 0);
-	return data_[size_ - 1];
+	return data()[size_ - 1];
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::const_reference small_vector<T, N>::back() const {
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::const_reference small_vector<T, N, A>::back() const {
 	assert(size_ > 0);
-	return data_[size_ - 1];
+	return data()[size_ - 1];
+}
+
+template <typename T, size_t N, typename A>
+T* small_vector<T, N, A>::data() noexcept {
+	return is_inline() ? inline_data() : heap_;
 }
 
-template <typename T, size_t N>
-T* small_vector<T, N>::data() noexcept {
-	return data_;
+template <typename T, size_t N, typename A>
+const T* small_vector<T, N, A>::data() const noexcept {
+	return is_inline() ? reinterpret_cast<const T*>(inline_buffer_) : heap_;
 }
 
-template <typename T, size_t N>
-const T* small_vector<T, N>::data() const noexcept {
-	return data_;
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::allocator_type small_vector<T, N, A>::get_allocator() const noexcept {
+	return alloc_;
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::iterator small_vector<T, N>::begin() noexcept {
-	return data_;
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::iterator small_vector<T, N, A>::begin() noexcept {
+	return data();
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::const_iterator small_vector<T, N>::begin() const noexcept {
-	return data_;
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::const_iterator small_vector<T, N, A>::begin() const noexcept {
+	return data();
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::const_iterator small_vector<T, N>::cbegin() const noexcept {
-	return data_;
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::const_iterator small_vector<T, N, A>::cbegin() const noexcept {
+	return data();
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::iterator small_vector<T, N>::end() noexcept {
-	return data_ + size_;
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::iterator small_vector<T, N, A>::end() noexcept {
+	return data() + size_;
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::const_iterator small_vector<T, N>::end() const noexcept {
-	return data_ + size_;
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::const_iterator small_vector<T, N, A>::end() const noexcept {
+	return data() + size_;
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::const_iterator small_vector<T, N>::cend() const noexcept {
-	return data_ + size_;
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::const_iterator small_vector<T, N, A>::cend() const noexcept {
+	return data() + size_;
 }
 
-template <typename T, size_t N>
-bool small_vector<T, N>::empty() const noexcept {
+template <typename T, size_t N, typename A>
+bool small_vector<T, N, A>::empty() const noexcept {
 	return size_ == 0;
 }
 
-template <typename T, size_t N>
-size_t small_vector<T, N>::size() const noexcept {
+template <typename T, size_t N, typename A>
+size_t small_vector<T, N, A>::size() const noexcept {
 	return size_;
 }
 
-template <typename T, size_t N>
-size_t small_vector<T, N>::capacity() const noexcept {
+template <typename T, size_t N, typename A>
+size_t small_vector<T, N, A>::capacity() const noexcept {
 	return capacity_;
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::reserve(size_t new_capacity) {
+template <typename T, size_t N, typename A>
+bool small_vector<T, N, A>::spilled() const noexcept {
+	return !is_inline();
+}
+
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::reserve(size_t new_capacity) {
 	if (new_capacity > capacity_) {
 		grow(new_capacity);
 	}
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::shrink_to_fit() {
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::shrink_to_fit() {
 	if (size_ == capacity_) return;
 
 	if (size_ <= N) {
 		// Switch back to inline storage if possible
-		if (data_ != reinterpret_cast<T*>(inline_buffer_)) {
-			small_vector tmp;
-			for (size_t i = 0; i < size_; ++i) {
-				tmp.push_back(std::move(data_[i]));
+		if (!is_inline()) {
+			T* heap = heap_;
+			const uint32_t capacity = capacity_;
+			capacity_ = N;
+			try {
+				relocate(heap, size_, inline_data());
+			} catch (...) {
+				heap_ = heap;
+				capacity_ = capacity;
+				throw;
 			}
-			this->swap(tmp);
+			traits::deallocate(alloc_, heap, capacity);
 		}
 	} else {
 		// Reallocate to exactly fit the size
-		grow(size_);
+		T* new_data = traits::allocate(alloc_, size_);
+		try {
+			relocate(heap_, size_, new_data);
+		} catch (...) {
+			traits::deallocate(alloc_, new_data, size_);
+			throw;
+		}
+		traits::deallocate(alloc_, heap_, capacity_);
+		heap_ = new_data;
+		capacity_ = size_;
 	}
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::clear() noexcept {
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::clear() noexcept {
 	assert(invariant());
-	// Debug checks
-	if (size_ == 0) return;  // Nothing to do
-
-	// Handle invalid states defensively
-	if (data_ == nullptr) {
-		assert(false && "clear() called with null data_ but non-zero size_");
-		size_ = 0;
-		return;
-	}
-
-	// Destroy elements safely
+	T* elements = data();
 	for (size_t i = 0; i < size_; ++i) {
-		try {
-			data_[i].~T();
-		} catch (...) {
-			// Absorb exceptions in noexcept method
-			assert(false && "Destructor threw in noexcept clear()");
-		}
+		elements[i].~T();
 	}
 	size_ = 0;
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::push_back(const T& value) {
-	assert(invariant());
-	if (size_ == capacity_) {
-		grow(capacity_ * 2);
-	}
-	new (data_ + size_) T(value);
-	++size_;
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::push_back(const T& value) {
+	emplace_back(value);
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::push_back(T&& value) {
-	assert(invariant());
-	if (size_ == capacity_) {
-		grow(capacity_ * 2);
-	}
-	new (data_ + size_) T(std::move(value));
-	++size_;
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::push_back(T&& value) {
+	emplace_back(std::move(value));
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::pop_back() {
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::pop_back() {
 	assert(invariant());
 	assert(size_ > 0);
-	data_[size_ - 1].~T();
+	data()[size_ - 1].~T();
 	--size_;
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::resize(size_t new_size) {
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::resize(size_t new_size) {
 	if (new_size < size_) {
 		for (size_t i = new_size; i < size_; ++i) {
-			data_[i].~T();
+			data()[i].~T();
 		}
 	} else if (new_size > size_) {
 		reserve(new_size);
 		for (size_t i = size_; i < new_size; ++i) {
-			new (data_ + i) T();
+			new (data() + i) T();
 		}
 	}
-	size_ = new_size;
+	size_ = static_cast<uint32_t>(new_size);
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::resize(size_t new_size, const T& value) {
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::resize(size_t new_size, const T& value) {
 	if (new_size < size_) {
 		for (size_t i = new_size; i < size_; ++i) {
-			data_[i].~T();
+			data()[i].~T();
 		}
 	} else if (new_size > size_) {
 		reserve(new_size);
 		for (size_t i = size_; i < new_size; ++i) {
-			new (data_ + i) T(value);
+			new (data() + i) T(value);
 		}
 	}
-	size_ = new_size;
+	size_ = static_cast<uint32_t>(new_size);
 }
 
-template <typename T, size_t N>
-template <typename Allocator>
-small_vector<T, N>::small_vector(std::vector<T, Allocator>&& other) {
-	if (other.size() <= N) {
-		// Move elements one by one into inline storage
-		size_ = other.size();
-		capacity_ = N;
-		for (size_t i = 0; i < size_; ++i) {
-			new (data_ + i) T(std::move(other[i]));
-		}
-	} else {
-		// Take ownership of the vector's heap allocation
-		data_ = other.data();
-		size_ = other.size();
-		capacity_ = other.capacity();
-
-		// Leave the source vector in valid but empty state
-		other = std::vector<T, Allocator>(); // Reset to empty vector
-	}
+template <typename T, size_t N, typename A>
+template <typename VectorAllocator>
+small_vector<T, N, A>::small_vector(std::vector<T, VectorAllocator>&& other, const std::source_location site)
+	: site_(site) {
+	// The vector's buffer belongs to its allocator, so the elements move rather than the buffer
+	reserve(other.size());
+	std::uninitialized_move(other.begin(), other.end(), data());
+	size_ = static_cast<uint32_t>(other.size());
+	other.clear();
 }
 
-template <typename T, size_t N>
-template <typename Allocator>
-small_vector<T, N>& small_vector<T, N>::operator=(std::vector<T, Allocator>&& other) {
+template <typename T, size_t N, typename A>
+template <typename VectorAllocator>
+small_vector<T, N, A>& small_vector<T, N, A>::operator=(std::vector<T, VectorAllocator>&& other) {
 	small_vector tmp(std::move(other));
 	swap(tmp);
+	tmp.site_.forget();
 	return *this;
 }
 
-template <typename T, size_t N>
+template <typename T, size_t N, typename A>
 template <typename InputIt>
-void small_vector<T, N>::append(InputIt first, InputIt last) {
+void small_vector<T, N, A>::append(InputIt first, InputIt last) {
 	assert(invariant());
 	const size_t count = std::distance(first, last);
 	reserve(size_ + count);
 	for (; first != last; ++first) {
-		new (data_ + size_) T(*first);
+		new (data() + size_) T(*first);
 		++size_;
 	}
 }
 
-template <typename T, size_t N>
+template <typename T, size_t N, typename A>
 template <typename InputIt>
-small_vector<T, N>::small_vector(InputIt first, InputIt last) {
-	const size_t count = std::distance(first, last);
-	if (count > N) {
-		data_ = static_cast<T*>(::operator new(count * sizeof(T)));
-		capacity_ = count;
-	}
-	size_ = count;
-	std::uninitialized_copy(first, last, data_);
+small_vector<T, N, A>::small_vector(InputIt first, InputIt last, const std::source_location site) : site_(site) {
+	reserve(std::distance(first, last));
+	std::uninitialized_copy(first, last, data());
+	size_ = static_cast<uint32_t>(std::distance(first, last));
 }
 
-template <typename T, size_t N>
-void small_vector<T, N>::swap_range(size_t pos, small_vector& other, size_t other_pos, size_t count) {
+template <typename T, size_t N, typename A>
+void small_vector<T, N, A>::swap_range(size_t pos, small_vector& other, size_t other_pos, size_t count) {
 	assert(pos + count <= size_);
 	assert(other_pos + count <= other.size_);
 
 	for (size_t i = 0; i < count; ++i) {
 		using std::swap;
-		swap(data_[pos + i], other.data_[other_pos + i]);
+		swap(data()[pos + i], other.data()[other_pos + i]);
 	}
 }
 
-template <typename T, size_t N>
-typename small_vector<T, N>::iterator small_vector<T, N>::erase_range(const_iterator first, const_iterator last) {
+template <typename T, size_t N, typename A>
+typename small_vector<T, N, A>::iterator small_vector<T, N, A>::erase_range(const_iterator first, const_iterator last) {
 	const size_t start_pos = first - begin();
 	const size_t end_pos = last - begin();
 	const size_t count = end_pos - start_pos;
+	T* elements = data();
 
-	// Move elements down
-	for (size_t i = end_pos; i < size_; ++i) {
-		data_[i - count] = std::move(data_[i]);
-	}
+	if constexpr (relocatable) {
+		// Destroy the erased elements and slide the tail down over them
+		for (size_t i = start_pos; i < end_pos; ++i) {
+			elements[i].~T();
+		}
+		std::memmove(static_cast<void*>(elements + start_pos), static_cast<const void*>(elements + end_pos),
+		             (size_ - end_pos) * sizeof(T));
+	} else {
+		// Move elements down
+		for (size_t i = end_pos; i < size_; ++i) {
+			elements[i - count] = std::move(elements[i]);
+		}
 
-	// Destroy leftover elements
-	for (size_t i = size_ - count; i < size_; ++i) {
-		data_[i].~T();
+		// Destroy leftover elements
+		for (size_t i = size_ - count; i < size_; ++i) {
+			elements[i].~T();
+		}
 	}
-	size_ -= count;
+	size_ -= static_cast<uint32_t>(count);
 	return begin() + start_pos;
 }
 
-template <typename T, size_t N>
+template <typename T, size_t N, typename A>
 template <typename... Args>
-typename small_vector<T, N>::reference small_vector<T, N>::emplace_back(Args&&... args) {
+typename small_vector<T, N, A>::reference small_vector<T, N, A>::emplace_back(Args&&... args) {
 	assert(invariant());
 	if (size_ == capacity_) {
-		grow(capacity_ * 2);
+		// The new element is built before the old ones move, args may refer to one of them
+		const uint32_t capacity = checked_capacity(size_t{capacity_} * 2);
+		T* new_data = traits::allocate(alloc_, capacity);
+		try {
+			new (new_data + size_) T(std::forward<Args>(args)...);
+		} catch (...) {
+			traits::deallocate(alloc_, new_data, capacity);
+			throw;
+		}
+		try {
+			relocate(data(), size_, new_data);
+		} catch (...) {
+			new_data[size_].~T();
+			traits::deallocate(alloc_, new_data, capacity);
+			throw;
+		}
+		if (!is_inline()) {
+			traits::deallocate(alloc_, heap_, capacity_);
+		}
+		heap_ = new_data;
+		capacity_ = capacity;
+	} else {
+		new (data() + size_) T(std::forward<Args>(args)...);
 	}
-	new (data_ + size_) T(std::forward<Args>(args)...);
 	++size_;
-	return data_[size_ - 1];
+	return data()[size_ - 1];
 }
 
-template <typename T, size_t N>
+template <typename T, size_t N, typename A>
 template <typename... Args>
-void small_vector<T, N>::emplace_back_bulk(Args&&... args) {
+void small_vector<T, N, A>::emplace_back_bulk(Args&&... args) {
 	(emplace_back(std::forward<Args>(args)), ...);
 }
-template <typename T, size_t N>
-bool small_vector<T, N>::invariant() const {
+
+template <typename T, size_t N, typename A>
+bool small_vector<T, N, A>::invariant() const {
 	if (size_ > capacity_) return false;
-	if (data_ == nullptr) return size_ == 0;
-	if (capacity_ == N && data_ != reinterpret_cast<const T*>(inline_buffer_)) return false;
-	if (capacity_ > N && data_ == reinterpret_cast<const T*>(inline_buffer_)) return false;
+	if (capacity_ < N) return false;
+	if (capacity_ > N && heap_ == nullptr) return false;
 	return true;
-}
\ No newline at end of file
+}
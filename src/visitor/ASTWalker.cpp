@@ -0,0 +1,238 @@
+#include "ASTWalker.hpp"
+
+namespace zenith {
+	void ASTWalker::walkParams(std::vector<FunctionDeclNode::Param>& params) {
+		for (auto& param: params) {
+			walk(param.type);
+			walk(param.defaultValue);
+		}
+	}
+
+	void ASTWalker::walkAnnotations(DeclNode& node) {
+		for (auto& annotation: node.annotations) walk(annotation);
+	}
+
+	void ASTWalker::walkFunction(FunctionDeclNode& node) {
+		walkAnnotations(node);
+		walkParams(node.params);
+		walk(node.returnType);
+		walk(node.body);
+	}
+
+	void ASTWalker::visit(ASTNode& node) { enter(node); }
+
+	void ASTWalker::visit(ProgramNode& node) {
+		enter(node);
+		for (auto& declaration: node.declarations) walk(declaration);
+	}
+
+	void ASTWalker::visit(ImportNode& node) { enter(node); }
+
+	void ASTWalker::visit(BlockNode& node) {
+		enter(node);
+		for (auto& statement: node.statements) walk(statement);
+	}
+
+	void ASTWalker::visit(VarDeclNode& node) {
+		enter(node);
+		walk(node.type);
+		walk(node.initializer);
+	}
+
+	void ASTWalker::visit(MultiVarDeclNode& node) {
+		enter(node);
+		for (auto& var: node.vars) walk(var);
+	}
+
+	void ASTWalker::visit(FunctionDeclNode& node) {
+		enter(node);
+		walkFunction(node);
+	}
+
+	void ASTWalker::visit(ObjectDeclNode& node) {
+		enter(node);
+		for (auto& member: node.members) walk(member);
+		for (auto& op: node.operators) walk(op);
+	}
+
+	void ASTWalker::visit(UnionDeclNode& node) {
+		enter(node);
+		for (auto& type: node.types) walk(type);
+	}
+
+	void ASTWalker::visit(IfNode& node) {
+		enter(node);
+		walk(node.condition);
+		walk(node.thenBranch);
+		walk(node.elseBranch);
+	}
+
+	void ASTWalker::visit(WhileNode& node) {
+		enter(node);
+		walk(node.condition);
+		walk(node.body);
+	}
+
+	void ASTWalker::visit(DoWhileNode& node) {
+		enter(node);
+		walk(node.body);
+		walk(node.condition);
+	}
+
+	void ASTWalker::visit(ForNode& node) {
+		enter(node);
+		walk(node.initializer);
+		walk(node.condition);
+		walk(node.increment);
+		walk(node.body);
+	}
+
+	void ASTWalker::visit(ExprStmtNode& node) {
+		enter(node);
+		walk(node.expr);
+	}
+
+	void ASTWalker::visit(EmptyStmtNode& node) { enter(node); }
+
+	void ASTWalker::visit(AnnotationNode& node) {
+		enter(node);
+		for (auto& [name, value]: node.arguments) walk(value);
+	}
+
+	void ASTWalker::visit(TemplateDeclNode& node) {
+		enter(node);
+		for (auto& parameter: node.parameters) parameter.accept(*this);
+		walk(node.declaration);
+	}
+
+	void ASTWalker::visit(DeclNode& node) {
+		enter(node);
+		walkAnnotations(node);
+	}
+
+	void ASTWalker::visit(CtorDeclNode& node) {
+		enter(node);
+		walkFunction(node);
+		for (auto& [member, value]: node.initializers) walk(value);
+	}
+
+	void ASTWalker::visit(FieldDeclNode& node) {
+		enter(node);
+		walkAnnotations(node);
+		walk(node.type);
+		walk(node.initializer);
+	}
+
+	void ASTWalker::visit(MethodDeclNode& node) {
+		enter(node);
+		walkFunction(node);
+	}
+
+	void ASTWalker::visit(MessageHandlerNode& node) {
+		enter(node);
+		walkFunction(node);
+	}
+
+	void ASTWalker::visit(OperatorOverloadNode& node) {
+		enter(node);
+		for (auto& [name, type]: node.params) walk(type);
+		walk(node.returnType);
+		walk(node.body);
+	}
+
+	void ASTWalker::visit(CompoundStmtNode& node) {
+		enter(node);
+		for (auto& statement: node.stmts) walk(statement);
+	}
+
+	void ASTWalker::visit(ReturnStmtNode& node) {
+		enter(node);
+		walk(node.value);
+	}
+
+	void ASTWalker::visit(TemplateParameter& node) {
+		enter(node);
+		walk(node.defaultType);
+		walk(node.type);
+		walk(node.defaultValue);
+		for (auto& parameter: node.templateParams) parameter.accept(*this);
+	}
+
+	void ASTWalker::visit(LiteralNode& node) { enter(node); }
+	void ASTWalker::visit(VarNode& node) { enter(node); }
+	void ASTWalker::visit(ThisNode& node) { enter(node); }
+
+	void ASTWalker::visit(BinaryOpNode& node) {
+		enter(node);
+		walk(node.left);
+		walk(node.right);
+	}
+
+	void ASTWalker::visit(UnaryOpNode& node) {
+		enter(node);
+		walk(node.right);
+	}
+
+	void ASTWalker::visit(CallNode& node) {
+		enter(node);
+		walk(node.callee);
+		for (auto& argument: node.arguments) walk(argument);
+	}
+
+	void ASTWalker::visit(MemberAccessNode& node) {
+		enter(node);
+		walk(node.object);
+	}
+
+	void ASTWalker::visit(FreeObjectNode& node) {
+		enter(node);
+		for (auto& [name, value]: node.properties) walk(value);
+	}
+
+	void ASTWalker::visit(ArrayAccessNode& node) {
+		enter(node);
+		walk(node.array);
+		walk(node.index);
+	}
+
+	void ASTWalker::visit(NewExprNode& node) {
+		enter(node);
+		for (auto& argument: node.args) walk(argument);
+	}
+
+	void ASTWalker::visit(TemplateStringNode& node) {
+		enter(node);
+		for (auto& part: node.parts) walk(part);
+	}
+
+	void ASTWalker::visit(StructInitializerNode& node) {
+		enter(node);
+		for (auto& field: node.fields) walk(field.value);
+	}
+
+	void ASTWalker::visit(LambdaExprNode& node) {
+		enter(node);
+		walk(node.lambda);
+	}
+
+	void ASTWalker::visit(TypeNode& node) { enter(node); }
+
+	void ASTWalker::visit(ArrayTypeNode& node) {
+		enter(node);
+		walk(node.elementType);
+		walk(node.sizeExpr);
+	}
+
+	void ASTWalker::visit(TemplateTypeNode& node) {
+		enter(node);
+		for (auto& argument: node.templateArgs) walk(argument);
+	}
+
+	void ASTWalker::visit(FunctionTypeNode& node) {
+		enter(node);
+		for (auto& parameter: node.parameterTypes) walk(parameter);
+		walk(node.returnType);
+	}
+
+	void ASTWalker::visit(ErrorNode& node) { enter(node); }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Visitor.hpp"
+#include "../ast/AST.hpp"
+
+namespace zenith {
+	// Visits every node of a tree in source order, parents before their children
+	// Subclasses override enter() for what they do at each node; the visit() overloads only know where the children are.
+	class ASTWalker : public Visitor {
+	protected:
+		virtual void enter(ASTNode& node) = 0;
+
+		template<typename T>
+		void walk(polymorphic<T>& node) { if (node) node->accept(*this); }
+		template<typename T>
+		void walk(polymorphic_variant<T>& node) { if (node) node->accept(*this); }
+		void walkParams(std::vector<FunctionDeclNode::Param>& params);
+		void walkAnnotations(DeclNode& node);
+		void walkFunction(FunctionDeclNode& node);
+
+	public:
+		void visit(ASTNode& node) override;
+		void visit(ProgramNode& node) override;
+		void visit(ImportNode& node) override;
+		void visit(BlockNode& node) override;
+		void visit(VarDeclNode& node) override;
+		void visit(MultiVarDeclNode& node) override;
+		void visit(FunctionDeclNode& node) override;
+		void visit(ObjectDeclNode& node) override;
+		void visit(UnionDeclNode& node) override;
+		void visit(IfNode& node) override;
+		void visit(WhileNode& node) override;
+		void visit(DoWhileNode& node) override;
+		void visit(ForNode& node) override;
+		void visit(ExprStmtNode& node) override;
+		void visit(EmptyStmtNode& node) override;
+		void visit(AnnotationNode& node) override;
+		void visit(TemplateDeclNode& node) override;
+		void visit(DeclNode& node) override;
+		void visit(CtorDeclNode& node) override;
+		void visit(FieldDeclNode& node) override;
+		void visit(MethodDeclNode& node) override;
+		void visit(MessageHandlerNode& node) override;
+		void visit(OperatorOverloadNode& node) override;
+		void visit(CompoundStmtNode& node) override;
+		void visit(ReturnStmtNode& node) override;
+		void visit(TemplateParameter& node) override;
+
+		void visit(LiteralNode& node) override;
+		void visit(VarNode& node) override;
+		void visit(BinaryOpNode& node) override;
+		void visit(UnaryOpNode& node) override;
+		void visit(CallNode& node) override;
+		void visit(MemberAccessNode& node) override;
+		void visit(FreeObjectNode& node) override;
+		void visit(ArrayAccessNode& node) override;
+		void visit(NewExprNode& node) override;
+		void visit(TemplateStringNode& node) override;
+		void visit(ThisNode& node) override;
+		void visit(StructInitializerNode& node) override;
+		void visit(LambdaExprNode& node) override;
+
+		void visit(TypeNode& node) override;
+		void visit(ArrayTypeNode& node) override;
+		void visit(TemplateTypeNode& node) override;
+		void visit(FunctionTypeNode& node) override;
+
+		void visit(ErrorNode& node) override;
+	};
+}
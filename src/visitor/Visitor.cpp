@@ -45,24 +45,24 @@ namespace zenith{
 		visit(static_cast<FunctionDeclNode&>(node));
 	}
 
-	void Visitor::visit(MemberDeclNode& node) {
+	void Visitor::visit(DeclNode& node) {
 		visit(static_cast<ASTNode&>(node));
 	}
 
 	void Visitor::visit(CtorDeclNode& node) {
-		visit(static_cast<MemberDeclNode &>(node));
+		visit(static_cast<DeclNode &>(node));
 	}
 
 	void Visitor::visit(MessageHandlerNode& node) {
-		visit(static_cast<MemberDeclNode &>(node));
+		visit(static_cast<DeclNode &>(node));
 	}
 
 	void Visitor::visit(FieldDeclNode& node) {
-		visit(static_cast<MemberDeclNode &>(node));
+		visit(static_cast<DeclNode &>(node));
 	}
 
 	void Visitor::visit(MethodDeclNode& node) {
-		visit(static_cast<MemberDeclNode &>(node));
+		visit(static_cast<DeclNode &>(node));
 	}
 
 	void Visitor::visit(OperatorOverloadNode& node) {
@@ -89,6 +89,11 @@ namespace zenith{
 		visit(static_cast<StmtNode&>(node));
 	}
 
+	void Visitor::visit(LazyBlockNode& node) {
+		node.materialize();
+		visit(static_cast<BlockNode&>(node));
+	}
+
 	void Visitor::visit(IfNode& node) {
 		visit(static_cast<StmtNode&>(node));
 	}
@@ -20,6 +20,8 @@ namespace zenith {
 		virtual void visit(struct ProgramNode& node);
 		virtual void visit(struct ImportNode& node);
 		virtual void visit(struct BlockNode& node);
+		// Parses the body without a reporter, then visits it as a BlockNode
+		virtual void visit(struct LazyBlockNode& node);
 		virtual void visit(struct VarDeclNode& node);
 		virtual void visit(struct MultiVarDeclNode& node);
 		virtual void visit(struct FunctionDeclNode& node);
@@ -36,7 +38,7 @@ namespace zenith {
 		virtual void visit(struct TemplateDeclNode& node);
 		virtual void visit(struct LambdaNode& node);
 		virtual void visit(struct MessageHandlerNode& node);
-		virtual void visit(struct MemberDeclNode& node);
+		virtual void visit(struct DeclNode& node);
 		virtual void visit(struct CtorDeclNode& node);
 		virtual void visit(struct FieldDeclNode& node);
 		virtual void visit(struct MethodDeclNode& node);